@@ -40,6 +40,7 @@
 #include <d3d12.h>
 #include <wrl.h>
 
+#include <atomic> // for std::atomic
 #include <map> // for std::map
 #include <memory> // for std::unique_ptr
 #include <mutex> // for std::mutex
@@ -48,6 +49,7 @@
 #include "GenerateMipsPso.h"
 #include "ClearValue.h"
 #include "RenderTargetState.h"
+#include "TextureData.h"
 #include "UploadBuffer.h"
 
 class Buffer;
@@ -197,10 +199,19 @@ public:
 
     /**
      * Load a texture by a filename.
+     * Blocks until the file is decoded (see TextureStreamer for asynchronous loading).
      */
     bool LoadTextureFromFile(Texture& texture, const std::wstring& fileName,
         TextureUsageType textureUsage = TextureUsageType::Albedo, bool throwOnNotFound = true);
 
+    /**
+     * Release the loaded textures that are no longer used outside of the cache.
+     * Called on every load, but can also be called after unloading content.
+     */
+    static void TrimTextureCache();
+    // Must be called before the device is destroyed.
+    static void ClearTextureCache();
+
     /**
      * Clear a texture.
      */
@@ -213,6 +224,12 @@ public:
     void ClearDepthStencilTexture(const Texture& texture, D3D12_CLEAR_FLAGS clearFlags, float depth = 1.0f,
         uint8_t stencil = 0);
 
+    /**
+     * Clear a single slice of a depth/stencil texture array.
+     */
+    void ClearDepthStencilTextureArraySlice(const Texture& texture, uint32_t arrayIndex, D3D12_CLEAR_FLAGS clearFlags, float depth = 1.0f,
+        uint8_t stencil = 0);
+
     /**
      * Generate mips for the texture.
      * The first subresource is used to generate the mip chain.
@@ -231,6 +248,18 @@ public:
     void CopyTextureSubresource(const Texture& texture, uint32_t firstSubresource, uint32_t numSubresources,
         D3D12_SUBRESOURCE_DATA* subresourceData);
 
+    /**
+     * Copy all the decoded subresources to a texture.
+     */
+    void CopyTextureData(const Texture& texture, const TextureData& textureData);
+
+    /**
+     * Copy a range of mips between textures of the same format and array size, e.g., with a different number of mips.
+     * Only the first array slice is copied.
+     */
+    void CopyTextureMips(const Texture& dstTexture, uint32_t dstFirstMip, const Texture& srcTexture, uint32_t srcFirstMip,
+        uint32_t numMips);
+
     /**
      * Set a dynamic constant buffer data to an inline descriptor in the root
      * signature.
@@ -341,6 +370,12 @@ public:
      */
     void SetPipelineState(const Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState);
 
+    /**
+     * Skip all draws until the next call to SetPipelineState.
+     * Used when the pipeline state object for the next draws is not compiled yet.
+     */
+    void SkipDrawsUntilNextPipelineState();
+
     /**
      * Set the current root signature on the command list.
      */
@@ -490,10 +525,35 @@ public:
 
     UploadBuffer::Allocation AllocateInUploadBuffer(size_t bufferSize, size_t alignment);
 
+    /**
+     * Changes every time the command list is reset.
+     * Upload buffer allocations made with a different generation are no longer valid.
+     */
+    uint64_t GetUploadBufferGeneration() const { return m_UploadBufferGeneration; }
+
+    /**
+     * Set a constant buffer (e.g., previously allocated with AllocateInUploadBuffer)
+     * to an inline descriptor in the root signature.
+     */
+    void SetGraphicsRootConstantBufferView(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+
     void TrackObject(const Microsoft::WRL::ComPtr<ID3D12Object>& object);
     void TrackResource(const Resource& res);
 
 private:
+    friend class TextureStreamer;
+
+    /**
+     * @param mipLevels 0 for the full mip chain.
+     */
+    static D3D12_RESOURCE_DESC GetTextureResourceDesc(const TextureData& textureData, uint16_t mipLevels);
+    // Creates the resource in the common state.
+    static Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(const TextureData& textureData, uint16_t mipLevels);
+    static Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(const D3D12_RESOURCE_DESC& textureDesc);
+
+    static bool TryGetCachedTexture(const std::wstring& fileName, Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+    static void AddCachedTexture(const std::wstring& fileName, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource);
+
     // Generate mips for UAV compatible textures.
     void GenerateMipsUav(Texture& texture, DXGI_FORMAT format);
     //// Generate mips for BGR textures.
@@ -524,6 +584,9 @@ private:
     // Resource created in an upload heap. Useful for drawing of dynamic geometry
     // or for uploading constant buffer data that changes every draw call.
     std::unique_ptr<UploadBuffer> m_PUploadBuffer;
+    uint64_t m_UploadBufferGeneration;
+    // Unique across all command lists, so that a generation identifies both the list and its reset.
+    static std::atomic<uint64_t> s_NextUploadBufferGeneration;
 
     // Resource state tracker is used by the command list to track (per command list)
     // the current state of a resource. The resource state tracker also tracks the
@@ -553,7 +616,10 @@ private:
 
     RenderTargetState m_LastRenderTargetState;
 
+    // Set if the currently bound pipeline state is not available (see SkipDrawsUntilNextPipelineState).
+    bool m_SkipDraws = false;
+
     // Keep track of loaded textures to avoid loading the same texture multiple times.
-    static std::map<std::wstring, ID3D12Resource*> m_TextureCache;
+    static std::map<std::wstring, Microsoft::WRL::ComPtr<ID3D12Resource>> m_TextureCache;
     static std::mutex m_TextureCacheMutex;
 };
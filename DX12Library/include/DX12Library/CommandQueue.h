@@ -60,6 +60,7 @@ public:
 
 	uint64_t Signal();
 	bool IsFenceComplete(uint64_t fenceValue);
+	uint64_t GetCompletedFenceValue() const;
 	void WaitForFenceValue(uint64_t fenceValue);
 	void Flush();
 
@@ -6,10 +6,14 @@
 
 #include <wrl.h>
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 #include "RootSignature.h"
 
@@ -23,6 +27,21 @@ class RootSignature;
 class DynamicDescriptorHeap
 {
 public:
+	/**
+	 * Counters of the work done by CommitStagedDescriptors.
+	 */
+	struct Statistics
+	{
+		// Number of descriptors copied to GPU visible descriptor heaps.
+		uint32_t NumDescriptorsCopied = 0;
+		// Number of descriptor tables which were copied.
+		uint32_t NumTablesCopied = 0;
+		// Number of descriptor tables which reused an identical table copied earlier.
+		uint32_t NumTablesReused = 0;
+		// Number of ID3D12Device::CopyDescriptors calls.
+		uint32_t NumCopyCalls = 0;
+	};
+
 	DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptorsPerHeap = 1024);
 
 	virtual ~DynamicDescriptorHeap();
@@ -84,6 +103,16 @@ public:
 	 */
 	void Reset();
 
+	/**
+	 * Statistics of this heap since the last Reset.
+	 */
+	const Statistics& GetStatistics() const { return m_Statistics; }
+
+	/**
+	 * Statistics accumulated by all dynamic descriptor heaps during the previous frame.
+	 */
+	static Statistics GetLastFrameStatistics();
+
 private:
 	// Request a descriptor heap if one is available.
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> RequestDescriptorHeap();
@@ -94,6 +123,16 @@ private:
 	// to GPU visible descriptor heap.
 	uint32_t ComputeStaleDescriptorCount() const;
 
+	// Switch to a new GPU visible descriptor heap and bind it to the command list.
+	void SwitchToNewDescriptorHeap(CommandList& commandList);
+
+	static size_t ComputeTableHash(const D3D12_CPU_DESCRIPTOR_HANDLE* descriptors, uint32_t numDescriptors);
+
+	// Add the counters to the statistics of the current frame.
+	static void AddFrameStatistics(const Statistics& statistics);
+	// Move the current frame's statistics to the last frame's ones if a new frame has started.
+	static void RollOverFrameStatistics();
+
 	/**
 	 * The maximum number of descriptor tables per root signature.
 	 * A 32-bit mask is used to keep track of the root parameter indices that
@@ -137,7 +176,7 @@ private:
 	uint32_t m_DescriptorTableBitMask;
 	uint32_t m_StaleDescriptorTableBitMask;
 
-	using DescriptorHeapPoolType = std::queue<ComPtr<ID3D12DescriptorHeap>>;
+	using DescriptorHeapPoolType = std::queue<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>>;
 
 	DescriptorHeapPoolType m_DescriptorHeapPool;
 	DescriptorHeapPoolType m_AvailableDescriptorHeaps;
@@ -147,4 +186,39 @@ private:
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_CurrentCpuDescriptorHandle;
 
 	uint32_t m_NumFreeHandles;
+
+	// A descriptor table which has already been copied to the current GPU visible descriptor heap.
+	// Valid only until the current descriptor heap changes.
+	struct CommittedTable
+	{
+		uint32_t NumDescriptors;
+		// Offset of the table's source descriptors in m_CommittedDescriptors.
+		uint32_t SourceOffset;
+		D3D12_GPU_DESCRIPTOR_HANDLE GpuDescriptor;
+	};
+
+	// Committed tables by the hash of their source descriptors.
+	std::unordered_map<size_t, CommittedTable> m_CommittedTables;
+	// Source descriptors of the committed tables. Used to resolve hash collisions.
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_CommittedDescriptors;
+
+	// Scratch buffers for batching the copies into a single CopyDescriptors call.
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_SrcDescriptorRangeStarts;
+	std::vector<UINT> m_SrcDescriptorRangeSizes;
+
+	Statistics m_Statistics;
+
+	struct FrameStatistics
+	{
+		std::atomic<uint64_t> FrameIndex = 0;
+		std::atomic<uint32_t> NumDescriptorsCopied = 0;
+		std::atomic<uint32_t> NumTablesCopied = 0;
+		std::atomic<uint32_t> NumTablesReused = 0;
+		std::atomic<uint32_t> NumCopyCalls = 0;
+	};
+
+	static FrameStatistics s_CurrentFrameStatistics;
+	// Written by the command list thread that rolls the frame over, read by the UI thread.
+	static Statistics s_LastFrameStatistics;
+	static std::mutex s_LastFrameStatisticsMutex;
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Stable (across runs and platforms) 64-bit hashing.
+ * Unlike std::hash, the values can be persisted to disk.
+ */
+namespace HashUtils
+{
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    inline uint64_t Fnv1a(const void* data, const size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            seed ^= bytes[i];
+            seed *= FNV_PRIME;
+        }
+
+        return seed;
+    }
+
+    constexpr uint64_t Fnv1a(const std::string_view string, uint64_t seed = FNV_OFFSET_BASIS)
+    {
+        for (const char c : string)
+        {
+            seed ^= static_cast<uint8_t>(c);
+            seed *= FNV_PRIME;
+        }
+
+        return seed;
+    }
+
+    inline uint64_t Combine(const uint64_t seed, const uint64_t value)
+    {
+        return Fnv1a(&value, sizeof(value), seed);
+    }
+
+    class Hasher
+    {
+    public:
+        Hasher& AddBytes(const void* data, const size_t size)
+        {
+            m_Value = Fnv1a(data, size, m_Value);
+            return *this;
+        }
+
+        template <typename T>
+        Hasher& Add(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be hashed as raw bytes.");
+            return AddBytes(&value, sizeof(T));
+        }
+
+        Hasher& AddString(const std::string_view string)
+        {
+            Add(string.size());
+            m_Value = Fnv1a(string, m_Value);
+            return *this;
+        }
+
+        uint64_t GetValue() const { return m_Value; }
+
+    private:
+        uint64_t m_Value = FNV_OFFSET_BASIS;
+    };
+
+    // Lower-case hexadecimal representation of the hash value, e.g., for use as a file or a pipeline name.
+    inline std::wstring ToWString(const uint64_t value)
+    {
+        constexpr wchar_t DIGITS[] = L"0123456789abcdef";
+
+        std::wstring result(16, L'0');
+        for (size_t i = 0; i < 16; ++i)
+        {
+            result[15 - i] = DIGITS[(value >> (i * 4)) & 0xF];
+        }
+
+        return result;
+    }
+}
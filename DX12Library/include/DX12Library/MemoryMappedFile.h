@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ *  @file MemoryMappedFile.h
+ *
+ *  @brief A read-only view of a whole file mapped into the address space.
+ *  Works on both Windows and POSIX systems.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+class MemoryMappedFile
+{
+public:
+	MemoryMappedFile() = default;
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+	MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+	/**
+	 * Map the file, unmapping the previous one (if any).
+	 * @return false if the file does not exist, is empty, or cannot be mapped.
+	 */
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+
+	// The mapping is page-aligned.
+	const uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#ifdef _WIN32
+	void* m_FileHandle = nullptr;
+	void* m_MappingHandle = nullptr;
+#endif
+};
@@ -43,6 +43,17 @@ public:
         m_DepthStencilFormat = depthStencil->IsValid() ? depthStencil->GetD3D12ResourceDesc().Format : DXGI_FORMAT_UNKNOWN;
     }
 
+    RenderTargetFormats(ConstFormatsArray& formats, const UINT count, const DXGI_FORMAT depthStencilFormat)
+        : m_Count(count)
+        , m_Formats()
+        , m_DepthStencilFormat(depthStencilFormat)
+    {
+        for (UINT i = 0; i < MAX_RENDER_TARGETS; ++i)
+        {
+            m_Formats[i] = formats[i];
+        }
+    }
+
     inline UINT GetCount() const { return m_Count; }
     inline const ConstFormatsArray& GetFormats() const { return m_Formats; }
 
@@ -34,6 +34,11 @@ public:
         , m_SampleDesc{}
     {}
 
+    RenderTargetState(const RenderTargetFormats& formats, const DXGI_SAMPLE_DESC& sampleDesc)
+        : m_Formats(formats)
+        , m_SampleDesc(sampleDesc)
+    {}
+
     const RenderTargetFormats& GetFormats() const { return m_Formats; };
 
     const DXGI_SAMPLE_DESC& GetSampleDesc() const { return m_SampleDesc; };
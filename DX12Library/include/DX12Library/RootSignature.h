@@ -69,6 +69,12 @@ public:
 		return RootSignatureDesc;
 	}
 
+	// Stable hash of the serialized root signature. Can be used as a part of persistent cache keys.
+	uint64_t GetHash() const
+	{
+		return SerializedHash;
+	}
+
 	uint32_t GetDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const;
 	uint32_t GetNumDescriptors(uint32_t rootIndex) const;
 
@@ -89,4 +95,6 @@ private:
 	// A bit mask that represents the root parameter indices that are 
 	// CBV, UAV, and SRV descriptor tables.
 	uint32_t DescriptorTableBitMask;
+
+	uint64_t SerializedHash;
 };
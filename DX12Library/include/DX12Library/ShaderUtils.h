@@ -10,6 +10,9 @@
 
 namespace ShaderUtils
 {
+	// Compiled shaders are placed in the Shaders directory next to the executable.
+	std::wstring GetShaderFilePath(const std::wstring& fileName);
+
 	Microsoft::WRL::ComPtr<ID3DBlob> LoadShaderFromFile(const std::wstring& fileName);
 
 	Microsoft::WRL::ComPtr<ID3D12ShaderReflection> Reflect(const Microsoft::WRL::ComPtr<ID3DBlob>& shaderSource);
@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ *  @file TextureData.h
+ *
+ *  @brief The decoded subresources of a texture, ready to be copied into a GPU resource.
+ *  Does not depend on Windows or D3D12.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct TextureData
+{
+    enum class Dimension
+    {
+        Texture1D,
+        Texture2D,
+        Texture3D,
+    };
+
+    // Mirrors D3D12_SUBRESOURCE_DATA.
+    struct Subresource
+    {
+        const void* m_Data;
+        size_t m_RowPitch;
+        size_t m_SlicePitch;
+    };
+
+    Dimension m_Dimension = Dimension::Texture2D;
+    // A DXGI_FORMAT.
+    uint32_t m_Format = 0;
+    uint64_t m_Width = 0;
+    uint32_t m_Height = 1;
+    // The depth of 3D textures, otherwise the array size.
+    uint16_t m_DepthOrArraySize = 1;
+    uint16_t m_MipLevels = 1;
+
+    // In the order of the subresource indices: all the mips of the first array slice, then of the second, and so on.
+    std::vector<Subresource> m_Subresources;
+    size_t m_SizeInBytes = 0;
+    // The size of the upload (staging) buffer, which can be larger than the pixels because of the row pitch alignment of the GPU.
+    // If 0, m_SizeInBytes is used.
+    size_t m_StagingSizeInBytes = 0;
+
+    // Owns the memory of the subresources (e.g., a DirectX::ScratchImage).
+    std::shared_ptr<const void> m_Storage;
+
+    size_t GetStagingSizeInBytes() const { return m_StagingSizeInBytes != 0 ? m_StagingSizeInBytes : m_SizeInBytes; }
+
+    // A range of the mips sharing the same storage, e.g., to upload only some of them.
+    TextureData SelectMips(const uint16_t firstMip, const uint16_t mipLevels) const
+    {
+        TextureData result;
+        result.m_Dimension = m_Dimension;
+        result.m_Format = m_Format;
+        result.m_Width = std::max<uint64_t>(m_Width >> firstMip, 1);
+        result.m_Height = m_Dimension == Dimension::Texture1D ? 1 : std::max(m_Height >> firstMip, 1u);
+        result.m_DepthOrArraySize = m_Dimension == Dimension::Texture3D ? static_cast<uint16_t>(std::max(m_DepthOrArraySize >> firstMip, 1)) : m_DepthOrArraySize;
+        result.m_MipLevels = mipLevels;
+        result.m_Storage = m_Storage;
+
+        const uint16_t arraySize = m_Dimension == Dimension::Texture3D ? 1 : m_DepthOrArraySize;
+        for (uint16_t arraySlice = 0; arraySlice < arraySize; ++arraySlice)
+        {
+            for (uint16_t mip = firstMip; mip < firstMip + mipLevels; ++mip)
+            {
+                const Subresource& subresource = m_Subresources[arraySlice * m_MipLevels + mip];
+                result.m_Subresources.push_back(subresource);
+                result.m_SizeInBytes += m_Dimension == Dimension::Texture3D ? subresource.m_SlicePitch * std::max(m_DepthOrArraySize >> mip, 1) : subresource.m_SlicePitch;
+            }
+        }
+
+        return result;
+    }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ *  @file TextureDecoder.h
+ *
+ *  @brief Decodes texture files into TextureData with DirectXTex.
+ *  Does not depend on D3D12, so it can run on any thread (and on Linux, except for the WIC formats: PNG, JPEG, etc.).
+ */
+
+#include "TextureData.h"
+#include "TextureUsageType.h"
+
+#include <filesystem>
+
+class TextureDecoder
+{
+public:
+    /**
+     * If the file is not a DDS, a DDS with the same name is preferred when it exists (e.g., with block compression and precomputed mips).
+     */
+    static std::filesystem::path ResolvePath(const std::filesystem::path& path);
+
+    /**
+     * Throws std::runtime_error if the file cannot be decoded.
+     * @param usage Albedo textures get sRGB formats.
+     * @param generateMips Generate the mips of uncompressed 2D textures on the CPU.
+     */
+    static TextureData Decode(const std::filesystem::path& path, TextureUsageType usage, bool generateMips = true);
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+/**
+ *  @file TextureResidencyManager.h
+ *
+ *  @brief Decides which mips of the streamed textures are resident within a memory budget.
+ *  Textures are requested every frame at the mip their screen size needs; the rest is evicted in LRU order.
+ *  Only makes decisions: does not depend on Windows or D3D12 (see TextureStreamer for loading the mips).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class TextureResidencyManager
+{
+public:
+    using TextureId = uint32_t;
+
+    // Mips up to this size (in both dimensions) are the tail: they are loaded up front and never evicted.
+    static constexpr uint32_t DEFAULT_MAX_TAIL_SIZE = 64;
+
+    struct TextureDesc
+    {
+        uint32_t m_Width = 0;
+        uint32_t m_Height = 0;
+        // The size of every mip level, starting from the finest one.
+        std::vector<size_t> m_MipSizesInBytes;
+        // Textures that are not streamed are always fully resident, but they still count against the budget.
+        bool m_IsStreamed = true;
+    };
+
+    struct Change
+    {
+        TextureId m_Id;
+        // The finest resident mip before and after the update.
+        uint16_t m_PreviousMip;
+        uint16_t m_Mip;
+    };
+
+    explicit TextureResidencyManager(size_t budgetInBytes, uint32_t maxTailSize = DEFAULT_MAX_TAIL_SIZE);
+
+    /**
+     * The tail is resident right away, even if it does not fit into the budget.
+     */
+    TextureId Register(const TextureDesc& desc);
+    void Unregister(TextureId id);
+
+    /**
+     * Request a mip for the next update. Several requests in a frame are merged into the finest one.
+     * A requested texture counts as used in this frame, so it is the last to be evicted.
+     */
+    void Request(TextureId id, uint16_t mip);
+
+    // Request the mip needed to draw the texture over screenSizeInPixels (see ComputeMip).
+    void RequestScreenSize(TextureId id, float screenSizeInPixels);
+
+    /**
+     * Grant the requests of this frame, evicting the least recently used mips if they do not fit into the budget.
+     * When there is nothing left to evict, textures get a coarser mip than requested.
+     * Textures that are not requested keep their mips until they are evicted.
+     * @return The textures whose resident mip has changed, valid until the next update.
+     */
+    const std::vector<Change>& Update();
+
+    // The finest resident mip of the texture.
+    uint16_t GetMip(TextureId id) const;
+    // The finest mip of the tail of the texture.
+    uint16_t GetTailMip(TextureId id) const;
+    uint16_t GetMipLevels(TextureId id) const;
+
+    size_t GetBudgetInBytes() const { return m_BudgetInBytes; }
+    // Takes effect in the next update.
+    void SetBudgetInBytes(size_t budgetInBytes) { m_BudgetInBytes = budgetInBytes; }
+
+    // Can exceed the budget when the tails alone do not fit.
+    size_t GetResidentSizeInBytes() const { return m_ResidentSizeInBytes; }
+    size_t GetNumTextures() const { return m_NumTextures; }
+    uint32_t GetMaxTailSize() const { return m_MaxTailSize; }
+
+    /**
+     * The mip whose texels match the pixels when the whole texture is drawn over screenSizeInPixels
+     * (i.e., assuming the UVs cover the texture once).
+     */
+    static uint16_t ComputeMip(uint32_t width, uint32_t height, uint16_t mipLevels, float screenSizeInPixels);
+
+    // The first mip that is not larger than maxTailSize, or the last mip.
+    static uint16_t ComputeTailMip(uint32_t width, uint32_t height, uint16_t mipLevels, uint32_t maxTailSize);
+
+private:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+    static constexpr uint16_t NO_REQUEST = std::numeric_limits<uint16_t>::max();
+
+    struct Entry
+    {
+        uint32_t m_Width = 0;
+        uint32_t m_Height = 0;
+        uint16_t m_MipLevels = 0;
+        uint16_t m_TailMip = 0;
+        uint16_t m_Mip = 0;
+        uint16_t m_PreviousMip = 0;
+        uint16_t m_RequestedMip = NO_REQUEST;
+        bool m_IsRegistered = false;
+        bool m_IsChanged = false;
+        uint64_t m_LastUsedFrame = 0;
+
+        // The resident size when the finest resident mip is the index (one more entry than the mips, the last one is 0).
+        std::vector<size_t> m_SizesFromMipInBytes;
+
+        // The LRU list, from the least recently used texture.
+        uint32_t m_Previous = INVALID_INDEX;
+        uint32_t m_Next = INVALID_INDEX;
+    };
+
+    Entry& GetEntry(TextureId id);
+    const Entry& GetEntry(TextureId id) const;
+
+    void SetMip(TextureId id, uint16_t mip);
+    // Evict until the size fits into the budget. With keepRequestedMips, textures used in this frame are only trimmed down to their requested mip.
+    bool MakeRoom(size_t sizeInBytes, bool keepRequestedMips);
+
+    void LinkAsMostRecent(TextureId id);
+    void Unlink(TextureId id);
+
+    size_t m_BudgetInBytes;
+    uint32_t m_MaxTailSize;
+    uint64_t m_Frame = 1;
+
+    std::vector<Entry> m_Textures;
+    std::vector<TextureId> m_FreeIds;
+    size_t m_NumTextures = 0;
+    size_t m_ResidentSizeInBytes = 0;
+
+    std::vector<TextureId> m_RequestedTextures;
+    std::vector<TextureId> m_ChangedTextures;
+    std::vector<Change> m_Changes;
+
+    TextureId m_LeastRecentlyUsed = INVALID_INDEX;
+    TextureId m_MostRecentlyUsed = INVALID_INDEX;
+    // The LRU order does not change during an update, so eviction resumes where the previous one has stopped.
+    TextureId m_EvictionCursor = INVALID_INDEX;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+ *  @file TextureStreamer.h
+ *
+ *  @brief Loads textures asynchronously: files are decoded on worker threads and uploaded through the copy queue,
+ *  while a placeholder is bound in the meantime.
+ *  Textures loaded with mip streaming start with their tail mips, the finer ones are loaded and evicted
+ *  by a TextureResidencyManager from the screen sizes reported every frame.
+ */
+
+#include "TextureResidencyManager.h"
+#include "TextureStreamingScheduler.h"
+#include "TextureUsageType.h"
+#include "ThreadPool.h"
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CommandList;
+class Resource;
+class Texture;
+
+class TextureStreamer
+{
+public:
+    static constexpr size_t DEFAULT_STAGING_BUDGET = 64 * 1024 * 1024;
+    static constexpr size_t DEFAULT_RESIDENCY_BUDGET = 512 * 1024 * 1024;
+
+    static void Create(uint32_t numThreads = 0, size_t stagingBudgetInBytes = DEFAULT_STAGING_BUDGET,
+        size_t residencyBudgetInBytes = DEFAULT_RESIDENCY_BUDGET);
+    static void Destroy();
+    static bool IsCreated();
+    static TextureStreamer& Get();
+
+    TextureStreamer(uint32_t numThreads, size_t stagingBudgetInBytes, size_t residencyBudgetInBytes);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer& other) = delete;
+    TextureStreamer& operator=(const TextureStreamer& other) = delete;
+
+    /**
+     * Never blocks on the file: returns a texture showing a placeholder (1x1, depending on the usage),
+     * which is replaced by the loaded one in a later Update. Loading the same file again returns a texture sharing the resource.
+     * Throws if the file does not exist.
+     * @param streamMips Only load the tail mips up front, the finer ones follow the screen sizes passed to RequestScreenSize.
+     * Otherwise, all the mips are loaded and stay resident.
+     */
+    std::shared_ptr<Texture> LoadTexture(const std::wstring& fileName, TextureUsageType usage = TextureUsageType::Albedo,
+        bool streamMips = false);
+
+    /**
+     * Report that a texture is drawn over screenSizeInPixels in this frame (e.g., the projected size of the object).
+     * Ignores the resources that have not been loaded with mip streaming.
+     */
+    void RequestScreenSize(const Resource& texture, float screenSizeInPixels);
+
+    /**
+     * Submit the decoded textures to the copy queue, swap in the ones that have finished uploading,
+     * and apply the mip changes of the residency manager.
+     * Called once per frame on the render thread (see Window::OnUpdate).
+     */
+    void Update();
+
+    // The textures that still show a placeholder.
+    size_t GetNumPendingTextures() const { return m_NumPendingTextures; }
+
+    TextureResidencyManager& GetResidencyManager() { return m_ResidencyManager; }
+    const TextureResidencyManager& GetResidencyManager() const { return m_ResidencyManager; }
+
+private:
+    struct StreamedTexture
+    {
+        std::wstring m_FileName;
+        TextureUsageType m_Usage;
+        bool m_StreamMips;
+        bool m_IsFailed = false;
+        std::vector<std::pair<const Resource*, std::weak_ptr<Texture>>> m_Textures;
+
+        // Null while the placeholder is bound.
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_Resource;
+        // The full chain has m_MipLevels mips, the resource only has the ones from m_FirstMip.
+        uint16_t m_FirstMip = 0;
+        uint16_t m_MipLevels = 0;
+
+        std::optional<TextureResidencyManager::TextureId> m_ResidencyId;
+        uint16_t m_TargetMip = 0;
+
+        // At most one load in flight: the mips from m_PendingFirstMip to m_FirstMip (or the end, for the first load).
+        std::shared_ptr<TextureStreamingScheduler::Request> m_Request;
+        uint16_t m_PendingFirstMip = 0;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_PendingResource;
+    };
+
+    const Microsoft::WRL::ComPtr<ID3D12Resource>& GetPlaceholder(TextureUsageType usage);
+
+    // Load the mips from firstMip to the first resident one (all the mips for the first load).
+    void ScheduleLoad(StreamedTexture& streamedTexture, uint16_t firstMip);
+    void SubmitUploads();
+    // The command list of the direct queue is only created when there is something to copy.
+    void FinishUploads(std::shared_ptr<CommandList>& commandList, std::vector<StreamedTexture*>& changedTextures);
+    void ApplyResidencyChanges(std::shared_ptr<CommandList>& commandList, std::vector<StreamedTexture*>& changedTextures);
+    // Evict the finer mips: the remaining ones are copied on the GPU.
+    void DropMips(CommandList& commandList, StreamedTexture& streamedTexture, uint16_t firstMip);
+    void SwapResource(StreamedTexture& streamedTexture, const Microsoft::WRL::ComPtr<ID3D12Resource>& resource, uint16_t firstMip);
+    void ReleaseUnusedTextures();
+
+    static CommandList& GetDirectCommandList(std::shared_ptr<CommandList>& commandList);
+
+    ThreadPool m_ThreadPool;
+    TextureStreamingScheduler m_Scheduler;
+    TextureResidencyManager m_ResidencyManager;
+
+    // Keyed by the resolved file name.
+    std::map<std::wstring, StreamedTexture> m_StreamedTextures;
+    // For the screen size feedback.
+    std::unordered_map<const Resource*, StreamedTexture*> m_StreamedTexturesByResource;
+    std::vector<StreamedTexture*> m_StreamedTexturesByResidencyId;
+    size_t m_NumPendingTextures = 0;
+
+    std::map<TextureUsageType, Microsoft::WRL::ComPtr<ID3D12Resource>> m_Placeholders;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+/**
+ *  @file TextureStreamingScheduler.h
+ *
+ *  @brief The CPU side of texture streaming: decodes textures on worker threads and hands them out for upload
+ *  within a budget of staging memory, which is returned when the fence of the upload is reached.
+ *  Does not depend on Windows or D3D12 (see TextureStreamer for the GPU side).
+ */
+
+#include "TextureData.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+class TextureStreamingScheduler
+{
+public:
+    using DecodeFunction = std::function<TextureData()>;
+
+    enum class RequestStatus
+    {
+        Decoding,
+        // Waiting for staging memory.
+        Decoded,
+        Uploading,
+        Completed,
+        Failed,
+    };
+
+    class Request
+    {
+    public:
+        explicit Request(std::wstring key);
+
+        const std::wstring& GetKey() const { return m_Key; }
+        RequestStatus GetStatus() const { return m_Status.load(std::memory_order_acquire); }
+
+        // Only valid while the status is Decoded or Uploading: the pixels are released when the upload completes.
+        const TextureData& GetData() const { return m_Data; }
+        // Only valid after the status has become Failed.
+        const std::string& GetErrorMessage() const { return m_ErrorMessage; }
+
+    private:
+        friend class TextureStreamingScheduler;
+
+        std::wstring m_Key;
+        std::atomic<RequestStatus> m_Status;
+        TextureData m_Data;
+        std::string m_ErrorMessage;
+
+        size_t m_StagingSizeInBytes = 0;
+        uint64_t m_FenceValue = 0;
+    };
+
+    /**
+     * @param stagingBudgetInBytes The maximum size of the uploads in flight.
+     * A texture larger than the whole budget is still uploaded, but only when nothing else is in flight.
+     */
+    TextureStreamingScheduler(ThreadPool& threadPool, size_t stagingBudgetInBytes);
+
+    // Waits for the decodes in flight.
+    ~TextureStreamingScheduler();
+
+    TextureStreamingScheduler(const TextureStreamingScheduler& other) = delete;
+    TextureStreamingScheduler& operator=(const TextureStreamingScheduler& other) = delete;
+
+    /**
+     * Schedule the decode function on a worker thread. Never blocks.
+     * If a request with the same key is still in flight, that request is returned instead.
+     */
+    std::shared_ptr<Request> Schedule(const std::wstring& key, DecodeFunction decodeFunction);
+
+    /**
+     * Take the decoded textures that fit into the remaining staging budget, in the order they have been decoded.
+     * Their staging memory is reserved until they are retired.
+     */
+    std::vector<std::shared_ptr<Request>> AcquireUploads();
+
+    /**
+     * Mark the acquired uploads as submitted: they complete once the given fence value is reached.
+     */
+    void SubmitUploads(const std::vector<std::shared_ptr<Request>>& requests, uint64_t fenceValue);
+
+    /**
+     * Complete the uploads whose fence value has been reached and return their staging memory.
+     * @return The requests that have completed or failed since the last call.
+     */
+    std::vector<std::shared_ptr<Request>> Retire(uint64_t completedFenceValue);
+
+    size_t GetStagingBudgetInBytes() const { return m_StagingBudgetInBytes; }
+    size_t GetStagingSizeInFlight() const;
+    // The requests that have not been retired yet.
+    size_t GetNumPendingRequests() const;
+
+    // Block until all the scheduled decodes are complete.
+    void WaitForDecodes();
+
+private:
+    void Decode(const std::shared_ptr<Request>& request, const DecodeFunction& decodeFunction);
+    void Finish(const std::shared_ptr<Request>& request);
+
+    ThreadPool& m_ThreadPool;
+    const size_t m_StagingBudgetInBytes;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<std::wstring, std::weak_ptr<Request>> m_InFlightRequests;
+    std::deque<std::shared_ptr<Request>> m_DecodedRequests;
+    // In the order of their fence values.
+    std::deque<std::shared_ptr<Request>> m_UploadingRequests;
+    std::vector<std::shared_ptr<Request>> m_FinishedRequests;
+    size_t m_StagingSizeInFlight = 0;
+    size_t m_NumAcquiredRequests = 0;
+    size_t m_NumDecodingRequests = 0;
+    std::condition_variable m_AllDecodesComplete;
+};
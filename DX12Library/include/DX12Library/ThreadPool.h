@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ *  @file ThreadPool.h
+ *
+ *  @brief A fixed-size pool of worker threads executing jobs in FIFO order.
+ *  Does not depend on Windows or D3D12.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	/**
+	 * @param numThreads The number of worker threads. If 0, one thread less than the number of hardware threads is used (but at least one).
+	 */
+	explicit ThreadPool(uint32_t numThreads = 0);
+
+	/**
+	 * Finishes all the scheduled jobs and joins the worker threads.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	/**
+	 * Schedule a job for execution on one of the worker threads.
+	 */
+	void Schedule(std::function<void()> job);
+
+	/**
+	 * Schedule a job and get a future of its result.
+	 * Exceptions thrown by the job are rethrown by std::future::get.
+	 */
+	template <typename F>
+	auto Submit(F&& function) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+	{
+		using ResultType = std::invoke_result_t<std::decay_t<F>>;
+
+		auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(function));
+		auto future = task->get_future();
+		Schedule([task]() { (*task)(); });
+		return future;
+	}
+
+	/**
+	 * Call function(i) for every i in [0, count) and wait for completion.
+	 * The calling thread participates in the work, so it is safe to call from a worker thread.
+	 * Indices are distributed dynamically, so the order of execution is not defined.
+	 */
+	void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+	/**
+	 * Block until all the scheduled jobs are complete.
+	 */
+	void Wait();
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+	size_t GetNumPendingJobs() const;
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> m_Threads;
+
+	std::queue<std::function<void()>> m_Jobs;
+	size_t m_NumActiveJobs = 0;
+	bool m_IsStopping = false;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_JobAvailable;
+	std::condition_variable m_AllJobsComplete;
+};
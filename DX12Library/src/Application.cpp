@@ -3,6 +3,7 @@
 #include "Application.h"
 #include "ApplicationResources.h"
 
+#include "CommandList.h"
 #include "CommandQueue.h"
 #include "Game.h"
 #include "DescriptorAllocator.h"
@@ -134,6 +135,7 @@ void Application::Destroy()
         assert(gs_Windows.empty() && gs_WindowByName.empty() &&
             "All windows should be destroyed before destroying the application instance.");
 
+        CommandList::ClearTextureCache();
         delete gs_pSingelton;
         gs_pSingelton = nullptr;
     }
@@ -12,18 +12,18 @@
 #include "Resource.h"
 #include "ResourceStateTracker.h"
 #include "RootSignature.h"
+#include "TextureDecoder.h"
 #include "UploadBuffer.h"
 #include "VertexBuffer.h"
 
-#include <DirectXTex.h>
-
 #include <d3d12.h>
 
 #include <filesystem>
 #include "StructuredBuffer.h"
 
-std::map<std::wstring, ID3D12Resource*> CommandList::m_TextureCache;
+std::map<std::wstring, ComPtr<ID3D12Resource>> CommandList::m_TextureCache;
 std::mutex CommandList::m_TextureCacheMutex;
+std::atomic<uint64_t> CommandList::s_NextUploadBufferGeneration = 1;
 namespace fs = std::filesystem;
 
 CommandList::CommandList(D3D12_COMMAND_LIST_TYPE type) : m_D3d12CommandListType(type)
@@ -38,6 +38,7 @@ CommandList::CommandList(D3D12_COMMAND_LIST_TYPE type) : m_D3d12CommandListType(
     ThrowIfFailed(m_D3d12CommandList.As(&m_D3d12CommandList5));
 
     m_PUploadBuffer = std::make_unique<UploadBuffer>();
+    m_UploadBufferGeneration = s_NextUploadBufferGeneration++;
 
     m_PResourceStateTracker = std::make_unique<ResourceStateTracker>();
 
@@ -294,59 +295,102 @@ void CommandList::SetPrimitiveTopology(const D3D_PRIMITIVE_TOPOLOGY primitiveTop
     m_D3d12CommandList->IASetPrimitiveTopology(primitiveTopology);
 }
 
-namespace
+D3D12_RESOURCE_DESC CommandList::GetTextureResourceDesc(const TextureData& textureData, const uint16_t mipLevels)
 {
-    DirectX::ScratchImage LoadScratchImage(const fs::path& filePath, DirectX::TexMetadata* pMetadata,
-        const bool builtInMipMapGeneration = true)
+    const auto format = static_cast<DXGI_FORMAT>(textureData.m_Format);
+
+    switch (textureData.m_Dimension)
     {
-        DirectX::ScratchImage scratchImage;
+    case TextureData::Dimension::Texture1D:
+        return CD3DX12_RESOURCE_DESC::Tex1D(format, textureData.m_Width, textureData.m_DepthOrArraySize, mipLevels);
+    case TextureData::Dimension::Texture2D:
+        return CD3DX12_RESOURCE_DESC::Tex2D(format, textureData.m_Width, textureData.m_Height, textureData.m_DepthOrArraySize, mipLevels);
+    case TextureData::Dimension::Texture3D:
+        return CD3DX12_RESOURCE_DESC::Tex3D(format, textureData.m_Width, textureData.m_Height, textureData.m_DepthOrArraySize, mipLevels);
+    default:
+        throw std::exception("Invalid texture dimension.");
+    }
+}
 
-        if (filePath.extension() == ".dds")
-        {
-            ThrowIfFailed(LoadFromDDSFile(filePath.c_str(), DirectX::DDS_FLAGS_FORCE_RGB, pMetadata, scratchImage));
-        }
-        else if (filePath.extension() == ".hdr")
-        {
-            ThrowIfFailed(LoadFromHDRFile(filePath.c_str(), pMetadata, scratchImage));
-        }
-        else if (filePath.extension() == ".tga")
-        {
-            ThrowIfFailed(LoadFromTGAFile(filePath.c_str(), pMetadata, scratchImage));
-        }
-        else
-        {
-            ThrowIfFailed(LoadFromWICFile(filePath.c_str(), DirectX::WIC_FLAGS_FORCE_RGB, pMetadata, scratchImage));
-        }
+ComPtr<ID3D12Resource> CommandList::CreateTextureResource(const TextureData& textureData, const uint16_t mipLevels)
+{
+    return CreateTextureResource(GetTextureResourceDesc(textureData, mipLevels));
+}
 
-        if (builtInMipMapGeneration && pMetadata->dimension == DirectX::TEX_DIMENSION_TEXTURE2D && !DirectX::IsCompressed(pMetadata->format))
-        {
-            DirectX::ScratchImage mipChain;
-            ThrowIfFailed(GenerateMipMaps(scratchImage.GetImages(), scratchImage.GetImageCount(), *pMetadata,
-                DirectX::TEX_FILTER_DEFAULT, 0, mipChain));
-            return mipChain;
-        }
+ComPtr<ID3D12Resource> CommandList::CreateTextureResource(const D3D12_RESOURCE_DESC& textureDesc)
+{
+    const auto device = Application::Get().GetDevice();
+    ComPtr<ID3D12Resource> textureResource;
+
+    const auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    constexpr auto initialResourceState = D3D12_RESOURCE_STATE_COMMON;
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &textureDesc,
+        initialResourceState,
+        nullptr,
+        IID_PPV_ARGS(&textureResource)
+    ));
+
+    ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), initialResourceState);
+    return textureResource;
+}
+
+bool CommandList::TryGetCachedTexture(const std::wstring& fileName, ComPtr<ID3D12Resource>& resource)
+{
+    std::lock_guard lock(m_TextureCacheMutex);
 
-        return scratchImage;
+    const auto iter = m_TextureCache.find(fileName);
+    if (iter == m_TextureCache.end())
+    {
+        return false;
     }
+
+    resource = iter->second;
+    return true;
 }
 
-bool CommandList::LoadTextureFromFile(Texture& texture, const std::wstring& fileName,
-    const TextureUsageType textureUsage, bool throwOnNotFound)
+void CommandList::AddCachedTexture(const std::wstring& fileName, const ComPtr<ID3D12Resource>& resource)
 {
-    std::wstring effectiveFileName = fileName;
-    fs::path filePath(effectiveFileName);
+    TrimTextureCache();
 
-    // if not dds, try loading dds instead
-    if (filePath.extension() != ".dds")
+    std::lock_guard lock(m_TextureCacheMutex);
+    m_TextureCache[fileName] = resource;
+}
+
+void CommandList::TrimTextureCache()
+{
+    std::lock_guard lock(m_TextureCacheMutex);
+
+    for (auto iter = m_TextureCache.begin(); iter != m_TextureCache.end();)
     {
-        fs::path ddsFilePath = filePath;
-        ddsFilePath.replace_extension(".dds");
-        if (exists(ddsFilePath))
+        // Release returns the new reference count: 1 means that only the cache references the resource.
+        ID3D12Resource* resource = iter->second.Get();
+        resource->AddRef();
+        if (resource->Release() == 1)
         {
-            filePath = ddsFilePath;
-            effectiveFileName = ddsFilePath;
+            ResourceStateTracker::RemoveGlobalResourceState(resource);
+            iter = m_TextureCache.erase(iter);
+        }
+        else
+        {
+            ++iter;
         }
     }
+}
+
+void CommandList::ClearTextureCache()
+{
+    std::lock_guard lock(m_TextureCacheMutex);
+    m_TextureCache.clear();
+}
+
+bool CommandList::LoadTextureFromFile(Texture& texture, const std::wstring& fileName,
+    const TextureUsageType textureUsage, bool throwOnNotFound)
+{
+    const fs::path filePath = TextureDecoder::ResolvePath(fileName);
+    const std::wstring effectiveFileName = filePath.wstring();
 
     if (!exists(filePath))
     {
@@ -355,92 +399,34 @@ bool CommandList::LoadTextureFromFile(Texture& texture, const std::wstring& file
         return false;
     }
 
-    std::lock_guard lock(m_TextureCacheMutex);
-    const auto iter = m_TextureCache.find(effectiveFileName);
-    if (iter != m_TextureCache.end())
+    ComPtr<ID3D12Resource> textureResource;
+    if (TryGetCachedTexture(effectiveFileName, textureResource))
     {
-        texture.SetTextureUsage(textureUsage);
-        texture.SetD3D12Resource(iter->second);
-        texture.CreateViews();
-        texture.SetName(effectiveFileName);
-    }
-    else
-    {
-        DirectX::TexMetadata metadata{};
-        auto scratchImage = LoadScratchImage(filePath, &metadata);
-
-        if (textureUsage == TextureUsageType::Albedo)
-        {
-            metadata.format = DirectX::MakeSRGB(metadata.format);
-        }
-
-        D3D12_RESOURCE_DESC textureDesc = {};
-        switch (metadata.dimension)
-        {
-        case DirectX::TEX_DIMENSION_TEXTURE1D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex1D(
-                metadata.format, metadata.width, static_cast<UINT16>(metadata.arraySize));
-            break;
-        case DirectX::TEX_DIMENSION_TEXTURE2D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
-                metadata.format, metadata.width, static_cast<UINT>(metadata.height), static_cast<UINT16>(metadata.arraySize));
-            break;
-        case DirectX::TEX_DIMENSION_TEXTURE3D:
-            textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
-                metadata.format, metadata.width, static_cast<UINT>(metadata.height), static_cast<UINT16>(metadata.depth));
-            break;
-        default:
-            throw std::exception("Invalid texture dimension.");
-        }
-
-        const auto device = Application::Get().GetDevice();
-        ComPtr<ID3D12Resource> textureResource;
-
-        const auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        constexpr auto initialResourceState = D3D12_RESOURCE_STATE_COMMON;
-        ThrowIfFailed(device->CreateCommittedResource(
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &textureDesc,
-            initialResourceState,
-            nullptr,
-            IID_PPV_ARGS(&textureResource)
-        ));
-
         texture.SetTextureUsage(textureUsage);
         texture.SetD3D12Resource(textureResource);
         texture.CreateViews();
         texture.SetName(effectiveFileName);
+        return true;
+    }
 
-        ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), initialResourceState);
-
-        std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
-        const DirectX::Image* pImages = scratchImage.GetImages();
-        for (int i = 0; i < scratchImage.GetImageCount(); ++i)
-        {
-            auto& subresourceData = subresources[i];
-            subresourceData.RowPitch = pImages[i].rowPitch;
-            subresourceData.SlicePitch = pImages[i].slicePitch;
-            subresourceData.pData = pImages[i].pixels;
-        }
+    // The cache is not locked while decoding, so other threads can load other textures in the meantime.
+    const TextureData textureData = TextureDecoder::Decode(filePath, textureUsage);
+    textureResource = CreateTextureResource(textureData, 0);
 
-        auto numSubresources = static_cast<uint32_t>(subresources.size());
-        CopyTextureSubresource(
-            texture,
-            0,
-            numSubresources,
-            subresources.data()
-        );
+    texture.SetTextureUsage(textureUsage);
+    texture.SetD3D12Resource(textureResource);
+    texture.CreateViews();
+    texture.SetName(effectiveFileName);
 
-        // Not used when having built-in mipmap generation from DirectXTex
-        if (subresources.size() < textureResource->GetDesc().MipLevels)
-        {
-            GenerateMips(texture);
-        }
+    CopyTextureData(texture, textureData);
 
-        m_TextureCache[effectiveFileName] = textureResource.Get();
+    // Not used when having built-in mipmap generation from DirectXTex
+    if (textureData.m_Subresources.size() < textureResource->GetDesc().MipLevels)
+    {
+        GenerateMips(texture);
     }
 
+    AddCachedTexture(effectiveFileName, textureResource);
     return true;
 }
 
@@ -474,6 +460,19 @@ void CommandList::ClearDepthStencilTexture(const Texture& texture, const D3D12_C
     TrackResource(texture);
 }
 
+void CommandList::ClearDepthStencilTextureArraySlice(const Texture& texture, const uint32_t arrayIndex, const D3D12_CLEAR_FLAGS clearFlags,
+    const float depth, const uint8_t stencil)
+{
+    if (texture.AreAutoBarriersEnabled())
+    {
+        TransitionBarrier(texture, D3D12_RESOURCE_STATE_DEPTH_WRITE, texture.GetDepthStencilSubresourceIndex(static_cast<UINT16>(arrayIndex)));
+    }
+
+    m_D3d12CommandList->ClearDepthStencilView(texture.GetDepthStencilViewArray(arrayIndex), clearFlags, depth, stencil, 0, nullptr);
+
+    TrackResource(texture);
+}
+
 void CommandList::GenerateMips(Texture& texture)
 {
     if (m_D3d12CommandListType == D3D12_COMMAND_LIST_TYPE_COPY)
@@ -655,6 +654,49 @@ void CommandList::CopyTextureSubresource(const Texture& texture, const uint32_t
     TrackObject(destinationResource);
 }
 
+void CommandList::CopyTextureData(const Texture& texture, const TextureData& textureData)
+{
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(textureData.m_Subresources.size());
+    for (size_t i = 0; i < subresources.size(); ++i)
+    {
+        const auto& subresource = textureData.m_Subresources[i];
+        subresources[i].pData = subresource.m_Data;
+        subresources[i].RowPitch = static_cast<LONG_PTR>(subresource.m_RowPitch);
+        subresources[i].SlicePitch = static_cast<LONG_PTR>(subresource.m_SlicePitch);
+    }
+
+    CopyTextureSubresource(texture, 0, static_cast<uint32_t>(subresources.size()), subresources.data());
+}
+
+void CommandList::CopyTextureMips(const Texture& dstTexture, const uint32_t dstFirstMip, const Texture& srcTexture,
+    const uint32_t srcFirstMip, const uint32_t numMips)
+{
+    const auto dstResource = dstTexture.GetD3D12Resource();
+    const auto srcResource = srcTexture.GetD3D12Resource();
+
+    if (dstTexture.AreAutoBarriersEnabled())
+    {
+        TransitionBarrier(dstTexture, D3D12_RESOURCE_STATE_COPY_DEST);
+    }
+
+    if (srcTexture.AreAutoBarriersEnabled())
+    {
+        TransitionBarrier(srcTexture, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    }
+
+    FlushResourceBarriers();
+
+    for (uint32_t i = 0; i < numMips; ++i)
+    {
+        const CD3DX12_TEXTURE_COPY_LOCATION dstLocation(dstResource.Get(), dstFirstMip + i);
+        const CD3DX12_TEXTURE_COPY_LOCATION srcLocation(srcResource.Get(), srcFirstMip + i);
+        m_D3d12CommandList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
+    }
+
+    TrackResource(srcTexture);
+    TrackResource(dstTexture);
+}
+
 void CommandList::SetGraphicsDynamicConstantBuffer(const uint32_t rootParameterIndex, const size_t sizeInBytes,
     const void* bufferData) const
 {
@@ -664,6 +706,11 @@ void CommandList::SetGraphicsDynamicConstantBuffer(const uint32_t rootParameterI
     m_D3d12CommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, heapAllocation.Gpu);
 }
 
+void CommandList::SetGraphicsRootConstantBufferView(const uint32_t rootParameterIndex, const D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+    m_D3d12CommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
 void CommandList::SetComputeDynamicConstantBuffer(uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData) const
 {
     const auto heapAllocation = m_PUploadBuffer->Allocate(sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
@@ -747,10 +794,16 @@ void CommandList::SetScissorRects(const std::vector<D3D12_RECT>& scissorRects)
 void CommandList::SetPipelineState(const ComPtr<ID3D12PipelineState>& pipelineState)
 {
     m_D3d12CommandList->SetPipelineState(pipelineState.Get());
+    m_SkipDraws = false;
 
     TrackObject(pipelineState);
 }
 
+void CommandList::SkipDrawsUntilNextPipelineState()
+{
+    m_SkipDraws = true;
+}
+
 void CommandList::SetGraphicsRootSignature(const RootSignature& rootSignature)
 {
     const auto d3d12RootSignature = rootSignature.GetRootSignature().Get();
@@ -1004,6 +1057,11 @@ void CommandList::DiscardResource(const Resource& resource)
 void CommandList::Draw(const uint32_t vertexCount, const uint32_t instanceCount, const uint32_t startVertex,
     const uint32_t startInstance)
 {
+    if (m_SkipDraws)
+    {
+        return;
+    }
+
     FlushResourceBarriers();
 
     for (const auto& dynamicDescriptorHeap : m_DynamicDescriptorHeaps)
@@ -1018,6 +1076,11 @@ void CommandList::DrawIndexed(const uint32_t indexCount, const uint32_t instance
     const int32_t baseVertex,
     const uint32_t startInstance)
 {
+    if (m_SkipDraws)
+    {
+        return;
+    }
+
     FlushResourceBarriers();
 
     for (const auto& dynamicDescriptorHeap : m_DynamicDescriptorHeaps)
@@ -1034,6 +1097,11 @@ void CommandList::DrawIndirect(
     const ComPtr<ID3D12Resource>& pCountBuffer, const uint64_t countBufferOffset
 )
 {
+    if (m_SkipDraws)
+    {
+        return;
+    }
+
     FlushResourceBarriers();
 
     for (const auto& dynamicDescriptorHeap : m_DynamicDescriptorHeaps)
@@ -1084,6 +1152,7 @@ void CommandList::Reset()
 
     m_PResourceStateTracker->Reset();
     m_PUploadBuffer->Reset();
+    m_UploadBufferGeneration = s_NextUploadBufferGeneration++;
 
     ReleaseTrackedObjects();
 
@@ -1095,6 +1164,7 @@ void CommandList::Reset()
 
     m_RootSignature = nullptr;
     m_ComputeCommandList = nullptr;
+    m_SkipDraws = false;
 }
 
 void CommandList::TrackObject(const ComPtr<ID3D12Object>& object)
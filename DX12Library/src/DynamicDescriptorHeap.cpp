@@ -9,6 +9,10 @@
 
 #include "RootSignature.h"
 
+DynamicDescriptorHeap::FrameStatistics DynamicDescriptorHeap::s_CurrentFrameStatistics;
+DynamicDescriptorHeap::Statistics DynamicDescriptorHeap::s_LastFrameStatistics;
+std::mutex DynamicDescriptorHeap::s_LastFrameStatisticsMutex;
+
 DynamicDescriptorHeap::DynamicDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_TYPE heapType,
 	const uint32_t numDescriptorsPerHeap)
 	: m_DescriptorHeapType(heapType)
@@ -23,6 +27,11 @@ DynamicDescriptorHeap::DynamicDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_TYPE he
 
 	// Allocate space for CPU descriptors
 	m_DescriptorHandleCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_NumDescriptorsPerHeap);
+
+	// A GPU visible heap can never hold more than m_NumDescriptorsPerHeap committed descriptors.
+	m_CommittedDescriptors.reserve(m_NumDescriptorsPerHeap);
+	m_SrcDescriptorRangeStarts.reserve(m_NumDescriptorsPerHeap);
+	m_SrcDescriptorRangeSizes.reserve(m_NumDescriptorsPerHeap);
 }
 
 DynamicDescriptorHeap::~DynamicDescriptorHeap() = default;
@@ -141,6 +150,37 @@ ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::CreateDescriptorHeap() const
 	return descriptorHeap;
 }
 
+void DynamicDescriptorHeap::SwitchToNewDescriptorHeap(CommandList& commandList)
+{
+	m_CurrentDescriptorHeap = RequestDescriptorHeap();
+	m_CurrentCpuDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+	m_CurrentGpuDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+	m_NumFreeHandles = m_NumDescriptorsPerHeap;
+
+	commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap.Get());
+
+	// When updating the descriptor heap on the command list, all descriptor
+	// tables must be (re)recopied to the new descriptor heap (not just
+	// the stale descriptor tables).
+	m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+
+	// Tables committed to the previous heap cannot be referenced anymore.
+	m_CommittedTables.clear();
+	m_CommittedDescriptors.clear();
+}
+
+size_t DynamicDescriptorHeap::ComputeTableHash(const D3D12_CPU_DESCRIPTOR_HANDLE* descriptors, const uint32_t numDescriptors)
+{
+	size_t seed = numDescriptors;
+
+	for (uint32_t i = 0; i < numDescriptors; ++i)
+	{
+		std::hash_combine(seed, descriptors[i].ptr);
+	}
+
+	return seed;
+}
+
 void DynamicDescriptorHeap::CommitStagedDescriptors(CommandList& commandList,
 	std::function<void(ID3D12GraphicsCommandList*, UINT,
 		D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc)
@@ -155,46 +195,98 @@ void DynamicDescriptorHeap::CommitStagedDescriptors(CommandList& commandList,
 
 		if (!m_CurrentDescriptorHeap || m_NumFreeHandles < numDescriptorsToCommit)
 		{
-			m_CurrentDescriptorHeap = RequestDescriptorHeap();
-			m_CurrentCpuDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-			m_CurrentGpuDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-			m_NumFreeHandles = m_NumDescriptorsPerHeap;
+			SwitchToNewDescriptorHeap(commandList);
+		}
 
-			commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap.Get());
+		Statistics statistics;
+
+		// All copied tables are packed one after another in the GPU visible heap,
+		// so the copies are batched into a single destination range.
+		const D3D12_CPU_DESCRIPTOR_HANDLE destDescriptorRangeStart = m_CurrentCpuDescriptorHandle;
+		UINT destDescriptorRangeSize = 0;
+		m_SrcDescriptorRangeStarts.clear();
+		m_SrcDescriptorRangeSizes.clear();
 
-			// When updating the descriptor heap on the command list, all descriptor
-			// tables must be (re)recopied to the new descriptor heap (not just
-			// the stale descriptor tables).
-			m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
-		}
 		DWORD rootIndex;
 
 		while (_BitScanForward(&rootIndex, m_StaleDescriptorTableBitMask))
 		{
 			const UINT numSrcDescriptors = m_DescriptorTableCaches[rootIndex].NumDescriptors;
 			const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorHandles = m_DescriptorTableCaches[rootIndex].BaseDescriptor;
-
-			const D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStarts[] = {
-				m_CurrentCpuDescriptorHandle
-			};
-			const UINT pDestDescriptorRangeSizes[] = {
-				numSrcDescriptors
-			};
-
-			// Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
-			device->CopyDescriptors(1, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes, numSrcDescriptors,
-				pSrcDescriptorHandles, nullptr, m_DescriptorHeapType);
+			const size_t tableHash = ComputeTableHash(pSrcDescriptorHandles, numSrcDescriptors);
+
+			D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle;
+
+			// Reuse the GPU visible copy if the same set of descriptors has already been committed to the current heap.
+			const auto findResult = m_CommittedTables.find(tableHash);
+			if (findResult != m_CommittedTables.end() &&
+				findResult->second.NumDescriptors == numSrcDescriptors &&
+				std::equal(pSrcDescriptorHandles, pSrcDescriptorHandles + numSrcDescriptors,
+					m_CommittedDescriptors.data() + findResult->second.SourceOffset,
+					[](const D3D12_CPU_DESCRIPTOR_HANDLE& lhs, const D3D12_CPU_DESCRIPTOR_HANDLE& rhs) { return lhs.ptr == rhs.ptr; }))
+			{
+				gpuDescriptorHandle = findResult->second.GpuDescriptor;
+				++statistics.NumTablesReused;
+			}
+			else
+			{
+				gpuDescriptorHandle = m_CurrentGpuDescriptorHandle;
+
+				// Coalesce adjacent CPU descriptors into source ranges.
+				for (UINT i = 0; i < numSrcDescriptors; ++i)
+				{
+					const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor = pSrcDescriptorHandles[i];
+
+					if (!m_SrcDescriptorRangeStarts.empty() &&
+						m_SrcDescriptorRangeStarts.back().ptr + static_cast<SIZE_T>(m_SrcDescriptorRangeSizes.back()) * m_DescriptorHandleIncrementSize == srcDescriptor.ptr)
+					{
+						++m_SrcDescriptorRangeSizes.back();
+					}
+					else
+					{
+						m_SrcDescriptorRangeStarts.push_back(srcDescriptor);
+						m_SrcDescriptorRangeSizes.push_back(1);
+					}
+				}
+
+				CommittedTable committedTable;
+				committedTable.NumDescriptors = numSrcDescriptors;
+				committedTable.SourceOffset = static_cast<uint32_t>(m_CommittedDescriptors.size());
+				committedTable.GpuDescriptor = gpuDescriptorHandle;
+				m_CommittedTables[tableHash] = committedTable;
+				m_CommittedDescriptors.insert(m_CommittedDescriptors.end(), pSrcDescriptorHandles, pSrcDescriptorHandles + numSrcDescriptors);
+
+				m_CurrentCpuDescriptorHandle.Offset(static_cast<INT>(numSrcDescriptors), m_DescriptorHandleIncrementSize);
+				m_CurrentGpuDescriptorHandle.Offset(static_cast<INT>(numSrcDescriptors), m_DescriptorHandleIncrementSize);
+				m_NumFreeHandles -= numSrcDescriptors;
+				destDescriptorRangeSize += numSrcDescriptors;
+
+				++statistics.NumTablesCopied;
+			}
 
 			// Set the descriptors on the command list using the passed-in setter function.
-			setFunc(graphicsCommandList, rootIndex, m_CurrentGpuDescriptorHandle);
-
-			m_CurrentCpuDescriptorHandle.Offset(static_cast<INT>(numSrcDescriptors), m_DescriptorHandleIncrementSize);
-			m_CurrentGpuDescriptorHandle.Offset(static_cast<INT>(numSrcDescriptors), m_DescriptorHandleIncrementSize);
-			m_NumFreeHandles -= numSrcDescriptors;
+			setFunc(graphicsCommandList, rootIndex, gpuDescriptorHandle);
 
 			// Flip the stale bit so the descriptor table is not recopied again unless it is updated with a new descriptor.
 			m_StaleDescriptorTableBitMask ^= (1 << rootIndex);
 		}
+
+		if (destDescriptorRangeSize > 0)
+		{
+			// Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
+			device->CopyDescriptors(1, &destDescriptorRangeStart, &destDescriptorRangeSize,
+				static_cast<UINT>(m_SrcDescriptorRangeStarts.size()), m_SrcDescriptorRangeStarts.data(), m_SrcDescriptorRangeSizes.data(),
+				m_DescriptorHeapType);
+
+			statistics.NumDescriptorsCopied = destDescriptorRangeSize;
+			statistics.NumCopyCalls = 1;
+		}
+
+		m_Statistics.NumDescriptorsCopied += statistics.NumDescriptorsCopied;
+		m_Statistics.NumTablesCopied += statistics.NumTablesCopied;
+		m_Statistics.NumTablesReused += statistics.NumTablesReused;
+		m_Statistics.NumCopyCalls += statistics.NumCopyCalls;
+		AddFrameStatistics(statistics);
 	}
 }
 
@@ -213,17 +305,7 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(CommandList& c
 {
 	if (!m_CurrentDescriptorHeap || m_NumFreeHandles < 1)
 	{
-		m_CurrentDescriptorHeap = RequestDescriptorHeap();
-		m_CurrentCpuDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-		m_CurrentGpuDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-		m_NumFreeHandles = m_NumDescriptorsPerHeap;
-
-		commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap.Get());
-
-		// When updating the descriptor heap on the command list, all descriptor
-		// tables must be (re)recopied to the new descriptor heap (not just
-		// the stale descriptor tables).
-		m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+		SwitchToNewDescriptorHeap(commandList);
 	}
 
 	const auto device = Application::Get().GetDevice();
@@ -235,6 +317,13 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(CommandList& c
 	m_CurrentGpuDescriptorHandle.Offset(1, m_DescriptorHandleIncrementSize);
 	m_NumFreeHandles -= 1;
 
+	Statistics statistics;
+	statistics.NumDescriptorsCopied = 1;
+	statistics.NumCopyCalls = 1;
+	m_Statistics.NumDescriptorsCopied += statistics.NumDescriptorsCopied;
+	m_Statistics.NumCopyCalls += statistics.NumCopyCalls;
+	AddFrameStatistics(statistics);
+
 	return hGpu;
 }
 
@@ -252,4 +341,58 @@ void DynamicDescriptorHeap::Reset()
 	{
 		descriptorTableCache.Reset();
 	}
+
+	m_CommittedTables.clear();
+	m_CommittedDescriptors.clear();
+	m_Statistics = {};
+}
+
+DynamicDescriptorHeap::Statistics DynamicDescriptorHeap::GetLastFrameStatistics()
+{
+	RollOverFrameStatistics();
+
+	std::lock_guard<std::mutex> lock(s_LastFrameStatisticsMutex);
+	return s_LastFrameStatistics;
+}
+
+void DynamicDescriptorHeap::AddFrameStatistics(const Statistics& statistics)
+{
+	RollOverFrameStatistics();
+
+	s_CurrentFrameStatistics.NumDescriptorsCopied += statistics.NumDescriptorsCopied;
+	s_CurrentFrameStatistics.NumTablesCopied += statistics.NumTablesCopied;
+	s_CurrentFrameStatistics.NumTablesReused += statistics.NumTablesReused;
+	s_CurrentFrameStatistics.NumCopyCalls += statistics.NumCopyCalls;
+}
+
+void DynamicDescriptorHeap::RollOverFrameStatistics()
+{
+	const uint64_t frameIndex = Application::GetFrameCount();
+	uint64_t statisticsFrameIndex = s_CurrentFrameStatistics.FrameIndex.load();
+
+	// Only the thread which advances the frame index moves the counters.
+	if (statisticsFrameIndex != frameIndex &&
+		s_CurrentFrameStatistics.FrameIndex.compare_exchange_strong(statisticsFrameIndex, frameIndex))
+	{
+		Statistics lastFrameStatistics;
+
+		// The counters are only meaningful if they were collected during the frame right before the current one.
+		if (statisticsFrameIndex + 1 == frameIndex)
+		{
+			lastFrameStatistics.NumDescriptorsCopied = s_CurrentFrameStatistics.NumDescriptorsCopied.exchange(0);
+			lastFrameStatistics.NumTablesCopied = s_CurrentFrameStatistics.NumTablesCopied.exchange(0);
+			lastFrameStatistics.NumTablesReused = s_CurrentFrameStatistics.NumTablesReused.exchange(0);
+			lastFrameStatistics.NumCopyCalls = s_CurrentFrameStatistics.NumCopyCalls.exchange(0);
+		}
+		else
+		{
+			s_CurrentFrameStatistics.NumDescriptorsCopied = 0;
+			s_CurrentFrameStatistics.NumTablesCopied = 0;
+			s_CurrentFrameStatistics.NumTablesReused = 0;
+			s_CurrentFrameStatistics.NumCopyCalls = 0;
+		}
+
+		std::lock_guard<std::mutex> lock(s_LastFrameStatisticsMutex);
+		s_LastFrameStatistics = lastFrameStatistics;
+	}
 }
@@ -0,0 +1,151 @@
+#include "MemoryMappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+
+		m_Data = std::exchange(other.m_Data, nullptr);
+		m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+		m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+		m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+#endif
+	}
+
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MemoryMappedFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+	const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_Data = static_cast<const uint8_t*>(data);
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	m_FileHandle = file;
+	m_MappingHandle = mapping;
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if (m_Data != nullptr)
+	{
+		UnmapViewOfFile(m_Data);
+	}
+
+	if (m_MappingHandle != nullptr)
+	{
+		CloseHandle(m_MappingHandle);
+	}
+
+	if (m_FileHandle != nullptr)
+	{
+		CloseHandle(m_FileHandle);
+	}
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_FileHandle = nullptr;
+	m_MappingHandle = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const std::filesystem::path& path)
+{
+	Close();
+
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat {};
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping stays valid after the descriptor is closed.
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_Data = static_cast<const uint8_t*>(data);
+	m_Size = static_cast<size_t>(fileStat.st_size);
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if (m_Data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+	}
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+#endif
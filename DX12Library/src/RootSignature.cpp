@@ -3,6 +3,7 @@
 #include "RootSignature.h"
 
 #include "Application.h"
+#include "HashUtils.h"
 
 RootSignature::RootSignature()
 	:
@@ -10,6 +11,7 @@ RootSignature::RootSignature()
 	, NumDescriptorsPerTable{ 0 }
 	, SamplerTableBitMask(0)
 	, DescriptorTableBitMask(0)
+	, SerializedHash(0)
 {
 }
 
@@ -19,6 +21,7 @@ RootSignature::RootSignature(
 	, NumDescriptorsPerTable{ 0 }
 	, SamplerTableBitMask(0)
 	, DescriptorTableBitMask(0)
+	, SerializedHash(0)
 {
 	SetRootSignatureDesc(rootSignatureDesc, rootSignatureVersion);
 }
@@ -49,6 +52,7 @@ void RootSignature::Destroy()
 
 	DescriptorTableBitMask = 0;
 	SamplerTableBitMask = 0;
+	SerializedHash = 0;
 
 	memset(NumDescriptorsPerTable, 0, sizeof NumDescriptorsPerTable);
 }
@@ -143,6 +147,7 @@ void RootSignature::SetRootSignatureDesc(
 		ThrowIfFailed(hResult);
 	}
 
+	SerializedHash = HashUtils::Fnv1a(rootSignatureBlob->GetBufferPointer(), rootSignatureBlob->GetBufferSize());
 
 	// Create the root signature.
 	ThrowIfFailed(device->CreateRootSignature(0, rootSignatureBlob->GetBufferPointer(),
@@ -38,9 +38,14 @@ namespace hlsl
 
 
 
+std::wstring ShaderUtils::GetShaderFilePath(const std::wstring& fileName)
+{
+    return L"Shaders/" + fileName;
+}
+
 Microsoft::WRL::ComPtr<ID3DBlob> ShaderUtils::LoadShaderFromFile(const std::wstring& fileName)
 {
-    const auto completePath = L"Shaders/" + fileName;
+    const auto completePath = GetShaderFilePath(fileName);
 
     const auto& library = Application::Get().GetDxcLibrary();
     uint32_t codePage = CP_UTF8;
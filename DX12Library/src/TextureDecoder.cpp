@@ -0,0 +1,116 @@
+#include "TextureDecoder.h"
+
+#include <DirectXTex.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    void ThrowIfFailed(const HRESULT result, const fs::path& path)
+    {
+        if (FAILED(result))
+        {
+            throw std::runtime_error("Failed to decode " + path.string() + " (" + std::to_string(result) + ").");
+        }
+    }
+
+    DirectX::ScratchImage LoadScratchImage(const fs::path& path, DirectX::TexMetadata* pMetadata)
+    {
+        DirectX::ScratchImage scratchImage;
+
+        if (path.extension() == ".dds")
+        {
+            ThrowIfFailed(LoadFromDDSFile(path.c_str(), DirectX::DDS_FLAGS_FORCE_RGB, pMetadata, scratchImage), path);
+        }
+        else if (path.extension() == ".hdr")
+        {
+            ThrowIfFailed(LoadFromHDRFile(path.c_str(), pMetadata, scratchImage), path);
+        }
+        else if (path.extension() == ".tga")
+        {
+            ThrowIfFailed(LoadFromTGAFile(path.c_str(), pMetadata, scratchImage), path);
+        }
+        else
+        {
+#ifdef _WIN32
+            ThrowIfFailed(LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_FORCE_RGB, pMetadata, scratchImage), path);
+#else
+            throw std::runtime_error("WIC formats are only supported on Windows: " + path.string() + ".");
+#endif
+        }
+
+        return scratchImage;
+    }
+
+    TextureData::Dimension ToDimension(const DirectX::TEX_DIMENSION dimension)
+    {
+        switch (dimension)
+        {
+        case DirectX::TEX_DIMENSION_TEXTURE1D:
+            return TextureData::Dimension::Texture1D;
+        case DirectX::TEX_DIMENSION_TEXTURE2D:
+            return TextureData::Dimension::Texture2D;
+        case DirectX::TEX_DIMENSION_TEXTURE3D:
+            return TextureData::Dimension::Texture3D;
+        default:
+            throw std::runtime_error("Invalid texture dimension.");
+        }
+    }
+}
+
+fs::path TextureDecoder::ResolvePath(const fs::path& path)
+{
+    if (path.extension() != ".dds")
+    {
+        fs::path ddsPath = path;
+        ddsPath.replace_extension(".dds");
+        if (exists(ddsPath))
+        {
+            return ddsPath;
+        }
+    }
+
+    return path;
+}
+
+TextureData TextureDecoder::Decode(const fs::path& path, const TextureUsageType usage, const bool generateMips)
+{
+    DirectX::TexMetadata metadata{};
+    auto scratchImage = std::make_shared<DirectX::ScratchImage>(LoadScratchImage(path, &metadata));
+
+    if (generateMips && metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE2D && !DirectX::IsCompressed(metadata.format))
+    {
+        auto mipChain = std::make_shared<DirectX::ScratchImage>();
+        ThrowIfFailed(GenerateMipMaps(scratchImage->GetImages(), scratchImage->GetImageCount(), metadata,
+            DirectX::TEX_FILTER_DEFAULT, 0, *mipChain), path);
+        scratchImage = std::move(mipChain);
+        metadata = scratchImage->GetMetadata();
+    }
+
+    if (usage == TextureUsageType::Albedo)
+    {
+        metadata.format = DirectX::MakeSRGB(metadata.format);
+    }
+
+    TextureData textureData;
+    textureData.m_Dimension = ToDimension(metadata.dimension);
+    textureData.m_Format = static_cast<uint32_t>(metadata.format);
+    textureData.m_Width = metadata.width;
+    textureData.m_Height = static_cast<uint32_t>(metadata.height);
+    textureData.m_DepthOrArraySize = static_cast<uint16_t>(metadata.dimension == DirectX::TEX_DIMENSION_TEXTURE3D ? metadata.depth : metadata.arraySize);
+    textureData.m_MipLevels = static_cast<uint16_t>(metadata.mipLevels);
+    textureData.m_SizeInBytes = scratchImage->GetPixelsSize();
+
+    const DirectX::Image* pImages = scratchImage->GetImages();
+    textureData.m_Subresources.resize(scratchImage->GetImageCount());
+    for (size_t i = 0; i < textureData.m_Subresources.size(); ++i)
+    {
+        textureData.m_Subresources[i] = { pImages[i].pixels, pImages[i].rowPitch, pImages[i].slicePitch };
+    }
+
+    textureData.m_Storage = std::move(scratchImage);
+    return textureData;
+}
@@ -0,0 +1,312 @@
+#include "TextureResidencyManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+TextureResidencyManager::TextureResidencyManager(const size_t budgetInBytes, const uint32_t maxTailSize)
+    : m_BudgetInBytes(budgetInBytes)
+    , m_MaxTailSize(maxTailSize)
+{}
+
+TextureResidencyManager::TextureId TextureResidencyManager::Register(const TextureDesc& desc)
+{
+    const size_t mipLevels = desc.m_MipSizesInBytes.size();
+    if (mipLevels == 0 || mipLevels >= NO_REQUEST)
+    {
+        throw std::invalid_argument("Invalid number of mip levels.");
+    }
+
+    TextureId id;
+    if (!m_FreeIds.empty())
+    {
+        id = m_FreeIds.back();
+        m_FreeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<TextureId>(m_Textures.size());
+        m_Textures.emplace_back();
+    }
+
+    Entry& entry = m_Textures[id];
+    entry = {};
+    entry.m_Width = desc.m_Width;
+    entry.m_Height = desc.m_Height;
+    entry.m_MipLevels = static_cast<uint16_t>(mipLevels);
+    entry.m_TailMip = desc.m_IsStreamed ? ComputeTailMip(desc.m_Width, desc.m_Height, entry.m_MipLevels, m_MaxTailSize) : 0;
+    entry.m_IsRegistered = true;
+
+    entry.m_SizesFromMipInBytes.resize(mipLevels + 1);
+    entry.m_SizesFromMipInBytes[mipLevels] = 0;
+    for (size_t mip = mipLevels; mip-- > 0;)
+    {
+        entry.m_SizesFromMipInBytes[mip] = entry.m_SizesFromMipInBytes[mip + 1] + desc.m_MipSizesInBytes[mip];
+    }
+
+    entry.m_Mip = entry.m_TailMip;
+    entry.m_PreviousMip = entry.m_TailMip;
+    m_ResidentSizeInBytes += entry.m_SizesFromMipInBytes[entry.m_Mip];
+
+    LinkAsMostRecent(id);
+    ++m_NumTextures;
+    return id;
+}
+
+void TextureResidencyManager::Unregister(const TextureId id)
+{
+    Entry& entry = GetEntry(id);
+    m_ResidentSizeInBytes -= entry.m_SizesFromMipInBytes[entry.m_Mip];
+
+    Unlink(id);
+    entry = {};
+    m_FreeIds.push_back(id);
+    --m_NumTextures;
+}
+
+void TextureResidencyManager::Request(const TextureId id, const uint16_t mip)
+{
+    Entry& entry = GetEntry(id);
+
+    if (entry.m_RequestedMip == NO_REQUEST)
+    {
+        m_RequestedTextures.push_back(id);
+    }
+
+    entry.m_RequestedMip = std::min({ entry.m_RequestedMip, mip, static_cast<uint16_t>(entry.m_MipLevels - 1) });
+
+    if (entry.m_LastUsedFrame != m_Frame)
+    {
+        entry.m_LastUsedFrame = m_Frame;
+        Unlink(id);
+        LinkAsMostRecent(id);
+    }
+}
+
+void TextureResidencyManager::RequestScreenSize(const TextureId id, const float screenSizeInPixels)
+{
+    const Entry& entry = GetEntry(id);
+    Request(id, ComputeMip(entry.m_Width, entry.m_Height, entry.m_MipLevels, screenSizeInPixels));
+}
+
+const std::vector<TextureResidencyManager::Change>& TextureResidencyManager::Update()
+{
+    m_Changes.clear();
+    m_ChangedTextures.clear();
+    m_EvictionCursor = m_LeastRecentlyUsed;
+
+    // The budget might have been lowered: the requested mips are not protected, they are granted again below if they fit.
+    MakeRoom(0, false);
+
+    // The blurriest textures first.
+    const auto getMissingMips = [this](const TextureId id)
+    {
+        const Entry& entry = m_Textures[id];
+        return entry.m_Mip > entry.m_RequestedMip ? entry.m_Mip - entry.m_RequestedMip : 0;
+    };
+    std::sort(m_RequestedTextures.begin(), m_RequestedTextures.end(), [&](const TextureId id1, const TextureId id2)
+        {
+            const int missingMips1 = getMissingMips(id1);
+            const int missingMips2 = getMissingMips(id2);
+            return missingMips1 != missingMips2 ? missingMips1 > missingMips2 : id1 < id2;
+        });
+
+    for (const TextureId id : m_RequestedTextures)
+    {
+        Entry& entry = m_Textures[id];
+
+        // Unregistered after the request.
+        if (entry.m_RequestedMip == NO_REQUEST)
+        {
+            continue;
+        }
+
+        while (entry.m_Mip > entry.m_RequestedMip)
+        {
+            const size_t mipSize = entry.m_SizesFromMipInBytes[entry.m_Mip - 1] - entry.m_SizesFromMipInBytes[entry.m_Mip];
+            if (!MakeRoom(mipSize, true))
+            {
+                break;
+            }
+
+            SetMip(id, entry.m_Mip - 1);
+        }
+    }
+
+    for (const TextureId id : m_RequestedTextures)
+    {
+        m_Textures[id].m_RequestedMip = NO_REQUEST;
+    }
+    m_RequestedTextures.clear();
+
+    for (const TextureId id : m_ChangedTextures)
+    {
+        Entry& entry = m_Textures[id];
+        entry.m_IsChanged = false;
+
+        if (entry.m_Mip != entry.m_PreviousMip)
+        {
+            m_Changes.push_back({ id, entry.m_PreviousMip, entry.m_Mip });
+            entry.m_PreviousMip = entry.m_Mip;
+        }
+    }
+
+    ++m_Frame;
+    return m_Changes;
+}
+
+uint16_t TextureResidencyManager::GetMip(const TextureId id) const
+{
+    return GetEntry(id).m_Mip;
+}
+
+uint16_t TextureResidencyManager::GetTailMip(const TextureId id) const
+{
+    return GetEntry(id).m_TailMip;
+}
+
+uint16_t TextureResidencyManager::GetMipLevels(const TextureId id) const
+{
+    return GetEntry(id).m_MipLevels;
+}
+
+uint16_t TextureResidencyManager::ComputeMip(const uint32_t width, const uint32_t height, const uint16_t mipLevels, const float screenSizeInPixels)
+{
+    const uint16_t lastMip = mipLevels > 0 ? mipLevels - 1 : 0;
+    if (!(screenSizeInPixels > 0.0f))
+    {
+        return lastMip;
+    }
+
+    const float texelsPerPixel = static_cast<float>(std::max(width, height)) / screenSizeInPixels;
+    if (texelsPerPixel <= 1.0f)
+    {
+        return 0;
+    }
+
+    const float mip = std::floor(std::log2(texelsPerPixel));
+    return static_cast<uint16_t>(std::min(mip, static_cast<float>(lastMip)));
+}
+
+uint16_t TextureResidencyManager::ComputeTailMip(const uint32_t width, const uint32_t height, const uint16_t mipLevels, const uint32_t maxTailSize)
+{
+    for (uint16_t mip = 0; mip < mipLevels; ++mip)
+    {
+        if (std::max(width >> mip, 1u) <= maxTailSize && std::max(height >> mip, 1u) <= maxTailSize)
+        {
+            return mip;
+        }
+    }
+
+    return mipLevels > 0 ? mipLevels - 1 : 0;
+}
+
+TextureResidencyManager::Entry& TextureResidencyManager::GetEntry(const TextureId id)
+{
+    if (id >= m_Textures.size() || !m_Textures[id].m_IsRegistered)
+    {
+        throw std::out_of_range("The texture is not registered.");
+    }
+
+    return m_Textures[id];
+}
+
+const TextureResidencyManager::Entry& TextureResidencyManager::GetEntry(const TextureId id) const
+{
+    if (id >= m_Textures.size() || !m_Textures[id].m_IsRegistered)
+    {
+        throw std::out_of_range("The texture is not registered.");
+    }
+
+    return m_Textures[id];
+}
+
+void TextureResidencyManager::SetMip(const TextureId id, const uint16_t mip)
+{
+    Entry& entry = m_Textures[id];
+
+    m_ResidentSizeInBytes -= entry.m_SizesFromMipInBytes[entry.m_Mip];
+    m_ResidentSizeInBytes += entry.m_SizesFromMipInBytes[mip];
+    entry.m_Mip = mip;
+
+    if (!entry.m_IsChanged)
+    {
+        entry.m_IsChanged = true;
+        m_ChangedTextures.push_back(id);
+    }
+}
+
+bool TextureResidencyManager::MakeRoom(const size_t sizeInBytes, const bool keepRequestedMips)
+{
+    while (m_ResidentSizeInBytes + sizeInBytes > m_BudgetInBytes)
+    {
+        if (m_EvictionCursor == INVALID_INDEX)
+        {
+            return false;
+        }
+
+        Entry& entry = m_Textures[m_EvictionCursor];
+
+        // The mips a texture used in this frame needs are kept, only the finer ones are evicted.
+        uint16_t minMip = entry.m_TailMip;
+        if (keepRequestedMips && entry.m_LastUsedFrame == m_Frame && entry.m_RequestedMip != NO_REQUEST)
+        {
+            minMip = std::min(minMip, entry.m_RequestedMip);
+        }
+
+        if (entry.m_Mip < minMip)
+        {
+            SetMip(m_EvictionCursor, entry.m_Mip + 1);
+        }
+        else
+        {
+            m_EvictionCursor = entry.m_Next;
+        }
+    }
+
+    return true;
+}
+
+void TextureResidencyManager::LinkAsMostRecent(const TextureId id)
+{
+    Entry& entry = m_Textures[id];
+    entry.m_Previous = m_MostRecentlyUsed;
+    entry.m_Next = INVALID_INDEX;
+
+    if (m_MostRecentlyUsed != INVALID_INDEX)
+    {
+        m_Textures[m_MostRecentlyUsed].m_Next = id;
+    }
+    else
+    {
+        m_LeastRecentlyUsed = id;
+    }
+
+    m_MostRecentlyUsed = id;
+}
+
+void TextureResidencyManager::Unlink(const TextureId id)
+{
+    Entry& entry = m_Textures[id];
+
+    if (entry.m_Previous != INVALID_INDEX)
+    {
+        m_Textures[entry.m_Previous].m_Next = entry.m_Next;
+    }
+    else
+    {
+        m_LeastRecentlyUsed = entry.m_Next;
+    }
+
+    if (entry.m_Next != INVALID_INDEX)
+    {
+        m_Textures[entry.m_Next].m_Previous = entry.m_Previous;
+    }
+    else
+    {
+        m_MostRecentlyUsed = entry.m_Previous;
+    }
+
+    entry.m_Previous = INVALID_INDEX;
+    entry.m_Next = INVALID_INDEX;
+}
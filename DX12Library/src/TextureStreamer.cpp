@@ -0,0 +1,428 @@
+#include "DX12LibPCH.h"
+
+#include "TextureStreamer.h"
+
+#include "Application.h"
+#include "CommandList.h"
+#include "CommandQueue.h"
+#include "Helpers.h"
+#include "ResourceStateTracker.h"
+#include "Texture.h"
+#include "TextureDecoder.h"
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace Microsoft::WRL;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    TextureStreamer* g_TextureStreamer = nullptr;
+
+    struct PlaceholderDesc
+    {
+        DXGI_FORMAT m_Format;
+        uint8_t m_Color[4];
+    };
+
+    PlaceholderDesc GetPlaceholderDesc(const TextureUsageType usage)
+    {
+        switch (usage)
+        {
+        case TextureUsageType::Albedo:
+            return { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, { 255, 255, 255, 255 } };
+        case TextureUsageType::Normalmap:
+            // A flat normal in tangent space.
+            return { DXGI_FORMAT_R8G8B8A8_UNORM, { 128, 128, 255, 255 } };
+        case TextureUsageType::Heightmap:
+            return { DXGI_FORMAT_R8G8B8A8_UNORM, { 0, 0, 0, 255 } };
+        default:
+            return { DXGI_FORMAT_R8G8B8A8_UNORM, { 255, 255, 255, 255 } };
+        }
+    }
+
+    // Resources with fewer mips are smaller, which only works for textures that are not arrays or volumes.
+    bool IsStreamable(const TextureData& textureData)
+    {
+        return textureData.m_Dimension == TextureData::Dimension::Texture2D && textureData.m_DepthOrArraySize == 1 && textureData.m_MipLevels > 1;
+    }
+}
+
+void TextureStreamer::Create(const uint32_t numThreads, const size_t stagingBudgetInBytes, const size_t residencyBudgetInBytes)
+{
+    Assert(g_TextureStreamer == nullptr, "Texture streamer is already created.");
+    g_TextureStreamer = new TextureStreamer(numThreads, stagingBudgetInBytes, residencyBudgetInBytes);
+}
+
+void TextureStreamer::Destroy()
+{
+    delete g_TextureStreamer;
+    g_TextureStreamer = nullptr;
+}
+
+bool TextureStreamer::IsCreated()
+{
+    return g_TextureStreamer != nullptr;
+}
+
+TextureStreamer& TextureStreamer::Get()
+{
+    Assert(g_TextureStreamer != nullptr, "Texture streamer is not created.");
+    return *g_TextureStreamer;
+}
+
+TextureStreamer::TextureStreamer(const uint32_t numThreads, const size_t stagingBudgetInBytes, const size_t residencyBudgetInBytes)
+    : m_ThreadPool(numThreads)
+    , m_Scheduler(m_ThreadPool, stagingBudgetInBytes)
+    , m_ResidencyManager(residencyBudgetInBytes)
+{}
+
+TextureStreamer::~TextureStreamer()
+{
+    m_Scheduler.WaitForDecodes();
+    // The uploads in flight reference the staging memory owned by the requests.
+    Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY)->Flush();
+}
+
+std::shared_ptr<Texture> TextureStreamer::LoadTexture(const std::wstring& fileName, const TextureUsageType usage, const bool streamMips)
+{
+    const fs::path filePath = TextureDecoder::ResolvePath(fileName);
+    const std::wstring effectiveFileName = filePath.wstring();
+
+    if (!exists(filePath))
+    {
+        throw std::exception("File not found.");
+    }
+
+    auto [iter, isNew] = m_StreamedTextures.try_emplace(effectiveFileName);
+    StreamedTexture& streamedTexture = iter->second;
+    if (isNew)
+    {
+        streamedTexture.m_FileName = effectiveFileName;
+        streamedTexture.m_Usage = usage;
+        streamedTexture.m_StreamMips = streamMips;
+        ++m_NumPendingTextures;
+        ScheduleLoad(streamedTexture, 0);
+    }
+
+    std::shared_ptr<Texture> texture;
+    if (streamedTexture.m_Resource != nullptr)
+    {
+        texture = std::make_shared<Texture>(streamedTexture.m_Resource, usage, effectiveFileName);
+    }
+    else
+    {
+        // Left unnamed: the name would be applied to the shared placeholder resource.
+        texture = std::make_shared<Texture>(GetPlaceholder(usage), usage);
+    }
+
+    streamedTexture.m_Textures.emplace_back(texture.get(), texture);
+    m_StreamedTexturesByResource[texture.get()] = &streamedTexture;
+    return texture;
+}
+
+void TextureStreamer::RequestScreenSize(const Resource& texture, const float screenSizeInPixels)
+{
+    const auto findResult = m_StreamedTexturesByResource.find(&texture);
+    if (findResult == m_StreamedTexturesByResource.end())
+    {
+        return;
+    }
+
+    const StreamedTexture& streamedTexture = *findResult->second;
+    if (streamedTexture.m_StreamMips && streamedTexture.m_ResidencyId.has_value())
+    {
+        m_ResidencyManager.RequestScreenSize(*streamedTexture.m_ResidencyId, screenSizeInPixels);
+    }
+}
+
+void TextureStreamer::Update()
+{
+    ReleaseUnusedTextures();
+    SubmitUploads();
+
+    std::shared_ptr<CommandList> commandList;
+    std::vector<StreamedTexture*> changedTextures;
+    FinishUploads(commandList, changedTextures);
+    ApplyResidencyChanges(commandList, changedTextures);
+
+    if (commandList != nullptr)
+    {
+        Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->ExecuteCommandList(commandList);
+    }
+}
+
+const ComPtr<ID3D12Resource>& TextureStreamer::GetPlaceholder(const TextureUsageType usage)
+{
+    auto& placeholder = m_Placeholders[usage];
+    if (placeholder != nullptr)
+    {
+        return placeholder;
+    }
+
+    const auto [format, color] = GetPlaceholderDesc(usage);
+
+    TextureData textureData;
+    textureData.m_Dimension = TextureData::Dimension::Texture2D;
+    textureData.m_Format = format;
+    textureData.m_Width = 1;
+    textureData.m_Subresources.push_back({ color, sizeof color, sizeof color });
+    textureData.m_SizeInBytes = sizeof color;
+    placeholder = CommandList::CreateTextureResource(textureData, 1);
+
+    const auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+    const auto commandList = commandQueue->GetCommandList();
+    commandList->CopyTextureData(Texture(placeholder, usage), textureData);
+    // Only done once per usage type, the color is on the stack.
+    commandQueue->WaitForFenceValue(commandQueue->ExecuteCommandList(commandList));
+    ResourceStateTracker::AddGlobalResourceState(placeholder.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+    return placeholder;
+}
+
+void TextureStreamer::ScheduleLoad(StreamedTexture& streamedTexture, const uint16_t firstMip)
+{
+    const bool isFirstLoad = streamedTexture.m_MipLevels == 0;
+    const uint16_t endMip = streamedTexture.m_FirstMip;
+    const bool streamMips = streamedTexture.m_StreamMips;
+    const uint32_t maxTailSize = m_ResidencyManager.GetMaxTailSize();
+
+    streamedTexture.m_PendingFirstMip = firstMip;
+    streamedTexture.m_Request = m_Scheduler.Schedule(streamedTexture.m_FileName,
+        [filePath = fs::path(streamedTexture.m_FileName), usage = streamedTexture.m_Usage, isFirstLoad, firstMip, endMip, streamMips, maxTailSize]()
+        {
+            TextureData textureData = TextureDecoder::Decode(filePath, usage);
+
+            uint16_t uploadFirstMip = firstMip;
+            uint16_t uploadEndMip = endMip;
+            if (isFirstLoad)
+            {
+                uploadFirstMip = streamMips && IsStreamable(textureData)
+                    ? TextureResidencyManager::ComputeTailMip(static_cast<uint32_t>(textureData.m_Width), textureData.m_Height, textureData.m_MipLevels, maxTailSize)
+                    : 0;
+                uploadEndMip = textureData.m_MipLevels;
+            }
+
+            // Reserve the size of the upload heap, which is larger than the pixels because of the row alignment.
+            const auto uploadData = textureData.SelectMips(uploadFirstMip, uploadEndMip - uploadFirstMip);
+            const auto resourceDesc = CommandList::GetTextureResourceDesc(uploadData, uploadData.m_MipLevels);
+            UINT64 stagingSizeInBytes = 0;
+            Application::Get().GetDevice()->GetCopyableFootprints(&resourceDesc, 0,
+                static_cast<UINT>(uploadData.m_Subresources.size()), 0,
+                nullptr, nullptr, nullptr, &stagingSizeInBytes);
+            textureData.m_StagingSizeInBytes = static_cast<size_t>(stagingSizeInBytes);
+
+            return textureData;
+        });
+}
+
+void TextureStreamer::SubmitUploads()
+{
+    const auto requests = m_Scheduler.AcquireUploads();
+    if (requests.empty())
+    {
+        return;
+    }
+
+    const auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+    const auto commandList = commandQueue->GetCommandList();
+
+    for (const auto& request : requests)
+    {
+        StreamedTexture& streamedTexture = m_StreamedTextures.at(request->GetKey());
+        const TextureData& textureData = request->GetData();
+
+        uint16_t endMip = streamedTexture.m_FirstMip;
+        if (streamedTexture.m_MipLevels == 0)
+        {
+            const bool isStreamed = streamedTexture.m_StreamMips && IsStreamable(textureData);
+
+            TextureResidencyManager::TextureDesc residencyDesc;
+            residencyDesc.m_Width = static_cast<uint32_t>(textureData.m_Width);
+            residencyDesc.m_Height = textureData.m_Height;
+            residencyDesc.m_IsStreamed = isStreamed;
+            // Approximated by the size of the pixels, the same for the mips of all the array slices.
+            residencyDesc.m_MipSizesInBytes.resize(textureData.m_MipLevels);
+            for (size_t i = 0; i < textureData.m_Subresources.size(); ++i)
+            {
+                residencyDesc.m_MipSizesInBytes[i % textureData.m_MipLevels] += textureData.m_Subresources[i].m_SlicePitch;
+            }
+
+            const auto residencyId = m_ResidencyManager.Register(residencyDesc);
+            if (residencyId >= m_StreamedTexturesByResidencyId.size())
+            {
+                m_StreamedTexturesByResidencyId.resize(residencyId + 1);
+            }
+            m_StreamedTexturesByResidencyId[residencyId] = &streamedTexture;
+
+            streamedTexture.m_ResidencyId = residencyId;
+            streamedTexture.m_MipLevels = textureData.m_MipLevels;
+            streamedTexture.m_PendingFirstMip = m_ResidencyManager.GetMip(residencyId);
+            streamedTexture.m_TargetMip = streamedTexture.m_PendingFirstMip;
+            endMip = streamedTexture.m_MipLevels;
+        }
+
+        // The new resource has all the mips from the first one, the resident ones are copied after the upload.
+        const uint16_t firstMip = streamedTexture.m_PendingFirstMip;
+        const auto uploadData = textureData.SelectMips(firstMip, endMip - firstMip);
+        streamedTexture.m_PendingResource = CommandList::CreateTextureResource(uploadData, streamedTexture.m_MipLevels - firstMip);
+        commandList->CopyTextureData(Texture(streamedTexture.m_PendingResource, streamedTexture.m_Usage), uploadData);
+    }
+
+    m_Scheduler.SubmitUploads(requests, commandQueue->ExecuteCommandList(commandList));
+}
+
+void TextureStreamer::FinishUploads(std::shared_ptr<CommandList>& commandList, std::vector<StreamedTexture*>& changedTextures)
+{
+    const auto commandQueue = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+    const auto requests = m_Scheduler.Retire(commandQueue->GetCompletedFenceValue());
+
+    for (const auto& request : requests)
+    {
+        StreamedTexture& streamedTexture = m_StreamedTextures.at(request->GetKey());
+        streamedTexture.m_Request = nullptr;
+
+        const bool isFirstLoad = streamedTexture.m_Resource == nullptr;
+        if (isFirstLoad)
+        {
+            --m_NumPendingTextures;
+        }
+
+        if (request->GetStatus() == TextureStreamingScheduler::RequestStatus::Completed)
+        {
+            // Resources used on a copy queue decay to the common state.
+            ResourceStateTracker::AddGlobalResourceState(streamedTexture.m_PendingResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+            if (!isFirstLoad)
+            {
+                const Texture pendingTexture(streamedTexture.m_PendingResource, streamedTexture.m_Usage);
+                const Texture residentTexture(streamedTexture.m_Resource, streamedTexture.m_Usage);
+                GetDirectCommandList(commandList).CopyTextureMips(pendingTexture, streamedTexture.m_FirstMip - streamedTexture.m_PendingFirstMip,
+                    residentTexture, 0, streamedTexture.m_MipLevels - streamedTexture.m_FirstMip);
+            }
+
+            SwapResource(streamedTexture, streamedTexture.m_PendingResource, streamedTexture.m_PendingFirstMip);
+            changedTextures.push_back(&streamedTexture);
+        }
+        else
+        {
+            // Not retried: the texture keeps the mips it has.
+            streamedTexture.m_IsFailed = true;
+
+            const std::string message = "Failed to load a texture: " + request->GetErrorMessage() + "\n";
+            OutputDebugStringA(message.c_str());
+        }
+
+        streamedTexture.m_PendingResource = nullptr;
+    }
+}
+
+void TextureStreamer::ApplyResidencyChanges(std::shared_ptr<CommandList>& commandList, std::vector<StreamedTexture*>& changedTextures)
+{
+    for (const auto& change : m_ResidencyManager.Update())
+    {
+        StreamedTexture* streamedTexture = m_StreamedTexturesByResidencyId[change.m_Id];
+        streamedTexture->m_TargetMip = change.m_Mip;
+        changedTextures.push_back(streamedTexture);
+    }
+
+    for (StreamedTexture* streamedTexture : changedTextures)
+    {
+        // A texture with a load in flight is revisited when the load finishes.
+        if (streamedTexture->m_Request != nullptr || streamedTexture->m_IsFailed || streamedTexture->m_Resource == nullptr)
+        {
+            continue;
+        }
+
+        if (streamedTexture->m_TargetMip > streamedTexture->m_FirstMip)
+        {
+            DropMips(GetDirectCommandList(commandList), *streamedTexture, streamedTexture->m_TargetMip);
+        }
+        else if (streamedTexture->m_TargetMip < streamedTexture->m_FirstMip)
+        {
+            ScheduleLoad(*streamedTexture, streamedTexture->m_TargetMip);
+        }
+    }
+}
+
+void TextureStreamer::DropMips(CommandList& commandList, StreamedTexture& streamedTexture, const uint16_t firstMip)
+{
+    const uint16_t numDroppedMips = firstMip - streamedTexture.m_FirstMip;
+
+    auto textureDesc = streamedTexture.m_Resource->GetDesc();
+    textureDesc.Width = std::max<UINT64>(textureDesc.Width >> numDroppedMips, 1);
+    textureDesc.Height = std::max<UINT>(textureDesc.Height >> numDroppedMips, 1);
+    textureDesc.MipLevels = streamedTexture.m_MipLevels - firstMip;
+
+    const auto resource = CommandList::CreateTextureResource(textureDesc);
+    commandList.CopyTextureMips(Texture(resource, streamedTexture.m_Usage), 0,
+        Texture(streamedTexture.m_Resource, streamedTexture.m_Usage), numDroppedMips, textureDesc.MipLevels);
+
+    SwapResource(streamedTexture, resource, firstMip);
+}
+
+void TextureStreamer::SwapResource(StreamedTexture& streamedTexture, const ComPtr<ID3D12Resource>& resource, const uint16_t firstMip)
+{
+    // The previous resource stays alive until the command lists using it have finished.
+    streamedTexture.m_Resource = resource;
+    streamedTexture.m_FirstMip = firstMip;
+
+    for (const auto& [pResource, weakTexture] : streamedTexture.m_Textures)
+    {
+        if (const auto texture = weakTexture.lock())
+        {
+            texture->SetD3D12Resource(resource);
+            texture->CreateViews();
+            texture->SetName(streamedTexture.m_FileName);
+        }
+    }
+}
+
+void TextureStreamer::ReleaseUnusedTextures()
+{
+    for (auto iter = m_StreamedTextures.begin(); iter != m_StreamedTextures.end();)
+    {
+        StreamedTexture& streamedTexture = iter->second;
+
+        auto& textures = streamedTexture.m_Textures;
+        for (auto textureIter = textures.begin(); textureIter != textures.end();)
+        {
+            if (textureIter->second.expired())
+            {
+                m_StreamedTexturesByResource.erase(textureIter->first);
+                textureIter = textures.erase(textureIter);
+            }
+            else
+            {
+                ++textureIter;
+            }
+        }
+
+        // The staging memory of a load in flight is owned by its request.
+        if (!textures.empty() || streamedTexture.m_Request != nullptr)
+        {
+            ++iter;
+            continue;
+        }
+
+        if (streamedTexture.m_ResidencyId.has_value())
+        {
+            m_ResidencyManager.Unregister(*streamedTexture.m_ResidencyId);
+            m_StreamedTexturesByResidencyId[*streamedTexture.m_ResidencyId] = nullptr;
+        }
+
+        iter = m_StreamedTextures.erase(iter);
+    }
+}
+
+CommandList& TextureStreamer::GetDirectCommandList(std::shared_ptr<CommandList>& commandList)
+{
+    if (commandList == nullptr)
+    {
+        commandList = Application::Get().GetCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)->GetCommandList();
+    }
+
+    return *commandList;
+}
@@ -0,0 +1,178 @@
+#include "TextureStreamingScheduler.h"
+
+#include "ThreadPool.h"
+
+#include <exception>
+#include <stdexcept>
+
+TextureStreamingScheduler::Request::Request(std::wstring key)
+    : m_Key(std::move(key))
+    , m_Status(RequestStatus::Decoding)
+{}
+
+TextureStreamingScheduler::TextureStreamingScheduler(ThreadPool& threadPool, const size_t stagingBudgetInBytes)
+    : m_ThreadPool(threadPool)
+    , m_StagingBudgetInBytes(stagingBudgetInBytes)
+{}
+
+TextureStreamingScheduler::~TextureStreamingScheduler()
+{
+    WaitForDecodes();
+}
+
+std::shared_ptr<TextureStreamingScheduler::Request> TextureStreamingScheduler::Schedule(const std::wstring& key, DecodeFunction decodeFunction)
+{
+    std::shared_ptr<Request> request;
+
+    {
+        std::lock_guard lock(m_Mutex);
+
+        auto& inFlightRequest = m_InFlightRequests[key];
+        request = inFlightRequest.lock();
+        if (request != nullptr)
+        {
+            return request;
+        }
+
+        request = std::make_shared<Request>(key);
+        inFlightRequest = request;
+        ++m_NumDecodingRequests;
+    }
+
+    m_ThreadPool.Schedule([this, request, decodeFunction = std::move(decodeFunction)]()
+        {
+            Decode(request, decodeFunction);
+        });
+
+    return request;
+}
+
+void TextureStreamingScheduler::Decode(const std::shared_ptr<Request>& request, const DecodeFunction& decodeFunction)
+{
+    RequestStatus status;
+    try
+    {
+        request->m_Data = decodeFunction();
+        request->m_StagingSizeInBytes = request->m_Data.GetStagingSizeInBytes();
+        status = RequestStatus::Decoded;
+    }
+    catch (const std::exception& exception)
+    {
+        request->m_Data = {};
+        request->m_ErrorMessage = exception.what();
+        status = RequestStatus::Failed;
+    }
+
+    // Publish the results only after they have been written.
+    request->m_Status.store(status, std::memory_order_release);
+
+    std::lock_guard lock(m_Mutex);
+
+    if (status == RequestStatus::Decoded)
+    {
+        m_DecodedRequests.push_back(request);
+    }
+    else
+    {
+        Finish(request);
+    }
+
+    --m_NumDecodingRequests;
+    m_AllDecodesComplete.notify_all();
+}
+
+void TextureStreamingScheduler::Finish(const std::shared_ptr<Request>& request)
+{
+    const auto findResult = m_InFlightRequests.find(request->GetKey());
+    if (findResult != m_InFlightRequests.end() && findResult->second.lock() == request)
+    {
+        m_InFlightRequests.erase(findResult);
+    }
+
+    m_FinishedRequests.push_back(request);
+}
+
+std::vector<std::shared_ptr<TextureStreamingScheduler::Request>> TextureStreamingScheduler::AcquireUploads()
+{
+    std::lock_guard lock(m_Mutex);
+
+    std::vector<std::shared_ptr<Request>> requests;
+
+    while (!m_DecodedRequests.empty())
+    {
+        const auto& request = m_DecodedRequests.front();
+
+        // Let a texture larger than the budget through when nothing else is in flight, otherwise it would wait forever.
+        if (m_StagingSizeInFlight != 0 && m_StagingSizeInFlight + request->m_StagingSizeInBytes > m_StagingBudgetInBytes)
+        {
+            break;
+        }
+
+        m_StagingSizeInFlight += request->m_StagingSizeInBytes;
+        request->m_Status.store(RequestStatus::Uploading, std::memory_order_release);
+
+        requests.push_back(request);
+        m_DecodedRequests.pop_front();
+    }
+
+    m_NumAcquiredRequests += requests.size();
+    return requests;
+}
+
+void TextureStreamingScheduler::SubmitUploads(const std::vector<std::shared_ptr<Request>>& requests, const uint64_t fenceValue)
+{
+    std::lock_guard lock(m_Mutex);
+
+    if (!m_UploadingRequests.empty() && m_UploadingRequests.back()->m_FenceValue > fenceValue)
+    {
+        throw std::runtime_error("Uploads must be submitted in the order of their fence values.");
+    }
+
+    for (const auto& request : requests)
+    {
+        request->m_FenceValue = fenceValue;
+        m_UploadingRequests.push_back(request);
+    }
+
+    m_NumAcquiredRequests -= requests.size();
+}
+
+std::vector<std::shared_ptr<TextureStreamingScheduler::Request>> TextureStreamingScheduler::Retire(const uint64_t completedFenceValue)
+{
+    std::lock_guard lock(m_Mutex);
+
+    while (!m_UploadingRequests.empty() && m_UploadingRequests.front()->m_FenceValue <= completedFenceValue)
+    {
+        const auto request = m_UploadingRequests.front();
+        m_UploadingRequests.pop_front();
+
+        m_StagingSizeInFlight -= request->m_StagingSizeInBytes;
+        // The pixels are in GPU memory now.
+        request->m_Data = {};
+        request->m_Status.store(RequestStatus::Completed, std::memory_order_release);
+
+        Finish(request);
+    }
+
+    std::vector<std::shared_ptr<Request>> finishedRequests;
+    finishedRequests.swap(m_FinishedRequests);
+    return finishedRequests;
+}
+
+size_t TextureStreamingScheduler::GetStagingSizeInFlight() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_StagingSizeInFlight;
+}
+
+size_t TextureStreamingScheduler::GetNumPendingRequests() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_NumDecodingRequests + m_DecodedRequests.size() + m_NumAcquiredRequests + m_UploadingRequests.size() + m_FinishedRequests.size();
+}
+
+void TextureStreamingScheduler::WaitForDecodes()
+{
+    std::unique_lock lock(m_Mutex);
+    m_AllDecodesComplete.wait(lock, [this]() { return m_NumDecodingRequests == 0; });
+}
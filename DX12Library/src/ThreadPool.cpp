@@ -0,0 +1,155 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+	if (numThreads == 0)
+	{
+		const uint32_t hardwareConcurrency = std::thread::hardware_concurrency();
+		numThreads = std::max(hardwareConcurrency, 2u) - 1;
+	}
+
+	m_Threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(m_Mutex);
+		m_IsStopping = true;
+	}
+
+	m_JobAvailable.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Schedule(std::function<void()> job)
+{
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Jobs.push(std::move(job));
+	}
+
+	m_JobAvailable.notify_one();
+}
+
+void ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	struct SharedState
+	{
+		std::atomic<size_t> NextIndex = 0;
+		std::atomic<size_t> NumCompleted = 0;
+		std::mutex Mutex;
+		std::condition_variable Completed;
+		std::exception_ptr Exception;
+	};
+
+	const auto state = std::make_shared<SharedState>();
+
+	// Each participant grabs the next index until there are none left.
+	const auto work = [state, count, &function]()
+	{
+		size_t index;
+		while ((index = state->NextIndex++) < count)
+		{
+			try
+			{
+				function(index);
+			}
+			catch (...)
+			{
+				std::lock_guard lock(state->Mutex);
+				if (!state->Exception)
+				{
+					state->Exception = std::current_exception();
+				}
+			}
+
+			if (++state->NumCompleted == count)
+			{
+				std::lock_guard lock(state->Mutex);
+				state->Completed.notify_all();
+			}
+		}
+	};
+
+	const size_t numHelpers = std::min(count - 1, m_Threads.size());
+	for (size_t i = 0; i < numHelpers; ++i)
+	{
+		Schedule(work);
+	}
+
+	work();
+
+	{
+		std::unique_lock lock(state->Mutex);
+		state->Completed.wait(lock, [&state, count]() { return state->NumCompleted == count; });
+	}
+
+	if (state->Exception)
+	{
+		std::rethrow_exception(state->Exception);
+	}
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock lock(m_Mutex);
+	m_AllJobsComplete.wait(lock, [this]() { return m_Jobs.empty() && m_NumActiveJobs == 0; });
+}
+
+size_t ThreadPool::GetNumPendingJobs() const
+{
+	std::lock_guard lock(m_Mutex);
+	return m_Jobs.size() + m_NumActiveJobs;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock lock(m_Mutex);
+			m_JobAvailable.wait(lock, [this]() { return m_IsStopping || !m_Jobs.empty(); });
+
+			// Remaining jobs are still executed when stopping.
+			if (m_Jobs.empty())
+			{
+				return;
+			}
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop();
+			++m_NumActiveJobs;
+		}
+
+		job();
+
+		{
+			std::lock_guard lock(m_Mutex);
+			--m_NumActiveJobs;
+
+			if (m_Jobs.empty() && m_NumActiveJobs == 0)
+			{
+				m_AllJobsComplete.notify_all();
+			}
+		}
+	}
+}
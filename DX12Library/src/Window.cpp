@@ -9,6 +9,7 @@
 #include "RenderTarget.h"
 #include "ResourceStateTracker.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
 #include "Helpers.h"
 
 Window::Window(HWND hWnd, const std::wstring& windowName, int clientWidth, int clientHeight, bool vSync)
@@ -184,6 +185,11 @@ void Window::OnUpdate(UpdateEventArgs& e)
 {
 	UpdateClock.Tick();
 
+	if (TextureStreamer::IsCreated())
+	{
+		TextureStreamer::Get().Update();
+	}
+
 	if (auto pGame = PGame.lock())
 	{
 		UpdateEventArgs updateEventArgs(UpdateClock.GetDeltaSeconds(), UpdateClock.GetTotalSeconds(),
@@ -9,7 +9,18 @@
 #include <DX12Library/Texture.h>
 #include <DX12Library/VertexBuffer.h>
 #include <DX12Library/StructuredBuffer.h>
-
+#include <DX12Library/ThreadPool.h>
+
+#include <deque>
+#include <functional>
+
+#include <Framework/Animation.h>
+#include <Framework/AnimationBlendTree.h>
+#include <Framework/CrowdAnimator.h>
+#include <Framework/AnimationLibrary.h>
+#include <Framework/Armature.h>
+#include <Framework/BonePalette.h>
+#include <Framework/InstanceBatcher.h>
 #include <Framework/Light.h>
 #include <Framework/GameObject.h>
 #include <Framework/GraphicsSettings.h>
@@ -17,8 +28,6 @@
 #include <Framework/Material.h>
 #include <Framework/CommonRootSignature.h>
 
-class Animation;
-
 class AnimationsDemo final : public Game
 {
 public:
@@ -46,15 +55,66 @@ private:
 
 	Camera m_Camera;
 	std::vector<GameObject> m_GameObjects;
+	AnimationLibrary m_AnimationLibrary;
 	std::shared_ptr<Animation> m_RunAnimation;
 	std::shared_ptr<Animation> m_IdleAnimation;
 	std::shared_ptr<Animation> m_TopAnimation;
 
+	// The characters are animated on the worker threads.
+	ThreadPool m_AnimationThreadPool;
+	CrowdAnimator m_CrowdAnimator;
+
+	struct AnimatedMesh
+	{
+		std::shared_ptr<Mesh> m_Mesh;
+		std::shared_ptr<Material> m_Material;
+		size_t m_GameObjectIndex;
+		// Every character has its own copy of the mesh's armature.
+		Armature m_Armature;
+		CrowdAnimator::CharacterId m_CharacterId;
+		// The run/idle blend, the upper body is taken from the reaction clip.
+		AnimationBlendTree::NodeId m_LocomotionNode;
+	};
+
+	// A deque, because the crowd animator keeps pointers to the armatures.
+	std::deque<AnimatedMesh> m_AnimatedMeshes;
+
 	std::shared_ptr<CommonRootSignature> m_RootSignature;
 	std::shared_ptr<Mesh> m_BoneMesh;
 	std::shared_ptr<Material> m_BoneMaterial;
 
-	std::shared_ptr<StructuredBuffer> m_BonesStructuredBuffer;
+	// Matches SkinnedInstance in AnimationsDemo_VS.hlsl.
+	struct SkinnedInstance
+	{
+		DirectX::XMMATRIX m_Model;
+		DirectX::XMMATRIX m_InverseTransposeModel;
+		uint32_t m_PaletteOffset;
+		uint32_t m_Padding[3];
+	};
+
+	struct DrawKey
+	{
+		const Mesh* m_Mesh;
+		Material* m_Material;
+	};
+
+	struct DrawKeyCompare
+	{
+		bool operator()(const DrawKey& key1, const DrawKey& key2) const
+		{
+			if (key1.m_Mesh != key2.m_Mesh)
+			{
+				return std::less<const Mesh*>()(key1.m_Mesh, key2.m_Mesh);
+			}
+			return std::less<Material*>()(key1.m_Material, key2.m_Material);
+		}
+	};
+
+	// The bone matrices of all the characters are uploaded once per frame, the characters sharing a mesh and a material are drawn with one instanced draw.
+	BonePalette m_BonePalette;
+	InstanceBatcher<DrawKey, SkinnedInstance, DrawKeyCompare> m_InstanceBatcher;
+	std::shared_ptr<StructuredBuffer> m_BonePaletteStructuredBuffer;
+	std::shared_ptr<StructuredBuffer> m_InstancesStructuredBuffer;
 
 	D3D12_VIEWPORT m_Viewport;
 	D3D12_RECT m_ScissorRect;
@@ -1,4 +1,5 @@
 #include "ShaderLibrary/Model.hlsli"
+#include "ShaderLibrary/Instancing.hlsli"
 
 struct VertexAttributes
 {
@@ -10,11 +11,13 @@ struct VertexShaderOutput
     float4 PositionCs : SV_POSITION;
 };
 
-VertexShaderOutput main(VertexAttributes IN)
+VertexShaderOutput main(VertexAttributes IN, uint instanceId : SV_InstanceID)
 {
     VertexShaderOutput OUT;
     
-    OUT.PositionCs = mul(g_Model_ModelViewProjection, float4(IN.PositionOs, 1.0));
+    // An instance per bone: the palette holds the world matrices of the bones, the model constant buffer holds the view-projection.
+    const matrix boneModel = g_BonePalette[GetInstanceIndex(instanceId)];
+    OUT.PositionCs = mul(g_Model_ModelViewProjection, mul(boneModel, float4(IN.PositionOs, 1.0)));
 
     return OUT;
 }
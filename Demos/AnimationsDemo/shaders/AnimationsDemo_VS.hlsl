@@ -1,11 +1,16 @@
 #include "ShaderLibrary/Model.hlsli"
+#include "ShaderLibrary/Instancing.hlsli"
 
-struct Bone
+struct SkinnedInstance
 {
-    matrix Transform;
+    matrix Model;
+    matrix InverseTransposeModel;
+    // The index of the first skinning matrix of the character in the palette.
+    uint PaletteOffset;
+    uint3 _Padding;
 };
 
-StructuredBuffer<Bone> bonesSb : register(t0);
+StructuredBuffer<SkinnedInstance> instancesSb : register(t1, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 
 struct VertexAttributes
 {
@@ -23,25 +28,28 @@ struct VertexShaderOutput
     float4 PositionCs : SV_POSITION;
 };
 
-VertexShaderOutput main(VertexAttributes IN)
+VertexShaderOutput main(VertexAttributes IN, uint instanceId : SV_InstanceID)
 {
     VertexShaderOutput OUT;
     
+    const SkinnedInstance instance = instancesSb[GetInstanceIndex(instanceId)];
     float4 positionOs = float4(IN.PositionOs, 1.0f);
     
     // skinning
     {
-        matrix boneTransform = bonesSb[IN.BoneIds[0]].Transform * IN.BoneWeights[0];
-        boneTransform += bonesSb[IN.BoneIds[1]].Transform * IN.BoneWeights[1];
-        boneTransform += bonesSb[IN.BoneIds[2]].Transform * IN.BoneWeights[2];
-        boneTransform += bonesSb[IN.BoneIds[3]].Transform * IN.BoneWeights[3];
+        const uint4 boneIds = instance.PaletteOffset + IN.BoneIds;
+        matrix boneTransform = g_BonePalette[boneIds[0]] * IN.BoneWeights[0];
+        boneTransform += g_BonePalette[boneIds[1]] * IN.BoneWeights[1];
+        boneTransform += g_BonePalette[boneIds[2]] * IN.BoneWeights[2];
+        boneTransform += g_BonePalette[boneIds[3]] * IN.BoneWeights[3];
         
         positionOs = mul(boneTransform, positionOs);
     }
 
-    OUT.NormalWs = mul((float3x3) g_Model_InverseTransposeModel, IN.Normal);
+    // The model constant buffer holds the view-projection, the model matrix is per instance.
+    OUT.NormalWs = mul((float3x3) instance.InverseTransposeModel, IN.Normal);
     OUT.Uv = IN.Uv;
-    OUT.PositionCs = mul(g_Model_ModelViewProjection, positionOs);
+    OUT.PositionCs = mul(g_Model_ModelViewProjection, mul(instance.Model, positionOs));
 
     return OUT;
 }
@@ -0,0 +1,19 @@
+#ifndef INSTANCING_HLSLI
+#define INSTANCING_HLSLI
+
+#include <ShaderLibrary/Common/RootSignature.hlsli>
+
+// The bone matrices of all the characters of the frame (see BonePalette).
+StructuredBuffer<matrix> g_BonePalette : register(t0, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+
+ROOT_CONSTANTS_BEGIN
+    // SV_InstanceID does not include the start instance of the draw.
+    uint g_Instancing_FirstInstance;
+ROOT_CONSTANTS_END
+
+uint GetInstanceIndex(uint instanceId)
+{
+    return g_Instancing_FirstInstance + instanceId;
+}
+
+#endif
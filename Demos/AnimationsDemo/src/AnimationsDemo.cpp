@@ -81,10 +81,9 @@ namespace
 		return M;
 	}
 
-	struct BoneSbItem
-	{
-		XMMATRIX Transform;
-	};
+	// The archers are placed on a grid of CROWD_SIZE x CROWD_SIZE.
+	constexpr uint32_t CROWD_SIZE = 5;
+	constexpr float CROWD_SPACING = 5.0f;
 
 	namespace CBuffer
 	{
@@ -105,6 +104,7 @@ namespace
 
 AnimationsDemo::AnimationsDemo(const std::wstring& name, int width, int height, GraphicsSettings graphicsSettings)
 	: Base(name, width, height, graphicsSettings.VSync)
+	, m_CrowdAnimator(&m_AnimationThreadPool)
 	, m_Viewport(CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)))
 	, m_ScissorRect(CD3DX12_RECT(0, 0, LONG_MAX, LONG_MAX))
 	, m_GraphicsSettings(graphicsSettings)
@@ -150,7 +150,8 @@ bool AnimationsDemo::LoadContent()
 
 	m_RootSignature = std::make_shared<CommonRootSignature>(m_WhiteTexture2d);
 
-	m_BonesStructuredBuffer = std::make_shared<StructuredBuffer>(L"Bones Structured Buffer");
+	m_BonePaletteStructuredBuffer = std::make_shared<StructuredBuffer>(L"Bone Palette Structured Buffer");
+	m_InstancesStructuredBuffer = std::make_shared<StructuredBuffer>(L"Skinned Instances Structured Buffer");
 
 	auto modelShader = std::make_shared<Shader>(m_RootSignature,
 		ShaderBlob(L"AnimationsDemo_VS.cso"),
@@ -158,7 +159,7 @@ bool AnimationsDemo::LoadContent()
 		[](PipelineStateBuilder& builder)
 		{
 			std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout;
-			inputLayout.insert(inputLayout.end(), std::begin(VertexAttributes::INPUT_ELEMENTS), std::end(VertexAttributes::INPUT_ELEMENTS));
+			inputLayout.insert(inputLayout.end(), std::begin(VertexAttributes::INPUT_ELEMENTS), std::begin(VertexAttributes::INPUT_ELEMENTS) + VertexAttributes::INPUT_ELEMENT_COUNT);
 			inputLayout.insert(inputLayout.end(), std::begin(SkinningVertexAttributes::INPUT_ELEMENTS), std::end(SkinningVertexAttributes::INPUT_ELEMENTS));
 			builder.WithInputLayout(inputLayout);
 		}
@@ -196,19 +197,57 @@ bool AnimationsDemo::LoadContent()
 			auto material = Material::Create(modelShader);
 			MaterialSetTexture(*material, "diffuseMap", L"Assets/Models/archer/textures/akai_diffuse.png");
 
-			XMMATRIX translationMatrix = XMMatrixTranslation(0.0f, 0.0f, 0.0f);
-			XMMATRIX rotationMatrix = XMMatrixIdentity();
-			XMMATRIX scaleMatrix = XMMatrixScaling(0.05f, 0.05f, 0.05f);
-			XMMATRIX worldMatrix = scaleMatrix * rotationMatrix * translationMatrix;
-			m_GameObjects.push_back(GameObject(worldMatrix, model, material));
+			for (uint32_t row = 0; row < CROWD_SIZE; ++row)
+			{
+				for (uint32_t column = 0; column < CROWD_SIZE; ++column)
+				{
+					const float offset = (CROWD_SIZE - 1) * 0.5f;
+					XMMATRIX translationMatrix = XMMatrixTranslation((column - offset) * CROWD_SPACING, 0.0f, row * CROWD_SPACING);
+					XMMATRIX rotationMatrix = XMMatrixIdentity();
+					XMMATRIX scaleMatrix = XMMatrixScaling(0.05f, 0.05f, 0.05f);
+					XMMATRIX worldMatrix = scaleMatrix * rotationMatrix * translationMatrix;
+					m_GameObjects.push_back(GameObject(worldMatrix, model, material));
+				}
+			}
 		}
 
 		m_BoneMesh = Mesh::CreateCube(*commandList);
 
 		{
-			m_RunAnimation = modelLoader.LoadAnimation("Assets/Models/archer/fast_run.fbx", "mixamo.com");
-			m_IdleAnimation = modelLoader.LoadAnimation("Assets/Models/archer/idle.fbx", "mixamo.com");
-			m_TopAnimation = modelLoader.LoadAnimation("Assets/Models/archer/reaction.fbx", "mixamo.com");
+			// Mixamo names every clip "mixamo.com", hence the prefixes.
+			m_AnimationLibrary.AddFile("Assets/Models/archer/fast_run.fbx", "run");
+			m_AnimationLibrary.AddFile("Assets/Models/archer/idle.fbx", "idle");
+			m_AnimationLibrary.AddFile("Assets/Models/archer/reaction.fbx", "reaction");
+
+			m_RunAnimation = m_AnimationLibrary.Get("run/mixamo.com");
+			m_IdleAnimation = m_AnimationLibrary.Get("idle/mixamo.com");
+			m_TopAnimation = m_AnimationLibrary.Get("reaction/mixamo.com");
+		}
+
+		// The channels are bound to the bones once, each character keeps its own playback state.
+		for (size_t gameObjectIndex = 0; gameObjectIndex < m_GameObjects.size(); ++gameObjectIndex)
+		{
+			const auto& go = m_GameObjects[gameObjectIndex];
+
+			for (const auto& mesh : go.GetModel()->GetMeshes())
+			{
+				auto& animatedMesh = m_AnimatedMeshes.emplace_back();
+				animatedMesh.m_Mesh = mesh;
+				animatedMesh.m_Material = go.GetMaterial();
+				animatedMesh.m_GameObjectIndex = gameObjectIndex;
+				animatedMesh.m_Armature = mesh->GetArmature();
+
+				// Offset in time, so that the crowd does not move in sync.
+				auto& armature = animatedMesh.m_Armature;
+				animatedMesh.m_CharacterId = m_CrowdAnimator.AddCharacter(armature, gameObjectIndex * 0.37);
+				auto& blendTree = m_CrowdAnimator.GetBlendTree(animatedMesh.m_CharacterId);
+
+				const auto run = blendTree.AddClip(m_RunAnimation);
+				const auto idle = blendTree.AddClip(m_IdleAnimation);
+				animatedMesh.m_LocomotionNode = blendTree.AddBlend({ run, idle }, { 1.0f, 0.0f });
+				const auto top = blendTree.AddClip(m_TopAnimation);
+				blendTree.AddMask(top, animatedMesh.m_LocomotionNode, Animation::BuildMask(armature, "mixamorig:Spine"));
+			}
 		}
 	}
 
@@ -312,22 +351,15 @@ void AnimationsDemo::OnUpdate(UpdateEventArgs& e)
 	// oscillate between 0 and 1 while spending some time on exact values of 0 and 1
 	auto weight = static_cast<float>(Smoothstep(0.25, 0.75, (sin(m_Time * 2) + 1) * 0.5));
 
-	for (const auto& go : m_GameObjects)
+	for (const auto& animatedMesh : m_AnimatedMeshes)
 	{
-		for (auto& mesh : go.GetModel()->GetMeshes())
-		{
-			const auto runTransforms = m_RunAnimation->GetBonesTransforms(*mesh, m_Time);
-			const auto idleTransforms = m_IdleAnimation->GetBonesTransforms(*mesh, m_Time);
-			const auto topTransforms = m_TopAnimation->GetBonesTransforms(*mesh, m_Time);
-			const auto topBodyMask = Animation::BuildMask(*mesh, "mixamorig:Spine");
-
-			auto transforms = Animation::Blend(runTransforms, idleTransforms, weight);
-			transforms = Animation::ApplyMask(topTransforms, transforms, topBodyMask);
-
-			Animation::Apply(*mesh, transforms);
-			mesh->GetArmature().UpdateBoneGlobalTransforms();
-		}
+		auto& blendTree = m_CrowdAnimator.GetBlendTree(animatedMesh.m_CharacterId);
+		blendTree.SetWeight(animatedMesh.m_LocomotionNode, 0, 1.0f - weight);
+		blendTree.SetWeight(animatedMesh.m_LocomotionNode, 1, weight);
 	}
+
+	// The pose buffers are reused every frame, and a clip with a zero weight is not sampled.
+	m_CrowdAnimator.Update(m_Time);
 }
 
 void AnimationsDemo::OnRender(RenderEventArgs& e)
@@ -353,66 +385,88 @@ void AnimationsDemo::OnRender(RenderEventArgs& e)
 
 	m_RootSignature->Bind(*commandList);
 
+	// Pack the bones of all the characters into one palette and group the characters into instanced draws.
+	uint32_t firstBoneInstance = 0;
+	uint32_t numBoneInstances = 0;
 	{
-		PIXScope(*commandList, "Main Pass");
+		PIXScope(*commandList, "Upload Bone Palette");
 
-		for (const auto& go : m_GameObjects)
+		m_BonePalette.Clear();
+		m_InstanceBatcher.Clear();
+
+		for (const auto& animatedMesh : m_AnimatedMeshes)
 		{
-			CBuffer::Model modelCBuffer{};
-			modelCBuffer.Compute(go.GetWorldMatrix(), viewProjection);
-			m_RootSignature->SetModelConstantBuffer(*commandList, modelCBuffer);
+			const XMMATRIX worldMatrix = m_GameObjects[animatedMesh.m_GameObjectIndex].GetWorldMatrix();
 
-			const auto& model = go.GetModel();
-			const auto& material = go.GetMaterial();
-			material->BeginBatch(*commandList);
-			material->UploadUniforms(*commandList);
+			SkinnedInstance instance{};
+			instance.m_Model = worldMatrix;
+			instance.m_InverseTransposeModel = XMMatrixTranspose(XMMatrixInverse(nullptr, worldMatrix));
+			instance.m_PaletteOffset = m_BonePalette.AddSkinningMatrices(animatedMesh.m_Armature);
+			m_InstanceBatcher.Add({ animatedMesh.m_Mesh.get(), animatedMesh.m_Material.get() }, instance);
+		}
 
-			for (const auto& mesh : model->GetMeshes())
-			{
-				auto& bones = mesh->GetArmature().GetBones();
-				std::vector<BoneSbItem> bonesSb;
-				bonesSb.reserve(bones.size());
+		m_InstanceBatcher.Build();
 
-				for (const auto& bone : bones)
+		// The bones are drawn from the same palette, after the skinning matrices.
+		firstBoneInstance = m_BonePalette.GetSize();
+		for (const auto& animatedMesh : m_AnimatedMeshes)
+		{
+			m_BonePalette.AddBoneWorldMatrices(animatedMesh.m_Armature, m_GameObjects[animatedMesh.m_GameObjectIndex].GetWorldMatrix());
+		}
+		numBoneInstances = m_BonePalette.GetSize() - firstBoneInstance;
+
+		commandList->CopyStructuredBuffer(*m_BonePaletteStructuredBuffer, m_BonePalette.GetMatrices());
+		commandList->CopyStructuredBuffer(*m_InstancesStructuredBuffer, m_InstanceBatcher.GetInstances());
+	}
+
+	// The model matrices are per instance.
+	CBuffer::Model modelCBuffer{};
+	modelCBuffer.Compute(XMMatrixIdentity(), viewProjection);
+	m_RootSignature->SetModelConstantBuffer(*commandList, modelCBuffer);
+	m_RootSignature->SetPipelineShaderResourceView(*commandList, 0, ShaderResourceView(m_BonePaletteStructuredBuffer));
+	m_RootSignature->SetPipelineShaderResourceView(*commandList, 1, ShaderResourceView(m_InstancesStructuredBuffer));
+
+	{
+		PIXScope(*commandList, "Main Pass");
+
+		Material* boundMaterial = nullptr;
+
+		for (const auto& batch : m_InstanceBatcher.GetBatches())
+		{
+			if (boundMaterial != batch.Key.m_Material)
+			{
+				if (boundMaterial != nullptr)
 				{
-					bonesSb.push_back({ bone.Offset * bone.GlobalTransform });
+					boundMaterial->EndBatch(*commandList);
 				}
 
-				commandList->CopyStructuredBuffer(*m_BonesStructuredBuffer, bonesSb);
-				m_RootSignature->SetMaterialShaderResourceView(*commandList, 0, ShaderResourceView(m_BonesStructuredBuffer));
-				mesh->Draw(*commandList);
+				boundMaterial = batch.Key.m_Material;
+				boundMaterial->BeginBatch(*commandList);
+				boundMaterial->UploadUniforms(*commandList);
 			}
 
-			material->EndBatch(*commandList);
+			m_RootSignature->SetGraphicsRootConstants(*commandList, batch.FirstInstance);
+			batch.Key.m_Mesh->Draw(*commandList, batch.NumInstances);
+		}
+
+		if (boundMaterial != nullptr)
+		{
+			boundMaterial->EndBatch(*commandList);
 		}
 	}
 
+	if (numBoneInstances > 0)
 	{
 		PIXScope(*commandList, "Draw Bones");
 
-		for (const auto& go : m_GameObjects)
-		{
-			const auto& model = go.GetModel();
-
-
-			const auto& material = m_BoneMaterial;
-			material->BeginBatch(*commandList);
-			material->UploadUniforms(*commandList);
+		const auto& material = m_BoneMaterial;
+		material->BeginBatch(*commandList);
+		material->UploadUniforms(*commandList);
 
-			for (const auto& mesh : model->GetMeshes())
-			{
-				for (const auto& bone : mesh->GetArmature().GetBones())
-				{
-					CBuffer::Model modelCBuffer{};
-					XMMATRIX boneModelMatrix = bone.GlobalTransform * go.GetWorldMatrix();
-					modelCBuffer.Compute(boneModelMatrix, viewProjection);
-					m_RootSignature->SetModelConstantBuffer(*commandList, modelCBuffer);
-					m_BoneMesh->Draw(*commandList);
-				}
-			}
+		m_RootSignature->SetGraphicsRootConstants(*commandList, firstBoneInstance);
+		m_BoneMesh->Draw(*commandList, numBoneInstances);
 
-			material->EndBatch(*commandList);
-		}
+		material->EndBatch(*commandList);
 	}
 
 	commandQueue->ExecuteCommandList(commandList);
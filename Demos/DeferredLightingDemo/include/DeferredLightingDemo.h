@@ -6,6 +6,7 @@
 #include <DX12Library/Window.h>
 #include <DX12Library/RenderTarget.h>
 #include <DX12Library/RootSignature.h>
+#include <DX12Library/StructuredBuffer.h>
 #include <DX12Library/Texture.h>
 #include <DX12Library/VertexBuffer.h>
 
@@ -14,6 +15,9 @@
 
 #include <Framework/GameObject.h>
 #include <Framework/GraphicsSettings.h>
+#include <Framework/Material.h>
+#include <Framework/LightClustering.h>
+#include <Framework/SceneBvh.h>
 #include <HDR/ToneMapping.h>
 #include <Ssao.h>
 #include <Framework/TAA.h>
@@ -78,6 +82,7 @@ private:
 	void PointLightPass(CommandList& commandList, const PointLight& pointLight, const std::shared_ptr<Mesh>& mesh);
 	void SpotLightPass(CommandList& commandList, const SpotLight& spotLight, const std::shared_ptr<Mesh>& mesh);
 	void CapsuleLightPass(CommandList& commandList, const CapsuleLight& capsuleLight, const std::shared_ptr<Mesh>& mesh);
+	void ClusteredLightPass(CommandList& commandList);
 
 	std::shared_ptr<Texture> m_WhiteTexture2d;
 
@@ -116,7 +121,29 @@ private:
 	std::vector<SpotLight> m_SpotLights;
 	std::vector<CapsuleLight> m_CapsuleLights;
 
+	// The main view draws only the objects and the light volumes inside its frustum.
+	// The light volumes are the point lights, then the spot lights, then the capsule lights.
+	SceneBvh m_GameObjectBvh;
+	SceneBvh m_LightVolumeBvh;
+	std::vector<Aabb> m_CullingBounds;
+	std::vector<uint32_t> m_VisibleGameObjects;
+	std::vector<uint32_t> m_VisibleLightVolumes;
+
+	// With clustered lighting, a single full-screen pass shades the point and the spot lights, with only the lights of each pixel's cluster.
+	// The capsule lights are still drawn as light volumes.
+	bool m_ClusteredLightingEnabled = true;
+	LightClustering m_LightClustering;
+	std::vector<LightClustering::PointLightBounds> m_PointLightBounds;
+	std::vector<LightClustering::SpotLightBounds> m_SpotLightBounds;
+	std::shared_ptr<StructuredBuffer> m_PointLightsStructuredBuffer;
+	std::shared_ptr<StructuredBuffer> m_SpotLightsStructuredBuffer;
+	std::shared_ptr<StructuredBuffer> m_ClustersStructuredBuffer;
+	std::shared_ptr<StructuredBuffer> m_LightIndicesStructuredBuffer;
+	std::shared_ptr<Material> m_ClusteredLightPassMaterial;
+
 	std::shared_ptr<Material> m_DirectionalLightPassMaterial;
+	MaterialParameterHandle m_DirectionalLightDirectionParameter;
+	MaterialParameterHandle m_DirectionalLightColorParameter;
 	std::shared_ptr<Mesh> m_FullScreenMesh;
 
 	std::shared_ptr<Material> m_LightStencilPasssMaterial;
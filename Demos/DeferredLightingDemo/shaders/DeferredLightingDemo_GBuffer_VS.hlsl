@@ -6,8 +6,8 @@ struct VertexAttributes
     float3 PositionOs : POSITION;
     float3 Normal : NORMAL;
     float2 Uv : TEXCOORD;
-    float3 TangentOs : TANGENT;
-    float3 BitangentOs : BINORMAL;
+    // w is the handedness of the tangent frame, the bitangent is not stored (see VertexLayout).
+    float4 TangentOs : TANGENT;
 };
 
 struct VertexShaderOutput
@@ -31,8 +31,9 @@ VertexShaderOutput main(VertexAttributes IN)
     OUT.PositionCs = positionCS;
 
     OUT.NormalWs = mul((float3x3) g_Model_InverseTransposeModel, IN.Normal);
-    OUT.TangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.TangentOs);
-    OUT.BitangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.BitangentOs);
+    const float3 bitangentOs = cross(IN.Normal, IN.TangentOs.xyz) * IN.TangentOs.w;
+    OUT.TangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.TangentOs.xyz);
+    OUT.BitangentWs = mul((float3x3) g_Model_InverseTransposeModel, bitangentOs);
     OUT.Uv = IN.Uv;
 
     OUT.CurrentPositionCs = originalPositionCS;
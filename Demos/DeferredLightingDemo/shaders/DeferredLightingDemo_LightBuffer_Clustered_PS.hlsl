@@ -0,0 +1,97 @@
+#include "ShaderLibrary/PointLight.hlsli"
+#include "ShaderLibrary/SpotLight.hlsli"
+#include "ShaderLibrary/GBufferUtils.hlsli"
+#include "ShaderLibrary/ScreenParameters.hlsli"
+#include "ShaderLibrary/BRDF.hlsli"
+#include "ShaderLibrary/Pipeline.hlsli"
+
+// Matches LightClustering::ShaderParameters.
+cbuffer CBuffer : register(b0)
+{
+    uint TilesX;
+    uint TilesY;
+    uint SlicesCount;
+    uint NumPointLights;
+    float SliceScale;
+    float SliceBias;
+    float2 _Padding;
+};
+
+#include "ShaderLibrary/GBuffer.hlsli"
+
+StructuredBuffer<PointLight> pointLights : register(t4, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+StructuredBuffer<SpotLight> spotLights : register(t5, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+// Offset and count in lightIndices of every cluster.
+StructuredBuffer<uint2> clusters : register(t6, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+// The point lights, then the spot lights shifted by NumPointLights.
+StructuredBuffer<uint> lightIndices : register(t7, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+
+struct PixelShaderInput
+{
+    float4 PositionCS : SV_Position;
+};
+
+uint GetClusterIndex(const float2 uv, const float viewDepth)
+{
+    const uint tileX = min((uint) (uv.x * TilesX), TilesX - 1);
+    const uint tileY = min((uint) (uv.y * TilesY), TilesY - 1);
+    const uint slice = (uint) clamp(floor(log2(viewDepth) * SliceScale + SliceBias), 0.0f, (float) (SlicesCount - 1));
+    return (slice * TilesY + tileY) * TilesX + tileX;
+}
+
+float4 main(PixelShaderInput IN) : SV_TARGET
+{
+    ScreenParameters screenParameters = GetScreenParameters();
+    float2 uv = ToScreenSpaceUV(IN.PositionCS, screenParameters);
+    float3 diffuseColor = gBufferDiffuse.Sample(gBufferSampler, uv).rgb;
+    float3 normalWS = normalize(UnpackNormal(gBufferNormalsWS.Sample(gBufferSampler, uv).xyz));
+
+    float zNDC = gBufferDepth.Sample(gBufferSampler, uv).x;
+    float3 positionNDC = ScreenSpaceUVToNDC(uv, zNDC);
+    float4 positionVS = RestorePositionVS(positionNDC, g_Pipeline_InverseProjection);
+    float3 positionWS = mul(g_Pipeline_InverseView, positionVS).xyz;
+
+    BRDFInput brdfInput;
+    brdfInput.CameraPositionWS = g_Pipeline_CameraPosition.xyz;
+    brdfInput.NormalWS = normalWS;
+    brdfInput.PositionWS = positionWS;
+    brdfInput.DiffuseColor = diffuseColor;
+    brdfInput.Irradiance = 0;
+
+    const float4 surface = gBufferSurface.Sample(gBufferSampler, uv);
+    UnpackSurface(surface, brdfInput.Metallic, brdfInput.Roughness, brdfInput.AmbientOcclusion);
+
+    const uint2 cluster = clusters[GetClusterIndex(uv, positionVS.z)];
+
+    float3 color = 0;
+    for (uint i = 0; i < cluster.y; ++i)
+    {
+        const uint lightIndex = lightIndices[cluster.x + i];
+
+        if (lightIndex < NumPointLights)
+        {
+            const PointLight pointLight = pointLights[lightIndex];
+            const float3 lightOffsetWS = pointLight.PositionWS.xyz - positionWS;
+            const float lightDistance = length(lightOffsetWS);
+
+            brdfInput.LightColor = ComputeDistanceAttenuation(pointLight.ConstantAttenuation, pointLight.LinearAttenuation, pointLight.QuadraticAttenuation, lightDistance) * pointLight.Color.rgb;
+            brdfInput.LightDirectionWS = lightOffsetWS / lightDistance;
+        }
+        else
+        {
+            const SpotLight spotLight = spotLights[lightIndex - NumPointLights];
+            const float3 offsetWS = spotLight.PositionWS.xyz - positionWS;
+            const float distance = length(offsetWS);
+            const float3 directionTowardsLightWS = offsetWS / distance;
+
+            const float attenuation = GetSpotLightDistanceAttenuation(spotLight.Attenuation, distance) *
+                GetSpotLightConeAttenuation(spotLight.DirectionWS.xyz, directionTowardsLightWS, spotLight.SpotAngle);
+            brdfInput.LightColor = spotLight.Color.rgb * spotLight.Intensity * attenuation;
+            brdfInput.LightDirectionWS = directionTowardsLightWS;
+        }
+
+        color += ComputeBRDF(brdfInput);
+    }
+
+    return float4(color, 1.0);
+}
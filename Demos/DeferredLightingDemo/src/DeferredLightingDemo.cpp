@@ -7,6 +7,7 @@
 #include <Framework/Light.h>
 #include <DX12Library/Window.h>
 #include <Framework/GameObject.h>
+#include <Framework/LodSelector.h>
 #include <Framework/Bone.h>
 #include <Framework/Animation.h>
 #include <DX12Library/Cubemap.h>
@@ -193,7 +194,8 @@ namespace
         return std::max(color.x, std::max(color.y, color.z));
     }
 
-    XMMATRIX GetModelMatrix(const PointLight& light)
+    // The distance where the light becomes invisible.
+    float GetInfluenceRadius(const PointLight& light)
     {
         // assuming minimum visible attenuation of L...
         // 1/(c+l*d+q*d*d) = L
@@ -201,18 +203,29 @@ namespace
         const auto lInv = 1 / l;
         auto discriminant = light.LinearAttenuation * light.LinearAttenuation
             - 4 * light.QuadraticAttenuation * (light.ConstantAttenuation - lInv);
-        auto radius = 2 * (-light.LinearAttenuation + sqrt(discriminant)) / (2 * light.QuadraticAttenuation);
-        return XMMatrixScaling(radius, radius, radius) *
-            XMMatrixTranslationFromVector(XMLoadFloat4(&light.PositionWs));
+        return static_cast<float>((-light.LinearAttenuation + sqrt(discriminant)) / (2 * light.QuadraticAttenuation));
     }
 
-    XMMATRIX GetModelMatrix(const SpotLight& light)
+    float GetInfluenceRadius(const SpotLight& light)
     {
         // assuming minimum visible attenuation of L...
         // 1/(1+a * d * d) = L
         const auto l = 0.01f / (light.Intensity * GetMaxColorComponentRGB(light.Color));
         const auto lInv = 1 / l;
-        auto scaleZ = (light.Attenuation > 0.0f) ? (sqrt((lInv - 1) / light.Attenuation)) : 1000.0f;
+        return static_cast<float>((light.Attenuation > 0.0f) ? (sqrt((lInv - 1) / light.Attenuation)) : 1000.0f);
+    }
+
+    XMMATRIX GetModelMatrix(const PointLight& light)
+    {
+        // the sphere mesh has a diameter of 1
+        auto diameter = 2 * GetInfluenceRadius(light);
+        return XMMatrixScaling(diameter, diameter, diameter) *
+            XMMatrixTranslationFromVector(XMLoadFloat4(&light.PositionWs));
+    }
+
+    XMMATRIX GetModelMatrix(const SpotLight& light)
+    {
+        auto scaleZ = GetInfluenceRadius(light);
         auto tangent = static_cast<float>(tan(light.SpotAngle));
         auto scaleX = 2 * scaleZ * tangent;
 
@@ -252,6 +265,19 @@ namespace
         return transform;
     }
 
+    template <typename T>
+    void CopyStructuredBufferPadded(CommandList& commandList, StructuredBuffer& structuredBuffer, const std::vector<T>& data)
+    {
+        if (data.empty())
+        {
+            commandList.CopyStructuredBuffer(structuredBuffer, std::vector<T>(1));
+        }
+        else
+        {
+            commandList.CopyStructuredBuffer(structuredBuffer, data);
+        }
+    }
+
     auto GetSkyboxSampler(UINT shaderRegister)
     {
         auto skyboxSampler = CD3DX12_STATIC_SAMPLER_DESC(shaderRegister,
@@ -323,6 +349,8 @@ bool DeferredLightingDemo::LoadContent()
                 }
             );
             m_DirectionalLightPassMaterial = Material::Create(shader);
+            m_DirectionalLightDirectionParameter = m_DirectionalLightPassMaterial->FindParameter("DirectionWS");
+            m_DirectionalLightColorParameter = m_DirectionalLightPassMaterial->FindParameter("Color");
         }
 
         // light stencil pass
@@ -426,6 +454,27 @@ bool DeferredLightingDemo::LoadContent()
             );
         }
 
+        // clustered light pass
+        {
+            auto shader = std::make_shared<Shader>(m_CommonRootSignature,
+                ShaderBlob(L"DeferredLightingDemo_LightBuffer_Directional_VS.cso"),
+                ShaderBlob(L"DeferredLightingDemo_LightBuffer_Clustered_PS.cso"),
+                [](PipelineStateBuilder& builder)
+                {
+                    builder
+                        .WithAdditiveBlend()
+                        .WithDisabledDepthStencil()
+                        ;
+                }
+            );
+            m_ClusteredLightPassMaterial = Material::Create(shader);
+
+            m_PointLightsStructuredBuffer = std::make_shared<StructuredBuffer>(L"Point Lights Structured Buffer");
+            m_SpotLightsStructuredBuffer = std::make_shared<StructuredBuffer>(L"Spot Lights Structured Buffer");
+            m_ClustersStructuredBuffer = std::make_shared<StructuredBuffer>(L"Light Clusters Structured Buffer");
+            m_LightIndicesStructuredBuffer = std::make_shared<StructuredBuffer>(L"Light Indices Structured Buffer");
+        }
+
         // capsule light pass
         {
             ModelLoader modelLoader;
@@ -566,11 +615,13 @@ bool DeferredLightingDemo::LoadContent()
             ShaderBlob(L"DeferredLightingDemo_GBuffer_PS.cso")
             );
 
-        const std::string property_Metallic = "Metallic";
-        const std::string property_Roughness = "Roughness";
-        const std::string property_Diffuse = "Diffuse";
-        const std::string property_Emission = "Emission";
-        const std::string property_TilingOffset = "TilingOffset";
+        auto gBufferMaterialPreset = Material(gBufferShader);
+
+        const auto property_Metallic = gBufferMaterialPreset.FindParameter("Metallic");
+        const auto property_Roughness = gBufferMaterialPreset.FindParameter("Roughness");
+        const auto property_Diffuse = gBufferMaterialPreset.FindParameter("Diffuse");
+        const auto property_Emission = gBufferMaterialPreset.FindParameter("Emission");
+        const auto property_TilingOffset = gBufferMaterialPreset.FindParameter("TilingOffset");
 
         const std::string property_diffuseMap = "diffuseMap";
         const std::string property_normalMap = "normalMap";
@@ -578,7 +629,6 @@ bool DeferredLightingDemo::LoadContent()
         const std::string property_roughnessMap = "roughnessMap";
         const std::string property_ambientOcclusionMap = "ambientOcclusionMap";
 
-        auto gBufferMaterialPreset = Material(gBufferShader);
         gBufferMaterialPreset.SetVariable<XMFLOAT4>(property_Diffuse, { 1, 1, 1, 1 });
         gBufferMaterialPreset.SetVariable<float>(property_Metallic, 1.0f);
         gBufferMaterialPreset.SetVariable<float>(property_Roughness, 1.0f);
@@ -586,7 +636,7 @@ bool DeferredLightingDemo::LoadContent()
 
         const auto MaterialSetTexture = [&modelLoader, &commandList](Material& material, const std::string& propertyName, const std::wstring& texturePath, TextureUsageType usage = TextureUsageType::Albedo)
         {
-            material.SetShaderResourceView(propertyName, ShaderResourceView(modelLoader.LoadTexture(*commandList, texturePath, usage)));
+            material.SetShaderResourceView(propertyName, ShaderResourceView(modelLoader.LoadTexture(*commandList, texturePath, usage, true)));
         };
 
         {
@@ -1067,6 +1117,73 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
         const XMMATRIX projectionMatrix = m_Camera.GetProjectionMatrix();
         const XMMATRIX viewProjectionMatrix = viewMatrix * projectionMatrix;
 
+        {
+            const auto frustum = SceneBvh::Frustum::FromViewProjection(viewProjectionMatrix);
+
+            m_CullingBounds.clear();
+            for (const auto& go : m_GameObjects)
+            {
+                m_CullingBounds.push_back(go.GetAabb());
+            }
+
+            m_GameObjectBvh.Update(m_CullingBounds);
+            m_VisibleGameObjects.clear();
+            m_GameObjectBvh.Query(frustum, m_VisibleGameObjects);
+
+            m_CullingBounds.clear();
+            for (const auto& pointLight : m_PointLights)
+            {
+                m_CullingBounds.push_back(Aabb::Transform(GetModelMatrix(pointLight), m_PointLightMesh->GetAabb()));
+            }
+            for (const auto& spotLight : m_SpotLights)
+            {
+                m_CullingBounds.push_back(Aabb::Transform(GetModelMatrix(spotLight), m_SpotLightMesh->GetAabb()));
+            }
+            for (const auto& capsuleLight : m_CapsuleLights)
+            {
+                m_CullingBounds.push_back(Aabb::Transform(GetModelMatrix(capsuleLight), m_CapsuleLightMesh->GetAabb()));
+            }
+
+            m_LightVolumeBvh.Update(m_CullingBounds);
+            m_VisibleLightVolumes.clear();
+            m_LightVolumeBvh.Query(frustum, m_VisibleLightVolumes);
+
+            // Keeps the draw order of the scene, and groups the light volumes by type.
+            std::sort(m_VisibleGameObjects.begin(), m_VisibleGameObjects.end());
+            std::sort(m_VisibleLightVolumes.begin(), m_VisibleLightVolumes.end());
+
+            if (m_ClusteredLightingEnabled)
+            {
+                // The lights outside the frustum are in no cluster, so all of them are given.
+                m_PointLightBounds.clear();
+                for (const auto& pointLight : m_PointLights)
+                {
+                    const XMFLOAT3 positionWs(pointLight.PositionWs.x, pointLight.PositionWs.y, pointLight.PositionWs.z);
+                    m_PointLightBounds.push_back({ positionWs, GetInfluenceRadius(pointLight) });
+                }
+
+                m_SpotLightBounds.clear();
+                for (const auto& spotLight : m_SpotLights)
+                {
+                    const XMFLOAT3 positionWs(spotLight.PositionWs.x, spotLight.PositionWs.y, spotLight.PositionWs.z);
+                    const XMFLOAT3 directionWs(spotLight.DirectionWs.x, spotLight.DirectionWs.y, spotLight.DirectionWs.z);
+                    m_SpotLightBounds.push_back({ positionWs, GetInfluenceRadius(spotLight), directionWs, spotLight.SpotAngle });
+                }
+
+                m_LightClustering.Build(LightClustering::Settings{}, viewMatrix, projectionMatrix, m_PointLightBounds, m_SpotLightBounds);
+            }
+        }
+
+        {
+            const LodSelector lodSelector(viewMatrix, projectionMatrix);
+
+            for (auto& go : m_GameObjects)
+            {
+                go.SelectLods(lodSelector);
+                go.RequestTextureMips(lodSelector, static_cast<float>(m_Height));
+            }
+        }
+
         m_CommonRootSignature->Bind(*commandList);
         Demo::Pipeline::CBuffer pipelineCBuffer{};
 
@@ -1099,8 +1216,9 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
             commandList->SetRenderTarget(m_GBufferRenderTarget);
             commandList->SetAutomaticViewportAndScissorRect(m_GBufferRenderTarget);
 
-            for (const auto& go : m_GameObjects)
+            for (const uint32_t gameObjectIndex : m_VisibleGameObjects)
             {
+                const auto& go = m_GameObjects[gameObjectIndex];
                 Demo::Model::CBuffer modelCBuffer{};
                 modelCBuffer.Compute(go.GetWorldMatrix(), viewProjectionMatrix);
                 modelCBuffer.m_Taa_PreviousModelViewProjectionMatrix = go.GetPreviousWorldMatrix() * m_Taa->GetPreviousViewProjectionMatrix();
@@ -1186,8 +1304,8 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
                 ShaderResourceView irradianceMapSrv(diffuseIrradianceMap, irradianceSrvDesc);
 
                 m_DirectionalLightPassMaterial->SetShaderResourceView("irradianceMap", irradianceMapSrv);
-                m_DirectionalLightPassMaterial->SetVariable<XMFLOAT4>("DirectionWS", m_DirectionalLight.m_DirectionWs);
-                m_DirectionalLightPassMaterial->SetVariable<XMFLOAT4>("Color", m_DirectionalLight.m_Color);
+                m_DirectionalLightPassMaterial->SetVariable<XMFLOAT4>(m_DirectionalLightDirectionParameter, m_DirectionalLight.m_DirectionWs);
+                m_DirectionalLightPassMaterial->SetVariable<XMFLOAT4>(m_DirectionalLightColorParameter, m_DirectionalLight.m_Color);
 
                 m_DirectionalLightPassMaterial->Bind(*commandList);
                 m_FullScreenMesh->Draw(*commandList);
@@ -1218,11 +1336,23 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
 
             commandList->SetStencilRef(0);
 
+            const auto firstSpotLightVolume = static_cast<uint32_t>(m_PointLights.size());
+            const auto firstCapsuleLightVolume = firstSpotLightVolume + static_cast<uint32_t>(m_SpotLights.size());
+            const auto spotLightVolumes = std::lower_bound(m_VisibleLightVolumes.begin(), m_VisibleLightVolumes.end(), firstSpotLightVolume);
+            const auto capsuleLightVolumes = std::lower_bound(spotLightVolumes, m_VisibleLightVolumes.end(), firstCapsuleLightVolume);
+
+            if (m_ClusteredLightingEnabled)
+            {
+                PIXScope(*commandList, "Clustered Light Pass");
+                ClusteredLightPass(*commandList);
+            }
+            else
             {
                 PIXScope(*commandList, "Point Light Pass");
 
-                for (const auto& pointLight : m_PointLights)
+                for (auto it = m_VisibleLightVolumes.begin(); it != spotLightVolumes; ++it)
                 {
+                    const auto& pointLight = m_PointLights[*it];
                     XMMATRIX modelMatrix = GetModelMatrix(pointLight);
                     const auto& mesh = m_PointLightMesh;
                     LightStencilPass(*commandList, modelMatrix, viewProjectionMatrix, mesh);
@@ -1230,11 +1360,13 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
                 }
             }
 
+            if (!m_ClusteredLightingEnabled)
             {
                 PIXScope(*commandList, "Spot Light Pass");
 
-                for (const auto& spotLight : m_SpotLights)
+                for (auto it = spotLightVolumes; it != capsuleLightVolumes; ++it)
                 {
+                    const auto& spotLight = m_SpotLights[*it - firstSpotLightVolume];
                     XMMATRIX modelMatrix = GetModelMatrix(spotLight);
                     const auto& mesh = m_SpotLightMesh;
                     LightStencilPass(*commandList, modelMatrix, viewProjectionMatrix, mesh);
@@ -1245,8 +1377,9 @@ void DeferredLightingDemo::OnRender(RenderEventArgs& e)
             {
                 PIXScope(*commandList, "Capsule Light Pass");
 
-                for (const auto& capsuleLight : m_CapsuleLights)
+                for (auto it = capsuleLightVolumes; it != m_VisibleLightVolumes.end(); ++it)
                 {
+                    const auto& capsuleLight = m_CapsuleLights[*it - firstCapsuleLightVolume];
                     XMMATRIX modelMatrix = GetModelMatrix(capsuleLight);
                     const auto& mesh = m_CapsuleLightMesh;
                     LightStencilPass(*commandList, modelMatrix, viewProjectionMatrix, mesh);
@@ -1413,6 +1546,34 @@ void DeferredLightingDemo::SpotLightPass(CommandList& commandList,
     m_SpotLightPassMaterial->Unbind(commandList);
 }
 
+void DeferredLightingDemo::ClusteredLightPass(CommandList& commandList)
+{
+    const auto& lightIndices = m_LightClustering.GetLightIndices();
+    if (lightIndices.empty())
+    {
+        return;
+    }
+
+    // A structured buffer can't be empty: the padding light is never read, as no cluster refers to it.
+    CopyStructuredBufferPadded(commandList, *m_PointLightsStructuredBuffer, m_PointLights);
+    CopyStructuredBufferPadded(commandList, *m_SpotLightsStructuredBuffer, m_SpotLights);
+    commandList.CopyStructuredBuffer(*m_ClustersStructuredBuffer, m_LightClustering.GetClusters());
+    commandList.CopyStructuredBuffer(*m_LightIndicesStructuredBuffer, lightIndices);
+
+    m_CommonRootSignature->SetPipelineShaderResourceView(commandList, 4, ShaderResourceView(m_PointLightsStructuredBuffer));
+    m_CommonRootSignature->SetPipelineShaderResourceView(commandList, 5, ShaderResourceView(m_SpotLightsStructuredBuffer));
+    m_CommonRootSignature->SetPipelineShaderResourceView(commandList, 6, ShaderResourceView(m_ClustersStructuredBuffer));
+    m_CommonRootSignature->SetPipelineShaderResourceView(commandList, 7, ShaderResourceView(m_LightIndicesStructuredBuffer));
+
+    m_ClusteredLightPassMaterial->SetAllVariables(m_LightClustering.GetShaderParameters());
+
+    commandList.SetRenderTarget(m_LightBufferRenderTarget);
+
+    m_ClusteredLightPassMaterial->Bind(commandList);
+    m_FullScreenMesh->Draw(commandList);
+    m_ClusteredLightPassMaterial->Unbind(commandList);
+}
+
 void DeferredLightingDemo::CapsuleLightPass(CommandList& commandList,
     const CapsuleLight& capsuleLight,
     const std::shared_ptr<Mesh>& mesh)
@@ -1542,6 +1703,10 @@ void DeferredLightingDemo::OnKeyReleased(KeyEventArgs& e)
         m_BloomEnabled = !m_BloomEnabled;
         OutputDebugStringA(m_BloomEnabled ? "Bloom: On\n" : "Bloom: Off\n");
         break;
+    case KeyCode::C:
+        m_ClusteredLightingEnabled = !m_ClusteredLightingEnabled;
+        OutputDebugStringA(m_ClusteredLightingEnabled ? "Clustered Lighting: On\n" : "Clustered Lighting: Off\n");
+        break;
     }
 }
 
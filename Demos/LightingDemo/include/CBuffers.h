@@ -1,5 +1,7 @@
 #pragma once
 
+#include <Framework/ShadowCascades.h>
+
 namespace Demo::Pipeline
 {
     struct CBuffer
@@ -16,12 +18,15 @@ namespace Demo::Pipeline
         DirectX::XMFLOAT2 m_ScreenResolution;
         DirectX::XMFLOAT2 m_ScreenTexelSize;
 
-        DirectX::XMMATRIX m_DirectionalLightViewProjection;
+        DirectX::XMMATRIX m_DirectionalLightViewProjections[ShadowCascades::MAX_CASCADES_COUNT];
 
         DirectionalLight m_DirectionalLight;
 
         uint32_t m_NumPointLights;
         uint32_t m_NumSpotLights;
+        uint32_t m_DirectionalLightCascadesCount;
+        // HLSL starts a struct on a new 16-byte register.
+        uint32_t m_Padding;
 
         struct ShadowReceiverParameters
         {
@@ -5,6 +5,8 @@
 #include <DirectXMath.h>
 
 #include <Framework/GameObject.h>
+#include <Framework/GraphicsSettings.h>
+#include <Framework/ShadowCascades.h>
 #include <DX12Library/RenderTarget.h>
 #include "Scene.h"
 #include "ShadowPassPsoBase.h"
@@ -16,18 +18,32 @@ class CommandList;
 class DirectionalLightShadowPassPso final : public ShadowPassPsoBase
 {
 public:
-	explicit DirectionalLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution = 4096);
-	void ComputePassParameters(const Scene& scene, const DirectionalLight& directionalLight);
+	DirectionalLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution,
+		const GraphicsSettings::ShadowCascadesSettings& cascadesSettings);
+
+	// Fits the cascades to the camera's frustum. Select the one to render with SetCurrentCascade.
+	void ComputePassParameters(const Scene& scene, const DirectionalLight& directionalLight, const Camera& camera);
 
 	[[nodiscard]] DirectX::XMMATRIX ComputeShadowModelViewProjectionMatrix(DirectX::XMMATRIX worldMatrix) const;
 
+	[[nodiscard]] uint32_t GetCascadesCount() const;
+	void SetCurrentCascade(uint32_t cascadeIndex);
+	[[nodiscard]] DirectX::XMMATRIX GetCascadeViewProjectionMatrix(uint32_t cascadeIndex) const;
+
 	void SetRenderTarget(CommandList& commandList) const override;
 	void ClearShadowMap(CommandList& commandList) const override;
+	// Clears only the cascade selected with SetCurrentCascade, so that the others keep their contents.
+	void ClearCurrentShadowMap(CommandList& commandList) const;
 
 	ShaderResourceView GetShadowMapShaderResourceView() const override;
 
 private:
 	[[nodiscard]] const std::shared_ptr<Texture>& GetShadowMapAsTexture() const;
 
+	ShadowCascades::Settings m_CascadesSettings;
+	ShadowCascades m_Cascades;
+	uint32_t m_CurrentCascadeIndex;
+
+	// A slice per cascade.
 	RenderTarget m_ShadowMap;
 };
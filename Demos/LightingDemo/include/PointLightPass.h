@@ -3,6 +3,7 @@
 #include <wrl.h>
 #include <memory>
 
+#include <Framework/Aabb.h>
 #include <Framework/Light.h>
 #include <Framework/Material.h>
 #include <Framework/CommonRootSignature.h>
@@ -19,7 +20,12 @@ public:
     void End(CommandList& commandList) const;
     void Draw(CommandList& commandList, const PointLight& pointLight, const DirectX::XMMATRIX& viewProjection, float scale) const;
 
+    // The world-space bounds of what Draw draws, for culling.
+    Aabb GetBounds(const PointLight& pointLight, float scale) const;
+
 private:
+    static DirectX::XMMATRIX ComputeWorldMatrix(const PointLight& pointLight, float scale);
+
     std::shared_ptr<CommonRootSignature> m_RootSignature;
     std::shared_ptr<Mesh> m_Mesh;
     std::shared_ptr<Material> m_Material;
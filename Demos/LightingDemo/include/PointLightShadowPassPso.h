@@ -11,12 +11,17 @@ public:
     PointLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution);
     void SetRenderTarget(CommandList& commandList) const override;
     void ClearShadowMap(CommandList& commandList) const override;
+    // Clears only the shadow map selected with SetCurrentShadowMap, so that the others keep their contents.
+    void ClearCurrentShadowMap(CommandList& commandList) const;
 
     ShaderResourceView GetShadowMapShaderResourceView() const override;
 
     void ComputePassParameters(const PointLight& pointLight);
+    // The far plane of the cube map faces: nothing further away casts a shadow.
+    static float ComputeShadowRange(const PointLight& pointLight);
     void SetCurrentShadowMap(uint32_t lightIndex, uint32_t cubeMapSideIndex);
-    void SetShadowMapsCount(uint32_t count);
+    // Returns true if the shadow maps have been recreated, i.e., their contents are lost.
+    bool SetShadowMapsCount(uint32_t count);
 
 
 private:
@@ -16,6 +16,8 @@
 #include <Framework/GraphicsSettings.h>
 #include "PointLightPass.h"
 #include <Framework/CommonRootSignature.h>
+#include <Framework/SceneBvh.h>
+#include <Framework/ShadowCasterCulling.h>
 
 
 class SceneRenderer
@@ -62,6 +64,20 @@ private:
     std::vector<DirectX::XMMATRIX> m_PointLightShadowMatrices;
     std::vector<DirectX::XMMATRIX> m_SpotLightShadowMatrices;
 
+    // The shadow maps keep their contents between frames, a view is only redrawn when its casters have changed.
+    std::vector<ShadowCasterCulling::Caster> m_ShadowCasters;
+    std::vector<Aabb> m_ShadowCasterBounds;
+    ShadowCasterCulling m_DirectionalLightShadowCasters;
+    ShadowCasterCulling m_PointLightShadowCasters;
+    ShadowCasterCulling m_SpotLightShadowCasters;
+
+    // Updated once per frame by ShadowPass, and queried by every MainPass (the camera and the reflection cubemap's sides).
+    SceneBvh m_GameObjectBvh;
+    SceneBvh m_PointLightBvh;
+    std::vector<Aabb> m_PointLightBounds;
+    std::vector<uint32_t> m_VisibleGameObjects;
+    std::vector<uint32_t> m_VisiblePointLights;
+
     std::shared_ptr<StructuredBuffer> m_PointLightsStructuredBuffer;
     std::shared_ptr<StructuredBuffer> m_SpotLightsStructuredBuffer;
 
@@ -10,12 +10,15 @@ public:
     SpotLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution);
     void SetRenderTarget(CommandList& commandList) const override;
     void ClearShadowMap(CommandList& commandList) const override;
+    // Clears only the shadow map selected with SetCurrentShadowMap, so that the others keep their contents.
+    void ClearCurrentShadowMap(CommandList& commandList) const;
 
     ShaderResourceView GetShadowMapShaderResourceView() const override;
 
     void ComputePassParameters(const SpotLight& spotLight);
     void SetCurrentShadowMap(uint32_t lightIndex);
-    void SetShadowMapsCount(uint32_t count);
+    // Returns true if the shadow maps have been recreated, i.e., their contents are lost.
+    bool SetShadowMapsCount(uint32_t count);
 
 private:
     [[nodiscard]] const std::shared_ptr<Texture>& GetShadowMapsAsTexture() const;
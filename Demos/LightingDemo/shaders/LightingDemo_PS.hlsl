@@ -10,7 +10,6 @@ struct PixelShaderInput
     float3 TangentWs : TANGENT;
     float3 BitangentWs : BINORMAL;
     float2 Uv : TEXCOORD;
-    float4 ShadowCoords : SHADOW_COORD;
     float3 EyeWs : EYE_WS;
 };
 
@@ -42,7 +41,7 @@ cbuffer MaterialCBuffer : register(b0)
     float4 TilingOffset = float4(1, 1, 0, 0);
 };
 
-Texture2D directionalLightShadowMap : register(t0, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+Texture2DArray directionalLightShadowMap : register(t0, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 
 StructuredBuffer<PointLight> pointLights : register(t1, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 Texture2DArray pointLightShadowMaps : register(t2, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
@@ -77,13 +76,31 @@ struct Light
 #include "ShaderLibrary/ShadowsPoissonSampling.hlsli"
 #undef POISSON_SAMPLING_SPOT_LIGHT
 
-Light GetMainLight(const float4 shadowCoords)
+float MainLightShadowAttenuation(const float3 positionWs)
+{
+    // The cascades are ordered from the nearest (and the sharpest) one: take the first one that covers the position, filter included.
+    const float border = g_Pipeline_ShadowReceiverParameters.PoissonSpreadInv;
+
+    for (uint cascadeIndex = 0; cascadeIndex < g_Pipeline_DirectionalLightCascadesCount; ++cascadeIndex)
+    {
+        const float4 shadowCoords = HClipToShadowCoords(mul(g_Pipeline_DirectionalLightViewProjections[cascadeIndex], float4(positionWs, 1.0f)));
+        if (all(shadowCoords.xy >= border) && all(shadowCoords.xy <= 1 - border) && shadowCoords.z >= 0 && shadowCoords.z <= 1)
+        {
+            return PoissonSampling_MainLight(shadowCoords, cascadeIndex);
+        }
+    }
+
+    // Further than the last cascade.
+    return 1.0f;
+}
+
+Light GetMainLight(const float3 positionWs)
 {
     Light light;
     light.Color = g_Pipeline_DirectionalLight.Color.rgb;
     light.DirectionWs = g_Pipeline_DirectionalLight.DirectionWs.xyz;
     light.DistanceAttenuation = 1.0f;
-    light.ShadowAttenuation = PoissonSampling_MainLight(shadowCoords);
+    light.ShadowAttenuation = MainLightShadowAttenuation(positionWs);
     return light;
 }
 
@@ -213,7 +230,7 @@ void Combine(inout LightingResult destination, const in LightingResult source)
 }
 
 LightingResult ComputeLighting(const float3 positionWs, const float3 normalWs, const float specularPower,
-                               const float4 shadowCoords, const float3 eyeWs)
+                               const float3 eyeWs)
 {
     LightingResult totalLightingResult;
     totalLightingResult.Diffuse = 0;
@@ -221,7 +238,7 @@ LightingResult ComputeLighting(const float3 positionWs, const float3 normalWs, c
 
 	// main light
 	{
-        const Light light = GetMainLight(shadowCoords);
+        const Light light = GetMainLight(positionWs);
         const LightingResult lightingResult = Phong(light, normalWs, eyeWs, specularPower);
         Combine(totalLightingResult, lightingResult);
     }
@@ -280,7 +297,7 @@ float4 main(PixelShaderInput IN) : SV_Target
     }
 
     const float3 eyeWs = normalize(IN.EyeWs);
-    const LightingResult lightingResult = ComputeLighting(IN.PositionWs, normalWs, specularPower, IN.ShadowCoords, eyeWs);
+    const LightingResult lightingResult = ComputeLighting(IN.PositionWs, normalWs, specularPower, eyeWs);
 
     const float4 emissive = Emissive;
     const float4 ambient = Ambient;
@@ -19,8 +19,8 @@ struct VertexAttributes
     float3 PositionOs : POSITION;
     float3 Normal : NORMAL;
     float2 Uv : TEXCOORD;
-    float3 TangentOs : TANGENT;
-    float3 BitangentOs : BINORMAL;
+    // w is the handedness of the tangent frame, the bitangent is not stored (see VertexLayout).
+    float4 TangentOs : TANGENT;
 };
 
 struct VertexShaderOutput
@@ -30,7 +30,6 @@ struct VertexShaderOutput
     float3 TangentWs : TANGENT;
     float3 BitangentWs : BINORMAL;
     float2 Uv : TEXCOORD0;
-    float4 ShadowCoords : SHADOW_COORD;
     float3 EyeWs : EYE_WS;
     float4 PositionCs : SV_POSITION;
 };
@@ -41,17 +40,14 @@ VertexShaderOutput main(VertexAttributes IN)
 
     OUT.PositionCs = mul(g_Model_ModelViewProjection, float4(IN.PositionOs, 1.0f));
     OUT.NormalWs = mul((float3x3) g_Model_InverseTransposeModel, IN.Normal);
-    OUT.TangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.TangentOs);
-    OUT.BitangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.BitangentOs);
+    const float3 bitangentOs = cross(IN.Normal, IN.TangentOs.xyz) * IN.TangentOs.w;
+    OUT.TangentWs = mul((float3x3) g_Model_InverseTransposeModel, IN.TangentOs.xyz);
+    OUT.BitangentWs = mul((float3x3) g_Model_InverseTransposeModel, bitangentOs);
     OUT.Uv = IN.Uv;
 
     const float4 positionWs = mul(g_Model_Model, float4(IN.PositionOs, 1.0f));
     OUT.PositionWs = positionWs.xyz;
 
-	// See http://www.opengl-tutorial.org/ru/intermediate-tutorials/tutorial-16-shadow-mapping/
-	// "Using the shadow map"
-    OUT.ShadowCoords = HClipToShadowCoords(mul(g_Pipeline_DirectionalLightViewProjection, positionWs));
-	
     OUT.EyeWs = normalize(positionWs.xyz - g_Pipeline_CameraPosition.xyz);
 
     return OUT;
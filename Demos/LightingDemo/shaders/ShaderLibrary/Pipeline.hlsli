@@ -5,6 +5,9 @@
 #include <ShaderLibrary/ScreenParameters.hlsli>
 #include <ShaderLibrary/Shadows.hlsli>
 
+// Matches ShadowCascades::MAX_CASCADES_COUNT.
+#define DIRECTIONAL_LIGHT_MAX_CASCADES_COUNT 4
+
 struct DirectionalLight
 {
     float4 DirectionWs; // update on CPU
@@ -25,12 +28,14 @@ cbuffer PipelineCBuffer : register(b0, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE)
     float2 g_Pipeline_Screen_Resolution;
     float2 g_Pipeline_Screen_TexelSize;
     
-    matrix g_Pipeline_DirectionalLightViewProjection;
+    // Ordered from the nearest cascade.
+    matrix g_Pipeline_DirectionalLightViewProjections[DIRECTIONAL_LIGHT_MAX_CASCADES_COUNT];
     
     DirectionalLight g_Pipeline_DirectionalLight;
 
     uint g_Pipeline_NumPointLights;
     uint g_Pipeline_NumSpotLights;
+    uint g_Pipeline_DirectionalLightCascadesCount;
     
     ShadowReceiverParameters g_Pipeline_ShadowReceiverParameters;
 };
@@ -32,7 +32,7 @@ float PoissonSampling_PointLight(const float4 shadowCoords, const uint shadowSli
 #elif defined(POISSON_SAMPLING_SPOT_LIGHT)
 float PoissonSampling_SpotLight(const float4 shadowCoords, const uint shadowSliceIndex)
 #else
-float PoissonSampling_MainLight(const float4 shadowCoords)
+float PoissonSampling_MainLight(const float4 shadowCoords, const uint shadowSliceIndex)
 #endif
 {
 	if (any(shadowCoords.xyz < 0) || any(shadowCoords.xyz > 1))
@@ -64,7 +64,7 @@ float PoissonSampling_MainLight(const float4 shadowCoords)
 			sampleShadowCoords.z).x;
 #else
 		attenuation += directionalLightShadowMap.SampleCmpLevelZero(
-			g_Common_ShadowMapSampler, sampleShadowCoords.xy, sampleShadowCoords.z).x;
+			g_Common_ShadowMapSampler, float3(sampleShadowCoords.xy, shadowSliceIndex), sampleShadowCoords.z).x;
 #endif
 
 
@@ -10,20 +10,30 @@
 
 #include <DirectXMath.h>
 
+#include <algorithm>
+
+#include <DX12Library/Camera.h>
 #include <Framework/Light.h>
 #include <Framework/Model.h>
 
 using namespace Microsoft::WRL;
 using namespace DirectX;
 
-DirectionalLightShadowPassPso::DirectionalLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution)
+DirectionalLightShadowPassPso::DirectionalLightShadowPassPso(const std::shared_ptr<CommonRootSignature>& rootSignature, UINT resolution,
+    const GraphicsSettings::ShadowCascadesSettings& cascadesSettings)
     : ShadowPassPsoBase(rootSignature, resolution)
+    , m_CurrentCascadeIndex(0)
 {
     m_ShadowPassParameters.LightType = ShadowPassParameters::DirectionalLight;
 
+    m_CascadesSettings.CascadesCount = std::clamp<uint32_t>(cascadesSettings.m_CascadesCount, 1, ShadowCascades::MAX_CASCADES_COUNT);
+    m_CascadesSettings.LogarithmicSplitWeight = cascadesSettings.m_LogarithmicSplitWeight;
+    m_CascadesSettings.MaxDistance = cascadesSettings.m_MaxDistance;
+    m_CascadesSettings.Resolution = m_Resolution;
+
     const auto shadowMapDesc = CD3DX12_RESOURCE_DESC::Tex2D(SHADOW_MAP_FORMAT,
         m_Resolution, m_Resolution,
-        1, 1,
+        static_cast<UINT16>(m_CascadesSettings.CascadesCount), 1,
         1, 0,
         D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
     D3D12_CLEAR_VALUE depthClearValue;
@@ -32,38 +42,35 @@ DirectionalLightShadowPassPso::DirectionalLightShadowPassPso(const std::shared_p
 
     const auto shadowMap = std::make_shared<Texture>(shadowMapDesc, &depthClearValue,
         TextureUsageType::Depth,
-        L"Shadow Map");
+        L"Shadow Map Cascades");
     m_ShadowMap.AttachTexture(DepthStencil, shadowMap);
 }
 
 void DirectionalLightShadowPassPso::ComputePassParameters(
-    const Scene& scene, const DirectionalLight& directionalLight)
+    const Scene& scene, const DirectionalLight& directionalLight, const Camera& camera)
 {
     const XMVECTOR lightDirection = XMLoadFloat4(&directionalLight.m_DirectionWs);
-    const auto sceneBounds = scene.ComputeBoundingSphere();
-    const float radius = sceneBounds.GetRadius();
+    m_Cascades.Update(m_CascadesSettings, camera.GetViewMatrix(), camera.GetProjectionMatrix(),
+        lightDirection, scene.ComputeBoundingSphere());
 
+    m_ShadowPassParameters.LightDirectionWs = directionalLight.m_DirectionWs;
+    SetCurrentCascade(0);
+}
 
-    const auto viewMatrix = XMMatrixLookToLH(2.0f * radius * lightDirection, -lightDirection,
-        XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-    XMFLOAT3 sceneCenterVs{};
-    XMStoreFloat3(&sceneCenterVs, XMVector3TransformCoord(sceneBounds.GetCenter(), viewMatrix));
-
-    const float projLeft = sceneCenterVs.x - radius;
-    const float projRight = sceneCenterVs.x + radius;
-    const float projBottom = sceneCenterVs.y - radius;
-    const float projTop = sceneCenterVs.y + radius;
-    const float projNear = sceneCenterVs.z - radius;
-    const float projFar = sceneCenterVs.z + radius;
+uint32_t DirectionalLightShadowPassPso::GetCascadesCount() const
+{
+    return m_Cascades.GetCascadesCount();
+}
 
-    const auto projectionMatrix = XMMatrixOrthographicOffCenterLH(projLeft, projRight,
-        projBottom, projTop,
-        projNear, projFar
-    );
-    const auto viewProjection = viewMatrix * projectionMatrix;
+void DirectionalLightShadowPassPso::SetCurrentCascade(const uint32_t cascadeIndex)
+{
+    m_CurrentCascadeIndex = cascadeIndex;
+    m_ShadowPassParameters.ViewProjection = m_Cascades.GetCascade(cascadeIndex).ViewProjection;
+}
 
-    m_ShadowPassParameters.LightDirectionWs = directionalLight.m_DirectionWs;
-    m_ShadowPassParameters.ViewProjection = viewProjection;
+XMMATRIX DirectionalLightShadowPassPso::GetCascadeViewProjectionMatrix(const uint32_t cascadeIndex) const
+{
+    return m_Cascades.GetCascade(cascadeIndex).ViewProjection;
 }
 
 void DirectionalLightShadowPassPso::ClearShadowMap(CommandList& commandList) const
@@ -71,20 +78,27 @@ void DirectionalLightShadowPassPso::ClearShadowMap(CommandList& commandList) con
     commandList.ClearDepthStencilTexture(*GetShadowMapAsTexture(), D3D12_CLEAR_FLAG_DEPTH);
 }
 
+void DirectionalLightShadowPassPso::ClearCurrentShadowMap(CommandList& commandList) const
+{
+    commandList.ClearDepthStencilTextureArraySlice(*GetShadowMapAsTexture(), m_CurrentCascadeIndex, D3D12_CLEAR_FLAG_DEPTH);
+}
+
 ShaderResourceView DirectionalLightShadowPassPso::GetShadowMapShaderResourceView() const
 {
-    constexpr auto stateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    const uint32_t numSubresources = m_CascadesSettings.CascadesCount;
 
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-    srvDesc.Texture2D.PlaneSlice = 0;
-
-    return ShaderResourceView(GetShadowMapAsTexture(), 0, 1, srvDesc);
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.ArraySize = numSubresources;
+    srvDesc.Texture2DArray.MipLevels = 1;
+    srvDesc.Texture2DArray.FirstArraySlice = 0;
+    srvDesc.Texture2DArray.MostDetailedMip = 0;
+    srvDesc.Texture2DArray.PlaneSlice = 0;
+    srvDesc.Texture2DArray.ResourceMinLODClamp = 0.0f;
+
+    return ShaderResourceView(GetShadowMapAsTexture(), 0, numSubresources, srvDesc);
 }
 
 XMMATRIX DirectionalLightShadowPassPso::ComputeShadowModelViewProjectionMatrix(
@@ -95,7 +109,7 @@ XMMATRIX DirectionalLightShadowPassPso::ComputeShadowModelViewProjectionMatrix(
 
 void DirectionalLightShadowPassPso::SetRenderTarget(CommandList& commandList) const
 {
-    commandList.SetRenderTarget(m_ShadowMap);
+    commandList.SetRenderTarget(m_ShadowMap, m_CurrentCascadeIndex);
 }
 
 const std::shared_ptr<Texture>& DirectionalLightShadowPassPso::GetShadowMapAsTexture() const
@@ -56,7 +56,7 @@ ParticleSystemPso::ParticleSystemPso(const std::shared_ptr<CommonRootSignature>&
         {
             constexpr size_t inputElementsCount = VertexAttributes::INPUT_ELEMENT_COUNT + INSTANCE_INPUT_ELEMENT_COUNT;
             std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(inputElementsCount);
-            std::copy_n(VertexAttributes::INPUT_ELEMENTS, VertexAttributes::INPUT_ELEMENT_COUNT, inputElements.data());
+            std::copy_n(VertexAttributes::INPUT_ELEMENTS.data(), VertexAttributes::INPUT_ELEMENT_COUNT, inputElements.data());
             std::copy_n(INSTANCE_INPUT_ELEMENTS, INSTANCE_INPUT_ELEMENT_COUNT,
                 inputElements.data() + VertexAttributes::INPUT_ELEMENT_COUNT
             );
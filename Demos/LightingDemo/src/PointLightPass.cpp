@@ -25,12 +25,8 @@ void PointLightPass::End(CommandList &commandList) const
 
 void PointLightPass::Draw(CommandList &commandList, const PointLight &pointLight, const DirectX::XMMATRIX &viewProjection, float scale) const
 {
-    XMMATRIX worldMatrix = XMMatrixTranslation(pointLight.PositionWs.x, pointLight.PositionWs.y,
-        pointLight.PositionWs.z);
-    worldMatrix = XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), worldMatrix);
-
     Demo::Model::CBuffer modelCBuffer{};
-    modelCBuffer.Compute(worldMatrix, viewProjection);
+    modelCBuffer.Compute(ComputeWorldMatrix(pointLight, scale), viewProjection);
     m_RootSignature->SetModelConstantBuffer(commandList, modelCBuffer);
 
     m_Material->SetVariable<DirectX::XMFLOAT4>("Color", pointLight.Color);
@@ -39,6 +35,18 @@ void PointLightPass::Draw(CommandList &commandList, const PointLight &pointLight
     m_Mesh->Draw(commandList);
 }
 
+Aabb PointLightPass::GetBounds(const PointLight &pointLight, float scale) const
+{
+    return Aabb::Transform(ComputeWorldMatrix(pointLight, scale), m_Mesh->GetAabb());
+}
+
+XMMATRIX PointLightPass::ComputeWorldMatrix(const PointLight &pointLight, float scale)
+{
+    XMMATRIX worldMatrix = XMMatrixTranslation(pointLight.PositionWs.x, pointLight.PositionWs.y,
+        pointLight.PositionWs.z);
+    return XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), worldMatrix);
+}
+
 PointLightPass::PointLightPass(const std::shared_ptr<CommonRootSignature> &rootSignature, CommandList &commandList)
     : m_Mesh(Mesh::CreateSphere(commandList)), m_RootSignature(rootSignature)
 {
@@ -29,6 +29,11 @@ void PointLightShadowPassPso::ClearShadowMap(CommandList& commandList) const
     commandList.ClearDepthStencilTexture(*GetShadowMapsAsTexture(), D3D12_CLEAR_FLAG_DEPTH);
 }
 
+void PointLightShadowPassPso::ClearCurrentShadowMap(CommandList& commandList) const
+{
+    commandList.ClearDepthStencilTextureArraySlice(*GetShadowMapsAsTexture(), GetCurrentSubresource(), D3D12_CLEAR_FLAG_DEPTH);
+}
+
 ShaderResourceView PointLightShadowPassPso::GetShadowMapShaderResourceView() const
 {
     const uint32_t numSubresources = m_CubeShadowMapsCount * Cubemap::SIDES_COUNT;
@@ -53,11 +58,7 @@ void PointLightShadowPassPso::ComputePassParameters(const PointLight& pointLight
     const auto& cubeSideOrientation = Cubemap::SIDE_ORIENTATIONS[m_CurrentCubeMapSideIndex];
     const auto viewMatrix = XMMatrixLookToLH(eyePosition, cubeSideOrientation.Forward, cubeSideOrientation.Up);
 
-    float rangeMultiplier = 1.0f;
-    rangeMultiplier = max(rangeMultiplier, pointLight.Color.x);
-    rangeMultiplier = max(rangeMultiplier, pointLight.Color.y);
-    rangeMultiplier = max(rangeMultiplier, pointLight.Color.z);
-    const float range = pointLight.Range * rangeMultiplier * 2.0f;
+    const float range = ComputeShadowRange(pointLight);
     const auto projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(90.0f), 1, 0.1f, range);
     const auto viewProjection = viewMatrix * projectionMatrix;
 
@@ -65,6 +66,15 @@ void PointLightShadowPassPso::ComputePassParameters(const PointLight& pointLight
     m_ShadowPassParameters.ViewProjection = viewProjection;
 }
 
+float PointLightShadowPassPso::ComputeShadowRange(const PointLight& pointLight)
+{
+    float rangeMultiplier = 1.0f;
+    rangeMultiplier = max(rangeMultiplier, pointLight.Color.x);
+    rangeMultiplier = max(rangeMultiplier, pointLight.Color.y);
+    rangeMultiplier = max(rangeMultiplier, pointLight.Color.z);
+    return pointLight.Range * rangeMultiplier * 2.0f;
+}
+
 void PointLightShadowPassPso::SetCurrentShadowMap(const uint32_t lightIndex, const uint32_t cubeMapSideIndex)
 {
     if (lightIndex >= m_CubeShadowMapsCount)
@@ -74,8 +84,10 @@ void PointLightShadowPassPso::SetCurrentShadowMap(const uint32_t lightIndex, con
     m_CurrentCubeMapSideIndex = cubeMapSideIndex;
 }
 
-void PointLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
+bool PointLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
 {
+    bool isRecreated = false;
+
     if (count > m_CubeShadowMapsCapacity && count > 0)
     {
         const uint32_t arraySize = count * Cubemap::SIDES_COUNT;
@@ -94,9 +106,11 @@ void PointLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
             L"Point Light Shadow Map Array");
         m_ShadowMapArray.AttachTexture(DepthStencil, shadowMap);
         m_CubeShadowMapsCapacity = count;
+        isRecreated = true;
     }
 
     m_CubeShadowMapsCount = count;
+    return isRecreated;
 }
 
 uint32_t PointLightShadowPassPso::GetCurrentSubresource() const
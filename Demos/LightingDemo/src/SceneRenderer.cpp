@@ -1,7 +1,9 @@
 #include <SceneRenderer.h>
+#include <algorithm>
 #include <memory>
 
 #include <DX12Library/Helpers.h>
+#include <Framework/BoundingSphere.h>
 #include <Framework/Model.h>
 #include <Framework/Mesh.h>
 #include <Framework/MatricesCb.h>
@@ -25,6 +27,8 @@ namespace
     constexpr UINT SPOT_LIGHT_SHADOW_MAPS_REGISTER_INDEX = 5;
 
     constexpr UINT ENVIRONMENT_REFLECTIONS_REGISTER_INDEX = 7;
+
+    constexpr float POINT_LIGHT_SCALE = 1.0f;
 }
 
 SceneRenderer::SceneRenderer(const std::shared_ptr<CommonRootSignature> &rootSignature, CommandList &commandList, const GraphicsSettings &graphicsSettings, DXGI_FORMAT backBufferFormat, DXGI_FORMAT depthBufferFormat)
@@ -37,7 +41,7 @@ SceneRenderer::SceneRenderer(const std::shared_ptr<CommonRootSignature> &rootSig
         // Directional Light
         const auto &directionalLightShadowsQuality = graphicsSettings.DirectionalLightShadows;
         m_DirectionalLightShadowPassPso = std::make_unique<DirectionalLightShadowPassPso>(
-            rootSignature, directionalLightShadowsQuality.m_Resolution);
+            rootSignature, directionalLightShadowsQuality.m_Resolution, graphicsSettings.DirectionalLightShadowCascades);
         m_DirectionalLightShadowPassPso->SetBias(directionalLightShadowsQuality.m_DepthBias,
             directionalLightShadowsQuality.m_NormalBias);
 
@@ -72,6 +76,13 @@ void SceneRenderer::ResetShadowMatrices()
 void SceneRenderer::SetScene(const std::shared_ptr<Scene> scene)
 {
     m_Scene = scene;
+
+    // The casters are identified by their index in the scene.
+    m_DirectionalLightShadowCasters.Invalidate();
+    m_PointLightShadowCasters.Invalidate();
+    m_SpotLightShadowCasters.Invalidate();
+    m_GameObjectBvh.Invalidate();
+    m_PointLightBvh.Invalidate();
 }
 
 void SceneRenderer::SetEnvironmentReflectionsCubemap(const std::shared_ptr<Cubemap> cubemap)
@@ -105,17 +116,50 @@ void SceneRenderer::ShadowPass(CommandList &commandList)
     PIXScope(commandList, "Shadow Pass");
     ResetShadowMatrices();
 
+    m_ShadowCasters.clear();
+    m_ShadowCasterBounds.clear();
+    for (const auto &gameObject : m_Scene->GameObjects)
+    {
+        m_ShadowCasters.push_back({ gameObject.GetAabb(), gameObject.GetWorldMatrix(), gameObject.GetModel().get() });
+        m_ShadowCasterBounds.push_back(gameObject.GetAabb());
+    }
+
+    m_DirectionalLightShadowCasters.BeginFrame(m_ShadowCasters);
+    m_PointLightShadowCasters.BeginFrame(m_ShadowCasters);
+    m_SpotLightShadowCasters.BeginFrame(m_ShadowCasters);
+
+    m_GameObjectBvh.Update(m_ShadowCasterBounds);
+
+    m_PointLightBounds.clear();
+    for (const auto &pointLight : m_Scene->PointLights)
+    {
+        m_PointLightBounds.push_back(m_PointLightPass->GetBounds(pointLight, POINT_LIGHT_SCALE));
+    }
+    m_PointLightBvh.Update(m_PointLightBounds);
+
     {
         PIXScope(commandList, "Directional Light Shadows");
 
         m_DirectionalLightShadowPassPso->Begin(commandList);
-        m_DirectionalLightShadowPassPso->ClearShadowMap(commandList);
-        m_DirectionalLightShadowPassPso->ComputePassParameters(*m_Scene, m_Scene->MainDirectionalLight);
-        m_DirectionalLightShadowPassPso->SetRenderTarget(commandList);
+        m_DirectionalLightShadowPassPso->ComputePassParameters(*m_Scene, m_Scene->MainDirectionalLight, m_Scene->MainCamera);
 
-        for (auto &gameObject : m_Scene->GameObjects)
+        for (uint32_t cascadeIndex = 0; cascadeIndex < m_DirectionalLightShadowPassPso->GetCascadesCount(); ++cascadeIndex)
         {
-            m_DirectionalLightShadowPassPso->DrawToShadowMap(commandList, gameObject);
+            m_DirectionalLightShadowPassPso->SetCurrentCascade(cascadeIndex);
+
+            const auto viewProjection = m_DirectionalLightShadowPassPso->GetShadowViewProjectionMatrix();
+            if (!m_DirectionalLightShadowCasters.CullView(cascadeIndex, viewProjection))
+            {
+                continue;
+            }
+
+            m_DirectionalLightShadowPassPso->ClearCurrentShadowMap(commandList);
+            m_DirectionalLightShadowPassPso->SetRenderTarget(commandList);
+
+            for (const uint32_t gameObjectIndex : m_DirectionalLightShadowCasters.GetVisibleCasters(cascadeIndex))
+            {
+                m_DirectionalLightShadowPassPso->DrawToShadowMap(commandList, m_Scene->GameObjects[gameObjectIndex]);
+            }
         }
 
         m_DirectionalLightShadowPassPso->End(commandList);
@@ -125,26 +169,36 @@ void SceneRenderer::ShadowPass(CommandList &commandList)
         PIXScope(commandList, "Point Light Shadows");
 
         const auto pointLightsCount = static_cast<uint32_t>(m_Scene->PointLights.size());
-        m_PointLightShadowPassPso->SetShadowMapsCount(pointLightsCount);
-        m_PointLightShadowPassPso->ClearShadowMap(commandList);
+        if (m_PointLightShadowPassPso->SetShadowMapsCount(pointLightsCount))
+        {
+            m_PointLightShadowCasters.Invalidate();
+        }
         m_PointLightShadowPassPso->Begin(commandList);
 
         for (uint32_t lightIndex = 0; lightIndex < pointLightsCount; ++lightIndex)
         {
             const PointLight &pointLight = m_Scene->PointLights[lightIndex];
+            const BoundingSphere lightRange(PointLightShadowPassPso::ComputeShadowRange(pointLight), XMLoadFloat4(&pointLight.PositionWs));
 
             for (uint32_t cubeMapSideIndex = 0; cubeMapSideIndex < Cubemap::SIDES_COUNT; ++cubeMapSideIndex)
             {
                 m_PointLightShadowPassPso->SetCurrentShadowMap(lightIndex, cubeMapSideIndex);
                 m_PointLightShadowPassPso->ComputePassParameters(pointLight);
-                m_PointLightShadowPassPso->SetRenderTarget(commandList);
 
-                for (auto &gameObject : m_Scene->GameObjects)
+                const auto viewProjection = m_PointLightShadowPassPso->GetShadowViewProjectionMatrix();
+                const uint32_t viewIndex = lightIndex * Cubemap::SIDES_COUNT + cubeMapSideIndex;
+                if (m_PointLightShadowCasters.CullView(viewIndex, viewProjection, &lightRange))
                 {
-                    m_PointLightShadowPassPso->DrawToShadowMap(commandList, gameObject);
+                    m_PointLightShadowPassPso->ClearCurrentShadowMap(commandList);
+                    m_PointLightShadowPassPso->SetRenderTarget(commandList);
+
+                    for (const uint32_t gameObjectIndex : m_PointLightShadowCasters.GetVisibleCasters(viewIndex))
+                    {
+                        m_PointLightShadowPassPso->DrawToShadowMap(commandList, m_Scene->GameObjects[gameObjectIndex]);
+                    }
                 }
 
-                m_PointLightShadowMatrices.push_back(m_PointLightShadowPassPso->GetShadowViewProjectionMatrix());
+                m_PointLightShadowMatrices.push_back(viewProjection);
             }
         }
 
@@ -154,8 +208,10 @@ void SceneRenderer::ShadowPass(CommandList &commandList)
         PIXScope(commandList, "Spot Light Shadows");
 
         const auto spotLightsCount = static_cast<uint32_t>(m_Scene->SpotLights.size());
-        m_SpotLightShadowPassPso->SetShadowMapsCount(spotLightsCount);
-        m_SpotLightShadowPassPso->ClearShadowMap(commandList);
+        if (m_SpotLightShadowPassPso->SetShadowMapsCount(spotLightsCount))
+        {
+            m_SpotLightShadowCasters.Invalidate();
+        }
         m_SpotLightShadowPassPso->Begin(commandList);
 
         for (uint32_t lightIndex = 0; lightIndex < spotLightsCount; ++lightIndex)
@@ -164,14 +220,20 @@ void SceneRenderer::ShadowPass(CommandList &commandList)
 
             m_SpotLightShadowPassPso->SetCurrentShadowMap(lightIndex);
             m_SpotLightShadowPassPso->ComputePassParameters(spotLight);
-            m_SpotLightShadowPassPso->SetRenderTarget(commandList);
 
-            for (auto &gameObject : m_Scene->GameObjects)
+            const auto viewProjection = m_SpotLightShadowPassPso->GetShadowViewProjectionMatrix();
+            if (m_SpotLightShadowCasters.CullView(lightIndex, viewProjection))
             {
-                m_SpotLightShadowPassPso->DrawToShadowMap(commandList, gameObject);
+                m_SpotLightShadowPassPso->ClearCurrentShadowMap(commandList);
+                m_SpotLightShadowPassPso->SetRenderTarget(commandList);
+
+                for (const uint32_t gameObjectIndex : m_SpotLightShadowCasters.GetVisibleCasters(lightIndex))
+                {
+                    m_SpotLightShadowPassPso->DrawToShadowMap(commandList, m_Scene->GameObjects[gameObjectIndex]);
+                }
             }
 
-            m_SpotLightShadowMatrices.push_back(m_SpotLightShadowPassPso->GetShadowViewProjectionMatrix());
+            m_SpotLightShadowMatrices.push_back(viewProjection);
         }
 
         m_SpotLightShadowPassPso->End(commandList);
@@ -198,7 +260,11 @@ void SceneRenderer::MainPass(CommandList &commandList)
         pipelineCBuffer.m_ScreenResolution = { static_cast<float>(m_Width), static_cast<float>(m_Height) };
         pipelineCBuffer.m_ScreenTexelSize = { 1.0f / static_cast<float>(m_Width), 1.0f / static_cast<float>(m_Height) };
 
-        pipelineCBuffer.m_DirectionalLightViewProjection = m_DirectionalLightShadowPassPso->GetShadowViewProjectionMatrix();
+        pipelineCBuffer.m_DirectionalLightCascadesCount = m_DirectionalLightShadowPassPso->GetCascadesCount();
+        for (uint32_t cascadeIndex = 0; cascadeIndex < pipelineCBuffer.m_DirectionalLightCascadesCount; ++cascadeIndex)
+        {
+            pipelineCBuffer.m_DirectionalLightViewProjections[cascadeIndex] = m_DirectionalLightShadowPassPso->GetCascadeViewProjectionMatrix(cascadeIndex);
+        }
         pipelineCBuffer.m_DirectionalLight = m_Scene->MainDirectionalLight;
 
         pipelineCBuffer.m_NumPointLights = static_cast<uint32_t>(m_Scene->PointLights.size());
@@ -210,14 +276,24 @@ void SceneRenderer::MainPass(CommandList &commandList)
     }
     m_RootSignature->SetPipelineConstantBuffer(commandList, pipelineCBuffer);
 
+    // The visible objects and lights, sorted to keep the scene's draw order.
+    const auto frustum = SceneBvh::Frustum::FromViewProjection(viewProjectionMatrix);
+    m_VisibleGameObjects.clear();
+    m_GameObjectBvh.Query(frustum, m_VisibleGameObjects);
+    std::sort(m_VisibleGameObjects.begin(), m_VisibleGameObjects.end());
+
+    m_VisiblePointLights.clear();
+    m_PointLightBvh.Query(frustum, m_VisiblePointLights);
+    std::sort(m_VisiblePointLights.begin(), m_VisiblePointLights.end());
+
     {
         PIXScope(commandList, "Draw Point Lights");
 
         m_PointLightPass->Begin(commandList);
 
-        for (const auto &pointLight : m_Scene->PointLights)
+        for (const uint32_t pointLightIndex : m_VisiblePointLights)
         {
-            m_PointLightPass->Draw(commandList, pointLight, viewProjectionMatrix, 1.0f);
+            m_PointLightPass->Draw(commandList, m_Scene->PointLights[pointLightIndex], viewProjectionMatrix, POINT_LIGHT_SCALE);
         }
 
         m_PointLightPass->End(commandList);
@@ -247,7 +323,7 @@ void SceneRenderer::MainPass(CommandList &commandList)
         // Bind shadow maps
         {
             m_RootSignature->SetPipelineShaderResourceView(commandList, DIRECTIONAL_LIGHT_SHADOW_MAP_REGISTER_INDEX,
-                m_PointLightShadowPassPso->GetShadowMapShaderResourceView()
+                m_DirectionalLightShadowPassPso->GetShadowMapShaderResourceView()
             );
 
             m_RootSignature->SetPipelineShaderResourceView(commandList, POINT_LIGHT_SHADOW_MAPS_REGISTER_INDEX,
@@ -268,8 +344,9 @@ void SceneRenderer::MainPass(CommandList &commandList)
             }
         }
 
-        for (const auto &go : m_Scene->GameObjects)
+        for (const uint32_t gameObjectIndex : m_VisibleGameObjects)
         {
+            const auto &go = m_Scene->GameObjects[gameObjectIndex];
             Demo::Model::CBuffer modelCBuffer{};
             modelCBuffer.Compute(go.GetWorldMatrix(), viewProjectionMatrix);
             m_RootSignature->SetModelConstantBuffer(commandList, modelCBuffer);
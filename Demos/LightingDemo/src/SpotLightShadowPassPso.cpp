@@ -24,6 +24,11 @@ void SpotLightShadowPassPso::ClearShadowMap(CommandList& commandList) const
     commandList.ClearDepthStencilTexture(*GetShadowMapsAsTexture(), D3D12_CLEAR_FLAG_DEPTH);
 }
 
+void SpotLightShadowPassPso::ClearCurrentShadowMap(CommandList& commandList) const
+{
+    commandList.ClearDepthStencilTextureArraySlice(*GetShadowMapsAsTexture(), m_CurrentLightIndex, D3D12_CLEAR_FLAG_DEPTH);
+}
+
 ShaderResourceView SpotLightShadowPassPso::GetShadowMapShaderResourceView() const
 {
     const uint32_t numSubresources = m_ShadowMapsCount;
@@ -62,8 +67,10 @@ void SpotLightShadowPassPso::SetCurrentShadowMap(const uint32_t lightIndex)
     m_CurrentLightIndex = lightIndex;
 }
 
-void SpotLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
+bool SpotLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
 {
+    bool isRecreated = false;
+
     if (count > m_ShadowMapsCapacity && count > 0)
     {
         const auto shadowMapDesc = CD3DX12_RESOURCE_DESC::Tex2D(SHADOW_MAP_FORMAT,
@@ -80,9 +87,11 @@ void SpotLightShadowPassPso::SetShadowMapsCount(const uint32_t count)
             L"Spot Light Shadow Map Array");
         m_ShadowMapArray.AttachTexture(DepthStencil, shadowMap);
         m_ShadowMapsCapacity = count;
+        isRecreated = true;
     }
 
     m_ShadowMapsCount = count;
+    return isRecreated;
 }
 
 const std::shared_ptr<Texture>& SpotLightShadowPassPso::GetShadowMapsAsTexture() const
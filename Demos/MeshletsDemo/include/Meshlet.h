@@ -31,3 +31,63 @@ struct Meshlet
     uint32_t m_VertexCount;
     uint32_t m_IndexCount;
 };
+
+/*
+ * The streams of MeshletStore: the same data as Meshlet, split by the tests that need it.
+ * Mirrored in Meshlets.hlsli.
+ */
+
+struct MeshletSphere
+{
+    DirectX::XMFLOAT3 m_Center;
+    float m_Radius;
+};
+
+struct MeshletCone
+{
+    DirectX::XMFLOAT3 m_Apex;
+    DirectX::XMFLOAT3 m_Axis;
+    float m_Cutoff; /* = cos(angle/2) */
+};
+
+struct MeshletAabb
+{
+    DirectX::XMFLOAT3 m_Center;
+    DirectX::XMFLOAT3 m_HalfSize;
+};
+
+struct MeshletDrawRange
+{
+    uint32_t m_TransformIndex;
+
+    uint32_t m_VertexOffset;
+    uint32_t m_IndexOffset;
+
+    uint32_t m_VertexCount;
+    uint32_t m_IndexCount;
+};
+
+/*
+ * A node of the cluster LOD hierarchy (see MeshletBuilder::Settings::BuildClusterLod), CPU-only.
+ * Groups of meshlets are merged, simplified and split again into the meshlets of the next level, which forms a DAG.
+ * The errors are absolute (in object space) and grow monotonically towards the roots, and so do the spheres,
+ * so that a consistent cut through the DAG can be selected for every meshlet independently.
+ */
+struct MeshletLod
+{
+    static constexpr uint32_t NO_GROUP = ~0u;
+
+    /* the sphere and the error of the group this meshlet has been simplified from (or of the meshlet itself at level 0) */
+    DirectX::XMFLOAT3 m_Center;
+    float m_Radius;
+    float m_Error;
+
+    /* the sphere and the error of the group this meshlet is simplified into, m_ParentError = FLT_MAX at the roots */
+    DirectX::XMFLOAT3 m_ParentCenter;
+    float m_ParentRadius;
+    float m_ParentError;
+
+    uint32_t m_Level;
+    uint32_t m_ChildGroup; /* the group this meshlet has been built from, NO_GROUP at level 0 */
+    uint32_t m_ParentGroup; /* NO_GROUP at the roots */
+};
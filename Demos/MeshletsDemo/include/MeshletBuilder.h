@@ -1,33 +1,71 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
-#include <Framework/Mesh.h>
-
 #include "Meshlet.h"
 
+class ThreadPool;
+
+/**
+ * Splits triangle meshes into meshlets (via meshoptimizer).
+ * Large meshes are sorted spatially and cut into partitions that are built in parallel; the partitions are then merged at precomputed offsets.
+ * The partitioning does not depend on the number of threads, so neither does the output.
+ * Does not depend on D3D12, so that it can be built and benchmarked on its own (see Tools/MeshletBenchmark).
+ */
 class MeshletBuilder
 {
 public:
-    class MeshletSet
+    struct Settings
     {
-    public:
-        MeshPrototype m_MeshPrototype;
-        std::vector<Meshlet> m_Meshlets;
-
-        MeshletSet(MeshPrototype&& meshPrototype, std::vector<Meshlet>&& meshlets)
-            : m_MeshPrototype(std::move(meshPrototype))
-            , m_Meshlets(std::move(meshlets))
-        { }
-
-        MeshletSet() = default;
-
-        void Add(const MeshletSet& other)
-        {
-            m_MeshPrototype.AddVertexAttributes(other.m_MeshPrototype);
-            m_Meshlets.insert(m_Meshlets.end(), other.m_Meshlets.begin(), other.m_Meshlets.end());
-        }
+        uint32_t MaxVertices = 64;
+        uint32_t MaxTriangles = 124;
+        float ConeWeight = 0.5f;
+
+        // Meshes with more triangles are split into partitions of this many spatially close triangles.
+        uint32_t PartitionSize = 16 * 1024;
+
+        // Build the cluster LOD hierarchy (see MeshletLod).
+        bool BuildClusterLod = false;
+        // The number of meshlets merged and simplified together.
+        uint32_t ClusterLodGroupSize = 4;
+        // Groups that do not get at least this much smaller are not simplified: their meshlets become roots.
+        float ClusterLodMinReduction = 0.85f;
+        uint32_t MaxClusterLodLevels = 16;
     };
 
-    static MeshletSet BuildMeshlets(const MeshPrototype& meshPrototype, uint32_t baseVertexOffset = 0, uint32_t baseIndexOffset = 0);
+    struct MeshView
+    {
+        // float3 positions, PositionStride bytes apart.
+        const float* Positions;
+        size_t PositionStride;
+        size_t NumVertices;
+        const uint32_t* Indices;
+        size_t NumIndices;
+    };
+
+    /**
+     * The meshlets of a mesh. The offsets of the meshlets are relative to the streams below.
+     * With the cluster LOD, the original meshlets come first, followed by the simplified levels.
+     */
+    struct Output
+    {
+        std::vector<Meshlet> Meshlets;
+        // The source vertex of every meshlet vertex.
+        std::vector<uint32_t> VertexIndices;
+        // Triangle lists indexing the vertices of their meshlet.
+        std::vector<uint32_t> Indices;
+        // One per meshlet if the cluster LOD has been built, otherwise empty.
+        std::vector<MeshletLod> Lods;
+    };
+
+    static Output BuildMeshlets(const MeshView& mesh, const Settings& settings, ThreadPool* threadPool = nullptr);
+
+    /**
+     * Whether a meshlet belongs to the LOD cut seen from the given (object-space) position:
+     * its own error is acceptable, and the error of the group it has been simplified into is not.
+     * @param maxError The acceptable error per unit of distance.
+     */
+    static bool IsInLodCut(const MeshletLod& lod, const DirectX::XMFLOAT3& viewerPosition, float maxError);
 };
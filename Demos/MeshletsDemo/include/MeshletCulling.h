@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "Meshlet.h"
+#include "MeshletStore.h"
+#include "Transform.h"
+
+class ThreadPool;
+
+/**
+ * CPU implementation of MeshletCulling_CS.hlsl: the same cone, frustum and HDB occlusion tests with the same conventions,
+ * so the results match the GPU up to floating-point rounding.
+ * Used to cull without a compute queue, and as a deterministic reference to validate the GPU culling against.
+ * Vectorized with DirectXMath (SSE/AVX2 on x64, NEON on ARM). Does not depend on D3D12.
+ */
+class MeshletCulling
+{
+public:
+    // Mirror MESHLET_FLAGS_* in Meshlets.hlsli.
+    static constexpr uint32_t FLAGS_PASSED_CONE_CULLING = 1 << 0;
+    static constexpr uint32_t FLAGS_PASSED_FRUSTUM_CULLING = 1 << 1;
+    static constexpr uint32_t FLAGS_PASSED_OCCLUSION_CULLING = 1 << 2;
+    static constexpr uint32_t FLAGS_PASSED_ALL = FLAGS_PASSED_CONE_CULLING | FLAGS_PASSED_FRUSTUM_CULLING | FLAGS_PASSED_OCCLUSION_CULLING;
+
+    static constexpr uint32_t FRUSTUM_PLANES_COUNT = 6;
+
+    // Mirrors _OcclusionCullingMode.
+    enum class OcclusionCullingMode : uint32_t
+    {
+        Aabb = 0,
+        BoundingSphere = 1,
+    };
+
+    // A CPU copy of the hierarchical depth buffer: every texel stores the maximum depth of the texels it covers in the previous mip.
+    struct HierarchicalDepthBuffer
+    {
+        uint32_t m_Width = 0;
+        uint32_t m_Height = 0;
+        // Row-major, mip i is max(m_Width >> i, 1) x max(m_Height >> i, 1).
+        std::vector<std::vector<float>> m_Mips;
+
+        // Point sampling with clamping, like g_Common_PointClampSampler.
+        float SampleLevel(float u, float v, float lod) const;
+    };
+
+    // The constants of MeshletCulling_CS.
+    struct Parameters
+    {
+        DirectX::XMFLOAT3 m_CameraPosition;
+        // Normal (xyz) and distance (w) of each plane, in the order and layout of Camera::Frustum.
+        DirectX::XMFLOAT4 m_FrustumPlanes[FRUSTUM_PLANES_COUNT];
+        DirectX::XMMATRIX m_ViewProjection;
+        OcclusionCullingMode m_OcclusionCullingMode = OcclusionCullingMode::Aabb;
+        // Occlusion culling is skipped (always passes) if null.
+        const HierarchicalDepthBuffer* m_Hdb = nullptr;
+    };
+
+    explicit MeshletCulling(const Parameters& parameters);
+
+    bool PassesConeCulling(const MeshletCone& cone, const Transform& transform) const;
+    bool PassesFrustumCulling(const MeshletSphere& sphere, const Transform& transform) const;
+    bool PassesOcclusionCulling(const MeshletSphere& sphere, const MeshletAabb& aabb, const Transform& transform) const;
+
+    /**
+     * @param transforms Indexed by MeshletDrawRange::m_TransformIndex.
+     */
+    bool IsVisible(const MeshletStore& meshlets, size_t index, const Transform* transforms) const;
+    // The results of all the tests, like the debug mode of the shader.
+    uint32_t ComputeFlags(const MeshletStore& meshlets, size_t index, const Transform* transforms) const;
+
+    /**
+     * Appends the indices of the visible meshlets in increasing order (unlike the GPU, which appends them in any order).
+     * @param transforms Indexed by MeshletDrawRange::m_TransformIndex.
+     */
+    void Cull(const MeshletStore& meshlets, const Transform* transforms,
+        std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool = nullptr) const;
+
+    // The same for an array of structures, to compare the layouts (see MeshletBenchmark --culling).
+    bool IsVisible(const Meshlet& meshlet, const Transform& transform) const;
+    void Cull(const Meshlet* meshlets, size_t count, const Transform* transforms,
+        std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool = nullptr) const;
+
+private:
+    struct BoundingSquare
+    {
+        float m_MinU;
+        float m_MinV;
+        float m_MaxU;
+        float m_MaxV;
+        float m_MinNdcDepth;
+    };
+
+    BoundingSquare ComputeScreenSpaceBoundingSquare(const DirectX::XMVECTOR* vertices) const;
+
+    template <typename IsVisibleFunction>
+    void CullBatches(size_t count, const IsVisibleFunction& isVisible, std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool) const;
+
+    // The frustum planes transposed into 4-wide registers: planes 0-3 and 4-5 (the latter repeated).
+    DirectX::XMVECTOR m_PlaneNormalsX[2];
+    DirectX::XMVECTOR m_PlaneNormalsY[2];
+    DirectX::XMVECTOR m_PlaneNormalsZ[2];
+    DirectX::XMVECTOR m_PlaneDistances[2];
+
+    DirectX::XMVECTOR m_CameraPosition;
+    DirectX::XMMATRIX m_ViewProjection;
+    OcclusionCullingMode m_OcclusionCullingMode;
+    const HierarchicalDepthBuffer* m_Hdb;
+};
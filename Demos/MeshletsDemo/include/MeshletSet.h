@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include <Framework/Mesh.h>
+
+#include "Meshlet.h"
+#include "MeshletBuilder.h"
+#include "MeshletStore.h"
+
+class ThreadPool;
+
+// The shared vertex, index and meshlet streams of all the meshlet-rendered meshes.
+class MeshletSet
+{
+public:
+    MeshPrototype m_MeshPrototype;
+    MeshletStore m_Meshlets;
+    // One per meshlet if the cluster LOD has been built for every mesh, otherwise empty.
+    std::vector<MeshletLod> m_MeshletLods;
+
+    /**
+     * Appends the meshlets of the meshes of a model, in order.
+     * The streams are resized once and the meshes are copied in parallel at precomputed offsets.
+     * @param outputs The meshlets of meshPrototypes (see MeshletBuilder::BuildMeshlets).
+     * @return The offset of the first meshlet of every mesh.
+     */
+    std::vector<uint32_t> Add(const std::vector<MeshPrototype>& meshPrototypes,
+        const std::vector<MeshletBuilder::Output>& outputs,
+        uint32_t transformIndex, ThreadPool* threadPool = nullptr);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Meshlet.h"
+
+/**
+ * Meshlets as a structure of arrays: one stream per kind of data (see Meshlet.h).
+ * A culling pass only touches the streams its tests need, e.g., the frustum test reads 16 bytes per meshlet instead of a whole Meshlet.
+ * The streams are uploaded as they are into the structured buffers of Meshlets.hlsli.
+ */
+class MeshletStore
+{
+public:
+    std::vector<MeshletSphere> m_Spheres;
+    std::vector<MeshletCone> m_Cones;
+    std::vector<MeshletAabb> m_Aabbs;
+    std::vector<MeshletDrawRange> m_DrawRanges;
+
+    size_t GetCount() const { return m_DrawRanges.size(); }
+    bool IsEmpty() const { return m_DrawRanges.empty(); }
+
+    void Reserve(size_t count);
+    void Resize(size_t count);
+
+    void Set(size_t index, const Meshlet& meshlet);
+    Meshlet Get(size_t index) const;
+    void Add(const Meshlet& meshlet);
+};
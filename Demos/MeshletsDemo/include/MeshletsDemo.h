@@ -9,6 +9,7 @@
 #include <DX12Library/Texture.h>
 #include <DX12Library/VertexBuffer.h>
 #include <DX12Library/StructuredBuffer.h>
+#include <DX12Library/ThreadPool.h>
 
 #include <Framework/ImGuiImpl.h>
 #include <Framework/GameObject.h>
@@ -22,7 +23,7 @@
 #include <RenderGraph/RenderGraphRoot.h>
 
 #include "Meshlet.h"
-#include "MeshletBuilder.h"
+#include "MeshletSet.h"
 #include "Transform.h"
 
 namespace RenderGraph
@@ -57,7 +58,7 @@ private:
     Camera m_Camera;
     std::vector<GameObject> m_MeshletGameObjects;
     std::vector<Transform> m_TransformsBuffer;
-    MeshletBuilder::MeshletSet m_MeshletsBuffer;
+    MeshletSet m_MeshletsBuffer;
     std::shared_ptr<Material> m_MeshletDrawMaterial;
     DirectionalLight m_DirectionalLight;
     DirectX::XMVECTOR m_CullingCameraPosition;
@@ -73,6 +74,9 @@ private:
 
     std::unique_ptr<RenderGraph::RenderGraphRoot> m_RenderGraph;
 
+    // Builds the meshlets, and culls them when m_CpuCulling is on.
+    ThreadPool m_ThreadPool;
+
     std::shared_ptr<CommonRootSignature> m_RootSignature;
 
     D3D12_VIEWPORT m_Viewport;
@@ -96,6 +100,8 @@ private:
     bool m_FreezeCulling = false;
     uint32_t m_OcclusionCullingMode = 0;
     bool m_DebugGpuCulling = false;
+    // Cull the meshlets with MeshletCulling instead of the compute shader (without occlusion culling: the HDB is not read back).
+    bool m_CpuCulling = false;
     bool m_RenderOccluders = true;
 
     struct
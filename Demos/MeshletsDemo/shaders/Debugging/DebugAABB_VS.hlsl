@@ -12,11 +12,11 @@ float2 UvToNdc(const float2 uv)
 
 float4 main(const CommonVertexAttributes IN) : SV_POSITION
 {
-    const Meshlet meshlet = _MeshletsBuffer[g_Pipeline_SelectedMeshletIndex];
-    const MeshletBounds bounds = meshlet.bounds;
-    const Transform transform = _TransformsBuffer[meshlet.transformIndex];
+    const MeshletDrawRange drawRange = _MeshletDrawRanges[g_Pipeline_SelectedMeshletIndex];
+    const MeshletAabb aabbOs = _MeshletAabbs[g_Pipeline_SelectedMeshletIndex];
+    const Transform transform = _TransformsBuffer[drawRange.transformIndex];
 
-    const float3 positionOs = IN.position.xyz * bounds.aabbHalfSize + bounds.aabbCenter;
+    const float3 positionOs = IN.position.xyz * aabbOs.halfSize + aabbOs.center;
     const float4 positionWs = mul(transform.worldMatrix, float4(positionOs, 1.0f));
     return mul(g_Pipeline_ViewProjection, positionWs);
 }
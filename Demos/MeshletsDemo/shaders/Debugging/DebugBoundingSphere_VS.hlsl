@@ -3,10 +3,10 @@
 
 float4 main(const CommonVertexAttributes IN) : SV_POSITION
 {
-    const Meshlet meshlet = _MeshletsBuffer[g_Pipeline_SelectedMeshletIndex];
-    const MeshletBounds bounds = meshlet.bounds;
-    const Transform transform = _TransformsBuffer[meshlet.transformIndex];
-    const float3 positionOs = IN.position.xyz * bounds.radius + bounds.center;
+    const MeshletDrawRange drawRange = _MeshletDrawRanges[g_Pipeline_SelectedMeshletIndex];
+    const MeshletSphere sphere = _MeshletSpheres[g_Pipeline_SelectedMeshletIndex];
+    const Transform transform = _TransformsBuffer[drawRange.transformIndex];
+    const float3 positionOs = IN.position.xyz * sphere.radius + sphere.center;
     const float4 positionWs = mul(transform.worldMatrix, float4(positionOs, 1.0f));
     return mul(g_Pipeline_ViewProjection, positionWs);
 }
@@ -14,15 +14,16 @@ float2 UvToNdc(const float2 uv)
 
 float4 main(const CommonVertexAttributes IN) : SV_POSITION
 {
-    const Meshlet meshlet = _MeshletsBuffer[g_Pipeline_SelectedMeshletIndex];
-    const MeshletBounds bounds = meshlet.bounds;
-    const Transform transform = _TransformsBuffer[meshlet.transformIndex];
+    const MeshletDrawRange drawRange = _MeshletDrawRanges[g_Pipeline_SelectedMeshletIndex];
+    const MeshletAabb aabbOs = _MeshletAabbs[g_Pipeline_SelectedMeshletIndex];
+    const MeshletSphere sphere = _MeshletSpheres[g_Pipeline_SelectedMeshletIndex];
+    const Transform transform = _TransformsBuffer[drawRange.transformIndex];
 
 #if USE_AABB == 1
-    const AABB aabb = AABBObjectToWorldSpace(bounds.aabbCenter, bounds.aabbHalfSize, transform.worldMatrix);
+    const AABB aabb = AABBObjectToWorldSpace(aabbOs.center, aabbOs.halfSize, transform.worldMatrix);
     const BoundingSquareSS boundingSquare = ComputeScreenSpaceBoundingSquareFromAABB(aabb, g_Pipeline_ViewProjection);
 #else
-    const BoundingSphere boundingSphere = BoundingSphereObjectToWorldSpace(bounds.center, bounds.radius, transform.worldMatrix);
+    const BoundingSphere boundingSphere = BoundingSphereObjectToWorldSpace(sphere.center, sphere.radius, transform.worldMatrix);
     const BoundingSquareSS boundingSquare = ComputeScreenSpaceBoundingSquareFromSphere(boundingSphere, g_Pipeline_ViewProjection);
 #endif
 
@@ -33,25 +33,25 @@ cbuffer CBuffer : register(b0)
     uint _Debug;
 }
 
+// The streams are loaded by the tests that need them, so a meshlet rejected early does not fetch the rest.
 struct MeshletInfo
 {
-    Meshlet meshlet;
+    uint index;
     Transform transform;
     BoundingSphere boundingSphere;
-    AABB aabb;
 };
 
 bool ConeCulling(const MeshletInfo meshletInfo)
 {
     const Transform transform = meshletInfo.transform;
-    const Meshlet meshlet = meshletInfo.meshlet;
-    const float3 coneApex = mul(transform.worldMatrix, float4(meshlet.bounds.coneApex, 1.0f)).xyz;
-    const float3 coneAxis = mul((float3x3) transform.inverseTransposeWorldMatrix, meshlet.bounds.coneAxis);
+    const MeshletCone cone = _MeshletCones[meshletInfo.index];
+    const float3 coneApex = mul(transform.worldMatrix, float4(cone.apex, 1.0f)).xyz;
+    const float3 coneAxis = mul((float3x3) transform.inverseTransposeWorldMatrix, cone.axis);
 
     const float dotResult = dot(normalize(coneApex - _CameraPosition), normalize(coneAxis));
     // using !>= handles the case when the meshlet's coneAxis is (0, 0, 0)
     // dotResult stores NaN in this case
-    return !(dotResult >= meshlet.bounds.coneCutoff);
+    return !(dotResult >= cone.cutoff);
 }
 
 float DistanceToPlane(const float4 plane, const float3 position)
@@ -93,7 +93,9 @@ bool OcclusionCullingBoundingSphere(const MeshletInfo meshletInfo)
 
 bool OcclusionCullingAABB(const MeshletInfo meshletInfo)
 {
-    const BoundingSquareSS boundingSquare = ComputeScreenSpaceBoundingSquareFromAABB(meshletInfo.aabb, _ViewProjection);
+    const MeshletAabb aabbOs = _MeshletAabbs[meshletInfo.index];
+    const AABB aabb = AABBObjectToWorldSpace(aabbOs.center, aabbOs.halfSize, meshletInfo.transform.worldMatrix);
+    const BoundingSquareSS boundingSquare = ComputeScreenSpaceBoundingSquareFromAABB(aabb, _ViewProjection);
     return OcclusionCulling(boundingSquare);
 }
 
@@ -111,9 +113,10 @@ bool OcclusionCulling(const MeshletInfo meshletInfo)
 
 bool Culling(const MeshletInfo meshletInfo)
 {
+    // the frustum test goes first: it rejects the most meshlets and only needs the sphere
     return
-    ConeCulling(meshletInfo) &&
     FrustumCulling(meshletInfo) &&
+    ConeCulling(meshletInfo) &&
     OcclusionCulling(meshletInfo);
 }
 
@@ -126,18 +129,18 @@ void main(in uint3 dispatchId : SV_DispatchThreadID)
         return;
     }
 
-    const Meshlet meshlet = _MeshletsBuffer[meshletIndex];
-    const Transform transform = _TransformsBuffer[meshlet.transformIndex];
-    const BoundingSphere boundingSphere = BoundingSphereObjectToWorldSpace(meshlet.bounds.center, meshlet.bounds.radius, transform.worldMatrix);
-    const AABB aabb = AABBObjectToWorldSpace(meshlet.bounds.aabbCenter, meshlet.bounds.aabbHalfSize, transform.worldMatrix);
-    const MeshletInfo meshletInfo = { meshlet, transform, boundingSphere, aabb };
+    const MeshletDrawRange drawRange = _MeshletDrawRanges[meshletIndex];
+    const MeshletSphere sphere = _MeshletSpheres[meshletIndex];
+    const Transform transform = _TransformsBuffer[drawRange.transformIndex];
+    const BoundingSphere boundingSphere = BoundingSphereObjectToWorldSpace(sphere.center, sphere.radius, transform.worldMatrix);
+    const MeshletInfo meshletInfo = { meshletIndex, transform, boundingSphere };
 
     [branch]
     if (_Debug || Culling(meshletInfo))
     {
         IndirectCommand indirectCommand;
         indirectCommand.meshletIndex = meshletIndex;
-        indirectCommand.drawArguments.VertexCountPerInstance = meshlet.indexCount;
+        indirectCommand.drawArguments.VertexCountPerInstance = drawRange.indexCount;
         indirectCommand.drawArguments.InstanceCount = 1;
         indirectCommand.drawArguments.StartVertexLocation = 0;
         indirectCommand.drawArguments.StartInstanceLocation = 0;
@@ -4,22 +4,9 @@
 
 #include "Meshlet_VertexShaderOutput.hlsli"
 
-uint AlignDown(uint value, const uint alignment, out uint outRemainder)
+uint LoadIndex(const in MeshletDrawRange drawRange, uint vertexId)
 {
-    outRemainder = value % alignment;
-    value -= outRemainder;
-    return value;
-}
-
-uint LoadIndex(const in Meshlet meshlet, uint vertexId)
-{
-    uint remainder;
-    const uint address = AlignDown((meshlet.indexOffset + vertexId) * 2, 4, remainder);
-    const uint index = _CommonIndexBuffer.Load<uint>(address);
-    // the remainder is either 0 or 2
-    const uint shift = remainder * 8;
-    const uint mask = 0xFFFF << shift;
-    return (index & mask) >> shift;
+    return _CommonIndexBuffer.Load<uint>((drawRange.indexOffset + vertexId) * 4);
 }
 
 VertexShaderOutput main(
@@ -28,11 +15,11 @@ VertexShaderOutput main(
 {
     VertexShaderOutput OUT;
 
-    const Meshlet meshlet = _MeshletsBuffer[g_Meshlet_Index];
-    const uint index = LoadIndex(meshlet, id);
-    const CommonVertexAttributes IN = _CommonVertexBuffer[meshlet.vertexOffset + index];
+    const MeshletDrawRange drawRange = _MeshletDrawRanges[g_Meshlet_Index];
+    const uint index = LoadIndex(drawRange, id);
+    const CommonVertexAttributes IN = _CommonVertexBuffer[drawRange.vertexOffset + index];
 
-    Transform transform = _TransformsBuffer[meshlet.transformIndex];
+    Transform transform = _TransformsBuffer[drawRange.transformIndex];
 
     OUT.NormalWS = mul((float3x3) transform.inverseTransposeWorldMatrix, IN.normal.xyz);
 
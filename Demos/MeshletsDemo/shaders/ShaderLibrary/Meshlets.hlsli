@@ -5,25 +5,34 @@
 
 #include "CommonVertexAttributes.hlsli"
 
-struct MeshletBounds
+/*
+ * The meshlets are stored as a structure of arrays (see MeshletStore.h):
+ * every pass only loads the streams it needs.
+ */
+
+/* bounding sphere, useful for frustum and occlusion culling */
+struct MeshletSphere
 {
-    /* bounding sphere, useful for frustum and occlusion culling */
     float3 center;
     float radius;
+};
 
-    /* normal cone, useful for backface culling */
-    float3 coneApex;
-    float3 coneAxis;
-    float coneCutoff; /* = cos(angle/2) */
-
-    float3 aabbCenter;
-    float3 aabbHalfSize;
+/* normal cone, useful for backface culling */
+struct MeshletCone
+{
+    float3 apex;
+    float3 axis;
+    float cutoff; /* = cos(angle/2) */
 };
 
-struct Meshlet
+struct MeshletAabb
 {
-    MeshletBounds bounds;
+    float3 center;
+    float3 halfSize;
+};
 
+struct MeshletDrawRange
+{
     uint transformIndex;
 
     uint vertexOffset;
@@ -41,8 +50,11 @@ struct Transform
 
 StructuredBuffer<CommonVertexAttributes> _CommonVertexBuffer : register(t0, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 ByteAddressBuffer _CommonIndexBuffer : register(t1, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
-StructuredBuffer<Meshlet> _MeshletsBuffer : register(t2, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+StructuredBuffer<MeshletSphere> _MeshletSpheres : register(t2, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 StructuredBuffer<Transform> _TransformsBuffer : register(t3, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+StructuredBuffer<MeshletCone> _MeshletCones : register(t4, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+StructuredBuffer<MeshletAabb> _MeshletAabbs : register(t5, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
+StructuredBuffer<MeshletDrawRange> _MeshletDrawRanges : register(t6, COMMON_ROOT_SIGNATURE_PIPELINE_SPACE);
 
 ROOT_CONSTANTS_BEGIN
     uint g_Meshlet_Index;
@@ -1,11 +1,56 @@
 #include "MeshletBuilder.h"
 
+#include <DX12Library/ThreadPool.h>
+
 #include <meshoptimizer.h>
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
 using namespace DirectX;
 
 namespace
 {
+    using Output = MeshletBuilder::Output;
+    using Settings = MeshletBuilder::Settings;
+    using MeshView = MeshletBuilder::MeshView;
+
+    struct Sphere
+    {
+        XMFLOAT3 Center;
+        float Radius;
+    };
+
+    // The result of merging and simplifying a group of meshlets.
+    struct SimplifiedGroup
+    {
+        bool IsSimplified = false;
+        Output Meshlets;
+        Sphere Bounds{};
+        float Error = 0.0f;
+    };
+
+    void ForEach(const size_t count, const std::function<void(size_t)>& function, ThreadPool* threadPool)
+    {
+        if (threadPool != nullptr && count > 1)
+        {
+            threadPool->ParallelFor(count, function);
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            function(i);
+        }
+    }
+
+    const float* GetPosition(const MeshView& mesh, const uint32_t vertexIndex)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(mesh.Positions) + vertexIndex * mesh.PositionStride);
+    }
+
     void CopyFloatArrayToDirectXFloat3(XMFLOAT3& destination, const float source[3])
     {
         destination.x = source[0];
@@ -13,110 +58,434 @@ namespace
         destination.z = source[2];
     }
 
-    void ComputeMeshletAabb(MeshletBounds& bounds, const meshopt_Meshlet& meshlet,
-        const std::vector<unsigned int>& vertices,
-        const std::vector<unsigned char>& indices,
-        const std::vector<VertexAttributes>& vertexAttributes
-    )
+    // Every vertex of a meshlet is referenced by its triangles, so the AABB of the vertices is the AABB of the triangles.
+    void ComputeMeshletAabb(MeshletBounds& bounds, const MeshView& mesh, const unsigned int* vertices, const size_t vertexCount)
+    {
+        float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const float* position = GetPosition(mesh, vertices[i]);
+
+            for (size_t axis = 0; axis < 3; ++axis)
+            {
+                min[axis] = std::min(min[axis], position[axis]);
+                max[axis] = std::max(max[axis], position[axis]);
+            }
+        }
+
+        bounds.m_AabbHalfSize = { (max[0] - min[0]) * 0.5f, (max[1] - min[1]) * 0.5f, (max[2] - min[2]) * 0.5f };
+        bounds.m_AabbCenter = { min[0] + bounds.m_AabbHalfSize.x, min[1] + bounds.m_AabbHalfSize.y, min[2] + bounds.m_AabbHalfSize.z };
+    }
+
+    // Builds the meshlets of a triangle list that references the vertices of the mesh.
+    Output BuildPartition(const MeshView& mesh, const uint32_t* indices, const size_t numIndices, const Settings& settings)
+    {
+        Output output;
+
+        if (numIndices == 0)
+        {
+            return output;
+        }
+
+        // Worst-case scratch buffers, bounded by the size of the partition.
+        const size_t maxMeshlets = meshopt_buildMeshletsBound(numIndices, settings.MaxVertices, settings.MaxTriangles);
+        std::vector<meshopt_Meshlet> meshoptMeshlets(maxMeshlets);
+        std::vector<unsigned int> vertices(maxMeshlets * settings.MaxVertices);
+        std::vector<unsigned char> triangles(maxMeshlets * settings.MaxTriangles * 3);
+
+        const size_t meshletCount = meshopt_buildMeshlets(meshoptMeshlets.data(),
+            vertices.data(), triangles.data(),
+            indices, numIndices,
+            mesh.Positions, mesh.NumVertices, mesh.PositionStride,
+            settings.MaxVertices, settings.MaxTriangles, settings.ConeWeight
+        );
+
+        size_t numMeshletVertices = 0;
+        size_t numMeshletIndices = 0;
+        for (size_t i = 0; i < meshletCount; ++i)
+        {
+            numMeshletVertices += meshoptMeshlets[i].vertex_count;
+            numMeshletIndices += meshoptMeshlets[i].triangle_count * 3;
+        }
+
+        output.Meshlets.resize(meshletCount);
+        output.VertexIndices.reserve(numMeshletVertices);
+        output.Indices.reserve(numMeshletIndices);
+
+        for (size_t i = 0; i < meshletCount; ++i)
+        {
+            const meshopt_Meshlet& meshoptMeshlet = meshoptMeshlets[i];
+            const unsigned int* meshletVertices = &vertices[meshoptMeshlet.vertex_offset];
+            const unsigned char* meshletTriangles = &triangles[meshoptMeshlet.triangle_offset];
+
+            Meshlet& meshlet = output.Meshlets[i];
+            meshlet.m_TransformIndex = -1;
+
+            {
+                const meshopt_Bounds meshoptBounds = meshopt_computeMeshletBounds(
+                    meshletVertices, meshletTriangles, meshoptMeshlet.triangle_count,
+                    mesh.Positions, mesh.NumVertices, mesh.PositionStride
+                );
+                MeshletBounds& bounds = meshlet.m_Bounds;
+
+                CopyFloatArrayToDirectXFloat3(bounds.m_Center, meshoptBounds.center);
+                bounds.m_Radius = meshoptBounds.radius;
+
+                CopyFloatArrayToDirectXFloat3(bounds.m_ConeApex, meshoptBounds.cone_apex);
+                CopyFloatArrayToDirectXFloat3(bounds.m_ConeAxis, meshoptBounds.cone_axis);
+                bounds.m_ConeCutoff = meshoptBounds.cone_cutoff;
+
+                ComputeMeshletAabb(bounds, mesh, meshletVertices, meshoptMeshlet.vertex_count);
+            }
+
+            {
+                meshlet.m_VertexOffset = static_cast<uint32_t>(output.VertexIndices.size());
+                meshlet.m_VertexCount = meshoptMeshlet.vertex_count;
+                meshlet.m_IndexOffset = static_cast<uint32_t>(output.Indices.size());
+                meshlet.m_IndexCount = meshoptMeshlet.triangle_count * 3;
+            }
+
+            output.VertexIndices.insert(output.VertexIndices.end(), meshletVertices, meshletVertices + meshoptMeshlet.vertex_count);
+            output.Indices.insert(output.Indices.end(), meshletTriangles, meshletTriangles + meshoptMeshlet.triangle_count * 3);
+        }
+
+        return output;
+    }
+
+    // Appends the parts at precomputed offsets: every stream is resized once, and the parts are copied in parallel.
+    void Append(Output& output, std::vector<Output>& parts, ThreadPool* threadPool)
     {
-        XMVECTOR min = XMVectorReplicate(FLT_MAX);
-        XMVECTOR max = XMVectorReplicate(-FLT_MAX);
+        struct Offsets
+        {
+            size_t Meshlets;
+            size_t VertexIndices;
+            size_t Indices;
+        };
 
-        const uint32_t indexCount = meshlet.triangle_count * 3;
+        std::vector<Offsets> offsets(parts.size());
+        Offsets total = { output.Meshlets.size(), output.VertexIndices.size(), output.Indices.size() };
 
-        for (uint32_t i = 0; i < indexCount; ++i)
+        for (size_t i = 0; i < parts.size(); ++i)
         {
-            const auto index = indices[meshlet.triangle_offset + i];
-            const auto& vertex = vertexAttributes[vertices[meshlet.vertex_offset + index]];
+            offsets[i] = total;
+            total.Meshlets += parts[i].Meshlets.size();
+            total.VertexIndices += parts[i].VertexIndices.size();
+            total.Indices += parts[i].Indices.size();
+        }
 
-            const XMVECTOR position = XMLoadFloat4(&vertex.Position);
-            min = XMVectorMin(position, min);
-            max = XMVectorMax(position, max);
+        const bool hasLods = !output.Lods.empty();
+        output.Meshlets.resize(total.Meshlets);
+        output.VertexIndices.resize(total.VertexIndices);
+        output.Indices.resize(total.Indices);
+        if (hasLods)
+        {
+            output.Lods.resize(total.Meshlets);
         }
 
-        const auto halfSize = (max - min) * 0.5f;
-        XMStoreFloat3(&bounds.m_AabbCenter, min + halfSize);
-        XMStoreFloat3(&bounds.m_AabbHalfSize, halfSize);
+        ForEach(parts.size(), [&](const size_t partIndex)
+            {
+                Output& part = parts[partIndex];
+                const Offsets& partOffsets = offsets[partIndex];
+
+                std::copy(part.VertexIndices.begin(), part.VertexIndices.end(), output.VertexIndices.begin() + partOffsets.VertexIndices);
+                std::copy(part.Indices.begin(), part.Indices.end(), output.Indices.begin() + partOffsets.Indices);
+
+                for (size_t i = 0; i < part.Meshlets.size(); ++i)
+                {
+                    Meshlet& meshlet = output.Meshlets[partOffsets.Meshlets + i];
+                    meshlet = part.Meshlets[i];
+                    meshlet.m_VertexOffset += static_cast<uint32_t>(partOffsets.VertexIndices);
+                    meshlet.m_IndexOffset += static_cast<uint32_t>(partOffsets.Indices);
+                }
+
+                if (hasLods)
+                {
+                    std::copy(part.Lods.begin(), part.Lods.end(), output.Lods.begin() + partOffsets.Meshlets);
+                }
+
+                part = {};
+            }, threadPool
+        );
     }
 
-}
+    float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        const float dx = a.x - b.x;
+        const float dy = a.y - b.y;
+        const float dz = a.z - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
 
-MeshletBuilder::MeshletSet MeshletBuilder::BuildMeshlets(const MeshPrototype& meshPrototype, uint32_t baseVertexOffset, uint32_t baseIndexOffset)
-{
-    constexpr size_t maxVertices = 64;
-    constexpr size_t maxTriangles = 124;
-    constexpr float coneWeight = 0.5f;
-
-    const size_t maxMeshlets = meshopt_buildMeshletsBound(meshPrototype.m_Indices.size(), maxVertices, maxTriangles);
-    std::vector<meshopt_Meshlet> meshoptMeshlets(maxMeshlets);
-    std::vector<unsigned int> vertices(maxMeshlets * maxVertices);
-    std::vector<unsigned char> indices(maxMeshlets * maxTriangles * 3);
-
-    const size_t meshletCount = meshopt_buildMeshlets(meshoptMeshlets.data(),
-        vertices.data(), indices.data(),
-        meshPrototype.m_Indices.data(), meshPrototype.m_Indices.size(),
-        &meshPrototype.m_Vertices[0].Position.x, meshPrototype.m_Vertices.size(), sizeof(VertexAttributes),
-        maxVertices, maxTriangles, coneWeight
-    );
-
-    // trim
-    const meshopt_Meshlet& last = meshoptMeshlets[meshletCount - 1];
-    std::vector<Meshlet> meshlets(meshletCount);
-    vertices.resize(last.vertex_offset + last.vertex_count);
-    indices.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
-
-    for (size_t i = 0; i < meshlets.size(); ++i)
-    {
-        const meshopt_Meshlet& meshoptMeshlet = meshoptMeshlets[i];
-        Meshlet meshlet;
-        meshlet.m_TransformIndex = -1;
-
-        {
-            const meshopt_Bounds meshoptBounds = meshopt_computeMeshletBounds(
-                &vertices[meshoptMeshlet.vertex_offset],
-                &indices[meshoptMeshlet.triangle_offset],
-                meshoptMeshlet.triangle_count,
-                &meshPrototype.m_Vertices[0].Position.x, meshPrototype.m_Vertices.size(), sizeof(VertexAttributes)
-            );
-            MeshletBounds& bounds = meshlet.m_Bounds;
+    // A sphere enclosing all the spheres (not the minimal one).
+    Sphere MergeSpheres(const std::vector<Sphere>& spheres)
+    {
+        XMFLOAT3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+        XMFLOAT3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (const Sphere& sphere : spheres)
+        {
+            min = { std::min(min.x, sphere.Center.x - sphere.Radius), std::min(min.y, sphere.Center.y - sphere.Radius), std::min(min.z, sphere.Center.z - sphere.Radius) };
+            max = { std::max(max.x, sphere.Center.x + sphere.Radius), std::max(max.y, sphere.Center.y + sphere.Radius), std::max(max.z, sphere.Center.z + sphere.Radius) };
+        }
+
+        Sphere result;
+        result.Center = { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f };
+        result.Radius = 0.0f;
+
+        for (const Sphere& sphere : spheres)
+        {
+            result.Radius = std::max(result.Radius, Distance(result.Center, sphere.Center) + sphere.Radius);
+        }
+
+        return result;
+    }
+
+    // Spatially close meshlets of [begin, end) in groups of groupSize.
+    std::vector<std::vector<uint32_t>> GroupMeshlets(const Output& output, const size_t begin, const size_t end, const uint32_t groupSize)
+    {
+        const size_t count = end - begin;
+
+        std::vector<XMFLOAT3> centers(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            centers[i] = output.Lods[begin + i].m_Center;
+        }
+
+        // Maps the old positions to the new ones.
+        std::vector<unsigned int> remap(count);
+        meshopt_spatialSortRemap(remap.data(), &centers[0].x, count, sizeof(XMFLOAT3));
+
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            order[remap[i]] = static_cast<uint32_t>(begin + i);
+        }
+
+        std::vector<std::vector<uint32_t>> groups;
+        groups.reserve((count + groupSize - 1) / groupSize);
+
+        for (size_t i = 0; i < count; i += groupSize)
+        {
+            const size_t groupEnd = std::min<size_t>(i + groupSize, count);
+            groups.emplace_back(order.begin() + i, order.begin() + groupEnd);
+        }
+
+        return groups;
+    }
 
-            CopyFloatArrayToDirectXFloat3(bounds.m_Center, meshoptBounds.center);
-            bounds.m_Radius = meshoptBounds.radius;
+    void SimplifyGroup(const MeshView& mesh, const Output& output, const std::vector<uint32_t>& group, const Settings& settings, SimplifiedGroup& result)
+    {
+        // The triangles of the group, indexing the vertices of the mesh.
+        std::vector<uint32_t> indices;
+        for (const uint32_t meshletIndex : group)
+        {
+            const Meshlet& meshlet = output.Meshlets[meshletIndex];
+
+            for (uint32_t i = 0; i < meshlet.m_IndexCount; ++i)
+            {
+                indices.push_back(output.VertexIndices[meshlet.m_VertexOffset + output.Indices[meshlet.m_IndexOffset + i]]);
+            }
+        }
+
+        // Simplify a compact copy of the vertices, so that the cost does not depend on the size of the whole mesh.
+        std::vector<uint32_t> groupVertices = indices;
+        std::sort(groupVertices.begin(), groupVertices.end());
+        groupVertices.erase(std::unique(groupVertices.begin(), groupVertices.end()), groupVertices.end());
+
+        std::vector<float> positions(groupVertices.size() * 3);
+        for (size_t i = 0; i < groupVertices.size(); ++i)
+        {
+            std::copy_n(GetPosition(mesh, groupVertices[i]), 3, positions.data() + i * 3);
+        }
 
-            CopyFloatArrayToDirectXFloat3(bounds.m_ConeApex, meshoptBounds.cone_apex);
-            CopyFloatArrayToDirectXFloat3(bounds.m_ConeAxis, meshoptBounds.cone_axis);
-            bounds.m_ConeCutoff = meshoptBounds.cone_cutoff;
+        for (uint32_t& index : indices)
+        {
+            index = static_cast<uint32_t>(std::lower_bound(groupVertices.begin(), groupVertices.end(), index) - groupVertices.begin());
+        }
+
+        // The borders are shared with the neighbouring groups: locking them keeps the levels crack-free.
+        const size_t targetIndexCount = indices.size() / 2 / 3 * 3;
+        std::vector<uint32_t> simplifiedIndices(indices.size());
+        float relativeError = 0.0f;
+        const size_t indexCount = meshopt_simplify(simplifiedIndices.data(), indices.data(), indices.size(),
+            positions.data(), groupVertices.size(), sizeof(float) * 3,
+            targetIndexCount, FLT_MAX, meshopt_SimplifyLockBorder, &relativeError
+        );
+
+        if (indexCount == 0 || static_cast<float>(indexCount) > static_cast<float>(indices.size()) * settings.ClusterLodMinReduction)
+        {
+            return;
+        }
+
+        simplifiedIndices.resize(indexCount);
+        for (uint32_t& index : simplifiedIndices)
+        {
+            index = groupVertices[index];
+        }
 
-            ComputeMeshletAabb(bounds, meshoptMeshlet, vertices, indices, meshPrototype.m_Vertices);
+        // Include the errors of the children, so that the error never decreases towards the roots.
+        float childError = 0.0f;
+        std::vector<Sphere> childSpheres;
+        childSpheres.reserve(group.size());
+        for (const uint32_t meshletIndex : group)
+        {
+            const MeshletLod& lod = output.Lods[meshletIndex];
+            childError = std::max(childError, lod.m_Error);
+            childSpheres.push_back({ lod.m_Center, lod.m_Radius });
         }
 
+        const float scale = meshopt_simplifyScale(positions.data(), groupVertices.size(), sizeof(float) * 3);
+
+        result.IsSimplified = true;
+        result.Error = childError + relativeError * scale;
+        result.Bounds = MergeSpheres(childSpheres);
+        result.Meshlets = BuildPartition(mesh, simplifiedIndices.data(), simplifiedIndices.size(), settings);
+    }
+
+    void BuildClusterLod(const MeshView& mesh, const Settings& settings, ThreadPool* threadPool, Output& output)
+    {
+        output.Lods.resize(output.Meshlets.size());
+        for (size_t i = 0; i < output.Meshlets.size(); ++i)
         {
+            const MeshletBounds& bounds = output.Meshlets[i].m_Bounds;
 
-            meshlet.m_VertexOffset = baseVertexOffset + meshoptMeshlet.vertex_offset;
-            meshlet.m_VertexCount = meshoptMeshlet.vertex_count;
-            meshlet.m_IndexOffset = baseIndexOffset + meshoptMeshlet.triangle_offset;
-            meshlet.m_IndexCount = meshoptMeshlet.triangle_count * 3;
+            MeshletLod& lod = output.Lods[i];
+            lod.m_Center = bounds.m_Center;
+            lod.m_Radius = bounds.m_Radius;
+            lod.m_Error = 0.0f;
+            lod.m_ParentCenter = bounds.m_Center;
+            lod.m_ParentRadius = bounds.m_Radius;
+            lod.m_ParentError = FLT_MAX;
+            lod.m_Level = 0;
+            lod.m_ChildGroup = MeshletLod::NO_GROUP;
+            lod.m_ParentGroup = MeshletLod::NO_GROUP;
         }
 
-        meshlets[i] = meshlet;
+        const uint32_t groupSize = std::max(settings.ClusterLodGroupSize, 2u);
+        uint32_t numGroups = 0;
+        size_t levelBegin = 0;
+
+        for (uint32_t level = 1; level < settings.MaxClusterLodLevels; ++level)
+        {
+            const size_t levelEnd = output.Meshlets.size();
+            if (levelEnd - levelBegin <= 1)
+            {
+                break;
+            }
+
+            const auto groups = GroupMeshlets(output, levelBegin, levelEnd, groupSize);
+            std::vector<SimplifiedGroup> simplifiedGroups(groups.size());
+
+            ForEach(groups.size(), [&](const size_t groupIndex)
+                {
+                    SimplifyGroup(mesh, output, groups[groupIndex], settings, simplifiedGroups[groupIndex]);
+                }, threadPool
+            );
+
+            // Link the levels in the order of the groups, so that the IDs do not depend on the number of threads.
+            std::vector<Output> parts;
+            for (size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+            {
+                SimplifiedGroup& simplifiedGroup = simplifiedGroups[groupIndex];
+                if (!simplifiedGroup.IsSimplified)
+                {
+                    continue;
+                }
+
+                const uint32_t groupId = numGroups++;
+
+                for (const uint32_t meshletIndex : groups[groupIndex])
+                {
+                    MeshletLod& lod = output.Lods[meshletIndex];
+                    lod.m_ParentCenter = simplifiedGroup.Bounds.Center;
+                    lod.m_ParentRadius = simplifiedGroup.Bounds.Radius;
+                    lod.m_ParentError = simplifiedGroup.Error;
+                    lod.m_ParentGroup = groupId;
+                }
+
+                Output& part = simplifiedGroup.Meshlets;
+                part.Lods.resize(part.Meshlets.size());
+                for (MeshletLod& lod : part.Lods)
+                {
+                    lod.m_Center = simplifiedGroup.Bounds.Center;
+                    lod.m_Radius = simplifiedGroup.Bounds.Radius;
+                    lod.m_Error = simplifiedGroup.Error;
+                    lod.m_ParentCenter = simplifiedGroup.Bounds.Center;
+                    lod.m_ParentRadius = simplifiedGroup.Bounds.Radius;
+                    lod.m_ParentError = FLT_MAX;
+                    lod.m_Level = level;
+                    lod.m_ChildGroup = groupId;
+                    lod.m_ParentGroup = MeshletLod::NO_GROUP;
+                }
+
+                parts.push_back(std::move(part));
+            }
+
+            if (parts.empty())
+            {
+                break;
+            }
+
+            levelBegin = levelEnd;
+            Append(output, parts, threadPool);
+        }
     }
+}
 
-    // new mesh prototype
-    VertexCollectionType vertexBuffer(vertices.size());
-    IndexCollectionType indexBuffer(indices.size());
+MeshletBuilder::Output MeshletBuilder::BuildMeshlets(const MeshView& mesh, const Settings& settings, ThreadPool* threadPool)
+{
+    const size_t numTriangles = mesh.NumIndices / 3;
+    const size_t partitionSize = std::max(settings.PartitionSize, 1u);
+    Output output;
 
-    for (size_t i = 0; i < vertices.size(); ++i)
+    if (numTriangles <= partitionSize)
     {
-        vertexBuffer[i] = meshPrototype.m_Vertices[vertices[i]];
+        output = BuildPartition(mesh, mesh.Indices, mesh.NumIndices, settings);
+    }
+    else
+    {
+        // Partitions of spatially sorted triangles are compact, so only the meshlets along their borders get worse.
+        std::vector<uint32_t> sortedIndices(mesh.NumIndices);
+        meshopt_spatialSortTriangles(sortedIndices.data(), mesh.Indices, mesh.NumIndices, mesh.Positions, mesh.NumVertices, mesh.PositionStride);
+
+        const size_t numPartitions = (numTriangles + partitionSize - 1) / partitionSize;
+        std::vector<Output> partitions(numPartitions);
+
+        ForEach(numPartitions, [&](const size_t partitionIndex)
+            {
+                const size_t firstTriangle = partitionIndex * partitionSize;
+                const size_t partitionTriangles = std::min(partitionSize, numTriangles - firstTriangle);
+                partitions[partitionIndex] = BuildPartition(mesh, sortedIndices.data() + firstTriangle * 3, partitionTriangles * 3, settings);
+            }, threadPool
+        );
+
+        Append(output, partitions, threadPool);
     }
 
-    for (size_t i = 0; i < indices.size(); ++i)
+    if (settings.BuildClusterLod)
     {
-        indexBuffer[i] = indices[i];
+        BuildClusterLod(mesh, settings, threadPool, output);
     }
 
-    return MeshletSet(
-        MeshPrototype(std::move(vertexBuffer), std::move(indexBuffer)),
-        std::move(meshlets)
-    );
+    return output;
+}
+
+bool MeshletBuilder::IsInLodCut(const MeshletLod& lod, const XMFLOAT3& viewerPosition, const float maxError)
+{
+    // The error projected onto the nearest point of the sphere. Monotonic along the DAG, since both the errors and the spheres are.
+    const auto projectError = [&viewerPosition](const XMFLOAT3& center, const float radius, const float error)
+    {
+        if (error == FLT_MAX)
+        {
+            return FLT_MAX;
+        }
+
+        const float distance = std::max(Distance(center, viewerPosition) - radius, FLT_EPSILON);
+        return error / distance;
+    };
+
+    return projectError(lod.m_Center, lod.m_Radius, lod.m_Error) <= maxError &&
+        projectError(lod.m_ParentCenter, lod.m_ParentRadius, lod.m_ParentError) > maxError;
 }
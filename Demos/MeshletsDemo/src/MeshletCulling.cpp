@@ -0,0 +1,313 @@
+#include "MeshletCulling.h"
+
+#include <DX12Library/ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t AABB_VERTICES_COUNT = 8;
+
+    // The number of meshlets culled by a single job.
+    constexpr size_t CULLING_BATCH_SIZE = 16 * 1024;
+
+    struct BoundingSphere
+    {
+        XMVECTOR m_Center;
+        float m_Radius;
+    };
+
+    // See BoundingSphereObjectToWorldSpace in Geometry.hlsli.
+    BoundingSphere BoundingSphereObjectToWorldSpace(const MeshletSphere& sphere, const XMMATRIX& worldMatrix)
+    {
+        const float maxScale = std::max(XMVectorGetX(worldMatrix.r[0]), std::max(XMVectorGetY(worldMatrix.r[1]), XMVectorGetZ(worldMatrix.r[2])));
+
+        BoundingSphere result;
+        result.m_Center = XMVector3Transform(XMLoadFloat3(&sphere.m_Center), worldMatrix);
+        result.m_Radius = sphere.m_Radius * maxScale;
+        return result;
+    }
+
+    // The world-space vertices of AABBObjectToWorldSpace in Geometry.hlsli.
+    void AabbObjectToWorldSpace(const MeshletAabb& aabb, const XMMATRIX& worldMatrix, XMVECTOR vertices[AABB_VERTICES_COUNT])
+    {
+        const XMVECTOR center = XMLoadFloat3(&aabb.m_Center);
+        const XMVECTOR halfSize = XMLoadFloat3(&aabb.m_HalfSize);
+
+        for (uint32_t i = 0; i < AABB_VERTICES_COUNT; ++i)
+        {
+            const XMVECTOR sign = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f);
+            vertices[i] = XMVector3Transform(XMVectorMultiplyAdd(halfSize, sign, center), worldMatrix);
+        }
+    }
+
+    // The corners of the cube enclosing the sphere, see ComputeScreenSpaceBoundingSquareFromSphere in Geometry.hlsli.
+    void SphereToAabbVertices(const BoundingSphere& sphere, XMVECTOR vertices[AABB_VERTICES_COUNT])
+    {
+        const XMVECTOR radius = XMVectorReplicate(sphere.m_Radius);
+
+        for (uint32_t i = 0; i < AABB_VERTICES_COUNT; ++i)
+        {
+            const XMVECTOR sign = XMVectorSet((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f);
+            vertices[i] = XMVectorMultiplyAdd(radius, sign, sphere.m_Center);
+        }
+    }
+
+    float HorizontalMin(XMVECTOR value)
+    {
+        value = XMVectorMin(value, XMVectorSwizzle<2, 3, 0, 1>(value));
+        value = XMVectorMin(value, XMVectorSwizzle<1, 0, 3, 2>(value));
+        return XMVectorGetX(value);
+    }
+
+    float Saturate(const float value)
+    {
+        return std::clamp(value, 0.0f, 1.0f);
+    }
+
+    MeshletSphere GetSphere(const MeshletBounds& bounds)
+    {
+        return { bounds.m_Center, bounds.m_Radius };
+    }
+
+    MeshletCone GetCone(const MeshletBounds& bounds)
+    {
+        return { bounds.m_ConeApex, bounds.m_ConeAxis, bounds.m_ConeCutoff };
+    }
+
+    MeshletAabb GetAabb(const MeshletBounds& bounds)
+    {
+        return { bounds.m_AabbCenter, bounds.m_AabbHalfSize };
+    }
+}
+
+float MeshletCulling::HierarchicalDepthBuffer::SampleLevel(const float u, const float v, const float lod) const
+{
+    // The mip filter of the sampler is point: the nearest mip.
+    const float maxMip = static_cast<float>(m_Mips.size() - 1);
+    const float clampedLod = std::isnan(lod) ? 0.0f : std::clamp(std::floor(lod + 0.5f), 0.0f, maxMip);
+    const auto mip = static_cast<uint32_t>(clampedLod);
+
+    const uint32_t width = std::max(m_Width >> mip, 1u);
+    const uint32_t height = std::max(m_Height >> mip, 1u);
+
+    const auto x = static_cast<uint32_t>(std::clamp(std::floor(u * static_cast<float>(width)), 0.0f, static_cast<float>(width - 1)));
+    const auto y = static_cast<uint32_t>(std::clamp(std::floor(v * static_cast<float>(height)), 0.0f, static_cast<float>(height - 1)));
+    return m_Mips[mip][y * width + x];
+}
+
+MeshletCulling::MeshletCulling(const Parameters& parameters)
+    : m_CameraPosition(XMLoadFloat3(&parameters.m_CameraPosition))
+    , m_ViewProjection(parameters.m_ViewProjection)
+    , m_OcclusionCullingMode(parameters.m_OcclusionCullingMode)
+    , m_Hdb(parameters.m_Hdb != nullptr && !parameters.m_Hdb->m_Mips.empty() ? parameters.m_Hdb : nullptr)
+{
+    // Repeating planes 4 and 5 does not change the minimum distance.
+    constexpr uint32_t planeIndices[2][4] = { { 0, 1, 2, 3 }, { 4, 5, 4, 5 } };
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        const XMFLOAT4& p0 = parameters.m_FrustumPlanes[planeIndices[i][0]];
+        const XMFLOAT4& p1 = parameters.m_FrustumPlanes[planeIndices[i][1]];
+        const XMFLOAT4& p2 = parameters.m_FrustumPlanes[planeIndices[i][2]];
+        const XMFLOAT4& p3 = parameters.m_FrustumPlanes[planeIndices[i][3]];
+
+        m_PlaneNormalsX[i] = XMVectorSet(p0.x, p1.x, p2.x, p3.x);
+        m_PlaneNormalsY[i] = XMVectorSet(p0.y, p1.y, p2.y, p3.y);
+        m_PlaneNormalsZ[i] = XMVectorSet(p0.z, p1.z, p2.z, p3.z);
+        m_PlaneDistances[i] = XMVectorSet(p0.w, p1.w, p2.w, p3.w);
+    }
+}
+
+bool MeshletCulling::PassesConeCulling(const MeshletCone& cone, const Transform& transform) const
+{
+    const XMVECTOR coneApex = XMVector3Transform(XMLoadFloat3(&cone.m_Apex), transform.m_WorldMatrix);
+    const XMVECTOR coneAxis = XMVector3TransformNormal(XMLoadFloat3(&cone.m_Axis), transform.m_InverseTransposeWorldMatrix);
+    const XMVECTOR direction = XMVectorSubtract(coneApex, m_CameraPosition);
+
+    // The shader gets NaN when normalizing a zero vector (e.g., the axis of a degenerate cone), which passes the test.
+    // DirectXMath returns a zero vector instead, so handle it explicitly.
+    if (XMVectorGetX(XMVector3LengthSq(coneAxis)) == 0.0f || XMVectorGetX(XMVector3LengthSq(direction)) == 0.0f)
+    {
+        return true;
+    }
+
+    const float dotResult = XMVectorGetX(XMVector3Dot(XMVector3Normalize(direction), XMVector3Normalize(coneAxis)));
+    return !(dotResult >= cone.m_Cutoff);
+}
+
+bool MeshletCulling::PassesFrustumCulling(const MeshletSphere& objectSpaceSphere, const Transform& transform) const
+{
+    const BoundingSphere sphere = BoundingSphereObjectToWorldSpace(objectSpaceSphere, transform.m_WorldMatrix);
+
+    // The signed distances to four planes at once: dot(normal, center) - distance.
+    const XMVECTOR centerX = XMVectorSplatX(sphere.m_Center);
+    const XMVECTOR centerY = XMVectorSplatY(sphere.m_Center);
+    const XMVECTOR centerZ = XMVectorSplatZ(sphere.m_Center);
+
+    XMVECTOR distances[2];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        XMVECTOR distance = XMVectorNegate(m_PlaneDistances[i]);
+        distance = XMVectorMultiplyAdd(centerX, m_PlaneNormalsX[i], distance);
+        distance = XMVectorMultiplyAdd(centerY, m_PlaneNormalsY[i], distance);
+        distance = XMVectorMultiplyAdd(centerZ, m_PlaneNormalsZ[i], distance);
+        distances[i] = distance;
+    }
+
+    return HorizontalMin(XMVectorMin(distances[0], distances[1])) + sphere.m_Radius > 0;
+}
+
+MeshletCulling::BoundingSquare MeshletCulling::ComputeScreenSpaceBoundingSquare(const XMVECTOR* vertices) const
+{
+    // Like in the shader, the minimums (the depth included) start from 1 and the maximums from -1.
+    XMVECTOR minNdc = XMVectorReplicate(1.0f);
+    XMVECTOR maxNdc = XMVectorReplicate(-1.0f);
+
+    for (uint32_t i = 0; i < AABB_VERTICES_COUNT; ++i)
+    {
+        const XMVECTOR positionCs = XMVector3Transform(vertices[i], m_ViewProjection);
+        const XMVECTOR ndc = XMVectorDivide(positionCs, XMVectorSplatW(positionCs));
+        minNdc = XMVectorMin(minNdc, ndc);
+        maxNdc = XMVectorMax(maxNdc, ndc);
+    }
+
+    XMFLOAT3 min;
+    XMFLOAT3 max;
+    XMStoreFloat3(&min, minNdc);
+    XMStoreFloat3(&max, maxNdc);
+
+    BoundingSquare result;
+    result.m_MinU = Saturate(min.x * 0.5f + 0.5f);
+    result.m_MinV = 1.0f - Saturate(min.y * 0.5f + 0.5f);
+    result.m_MaxU = Saturate(max.x * 0.5f + 0.5f);
+    result.m_MaxV = 1.0f - Saturate(max.y * 0.5f + 0.5f);
+    result.m_MinNdcDepth = min.z;
+    return result;
+}
+
+bool MeshletCulling::PassesOcclusionCulling(const MeshletSphere& sphere, const MeshletAabb& aabb, const Transform& transform) const
+{
+    if (m_Hdb == nullptr)
+    {
+        return true;
+    }
+
+    XMVECTOR vertices[AABB_VERTICES_COUNT];
+    if (m_OcclusionCullingMode == OcclusionCullingMode::Aabb)
+    {
+        AabbObjectToWorldSpace(aabb, transform.m_WorldMatrix, vertices);
+    }
+    else
+    {
+        SphereToAabbVertices(BoundingSphereObjectToWorldSpace(sphere, transform.m_WorldMatrix), vertices);
+    }
+
+    const BoundingSquare square = ComputeScreenSpaceBoundingSquare(vertices);
+
+    const float sizeX = (square.m_MaxU - square.m_MinU) * static_cast<float>(m_Hdb->m_Width);
+    const float sizeY = (square.m_MaxV - square.m_MinV) * static_cast<float>(m_Hdb->m_Height);
+    const float lod = std::ceil(std::log2(std::max(sizeX, sizeY) * 0.5f));
+
+    float maxOccluderDepth = m_Hdb->SampleLevel(square.m_MinU, square.m_MinV, lod);
+    maxOccluderDepth = std::max(maxOccluderDepth, m_Hdb->SampleLevel(square.m_MaxU, square.m_MaxV, lod));
+    maxOccluderDepth = std::max(maxOccluderDepth, m_Hdb->SampleLevel(square.m_MinU, square.m_MaxV, lod));
+    maxOccluderDepth = std::max(maxOccluderDepth, m_Hdb->SampleLevel(square.m_MaxU, square.m_MinV, lod));
+
+    return square.m_MinNdcDepth <= maxOccluderDepth;
+}
+
+// The frustum test goes first: it rejects the most meshlets and only needs the spheres.
+bool MeshletCulling::IsVisible(const MeshletStore& meshlets, const size_t index, const Transform* transforms) const
+{
+    const Transform& transform = transforms[meshlets.m_DrawRanges[index].m_TransformIndex];
+    return PassesFrustumCulling(meshlets.m_Spheres[index], transform) &&
+        PassesConeCulling(meshlets.m_Cones[index], transform) &&
+        PassesOcclusionCulling(meshlets.m_Spheres[index], meshlets.m_Aabbs[index], transform);
+}
+
+uint32_t MeshletCulling::ComputeFlags(const MeshletStore& meshlets, const size_t index, const Transform* transforms) const
+{
+    const Transform& transform = transforms[meshlets.m_DrawRanges[index].m_TransformIndex];
+    uint32_t flags = 0;
+
+    if (PassesConeCulling(meshlets.m_Cones[index], transform))
+    {
+        flags |= FLAGS_PASSED_CONE_CULLING;
+    }
+
+    if (PassesFrustumCulling(meshlets.m_Spheres[index], transform))
+    {
+        flags |= FLAGS_PASSED_FRUSTUM_CULLING;
+    }
+
+    if (PassesOcclusionCulling(meshlets.m_Spheres[index], meshlets.m_Aabbs[index], transform))
+    {
+        flags |= FLAGS_PASSED_OCCLUSION_CULLING;
+    }
+
+    return flags;
+}
+
+void MeshletCulling::Cull(const MeshletStore& meshlets, const Transform* transforms,
+    std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool) const
+{
+    CullBatches(meshlets.GetCount(), [&](const size_t i) { return IsVisible(meshlets, i, transforms); }, visibleMeshletIndices, threadPool);
+}
+
+bool MeshletCulling::IsVisible(const Meshlet& meshlet, const Transform& transform) const
+{
+    const MeshletSphere sphere = GetSphere(meshlet.m_Bounds);
+    return PassesFrustumCulling(sphere, transform) &&
+        PassesConeCulling(GetCone(meshlet.m_Bounds), transform) &&
+        PassesOcclusionCulling(sphere, GetAabb(meshlet.m_Bounds), transform);
+}
+
+void MeshletCulling::Cull(const Meshlet* meshlets, const size_t count, const Transform* transforms,
+    std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool) const
+{
+    CullBatches(count, [&](const size_t i) { return IsVisible(meshlets[i], transforms[meshlets[i].m_TransformIndex]); }, visibleMeshletIndices, threadPool);
+}
+
+template <typename IsVisibleFunction>
+void MeshletCulling::CullBatches(const size_t count, const IsVisibleFunction& isVisible,
+    std::vector<uint32_t>& visibleMeshletIndices, ThreadPool* threadPool) const
+{
+    const size_t numBatches = (count + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE;
+    std::vector<std::vector<uint32_t>> batchResults(numBatches);
+
+    const auto cullBatch = [&](const size_t batchIndex)
+    {
+        const size_t begin = batchIndex * CULLING_BATCH_SIZE;
+        const size_t end = std::min(begin + CULLING_BATCH_SIZE, count);
+        auto& result = batchResults[batchIndex];
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (isVisible(i))
+            {
+                result.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    };
+
+    if (threadPool != nullptr && numBatches > 1)
+    {
+        threadPool->ParallelFor(numBatches, cullBatch);
+    }
+    else
+    {
+        for (size_t i = 0; i < numBatches; ++i)
+        {
+            cullBatch(i);
+        }
+    }
+
+    for (const auto& result : batchResults)
+    {
+        visibleMeshletIndices.insert(visibleMeshletIndices.end(), result.begin(), result.end());
+    }
+}
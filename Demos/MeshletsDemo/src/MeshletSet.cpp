@@ -0,0 +1,91 @@
+#include "MeshletSet.h"
+
+#include <DX12Library/Helpers.h>
+#include <DX12Library/ThreadPool.h>
+
+#include <algorithm>
+
+std::vector<uint32_t> MeshletSet::Add(const std::vector<MeshPrototype>& meshPrototypes,
+    const std::vector<MeshletBuilder::Output>& outputs,
+    const uint32_t transformIndex, ThreadPool* threadPool)
+{
+    Assert(meshPrototypes.size() == outputs.size(), "Every mesh should have its meshlets.");
+
+    struct Offsets
+    {
+        size_t Meshlets;
+        size_t Vertices;
+        size_t Indices;
+    };
+
+    const bool hasLods = m_MeshletLods.size() == m_Meshlets.GetCount() &&
+        std::all_of(outputs.begin(), outputs.end(), [](const MeshletBuilder::Output& output) { return !output.Lods.empty(); });
+
+    std::vector<Offsets> offsets(outputs.size());
+    Offsets total = { m_Meshlets.GetCount(), m_MeshPrototype.m_Vertices.size(), m_MeshPrototype.m_Indices.size() };
+    std::vector<uint32_t> meshletOffsets(outputs.size());
+
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        offsets[i] = total;
+        meshletOffsets[i] = static_cast<uint32_t>(total.Meshlets);
+
+        total.Meshlets += outputs[i].Meshlets.size();
+        total.Vertices += outputs[i].VertexIndices.size();
+        total.Indices += outputs[i].Indices.size();
+    }
+
+    m_Meshlets.Resize(total.Meshlets);
+    m_MeshPrototype.m_Vertices.resize(total.Vertices);
+    m_MeshPrototype.m_Indices.resize(total.Indices);
+    if (hasLods)
+    {
+        m_MeshletLods.resize(total.Meshlets);
+    }
+    else
+    {
+        m_MeshletLods.clear();
+    }
+
+    const auto addMesh = [&](const size_t meshIndex)
+    {
+        const MeshPrototype& meshPrototype = meshPrototypes[meshIndex];
+        const MeshletBuilder::Output& output = outputs[meshIndex];
+        const Offsets& meshOffsets = offsets[meshIndex];
+
+        for (size_t i = 0; i < output.VertexIndices.size(); ++i)
+        {
+            m_MeshPrototype.m_Vertices[meshOffsets.Vertices + i] = meshPrototype.m_Vertices[output.VertexIndices[i]];
+        }
+
+        std::copy(output.Indices.begin(), output.Indices.end(), m_MeshPrototype.m_Indices.begin() + meshOffsets.Indices);
+
+        for (size_t i = 0; i < output.Meshlets.size(); ++i)
+        {
+            Meshlet meshlet = output.Meshlets[i];
+            meshlet.m_TransformIndex = transformIndex;
+            meshlet.m_VertexOffset += static_cast<uint32_t>(meshOffsets.Vertices);
+            meshlet.m_IndexOffset += static_cast<uint32_t>(meshOffsets.Indices);
+            m_Meshlets.Set(meshOffsets.Meshlets + i, meshlet);
+        }
+
+        if (hasLods)
+        {
+            std::copy(output.Lods.begin(), output.Lods.end(), m_MeshletLods.begin() + meshOffsets.Meshlets);
+        }
+    };
+
+    if (threadPool != nullptr)
+    {
+        threadPool->ParallelFor(outputs.size(), addMesh);
+    }
+    else
+    {
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            addMesh(i);
+        }
+    }
+
+    return meshletOffsets;
+}
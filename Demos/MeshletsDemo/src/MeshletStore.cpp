@@ -0,0 +1,51 @@
+#include "MeshletStore.h"
+
+void MeshletStore::Reserve(const size_t count)
+{
+    m_Spheres.reserve(count);
+    m_Cones.reserve(count);
+    m_Aabbs.reserve(count);
+    m_DrawRanges.reserve(count);
+}
+
+void MeshletStore::Resize(const size_t count)
+{
+    m_Spheres.resize(count);
+    m_Cones.resize(count);
+    m_Aabbs.resize(count);
+    m_DrawRanges.resize(count);
+}
+
+void MeshletStore::Set(const size_t index, const Meshlet& meshlet)
+{
+    const MeshletBounds& bounds = meshlet.m_Bounds;
+
+    m_Spheres[index] = { bounds.m_Center, bounds.m_Radius };
+    m_Cones[index] = { bounds.m_ConeApex, bounds.m_ConeAxis, bounds.m_ConeCutoff };
+    m_Aabbs[index] = { bounds.m_AabbCenter, bounds.m_AabbHalfSize };
+    m_DrawRanges[index] = { meshlet.m_TransformIndex, meshlet.m_VertexOffset, meshlet.m_IndexOffset, meshlet.m_VertexCount, meshlet.m_IndexCount };
+}
+
+Meshlet MeshletStore::Get(const size_t index) const
+{
+    const MeshletSphere& sphere = m_Spheres[index];
+    const MeshletCone& cone = m_Cones[index];
+    const MeshletAabb& aabb = m_Aabbs[index];
+    const MeshletDrawRange& drawRange = m_DrawRanges[index];
+
+    Meshlet meshlet;
+    meshlet.m_Bounds = { sphere.m_Center, sphere.m_Radius, cone.m_Apex, cone.m_Axis, cone.m_Cutoff, aabb.m_Center, aabb.m_HalfSize };
+    meshlet.m_TransformIndex = drawRange.m_TransformIndex;
+    meshlet.m_VertexOffset = drawRange.m_VertexOffset;
+    meshlet.m_IndexOffset = drawRange.m_IndexOffset;
+    meshlet.m_VertexCount = drawRange.m_VertexCount;
+    meshlet.m_IndexCount = drawRange.m_IndexCount;
+    return meshlet;
+}
+
+void MeshletStore::Add(const Meshlet& meshlet)
+{
+    const size_t index = GetCount();
+    Resize(index + 1);
+    Set(index, meshlet);
+}
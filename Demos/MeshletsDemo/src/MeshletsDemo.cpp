@@ -3,6 +3,7 @@
 #include <DX12Library/Application.h>
 #include <DX12Library/CommandQueue.h>
 #include <DX12Library/CommandList.h>
+#include <DX12Library/DynamicDescriptorHeap.h>
 #include <DX12Library/Helpers.h>
 #include <DX12Library/Window.h>
 #include <Framework/Bone.h>
@@ -108,55 +109,35 @@ bool MeshletsDemo::LoadContent()
             // ReSharper disable once CppVariableCanBeMadeConstexpr
             const ModelLoader modelLoader;
 
-            uint32_t vertexBufferOffset = 0;
-            uint32_t indexBufferOffset = 0;
-            uint32_t meshletOffset = 0;
+            // Meshes are built in parallel, and so are the partitions of large meshes.
+            const MeshletBuilder::Settings meshletBuilderSettings;
 
             const auto loadMeshletGameObject = [&](const std::string& path, const XMMATRIX& worldMatrix)
             {
                 const std::vector<MeshPrototype> meshPrototypes = modelLoader.LoadAsMeshPrototypes(path, true);
 
-                std::vector<MeshPrototype> updatedMeshPrototypes;
-                std::vector<MeshletBuilder::MeshletSet> meshletSets;
-                {
-                    for (const auto& meshPrototype : meshPrototypes)
+                std::vector<MeshletBuilder::Output> meshletOutputs(meshPrototypes.size());
+                m_ThreadPool.ParallelFor(meshPrototypes.size(), [&](const size_t meshIndex)
                     {
-                        meshletSets.emplace_back(MeshletBuilder::BuildMeshlets(meshPrototype, vertexBufferOffset, indexBufferOffset));
-
-                        const auto& lastSet = meshletSets.back();
-                        vertexBufferOffset += static_cast<uint32_t>(lastSet.m_MeshPrototype.m_Vertices.size());
-                        indexBufferOffset += static_cast<uint32_t>(lastSet.m_MeshPrototype.m_Indices.size());
-                    }
-
-                    updatedMeshPrototypes.reserve(meshletSets.size());
-
-                    for (size_t i = 0; i < meshletSets.size(); ++i)
-                    {
-                        updatedMeshPrototypes.emplace_back(meshletSets[i].m_MeshPrototype);
+                        const MeshPrototype& meshPrototype = meshPrototypes[meshIndex];
+                        const MeshletBuilder::MeshView meshView = {
+                            meshPrototype.m_Vertices.empty() ? nullptr : &meshPrototype.m_Vertices[0].Position.x, sizeof(VertexAttributes), meshPrototype.m_Vertices.size(),
+                            meshPrototype.m_Indices.data(), meshPrototype.m_Indices.size(),
+                        };
+                        meshletOutputs[meshIndex] = MeshletBuilder::BuildMeshlets(meshView, meshletBuilderSettings, &m_ThreadPool);
                     }
+                );
 
-                    for (auto& meshletSet : meshletSets)
-                    {
-                        const size_t oldCount = m_MeshletsBuffer.m_Meshlets.size();
-                        m_MeshletsBuffer.Add(meshletSet);
-
-                        for (size_t meshletIndex = oldCount; meshletIndex < m_MeshletsBuffer.m_Meshlets.size(); ++meshletIndex)
-                        {
-                            auto& meshlet = m_MeshletsBuffer.m_Meshlets[meshletIndex];
-                            meshlet.m_TransformIndex = static_cast<uint32_t>(m_TransformsBuffer.size());
-                        }
-                    }
-                }
+                const auto transformIndex = static_cast<uint32_t>(m_TransformsBuffer.size());
+                const std::vector<uint32_t> meshletOffsets = m_MeshletsBuffer.Add(meshPrototypes, meshletOutputs, transformIndex, &m_ThreadPool);
 
-                const auto model = modelLoader.Load(*pCmd, updatedMeshPrototypes);
+                const auto model = modelLoader.Load(*pCmd, meshPrototypes);
 
                 for (uint32_t i = 0; i < model->GetMeshes().size(); ++i)
                 {
                     const auto& pMesh = model->GetMeshes()[i];
-                    pMesh->m_MeshletsOffset = meshletOffset;
-                    pMesh->m_MeshletsCount = static_cast<uint32_t>(meshletSets[i].m_Meshlets.size());
-
-                    meshletOffset += pMesh->m_MeshletsCount;
+                    pMesh->m_MeshletsOffset = meshletOffsets[i];
+                    pMesh->m_MeshletsCount = static_cast<uint32_t>(meshletOutputs[i].Meshlets.size());
                 }
 
                 m_MeshletGameObjects.push_back(GameObject(worldMatrix, model, m_MeshletDrawMaterial));
@@ -248,7 +229,7 @@ void MeshletsDemo::OnImGui()
 
     {
         ImGui::InputInt("Selected Meshlet Index", reinterpret_cast<int*>(&m_SelectedMeshletIndex));
-        m_SelectedMeshletIndex = std::clamp(m_SelectedMeshletIndex, 0u, static_cast<uint32_t>(m_MeshletsBuffer.m_Meshlets.size() - 1));
+        m_SelectedMeshletIndex = std::clamp(m_SelectedMeshletIndex, 0u, static_cast<uint32_t>(m_MeshletsBuffer.m_Meshlets.GetCount() - 1));
     }
 
     ImGui::Checkbox("Freeze camera for cone and frustum culling", &m_FreezeCulling);
@@ -267,6 +248,7 @@ void MeshletsDemo::OnImGui()
 
         ImGui::Checkbox("Render Occluders", &m_RenderOccluders);
 
+        ImGui::Checkbox("CPU Culling", &m_CpuCulling);
         ImGui::Checkbox("Debug GPU Culling", &m_DebugGpuCulling);
         if (m_DebugGpuCulling)
         {
@@ -290,6 +272,15 @@ void MeshletsDemo::OnImGui()
         }
     }
 
+    if (ImGui::CollapsingHeader("Descriptors"))
+    {
+        const auto statistics = DynamicDescriptorHeap::GetLastFrameStatistics();
+        ImGui::Text("Descriptors copied: %u", statistics.NumDescriptorsCopied);
+        ImGui::Text("Tables copied: %u", statistics.NumTablesCopied);
+        ImGui::Text("Tables reused: %u", statistics.NumTablesReused);
+        ImGui::Text("Copy calls: %u", statistics.NumCopyCalls);
+    }
+
     ImGui::End();
 }
 
@@ -437,11 +428,11 @@ void MeshletsDemo::OnKeyPressed(KeyEventArgs& e)
     case KeyCode::N:
         m_SelectedMeshletIndex--;
         if (m_SelectedMeshletIndex == -1)
-            m_SelectedMeshletIndex = static_cast<uint32_t>(m_MeshletsBuffer.m_Meshlets.size()) - 1;
+            m_SelectedMeshletIndex = static_cast<uint32_t>(m_MeshletsBuffer.m_Meshlets.GetCount()) - 1;
         break;
     case KeyCode::M:
         m_SelectedMeshletIndex++;
-        m_SelectedMeshletIndex %= m_MeshletsBuffer.m_Meshlets.size();
+        m_SelectedMeshletIndex %= m_MeshletsBuffer.m_Meshlets.GetCount();
         break;
     case KeyCode::ShiftKey:
         m_CameraController.m_Shift = true;
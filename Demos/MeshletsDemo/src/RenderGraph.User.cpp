@@ -13,6 +13,7 @@
 #include <Framework/Shader.h>
 #include <Framework/SharedUploadBuffer.h>
 
+#include "MeshletCulling.h"
 #include "MeshletDrawIndirect.h"
 #include "MeshletsDemo.h"
 
@@ -31,7 +32,10 @@ namespace ResourceIds
         // Buffers
         static inline const RenderGraph::ResourceId CommonVertexBuffer = RenderGraph::ResourceIds::GetResourceId(L"CommonVertexBuffer");
         static inline const RenderGraph::ResourceId CommonIndexBuffer = RenderGraph::ResourceIds::GetResourceId(L"CommonIndexBuffer");
-        static inline const RenderGraph::ResourceId MeshletsBuffer = RenderGraph::ResourceIds::GetResourceId(L"MeshletsBuffer");
+        static inline const RenderGraph::ResourceId MeshletSpheres = RenderGraph::ResourceIds::GetResourceId(L"MeshletSpheres");
+        static inline const RenderGraph::ResourceId MeshletCones = RenderGraph::ResourceIds::GetResourceId(L"MeshletCones");
+        static inline const RenderGraph::ResourceId MeshletAabbs = RenderGraph::ResourceIds::GetResourceId(L"MeshletAabbs");
+        static inline const RenderGraph::ResourceId MeshletDrawRanges = RenderGraph::ResourceIds::GetResourceId(L"MeshletDrawRanges");
         static inline const RenderGraph::ResourceId TransformsBuffer = RenderGraph::ResourceIds::GetResourceId(L"TransformsBuffer");
         static inline const RenderGraph::ResourceId MeshletDrawCommands = RenderGraph::ResourceIds::GetResourceId(L"MeshletDrawCommands");
 
@@ -141,14 +145,20 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
         {
             { ::ResourceIds::User::CommonVertexBuffer, OutputType::CopyDestination },
             { ::ResourceIds::User::CommonIndexBuffer, OutputType::CopyDestination },
-            { ::ResourceIds::User::MeshletsBuffer, OutputType::CopyDestination },
+            { ::ResourceIds::User::MeshletSpheres, OutputType::CopyDestination },
+            { ::ResourceIds::User::MeshletCones, OutputType::CopyDestination },
+            { ::ResourceIds::User::MeshletAabbs, OutputType::CopyDestination },
+            { ::ResourceIds::User::MeshletDrawRanges, OutputType::CopyDestination },
             { ::ResourceIds::User::TransformsBuffer, OutputType::CopyDestination },
         },
         [&demo, pSharedUploadBuffer](const RenderContext& context, CommandList& commandList)
         {
             const auto& pCommonVertexBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::CommonVertexBuffer);
             const auto& pCommonIndexBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::CommonIndexBuffer);
-            const auto& pMeshletsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletsBuffer);
+            const auto& pMeshletSpheres = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletSpheres);
+            const auto& pMeshletCones = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletCones);
+            const auto& pMeshletAabbs = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletAabbs);
+            const auto& pMeshletDrawRanges = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletDrawRanges);
             const auto& pTransformsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::TransformsBuffer);
 
             const auto& meshletSet = demo.m_MeshletsBuffer;
@@ -157,7 +167,11 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
             pSharedUploadBuffer->Upload(commandList, *pCommonVertexBuffer, meshPrototype.m_Vertices);
             pSharedUploadBuffer->Upload(commandList, *pCommonIndexBuffer, meshPrototype.m_Indices);
 
-            pSharedUploadBuffer->Upload(commandList, *pMeshletsBuffer, meshletSet.m_Meshlets);
+            const auto& meshlets = meshletSet.m_Meshlets;
+            pSharedUploadBuffer->Upload(commandList, *pMeshletSpheres, meshlets.m_Spheres);
+            pSharedUploadBuffer->Upload(commandList, *pMeshletCones, meshlets.m_Cones);
+            pSharedUploadBuffer->Upload(commandList, *pMeshletAabbs, meshlets.m_Aabbs);
+            pSharedUploadBuffer->Upload(commandList, *pMeshletDrawRanges, meshlets.m_DrawRanges);
 
             pSharedUploadBuffer->Upload(commandList, *pTransformsBuffer, demo.m_TransformsBuffer);
         }
@@ -271,20 +285,63 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
         {
             { ::ResourceIds::User::MeshletDrawCommands, OutputType::CopyDestination }
         },
-        [pSharedUploadBuffer]
+        [&demo, pSharedUploadBuffer]
         (const RenderContext& context, CommandList& commandList)
         {
             const auto& pMeshletDrawCommands = context.m_ResourcePool->GetStructuredBuffer(::ResourceIds::User::MeshletDrawCommands);
 
-            constexpr uint32_t clearValue = 0;
-            pSharedUploadBuffer->Upload(commandList, pMeshletDrawCommands->GetCounterBuffer(), &clearValue, sizeof(uint32_t), sizeof(uint32_t));
+            uint32_t commandsCount = 0;
+
+            // Fill the commands here instead of dispatching the culling shader.
+            if (demo.m_CpuCulling)
+            {
+                MeshletCulling::Parameters parameters;
+                XMStoreFloat3(&parameters.m_CameraPosition, demo.m_CullingCameraPosition);
+                const Camera::Frustum frustum = demo.m_Camera.GetFrustum(demo.m_CullingCameraPosition, demo.m_CullingCameraRotation);
+                for (uint32_t i = 0; i < MeshletCulling::FRUSTUM_PLANES_COUNT; ++i)
+                {
+                    const auto& plane = frustum.m_Planes[i];
+                    parameters.m_FrustumPlanes[i] = XMFLOAT4(plane.m_Normal.x, plane.m_Normal.y, plane.m_Normal.z, plane.m_Distance);
+                }
+                parameters.m_ViewProjection = demo.m_Camera.GetViewMatrix() * demo.m_Camera.GetProjectionMatrix();
+                parameters.m_OcclusionCullingMode = static_cast<MeshletCulling::OcclusionCullingMode>(demo.m_OcclusionCullingMode);
+                const MeshletCulling culling(parameters);
+
+                const auto& meshlets = demo.m_MeshletsBuffer.m_Meshlets;
+                std::vector<uint32_t> visibleMeshletIndices;
+                culling.Cull(meshlets, demo.m_TransformsBuffer.data(), visibleMeshletIndices, &demo.m_ThreadPool);
+
+                std::vector<MeshletDrawIndirectCommand> commands(visibleMeshletIndices.size());
+                for (size_t i = 0; i < commands.size(); ++i)
+                {
+                    auto& command = commands[i];
+                    command.m_MeshletIndex = visibleMeshletIndices[i];
+                    command.m_Flags = 0;
+                    command.m_DrawArguments.VertexCountPerInstance = meshlets.m_DrawRanges[command.m_MeshletIndex].m_IndexCount;
+                    command.m_DrawArguments.InstanceCount = 1;
+                    command.m_DrawArguments.StartVertexLocation = 0;
+                    command.m_DrawArguments.StartInstanceLocation = 0;
+                }
+
+                if (!commands.empty())
+                {
+                    pSharedUploadBuffer->Upload(commandList, *pMeshletDrawCommands, commands);
+                }
+
+                commandsCount = static_cast<uint32_t>(commands.size());
+            }
+
+            pSharedUploadBuffer->Upload(commandList, pMeshletDrawCommands->GetCounterBuffer(), &commandsCount, sizeof(uint32_t), sizeof(uint32_t));
         }
     ));
 
     renderPasses.emplace_back(RenderPass::Create(
         L"Cull Meshlets",
         {
-            { ::ResourceIds::User::MeshletsBuffer, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletSpheres, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletCones, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletAabbs, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletDrawRanges, InputType::ShaderResource },
             { ::ResourceIds::User::TransformsBuffer, InputType::ShaderResource },
             { ::ResourceIds::User::HierarchicalDepthBuffer, InputType::ShaderResource },
         },
@@ -295,13 +352,25 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
             pCullingShader = std::make_shared<ComputeShader>(pRootSignature, ShaderBlob(L"MeshletCulling_CS.cso"))]
         (const RenderContext& context, CommandList& commandList)
         {
-            const auto& pMeshletsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletsBuffer);
+            // The commands have already been filled by the CPU.
+            if (demo.m_CpuCulling)
+            {
+                return;
+            }
+
+            const auto& pMeshletSpheres = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletSpheres);
+            const auto& pMeshletCones = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletCones);
+            const auto& pMeshletAabbs = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletAabbs);
+            const auto& pMeshletDrawRanges = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletDrawRanges);
             const auto& pTransformsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::TransformsBuffer);
             const auto& pMeshletDrawCommands = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletDrawCommands);
             const auto& pHdb = context.m_ResourcePool->GetTexture(::ResourceIds::User::HierarchicalDepthBuffer);
 
-            pRootSignature->SetPipelineShaderResourceView(commandList, 2, ShaderResourceView(pMeshletsBuffer));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 2, ShaderResourceView(pMeshletSpheres));
             pRootSignature->SetPipelineShaderResourceView(commandList, 3, ShaderResourceView(pTransformsBuffer));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 4, ShaderResourceView(pMeshletCones));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 5, ShaderResourceView(pMeshletAabbs));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 6, ShaderResourceView(pMeshletDrawRanges));
 
             const auto hdbDesc = pHdb->GetD3D12ResourceDesc();
             {
@@ -316,7 +385,7 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
 
             pRootSignature->SetUnorderedAccessView(commandList, 0, UnorderedAccessView(pMeshletDrawCommands));
 
-            const uint32_t meshletsCount = demo.m_MeshletsBuffer.m_Meshlets.size();
+            const uint32_t meshletsCount = demo.m_MeshletsBuffer.m_Meshlets.GetCount();
 
             {
                 struct
@@ -355,7 +424,10 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
         {
             { ::ResourceIds::User::CommonVertexBuffer, InputType::ShaderResource },
             { ::ResourceIds::User::CommonIndexBuffer, InputType::ShaderResource },
-            { ::ResourceIds::User::MeshletsBuffer, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletSpheres, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletCones, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletAabbs, InputType::ShaderResource },
+            { ::ResourceIds::User::MeshletDrawRanges, InputType::ShaderResource },
             { ::ResourceIds::User::TransformsBuffer, InputType::ShaderResource },
             { ::ResourceIds::User::MeshletDrawCommands, InputType::IndirectArgument },
         },
@@ -368,17 +440,23 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
         {
             const auto& pCommonVertexBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::CommonVertexBuffer);
             const auto& pCommonIndexBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::CommonIndexBuffer);
-            const auto& pMeshletsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletsBuffer);
+            const auto& pMeshletSpheres = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletSpheres);
+            const auto& pMeshletCones = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletCones);
+            const auto& pMeshletAabbs = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletAabbs);
+            const auto& pMeshletDrawRanges = context.m_ResourcePool->GetBuffer(::ResourceIds::User::MeshletDrawRanges);
             const auto& pTransformsBuffer = context.m_ResourcePool->GetBuffer(::ResourceIds::User::TransformsBuffer);
             const auto& pMeshletDrawCommands = context.m_ResourcePool->GetStructuredBuffer(::ResourceIds::User::MeshletDrawCommands);
 
             pRootSignature->SetPipelineShaderResourceView(commandList, 0, ShaderResourceView(pCommonVertexBuffer));
             pRootSignature->SetPipelineShaderResourceView(commandList, 1, ShaderResourceView(pCommonIndexBuffer));
-            pRootSignature->SetPipelineShaderResourceView(commandList, 2, ShaderResourceView(pMeshletsBuffer));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 2, ShaderResourceView(pMeshletSpheres));
             pRootSignature->SetPipelineShaderResourceView(commandList, 3, ShaderResourceView(pTransformsBuffer));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 4, ShaderResourceView(pMeshletCones));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 5, ShaderResourceView(pMeshletAabbs));
+            pRootSignature->SetPipelineShaderResourceView(commandList, 6, ShaderResourceView(pMeshletDrawRanges));
 
             pMeshletDrawIncorrect->DrawIndirect(commandList,
-                demo.m_MeshletsBuffer.m_Meshlets.size(),
+                demo.m_MeshletsBuffer.m_Meshlets.GetCount(),
                 *pMeshletDrawCommands);
         }
     ));
@@ -508,10 +586,13 @@ std::unique_ptr<RenderGraph::RenderGraphRoot> RenderGraph::User::Create(
     std::vector buffers =
     {
         BufferDescription{ ::ResourceIds::User::CommonVertexBuffer, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_MeshPrototype.m_Vertices.size(); }, sizeof(VertexAttributes), CopyDestination },
-        BufferDescription{ ::ResourceIds::User::CommonIndexBuffer, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_MeshPrototype.m_Indices.size() * sizeof(uint16_t); }, 1, CopyDestination },
-        BufferDescription{ ::ResourceIds::User::MeshletsBuffer, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.size(); }, sizeof(Meshlet), CopyDestination },
+        BufferDescription{ ::ResourceIds::User::CommonIndexBuffer, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_MeshPrototype.m_Indices.size() * sizeof(IndexCollectionType::value_type); }, 1, CopyDestination },
+        BufferDescription{ ::ResourceIds::User::MeshletSpheres, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.GetCount(); }, sizeof(MeshletSphere), CopyDestination },
+        BufferDescription{ ::ResourceIds::User::MeshletCones, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.GetCount(); }, sizeof(MeshletCone), CopyDestination },
+        BufferDescription{ ::ResourceIds::User::MeshletAabbs, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.GetCount(); }, sizeof(MeshletAabb), CopyDestination },
+        BufferDescription{ ::ResourceIds::User::MeshletDrawRanges, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.GetCount(); }, sizeof(MeshletDrawRange), CopyDestination },
         BufferDescription{ ::ResourceIds::User::TransformsBuffer, [&demo](const auto&) { return demo.m_TransformsBuffer.size(); }, sizeof(Transform), CopyDestination },
-        BufferDescription{ ::ResourceIds::User::MeshletDrawCommands, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.size(); }, sizeof(MeshletDrawIndirectCommand), CopyDestination },
+        BufferDescription{ ::ResourceIds::User::MeshletDrawCommands, [&demo](const auto&) { return demo.m_MeshletsBuffer.m_Meshlets.GetCount(); }, sizeof(MeshletDrawIndirectCommand), CopyDestination },
     };
 
     std::vector<TokenDescription> tokens =
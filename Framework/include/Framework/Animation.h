@@ -1,14 +1,22 @@
 #pragma once
 
+#include "BoneMask.h"
+
 #include <DirectXMath.h>
 
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 #include <memory>
-#include <set>
 
-class Mesh;
+class Armature;
 
+/**
+ * A clip of keyframed bone transforms.
+ * The keys are stored as separate time and value arrays, so the key search only touches the times.
+ * Does not depend on D3D12.
+ */
 class Animation
 {
 public:
@@ -35,21 +43,98 @@ public:
 		DirectX::XMVECTOR Scaling;
 	};
 
-	using BoneMask = std::set<size_t>;
+	// The local transforms of all the bones of an armature.
+	using Pose = std::vector<BoneTransform>;
+
+	static constexpr uint32_t NO_BONE = std::numeric_limits<uint32_t>::max();
+
+	// The bones of an armature the channels animate, resolved once instead of by name on every sample.
+	struct Binding
+	{
+		// Per channel, NO_BONE if the armature does not have the bone.
+		std::vector<uint32_t> BoneIndices;
+		size_t NumBones = 0;
+	};
+
+	// The keys the previous sample of a playing instance has used, per track. Sampling forward from there is amortized O(1).
+	struct Cursor
+	{
+		std::vector<uint32_t> KeyIndices;
+	};
+
+	Binding Bind(const Armature& armature) const;
+	Cursor CreateCursor() const;
+
+	// Resolve the bones of channels by their node names.
+	static Binding Bind(const std::vector<std::string>& channelNodeNames, const Armature& armature);
+
+	/**
+	 * Sample the local transforms of the bound armature. Bones without a channel get the identity.
+	 * @param time In seconds, looped over the duration.
+	 * @param cursor Keeps the position of an instance between samples. Seeks (e.g., when the clip loops) fall back to a binary search.
+	 * @param transforms Resized to the number of bones, so it does not allocate once it has the capacity.
+	 */
+	void Sample(const Binding& binding, double time, Cursor& cursor, Pose& transforms) const;
 
-	std::vector<BoneTransform> GetBonesTransforms(Mesh& mesh, double time) const;
+	// Without a cursor, every key is found with a binary search.
+	void Sample(const Binding& binding, double time, Pose& transforms) const;
 
-	static void Apply(Mesh& mesh, const std::vector<BoneTransform>& transforms);
+	size_t GetChannelCount() const { return m_ChannelNodeNames.size(); }
+	const std::string& GetChannelNodeName(size_t channelIndex) const { return m_ChannelNodeNames[channelIndex]; }
+	double GetDurationInSeconds() const { return m_Duration / m_TicksPerSecond; }
+	size_t GetKeyCount() const { return m_KeyTimes.size(); }
+	// The memory the keys and tracks take, without the channel names.
+	size_t GetMemorySize() const;
 
-	static BoneMask BuildMask(const Mesh& mesh, const std::string& rootBoneName);
-	static std::vector<BoneTransform> Blend(const std::vector<BoneTransform>& transforms1, const std::vector<BoneTransform>& transforms2, float weight);
-	static std::vector<BoneTransform> ApplyMask(const std::vector<BoneTransform>& transforms1, const std::vector<BoneTransform>& transforms2, const BoneMask& boneMask);
+	static void Apply(Armature& armature, const Pose& transforms);
+
+	// The bone and all its descendants.
+	static BoneMask BuildMask(const Armature& armature, const std::string& rootBoneName);
+
+	/**
+	 * The pose operations write into a caller-provided pose, resized to the size of the inputs (it does not allocate once it has the capacity).
+	 * The result may be one of the inputs.
+	 */
+
+	// Interpolate from transforms1 (weight 0) to transforms2 (weight 1).
+	static void Blend(const Pose& transforms1, const Pose& transforms2, float weight, Pose& result);
+
+	/**
+	 * The weighted average of several poses: rotations are accumulated in the hemisphere of the first pose and normalized (nlerp).
+	 * The weights are normalized, their sum must be positive.
+	 */
+	static void Blend(const Pose* const* poses, const float* weights, size_t numPoses, Pose& result);
+
+	// The bones of the mask take transforms1, the rest transforms2.
+	static void ApplyMask(const Pose& transforms1, const Pose& transforms2, const BoneMask& boneMask, Pose& result);
 
 private:
+	enum TrackType
+	{
+		Position = 0,
+		Rotation,
+		Scaling,
+		NumTrackTypes,
+	};
 
-	static void BuildMaskRecursive(const Mesh& mesh, size_t rootBoneIndex, BoneMask& result);
+	// A range of the keys.
+	struct Track
+	{
+		uint32_t FirstKey;
+		uint32_t NumKeys;
+	};
+
+	void SampleInternal(const Binding& binding, double time, uint32_t* keyIndices, Pose& transforms) const;
+	// The track must have keys. keyIndex is the key the previous sample has used (or out of range): it is moved to the last key not after the time.
+	DirectX::XMVECTOR SampleTrack(const Track& track, TrackType trackType, float time, uint32_t& keyIndex) const;
 
 	float m_Duration;
 	float m_TicksPerSecond;
-	std::vector<Channel> m_Channels;
-};
\ No newline at end of file
+
+	std::vector<std::string> m_ChannelNodeNames;
+	// NumTrackTypes per channel.
+	std::vector<Track> m_Tracks;
+	// The keys of all the tracks, in ticks.
+	std::vector<float> m_KeyTimes;
+	std::vector<DirectX::XMFLOAT4> m_KeyValues;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Animation.h"
+#include "BoneMask.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Armature;
+
+/**
+ * Blends the clips playing on an armature into a single pose.
+ * The nodes are added children first, so the last one is the root and the tree is evaluated in the order the nodes were added.
+ * Every node owns a pose buffer allocated when it is added: once the output has the capacity, Evaluate does not allocate.
+ * The armature must outlive the tree.
+ * Does not depend on D3D12.
+ */
+class AnimationBlendTree
+{
+public:
+    using NodeId = uint32_t;
+
+    explicit AnimationBlendTree(const Armature& armature);
+
+    // Plays the clip at time * speed.
+    NodeId AddClip(std::shared_ptr<const Animation> animation, float speed = 1.0f);
+
+    /**
+     * The weighted average of the children (see Animation::Blend). Children with a zero weight are not evaluated.
+     * The sum of the weights must be positive when the tree is evaluated.
+     */
+    NodeId AddBlend(const std::vector<NodeId>& children, const std::vector<float>& weights);
+
+    // The bones of the mask take the pose of maskedChild, the rest of unmaskedChild.
+    NodeId AddMask(NodeId maskedChild, NodeId unmaskedChild, BoneMask mask);
+
+    void SetWeight(NodeId blendNode, size_t childIndex, float weight);
+
+    size_t GetNodeCount() const { return m_Nodes.size(); }
+
+    // Evaluate the root (the last node added) at the time in seconds.
+    void Evaluate(double time, Animation::Pose& output);
+
+private:
+    enum class NodeType
+    {
+        Clip,
+        Blend,
+        Mask,
+    };
+
+    struct Node
+    {
+        NodeType m_Type;
+        std::vector<NodeId> m_Children;
+        // Blend nodes only.
+        std::vector<float> m_Weights;
+
+        // Clip nodes only.
+        std::shared_ptr<const Animation> m_Animation;
+        Animation::Binding m_Binding;
+        Animation::Cursor m_Cursor;
+        float m_Speed = 1.0f;
+
+        // Mask nodes only.
+        BoneMask m_Mask;
+
+        Animation::Pose m_Pose;
+        bool m_IsActive = false;
+    };
+
+    NodeId AddNode(Node node);
+    void ValidateChild(NodeId child) const;
+
+    const Armature& m_Armature;
+    size_t m_NumBones;
+    std::vector<Node> m_Nodes;
+
+    // Scratch space for the widest blend node.
+    std::vector<const Animation::Pose*> m_BlendPoses;
+    std::vector<float> m_BlendWeights;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <DX12Library/HashUtils.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class Animation;
+struct CookedAnimationFile;
+
+/**
+ * The animation clips of a demo, looked up by the hash of their names.
+ * All the clips of a file are imported in a single pass and cached next to it (see ModelCooker::GetCookedAnimationsPath),
+ * so later runs read the compact cooked representation instead of parsing the source again.
+ */
+class AnimationLibrary
+{
+public:
+    using NameHash = uint64_t;
+
+    /**
+     * Add all the clips of a model file. A clip is named "<prefix>/<clip name>", or just by its name if the prefix is empty
+     * (exporters often give every clip the same name, e.g. Mixamo's "mixamo.com").
+     * Throws std::runtime_error if the file cannot be imported or a name is already taken.
+     * @return The number of clips added.
+     */
+    size_t AddFile(const std::string& path, std::string_view prefix = {});
+
+    // Add the clips of an already imported file.
+    size_t AddClips(const CookedAnimationFile& file, std::string_view prefix = {});
+
+    static constexpr NameHash HashName(const std::string_view name)
+    {
+        return HashUtils::Fnv1a(name);
+    }
+
+    // Returns null if there is no such clip.
+    std::shared_ptr<Animation> Find(NameHash nameHash) const;
+    std::shared_ptr<Animation> Find(std::string_view name) const { return Find(HashName(name)); }
+
+    // Throws std::out_of_range if there is no such clip.
+    const std::shared_ptr<Animation>& Get(std::string_view name) const;
+
+    size_t GetClipCount() const { return m_Clips.size(); }
+
+    /**
+     * Read the cooked clips of a file if they are up to date, otherwise import them and try to update the cache.
+     * Failing to write the cache (e.g., a read-only directory) is not an error.
+     */
+    static CookedAnimationFile LoadCookedAnimations(const std::string& path);
+
+    static std::shared_ptr<Animation> CreateAnimation(const CookedAnimationFile& file, size_t clipIndex);
+
+private:
+    std::unordered_map<NameHash, std::shared_ptr<Animation>> m_Clips;
+};
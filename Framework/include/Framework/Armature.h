@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <vector>
 #include <string>
@@ -8,12 +10,20 @@
 
 #include "Bone.h"
 
+/**
+ * The bones of a skinned mesh, sorted so that parents come before their children.
+ * The global transforms are then updated in a single linear pass over the parent indices.
+ */
 class Armature
 {
 public:
-    void SetBones(const std::vector<Bone>& bones);
-    void SetBoneChildren(size_t boneIndex, const std::vector<size_t>& childrenIndices);
-    const std::vector<size_t>& GetBoneChildren(size_t boneIndex) const;
+    static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @param parentIndices Per bone, NO_PARENT for the roots. A parent must come before its children, otherwise std::invalid_argument is thrown.
+     */
+    void SetBones(const std::vector<Bone>& bones, const std::vector<uint32_t>& parentIndices);
+    uint32_t GetBoneParentIndex(size_t boneIndex) const;
 
     bool HasBones() const;
     const std::vector<Bone>& GetBones() const;
@@ -27,12 +37,11 @@ public:
     size_t GetBoneIndex(const std::string& name) const;
 
     void MarkBonesDirty();
+    // Updates the dirty bones and their descendants.
     void UpdateBoneGlobalTransforms();
 
 private:
-    void UpdateBoneGlobalTransforms(size_t rootIndex, const DirectX::XMMATRIX& parentTransform);
-
     std::vector<Bone> m_Bones;
+    std::vector<uint32_t> m_ParentIndices;
     std::map<std::string, size_t> m_BoneIndicesByNames;
-    std::vector<std::vector<size_t>> m_BoneChildrenByIndex;
 };
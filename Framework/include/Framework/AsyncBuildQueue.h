@@ -0,0 +1,169 @@
+#pragma once
+
+#include <DX12Library/ThreadPool.h>
+#include <DX12Library/ThreadSafeQueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Runs build functions on a pool of worker threads, so that the thread that schedules them never blocks on a build.
+ * The jobs are identified by a key: scheduling a key whose job is still in flight returns that job.
+ * PipelineStateCompiler uses it for pipeline state objects.
+ * Does not depend on Windows or D3D12.
+ */
+template <typename TResult>
+class AsyncBuildQueue
+{
+public:
+    using BuildFunction = std::function<TResult()>;
+
+    enum class JobStatus
+    {
+        Pending,
+        Completed,
+        Failed,
+    };
+
+    class Job
+    {
+    public:
+        explicit Job(const uint64_t key)
+            : m_Key(key)
+            , m_Status(JobStatus::Pending)
+        {}
+
+        uint64_t GetKey() const { return m_Key; }
+        JobStatus GetStatus() const { return m_Status.load(std::memory_order_acquire); }
+
+        // Only valid after the status has become Completed.
+        const TResult& GetResult() const { return m_Result; }
+        // Only valid after the status has become Failed.
+        const std::string& GetErrorMessage() const { return m_ErrorMessage; }
+
+    private:
+        friend class AsyncBuildQueue;
+
+        uint64_t m_Key;
+        std::atomic<JobStatus> m_Status;
+        TResult m_Result{};
+        std::string m_ErrorMessage;
+    };
+
+    // Reported once per finished job.
+    struct CompletionReport
+    {
+        uint64_t Key;
+        bool Succeeded;
+        double DurationMs;
+    };
+
+    explicit AsyncBuildQueue(const uint32_t numThreads = 0)
+        : m_ThreadPool(numThreads)
+    {}
+
+    ~AsyncBuildQueue()
+    {
+        m_ThreadPool.Wait();
+    }
+
+    AsyncBuildQueue(const AsyncBuildQueue& other) = delete;
+    AsyncBuildQueue& operator=(const AsyncBuildQueue& other) = delete;
+
+    /**
+     * Schedule the build function on a worker thread. Never blocks on a build.
+     * If a job with the same key is still in flight, that job is returned instead.
+     * An exception thrown by the build function fails the job with the exception's message.
+     */
+    std::shared_ptr<Job> Schedule(const uint64_t key, BuildFunction buildFunction)
+    {
+        std::shared_ptr<Job> job;
+
+        {
+            std::lock_guard lock(m_InFlightJobsMutex);
+
+            auto& inFlightJob = m_InFlightJobs[key];
+            job = inFlightJob.lock();
+            if (job != nullptr && job->GetStatus() == JobStatus::Pending)
+            {
+                return job;
+            }
+
+            job = std::make_shared<Job>(key);
+            inFlightJob = job;
+        }
+
+        m_ThreadPool.Schedule([this, job, buildFunction = std::move(buildFunction)]()
+            {
+                Execute(job, buildFunction);
+            });
+
+        return job;
+    }
+
+    bool TryPopCompletionReport(CompletionReport& report)
+    {
+        return m_CompletionReports.TryPop(report);
+    }
+
+    size_t GetNumPendingJobs() const
+    {
+        return m_ThreadPool.GetNumPendingJobs();
+    }
+
+    // Block until all the scheduled jobs are complete.
+    void Wait()
+    {
+        m_ThreadPool.Wait();
+    }
+
+private:
+    void Execute(const std::shared_ptr<Job>& job, const BuildFunction& buildFunction)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        JobStatus status;
+        try
+        {
+            job->m_Result = buildFunction();
+            status = JobStatus::Completed;
+        }
+        catch (const std::exception& exception)
+        {
+            job->m_ErrorMessage = exception.what();
+            status = JobStatus::Failed;
+        }
+
+        const auto endTime = std::chrono::high_resolution_clock::now();
+        const double durationMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+        // Publish the results only after they have been written.
+        job->m_Status.store(status, std::memory_order_release);
+
+        {
+            std::lock_guard lock(m_InFlightJobsMutex);
+
+            const auto findResult = m_InFlightJobs.find(job->GetKey());
+            if (findResult != m_InFlightJobs.end() && findResult->second.lock() == job)
+            {
+                m_InFlightJobs.erase(findResult);
+            }
+        }
+
+        m_CompletionReports.Push({ job->GetKey(), status == JobStatus::Completed, durationMs });
+    }
+
+    ThreadPool m_ThreadPool;
+
+    std::mutex m_InFlightJobsMutex;
+    std::unordered_map<uint64_t, std::weak_ptr<Job>> m_InFlightJobs;
+
+    ThreadSafeQueue<CompletionReport> m_CompletionReports;
+};
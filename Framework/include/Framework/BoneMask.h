@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A set of bone indices stored as a bitset, so testing a bone does not touch the heap.
+ * Only allocates when it is created.
+ */
+class BoneMask
+{
+public:
+    BoneMask() = default;
+
+    explicit BoneMask(const size_t numBones)
+        : m_Words((numBones + BITS_PER_WORD - 1) / BITS_PER_WORD, 0)
+        , m_NumBones(numBones)
+    {}
+
+    size_t GetNumBones() const { return m_NumBones; }
+
+    // Ignores the bones out of range.
+    void Add(const size_t boneIndex)
+    {
+        if (boneIndex < m_NumBones)
+        {
+            m_Words[boneIndex / BITS_PER_WORD] |= GetBit(boneIndex);
+        }
+    }
+
+    void Remove(const size_t boneIndex)
+    {
+        if (boneIndex < m_NumBones)
+        {
+            m_Words[boneIndex / BITS_PER_WORD] &= ~GetBit(boneIndex);
+        }
+    }
+
+    bool Contains(const size_t boneIndex) const
+    {
+        return boneIndex < m_NumBones && (m_Words[boneIndex / BITS_PER_WORD] & GetBit(boneIndex)) != 0;
+    }
+
+    size_t Count() const
+    {
+        size_t count = 0;
+        for (uint64_t word : m_Words)
+        {
+            for (; word != 0; word &= word - 1)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+private:
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    static uint64_t GetBit(const size_t boneIndex)
+    {
+        return uint64_t{ 1 } << (boneIndex % BITS_PER_WORD);
+    }
+
+    std::vector<uint64_t> m_Words;
+    size_t m_NumBones = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+class Armature;
+
+/**
+ * The bone matrices of all the characters of a frame, packed into one array so that they are uploaded to a single structured buffer.
+ * A character's draw finds its matrices by the offset returned when they are added.
+ * Clear it at the start of a frame: the capacity is kept, so the steady state does not allocate.
+ * Does not depend on D3D12.
+ */
+class BonePalette
+{
+public:
+    void Clear();
+
+    /**
+     * Appends the skinning matrices (bone offset * global transform) of every bone of the armature.
+     * @return The index of the first matrix, the bone indices of the skinned vertices are relative to it.
+     */
+    uint32_t AddSkinningMatrices(const Armature& armature);
+
+    /**
+     * Appends the world matrices (global transform * world) of every bone of the armature, e.g., to draw the bones for debugging.
+     * @return The index of the first matrix.
+     */
+    uint32_t AddBoneWorldMatrices(const Armature& armature, const DirectX::XMMATRIX& world);
+
+    const std::vector<DirectX::XMMATRIX>& GetMatrices() const { return m_Matrices; }
+    uint32_t GetSize() const { return static_cast<uint32_t>(m_Matrices.size()); }
+
+private:
+    std::vector<DirectX::XMMATRIX> m_Matrices;
+};
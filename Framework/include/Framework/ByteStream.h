@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal helpers to (de)serialize plain data to and from byte buffers.
+ * Do not depend on D3D12, so the on-disk formats can be used (and tested) without a device.
+ */
+class ByteWriter
+{
+public:
+    explicit ByteWriter(std::vector<uint8_t>& bytes)
+        : m_Bytes(bytes)
+    {}
+
+    void WriteBytes(const void* data, const size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteString(const std::string& value)
+    {
+        Write(static_cast<uint32_t>(value.size()));
+        WriteBytes(value.data(), value.size());
+    }
+
+private:
+    std::vector<uint8_t>& m_Bytes;
+};
+
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t* data, const size_t size)
+        : m_Data(data)
+        , m_Size(size)
+    {}
+
+    bool ReadBytes(void* destination, const size_t size)
+    {
+        if (size > m_Size - m_Offset)
+        {
+            return false;
+        }
+
+        memcpy(destination, m_Data + m_Offset, size);
+        m_Offset += size;
+        return true;
+    }
+
+    template <typename T>
+    bool Read(T& value)
+    {
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    bool ReadString(std::string& value)
+    {
+        uint32_t size;
+        if (!Read(size) || size > GetRemainingSize())
+        {
+            return false;
+        }
+
+        value.assign(reinterpret_cast<const char*>(m_Data + m_Offset), size);
+        m_Offset += size;
+        return true;
+    }
+
+    size_t GetRemainingSize() const { return m_Size - m_Offset; }
+
+private:
+    const uint8_t* m_Data;
+    size_t m_Size;
+    size_t m_Offset = 0;
+};
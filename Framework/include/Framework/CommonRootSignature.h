@@ -28,6 +28,8 @@ public:
     }
 
     void SetMaterialConstantBuffer(CommandList& commandList, size_t size, const void* data) const;
+    // Bind constant buffer data that has already been uploaded (see CommandList::AllocateInUploadBuffer).
+    void SetMaterialConstantBuffer(CommandList& commandList, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) const;
 
     void SetModelConstantBuffer(CommandList& commandList, size_t size, const void* data) const;
 
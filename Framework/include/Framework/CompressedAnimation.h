@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Animation.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Armature;
+
+/**
+ * A clip compressed for memory and sampling throughput:
+ * - rotations are quantized with the smallest-three encoding (15 bits per component),
+ * - positions and scalings are quantized to 16 bits per component within the range of their track,
+ * - key times are quantized to 16 bits over the duration,
+ * - keys that can be interpolated from their neighbors within the tolerances are removed.
+ * Samples 4 channels at a time with SIMD: decoding, reconstruction and interpolation (nlerp for rotations) run on all 4 lanes at once.
+ * Does not depend on D3D12.
+ */
+class CompressedAnimation
+{
+public:
+    struct Settings
+    {
+        // In the units of the clip.
+        float PositionTolerance = 0.01f;
+        // In radians.
+        float RotationTolerance = 0.001f;
+        float ScalingTolerance = 0.0001f;
+    };
+
+    /**
+     * Compress the channels of a clip (the same input as Animation's).
+     * At the source keys and halfway between them, the error is within the tolerances or the quantization step of the track, whichever is larger.
+     */
+    explicit CompressedAnimation(float duration, float ticksPerSecond, const std::vector<Animation::Channel>& channels, const Settings& settings);
+    explicit CompressedAnimation(float duration, float ticksPerSecond, const std::vector<Animation::Channel>& channels);
+
+    Animation::Binding Bind(const Armature& armature) const;
+    Animation::Cursor CreateCursor() const;
+
+    // Same as Animation::Sample.
+    void Sample(const Animation::Binding& binding, double time, Animation::Cursor& cursor, Animation::Pose& transforms) const;
+
+    size_t GetChannelCount() const { return m_ChannelNodeNames.size(); }
+    double GetDurationInSeconds() const { return m_Duration / m_TicksPerSecond; }
+    size_t GetKeyCount() const { return m_KeyTimes.size(); }
+    // The memory the keys and tracks take, without the channel names.
+    size_t GetMemorySize() const;
+
+private:
+    static constexpr size_t NUM_LANES = 4;
+
+    enum TrackType
+    {
+        Position = 0,
+        Rotation,
+        Scaling,
+        NumTrackTypes,
+    };
+
+    // Rotations: the three smallest components with the index of the largest one in the top bits of the first two.
+    // Positions and scalings: the components normalized to the range of the track.
+    struct PackedKey
+    {
+        uint16_t Values[3];
+    };
+
+    // A range of the keys and how to decode them: value = Min + packed value * Scale.
+    struct Track
+    {
+        uint32_t FirstKey;
+        uint32_t NumKeys;
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Scale;
+    };
+
+    void CompressTrack(TrackType trackType, const std::vector<Animation::KeyFrame>& keyFrames, float tolerance);
+    void SampleTracks(TrackType trackType, size_t firstChannel, float time, uint32_t* keyIndices, const uint32_t* boneIndices, Animation::Pose& transforms) const;
+
+    float m_Duration;
+    float m_TicksPerSecond;
+    // The duration of a step of the quantized key times, in ticks.
+    float m_TimeStep;
+
+    std::vector<std::string> m_ChannelNodeNames;
+    // NumTrackTypes per channel.
+    std::vector<Track> m_Tracks;
+    std::vector<uint16_t> m_KeyTimes;
+    std::vector<PackedKey> m_KeyValues;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * Compact binary representation of all the animation clips of a model file, produced by ModelCooker::ImportAnimations.
+ * Keys are stored as single-precision records (Assimp keeps a double time per key), and the node names are stored once
+ * for all the clips of the file.
+ * Does not depend on D3D12 or DirectXMath.
+ */
+struct CookedAnimationFile
+{
+    static constexpr uint32_t MAGIC = 0x4D494E41; // "ANIM"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Vector3Key
+    {
+        float Time;
+        float Value[3];
+    };
+
+    // The value is (x, y, z, w).
+    struct QuaternionKey
+    {
+        float Time;
+        float Value[4];
+    };
+
+    struct Channel
+    {
+        // Index into m_NodeNames.
+        uint32_t NodeIndex;
+        std::vector<Vector3Key> PositionKeys;
+        std::vector<QuaternionKey> RotationKeys;
+        std::vector<Vector3Key> ScalingKeys;
+    };
+
+    struct Clip
+    {
+        std::string Name;
+        // In ticks, as are the key times.
+        float Duration;
+        // 0 if not specified by the source file.
+        float TicksPerSecond;
+        std::vector<Channel> Channels;
+    };
+
+    // Shared by the channels of all the clips.
+    std::vector<std::string> m_NodeNames;
+    std::vector<Clip> m_Clips;
+
+    std::vector<uint8_t> Serialize() const;
+    // Returns false if the data is corrupted or has been written by an incompatible version.
+    bool Deserialize(const uint8_t* data, size_t size);
+
+    // Returns false if the file does not exist or cannot be deserialized.
+    bool Read(const std::filesystem::path& path);
+    void Write(const std::filesystem::path& path) const;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <DX12Library/MemoryMappedFile.h>
+
+#include "MeshOptimization.h"
+#include "VertexLayout.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Versioned binary representation of an imported model, produced offline by ModelCooker.
+ * Vertices are stored encoded with the vertex layout of the file, and indices are narrowed to 16 bits when possible,
+ * so that the streams of a memory-mapped file can be uploaded without any per-vertex conversion.
+ * The LODs of a mesh are consecutive ranges of its index stream and share its vertices.
+ * Does not depend on D3D12 or DirectXMath.
+ */
+struct CookedModelFile
+{
+    static constexpr uint32_t MAGIC = 0x4C444D43; // "CMDL"
+    static constexpr uint32_t VERSION = 5;
+
+    // The normals have been flipped during import (see ModelLoader::LoadAsMeshPrototypes).
+    static constexpr uint32_t FLAG_FLIP_NORMALS = 1u << 0;
+    // The meshes have been reordered for rendering (see ModelCooker::Optimize).
+    static constexpr uint32_t FLAG_OPTIMIZED = 1u << 1;
+
+    // All the streams start at this alignment relative to the beginning of the file.
+    static constexpr uint64_t STREAM_ALIGNMENT = 16;
+
+    struct Vertex
+    {
+        float Position[4];
+        float Normal[4];
+        float Uv[4];
+        float Tangent[4];
+        float Bitangent[4];
+    };
+
+    static constexpr uint32_t BONES_PER_VERTEX = 4;
+
+    struct SkinningVertex
+    {
+        uint32_t BoneIds[BONES_PER_VERTEX];
+        float Weights[BONES_PER_VERTEX];
+    };
+
+    using Index = uint32_t;
+    static constexpr size_t MAX_VERTICES_FOR_16_BIT_INDICES = 1 << 16;
+
+    // Matrices are row-major and follow the DirectXMath (left-handed) convention.
+    // The bones of a mesh are sorted so that parents come before their children (see Armature).
+    struct Bone
+    {
+        std::string Name;
+        float Offset[16];
+        float LocalTransform[16];
+        std::vector<uint32_t> Children;
+    };
+
+    struct Mesh
+    {
+        // Encoded with the vertex layout of the file on serialization.
+        std::vector<Vertex> Vertices;
+        std::vector<Index> Indices;
+        // Simplified versions of Indices (see ModelCooker::Optimize). Stored after Indices in the index stream.
+        std::vector<MeshOptimization::Lod> Lods;
+        // Empty if the mesh is not skinned.
+        std::vector<SkinningVertex> SkinningVertices;
+        std::vector<Bone> Bones;
+        float AabbMin[3];
+        float AabbMax[3];
+    };
+
+    // On-disk records. Offsets are relative to the beginning of the file.
+
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t Flags;
+        uint32_t NumMeshes;
+        uint64_t FileSize;
+        uint64_t MeshesOffset;
+        uint32_t VertexLayout; // see VertexLayout::Pack
+        uint32_t Padding;
+    };
+
+    struct MeshRecord
+    {
+        uint64_t VerticesOffset;
+        uint64_t IndicesOffset;
+        uint64_t SkinningVerticesOffset;
+        uint64_t BonesOffset;
+        uint64_t LodsOffset;
+        uint32_t NumVertices;
+        // The total of all the LODs.
+        uint32_t NumIndices;
+        uint32_t NumSkinningVertices;
+        uint32_t NumBones;
+        uint32_t VertexStride;
+        uint32_t IndexStride;
+        uint32_t SkinningVertexStride;
+        // At least one: the first LOD is the full mesh.
+        uint32_t NumLods;
+        float AabbMin[4];
+        float AabbMax[4];
+    };
+
+    // A range of the index stream of a mesh.
+    struct LodRecord
+    {
+        uint32_t IndexOffset;
+        uint32_t NumIndices;
+        // Relative to the mesh extents.
+        float Error;
+        uint32_t Padding;
+    };
+
+    struct BoneRecord
+    {
+        float Offset[16];
+        float LocalTransform[16];
+        uint64_t NameOffset;
+        uint64_t ChildrenOffset;
+        uint32_t NameLength;
+        uint32_t NumChildren;
+    };
+
+    uint32_t m_Flags = 0;
+    VertexLayout m_VertexLayout = VertexLayout::Full();
+    std::vector<Mesh> m_Meshes;
+
+    std::vector<uint8_t> Serialize() const;
+    void Write(const std::filesystem::path& path) const;
+};
+
+/**
+ * A read-only view of a cooked model. The streams point directly into the file (or the buffer) the view has been created from.
+ */
+class CookedModelView
+{
+public:
+    struct MeshView
+    {
+        // Encoded with the vertex layout of the model.
+        const void* Vertices;
+        uint32_t NumVertices;
+        uint32_t VertexStride;
+        // 16- or 32-bit.
+        const void* Indices;
+        uint32_t NumIndices;
+        uint32_t IndexStride;
+        const CookedModelFile::SkinningVertex* SkinningVertices;
+        uint32_t NumSkinningVertices;
+        const CookedModelFile::BoneRecord* Bones;
+        uint32_t NumBones;
+        const CookedModelFile::LodRecord* Lods;
+        uint32_t NumLods;
+        const float* AabbMin;
+        const float* AabbMax;
+    };
+
+    /**
+     * Memory-map a cooked model.
+     * @return false if the file does not exist, is corrupted, or has been written by an incompatible version.
+     */
+    bool Open(const std::filesystem::path& path);
+
+    // Take ownership of the serialized model (see CookedModelFile::Serialize).
+    bool Load(std::vector<uint8_t>&& bytes);
+
+    uint32_t GetFlags() const { return m_Header->Flags; }
+    const VertexLayout& GetVertexLayout() const { return m_VertexLayout; }
+    uint32_t GetMeshCount() const { return m_Header->NumMeshes; }
+    MeshView GetMesh(uint32_t meshIndex) const;
+
+    std::string_view GetBoneName(const CookedModelFile::BoneRecord& bone) const;
+    const uint32_t* GetBoneChildren(const CookedModelFile::BoneRecord& bone) const;
+
+private:
+    bool Parse();
+    bool IsRangeValid(uint64_t offset, uint64_t count, uint64_t stride, uint64_t alignment) const;
+
+    MemoryMappedFile m_File;
+    std::vector<uint8_t> m_Bytes;
+
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+    const CookedModelFile::Header* m_Header = nullptr;
+    VertexLayout m_VertexLayout{};
+    const CookedModelFile::MeshRecord* m_MeshRecords = nullptr;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Animation.h"
+#include "AnimationBlendTree.h"
+
+#include <cstdint>
+#include <vector>
+
+class Armature;
+class ThreadPool;
+
+/**
+ * Animates many characters: every character evaluates its blend tree, applies the pose to its armature and updates the global transforms.
+ * The characters are independent, so they are split into jobs of a few characters that run on the worker threads of a thread pool.
+ * Does not depend on D3D12.
+ */
+class CrowdAnimator
+{
+public:
+    using CharacterId = uint32_t;
+
+    /**
+     * @param threadPool If null, the characters are updated on the calling thread.
+     * @param charactersPerJob Small enough to balance the load, large enough to amortize the scheduling.
+     */
+    explicit CrowdAnimator(ThreadPool* threadPool, size_t charactersPerJob = 8);
+
+    /**
+     * The armature must outlive the animator. Add the nodes of the character to its blend tree before the next update.
+     * @param timeOffset In seconds, so that the characters of a crowd do not move in sync.
+     */
+    CharacterId AddCharacter(Armature& armature, double timeOffset = 0.0);
+
+    AnimationBlendTree& GetBlendTree(CharacterId characterId) { return m_Characters[characterId].m_BlendTree; }
+    size_t GetCharacterCount() const { return m_Characters.size(); }
+
+    // Blocks until all the characters are updated. An exception thrown by a character is rethrown.
+    void Update(double time);
+
+private:
+    struct Character
+    {
+        Armature* m_Armature;
+        AnimationBlendTree m_BlendTree;
+        Animation::Pose m_Pose;
+        double m_TimeOffset;
+    };
+
+    void UpdateCharacter(Character& character, double time);
+
+    ThreadPool* m_ThreadPool;
+    size_t m_CharactersPerJob;
+    std::vector<Character> m_Characters;
+};
@@ -5,10 +5,13 @@
 #include <shellapi.h>
 
 #include <DX12Library/Application.h>
+#include <DX12Library/TextureStreamer.h>
 
 #include <dxgidebug.h>
 
 #include <Framework/GraphicsSettings.h>
+#include <Framework/PipelineStateCache.h>
+#include <Framework/PipelineStateCompiler.h>
 
 
 #ifdef DEMO_TYPE
@@ -94,10 +97,16 @@ int CALLBACK wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdL
 	ParseCommandLineArguments(parameters);
 
 	Application::Create(hInstance);
+	PipelineStateCache::Create(L"PipelineStateCache.bin");
+	PipelineStateCompiler::Create();
+	TextureStreamer::Create();
 	{
 		const auto demo = CreateGame(parameters);
 		retCode = Application::Get().Run(demo);
 	}
+	TextureStreamer::Destroy();
+	PipelineStateCompiler::Destroy();
+	PipelineStateCache::Destroy();
 	Application::Destroy();
 
 	atexit(&ReportLiveObjects);
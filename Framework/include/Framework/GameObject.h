@@ -3,12 +3,14 @@
 #include <DirectXMath.h>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include <Framework/Aabb.h>
 
 class Model;
 class CommandList;
 class Material;
+class LodSelector;
 
 class GameObject
 {
@@ -17,6 +19,13 @@ public:
 
     void Draw(CommandList& commandList) const;
 
+    // Picks the LOD of every mesh for the following draws from the projected size of the AABB. Until then, the meshes are drawn at full detail.
+    void SelectLods(const LodSelector& lodSelector);
+    [[nodiscard]] uint32_t GetMeshLod(size_t meshIndex) const;
+
+    // Requests the mips of the streamed material textures from the projected size of the AABB.
+    void RequestTextureMips(const LodSelector& lodSelector, float viewportHeight) const;
+
     [[nodiscard]] const DirectX::XMMATRIX& GetWorldMatrix() const;
     [[nodiscard]] DirectX::XMMATRIX& GetWorldMatrix();
     [[nodiscard]] std::shared_ptr<const Model> GetModel() const;
@@ -39,4 +48,5 @@ private:
     Aabb m_Aabb;
     std::shared_ptr<Model> m_Model{};
     std::shared_ptr<Material> m_Material;
+    std::vector<uint32_t> m_MeshLods;
 };
@@ -11,9 +11,20 @@ struct GraphicsSettings
 		float m_PoissonSpread;
 	};
 
+	struct ShadowCascadesSettings
+	{
+		uint32_t m_CascadesCount;
+		// 0 - uniform splits, 1 - logarithmic splits
+		float m_LogarithmicSplitWeight;
+		// view depth where the directional light shadows end
+		float m_MaxDistance;
+	};
+
 	bool VSync = false;
 
+	// resolution is per cascade
 	ShadowsSettings DirectionalLightShadows{ 2048, 1.0f, 0.002f, 750.0f };
+	ShadowCascadesSettings DirectionalLightShadowCascades{ 4, 0.75f, 150.0f };
 	// resolution is only a single cubemap side
 	ShadowsSettings PointLightShadows{ 256, 0.5f, 0.1f, 250.0f };
 
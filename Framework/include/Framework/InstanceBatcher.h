@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Groups the instances of a frame by what they are drawn with (e.g., a mesh and a material), so that every group is a single instanced draw.
+ * The instances of a batch are contiguous, a draw reads them starting from the batch's first instance.
+ * Within a batch, the instances keep the order they were added in.
+ * Clear it at the start of a frame: the capacity is kept, so the steady state does not allocate.
+ * Does not depend on D3D12.
+ * @tparam TKey Ordered with TCompare. Instances with equivalent keys are drawn together.
+ * @tparam TInstance The per-instance data uploaded to the GPU.
+ */
+template <typename TKey, typename TInstance, typename TCompare = std::less<TKey>>
+class InstanceBatcher
+{
+public:
+    struct Batch
+    {
+        TKey Key;
+        uint32_t FirstInstance;
+        uint32_t NumInstances;
+    };
+
+    void Clear()
+    {
+        m_Entries.clear();
+        m_Instances.clear();
+        m_Batches.clear();
+    }
+
+    void Add(const TKey& key, const TInstance& instance)
+    {
+        m_Entries.push_back({ key, instance, static_cast<uint32_t>(m_Entries.size()) });
+    }
+
+    // Sorts the added instances into batches. Call after all the instances of the frame have been added.
+    void Build()
+    {
+        // The order the instances were added in breaks the ties, so the result does not depend on the sort being stable.
+        const TCompare compare;
+        std::sort(m_Entries.begin(), m_Entries.end(), [&compare](const Entry& entry1, const Entry& entry2)
+            {
+                if (compare(entry1.Key, entry2.Key))
+                {
+                    return true;
+                }
+                if (compare(entry2.Key, entry1.Key))
+                {
+                    return false;
+                }
+                return entry1.Order < entry2.Order;
+            });
+
+        m_Instances.clear();
+        m_Batches.clear();
+
+        for (const auto& entry : m_Entries)
+        {
+            if (m_Batches.empty() || compare(m_Batches.back().Key, entry.Key))
+            {
+                m_Batches.push_back({ entry.Key, static_cast<uint32_t>(m_Instances.size()), 0 });
+            }
+
+            m_Instances.push_back(entry.Instance);
+            ++m_Batches.back().NumInstances;
+        }
+    }
+
+    const std::vector<TInstance>& GetInstances() const { return m_Instances; }
+    const std::vector<Batch>& GetBatches() const { return m_Batches; }
+
+private:
+    struct Entry
+    {
+        TKey Key;
+        TInstance Instance;
+        uint32_t Order;
+    };
+
+    std::vector<Entry> m_Entries;
+    std::vector<TInstance> m_Instances;
+    std::vector<Batch> m_Batches;
+};
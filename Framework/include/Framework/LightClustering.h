@@ -0,0 +1,145 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Assigns lights to the clusters of a view frustum (froxels): a grid of screen tiles, split in view depth by exponential slices
+ * between the near and the far planes, so that a single full-screen pass can shade every pixel with only the lights of its cluster.
+ * A point light is a sphere. A spot light is the spherical sector of its range and cone: its bounding sphere is tested first,
+ * then the cone against the bounding sphere of the cluster.
+ * The clusters of a row are tested 4 at a time. Vectorized with DirectXMath (SSE/AVX2 on x64, NEON on ARM).
+ * Does not depend on D3D12.
+ */
+class LightClustering
+{
+public:
+    struct Settings
+    {
+        uint32_t TilesX = 16;
+        uint32_t TilesY = 9;
+        uint32_t SlicesCount = 24;
+    };
+
+    // The sphere lit by a point light.
+    struct PointLightBounds
+    {
+        DirectX::XMFLOAT3 PositionWs;
+        float Radius;
+    };
+
+    // The spherical sector lit by a spot light.
+    struct SpotLightBounds
+    {
+        DirectX::XMFLOAT3 PositionWs;
+        float Radius;
+        // Normalized.
+        DirectX::XMFLOAT3 DirectionWs;
+        // From the direction to the edge of the cone, in radians.
+        float HalfAngle;
+    };
+
+    // The lights of a cluster are GetLightIndices()[Offset, Offset + Count). Matches uint2 in HLSL.
+    struct Cluster
+    {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+    // Matches the CBuffer of the clustered light pass.
+    struct ShaderParameters
+    {
+        uint32_t TilesX;
+        uint32_t TilesY;
+        uint32_t SlicesCount;
+        // The light indices below it are point lights, the others are spot lights (minus NumPointLights).
+        uint32_t NumPointLights;
+        // slice = floor(log2(view depth) * SliceScale + SliceBias)
+        float SliceScale;
+        float SliceBias;
+        float _Padding[2];
+    };
+
+    /**
+     * Assigns the lights to the clusters of a view.
+     * @param view, projection A left-handed perspective with the depth in [0, 1], as Camera returns them.
+     * The tiles go from the left to the right, and from the top to the bottom of the screen.
+     * The lights of a cluster are sorted: the point lights, then the spot lights, in the order given.
+     */
+    void Build(const Settings& settings, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+        const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights);
+
+    /**
+     * The same as Build, without the SIMD tests and without skipping any cluster: every light is tested against every cluster, one at a time.
+     * The reference that Build must match exactly.
+     */
+    void BuildReference(const Settings& settings, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+        const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights);
+
+    uint32_t GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const;
+    const std::vector<Cluster>& GetClusters() const { return m_Clusters; }
+    const std::vector<uint32_t>& GetLightIndices() const { return m_LightIndices; }
+
+    // The view depth where a slice begins. The one at SlicesCount is the far plane.
+    float GetSliceDistance(uint32_t slice) const;
+
+    ShaderParameters GetShaderParameters() const;
+
+private:
+    static constexpr uint32_t LANES_COUNT = 4;
+
+    // In view space.
+    struct LightVolume
+    {
+        // The bounding sphere.
+        DirectX::XMFLOAT3 Center;
+        float Radius;
+
+        bool IsSpotLight;
+        DirectX::XMFLOAT3 Apex;
+        DirectX::XMFLOAT3 Direction;
+        float Range;
+        float CosHalfAngle;
+        float SinHalfAngle;
+    };
+
+    // The view-space bounds of 4 neighboring tiles of a slice along X.
+    struct TileGroupBoundsX
+    {
+        DirectX::XMFLOAT4A Min;
+        DirectX::XMFLOAT4A Max;
+    };
+
+    void Prepare(const Settings& settings, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+        const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights);
+    bool Intersects(const LightVolume& light, uint32_t tileX, uint32_t tileY, uint32_t slice) const;
+    // Returns a bit per tile of the group.
+    uint32_t IntersectsTileGroup(const LightVolume& light, uint32_t tileGroupX, uint32_t tileY, uint32_t slice) const;
+    // Gathers m_Hits into m_Clusters and m_LightIndices.
+    void Finish();
+
+    float GetTileMinX(uint32_t tileX, uint32_t slice) const;
+    float GetTileMaxX(uint32_t tileX, uint32_t slice) const;
+
+    Settings m_Settings;
+    uint32_t m_TileGroupsCountX = 0;
+    uint32_t m_NumPointLights = 0;
+    float m_NearPlane = 0.0f;
+    float m_FarPlane = 0.0f;
+
+    std::vector<float> m_SliceDistances;
+    // Per slice.
+    std::vector<TileGroupBoundsX> m_TileGroupBoundsX;
+    std::vector<float> m_TileMinY;
+    std::vector<float> m_TileMaxY;
+
+    std::vector<LightVolume> m_LightVolumes;
+    // The cluster index and the light index of every intersection, in the order of the lights.
+    std::vector<std::pair<uint32_t, uint32_t>> m_Hits;
+
+    std::vector<Cluster> m_Clusters;
+    std::vector<uint32_t> m_LightIndices;
+};
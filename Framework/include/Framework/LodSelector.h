@@ -0,0 +1,55 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+
+struct Aabb;
+
+/**
+ * Picks mesh LODs from the projected size of their bounds.
+ * Created once per frame and shared by all the objects, so that a selection costs a few vector operations.
+ * Does not depend on D3D12.
+ */
+class LodSelector
+{
+public:
+    // About two pixels at 1080p.
+    static constexpr float DEFAULT_MAX_SCREEN_ERROR = 2.0f / 1080.0f;
+
+    LodSelector(const DirectX::XMMATRIX& viewMatrix, const DirectX::XMMATRIX& projectionMatrix, float maxScreenError = DEFAULT_MAX_SCREEN_ERROR);
+
+    /**
+     * The diameter of the bounding sphere of a world-space AABB projected to the screen, relative to the viewport height.
+     * Spheres that contain the camera are projected as if they were in front of it.
+     */
+    float ComputeScreenSize(const Aabb& aabb) const;
+
+    // @param lods Mesh::Lod or MeshOptimization::Lod, at least one.
+    template <typename TLod>
+    uint32_t SelectLod(const TLod* lods, const uint32_t lodCount, const float screenSize) const
+    {
+        return SelectLod(lods, lodCount, screenSize, m_MaxScreenError);
+    }
+
+    /**
+     * The coarsest LOD whose error, projected to the screen, does not exceed maxScreenError.
+     * @param lods The errors grow with the LOD index, and the first LOD has none.
+     */
+    template <typename TLod>
+    static uint32_t SelectLod(const TLod* lods, const uint32_t lodCount, const float screenSize, const float maxScreenError)
+    {
+        uint32_t lodIndex = lodCount - 1;
+        while (lodIndex > 0 && lods[lodIndex].Error * screenSize > maxScreenError)
+        {
+            --lodIndex;
+        }
+
+        return lodIndex;
+    }
+
+private:
+    DirectX::XMVECTOR m_ViewDepthAxis;
+    float m_ProjectionScale;
+    float m_MaxScreenError;
+};
@@ -2,14 +2,21 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <type_traits>
+#include <vector>
 
 #include <DX12Library/CommandList.h>
+#include <DX12Library/HashUtils.h>
+#include <DX12Library/Helpers.h>
 
 #include <wrl.h>
 #include <d3d12.h>
 
+#include "MaterialConstantBuffer.h"
 #include "Shader.h"
 #include "ShaderResourceView.h"
 
@@ -39,6 +46,25 @@ public:
 	    SetVariable(name, sizeof(T) * data.size(), data.data(), true, throwOnNotFound);
 	}
 
+	/**
+	 * @param nameHash HashUtils::Fnv1a of the variable name, can be computed at compile time.
+	 * @return An invalid handle if the variable is not found.
+	 */
+	MaterialParameterHandle FindParameter(uint64_t nameHash) const;
+	MaterialParameterHandle FindParameter(std::string_view name) const { return FindParameter(HashUtils::Fnv1a(name)); }
+
+	// Setting an invalid handle is a no-op, so optional variables do not need to be checked.
+	template<typename T> void SetVariable(const MaterialParameterHandle& handle, const T& data)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be copied to the constant buffer.");
+		WriteVariable(handle, sizeof(T), &data, false);
+	}
+
+	template<typename T> void SetArrayVariable(const MaterialParameterHandle& handle, const std::vector<T>& data)
+	{
+		WriteVariable(handle, sizeof(T) * data.size(), data.data(), true);
+	}
+
 	void SetShaderResourceView(const std::string& name, const ShaderResourceView& shaderResourceView);
 
 	void Bind(CommandList& commandList);
@@ -48,20 +74,27 @@ public:
 	void BeginBatch(CommandList& commandList);
 	void EndBatch(CommandList& commandList);
 
+	// Report the screen size of this frame's draws to the texture streamer, which picks the mips of the streamed textures from it.
+	void RequestTextureScreenSize(float screenSizeInPixels) const;
+
 	static std::shared_ptr<Material> Create(const std::shared_ptr<Shader>& shader);
 	static std::shared_ptr<Material> Create(const Material& materialPreset);
 
 private:
 
     void SetVariable(const std::string& name, size_t size, const void* data, bool array = false, bool throwOnNotFound = true);
+	// Throws if the size does not match the variable (or exceeds it, for an array).
+	void WriteVariable(const MaterialParameterHandle& handle, size_t size, const void* data, bool array);
 
 	void UploadConstantBuffer(CommandList& commandList);
 	void UploadShaderResourceViews(CommandList& commandList);
 
 	std::shared_ptr<Shader> m_Shader;
-	const ShaderUtils::ConstantBufferMetadata* m_Metadata;
-	std::unique_ptr<uint8_t[]> m_ConstantBuffer = nullptr;
-	size_t m_ConstantBufferSize;
+	const ShaderUtils::ConstantBufferMetadata* m_Metadata = nullptr;
+	const std::unordered_map<uint64_t, size_t>* m_VariablesNameHashCache = nullptr;
+	// Null if the shaders have no material constant buffer.
+	std::unique_ptr<MaterialConstantBuffer> m_ConstantBuffer;
 
-	std::unordered_map <std::string, ShaderResourceView> m_ShaderResourceViews;
+	// Indexed by Shader::ShaderResourceViewId.
+	std::vector<std::optional<ShaderResourceView>> m_ShaderResourceViews;
 };
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A material constant buffer variable resolved once with Material::FindParameter.
+ * Valid for all the materials sharing the same constant buffer layout (e.g., created from the same shader).
+ */
+struct MaterialParameterHandle
+{
+    uint32_t Offset = 0;
+    uint32_t Size = 0;
+    const void* Layout = nullptr;
+
+    bool IsValid() const { return Layout != nullptr; }
+};
+
+/**
+ * The CPU copy of the constant buffer of a material and its upload state.
+ * Writes mark it dirty only when the bytes change, and the last upload is reused until it is dirty
+ * or the upload buffer it lives in has been reset (i.e., its generation has changed).
+ * Does not depend on D3D12.
+ */
+class MaterialConstantBuffer
+{
+public:
+    // @param layout Identifies the variable layout that the handles must have been resolved for.
+    MaterialConstantBuffer(size_t size, const void* layout);
+    MaterialConstantBuffer(const MaterialConstantBuffer& other);
+
+    MaterialConstantBuffer& operator=(const MaterialConstantBuffer& other) = delete;
+
+    size_t GetSize() const { return m_Size; }
+    const void* GetLayout() const { return m_Layout; }
+    uint8_t* GetData() { return m_Data.get(); }
+    const uint8_t* GetData() const { return m_Data.get(); }
+
+    /**
+     * Writing to an invalid handle is a no-op.
+     * Throws if the size does not match the variable (or exceeds it, for an array),
+     * or if the handle has been resolved for a different layout.
+     */
+    void Write(const MaterialParameterHandle& handle, size_t size, const void* data, bool array);
+    // Throws if the size does not match the constant buffer's.
+    void WriteAll(size_t size, const void* data);
+
+    bool IsDirty() const { return m_IsDirty; }
+
+    // Whether the data has to be uploaded again, rather than binding GetUploadedAddress().
+    bool NeedsUpload(uint64_t uploadBufferGeneration) const;
+    void OnUploaded(uint64_t uploadBufferGeneration, uint64_t uploadedAddress);
+    uint64_t GetUploadedAddress() const { return m_UploadedAddress; }
+
+private:
+    std::unique_ptr<uint8_t[]> m_Data;
+    size_t m_Size;
+    const void* m_Layout;
+
+    bool m_IsDirty = true;
+    uint64_t m_UploadBufferGeneration = 0;
+    uint64_t m_UploadedAddress = 0;
+};
@@ -47,6 +47,10 @@
 #include <Framework/Aabb.h>
 #include <Framework/Armature.h>
 #include <Framework/Bone.h>
+#include <Framework/CookedModelFile.h>
+#include <Framework/MeshOptimization.h>
+#include <Framework/VertexInputLayout.h>
+#include <Framework/VertexLayout.h>
 
 struct Bone;
 
@@ -88,9 +92,12 @@ struct VertexAttributes
     DirectX::XMFLOAT4 Tangent{};
     DirectX::XMFLOAT4 Bitangent{};
 
+    // The layout vertex buffers are stored in. The input elements are generated from it.
+    static constexpr VertexLayout LAYOUT = VertexLayout::Compact();
+
     static constexpr uint32_t VERTEX_BUFFER_SLOT_INDEX = 0;
-    static constexpr int INPUT_ELEMENT_COUNT = 5;
-    static const D3D12_INPUT_ELEMENT_DESC INPUT_ELEMENTS[INPUT_ELEMENT_COUNT];
+    static constexpr int INPUT_ELEMENT_COUNT = LAYOUT.GetStoredAttributeCount();
+    static constexpr auto INPUT_ELEMENTS = VertexInputLayout::Create(LAYOUT, VERTEX_BUFFER_SLOT_INDEX);
 
 private:
     static DirectX::XMFLOAT4 Extend(const DirectX::XMFLOAT2& value)
@@ -123,9 +130,12 @@ struct SkinningVertexAttributes
     static const D3D12_INPUT_ELEMENT_DESC INPUT_ELEMENTS[INPUT_ELEMENT_COUNT];
 };
 
+static_assert(sizeof(VertexAttributes) == VertexLayout::SOURCE_STRIDE);
+
 using VertexCollectionType = std::vector<VertexAttributes>;
 using SkinningVertexCollectionType = std::vector<SkinningVertexAttributes>;
-using IndexCollectionType = std::vector<uint16_t>;
+// Narrowed to 16 bits on upload when the vertices allow it.
+using IndexCollectionType = std::vector<uint32_t>;
 
 struct MeshPrototype
 {
@@ -135,22 +145,53 @@ struct MeshPrototype
     SkinningVertexCollectionType m_SkinningVertexAttributes;
     Armature m_Armature;
 
+    // Simplified index buffers referencing m_Vertices, generated by Optimize.
+    std::vector<MeshOptimization::Lod> m_Lods;
+
     MeshPrototype() = default;
     MeshPrototype(VertexCollectionType&& vertices, IndexCollectionType&& indices, bool rhCoords = true, bool generateTangents = false);
 
     void AddVertexAttributes(const MeshPrototype& otherPrototype);
+
+    /**
+     * Reorders the triangles and the vertices (skinning attributes included) for rendering, and generates the LODs.
+     * Vertices that are not referenced by any triangle are removed.
+     * @return The statistics before and after the optimization.
+     */
+    MeshOptimization::Result Optimize(const MeshOptimization::Settings& settings = {});
 };
 
 class Mesh final
 {
 public:
     static constexpr D3D_PRIMITIVE_TOPOLOGY PRIMITIVE_TOPOLOGY = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    static constexpr size_t MAX_VERTICES_FOR_16_BIT_INDICES = 1 << 16;
 
-    void Draw(CommandList& commandList, uint32_t instanceCount = 1) const;
+    // A range of the index buffer. All the LODs share the vertex buffer; the first one is the full mesh.
+    struct Lod
+    {
+        UINT StartIndex;
+        UINT IndexCount;
+        // Relative to the mesh extents (see MeshOptimization::Lod).
+        float Error;
+    };
+
+    // The LOD index is clamped to the available ones.
+    void Draw(CommandList& commandList, uint32_t instanceCount = 1, uint32_t lodIndex = 0) const;
     void Bind(CommandList& commandList) const;
 
+    // Of the full mesh.
     UINT GetIndexCount() const;
 
+    uint32_t GetLodCount() const;
+    const Lod& GetLod(uint32_t lodIndex) const;
+
+    /**
+     * The coarsest LOD whose error, projected to the screen, does not exceed maxScreenError.
+     * @param screenSize The projected size of the mesh relative to the viewport height (see LodSelector).
+     */
+    uint32_t SelectLod(float screenSize, float maxScreenError) const;
+
     static std::shared_ptr<Mesh> CreateCube(CommandList& commandList, float size = 1, bool rhCoords = false);
     static std::shared_ptr<Mesh> CreateSphere(CommandList& commandList, float diameter = 1, size_t tessellation = 16,
         bool rhCoords = false);
@@ -170,6 +211,10 @@ public:
         IndexCollectionType& indices, bool rhCoords = false,
         bool generateTangents = false);
     static std::shared_ptr<Mesh> CreateMesh(CommandList& commandList, const MeshPrototype& prototype);
+    // Uploads the streams directly from the cooked model, without intermediate copies.
+    static std::shared_ptr<Mesh> CreateMesh(CommandList& commandList, const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh);
+
+    static Armature CreateArmature(const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh);
 
     Mesh(const Mesh& copy) = delete;
     ~Mesh();
@@ -188,6 +233,7 @@ private:
     void Initialize(CommandList& commandList, VertexCollectionType& vertices, IndexCollectionType& indices,
         bool rhCoords);
     void Initialize(CommandList& commandList, const MeshPrototype& prototype);
+    void Initialize(CommandList& commandList, const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh);
     void CalculateAabb(const VertexCollectionType& vertices);
 
     VertexBuffer m_VertexBuffer;
@@ -198,5 +244,5 @@ private:
 
 
     Aabb m_Aabb{};
-    UINT m_IndexCount;
+    std::vector<Lod> m_Lods;
 };
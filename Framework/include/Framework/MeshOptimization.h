@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Reorders triangle lists and their vertices for the post-transform vertex cache, overdraw and vertex fetch (via meshoptimizer),
+ * and simplifies them into LODs. The triangles themselves are not changed: only their order and the order of the vertices.
+ * Does not depend on D3D12 or DirectXMath, so that both MeshPrototype and ModelCooker can use it.
+ */
+namespace MeshOptimization
+{
+    struct Settings
+    {
+        bool OptimizeVertexCache = true;
+        bool OptimizeOverdraw = true;
+        // How much the vertex cache efficiency (ACMR) may degrade in exchange for less overdraw.
+        float OverdrawThreshold = 1.05f;
+        bool OptimizeVertexFetch = true;
+
+        // Simplified index buffers generated in addition to the original one. They reference the same vertices.
+        uint32_t MaxLods = 0;
+        // The target index count of each LOD relative to the previous one.
+        float LodReduction = 0.5f;
+        // Relative to the mesh extents.
+        float LodTargetError = 1e-2f;
+        // Stop once a LOD does not get at least this much smaller than the previous one.
+        float LodMinReduction = 0.95f;
+    };
+
+    struct Statistics
+    {
+        // Average cache miss ratio: transformed vertices per triangle (0.5 at best, 3 at worst).
+        float Acmr = 0.0f;
+        // Average transformed vertex ratio: transformed vertices per vertex (1 at best).
+        float Atvr = 0.0f;
+        // Shaded pixels per covered pixel, measured by a software rasterizer (1 at best).
+        float Overdraw = 0.0f;
+        // Fetched bytes per vertex buffer byte (1 at best).
+        float Overfetch = 0.0f;
+    };
+
+    struct Lod
+    {
+        std::vector<uint32_t> Indices;
+        // The deviation from the original mesh, relative to its extents.
+        float Error = 0.0f;
+    };
+
+    struct Result
+    {
+        Statistics Before;
+        Statistics After;
+
+        // Old vertex index -> new vertex index, or UNUSED_VERTEX if the vertex is not referenced. Empty if the vertices have not been reordered.
+        std::vector<uint32_t> VertexRemap;
+        size_t NumVertices = 0;
+
+        std::vector<Lod> Lods;
+    };
+
+    constexpr uint32_t UNUSED_VERTEX = ~0u;
+
+    // A post-transform cache of 16 vertices is the conventional reference for ACMR/ATVR.
+    constexpr uint32_t REFERENCE_VERTEX_CACHE_SIZE = 16;
+
+    /**
+     * @param positions float3 positions, positionStride bytes apart.
+     * @param vertexSize The size of a vertex in the vertex buffer, used to measure the overfetch.
+     */
+    Statistics Analyze(const uint32_t* indices, size_t numIndices,
+        const float* positions, size_t numVertices, size_t positionStride, size_t vertexSize);
+
+    /**
+     * Optimizes the index buffer in place. The vertex buffers are not modified: apply Result::VertexRemap with RemapVertices.
+     * The indices of the LODs are already remapped.
+     */
+    Result Optimize(std::vector<uint32_t>& indices,
+        const float* positions, size_t numVertices, size_t positionStride, size_t vertexSize,
+        const Settings& settings = {});
+
+    template <typename T>
+    void RemapVertices(std::vector<T>& vertices, const Result& result)
+    {
+        if (result.VertexRemap.empty() || vertices.empty())
+        {
+            return;
+        }
+
+        std::vector<T> remappedVertices(result.NumVertices);
+
+        for (size_t vertexIndex = 0; vertexIndex < vertices.size(); ++vertexIndex)
+        {
+            const uint32_t newIndex = result.VertexRemap[vertexIndex];
+            if (newIndex != UNUSED_VERTEX)
+            {
+                remappedVertices[newIndex] = vertices[vertexIndex];
+            }
+        }
+
+        vertices = std::move(remappedVertices);
+    }
+}
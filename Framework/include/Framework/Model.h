@@ -23,6 +23,8 @@ public:
 	virtual ~Model();
 
 	void Draw(CommandList& commandList) const;
+	// One LOD index per mesh (see Mesh::Draw).
+	void Draw(CommandList& commandList, const std::vector<uint32_t>& meshLods) const;
 
 	const MeshCollectionType& GetMeshes() const;
 
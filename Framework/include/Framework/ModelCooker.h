@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CookedAnimationFile.h"
+#include "CookedModelFile.h"
+#include "MeshOptimization.h"
+
+#include <filesystem>
+#include <string>
+
+class ThreadPool;
+
+/**
+ * Imports models with Assimp and converts them into the cooked representation.
+ * Used both offline (the ModelCooker tool) and by ModelLoader when a model has not been cooked yet.
+ * Does not depend on D3D12 or DirectXMath.
+ */
+class ModelCooker
+{
+public:
+    /**
+     * Throws std::runtime_error if the model cannot be imported.
+     * @param threadPool If not null, the meshes are converted in parallel. The output does not depend on the number of threads.
+     */
+    static CookedModelFile Import(const std::string& path, bool flipNormals = false, ThreadPool* threadPool = nullptr);
+
+    /**
+     * Imports all the animation clips of the file in a single pass. Returns an empty file if there are none.
+     * Throws std::runtime_error if the file cannot be imported.
+     */
+    static CookedAnimationFile ImportAnimations(const std::string& path);
+
+    /**
+     * Reorders the triangles and the vertices of every mesh and generates its LODs (see MeshOptimization::Optimize).
+     * The statistics are measured with the vertex layout of the model.
+     * @return The results of the meshes, in order.
+     */
+    static std::vector<MeshOptimization::Result> Optimize(CookedModelFile& model, const MeshOptimization::Settings& settings = GetDefaultOptimizationSettings(), ThreadPool* threadPool = nullptr);
+
+    // Full optimization with a chain of DEFAULT_LOD_COUNT LODs.
+    static MeshOptimization::Settings GetDefaultOptimizationSettings();
+
+    static constexpr uint32_t DEFAULT_LOD_COUNT = 3;
+
+    static std::filesystem::path GetCookedPath(const std::filesystem::path& sourcePath);
+
+    static std::filesystem::path GetCookedAnimationsPath(const std::filesystem::path& sourcePath);
+
+    // A cooked model is up to date if it is not older than its source. A missing source (e.g., a shipped build) counts as up to date.
+    static bool IsUpToDate(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath);
+};
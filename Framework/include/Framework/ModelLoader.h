@@ -20,5 +20,7 @@ public:
 
     std::shared_ptr<Animation> LoadAnimation(const std::string& path, const std::string& animationName) const;
 
-    std::shared_ptr<Texture> LoadTexture(CommandList& commandList, const std::wstring& path, TextureUsageType usage = TextureUsageType::Albedo) const;
+    // With a TextureStreamer, returns a placeholder until the texture is loaded. streamMips is ignored without it.
+    std::shared_ptr<Texture> LoadTexture(CommandList& commandList, const std::wstring& path, TextureUsageType usage = TextureUsageType::Albedo,
+        bool streamMips = false) const;
 };
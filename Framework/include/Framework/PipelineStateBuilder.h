@@ -9,6 +9,8 @@
 #include <memory>
 #include <vector>
 
+struct PipelineStateKey;
+
 class PipelineStateBuilder final
 {
 public:
@@ -16,6 +18,12 @@ public:
 
     Microsoft::WRL::ComPtr<ID3D12PipelineState> Build(Microsoft::WRL::ComPtr<ID3D12Device2> device) const;
 
+    // Stable hash of the shaders, the root signature, and the fixed-function state (excluding the render target formats and sample desc).
+    // See PipelineStateKey::ComputeStateHash.
+    uint64_t ComputeStateHash() const;
+    // Stable hash of the complete pipeline state. Used as the key in PipelineStateCache.
+    uint64_t ComputeKey() const;
+
     PipelineStateBuilder& WithRenderTargetFormats(const std::vector<DXGI_FORMAT>& renderTargetFormats, DXGI_FORMAT depthStencilFormat);
     PipelineStateBuilder& WithSampleDesc(const DXGI_SAMPLE_DESC& sampleDesc);
     PipelineStateBuilder& WithShaders(const Microsoft::WRL::ComPtr<ID3DBlob>& vertexShader, const Microsoft::WRL::ComPtr<ID3DBlob>& pixelShader);
@@ -32,11 +40,14 @@ public:
     PipelineStateBuilder& WithRasterizer(const CD3DX12_RASTERIZER_DESC& rasterizer);
 
 private:
+    // The state that identifies the pipeline, without D3D12 types (see PipelineStateKey).
+    PipelineStateKey CreateKey() const;
+
     std::shared_ptr<RootSignature> m_RootSignature;
 
     std::vector<DXGI_FORMAT> m_RenderTargetFormats;
-    DXGI_SAMPLE_DESC m_SampleDesc;
-    DXGI_FORMAT m_DepthStencilFormat;
+    DXGI_SAMPLE_DESC m_SampleDesc = { 1, 0 };
+    DXGI_FORMAT m_DepthStencilFormat = DXGI_FORMAT_UNKNOWN;
 
     Microsoft::WRL::ComPtr<ID3DBlob> m_VertexShader;
     Microsoft::WRL::ComPtr<ID3DBlob> m_PixelShader;
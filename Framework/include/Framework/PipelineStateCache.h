@@ -0,0 +1,71 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <DX12Library/RenderTargetState.h>
+
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#include "PipelineStateCacheFile.h"
+
+/**
+ * Disk-backed cache of pipeline state objects built on top of ID3D12PipelineLibrary.
+ * Pipelines are identified by a stable 64-bit key (see PipelineStateBuilder::ComputeKey).
+ * Also remembers which render target states each pipeline was used with, so that they can be pre-warmed on the next startup.
+ */
+class PipelineStateCache
+{
+public:
+    /**
+     * Create the cache singleton and load the cache file if it exists.
+     * Must be called after the Application is created.
+     */
+    static void Create(const std::filesystem::path& path);
+
+    /**
+     * Write the cache file (if anything changed) and destroy the singleton.
+     * Must be called before the Application is destroyed.
+     */
+    static void Destroy();
+
+    static bool IsCreated();
+    static PipelineStateCache& Get();
+
+    /**
+     * Load the pipeline from the library or create it and store it in the library.
+     * Can be called from any thread.
+     */
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> LoadOrCreate(
+        const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+        uint64_t key,
+        const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc
+    );
+
+    void RegisterRenderTargetState(uint64_t stateHash, const RenderTargetState& renderTargetState);
+    std::vector<RenderTargetState> GetKnownRenderTargetStates(uint64_t stateHash) const;
+
+    static PipelineStateCacheFile::RenderTargetStateRecord ToRecord(const RenderTargetState& renderTargetState);
+    static RenderTargetState FromRecord(const PipelineStateCacheFile::RenderTargetStateRecord& record);
+
+private:
+    explicit PipelineStateCache(const std::filesystem::path& path);
+    ~PipelineStateCache();
+
+    PipelineStateCache(const PipelineStateCache& other) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache& other) = delete;
+
+    void CreatePipelineLibrary();
+    void Save();
+
+    std::filesystem::path m_Path;
+
+    // Also owns the memory of the serialized library, which must outlive m_PipelineLibrary.
+    PipelineStateCacheFile m_File;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> m_PipelineLibrary;
+
+    mutable std::mutex m_Mutex;
+    bool m_IsDirty = false;
+};
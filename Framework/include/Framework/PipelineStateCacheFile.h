@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * On-disk representation of the pipeline state cache.
+ * Does not depend on D3D12, so the serialization can be used (and tested) without a device.
+ */
+struct PipelineStateCacheFile
+{
+    static constexpr uint32_t MAGIC = 0x43535050; // "PPSC"
+    static constexpr uint32_t VERSION = 1;
+
+    static constexpr uint32_t MAX_RENDER_TARGETS = 8;
+
+    // Plain copy of RenderTargetState.
+    struct RenderTargetStateRecord
+    {
+        uint32_t NumRenderTargets = 0;
+        uint32_t RenderTargetFormats[MAX_RENDER_TARGETS] = {};
+        uint32_t DepthStencilFormat = 0;
+        uint32_t SampleCount = 1;
+        uint32_t SampleQuality = 0;
+
+        uint64_t ComputeHash() const;
+
+        bool operator==(const RenderTargetStateRecord& other) const;
+        bool operator!=(const RenderTargetStateRecord& other) const { return !(*this == other); }
+    };
+
+    // Render target states a pipeline was used with, by the hash of the pipeline state (see PipelineStateBuilder::ComputeStateHash).
+    // Used to pre-warm the pipelines on startup.
+    std::unordered_map<uint64_t, std::vector<RenderTargetStateRecord>> m_KnownRenderTargetStates;
+
+    // Serialized ID3D12PipelineLibrary.
+    std::vector<uint8_t> m_PipelineLibraryBlob;
+
+    static uint64_t ComputePipelineKey(uint64_t stateHash, const RenderTargetStateRecord& renderTargetState);
+
+    std::vector<uint8_t> Serialize() const;
+    // Returns false if the data is corrupted or has been written by an incompatible version.
+    bool Deserialize(const uint8_t* data, size_t size);
+
+    // Returns false if the file does not exist or cannot be deserialized.
+    bool Read(const std::filesystem::path& path);
+    void Write(const std::filesystem::path& path) const;
+};
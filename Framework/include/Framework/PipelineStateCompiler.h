@@ -0,0 +1,51 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <Framework/AsyncBuildQueue.h>
+
+#include <cstdint>
+#include <memory>
+
+/**
+ * Compiles pipeline state objects asynchronously on a pool of worker threads,
+ * so that the render thread never blocks on a driver compilation.
+ * The scheduling is done by AsyncBuildQueue, which does not depend on D3D12.
+ */
+class PipelineStateCompiler
+{
+public:
+    using Queue = AsyncBuildQueue<Microsoft::WRL::ComPtr<ID3D12PipelineState>>;
+    using BuildFunction = Queue::BuildFunction;
+    using JobStatus = Queue::JobStatus;
+    // Its result is the pipeline state object.
+    using Job = Queue::Job;
+    using CompletionReport = Queue::CompletionReport;
+
+    static void Create(uint32_t numThreads = 0);
+    static void Destroy();
+    static bool IsCreated();
+    static PipelineStateCompiler& Get();
+
+    explicit PipelineStateCompiler(uint32_t numThreads = 0);
+
+    PipelineStateCompiler(const PipelineStateCompiler& other) = delete;
+    PipelineStateCompiler& operator=(const PipelineStateCompiler& other) = delete;
+
+    /**
+     * Schedule the build function on a worker thread. Never blocks.
+     * If a job with the same key is still in flight, that job is returned instead.
+     */
+    std::shared_ptr<Job> Compile(uint64_t key, BuildFunction buildFunction);
+
+    bool TryPopCompletionReport(CompletionReport& report);
+
+    size_t GetNumPendingJobs() const;
+
+    // Block until all the scheduled jobs are complete.
+    void Wait();
+
+private:
+    Queue m_Queue;
+};
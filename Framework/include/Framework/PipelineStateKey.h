@@ -0,0 +1,110 @@
+#pragma once
+
+#include "PipelineStateCacheFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Everything that identifies a pipeline state in the PipelineStateCache, as plain values.
+ * PipelineStateBuilder copies its D3D12 descriptions here member by member (they contain padding),
+ * with the same sizes as the D3D12 types (BOOL and enums are 32-bit), and hashes this.
+ * Does not depend on D3D12, so the key derivation can be tested without a device.
+ */
+struct PipelineStateKey
+{
+    static constexpr uint32_t MAX_RENDER_TARGETS = PipelineStateCacheFile::MAX_RENDER_TARGETS;
+
+    struct ShaderBytecode
+    {
+        const void* Data = nullptr;
+        size_t Size = 0;
+    };
+
+    struct InputElement
+    {
+        std::string SemanticName;
+        uint32_t SemanticIndex = 0;
+        uint32_t Format = 0;
+        uint32_t InputSlot = 0;
+        uint32_t AlignedByteOffset = 0;
+        uint32_t InputSlotClass = 0;
+        uint32_t InstanceDataStepRate = 0;
+    };
+
+    struct RenderTargetBlend
+    {
+        int32_t BlendEnable = 0;
+        int32_t LogicOpEnable = 0;
+        uint32_t SrcBlend = 0;
+        uint32_t DestBlend = 0;
+        uint32_t BlendOp = 0;
+        uint32_t SrcBlendAlpha = 0;
+        uint32_t DestBlendAlpha = 0;
+        uint32_t BlendOpAlpha = 0;
+        uint32_t LogicOp = 0;
+        uint8_t RenderTargetWriteMask = 0;
+    };
+
+    struct Blend
+    {
+        int32_t AlphaToCoverageEnable = 0;
+        int32_t IndependentBlendEnable = 0;
+        RenderTargetBlend RenderTargets[MAX_RENDER_TARGETS];
+    };
+
+    struct DepthStencilOp
+    {
+        uint32_t StencilFailOp = 0;
+        uint32_t StencilDepthFailOp = 0;
+        uint32_t StencilPassOp = 0;
+        uint32_t StencilFunc = 0;
+    };
+
+    struct DepthStencil
+    {
+        int32_t DepthEnable = 0;
+        uint32_t DepthWriteMask = 0;
+        uint32_t DepthFunc = 0;
+        int32_t StencilEnable = 0;
+        uint8_t StencilReadMask = 0;
+        uint8_t StencilWriteMask = 0;
+        DepthStencilOp FrontFace;
+        DepthStencilOp BackFace;
+    };
+
+    struct Rasterizer
+    {
+        uint32_t FillMode = 0;
+        uint32_t CullMode = 0;
+        int32_t FrontCounterClockwise = 0;
+        int32_t DepthBias = 0;
+        float DepthBiasClamp = 0.0f;
+        float SlopeScaledDepthBias = 0.0f;
+        int32_t DepthClipEnable = 0;
+        int32_t MultisampleEnable = 0;
+        int32_t AntialiasedLineEnable = 0;
+        uint32_t ForcedSampleCount = 0;
+        uint32_t ConservativeRaster = 0;
+    };
+
+    // The hash of the serialized root signature (see RootSignature::GetHash).
+    uint64_t RootSignatureHash = 0;
+    ShaderBytecode VertexShader;
+    ShaderBytecode PixelShader;
+    std::vector<InputElement> InputLayout;
+    Blend BlendState;
+    DepthStencil DepthStencilState;
+    Rasterizer RasterizerState;
+    PipelineStateCacheFile::RenderTargetStateRecord RenderTargetState;
+
+    // Stable hash of the shaders, the root signature, and the fixed-function state (excluding the render target state).
+    uint64_t ComputeStateHash() const;
+    // Stable hash of the complete pipeline state.
+    uint64_t ComputeKey() const;
+
+    // Stable hash of a compute pipeline state.
+    static uint64_t ComputeComputePipelineKey(uint64_t rootSignatureHash, const ShaderBytecode& computeShader);
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Aabb.h"
+#include "ShadowCasterCulling.h"
+
+/**
+ * A bounding volume hierarchy over the world-space AABBs of the objects of a scene, to find the ones inside a view frustum
+ * without testing every object.
+ * Every node has up to four children (nodes or objects), whose bounds are stored as a structure of arrays,
+ * so that a single test of 4 boxes against a plane is one SIMD operation. Vectorized with DirectXMath (SSE/AVX2 on x64, NEON on ARM).
+ * The objects are identified by their index, as in ShadowCasterCulling.
+ * When objects move, only the nodes above them are refitted; the tree is rebuilt when the number of objects changes,
+ * or when the refitted nodes have grown too much and the queries would visit too many of them.
+ * Does not depend on D3D12.
+ */
+class SceneBvh
+{
+public:
+    using Frustum = ShadowCasterCulling::Frustum;
+
+    static constexpr uint32_t BRANCHING_FACTOR = 4;
+
+    struct Stats
+    {
+        uint32_t NumObjects = 0;
+        uint32_t NumNodes = 0;
+        uint32_t NumRebuilds = 0;
+        uint32_t NumRefits = 0;
+        // In all the refits.
+        uint32_t NumRefittedNodes = 0;
+    };
+
+    /**
+     * Call when the objects may have changed, before querying.
+     * An object whose bounds differ from the previous call has moved. If the number of objects changes, the tree is rebuilt.
+     */
+    void Update(const std::vector<Aabb>& objectBounds);
+
+    /**
+     * Appends the objects that intersect the frustum, in no particular order. An object is culled when it is entirely behind one of the planes.
+     * The subtrees entirely inside the frustum are appended without testing them further.
+     */
+    void Query(const Frustum& frustum, std::vector<uint32_t>& visibleObjects) const;
+
+    // Rebuilds the tree on the next Update.
+    void Invalidate();
+
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    // Marks a child that is an object rather than a node.
+    static constexpr uint32_t OBJECT_BIT = 1u << 31;
+
+    struct Bounds
+    {
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Max;
+
+        bool operator==(const Bounds& other) const;
+        void Encapsulate(const Bounds& other);
+        float GetSurfaceArea() const;
+    };
+
+    struct Node
+    {
+        // The bounds of the children, one lane per child. The lanes past ChildrenCount are zero.
+        DirectX::XMFLOAT4A MinX, MinY, MinZ;
+        DirectX::XMFLOAT4A MaxX, MaxY, MaxZ;
+        // A node index, or an object index with OBJECT_BIT.
+        uint32_t Children[BRANCHING_FACTOR];
+        uint32_t ChildrenCount;
+        // The parent's index * BRANCHING_FACTOR + the lane of this node, or INVALID_INDEX for the root.
+        uint32_t ParentLane;
+    };
+
+    static Bounds ToBounds(const Aabb& aabb);
+    static Bounds GetChildBounds(const Node& node, uint32_t lane);
+    static void SetChildBounds(Node& node, uint32_t lane, const Bounds& bounds);
+    static Bounds ComputeNodeBounds(const Node& node);
+
+    void Build();
+    // Returns the index of the node of the objects [begin, end) of m_BuildObjects.
+    uint32_t BuildNode(uint32_t begin, uint32_t end, uint32_t parentLane);
+    void Refit();
+    void AppendSubtree(uint32_t nodeIndex, std::vector<uint32_t>& visibleObjects) const;
+
+    std::vector<Node> m_Nodes;
+    Bounds m_RootBounds{};
+
+    std::vector<Bounds> m_ObjectBounds;
+    // The node index * BRANCHING_FACTOR + the lane of every object.
+    std::vector<uint32_t> m_ObjectLanes;
+
+    // The sum of the surface areas of the nodes, which the cost of a query is roughly proportional to.
+    float m_SurfaceArea = 0.0f;
+    float m_BuiltSurfaceArea = 0.0f;
+
+    bool m_IsValid = false;
+    std::vector<uint8_t> m_IsNodeDirty;
+    std::vector<uint32_t> m_BuildObjects;
+    std::vector<DirectX::XMFLOAT3> m_BuildCenters;
+
+    Stats m_Stats;
+};
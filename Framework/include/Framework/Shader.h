@@ -9,6 +9,7 @@
 #include <DX12Library/RenderTargetState.h>
 #include "CommonRootSignature.h"
 
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <memory>
@@ -17,7 +18,9 @@
 
 #include "ShaderResourceView.h"
 #include "PipelineStateBuilder.h"
+#include "PipelineStateCompiler.h"
 #include "ShaderBlob.h"
+#include "ShaderReflectionCache.h"
 
 class Shader
 {
@@ -33,7 +36,16 @@ public:
 	Shader(Shader&& other) = delete;
 	Shader& operator=(Shader&& other) = delete;
 
-	void Bind(CommandList& commandList);
+	/**
+	 * Bind the pipeline state for the current render targets.
+	 * If the pipeline state is still being compiled (see PipelineStateCompiler),
+	 * the fallback shader is bound instead or, if there is none, the following draws are skipped.
+	 * @return false if the draws will be skipped.
+	 */
+	bool Bind(CommandList& commandList);
+
+	// A cheaper shader to use while this shader's pipeline states are being compiled.
+	void SetFallback(const std::shared_ptr<Shader>& fallbackShader);
 	void Unbind(CommandList& commandList);
 
 	template<typename T>
@@ -49,35 +61,64 @@ public:
 	}
 
 	void SetMaterialConstantBuffer(CommandList& commandList, size_t size, const void* data);
+	void SetMaterialConstantBuffer(CommandList& commandList, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
 
-	void SetShaderResourceView(CommandList& commandList, const std::string& variableName, const ShaderResourceView& shaderResourceView);
+	using ShaderResourceViewId = uint32_t;
+	static constexpr ShaderResourceViewId INVALID_SHADER_RESOURCE_VIEW_ID = UINT32_MAX;
 
-	struct ShaderMetadata
-	{
-		using NameCacheMap = std::map<std::string, size_t>;
+	/**
+	 * Resolve the variable name to an ID once, so that binding does not hash the name every frame.
+	 * @return INVALID_SHADER_RESOURCE_VIEW_ID if neither of the stages uses the variable.
+	 */
+	ShaderResourceViewId FindShaderResourceView(const std::string& variableName) const;
+	uint32_t GetShaderResourceViewCount() const { return static_cast<uint32_t>(m_ShaderResourceViewBindings.size()); }
 
-		std::vector<ShaderUtils::ConstantBufferMetadata> m_ConstantBuffers{};
-		NameCacheMap m_ConstantBuffersNameCache{};
+	void SetShaderResourceView(CommandList& commandList, ShaderResourceViewId id, const ShaderResourceView& shaderResourceView);
+	void SetShaderResourceView(CommandList& commandList, const std::string& variableName, const ShaderResourceView& shaderResourceView);
 
-		std::vector<ShaderUtils::ShaderResourceViewMetadata> m_ShaderResourceViews{};
-		NameCacheMap m_ShaderResourceViewsNameCache{};
-	};
+	using ShaderMetadata = ShaderReflection;
 
-	const ShaderMetadata& GetVertexShaderMetadata() const { return m_VertexShaderMetadata; }
-	const ShaderMetadata& GetPixelShaderMetadata() const { return m_PixelShaderMetadata; }
+	const ShaderMetadata& GetVertexShaderMetadata() const { return *m_VertexShaderMetadata; }
+	const ShaderMetadata& GetPixelShaderMetadata() const { return *m_PixelShaderMetadata; }
 
 private:
 
 
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> GetPipelineState(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const RenderTargetState& renderTargetState);
+	// Returns nullptr if the pipeline state is being compiled asynchronously.
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> TryGetPipelineState(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const RenderTargetState& renderTargetState);
 
-	void CollectShaderMetadata(const Microsoft::WRL::ComPtr<ID3DBlob>& shader, ShaderMetadata* outMetadata);
+	// Compile the pipeline states for the render target states this shader was used with during the previous runs.
+	void StartPrewarm();
+	void ScheduleCompilation(const RenderTargetState& renderTargetState);
+	static void ConfigureForRenderTargetState(PipelineStateBuilder& builder, const RenderTargetState& renderTargetState);
+
+	void BuildShaderResourceViewBindings();
+
+	// A variable is bound once per stage using it, or once if both stages use the same register.
+	struct ShaderResourceViewBinding
+	{
+		struct Register
+		{
+			UINT Space;
+			UINT Index;
+		};
+
+		Register Registers[2];
+		uint32_t NumRegisters;
+	};
 
 	std::shared_ptr<CommonRootSignature> m_RootSignature;
 
-	ShaderMetadata m_VertexShaderMetadata;
-	ShaderMetadata m_PixelShaderMetadata;
+	// Shared between all the shaders using the same bytecode.
+	std::shared_ptr<const ShaderMetadata> m_VertexShaderMetadata;
+	std::shared_ptr<const ShaderMetadata> m_PixelShaderMetadata;
+
+	std::vector<ShaderResourceViewBinding> m_ShaderResourceViewBindings;
+	std::unordered_map<std::string, ShaderResourceViewId> m_ShaderResourceViewIds;
 
 	PipelineStateBuilder m_PipelineStateBuilder;
+	uint64_t m_PipelineStateHash;
 	std::unordered_map<RenderTargetState, Microsoft::WRL::ComPtr<ID3D12PipelineState>> m_PipelineStateObjects;
+	std::unordered_map<RenderTargetState, std::shared_ptr<PipelineStateCompiler::Job>> m_PendingPipelineStateObjects;
+	std::shared_ptr<Shader> m_FallbackShader;
 };
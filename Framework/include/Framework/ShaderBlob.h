@@ -13,6 +13,10 @@ public:
 
 	const Microsoft::WRL::ComPtr<ID3DBlob>& GetBlob() const;
 
+	// Empty if the bytecode is embedded into the executable.
+	const std::wstring& GetFileName() const;
+
 private:
 	Microsoft::WRL::ComPtr<ID3DBlob> m_Blob;
+	std::wstring m_FileName;
 };
\ No newline at end of file
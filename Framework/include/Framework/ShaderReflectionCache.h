@@ -0,0 +1,62 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <DX12Library/ShaderUtils.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderBlob.h"
+
+struct ShaderReflection
+{
+    static constexpr uint32_t MAGIC = 0x4C465253; // "SRFL"
+    static constexpr uint32_t VERSION = 1;
+
+    using NameCacheMap = std::map<std::string, size_t>;
+
+    std::vector<ShaderUtils::ConstantBufferMetadata> m_ConstantBuffers{};
+    NameCacheMap m_ConstantBuffersNameCache{};
+    // Per constant buffer: variable indices by HashUtils::Fnv1a of their names.
+    std::vector<std::unordered_map<uint64_t, size_t>> m_ConstantBufferVariablesNameHashCache{};
+
+    std::vector<ShaderUtils::ShaderResourceViewMetadata> m_ShaderResourceViews{};
+    NameCacheMap m_ShaderResourceViewsNameCache{};
+
+    void BuildNameCaches();
+
+    // The bytecode hash is stored to detect a reflection file left behind by an older build of the shader.
+    std::vector<uint8_t> Serialize(uint64_t bytecodeHash) const;
+    // Returns false if the data is corrupted, has been written by an incompatible version, or belongs to different bytecode.
+    bool Deserialize(const uint8_t* data, size_t size, uint64_t bytecodeHash);
+};
+
+/**
+ * Reflects each unique shader bytecode only once per run.
+ * Identical bytecode (e.g., Blit_VS used by most of the post-processing passes) shares the same reflection.
+ * Reflection of shaders loaded from .cso files is also written next to them, so the following runs skip DXC altogether.
+ */
+class ShaderReflectionCache
+{
+public:
+    static std::shared_ptr<const ShaderReflection> Get(const ShaderBlob& shaderBlob);
+
+    static uint64_t ComputeBytecodeHash(const Microsoft::WRL::ComPtr<ID3DBlob>& shaderBlob);
+    static std::filesystem::path GetReflectionFilePath(const std::wstring& shaderFileName);
+
+private:
+    static std::shared_ptr<ShaderReflection> Reflect(const Microsoft::WRL::ComPtr<ID3DBlob>& shaderBlob);
+    static std::shared_ptr<ShaderReflection> TryReadReflectionFile(const std::filesystem::path& path, uint64_t bytecodeHash);
+    static void TryWriteReflectionFile(const std::filesystem::path& path, const ShaderReflection& reflection, uint64_t bytecodeHash);
+
+    static std::mutex s_Mutex;
+    static std::unordered_map<uint64_t, std::shared_ptr<const ShaderReflection>> s_Reflections;
+};
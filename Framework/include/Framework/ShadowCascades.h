@@ -0,0 +1,74 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <array>
+#include <cstdint>
+
+struct BoundingSphere;
+
+/**
+ * Fits the cascades of a directional light's shadow map to slices of the camera frustum.
+ * Every cascade is an orthographic projection around the bounding sphere of its slice: its size does not change when the camera rotates,
+ * and its position is snapped to the shadow map texels, so that the shadows do not shimmer when the camera moves.
+ * Does not depend on D3D12.
+ */
+class ShadowCascades
+{
+public:
+    static constexpr uint32_t MAX_CASCADES_COUNT = 4;
+
+    struct Settings
+    {
+        uint32_t CascadesCount = 4;
+        // Blends the split distances from uniform (0) to logarithmic (1).
+        float LogarithmicSplitWeight = 0.75f;
+        // The shadows end at this view depth, or at the camera's far plane if it is nearer.
+        float MaxDistance = 150.0f;
+        // Of a single cascade.
+        uint32_t Resolution = 2048;
+    };
+
+    struct Cascade
+    {
+        DirectX::XMMATRIX View;
+        DirectX::XMMATRIX Projection;
+        DirectX::XMMATRIX ViewProjection;
+        // The slice of the camera frustum, in view depth.
+        float NearDistance;
+        float FarDistance;
+        // The size of a shadow map texel in world units.
+        float TexelSize;
+    };
+
+    using SplitDistances = std::array<float, MAX_CASCADES_COUNT + 1>;
+
+    /**
+     * The view depths that bound the cascades: the first one is nearPlane, the last one (at cascadesCount) is farPlane.
+     * @param logarithmicSplitWeight 0 gives slices of the same depth, 1 gives slices of the same far/near ratio.
+     */
+    static SplitDistances ComputeSplitDistances(float nearPlane, float farPlane, uint32_t cascadesCount, float logarithmicSplitWeight);
+
+    /**
+     * Fits a cascade to the slice [nearDistance, farDistance] of the camera frustum.
+     * @param cameraView, cameraProjection A left-handed perspective with the depth in [0, 1], as Camera returns them.
+     * @param lightDirectionWs Points towards the light, as DirectionalLight::m_DirectionWs.
+     * @param sceneBounds The depth range covers the whole scene, so that the casters between the slice and the light are not clipped.
+     */
+    static Cascade ComputeCascade(const DirectX::XMMATRIX& cameraView, const DirectX::XMMATRIX& cameraProjection,
+        float nearDistance, float farDistance,
+        DirectX::FXMVECTOR lightDirectionWs, const BoundingSphere& sceneBounds, uint32_t resolution);
+
+    // Extracts the near and the far planes from a perspective projection.
+    static void GetPerspectiveClipPlanes(const DirectX::XMMATRIX& projection, float* nearPlane, float* farPlane);
+
+    void Update(const Settings& settings, const DirectX::XMMATRIX& cameraView, const DirectX::XMMATRIX& cameraProjection,
+        DirectX::FXMVECTOR lightDirectionWs, const BoundingSphere& sceneBounds);
+
+    uint32_t GetCascadesCount() const { return m_CascadesCount; }
+    const Cascade& GetCascade(uint32_t index) const;
+
+private:
+    std::array<Cascade, MAX_CASCADES_COUNT> m_Cascades{};
+    uint32_t m_CascadesCount = 0;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Aabb.h"
+
+struct BoundingSphere;
+
+/**
+ * Culls the shadow casters of the shadow views of one kind of light (e.g., the faces of the point lights' cube maps),
+ * and remembers what every view has drawn, so that a shadow map is only redrawn when its view or a caster inside it has changed.
+ * The casters are identified by their index, tested with their world-space AABBs, and compared by their world matrices and models.
+ * Does not depend on D3D12.
+ */
+class ShadowCasterCulling
+{
+public:
+    static constexpr uint32_t FRUSTUM_PLANES_COUNT = 6;
+
+    struct Frustum
+    {
+        // Pointing inwards: a point p is inside when dot(plane.xyz, p) >= plane.w for every plane.
+        DirectX::XMFLOAT4 Planes[FRUSTUM_PLANES_COUNT];
+
+        // Of a (row-vector) view-projection matrix with the depth in [0, 1].
+        static Frustum FromViewProjection(const DirectX::XMMATRIX& viewProjection);
+    };
+
+    struct Caster
+    {
+        // World-space, to cull the caster.
+        Aabb Bounds;
+        // The caster has changed when either differs from the previous frame,
+        // even within the same bounds (e.g., turned half a revolution, or with another model of the same size).
+        DirectX::XMMATRIX WorldMatrix;
+        // Only compared, e.g., the Model of a GameObject.
+        const void* Model = nullptr;
+    };
+
+    struct Stats
+    {
+        uint32_t NumViews = 0;
+        uint32_t NumRedrawnViews = 0;
+        // The casters drawn to the redrawn views.
+        uint32_t NumDraws = 0;
+        // The casters that would have been drawn to the redrawn views without culling.
+        uint32_t NumCulledDraws = 0;
+    };
+
+    static bool Intersects(const Frustum& frustum, const Aabb& aabb);
+    static bool Intersects(const BoundingSphere& sphere, const Aabb& aabb);
+
+    /**
+     * Call once per frame before culling the views.
+     * A caster whose world matrix or model differs from the previous frame's has changed, and the views that contain it (now or before) are redrawn.
+     * If the number of casters changes, all the views are redrawn.
+     */
+    void BeginFrame(const std::vector<Caster>& casters);
+
+    /**
+     * Culls the casters of a view and tells whether its shadow map has to be redrawn:
+     * the view is new or its view-projection has changed, a caster has entered or left it, or one of its casters has changed.
+     * @param viewIndex Identifies the view across frames, e.g., the slice of the shadow map array.
+     * @param range If not null, the casters must also touch it (e.g., the range of a point light).
+     */
+    bool CullView(uint32_t viewIndex, const DirectX::XMMATRIX& viewProjection, const BoundingSphere* range = nullptr);
+
+    // The casters of the view found by the last CullView, in increasing order.
+    const std::vector<uint32_t>& GetVisibleCasters(uint32_t viewIndex) const { return m_Views[viewIndex].Casters; }
+
+    // Forces all the views to be redrawn, e.g., when the shadow maps have been recreated.
+    void Invalidate();
+
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    struct View
+    {
+        DirectX::XMFLOAT4X4 ViewProjection;
+        std::vector<uint32_t> Casters;
+        bool IsValid = false;
+    };
+
+    struct Bounds
+    {
+        DirectX::XMFLOAT3 Min;
+        DirectX::XMFLOAT3 Max;
+
+    };
+
+    struct CasterState
+    {
+        DirectX::XMFLOAT4X4 WorldMatrix;
+        const void* Model;
+
+        bool operator==(const CasterState& other) const;
+    };
+
+    static Bounds ToBounds(const Aabb& aabb);
+    static bool Intersects(const Frustum& frustum, const Bounds& bounds);
+    static bool Intersects(DirectX::FXMVECTOR sphereCenter, float sphereRadius, const Bounds& bounds);
+
+    std::vector<Bounds> m_CasterBounds;
+    std::vector<CasterState> m_CasterStates;
+    std::vector<CasterState> m_PreviousCasterStates;
+    std::vector<bool> m_HasCasterChanged;
+
+    std::vector<View> m_Views;
+    std::vector<uint32_t> m_ScratchCasters;
+    Stats m_Stats;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VertexLayout.h"
+
+#include <d3d12.h>
+
+#include <array>
+
+/**
+ * Generates input layouts from vertex layouts.
+ */
+namespace VertexInputLayout
+{
+    constexpr DXGI_FORMAT GetDxgiFormat(const VertexAttributeFormat format)
+    {
+        switch (format)
+        {
+        case VertexAttributeFormat::Float32x4:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case VertexAttributeFormat::Float32x3:
+            return DXGI_FORMAT_R32G32B32_FLOAT;
+        case VertexAttributeFormat::Float32x2:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case VertexAttributeFormat::Float16x4:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case VertexAttributeFormat::Float16x2:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case VertexAttributeFormat::Snorm16x4:
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case VertexAttributeFormat::Snorm8x4:
+            return DXGI_FORMAT_R8G8B8A8_SNORM;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    /**
+     * The input elements of the stored attributes come first (see VertexLayout::GetStoredAttributeCount), the rest are left empty.
+     */
+    constexpr std::array<D3D12_INPUT_ELEMENT_DESC, VertexLayout::ATTRIBUTE_COUNT> Create(const VertexLayout& layout, const uint32_t inputSlot)
+    {
+        constexpr const char* semanticNames[VertexLayout::ATTRIBUTE_COUNT] = {
+            "POSITION",
+            "NORMAL",
+            "TEXCOORD",
+            "TANGENT",
+            "BINORMAL",
+        };
+
+        std::array<D3D12_INPUT_ELEMENT_DESC, VertexLayout::ATTRIBUTE_COUNT> inputElements{};
+
+        uint32_t elementIndex = 0;
+
+        for (uint32_t attribute = 0; attribute < VertexLayout::ATTRIBUTE_COUNT; ++attribute)
+        {
+            if (layout.Formats[attribute] == VertexAttributeFormat::None)
+            {
+                continue;
+            }
+
+            inputElements[elementIndex++] = {
+                semanticNames[attribute], 0, GetDxgiFormat(layout.Formats[attribute]), inputSlot, layout.GetOffset(attribute),
+                D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+            };
+        }
+
+        return inputElements;
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Storage formats of a vertex attribute in a vertex buffer.
+ * All of them are decoded by the input assembler, so the shaders keep reading float4 inputs:
+ * missing components are filled with (0, 0, 0, 1), normalized integers are mapped to [-1, 1].
+ */
+enum class VertexAttributeFormat : uint8_t
+{
+    Float32x4,
+    Float32x3,
+    Float32x2,
+    Float16x4,
+    Float16x2,
+    Snorm16x4,
+    Snorm8x4,
+    // Not stored. Only for the bitangent, which is rebuilt from the normal and the tangent.
+    None,
+
+    Count,
+};
+
+/**
+ * Describes how the attributes of VertexAttributes (five float4s: position, normal, uv, tangent, bitangent) are stored in a vertex buffer.
+ * The encoded tangent always carries the handedness of the tangent frame in w (+1 or -1),
+ * so that the bitangent can be left out and rebuilt as cross(normal, tangent.xyz) * tangent.w (as the vertex shaders do).
+ * Does not depend on D3D12 (see VertexInputLayout.h for the input elements).
+ */
+struct VertexLayout
+{
+    enum Attribute : uint32_t
+    {
+        Position,
+        Normal,
+        Uv,
+        Tangent,
+        Bitangent,
+
+        ATTRIBUTE_COUNT,
+    };
+
+    // The source layout is the one of VertexAttributes: a float4 per attribute.
+    static constexpr uint32_t SOURCE_COMPONENT_COUNT = 4;
+    static constexpr uint32_t SOURCE_STRIDE = ATTRIBUTE_COUNT * SOURCE_COMPONENT_COUNT * sizeof(float);
+
+    VertexAttributeFormat Formats[ATTRIBUTE_COUNT];
+
+    // 80 bytes: identical to VertexAttributes.
+    static constexpr VertexLayout Full()
+    {
+        return { { VertexAttributeFormat::Float32x4, VertexAttributeFormat::Float32x4, VertexAttributeFormat::Float32x4, VertexAttributeFormat::Float32x4, VertexAttributeFormat::Float32x4 } };
+    }
+
+    // 32 bytes: full-precision positions (world-scale meshes do not crack), 16-bit normalized normal and tangent, half-float uvs, no bitangent.
+    static constexpr VertexLayout Compact()
+    {
+        return { { VertexAttributeFormat::Float32x3, VertexAttributeFormat::Snorm16x4, VertexAttributeFormat::Float16x2, VertexAttributeFormat::Snorm16x4, VertexAttributeFormat::None } };
+    }
+
+    static constexpr uint32_t GetComponentCount(const VertexAttributeFormat format)
+    {
+        switch (format)
+        {
+        case VertexAttributeFormat::Float32x3:
+            return 3;
+        case VertexAttributeFormat::Float32x2:
+        case VertexAttributeFormat::Float16x2:
+            return 2;
+        case VertexAttributeFormat::None:
+            return 0;
+        default:
+            return 4;
+        }
+    }
+
+    static constexpr uint32_t GetSize(const VertexAttributeFormat format)
+    {
+        switch (format)
+        {
+        case VertexAttributeFormat::Float32x4:
+            return 16;
+        case VertexAttributeFormat::Float32x3:
+            return 12;
+        case VertexAttributeFormat::Float32x2:
+        case VertexAttributeFormat::Float16x4:
+        case VertexAttributeFormat::Snorm16x4:
+            return 8;
+        case VertexAttributeFormat::None:
+            return 0;
+        default:
+            return 4;
+        }
+    }
+
+    constexpr uint32_t GetOffset(const uint32_t attribute) const
+    {
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < attribute; ++i)
+        {
+            offset += GetSize(Formats[i]);
+        }
+        return offset;
+    }
+
+    constexpr uint32_t GetStride() const { return GetOffset(ATTRIBUTE_COUNT); }
+
+    // The number of attributes which are not None, i.e., of input elements.
+    constexpr uint32_t GetStoredAttributeCount() const
+    {
+        uint32_t count = 0;
+        for (const auto format : Formats)
+        {
+            count += format != VertexAttributeFormat::None ? 1 : 0;
+        }
+        return count;
+    }
+
+    // 4 bits per attribute, used to store the layout in files.
+    constexpr uint32_t Pack() const
+    {
+        uint32_t packed = 0;
+        for (uint32_t i = 0; i < ATTRIBUTE_COUNT; ++i)
+        {
+            packed |= static_cast<uint32_t>(Formats[i]) << (i * 4);
+        }
+        return packed;
+    }
+
+    static bool Unpack(uint32_t packed, VertexLayout& layout);
+
+    constexpr bool operator==(const VertexLayout& other) const = default;
+
+    /**
+     * @param source numVertices * SOURCE_STRIDE bytes.
+     * @param destination numVertices * GetStride() bytes.
+     */
+    void Encode(const void* source, size_t numVertices, void* destination) const;
+
+    /**
+     * The inverse of Encode. Missing components are restored as w = 1 for positions and 0 otherwise, as in VertexAttributes.
+     * A bitangent which is not stored is rebuilt from the normal and the tangent.
+     */
+    void Decode(const void* source, size_t numVertices, void* destination) const;
+};
@@ -1,117 +1,195 @@
 #include <Framework/Animation.h>
-#include <Framework/Mesh.h>
+#include <Framework/Armature.h>
 #include <Framework/Bone.h>
 #include <DirectXMath.h>
 
-#include <set>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 using namespace DirectX;
 
 namespace
 {
-    std::pair<Animation::KeyFrame, Animation::KeyFrame> GetInterpolatedKeyFrame(const std::vector<Animation::KeyFrame>& keyFrames, float normalizedTime)
+    constexpr uint32_t NO_KEY = std::numeric_limits<uint32_t>::max();
+
+    Animation::BoneTransform GetIdentityTransform()
     {
-        if (keyFrames.size() == 1)
-        {
-            return std::make_pair(keyFrames[0], keyFrames[0]);
-        }
+        return { XMVectorZero(), XMQuaternionIdentity(), XMVectorSet(1, 1, 1, 0) };
+    }
+}
+
+Animation::Animation(float duration, float ticksPerSecond, const std::vector<Channel>& channels)
+    : m_Duration(duration)
+    , m_TicksPerSecond(ticksPerSecond != 0 ? ticksPerSecond : 25.0f)
+{
+    m_ChannelNodeNames.reserve(channels.size());
+    m_Tracks.reserve(channels.size() * NumTrackTypes);
+
+    for (const auto& channel : channels)
+    {
+        m_ChannelNodeNames.push_back(channel.NodeName);
 
-        for (size_t i = 0; i < keyFrames.size() - 1; i++)
+        for (const auto* keyFrames : { &channel.PositionKeyFrames, &channel.RotationKeyFrames, &channel.ScalingKeyFrames })
         {
-            if (normalizedTime < static_cast<float>(keyFrames[i + 1].NormalizedTime))
+            m_Tracks.push_back({ static_cast<uint32_t>(m_KeyTimes.size()), static_cast<uint32_t>(keyFrames->size()) });
+
+            for (const auto& keyFrame : *keyFrames)
             {
-                return std::make_pair(keyFrames[i], keyFrames[i + 1]);
+                m_KeyTimes.push_back(keyFrame.NormalizedTime);
+
+                XMFLOAT4 value;
+                XMStoreFloat4(&value, keyFrame.Value);
+                m_KeyValues.push_back(value);
             }
         }
-
-        return std::make_pair(keyFrames[keyFrames.size() + 1], keyFrames[0]);
     }
+}
+
+Animation::Binding Animation::Bind(const Armature& armature) const
+{
+    return Bind(m_ChannelNodeNames, armature);
+}
+
+Animation::Binding Animation::Bind(const std::vector<std::string>& channelNodeNames, const Armature& armature)
+{
+    Binding binding;
+    binding.NumBones = armature.GetBones().size();
+    binding.BoneIndices.resize(channelNodeNames.size(), NO_BONE);
 
-    float InverseLerp(float a, float b, float v)
+    for (size_t channelIndex = 0; channelIndex < channelNodeNames.size(); ++channelIndex)
     {
-        if (a == b)
+        const auto& nodeName = channelNodeNames[channelIndex];
+        if (armature.HasBone(nodeName))
         {
-            return 0.0f;
+            binding.BoneIndices[channelIndex] = static_cast<uint32_t>(armature.GetBoneIndex(nodeName));
         }
-
-        return (v - a) / (b - a);
     }
 
-    XMVECTOR Interpolate(Animation::KeyFrame first, Animation::KeyFrame second, float normalizedTime)
-    {
-        float t = InverseLerp(first.NormalizedTime, second.NormalizedTime, normalizedTime);
-        return XMVectorLerp(first.Value, second.Value, t);
-    }
+    return binding;
+}
+
+Animation::Cursor Animation::CreateCursor() const
+{
+    Cursor cursor;
+    cursor.KeyIndices.resize(m_Tracks.size(), 0);
+    return cursor;
+}
+
+size_t Animation::GetMemorySize() const
+{
+    return m_Tracks.size() * sizeof(Track) + m_KeyTimes.size() * sizeof(float) + m_KeyValues.size() * sizeof(XMFLOAT4);
+}
 
-    XMVECTOR InterpolateRotation(Animation::KeyFrame first, Animation::KeyFrame second, float normalizedTime)
+void Animation::Sample(const Binding& binding, const double time, Cursor& cursor, Pose& transforms) const
+{
+    if (cursor.KeyIndices.size() != m_Tracks.size())
     {
-        float t = InverseLerp(first.NormalizedTime, second.NormalizedTime, normalizedTime);
-        return XMQuaternionSlerp(first.Value, second.Value, t);
+        throw std::invalid_argument("The cursor has been created for another animation.");
     }
+
+    SampleInternal(binding, time, cursor.KeyIndices.data(), transforms);
 }
 
-Animation::Animation(float duration, float ticksPerSecond, const std::vector<Channel>& channels)
-    : m_Duration(duration)
-    , m_TicksPerSecond(ticksPerSecond != 0 ? ticksPerSecond : 25.0f)
-    , m_Channels(channels)
-{}
+void Animation::Sample(const Binding& binding, const double time, Pose& transforms) const
+{
+    SampleInternal(binding, time, nullptr, transforms);
+}
 
-std::vector<Animation::BoneTransform> Animation::GetBonesTransforms(Mesh& mesh, double time) const
+void Animation::SampleInternal(const Binding& binding, const double time, uint32_t* keyIndices, Pose& transforms) const
 {
-    const auto& armature = mesh.GetArmature();
-    if (!armature.HasBones())
-        throw std::exception("Can't play an animation on a mesh without bones.");
+    if (binding.NumBones == 0)
+    {
+        throw std::invalid_argument("Can't play an animation on a mesh without bones.");
+    }
 
-    double timeInTicks = time * m_TicksPerSecond;
-    float normalizedTime = static_cast<float>(fmod(timeInTicks, m_Duration));
+    if (binding.BoneIndices.size() != m_ChannelNodeNames.size())
+    {
+        throw std::invalid_argument("The binding has been created for another animation.");
+    }
 
-    std::vector<BoneTransform> transforms;
-    transforms.resize(armature.GetBones().size());
+    double timeInTicks = m_Duration > 0 ? std::fmod(time * m_TicksPerSecond, m_Duration) : 0.0;
+    if (timeInTicks < 0)
+    {
+        timeInTicks += m_Duration;
+    }
+    const auto normalizedTime = static_cast<float>(timeInTicks);
 
-    std::set<size_t> affectedBones;
+    transforms.resize(binding.NumBones);
+    std::fill(transforms.begin(), transforms.end(), GetIdentityTransform());
 
-    for (const auto& channel : m_Channels)
+    for (size_t channelIndex = 0; channelIndex < m_ChannelNodeNames.size(); ++channelIndex)
     {
-        if (!armature.HasBone(channel.NodeName))
+        const uint32_t boneIndex = binding.BoneIndices[channelIndex];
+        if (boneIndex == NO_BONE)
         {
             continue;
         }
 
-        size_t boneIndex = armature.GetBoneIndex(channel.NodeName);
-        affectedBones.insert(boneIndex);
+        const Track* tracks = &m_Tracks[channelIndex * NumTrackTypes];
+        uint32_t searchedKeyIndices[NumTrackTypes] = { NO_KEY, NO_KEY, NO_KEY };
+        uint32_t* trackKeyIndices = keyIndices != nullptr ? keyIndices + channelIndex * NumTrackTypes : searchedKeyIndices;
 
-        const auto positionKfs = GetInterpolatedKeyFrame(channel.PositionKeyFrames, normalizedTime);
-        const auto position = Interpolate(positionKfs.first, positionKfs.second, normalizedTime);
+        // Tracks without keys keep the identity.
+        auto& transform = transforms[boneIndex];
+        XMVECTOR* values[NumTrackTypes] = { &transform.Position, &transform.Rotation, &transform.Scaling };
 
-        const auto rotationKfs = GetInterpolatedKeyFrame(channel.RotationKeyFrames, normalizedTime);
-        const auto rotation = InterpolateRotation(rotationKfs.first, rotationKfs.second, normalizedTime);
+        for (uint32_t trackType = 0; trackType < NumTrackTypes; ++trackType)
+        {
+            if (tracks[trackType].NumKeys > 0)
+            {
+                *values[trackType] = SampleTrack(tracks[trackType], static_cast<TrackType>(trackType), normalizedTime, trackKeyIndices[trackType]);
+            }
+        }
+    }
+}
 
-        const auto scalingKfs = GetInterpolatedKeyFrame(channel.ScalingKeyFrames, normalizedTime);
-        const auto scaling = Interpolate(scalingKfs.first, scalingKfs.second, normalizedTime);
+XMVECTOR Animation::SampleTrack(const Track& track, const TrackType trackType, const float time, uint32_t& keyIndex) const
+{
+    const float* times = m_KeyTimes.data() + track.FirstKey;
+    const XMFLOAT4* values = m_KeyValues.data() + track.FirstKey;
+    const uint32_t lastKey = track.NumKeys - 1;
 
-        transforms[boneIndex] = { position, rotation, scaling };
-    }
+    // Playback moves forward by less than a key per frame most of the time: check the current key and the next one.
+    uint32_t key = keyIndex;
+    const auto isKeyForTime = [times, lastKey, time](const uint32_t k)
+    {
+        return (k == 0 || times[k] <= time) && (k == lastKey || time < times[k + 1]);
+    };
 
-    for (size_t i = 0; i < armature.GetBones().size(); ++i)
+    if (key > lastKey || !isKeyForTime(key))
     {
-        if (affectedBones.contains(i))
+        if (key < lastKey && isKeyForTime(key + 1))
         {
-            continue;
+            ++key;
         }
+        else
+        {
+            const auto* upper = std::upper_bound(times, times + track.NumKeys, time);
+            key = upper == times ? 0 : static_cast<uint32_t>(upper - times - 1);
+        }
+    }
 
-        transforms[i] = { XMVECTOR(), XMQuaternionIdentity(), XMVectorSet(1, 1, 1, 0) };
+    keyIndex = key;
+
+    const XMVECTOR value = XMLoadFloat4(&values[key]);
+    if (key == lastKey || time <= times[key])
+    {
+        return value;
     }
 
-    return transforms;
+    const float t = (time - times[key]) / (times[key + 1] - times[key]);
+    const XMVECTOR nextValue = XMLoadFloat4(&values[key + 1]);
+
+    return trackType == Rotation ? XMQuaternionSlerp(value, nextValue, t) : XMVectorLerp(value, nextValue, t);
 }
 
-void Animation::Apply(Mesh& mesh, const std::vector<BoneTransform>& transforms)
+void Animation::Apply(Armature& armature, const Pose& transforms)
 {
-    auto& armature = mesh.GetArmature();
-
     if (armature.GetBones().size() != transforms.size())
     {
-        throw std::exception("Sizes are different.");
+        throw std::invalid_argument("Sizes are different.");
     }
 
     for (size_t i = 0; i < transforms.size(); ++i)
@@ -127,22 +205,34 @@ void Animation::Apply(Mesh& mesh, const std::vector<BoneTransform>& transforms)
     armature.MarkBonesDirty();
 }
 
-Animation::BoneMask Animation::BuildMask(const Mesh& mesh, const std::string& rootBoneName)
+BoneMask Animation::BuildMask(const Armature& armature, const std::string& rootBoneName)
 {
-    BoneMask mask;
-    const auto rootIndex = mesh.GetArmature().GetBoneIndex(rootBoneName);
-    BuildMaskRecursive(mesh, rootIndex, mask);
+    const size_t numBones = armature.GetBones().size();
+    const auto rootIndex = armature.GetBoneIndex(rootBoneName);
+
+    // Parents come before their children, so the descendants are all after the root.
+    BoneMask mask(numBones);
+    mask.Add(rootIndex);
+
+    for (size_t boneIndex = rootIndex + 1; boneIndex < numBones; ++boneIndex)
+    {
+        const uint32_t parentIndex = armature.GetBoneParentIndex(boneIndex);
+        if (parentIndex != Armature::NO_PARENT && mask.Contains(parentIndex))
+        {
+            mask.Add(boneIndex);
+        }
+    }
+
     return mask;
 }
 
-std::vector<Animation::BoneTransform> Animation::Blend(const std::vector<BoneTransform>& transforms1, const std::vector<BoneTransform>& transforms2, float weight)
+void Animation::Blend(const Pose& transforms1, const Pose& transforms2, const float weight, Pose& result)
 {
     if (transforms1.size() != transforms2.size())
     {
-        throw std::exception("Sizes are different.");
+        throw std::invalid_argument("Sizes are different.");
     }
 
-    std::vector<BoneTransform> result;
     result.resize(transforms1.size());
 
     for (size_t i = 0; i < transforms1.size(); ++i)
@@ -155,43 +245,76 @@ std::vector<Animation::BoneTransform> Animation::Blend(const std::vector<BoneTra
         tr.Rotation = XMQuaternionSlerp(t1.Rotation, t2.Rotation, weight);
         tr.Scaling = XMVectorLerp(t1.Scaling, t2.Scaling, weight);
     }
-
-    return result;
 }
 
-std::vector<Animation::BoneTransform> Animation::ApplyMask(const std::vector<BoneTransform>& transforms1, const std::vector<BoneTransform>& transforms2, const BoneMask& boneMask)
+void Animation::Blend(const Pose* const* poses, const float* weights, const size_t numPoses, Pose& result)
 {
-    if (transforms1.size() != transforms2.size())
+    if (numPoses == 0)
     {
-        throw std::exception("Sizes are different.");
+        throw std::invalid_argument("Nothing to blend.");
     }
 
-    std::vector<BoneTransform> result;
-    result.resize(transforms1.size());
-
-    for (size_t i = 0; i < transforms1.size(); ++i)
+    float totalWeight = 0.0f;
+    for (size_t poseIndex = 0; poseIndex < numPoses; ++poseIndex)
     {
-        const auto& t1 = transforms1[i];
-        const auto& t2 = transforms2[i];
+        if (poses[poseIndex]->size() != poses[0]->size())
+        {
+            throw std::invalid_argument("Sizes are different.");
+        }
+
+        totalWeight += std::max(weights[poseIndex], 0.0f);
+    }
 
-        result[i] = boneMask.contains(i) ? t1 : t2;
+    if (!(totalWeight > 0.0f))
+    {
+        throw std::invalid_argument("The sum of the weights must be positive.");
     }
 
-    return result;
+    const size_t numBones = poses[0]->size();
+    result.resize(numBones);
+
+    for (size_t i = 0; i < numBones; ++i)
+    {
+        const XMVECTOR referenceRotation = (*poses[0])[i].Rotation;
+        XMVECTOR position = XMVectorZero();
+        XMVECTOR rotation = XMVectorZero();
+        XMVECTOR scaling = XMVectorZero();
+
+        for (size_t poseIndex = 0; poseIndex < numPoses; ++poseIndex)
+        {
+            const float weight = std::max(weights[poseIndex], 0.0f) / totalWeight;
+            if (weight == 0.0f)
+            {
+                continue;
+            }
+
+            const auto& transform = (*poses[poseIndex])[i];
+            position = XMVectorMultiplyAdd(transform.Position, XMVectorReplicate(weight), position);
+            scaling = XMVectorMultiplyAdd(transform.Scaling, XMVectorReplicate(weight), scaling);
+
+            // q and -q are the same rotation: take the one closer to the reference, so that the sum does not cancel out.
+            const float rotationWeight = XMVectorGetX(XMVector4Dot(referenceRotation, transform.Rotation)) < 0.0f ? -weight : weight;
+            rotation = XMVectorMultiplyAdd(transform.Rotation, XMVectorReplicate(rotationWeight), rotation);
+        }
+
+        auto& tr = result[i];
+        tr.Position = position;
+        tr.Rotation = XMQuaternionNormalize(rotation);
+        tr.Scaling = scaling;
+    }
 }
 
-void Animation::BuildMaskRecursive(const Mesh& mesh, size_t rootBoneIndex, BoneMask& result)
+void Animation::ApplyMask(const Pose& transforms1, const Pose& transforms2, const BoneMask& boneMask, Pose& result)
 {
-    if (result.contains(rootBoneIndex))
+    if (transforms1.size() != transforms2.size())
     {
-        return;
+        throw std::invalid_argument("Sizes are different.");
     }
 
-    result.insert(rootBoneIndex);
-    const auto& children = mesh.GetArmature().GetBoneChildren(rootBoneIndex);
+    result.resize(transforms1.size());
 
-    for (const auto childIndex : children)
+    for (size_t i = 0; i < transforms1.size(); ++i)
     {
-        BuildMaskRecursive(mesh, childIndex, result);
+        result[i] = boneMask.Contains(i) ? transforms1[i] : transforms2[i];
     }
 }
@@ -0,0 +1,174 @@
+#include <Framework/AnimationBlendTree.h>
+#include <Framework/Armature.h>
+
+#include <stdexcept>
+#include <utility>
+
+AnimationBlendTree::AnimationBlendTree(const Armature& armature)
+    : m_Armature(armature)
+    , m_NumBones(armature.GetBones().size())
+{
+    if (m_NumBones == 0)
+    {
+        throw std::invalid_argument("Can't blend animations on a mesh without bones.");
+    }
+}
+
+AnimationBlendTree::NodeId AnimationBlendTree::AddClip(std::shared_ptr<const Animation> animation, const float speed)
+{
+    if (animation == nullptr)
+    {
+        throw std::invalid_argument("The animation is null.");
+    }
+
+    Node node{ NodeType::Clip };
+    node.m_Binding = animation->Bind(m_Armature);
+    node.m_Cursor = animation->CreateCursor();
+    node.m_Speed = speed;
+    node.m_Animation = std::move(animation);
+    return AddNode(std::move(node));
+}
+
+AnimationBlendTree::NodeId AnimationBlendTree::AddBlend(const std::vector<NodeId>& children, const std::vector<float>& weights)
+{
+    if (children.empty() || children.size() != weights.size())
+    {
+        throw std::invalid_argument("A blend needs a weight per child.");
+    }
+
+    for (const NodeId child : children)
+    {
+        ValidateChild(child);
+    }
+
+    Node node{ NodeType::Blend };
+    node.m_Children = children;
+    node.m_Weights = weights;
+
+    if (m_BlendPoses.size() < children.size())
+    {
+        m_BlendPoses.resize(children.size());
+        m_BlendWeights.resize(children.size());
+    }
+
+    return AddNode(std::move(node));
+}
+
+AnimationBlendTree::NodeId AnimationBlendTree::AddMask(const NodeId maskedChild, const NodeId unmaskedChild, BoneMask mask)
+{
+    ValidateChild(maskedChild);
+    ValidateChild(unmaskedChild);
+
+    if (mask.GetNumBones() != m_NumBones)
+    {
+        throw std::invalid_argument("The mask has been built for another armature.");
+    }
+
+    Node node{ NodeType::Mask };
+    node.m_Children = { maskedChild, unmaskedChild };
+    node.m_Mask = std::move(mask);
+    return AddNode(std::move(node));
+}
+
+void AnimationBlendTree::SetWeight(const NodeId blendNode, const size_t childIndex, const float weight)
+{
+    if (blendNode >= m_Nodes.size() || m_Nodes[blendNode].m_Type != NodeType::Blend)
+    {
+        throw std::invalid_argument("Not a blend node.");
+    }
+
+    auto& weights = m_Nodes[blendNode].m_Weights;
+    if (childIndex >= weights.size())
+    {
+        throw std::out_of_range("Invalid blend child index.");
+    }
+
+    weights[childIndex] = weight;
+}
+
+void AnimationBlendTree::Evaluate(const double time, Animation::Pose& output)
+{
+    if (m_Nodes.empty())
+    {
+        throw std::invalid_argument("The blend tree is empty.");
+    }
+
+    // Parents come after their children: walk back from the root to find the nodes that contribute to the output.
+    for (auto& node : m_Nodes)
+    {
+        node.m_IsActive = false;
+    }
+    m_Nodes.back().m_IsActive = true;
+
+    for (size_t nodeIndex = m_Nodes.size(); nodeIndex-- > 0;)
+    {
+        const auto& node = m_Nodes[nodeIndex];
+        if (!node.m_IsActive)
+        {
+            continue;
+        }
+
+        for (size_t childIndex = 0; childIndex < node.m_Children.size(); ++childIndex)
+        {
+            if (node.m_Type != NodeType::Blend || node.m_Weights[childIndex] > 0.0f)
+            {
+                m_Nodes[node.m_Children[childIndex]].m_IsActive = true;
+            }
+        }
+    }
+
+    for (size_t nodeIndex = 0; nodeIndex < m_Nodes.size(); ++nodeIndex)
+    {
+        auto& node = m_Nodes[nodeIndex];
+        if (!node.m_IsActive)
+        {
+            continue;
+        }
+
+        // The root writes straight to the output.
+        auto& pose = nodeIndex + 1 == m_Nodes.size() ? output : node.m_Pose;
+
+        switch (node.m_Type)
+        {
+        case NodeType::Clip:
+            node.m_Animation->Sample(node.m_Binding, time * node.m_Speed, node.m_Cursor, pose);
+            break;
+
+        case NodeType::Blend:
+        {
+            size_t numPoses = 0;
+            for (size_t childIndex = 0; childIndex < node.m_Children.size(); ++childIndex)
+            {
+                if (node.m_Weights[childIndex] > 0.0f)
+                {
+                    m_BlendPoses[numPoses] = &m_Nodes[node.m_Children[childIndex]].m_Pose;
+                    m_BlendWeights[numPoses] = node.m_Weights[childIndex];
+                    ++numPoses;
+                }
+            }
+
+            Animation::Blend(m_BlendPoses.data(), m_BlendWeights.data(), numPoses, pose);
+            break;
+        }
+
+        case NodeType::Mask:
+            Animation::ApplyMask(m_Nodes[node.m_Children[0]].m_Pose, m_Nodes[node.m_Children[1]].m_Pose, node.m_Mask, pose);
+            break;
+        }
+    }
+}
+
+AnimationBlendTree::NodeId AnimationBlendTree::AddNode(Node node)
+{
+    node.m_Pose.resize(m_NumBones);
+    m_Nodes.push_back(std::move(node));
+    return static_cast<NodeId>(m_Nodes.size() - 1);
+}
+
+void AnimationBlendTree::ValidateChild(const NodeId child) const
+{
+    if (child >= m_Nodes.size())
+    {
+        throw std::out_of_range("The child must be added before its parent.");
+    }
+}
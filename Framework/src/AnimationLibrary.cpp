@@ -0,0 +1,121 @@
+#include "AnimationLibrary.h"
+#include "Animation.h"
+#include "CookedAnimationFile.h"
+#include "ModelCooker.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+    XMVECTOR ToXMVECTOR(const CookedAnimationFile::Vector3Key& key)
+    {
+        return XMVectorSet(key.Value[0], key.Value[1], key.Value[2], 0.0f);
+    }
+
+    XMVECTOR ToXMVECTOR(const CookedAnimationFile::QuaternionKey& key)
+    {
+        return XMVectorSet(key.Value[0], key.Value[1], key.Value[2], key.Value[3]);
+    }
+
+    template <typename TKey>
+    void BuildKeyFrames(const std::vector<TKey>& keys, std::vector<Animation::KeyFrame>& result)
+    {
+        result.resize(keys.size());
+
+        for (size_t keyIndex = 0; keyIndex < keys.size(); ++keyIndex)
+        {
+            result[keyIndex].Value = ToXMVECTOR(keys[keyIndex]);
+            result[keyIndex].NormalizedTime = keys[keyIndex].Time;
+        }
+    }
+}
+
+size_t AnimationLibrary::AddFile(const std::string& path, const std::string_view prefix)
+{
+    return AddClips(LoadCookedAnimations(path), prefix);
+}
+
+size_t AnimationLibrary::AddClips(const CookedAnimationFile& file, const std::string_view prefix)
+{
+    // FNV-1a is incremental, so hashing the prefix once is the same as hashing every full name.
+    const NameHash prefixHash = prefix.empty() ? HashUtils::FNV_OFFSET_BASIS : HashUtils::Fnv1a(std::string_view("/"), HashName(prefix));
+
+    for (size_t clipIndex = 0; clipIndex < file.m_Clips.size(); ++clipIndex)
+    {
+        const auto& clip = file.m_Clips[clipIndex];
+        const NameHash nameHash = HashUtils::Fnv1a(clip.Name, prefixHash);
+
+        if (m_Clips.count(nameHash) != 0)
+        {
+            throw std::runtime_error("The animation clip \"" + std::string(prefix) + (prefix.empty() ? "" : "/") + clip.Name + "\" has already been added.");
+        }
+
+        m_Clips.emplace(nameHash, CreateAnimation(file, clipIndex));
+    }
+
+    return file.m_Clips.size();
+}
+
+std::shared_ptr<Animation> AnimationLibrary::Find(const NameHash nameHash) const
+{
+    const auto it = m_Clips.find(nameHash);
+    return it != m_Clips.end() ? it->second : nullptr;
+}
+
+const std::shared_ptr<Animation>& AnimationLibrary::Get(const std::string_view name) const
+{
+    const auto it = m_Clips.find(HashName(name));
+    if (it == m_Clips.end())
+    {
+        throw std::out_of_range("The animation clip \"" + std::string(name) + "\" was not found.");
+    }
+
+    return it->second;
+}
+
+CookedAnimationFile AnimationLibrary::LoadCookedAnimations(const std::string& path)
+{
+    const auto cookedPath = ModelCooker::GetCookedAnimationsPath(path);
+
+    CookedAnimationFile file;
+    if (ModelCooker::IsUpToDate(path, cookedPath) && file.Read(cookedPath))
+    {
+        return file;
+    }
+
+    file = ModelCooker::ImportAnimations(path);
+
+    try
+    {
+        file.Write(cookedPath);
+    }
+    catch (const std::exception&)
+    {
+        // The clips are imported again on the next run.
+    }
+
+    return file;
+}
+
+std::shared_ptr<Animation> AnimationLibrary::CreateAnimation(const CookedAnimationFile& file, const size_t clipIndex)
+{
+    const auto& clip = file.m_Clips.at(clipIndex);
+
+    std::vector<Animation::Channel> channels(clip.Channels.size());
+
+    for (size_t channelIndex = 0; channelIndex < clip.Channels.size(); ++channelIndex)
+    {
+        const auto& channel = clip.Channels[channelIndex];
+        auto& outputChannel = channels[channelIndex];
+
+        outputChannel.NodeName = file.m_NodeNames[channel.NodeIndex];
+        BuildKeyFrames(channel.PositionKeys, outputChannel.PositionKeyFrames);
+        BuildKeyFrames(channel.RotationKeys, outputChannel.RotationKeyFrames);
+        BuildKeyFrames(channel.ScalingKeys, outputChannel.ScalingKeyFrames);
+    }
+
+    return std::make_shared<Animation>(clip.Duration, clip.TicksPerSecond, channels);
+}
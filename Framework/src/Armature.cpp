@@ -1,31 +1,38 @@
 #include "Armature.h"
 
+#include <stdexcept>
+
 using namespace DirectX;
 
-void Armature::SetBones(const std::vector<Bone>& bones)
+void Armature::SetBones(const std::vector<Bone>& bones, const std::vector<uint32_t>& parentIndices)
 {
-    m_Bones.resize(bones.size());
-    std::copy(bones.begin(), bones.end(), m_Bones.begin());
+    if (parentIndices.size() != bones.size())
+    {
+        throw std::invalid_argument("Sizes are different.");
+    }
+
+    for (size_t i = 0; i < parentIndices.size(); ++i)
+    {
+        if (parentIndices[i] != NO_PARENT && parentIndices[i] >= i)
+        {
+            throw std::invalid_argument("The bones must be sorted so that parents come before their children.");
+        }
+    }
 
+    m_Bones = bones;
+    m_ParentIndices = parentIndices;
+
+    m_BoneIndicesByNames.clear();
     for (size_t i = 0; i < m_Bones.size(); ++i)
     {
         const auto& bone = m_Bones[i];
         m_BoneIndicesByNames[bone.Name] = i;
     }
-
-    m_BoneChildrenByIndex.resize(bones.size());
-}
-
-void Armature::SetBoneChildren(const size_t boneIndex, const std::vector<size_t>& childrenIndices)
-{
-    auto& children = m_BoneChildrenByIndex[boneIndex];
-    children.resize(childrenIndices.size());
-    std::copy(childrenIndices.begin(), childrenIndices.end(), children.begin());
 }
 
-const std::vector<size_t>& Armature::GetBoneChildren(size_t boneIndex) const
+uint32_t Armature::GetBoneParentIndex(const size_t boneIndex) const
 {
-    return m_BoneChildrenByIndex[boneIndex];
+    return m_ParentIndices[boneIndex];
 }
 
 bool Armature::HasBones() const
@@ -69,38 +76,49 @@ size_t Armature::GetBoneIndex(const std::string& name) const
         return findIter->second;
     }
 
-    throw std::exception("Bone not found.");
+    throw std::out_of_range("Bone not found.");
 }
 
 void Armature::UpdateBoneGlobalTransforms()
 {
+    // Parents come first: by the time a bone is reached, its parent is up to date and knows whether it has changed.
     for (size_t i = 0; i < m_Bones.size(); ++i)
     {
-        UpdateBoneGlobalTransforms(i, XMMatrixIdentity());
+        auto& bone = m_Bones[i];
+        const uint32_t parentIndex = m_ParentIndices[i];
+
+        if (parentIndex == NO_PARENT)
+        {
+            if (bone.IsDirty)
+            {
+                bone.GlobalTransform = bone.LocalTransform;
+            }
+        }
+        else
+        {
+            const auto& parent = m_Bones[parentIndex];
+            if (parent.IsDirty)
+            {
+                bone.IsDirty = true;
+            }
+
+            if (bone.IsDirty)
+            {
+                bone.GlobalTransform = bone.LocalTransform * parent.GlobalTransform;
+            }
+        }
     }
-}
 
-void Armature::MarkBonesDirty()
-{
     for (auto& bone : m_Bones)
     {
-        bone.IsDirty = true;
+        bone.IsDirty = false;
     }
 }
 
-void Armature::UpdateBoneGlobalTransforms(const size_t rootIndex, const XMMATRIX& parentTransform)
+void Armature::MarkBonesDirty()
 {
-    auto& bone = m_Bones[rootIndex];
-    if (!bone.IsDirty)
-    {
-        return;
-    }
-
-    bone.GlobalTransform = bone.LocalTransform * parentTransform;
-    bone.IsDirty = false;
-
-    for (size_t childIndex : m_BoneChildrenByIndex[rootIndex])
+    for (auto& bone : m_Bones)
     {
-        UpdateBoneGlobalTransforms(childIndex, bone.GlobalTransform);
+        bone.IsDirty = true;
     }
 }
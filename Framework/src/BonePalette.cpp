@@ -0,0 +1,33 @@
+#include <Framework/BonePalette.h>
+#include <Framework/Armature.h>
+
+using namespace DirectX;
+
+void BonePalette::Clear()
+{
+    m_Matrices.clear();
+}
+
+uint32_t BonePalette::AddSkinningMatrices(const Armature& armature)
+{
+    const uint32_t offset = GetSize();
+
+    for (const auto& bone : armature.GetBones())
+    {
+        m_Matrices.push_back(bone.Offset * bone.GlobalTransform);
+    }
+
+    return offset;
+}
+
+uint32_t BonePalette::AddBoneWorldMatrices(const Armature& armature, const XMMATRIX& world)
+{
+    const uint32_t offset = GetSize();
+
+    for (const auto& bone : armature.GetBones())
+    {
+        m_Matrices.push_back(bone.GlobalTransform * world);
+    }
+
+    return offset;
+}
@@ -114,6 +114,11 @@ void CommonRootSignature::SetMaterialConstantBuffer(CommandList& commandList, si
     commandList.SetGraphicsDynamicConstantBuffer(RootParameters::MaterialCBuffer, size, data);
 }
 
+void CommonRootSignature::SetMaterialConstantBuffer(CommandList& commandList, const D3D12_GPU_VIRTUAL_ADDRESS bufferLocation) const
+{
+    commandList.SetGraphicsRootConstantBufferView(RootParameters::MaterialCBuffer, bufferLocation);
+}
+
 void CommonRootSignature::SetModelConstantBuffer(CommandList& commandList, size_t size, const void* data) const
 {
     commandList.SetGraphicsDynamicConstantBuffer(RootParameters::ModelCBuffer, size, data);
@@ -0,0 +1,520 @@
+#include <Framework/CompressedAnimation.h>
+#include <Framework/Armature.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float INV_SQRT_2 = 0.70710678f;
+    constexpr uint16_t MAX_ROTATION_VALUE = 0x7FFF;
+    constexpr uint16_t MAX_VECTOR_VALUE = 0xFFFF;
+    constexpr uint16_t MAX_TIME = 0xFFFF;
+
+    Animation::BoneTransform GetIdentityTransform()
+    {
+        return { XMVectorZero(), XMQuaternionIdentity(), XMVectorSet(1, 1, 1, 0) };
+    }
+
+    uint16_t Quantize(const float value, const float min, const float scale, const uint16_t maxValue)
+    {
+        if (scale <= 0.0f)
+        {
+            return 0;
+        }
+
+        const float quantized = std::round((value - min) / scale);
+        return static_cast<uint16_t>(std::clamp(quantized, 0.0f, static_cast<float>(maxValue)));
+    }
+
+    // The largest component is reconstructed from the other three, so it is not stored. It is made positive (q and -q are the same rotation).
+    void PackRotation(const XMVECTOR rotation, const float min, const float scale, uint16_t* packedValues)
+    {
+        XMFLOAT4 q;
+        XMStoreFloat4(&q, XMQuaternionNormalize(rotation));
+        const float components[] = { q.x, q.y, q.z, q.w };
+
+        uint32_t largestIndex = 0;
+        for (uint32_t i = 1; i < 4; ++i)
+        {
+            if (std::abs(components[i]) > std::abs(components[largestIndex]))
+            {
+                largestIndex = i;
+            }
+        }
+
+        const float sign = components[largestIndex] < 0.0f ? -1.0f : 1.0f;
+        for (uint32_t i = 0, packedIndex = 0; i < 4; ++i)
+        {
+            if (i != largestIndex)
+            {
+                packedValues[packedIndex++] = Quantize(components[i] * sign, min, scale, MAX_ROTATION_VALUE);
+            }
+        }
+
+        packedValues[0] |= static_cast<uint16_t>((largestIndex & 1) << 15);
+        packedValues[1] |= static_cast<uint16_t>((largestIndex >> 1) << 15);
+    }
+
+    // The scalar version of the decoding in SampleTracks.
+    XMVECTOR UnpackRotation(const uint16_t* packedValues, const float min, const float scale)
+    {
+        const uint32_t largestIndex = (packedValues[0] >> 15) | ((packedValues[1] >> 15) << 1);
+
+        float components[4];
+        float sumOfSquares = 0.0f;
+        for (uint32_t i = 0, packedIndex = 0; i < 4; ++i)
+        {
+            if (i != largestIndex)
+            {
+                const float component = min + static_cast<float>(packedValues[packedIndex++] & MAX_ROTATION_VALUE) * scale;
+                components[i] = component;
+                sumOfSquares += component * component;
+            }
+        }
+
+        components[largestIndex] = std::sqrt(std::max(1.0f - sumOfSquares, 0.0f));
+        return XMVectorSet(components[0], components[1], components[2], components[3]);
+    }
+
+    XMVECTOR Nlerp(const XMVECTOR q1, XMVECTOR q2, const float t)
+    {
+        if (XMVectorGetX(XMVector4Dot(q1, q2)) < 0.0f)
+        {
+            q2 = XMVectorNegate(q2);
+        }
+
+        return XMQuaternionNormalize(XMVectorLerp(q1, q2, t));
+    }
+
+    float GetError(const bool isRotation, const XMVECTOR value, const XMVECTOR reference)
+    {
+        if (isRotation)
+        {
+            // The angle between the rotations. acos of the dot product is too imprecise near 1 for small tolerances.
+            const XMVECTOR q1 = XMQuaternionNormalize(value);
+            const XMVECTOR q2 = XMQuaternionNormalize(reference);
+            const float chord = std::min(XMVectorGetX(XMVector4Length(XMVectorSubtract(q1, q2))), XMVectorGetX(XMVector4Length(XMVectorAdd(q1, q2))));
+            return 4.0f * std::asin(std::min(chord * 0.5f, 1.0f));
+        }
+
+        return XMVectorGetX(XMVector3Length(XMVectorSubtract(value, reference)));
+    }
+
+    // The last key not after the time, starting from the key the previous sample has used (see Animation::SampleTrack).
+    uint32_t FindKey(const uint16_t* times, const uint32_t numKeys, const float time, const uint32_t keyIndex)
+    {
+        const uint32_t lastKey = numKeys - 1;
+        const auto isKeyForTime = [times, lastKey, time](const uint32_t k)
+        {
+            return (k == 0 || times[k] <= time) && (k == lastKey || time < times[k + 1]);
+        };
+
+        if (keyIndex <= lastKey && isKeyForTime(keyIndex))
+        {
+            return keyIndex;
+        }
+
+        if (keyIndex < lastKey && isKeyForTime(keyIndex + 1))
+        {
+            return keyIndex + 1;
+        }
+
+        const auto* upper = std::upper_bound(times, times + numKeys, time, [](const float t, const uint16_t keyTime)
+            {
+                return t < static_cast<float>(keyTime);
+            });
+        return upper == times ? 0 : static_cast<uint32_t>(upper - times - 1);
+    }
+}
+
+CompressedAnimation::CompressedAnimation(const float duration, const float ticksPerSecond, const std::vector<Animation::Channel>& channels, const Settings& settings)
+    : m_Duration(duration)
+    , m_TicksPerSecond(ticksPerSecond != 0 ? ticksPerSecond : 25.0f)
+{
+    // Some exporters put keys slightly past the duration.
+    float lastKeyTime = duration;
+    for (const auto& channel : channels)
+    {
+        for (const auto* keyFrames : { &channel.PositionKeyFrames, &channel.RotationKeyFrames, &channel.ScalingKeyFrames })
+        {
+            if (!keyFrames->empty())
+            {
+                lastKeyTime = std::max(lastKeyTime, keyFrames->back().NormalizedTime);
+            }
+        }
+    }
+    m_TimeStep = lastKeyTime > 0 ? lastKeyTime / MAX_TIME : 1.0f;
+
+    m_ChannelNodeNames.reserve(channels.size());
+    m_Tracks.reserve(channels.size() * NumTrackTypes);
+
+    for (const auto& channel : channels)
+    {
+        m_ChannelNodeNames.push_back(channel.NodeName);
+        CompressTrack(Position, channel.PositionKeyFrames, settings.PositionTolerance);
+        CompressTrack(Rotation, channel.RotationKeyFrames, settings.RotationTolerance);
+        CompressTrack(Scaling, channel.ScalingKeyFrames, settings.ScalingTolerance);
+    }
+
+    m_KeyTimes.shrink_to_fit();
+    m_KeyValues.shrink_to_fit();
+}
+
+CompressedAnimation::CompressedAnimation(const float duration, const float ticksPerSecond, const std::vector<Animation::Channel>& channels)
+    : CompressedAnimation(duration, ticksPerSecond, channels, Settings())
+{}
+
+void CompressedAnimation::CompressTrack(const TrackType trackType, const std::vector<Animation::KeyFrame>& keyFrames, const float tolerance)
+{
+    Track track{ static_cast<uint32_t>(m_KeyTimes.size()), 0, { 0, 0, 0 }, { 0, 0, 0 } };
+    const size_t numKeys = keyFrames.size();
+
+    if (numKeys == 0)
+    {
+        m_Tracks.push_back(track);
+        return;
+    }
+
+    const bool isRotation = trackType == Rotation;
+
+    // Quantize all the keys first, so that the key reduction accounts for the quantization error.
+    if (isRotation)
+    {
+        const float scale = 2.0f * INV_SQRT_2 / MAX_ROTATION_VALUE;
+        track.Min = { -INV_SQRT_2, -INV_SQRT_2, -INV_SQRT_2 };
+        track.Scale = { scale, scale, scale };
+    }
+    else
+    {
+        XMVECTOR min = keyFrames[0].Value;
+        XMVECTOR max = keyFrames[0].Value;
+        for (const auto& keyFrame : keyFrames)
+        {
+            min = XMVectorMin(min, keyFrame.Value);
+            max = XMVectorMax(max, keyFrame.Value);
+        }
+
+        XMStoreFloat3(&track.Min, min);
+        XMStoreFloat3(&track.Scale, XMVectorMultiply(XMVectorSubtract(max, min), XMVectorReplicate(1.0f / MAX_VECTOR_VALUE)));
+    }
+
+    const float mins[] = { track.Min.x, track.Min.y, track.Min.z };
+    const float scales[] = { track.Scale.x, track.Scale.y, track.Scale.z };
+
+    std::vector<PackedKey> packedKeys(numKeys);
+    std::vector<XMVECTOR> decodedValues(numKeys);
+    std::vector<float> quantizedTimes(numKeys);
+
+    for (size_t i = 0; i < numKeys; ++i)
+    {
+        auto& packedKey = packedKeys[i];
+
+        if (isRotation)
+        {
+            PackRotation(keyFrames[i].Value, mins[0], scales[0], packedKey.Values);
+            decodedValues[i] = UnpackRotation(packedKey.Values, mins[0], scales[0]);
+        }
+        else
+        {
+            XMFLOAT3 value;
+            XMStoreFloat3(&value, keyFrames[i].Value);
+            const float components[] = { value.x, value.y, value.z };
+
+            for (size_t c = 0; c < 3; ++c)
+            {
+                packedKey.Values[c] = Quantize(components[c], mins[c], scales[c], MAX_VECTOR_VALUE);
+            }
+
+            decodedValues[i] = XMVectorSet(
+                mins[0] + packedKey.Values[0] * scales[0],
+                mins[1] + packedKey.Values[1] * scales[1],
+                mins[2] + packedKey.Values[2] * scales[2],
+                0.0f);
+        }
+
+        quantizedTimes[i] = static_cast<float>(Quantize(keyFrames[i].NormalizedTime, 0.0f, m_TimeStep, MAX_TIME));
+    }
+
+    // The source curve is checked at the keys and halfway between them.
+    const auto interpolate = [isRotation](const XMVECTOR value1, const XMVECTOR value2, const float t)
+    {
+        return isRotation ? XMQuaternionSlerp(value1, value2, t) : XMVectorLerp(value1, value2, t);
+    };
+
+    // What the sampler reconstructs at a time between two kept keys.
+    const auto reconstruct = [&](const size_t key1, const size_t key2, const float time)
+    {
+        const float quantizedTime = time / m_TimeStep;
+        const float timeRange = quantizedTimes[key2] - quantizedTimes[key1];
+        const float t = timeRange > 0 ? std::clamp((quantizedTime - quantizedTimes[key1]) / timeRange, 0.0f, 1.0f) : 0.0f;
+        return isRotation ? Nlerp(decodedValues[key1], decodedValues[key2], t) : XMVectorLerp(decodedValues[key1], decodedValues[key2], t);
+    };
+
+    const auto fits = [&](const size_t key1, const size_t key2)
+    {
+        for (size_t k = key1; k < key2; ++k)
+        {
+            const float time = keyFrames[k].NormalizedTime;
+            const float nextTime = keyFrames[k + 1].NormalizedTime;
+
+            if (k > key1 && GetError(isRotation, reconstruct(key1, key2, time), keyFrames[k].Value) > tolerance)
+            {
+                return false;
+            }
+
+            const XMVECTOR halfway = interpolate(keyFrames[k].Value, keyFrames[k + 1].Value, 0.5f);
+            if (GetError(isRotation, reconstruct(key1, key2, (time + nextTime) * 0.5f), halfway) > tolerance)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    const bool isConstant = std::all_of(keyFrames.begin(), keyFrames.end(), [&](const Animation::KeyFrame& keyFrame)
+        {
+            return GetError(isRotation, decodedValues[0], keyFrame.Value) <= tolerance;
+        });
+
+    // Greedily extend the interpolated span from the last kept key for as long as it stays within the tolerance.
+    std::vector<size_t> keptKeys = { 0 };
+    if (!isConstant && numKeys > 1)
+    {
+        size_t anchor = 0;
+        for (size_t key = 1; key + 1 < numKeys; ++key)
+        {
+            if (!fits(anchor, key + 1))
+            {
+                keptKeys.push_back(key);
+                anchor = key;
+            }
+        }
+
+        keptKeys.push_back(numKeys - 1);
+    }
+
+    for (const size_t key : keptKeys)
+    {
+        m_KeyTimes.push_back(static_cast<uint16_t>(quantizedTimes[key]));
+        m_KeyValues.push_back(packedKeys[key]);
+    }
+
+    track.NumKeys = static_cast<uint32_t>(keptKeys.size());
+    m_Tracks.push_back(track);
+}
+
+Animation::Binding CompressedAnimation::Bind(const Armature& armature) const
+{
+    return Animation::Bind(m_ChannelNodeNames, armature);
+}
+
+Animation::Cursor CompressedAnimation::CreateCursor() const
+{
+    Animation::Cursor cursor;
+    cursor.KeyIndices.resize(m_Tracks.size(), 0);
+    return cursor;
+}
+
+size_t CompressedAnimation::GetMemorySize() const
+{
+    return m_Tracks.size() * sizeof(Track) + m_KeyTimes.size() * sizeof(uint16_t) + m_KeyValues.size() * sizeof(PackedKey);
+}
+
+void CompressedAnimation::Sample(const Animation::Binding& binding, const double time, Animation::Cursor& cursor, Animation::Pose& transforms) const
+{
+    if (binding.NumBones == 0)
+    {
+        throw std::invalid_argument("Can't play an animation on a mesh without bones.");
+    }
+
+    if (binding.BoneIndices.size() != m_ChannelNodeNames.size())
+    {
+        throw std::invalid_argument("The binding has been created for another animation.");
+    }
+
+    if (cursor.KeyIndices.size() != m_Tracks.size())
+    {
+        throw std::invalid_argument("The cursor has been created for another animation.");
+    }
+
+    double timeInTicks = m_Duration > 0 ? std::fmod(time * m_TicksPerSecond, m_Duration) : 0.0;
+    if (timeInTicks < 0)
+    {
+        timeInTicks += m_Duration;
+    }
+    const auto quantizedTime = static_cast<float>(timeInTicks / m_TimeStep);
+
+    transforms.resize(binding.NumBones);
+    std::fill(transforms.begin(), transforms.end(), GetIdentityTransform());
+
+    for (size_t firstChannel = 0; firstChannel < m_ChannelNodeNames.size(); firstChannel += NUM_LANES)
+    {
+        for (uint32_t trackType = 0; trackType < NumTrackTypes; ++trackType)
+        {
+            SampleTracks(static_cast<TrackType>(trackType), firstChannel, quantizedTime, cursor.KeyIndices.data(), binding.BoneIndices.data(), transforms);
+        }
+    }
+}
+
+void CompressedAnimation::SampleTracks(const TrackType trackType, const size_t firstChannel, const float time, uint32_t* keyIndices, const uint32_t* boneIndices, Animation::Pose& transforms) const
+{
+    const bool isRotation = trackType == Rotation;
+    const uint16_t valueMask = isRotation ? MAX_ROTATION_VALUE : MAX_VECTOR_VALUE;
+
+    // The lanes are gathered as a structure of arrays: a vector per component, holding the component of all 4 lanes.
+    alignas(16) float values1[3][NUM_LANES] = {};
+    alignas(16) float values2[3][NUM_LANES] = {};
+    alignas(16) float mins[3][NUM_LANES] = {};
+    alignas(16) float scales[3][NUM_LANES] = {};
+    alignas(16) float largestIndices1[NUM_LANES] = {};
+    alignas(16) float largestIndices2[NUM_LANES] = {};
+    alignas(16) float interpolationFactors[NUM_LANES] = {};
+    uint32_t laneBoneIndices[NUM_LANES];
+
+    const auto load = [](const float* lanes)
+    {
+        return XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(lanes));
+    };
+
+    bool anyLane = false;
+    for (size_t lane = 0; lane < NUM_LANES; ++lane)
+    {
+        const size_t channelIndex = firstChannel + lane;
+        laneBoneIndices[lane] = channelIndex < m_ChannelNodeNames.size() ? boneIndices[channelIndex] : Animation::NO_BONE;
+
+        const size_t trackIndex = channelIndex * NumTrackTypes + trackType;
+        // Tracks without keys keep the identity. The lanes that are not written are decoded from zeros.
+        if (laneBoneIndices[lane] == Animation::NO_BONE || m_Tracks[trackIndex].NumKeys == 0)
+        {
+            laneBoneIndices[lane] = Animation::NO_BONE;
+            largestIndices1[lane] = 3.0f;
+            largestIndices2[lane] = 3.0f;
+            continue;
+        }
+
+        anyLane = true;
+
+        const Track& track = m_Tracks[trackIndex];
+        const uint16_t* times = m_KeyTimes.data() + track.FirstKey;
+        const uint32_t lastKey = track.NumKeys - 1;
+
+        const uint32_t key = FindKey(times, track.NumKeys, time, keyIndices[trackIndex]);
+        keyIndices[trackIndex] = key;
+
+        const uint32_t nextKey = std::min(key + 1, lastKey);
+        const float t = key == lastKey || time <= times[key] ? 0.0f : (time - times[key]) / static_cast<float>(times[nextKey] - times[key]);
+        interpolationFactors[lane] = t;
+
+        const PackedKey& packedKey1 = m_KeyValues[track.FirstKey + key];
+        const PackedKey& packedKey2 = m_KeyValues[track.FirstKey + nextKey];
+        const float trackMins[] = { track.Min.x, track.Min.y, track.Min.z };
+        const float trackScales[] = { track.Scale.x, track.Scale.y, track.Scale.z };
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            values1[c][lane] = static_cast<float>(packedKey1.Values[c] & valueMask);
+            values2[c][lane] = static_cast<float>(packedKey2.Values[c] & valueMask);
+            mins[c][lane] = trackMins[c];
+            scales[c][lane] = trackScales[c];
+        }
+
+        if (isRotation)
+        {
+            largestIndices1[lane] = static_cast<float>((packedKey1.Values[0] >> 15) | ((packedKey1.Values[1] >> 15) << 1));
+            largestIndices2[lane] = static_cast<float>((packedKey2.Values[0] >> 15) | ((packedKey2.Values[1] >> 15) << 1));
+        }
+    }
+
+    if (!anyLane)
+    {
+        return;
+    }
+
+    XMVECTOR components1[3];
+    XMVECTOR components2[3];
+    for (size_t c = 0; c < 3; ++c)
+    {
+        const XMVECTOR min = load(mins[c]);
+        const XMVECTOR scale = load(scales[c]);
+        components1[c] = XMVectorMultiplyAdd(load(values1[c]), scale, min);
+        components2[c] = XMVectorMultiplyAdd(load(values2[c]), scale, min);
+    }
+
+    const XMVECTOR t = load(interpolationFactors);
+    XMMATRIX result;
+
+    if (isRotation)
+    {
+        // Reconstruct the largest component and put it in its place.
+        const auto unpack = [](const XMVECTOR* c, const XMVECTOR largestIndex, XMVECTOR* q)
+        {
+            const XMVECTOR sumOfSquares = XMVectorMultiplyAdd(c[2], c[2], XMVectorMultiplyAdd(c[1], c[1], XMVectorMultiply(c[0], c[0])));
+            const XMVECTOR largest = XMVectorSqrt(XMVectorMax(XMVectorSubtract(XMVectorReplicate(1.0f), sumOfSquares), XMVectorZero()));
+
+            const XMVECTOR is0 = XMVectorEqual(largestIndex, XMVectorReplicate(0.0f));
+            const XMVECTOR is1 = XMVectorEqual(largestIndex, XMVectorReplicate(1.0f));
+            const XMVECTOR is2 = XMVectorEqual(largestIndex, XMVectorReplicate(2.0f));
+            const XMVECTOR is3 = XMVectorEqual(largestIndex, XMVectorReplicate(3.0f));
+
+            q[0] = XMVectorSelect(c[0], largest, is0);
+            q[1] = XMVectorSelect(XMVectorSelect(c[1], largest, is1), c[0], is0);
+            q[2] = XMVectorSelect(XMVectorSelect(c[2], largest, is2), c[1], XMVectorOrInt(is0, is1));
+            q[3] = XMVectorSelect(c[2], largest, is3);
+        };
+
+        XMVECTOR q1[4];
+        XMVECTOR q2[4];
+        unpack(components1, load(largestIndices1), q1);
+        unpack(components2, load(largestIndices2), q2);
+
+        // nlerp through the shortest path.
+        XMVECTOR dot = XMVectorZero();
+        for (size_t c = 0; c < 4; ++c)
+        {
+            dot = XMVectorMultiplyAdd(q1[c], q2[c], dot);
+        }
+        const XMVECTOR flip = XMVectorLess(dot, XMVectorZero());
+
+        XMVECTOR lengthSq = XMVectorZero();
+        for (size_t c = 0; c < 4; ++c)
+        {
+            const XMVECTOR target = XMVectorSelect(q2[c], XMVectorNegate(q2[c]), flip);
+            result.r[c] = XMVectorMultiplyAdd(XMVectorSubtract(target, q1[c]), t, q1[c]);
+            lengthSq = XMVectorMultiplyAdd(result.r[c], result.r[c], lengthSq);
+        }
+
+        const XMVECTOR inverseLength = XMVectorReciprocalSqrt(lengthSq);
+        for (size_t c = 0; c < 4; ++c)
+        {
+            result.r[c] = XMVectorMultiply(result.r[c], inverseLength);
+        }
+    }
+    else
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            result.r[c] = XMVectorMultiplyAdd(XMVectorSubtract(components2[c], components1[c]), t, components1[c]);
+        }
+        result.r[3] = XMVectorZero();
+    }
+
+    // Back to a vector per lane.
+    result = XMMatrixTranspose(result);
+
+    for (size_t lane = 0; lane < NUM_LANES; ++lane)
+    {
+        if (laneBoneIndices[lane] == Animation::NO_BONE)
+        {
+            continue;
+        }
+
+        auto& transform = transforms[laneBoneIndices[lane]];
+        XMVECTOR* values[NumTrackTypes] = { &transform.Position, &transform.Rotation, &transform.Scaling };
+        *values[trackType] = result.r[lane];
+    }
+}
@@ -1,6 +1,9 @@
 #include "ComputeShader.h"
 #include <DX12Library/Helpers.h>
 
+#include "PipelineStateCache.h"
+#include "PipelineStateKey.h"
+
 ComputeShader::ComputeShader(const std::shared_ptr<CommonRootSignature>& rootSignature, const ShaderBlob& shader)
 {
     const auto device = Application::Get().GetDevice();
@@ -18,7 +21,16 @@ ComputeShader::ComputeShader(const std::shared_ptr<CommonRootSignature>& rootSig
         pipelineStateStream.CS = CD3DX12_SHADER_BYTECODE(blob->GetBufferPointer(), blob->GetBufferSize());
 
         const D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc{ sizeof(PipelineStateStream), &pipelineStateStream };
-        ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
+
+        if (PipelineStateCache::IsCreated())
+        {
+            const uint64_t key = PipelineStateKey::ComputeComputePipelineKey(rootSignature->GetHash(), { blob->GetBufferPointer(), blob->GetBufferSize() });
+            m_PipelineState = PipelineStateCache::Get().LoadOrCreate(device, key, pipelineStateStreamDesc);
+        }
+        else
+        {
+            ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
+        }
     }
 }
 
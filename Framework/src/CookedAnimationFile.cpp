@@ -0,0 +1,200 @@
+#include "CookedAnimationFile.h"
+#include "ByteStream.h"
+
+#include <DX12Library/HashUtils.h>
+
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t PayloadSize;
+        uint64_t PayloadHash;
+    };
+
+    template <typename T>
+    void WriteArray(ByteWriter& writer, const std::vector<T>& values)
+    {
+        writer.Write(static_cast<uint32_t>(values.size()));
+        writer.WriteBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadArray(ByteReader& reader, std::vector<T>& values)
+    {
+        uint32_t size;
+        if (!reader.Read(size) || size > reader.GetRemainingSize() / sizeof(T))
+        {
+            return false;
+        }
+
+        values.resize(size);
+        return values.empty() || reader.ReadBytes(values.data(), values.size() * sizeof(T));
+    }
+}
+
+std::vector<uint8_t> CookedAnimationFile::Serialize() const
+{
+    std::vector<uint8_t> payload;
+    ByteWriter payloadWriter(payload);
+
+    payloadWriter.Write(static_cast<uint32_t>(m_NodeNames.size()));
+    for (const auto& nodeName : m_NodeNames)
+    {
+        payloadWriter.WriteString(nodeName);
+    }
+
+    payloadWriter.Write(static_cast<uint32_t>(m_Clips.size()));
+    for (const auto& clip : m_Clips)
+    {
+        payloadWriter.WriteString(clip.Name);
+        payloadWriter.Write(clip.Duration);
+        payloadWriter.Write(clip.TicksPerSecond);
+
+        payloadWriter.Write(static_cast<uint32_t>(clip.Channels.size()));
+        for (const auto& channel : clip.Channels)
+        {
+            payloadWriter.Write(channel.NodeIndex);
+            WriteArray(payloadWriter, channel.PositionKeys);
+            WriteArray(payloadWriter, channel.RotationKeys);
+            WriteArray(payloadWriter, channel.ScalingKeys);
+        }
+    }
+
+    Header header{};
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.PayloadSize = payload.size();
+    header.PayloadHash = HashUtils::Fnv1a(payload.data(), payload.size());
+
+    std::vector<uint8_t> result;
+    result.reserve(sizeof(Header) + payload.size());
+
+    ByteWriter writer(result);
+    writer.Write(header);
+    writer.WriteBytes(payload.data(), payload.size());
+    return result;
+}
+
+bool CookedAnimationFile::Deserialize(const uint8_t* data, const size_t size)
+{
+    m_NodeNames.clear();
+    m_Clips.clear();
+
+    ByteReader reader(data, size);
+
+    Header header{};
+    if (!reader.Read(header) ||
+        header.Magic != MAGIC ||
+        header.Version != VERSION ||
+        header.PayloadSize != reader.GetRemainingSize() ||
+        header.PayloadHash != HashUtils::Fnv1a(data + sizeof(Header), reader.GetRemainingSize()))
+    {
+        return false;
+    }
+
+    const auto parsePayload = [this, &reader]()
+    {
+        uint32_t numNodeNames;
+        if (!reader.Read(numNodeNames) || numNodeNames > reader.GetRemainingSize() / sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        m_NodeNames.resize(numNodeNames);
+        for (auto& nodeName : m_NodeNames)
+        {
+            if (!reader.ReadString(nodeName))
+            {
+                return false;
+            }
+        }
+
+        uint32_t numClips;
+        if (!reader.Read(numClips) || numClips > reader.GetRemainingSize() / sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        m_Clips.resize(numClips);
+        for (auto& clip : m_Clips)
+        {
+            uint32_t numChannels;
+            if (!reader.ReadString(clip.Name) ||
+                !reader.Read(clip.Duration) ||
+                !reader.Read(clip.TicksPerSecond) ||
+                !reader.Read(numChannels) ||
+                numChannels > reader.GetRemainingSize() / sizeof(uint32_t))
+            {
+                return false;
+            }
+
+            clip.Channels.resize(numChannels);
+            for (auto& channel : clip.Channels)
+            {
+                if (!reader.Read(channel.NodeIndex) ||
+                    channel.NodeIndex >= m_NodeNames.size() ||
+                    !ReadArray(reader, channel.PositionKeys) ||
+                    !ReadArray(reader, channel.RotationKeys) ||
+                    !ReadArray(reader, channel.ScalingKeys))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return reader.GetRemainingSize() == 0;
+    };
+
+    if (!parsePayload())
+    {
+        m_NodeNames.clear();
+        m_Clips.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CookedAnimationFile::Read(const std::filesystem::path& path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return false;
+    }
+
+    const auto size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(size);
+    if (!stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size)))
+    {
+        return false;
+    }
+
+    return Deserialize(bytes.data(), bytes.size());
+}
+
+void CookedAnimationFile::Write(const std::filesystem::path& path) const
+{
+    const auto bytes = Serialize();
+
+    // Write to a temporary file first so that a crash does not leave a truncated file behind.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            throw std::runtime_error("Failed to write the cooked animations.");
+        }
+    }
+
+    std::filesystem::rename(tempPath, path);
+}
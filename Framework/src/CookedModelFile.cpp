@@ -0,0 +1,338 @@
+#include "CookedModelFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    // Appends the data at the given alignment and returns its offset.
+    uint64_t Append(std::vector<uint8_t>& bytes, const void* data, const size_t size, const uint64_t alignment)
+    {
+        const uint64_t offset = (bytes.size() + alignment - 1) / alignment * alignment;
+        bytes.resize(offset + size);
+
+        if (size > 0)
+        {
+            memcpy(bytes.data() + offset, data, size);
+        }
+
+        return offset;
+    }
+
+    template <typename T>
+    bool AreIndicesValid(const T* indices, const uint32_t numIndices, const uint32_t numVertices)
+    {
+        for (uint32_t i = 0; i < numIndices; ++i)
+        {
+            if (indices[i] >= numVertices)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool AreIndicesValid(const uint8_t* indices, const uint32_t numIndices, const uint32_t indexStride, const uint32_t numVertices)
+    {
+        return indexStride == sizeof(uint16_t) ?
+            AreIndicesValid(reinterpret_cast<const uint16_t*>(indices), numIndices, numVertices) :
+            AreIndicesValid(reinterpret_cast<const uint32_t*>(indices), numIndices, numVertices);
+    }
+
+    // The skinning shaders index the bone palette of the mesh with them.
+    bool AreBoneIdsValid(const CookedModelFile::SkinningVertex* vertices, const uint32_t numVertices, const uint32_t numBones)
+    {
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            for (const uint32_t boneId : vertices[i].BoneIds)
+            {
+                if (boneId >= numBones)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    uint64_t AppendArray(std::vector<uint8_t>& bytes, const std::vector<T>& values, const uint64_t alignment = CookedModelFile::STREAM_ALIGNMENT)
+    {
+        return Append(bytes, values.data(), values.size() * sizeof(T), alignment);
+    }
+}
+
+std::vector<uint8_t> CookedModelFile::Serialize() const
+{
+    std::vector<uint8_t> bytes;
+
+    Header header{};
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.Flags = m_Flags;
+    header.NumMeshes = static_cast<uint32_t>(m_Meshes.size());
+    header.VertexLayout = m_VertexLayout.Pack();
+
+    Append(bytes, &header, sizeof(header), STREAM_ALIGNMENT);
+
+    // The records are patched once the streams have been placed.
+    std::vector<MeshRecord> meshRecords(m_Meshes.size());
+    header.MeshesOffset = AppendArray(bytes, meshRecords);
+
+    for (size_t meshIndex = 0; meshIndex < m_Meshes.size(); ++meshIndex)
+    {
+        const auto& mesh = m_Meshes[meshIndex];
+        auto& meshRecord = meshRecords[meshIndex];
+
+        std::vector<uint8_t> encodedVertices(mesh.Vertices.size() * m_VertexLayout.GetStride());
+        m_VertexLayout.Encode(mesh.Vertices.data(), mesh.Vertices.size(), encodedVertices.data());
+
+        meshRecord.VerticesOffset = AppendArray(bytes, encodedVertices);
+        meshRecord.NumVertices = static_cast<uint32_t>(mesh.Vertices.size());
+        meshRecord.VertexStride = m_VertexLayout.GetStride();
+
+        std::vector<LodRecord> lodRecords;
+        lodRecords.push_back({ 0, static_cast<uint32_t>(mesh.Indices.size()), 0.0f, 0 });
+
+        std::vector<Index> indices = mesh.Indices;
+        for (const auto& lod : mesh.Lods)
+        {
+            lodRecords.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.Indices.size()), lod.Error, 0 });
+            indices.insert(indices.end(), lod.Indices.begin(), lod.Indices.end());
+        }
+
+        if (mesh.Vertices.size() <= MAX_VERTICES_FOR_16_BIT_INDICES)
+        {
+            std::vector<uint16_t> narrowIndices(indices.size());
+            std::transform(indices.begin(), indices.end(), narrowIndices.begin(), [](const Index index) { return static_cast<uint16_t>(index); });
+
+            meshRecord.IndicesOffset = AppendArray(bytes, narrowIndices);
+            meshRecord.IndexStride = sizeof(uint16_t);
+        }
+        else
+        {
+            meshRecord.IndicesOffset = AppendArray(bytes, indices);
+            meshRecord.IndexStride = sizeof(uint32_t);
+        }
+
+        meshRecord.NumIndices = static_cast<uint32_t>(indices.size());
+
+        meshRecord.LodsOffset = AppendArray(bytes, lodRecords);
+        meshRecord.NumLods = static_cast<uint32_t>(lodRecords.size());
+
+        meshRecord.SkinningVerticesOffset = AppendArray(bytes, mesh.SkinningVertices);
+        meshRecord.NumSkinningVertices = static_cast<uint32_t>(mesh.SkinningVertices.size());
+        meshRecord.SkinningVertexStride = sizeof(SkinningVertex);
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            meshRecord.AabbMin[i] = mesh.AabbMin[i];
+            meshRecord.AabbMax[i] = mesh.AabbMax[i];
+        }
+
+        std::vector<BoneRecord> boneRecords(mesh.Bones.size());
+        for (size_t boneIndex = 0; boneIndex < mesh.Bones.size(); ++boneIndex)
+        {
+            const auto& bone = mesh.Bones[boneIndex];
+            auto& boneRecord = boneRecords[boneIndex];
+
+            memcpy(boneRecord.Offset, bone.Offset, sizeof(bone.Offset));
+            memcpy(boneRecord.LocalTransform, bone.LocalTransform, sizeof(bone.LocalTransform));
+
+            boneRecord.NameOffset = Append(bytes, bone.Name.data(), bone.Name.size(), 1);
+            boneRecord.NameLength = static_cast<uint32_t>(bone.Name.size());
+
+            boneRecord.ChildrenOffset = AppendArray(bytes, bone.Children, alignof(uint32_t));
+            boneRecord.NumChildren = static_cast<uint32_t>(bone.Children.size());
+        }
+
+        meshRecord.BonesOffset = AppendArray(bytes, boneRecords);
+        meshRecord.NumBones = static_cast<uint32_t>(boneRecords.size());
+    }
+
+    header.FileSize = bytes.size();
+
+    memcpy(bytes.data(), &header, sizeof(header));
+    memcpy(bytes.data() + header.MeshesOffset, meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+    return bytes;
+}
+
+void CookedModelFile::Write(const std::filesystem::path& path) const
+{
+    const auto bytes = Serialize();
+
+    // Write to a temporary file first so that a crash does not leave a truncated model behind.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            throw std::runtime_error("Failed to write the cooked model.");
+        }
+    }
+
+    std::filesystem::rename(tempPath, path);
+}
+
+bool CookedModelView::Open(const std::filesystem::path& path)
+{
+    m_Bytes.clear();
+
+    if (!m_File.Open(path))
+    {
+        return false;
+    }
+
+    m_Data = m_File.GetData();
+    m_Size = m_File.GetSize();
+    return Parse();
+}
+
+bool CookedModelView::Load(std::vector<uint8_t>&& bytes)
+{
+    m_File.Close();
+
+    m_Bytes = std::move(bytes);
+    m_Data = m_Bytes.data();
+    m_Size = m_Bytes.size();
+    return Parse();
+}
+
+CookedModelView::MeshView CookedModelView::GetMesh(const uint32_t meshIndex) const
+{
+    const auto& meshRecord = m_MeshRecords[meshIndex];
+
+    MeshView meshView{};
+    meshView.Vertices = m_Data + meshRecord.VerticesOffset;
+    meshView.NumVertices = meshRecord.NumVertices;
+    meshView.VertexStride = meshRecord.VertexStride;
+    meshView.Indices = m_Data + meshRecord.IndicesOffset;
+    meshView.NumIndices = meshRecord.NumIndices;
+    meshView.IndexStride = meshRecord.IndexStride;
+    meshView.SkinningVertices = reinterpret_cast<const CookedModelFile::SkinningVertex*>(m_Data + meshRecord.SkinningVerticesOffset);
+    meshView.NumSkinningVertices = meshRecord.NumSkinningVertices;
+    meshView.Bones = reinterpret_cast<const CookedModelFile::BoneRecord*>(m_Data + meshRecord.BonesOffset);
+    meshView.NumBones = meshRecord.NumBones;
+    meshView.Lods = reinterpret_cast<const CookedModelFile::LodRecord*>(m_Data + meshRecord.LodsOffset);
+    meshView.NumLods = meshRecord.NumLods;
+    meshView.AabbMin = meshRecord.AabbMin;
+    meshView.AabbMax = meshRecord.AabbMax;
+    return meshView;
+}
+
+std::string_view CookedModelView::GetBoneName(const CookedModelFile::BoneRecord& bone) const
+{
+    return { reinterpret_cast<const char*>(m_Data + bone.NameOffset), bone.NameLength };
+}
+
+const uint32_t* CookedModelView::GetBoneChildren(const CookedModelFile::BoneRecord& bone) const
+{
+    return reinterpret_cast<const uint32_t*>(m_Data + bone.ChildrenOffset);
+}
+
+bool CookedModelView::IsRangeValid(const uint64_t offset, const uint64_t count, const uint64_t stride, const uint64_t alignment) const
+{
+    if (offset % alignment != 0 || offset > m_Size)
+    {
+        return false;
+    }
+
+    return count <= (m_Size - offset) / stride;
+}
+
+bool CookedModelView::Parse()
+{
+    using File = CookedModelFile;
+
+    m_Header = nullptr;
+    m_MeshRecords = nullptr;
+
+    // The streams are accessed in place, so the buffer itself must be aligned.
+    if (m_Size < sizeof(File::Header) || reinterpret_cast<uintptr_t>(m_Data) % File::STREAM_ALIGNMENT != 0)
+    {
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const File::Header*>(m_Data);
+    if (header->Magic != File::MAGIC ||
+        header->Version != File::VERSION ||
+        header->FileSize != m_Size ||
+        !IsRangeValid(header->MeshesOffset, header->NumMeshes, sizeof(File::MeshRecord), File::STREAM_ALIGNMENT) ||
+        !VertexLayout::Unpack(header->VertexLayout, m_VertexLayout))
+    {
+        return false;
+    }
+
+    const auto* meshRecords = reinterpret_cast<const File::MeshRecord*>(m_Data + header->MeshesOffset);
+
+    for (uint32_t meshIndex = 0; meshIndex < header->NumMeshes; ++meshIndex)
+    {
+        const auto& meshRecord = meshRecords[meshIndex];
+
+        if (meshRecord.VertexStride != m_VertexLayout.GetStride() ||
+            (meshRecord.IndexStride != sizeof(uint16_t) && meshRecord.IndexStride != sizeof(uint32_t)) ||
+            meshRecord.SkinningVertexStride != sizeof(File::SkinningVertex) ||
+            (meshRecord.NumSkinningVertices != 0 && meshRecord.NumSkinningVertices != meshRecord.NumVertices) ||
+            !IsRangeValid(meshRecord.VerticesOffset, meshRecord.NumVertices, meshRecord.VertexStride, File::STREAM_ALIGNMENT) ||
+            !IsRangeValid(meshRecord.IndicesOffset, meshRecord.NumIndices, meshRecord.IndexStride, File::STREAM_ALIGNMENT) ||
+            !IsRangeValid(meshRecord.SkinningVerticesOffset, meshRecord.NumSkinningVertices, sizeof(File::SkinningVertex), File::STREAM_ALIGNMENT) ||
+            !IsRangeValid(meshRecord.BonesOffset, meshRecord.NumBones, sizeof(File::BoneRecord), File::STREAM_ALIGNMENT) ||
+            meshRecord.NumLods == 0 ||
+            !IsRangeValid(meshRecord.LodsOffset, meshRecord.NumLods, sizeof(File::LodRecord), File::STREAM_ALIGNMENT))
+        {
+            return false;
+        }
+
+        const auto* lodRecords = reinterpret_cast<const File::LodRecord*>(m_Data + meshRecord.LodsOffset);
+        for (uint32_t lodIndex = 0; lodIndex < meshRecord.NumLods; ++lodIndex)
+        {
+            const auto& lodRecord = lodRecords[lodIndex];
+            if (lodRecord.NumIndices % 3 != 0 ||
+                static_cast<uint64_t>(lodRecord.IndexOffset) + lodRecord.NumIndices > meshRecord.NumIndices)
+            {
+                return false;
+            }
+        }
+
+        if (!AreIndicesValid(m_Data + meshRecord.IndicesOffset, meshRecord.NumIndices, meshRecord.IndexStride, meshRecord.NumVertices))
+        {
+            return false;
+        }
+
+        const auto* skinningVertices = reinterpret_cast<const File::SkinningVertex*>(m_Data + meshRecord.SkinningVerticesOffset);
+        if (!AreBoneIdsValid(skinningVertices, meshRecord.NumSkinningVertices, meshRecord.NumBones))
+        {
+            return false;
+        }
+
+        const auto* boneRecords = reinterpret_cast<const File::BoneRecord*>(m_Data + meshRecord.BonesOffset);
+        for (uint32_t boneIndex = 0; boneIndex < meshRecord.NumBones; ++boneIndex)
+        {
+            const auto& boneRecord = boneRecords[boneIndex];
+            if (!IsRangeValid(boneRecord.NameOffset, boneRecord.NameLength, 1, 1) ||
+                !IsRangeValid(boneRecord.ChildrenOffset, boneRecord.NumChildren, sizeof(uint32_t), alignof(uint32_t)))
+            {
+                return false;
+            }
+
+            const auto* children = reinterpret_cast<const uint32_t*>(m_Data + boneRecord.ChildrenOffset);
+            for (uint32_t i = 0; i < boneRecord.NumChildren; ++i)
+            {
+                if (children[i] >= meshRecord.NumBones || children[i] <= boneIndex)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    m_Header = header;
+    m_MeshRecords = meshRecords;
+    return true;
+}
@@ -0,0 +1,51 @@
+#include <Framework/CrowdAnimator.h>
+#include <Framework/Armature.h>
+
+#include <DX12Library/ThreadPool.h>
+
+#include <algorithm>
+
+CrowdAnimator::CrowdAnimator(ThreadPool* threadPool, const size_t charactersPerJob)
+    : m_ThreadPool(threadPool)
+    , m_CharactersPerJob(std::max<size_t>(charactersPerJob, 1))
+{}
+
+CrowdAnimator::CharacterId CrowdAnimator::AddCharacter(Armature& armature, const double timeOffset)
+{
+    m_Characters.push_back({ &armature, AnimationBlendTree(armature), {}, timeOffset });
+
+    // The pose has the capacity from the start, so that the updates do not allocate.
+    m_Characters.back().m_Pose.resize(armature.GetBones().size());
+    return static_cast<CharacterId>(m_Characters.size() - 1);
+}
+
+void CrowdAnimator::Update(const double time)
+{
+    if (m_ThreadPool == nullptr)
+    {
+        for (auto& character : m_Characters)
+        {
+            UpdateCharacter(character, time);
+        }
+        return;
+    }
+
+    const size_t numJobs = (m_Characters.size() + m_CharactersPerJob - 1) / m_CharactersPerJob;
+    m_ThreadPool->ParallelFor(numJobs, [this, time](const size_t jobIndex)
+        {
+            const size_t begin = jobIndex * m_CharactersPerJob;
+            const size_t end = std::min(begin + m_CharactersPerJob, m_Characters.size());
+
+            for (size_t characterIndex = begin; characterIndex < end; ++characterIndex)
+            {
+                UpdateCharacter(m_Characters[characterIndex], time);
+            }
+        });
+}
+
+void CrowdAnimator::UpdateCharacter(Character& character, const double time)
+{
+    character.m_BlendTree.Evaluate(time + character.m_TimeOffset, character.m_Pose);
+    Animation::Apply(*character.m_Armature, character.m_Pose);
+    character.m_Armature->UpdateBoneGlobalTransforms();
+}
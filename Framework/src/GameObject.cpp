@@ -2,6 +2,7 @@
 #include <Framework/Mesh.h>
 #include <Framework/Model.h>
 #include <Framework/Material.h>
+#include <Framework/LodSelector.h>
 
 GameObject::GameObject(const DirectX::XMMATRIX& worldMatrix, const std::shared_ptr<Model>& pModel, const std::shared_ptr<Material>& pMaterial)
     : m_WorldMatrix(worldMatrix)
@@ -9,6 +10,7 @@ GameObject::GameObject(const DirectX::XMMATRIX& worldMatrix, const std::shared_p
     , m_Aabb{}
     , m_Model(pModel)
     , m_Material(pMaterial)
+    , m_MeshLods(pModel->GetMeshes().size(), 0)
 {
     RecalculateAabb();
 }
@@ -16,10 +18,32 @@ GameObject::GameObject(const DirectX::XMMATRIX& worldMatrix, const std::shared_p
 void GameObject::Draw(CommandList& commandList) const
 {
     m_Material->Bind(commandList);
-    m_Model->Draw(commandList);
+    m_Model->Draw(commandList, m_MeshLods);
     m_Material->Unbind(commandList);
 }
 
+void GameObject::SelectLods(const LodSelector& lodSelector)
+{
+    const float screenSize = lodSelector.ComputeScreenSize(m_Aabb);
+    const auto& meshes = m_Model->GetMeshes();
+
+    for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+    {
+        const Mesh& mesh = *meshes[meshIndex];
+        m_MeshLods[meshIndex] = lodSelector.SelectLod(&mesh.GetLod(0), mesh.GetLodCount(), screenSize);
+    }
+}
+
+void GameObject::RequestTextureMips(const LodSelector& lodSelector, const float viewportHeight) const
+{
+    m_Material->RequestTextureScreenSize(lodSelector.ComputeScreenSize(m_Aabb) * viewportHeight);
+}
+
+uint32_t GameObject::GetMeshLod(const size_t meshIndex) const
+{
+    return m_MeshLods[meshIndex];
+}
+
 const DirectX::XMMATRIX& GameObject::GetWorldMatrix() const
 {
     return m_WorldMatrix;
@@ -54,9 +78,20 @@ void GameObject::RecalculateAabb()
 {
     m_Aabb = {};
 
-    for (auto& mesh : m_Model->GetMeshes())
+    const auto& meshes = m_Model->GetMeshes();
+
+    for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
     {
-        const auto meshAabb = Aabb::Transform(m_WorldMatrix, mesh->GetAabb());
-        m_Aabb.Encapsulate(meshAabb);
+        const auto meshAabb = Aabb::Transform(m_WorldMatrix, meshes[meshIndex]->GetAabb());
+
+        // Starting from the first mesh rather than an empty box, which would always contain the world origin.
+        if (meshIndex == 0)
+        {
+            m_Aabb = meshAabb;
+        }
+        else
+        {
+            m_Aabb.Encapsulate(meshAabb);
+        }
     }
 }
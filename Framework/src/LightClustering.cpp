@@ -0,0 +1,447 @@
+#include <Framework/LightClustering.h>
+#include <Framework/ShadowCascades.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+    // The distance from a value to the range [min, max], zero inside.
+    float GetSeparation(const float min, const float max, const float value)
+    {
+        return std::max(std::max(min - value, value - max), 0.0f);
+    }
+
+    XMVECTOR GetSeparation(const FXMVECTOR min, const FXMVECTOR max, const FXMVECTOR value)
+    {
+        return XMVectorMax(XMVectorMax(XMVectorSubtract(min, value), XMVectorSubtract(value, max)), XMVectorZero());
+    }
+
+    float GetLane(const XMFLOAT4A& vector, const uint32_t lane)
+    {
+        return lane == 0 ? vector.x : lane == 1 ? vector.y : lane == 2 ? vector.z : vector.w;
+    }
+
+    void SetLane(XMFLOAT4A& vector, const uint32_t lane, const float value)
+    {
+        (lane == 0 ? vector.x : lane == 1 ? vector.y : lane == 2 ? vector.z : vector.w) = value;
+    }
+
+    // Returns the first index in [0, count) for which the predicate is true, or count. The predicate must be false, then true.
+    template <typename TPredicate>
+    uint32_t FindFirst(const uint32_t count, TPredicate&& predicate)
+    {
+        uint32_t begin = 0;
+        uint32_t end = count;
+        while (begin < end)
+        {
+            const uint32_t middle = begin + (end - begin) / 2;
+            if (predicate(middle))
+            {
+                end = middle;
+            }
+            else
+            {
+                begin = middle + 1;
+            }
+        }
+
+        return begin;
+    }
+}
+
+void LightClustering::Build(const Settings& settings, const XMMATRIX& view, const XMMATRIX& projection,
+    const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights)
+{
+    Prepare(settings, view, projection, pointLights, spotLights);
+
+    const uint32_t slicesCount = m_Settings.SlicesCount;
+    const uint32_t tilesCountX = m_Settings.TilesX;
+    const uint32_t tilesCountY = m_Settings.TilesY;
+
+    for (uint32_t lightIndex = 0; lightIndex < m_LightVolumes.size(); ++lightIndex)
+    {
+        const LightVolume& light = m_LightVolumes[lightIndex];
+        const XMFLOAT3& center = light.Center;
+        const float radius = light.Radius;
+
+        // The clusters that the light's bounding box overlaps: the bounds of the slices and of the tiles are monotonic.
+        const uint32_t firstSlice = FindFirst(slicesCount, [&](const uint32_t slice) { return m_SliceDistances[slice + 1] >= center.z - radius; });
+        const uint32_t endSlice = FindFirst(slicesCount, [&](const uint32_t slice) { return m_SliceDistances[slice] > center.z + radius; });
+
+        for (uint32_t slice = firstSlice; slice < endSlice; ++slice)
+        {
+            const uint32_t firstTileX = FindFirst(tilesCountX, [&](const uint32_t tileX) { return GetTileMaxX(tileX, slice) >= center.x - radius; });
+            const uint32_t endTileX = FindFirst(tilesCountX, [&](const uint32_t tileX) { return GetTileMinX(tileX, slice) > center.x + radius; });
+            if (firstTileX >= endTileX)
+            {
+                continue;
+            }
+
+            // The tiles go from the top to the bottom.
+            const float* tileMinY = &m_TileMinY[slice * tilesCountY];
+            const float* tileMaxY = &m_TileMaxY[slice * tilesCountY];
+            const uint32_t firstTileY = FindFirst(tilesCountY, [&](const uint32_t tileY) { return tileMinY[tileY] <= center.y + radius; });
+            const uint32_t endTileY = FindFirst(tilesCountY, [&](const uint32_t tileY) { return tileMaxY[tileY] < center.y - radius; });
+
+            for (uint32_t tileY = firstTileY; tileY < endTileY; ++tileY)
+            {
+                for (uint32_t tileGroupX = firstTileX / LANES_COUNT; tileGroupX <= (endTileX - 1) / LANES_COUNT; ++tileGroupX)
+                {
+                    const uint32_t mask = IntersectsTileGroup(light, tileGroupX, tileY, slice);
+                    for (uint32_t lane = 0; lane < LANES_COUNT; ++lane)
+                    {
+                        if ((mask & (1u << lane)) != 0)
+                        {
+                            m_Hits.emplace_back(GetClusterIndex(tileGroupX * LANES_COUNT + lane, tileY, slice), lightIndex);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    Finish();
+}
+
+void LightClustering::BuildReference(const Settings& settings, const XMMATRIX& view, const XMMATRIX& projection,
+    const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights)
+{
+    Prepare(settings, view, projection, pointLights, spotLights);
+
+    for (uint32_t lightIndex = 0; lightIndex < m_LightVolumes.size(); ++lightIndex)
+    {
+        for (uint32_t slice = 0; slice < m_Settings.SlicesCount; ++slice)
+        {
+            for (uint32_t tileY = 0; tileY < m_Settings.TilesY; ++tileY)
+            {
+                for (uint32_t tileX = 0; tileX < m_Settings.TilesX; ++tileX)
+                {
+                    if (Intersects(m_LightVolumes[lightIndex], tileX, tileY, slice))
+                    {
+                        m_Hits.emplace_back(GetClusterIndex(tileX, tileY, slice), lightIndex);
+                    }
+                }
+            }
+        }
+    }
+
+    Finish();
+}
+
+uint32_t LightClustering::GetClusterIndex(const uint32_t tileX, const uint32_t tileY, const uint32_t slice) const
+{
+    return (slice * m_Settings.TilesY + tileY) * m_Settings.TilesX + tileX;
+}
+
+float LightClustering::GetSliceDistance(const uint32_t slice) const
+{
+    return m_SliceDistances.at(slice);
+}
+
+LightClustering::ShaderParameters LightClustering::GetShaderParameters() const
+{
+    // log2(distance) = log2(near) + slice / SlicesCount * log2(far / near)
+    const float slicesCount = static_cast<float>(m_Settings.SlicesCount);
+    const float logDepthRange = std::log2(m_FarPlane / m_NearPlane);
+
+    ShaderParameters parameters{};
+    parameters.TilesX = m_Settings.TilesX;
+    parameters.TilesY = m_Settings.TilesY;
+    parameters.SlicesCount = m_Settings.SlicesCount;
+    parameters.NumPointLights = m_NumPointLights;
+    parameters.SliceScale = slicesCount / logDepthRange;
+    parameters.SliceBias = -slicesCount * std::log2(m_NearPlane) / logDepthRange;
+    return parameters;
+}
+
+void LightClustering::Prepare(const Settings& settings, const XMMATRIX& view, const XMMATRIX& projection,
+    const std::vector<PointLightBounds>& pointLights, const std::vector<SpotLightBounds>& spotLights)
+{
+    if (settings.TilesX == 0 || settings.TilesY == 0 || settings.SlicesCount == 0)
+    {
+        throw std::invalid_argument("The number of tiles and slices must be positive.");
+    }
+
+    float nearPlane, farPlane;
+    ShadowCascades::GetPerspectiveClipPlanes(projection, &nearPlane, &farPlane);
+    if (!(nearPlane > 0.0f && farPlane > nearPlane))
+    {
+        throw std::invalid_argument("The projection must be a perspective one, with 0 < near < far.");
+    }
+
+    m_Settings = settings;
+    m_NearPlane = nearPlane;
+    m_FarPlane = farPlane;
+    m_NumPointLights = static_cast<uint32_t>(pointLights.size());
+
+    const uint32_t slicesCount = settings.SlicesCount;
+    m_SliceDistances.resize(slicesCount + 1);
+    for (uint32_t slice = 0; slice < slicesCount; ++slice)
+    {
+        m_SliceDistances[slice] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / static_cast<float>(slicesCount));
+    }
+    m_SliceDistances[slicesCount] = farPlane;
+
+    // A tile is a pyramid from the eye: x_vs = (x_ndc - P[2][0]) / P[0][0] * z_vs, and the same for y.
+    // Its bounds in a slice are the ones of the tile at the near and far distances of the slice.
+    XMFLOAT4X4 projectionValues;
+    XMStoreFloat4x4(&projectionValues, projection);
+    const auto getSlopeX = [&](const uint32_t tileBoundary)
+    {
+        const float ndc = -1.0f + 2.0f * static_cast<float>(tileBoundary) / static_cast<float>(settings.TilesX);
+        return (ndc - projectionValues.m[2][0]) / projectionValues.m[0][0];
+    };
+    const auto getSlopeY = [&](const uint32_t tileBoundary)
+    {
+        const float ndc = 1.0f - 2.0f * static_cast<float>(tileBoundary) / static_cast<float>(settings.TilesY);
+        return (ndc - projectionValues.m[2][1]) / projectionValues.m[1][1];
+    };
+
+    m_TileGroupsCountX = (settings.TilesX + LANES_COUNT - 1) / LANES_COUNT;
+    m_TileGroupBoundsX.resize(static_cast<size_t>(slicesCount) * m_TileGroupsCountX);
+    m_TileMinY.resize(static_cast<size_t>(slicesCount) * settings.TilesY);
+    m_TileMaxY.resize(static_cast<size_t>(slicesCount) * settings.TilesY);
+
+    for (uint32_t slice = 0; slice < slicesCount; ++slice)
+    {
+        const float nearDistance = m_SliceDistances[slice];
+        const float farDistance = m_SliceDistances[slice + 1];
+
+        for (uint32_t tileX = 0; tileX < m_TileGroupsCountX * LANES_COUNT; ++tileX)
+        {
+            auto& bounds = m_TileGroupBoundsX[slice * m_TileGroupsCountX + tileX / LANES_COUNT];
+            const uint32_t lane = tileX % LANES_COUNT;
+
+            // The padding lanes are infinitely far, so that nothing intersects them.
+            float minX = FLT_MAX;
+            float maxX = FLT_MAX;
+            if (tileX < settings.TilesX)
+            {
+                const float leftSlope = getSlopeX(tileX);
+                const float rightSlope = getSlopeX(tileX + 1);
+                minX = std::min(leftSlope * nearDistance, leftSlope * farDistance);
+                maxX = std::max(rightSlope * nearDistance, rightSlope * farDistance);
+            }
+
+            SetLane(bounds.Min, lane, minX);
+            SetLane(bounds.Max, lane, maxX);
+        }
+
+        for (uint32_t tileY = 0; tileY < settings.TilesY; ++tileY)
+        {
+            const float topSlope = getSlopeY(tileY);
+            const float bottomSlope = getSlopeY(tileY + 1);
+            m_TileMinY[slice * settings.TilesY + tileY] = std::min(bottomSlope * nearDistance, bottomSlope * farDistance);
+            m_TileMaxY[slice * settings.TilesY + tileY] = std::max(topSlope * nearDistance, topSlope * farDistance);
+        }
+    }
+
+    m_LightVolumes.clear();
+    m_LightVolumes.reserve(pointLights.size() + spotLights.size());
+
+    for (const auto& pointLight : pointLights)
+    {
+        LightVolume& volume = m_LightVolumes.emplace_back();
+        XMStoreFloat3(&volume.Center, XMVector3TransformCoord(XMLoadFloat3(&pointLight.PositionWs), view));
+        volume.Radius = pointLight.Radius;
+        volume.IsSpotLight = false;
+    }
+
+    for (const auto& spotLight : spotLights)
+    {
+        const XMVECTOR apex = XMVector3TransformCoord(XMLoadFloat3(&spotLight.PositionWs), view);
+        const XMVECTOR direction = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&spotLight.DirectionWs), view));
+        const float range = spotLight.Radius;
+        const float cosHalfAngle = std::cos(spotLight.HalfAngle);
+        const float sinHalfAngle = std::sin(spotLight.HalfAngle);
+
+        LightVolume& volume = m_LightVolumes.emplace_back();
+        XMStoreFloat3(&volume.Apex, apex);
+        XMStoreFloat3(&volume.Direction, direction);
+        volume.Range = range;
+        volume.CosHalfAngle = cosHalfAngle;
+        volume.SinHalfAngle = sinHalfAngle;
+
+        // The smallest sphere around the cone: the one through the apex and the rim of the base for a narrow cone,
+        // the one around the base for a wide cone. From 90 degrees, the light is as a point light.
+        float sphereOffset = 0.0f;
+        if (spotLight.HalfAngle >= XM_PIDIV2)
+        {
+            volume.Radius = range;
+            volume.IsSpotLight = false;
+        }
+        else if (spotLight.HalfAngle > XM_PIDIV4)
+        {
+            sphereOffset = range * cosHalfAngle;
+            volume.Radius = range * sinHalfAngle;
+            volume.IsSpotLight = true;
+        }
+        else
+        {
+            sphereOffset = range / (2.0f * cosHalfAngle);
+            volume.Radius = sphereOffset;
+            volume.IsSpotLight = true;
+        }
+
+        XMStoreFloat3(&volume.Center, XMVectorAdd(apex, XMVectorScale(direction, sphereOffset)));
+    }
+
+    m_Hits.clear();
+}
+
+bool LightClustering::Intersects(const LightVolume& light, const uint32_t tileX, const uint32_t tileY, const uint32_t slice) const
+{
+    const float minX = GetTileMinX(tileX, slice);
+    const float maxX = GetTileMaxX(tileX, slice);
+    const float minY = m_TileMinY[slice * m_Settings.TilesY + tileY];
+    const float maxY = m_TileMaxY[slice * m_Settings.TilesY + tileY];
+    const float minZ = m_SliceDistances[slice];
+    const float maxZ = m_SliceDistances[slice + 1];
+
+    // The bounding boxes, then the distance from the sphere's center to the cluster's box.
+    const XMFLOAT3& center = light.Center;
+    const float radius = light.Radius;
+    if (!(minX <= center.x + radius && maxX >= center.x - radius &&
+        minY <= center.y + radius && maxY >= center.y - radius &&
+        minZ <= center.z + radius && maxZ >= center.z - radius))
+    {
+        return false;
+    }
+
+    const float separationX = GetSeparation(minX, maxX, center.x);
+    const float separationY = GetSeparation(minY, maxY, center.y);
+    const float separationZ = GetSeparation(minZ, maxZ, center.z);
+    if (!((separationX * separationX + separationY * separationY) + separationZ * separationZ <= radius * radius))
+    {
+        return false;
+    }
+
+    if (!light.IsSpotLight)
+    {
+        return true;
+    }
+
+    // The cone against the cluster's bounding sphere: the distance from the sphere's center to the cone's side,
+    // and whether the sphere is behind the apex or past the range.
+    const float clusterCenterX = (minX + maxX) * 0.5f;
+    const float clusterCenterY = (minY + maxY) * 0.5f;
+    const float clusterCenterZ = (minZ + maxZ) * 0.5f;
+    const float halfExtentX = (maxX - minX) * 0.5f;
+    const float halfExtentY = (maxY - minY) * 0.5f;
+    const float halfExtentZ = (maxZ - minZ) * 0.5f;
+    const float clusterRadius = std::sqrt((halfExtentX * halfExtentX + halfExtentY * halfExtentY) + halfExtentZ * halfExtentZ);
+
+    const float offsetX = clusterCenterX - light.Apex.x;
+    const float offsetY = clusterCenterY - light.Apex.y;
+    const float offsetZ = clusterCenterZ - light.Apex.z;
+    const float offsetLengthSq = (offsetX * offsetX + offsetY * offsetY) + offsetZ * offsetZ;
+    const float axialDistance = (offsetX * light.Direction.x + offsetY * light.Direction.y) + offsetZ * light.Direction.z;
+    const float radialDistance = std::sqrt(std::max(offsetLengthSq - axialDistance * axialDistance, 0.0f));
+    const float sideDistance = light.CosHalfAngle * radialDistance - axialDistance * light.SinHalfAngle;
+
+    return sideDistance <= clusterRadius && axialDistance <= clusterRadius + light.Range && axialDistance >= -clusterRadius;
+}
+
+uint32_t LightClustering::IntersectsTileGroup(const LightVolume& light, const uint32_t tileGroupX, const uint32_t tileY, const uint32_t slice) const
+{
+    // The same tests as above, in the same order, for 4 tiles along X.
+    const auto& boundsX = m_TileGroupBoundsX[slice * m_TileGroupsCountX + tileGroupX];
+    const XMVECTOR minX = XMLoadFloat4A(&boundsX.Min);
+    const XMVECTOR maxX = XMLoadFloat4A(&boundsX.Max);
+    const float minY = m_TileMinY[slice * m_Settings.TilesY + tileY];
+    const float maxY = m_TileMaxY[slice * m_Settings.TilesY + tileY];
+    const float minZ = m_SliceDistances[slice];
+    const float maxZ = m_SliceDistances[slice + 1];
+
+    const XMFLOAT3& center = light.Center;
+    const float radius = light.Radius;
+    if (!(minY <= center.y + radius && maxY >= center.y - radius &&
+        minZ <= center.z + radius && maxZ >= center.z - radius))
+    {
+        return 0;
+    }
+
+    const XMVECTOR centerX = XMVectorReplicate(center.x);
+    XMVECTOR mask = XMVectorAndInt(XMVectorLessOrEqual(minX, XMVectorReplicate(center.x + radius)), XMVectorGreaterOrEqual(maxX, XMVectorReplicate(center.x - radius)));
+
+    const XMVECTOR separationX = GetSeparation(minX, maxX, centerX);
+    const float separationY = GetSeparation(minY, maxY, center.y);
+    const float separationZ = GetSeparation(minZ, maxZ, center.z);
+    const XMVECTOR distanceSq = XMVectorAdd(XMVectorAdd(XMVectorMultiply(separationX, separationX), XMVectorReplicate(separationY * separationY)), XMVectorReplicate(separationZ * separationZ));
+    mask = XMVectorAndInt(mask, XMVectorLessOrEqual(distanceSq, XMVectorReplicate(radius * radius)));
+
+    if (light.IsSpotLight)
+    {
+        const XMVECTOR half = XMVectorReplicate(0.5f);
+        const XMVECTOR clusterCenterX = XMVectorMultiply(XMVectorAdd(minX, maxX), half);
+        const float clusterCenterY = (minY + maxY) * 0.5f;
+        const float clusterCenterZ = (minZ + maxZ) * 0.5f;
+        const XMVECTOR halfExtentX = XMVectorMultiply(XMVectorSubtract(maxX, minX), half);
+        const float halfExtentY = (maxY - minY) * 0.5f;
+        const float halfExtentZ = (maxZ - minZ) * 0.5f;
+        const XMVECTOR clusterRadius = XMVectorSqrt(XMVectorAdd(XMVectorAdd(XMVectorMultiply(halfExtentX, halfExtentX), XMVectorReplicate(halfExtentY * halfExtentY)), XMVectorReplicate(halfExtentZ * halfExtentZ)));
+
+        const XMVECTOR offsetX = XMVectorSubtract(clusterCenterX, XMVectorReplicate(light.Apex.x));
+        const float offsetY = clusterCenterY - light.Apex.y;
+        const float offsetZ = clusterCenterZ - light.Apex.z;
+        const XMVECTOR offsetLengthSq = XMVectorAdd(XMVectorAdd(XMVectorMultiply(offsetX, offsetX), XMVectorReplicate(offsetY * offsetY)), XMVectorReplicate(offsetZ * offsetZ));
+        const XMVECTOR axialDistance = XMVectorAdd(XMVectorAdd(XMVectorMultiply(offsetX, XMVectorReplicate(light.Direction.x)), XMVectorReplicate(offsetY * light.Direction.y)), XMVectorReplicate(offsetZ * light.Direction.z));
+        const XMVECTOR radialDistance = XMVectorSqrt(XMVectorMax(XMVectorSubtract(offsetLengthSq, XMVectorMultiply(axialDistance, axialDistance)), XMVectorZero()));
+        const XMVECTOR sideDistance = XMVectorSubtract(XMVectorMultiply(XMVectorReplicate(light.CosHalfAngle), radialDistance), XMVectorMultiply(axialDistance, XMVectorReplicate(light.SinHalfAngle)));
+
+        mask = XMVectorAndInt(mask, XMVectorLessOrEqual(sideDistance, clusterRadius));
+        mask = XMVectorAndInt(mask, XMVectorLessOrEqual(axialDistance, XMVectorAdd(clusterRadius, XMVectorReplicate(light.Range))));
+        mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(axialDistance, XMVectorNegate(clusterRadius)));
+    }
+
+    uint32_t lanes[LANES_COUNT];
+    XMStoreInt4(lanes, mask);
+
+    uint32_t result = 0;
+    for (uint32_t lane = 0; lane < LANES_COUNT; ++lane)
+    {
+        result |= lanes[lane] != 0 ? 1u << lane : 0u;
+    }
+
+    return result;
+}
+
+void LightClustering::Finish()
+{
+    // Counting, then scattering the hits keeps the lights of every cluster in the order of the hits.
+    m_Clusters.assign(static_cast<size_t>(m_Settings.TilesX) * m_Settings.TilesY * m_Settings.SlicesCount, Cluster{ 0, 0 });
+    for (const auto& [clusterIndex, lightIndex] : m_Hits)
+    {
+        ++m_Clusters[clusterIndex].Count;
+    }
+
+    uint32_t offset = 0;
+    for (auto& cluster : m_Clusters)
+    {
+        cluster.Offset = offset;
+        offset += cluster.Count;
+        cluster.Count = 0;
+    }
+
+    m_LightIndices.resize(m_Hits.size());
+    for (const auto& [clusterIndex, lightIndex] : m_Hits)
+    {
+        auto& cluster = m_Clusters[clusterIndex];
+        m_LightIndices[cluster.Offset + cluster.Count++] = lightIndex;
+    }
+}
+
+float LightClustering::GetTileMinX(const uint32_t tileX, const uint32_t slice) const
+{
+    return GetLane(m_TileGroupBoundsX[slice * m_TileGroupsCountX + tileX / LANES_COUNT].Min, tileX % LANES_COUNT);
+}
+
+float LightClustering::GetTileMaxX(const uint32_t tileX, const uint32_t slice) const
+{
+    return GetLane(m_TileGroupBoundsX[slice * m_TileGroupsCountX + tileX / LANES_COUNT].Max, tileX % LANES_COUNT);
+}
@@ -0,0 +1,27 @@
+#include "LodSelector.h"
+
+#include <Framework/Aabb.h>
+
+#include <algorithm>
+
+using namespace DirectX;
+
+LodSelector::LodSelector(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, const float maxScreenError)
+    // Row vectors: the view-space depth is the dot product with the third column.
+    : m_ViewDepthAxis(XMMatrixTranspose(viewMatrix).r[2])
+    // cot(vFov / 2) for a perspective projection.
+    , m_ProjectionScale(XMVectorGetY(projectionMatrix.r[1]))
+    , m_MaxScreenError(maxScreenError)
+{ }
+
+float LodSelector::ComputeScreenSize(const Aabb& aabb) const
+{
+    constexpr float minDepth = 1e-6f;
+
+    const XMVECTOR center = XMVectorSetW((aabb.Min + aabb.Max) * 0.5f, 1.0f);
+    const float radius = XMVectorGetX(XMVector3Length(aabb.Max - aabb.Min)) * 0.5f;
+    const float depth = XMVectorGetX(XMVector4Dot(center, m_ViewDepthAxis));
+
+    // NDC spans [-1, 1], so the projected radius is the projected diameter relative to the viewport height.
+    return radius * m_ProjectionScale / std::max({ depth, radius, minDepth });
+}
@@ -1,13 +1,24 @@
 #include "Material.h"
 #include "CommonRootSignature.h"
 
-static const ShaderUtils::ConstantBufferMetadata* FindMaterialConstantBuffer(const Shader::ShaderMetadata& metadata)
+#include <DX12Library/TextureStreamer.h>
+
+namespace
+{
+    // "has_" + name is set when an SRV is assigned. FNV-1a can be continued, so the name does not have to be concatenated.
+    constexpr uint64_t HAS_SHADER_RESOURCE_VIEW_PREFIX_HASH = HashUtils::Fnv1a("has_");
+}
+
+static const ShaderUtils::ConstantBufferMetadata* FindMaterialConstantBuffer(const Shader::ShaderMetadata& metadata,
+    const std::unordered_map<uint64_t, size_t>** outVariablesNameHashCache)
 {
-    for (const auto& cbufferMetadata : metadata.m_ConstantBuffers)
+    for (size_t i = 0; i < metadata.m_ConstantBuffers.size(); ++i)
     {
+        const auto& cbufferMetadata = metadata.m_ConstantBuffers[i];
         if (cbufferMetadata.RegisterIndex != 0) continue;
         if (cbufferMetadata.Space != CommonRootSignature::MATERIAL_REGISTER_SPACE) continue;
 
+        *outVariablesNameHashCache = &metadata.m_ConstantBufferVariablesNameHashCache[i];
         return &cbufferMetadata;
     }
 
@@ -16,9 +27,12 @@ static const ShaderUtils::ConstantBufferMetadata* FindMaterialConstantBuffer(con
 
 Material::Material(const std::shared_ptr<Shader>& shader)
     : m_Shader(shader)
+    , m_ShaderResourceViews(shader->GetShaderResourceViewCount())
 {
-    const auto vsCbuffer = FindMaterialConstantBuffer(shader->GetVertexShaderMetadata());
-    const auto psCbuffer = FindMaterialConstantBuffer(shader->GetPixelShaderMetadata());
+    const std::unordered_map<uint64_t, size_t>* vsVariablesNameHashCache = nullptr;
+    const std::unordered_map<uint64_t, size_t>* psVariablesNameHashCache = nullptr;
+    const auto vsCbuffer = FindMaterialConstantBuffer(shader->GetVertexShaderMetadata(), &vsVariablesNameHashCache);
+    const auto psCbuffer = FindMaterialConstantBuffer(shader->GetPixelShaderMetadata(), &psVariablesNameHashCache);
 
     size_t cbufferSize;
 
@@ -31,27 +45,26 @@ Material::Material(const std::shared_ptr<Shader>& shader)
 
         cbufferSize = vsCbuffer->Size;
         m_Metadata = vsCbuffer;
+        m_VariablesNameHashCache = vsVariablesNameHashCache;
     }
     else if (vsCbuffer != nullptr)
     {
         cbufferSize = vsCbuffer->Size;
         m_Metadata = vsCbuffer;
+        m_VariablesNameHashCache = vsVariablesNameHashCache;
     }
     else if (psCbuffer != nullptr)
     {
         cbufferSize = psCbuffer->Size;
         m_Metadata = psCbuffer;
+        m_VariablesNameHashCache = psVariablesNameHashCache;
     }
     else
     {
-        m_ConstantBuffer = nullptr;
-        m_ConstantBufferSize = 0;
         return;
     }
 
-    m_ConstantBuffer.reset(new uint8_t[cbufferSize]);
-    m_ConstantBufferSize = cbufferSize;
-    memset(m_ConstantBuffer.get(), 0, m_ConstantBufferSize);
+    m_ConstantBuffer = std::make_unique<MaterialConstantBuffer>(cbufferSize, m_Metadata);
 
     for (const auto& variable : m_Metadata->Variables)
     {
@@ -60,29 +73,69 @@ Material::Material(const std::shared_ptr<Shader>& shader)
             continue;
         }
 
-        memcpy(m_ConstantBuffer.get() + variable.Offset, variable.DefaultValue.get(), variable.Size);
+        memcpy(m_ConstantBuffer->GetData() + variable.Offset, variable.DefaultValue.get(), variable.Size);
     }
 }
 
 Material::Material(const Material& materialPreset)
     : m_Shader(materialPreset.m_Shader)
     , m_Metadata(materialPreset.m_Metadata)
-    , m_ConstantBuffer()
-    , m_ConstantBufferSize(materialPreset.m_ConstantBufferSize)
+    , m_VariablesNameHashCache(materialPreset.m_VariablesNameHashCache)
+    , m_ConstantBuffer(materialPreset.m_ConstantBuffer != nullptr ? std::make_unique<MaterialConstantBuffer>(*materialPreset.m_ConstantBuffer) : nullptr)
     , m_ShaderResourceViews(materialPreset.m_ShaderResourceViews)
+{}
+
+void Material::SetAllVariables(size_t size, const void* data)
 {
-    m_ConstantBuffer.reset(new uint8_t[m_ConstantBufferSize]);
-    memcpy(m_ConstantBuffer.get(), materialPreset.m_ConstantBuffer.get(), m_ConstantBufferSize);
+    if (m_ConstantBuffer == nullptr)
+    {
+        if (size != 0)
+        {
+            throw std::exception("Constant buffer size mismatch.");
+        }
+
+        return;
+    }
+
+    m_ConstantBuffer->WriteAll(size, data);
 }
 
-void Material::SetAllVariables(size_t size, const void* data)
+MaterialParameterHandle Material::FindParameter(const uint64_t nameHash) const
 {
-    if (size != m_ConstantBufferSize)
+    if (m_VariablesNameHashCache == nullptr)
+    {
+        return {};
+    }
+
+    const auto findResult = m_VariablesNameHashCache->find(nameHash);
+    if (findResult == m_VariablesNameHashCache->end())
+    {
+        return {};
+    }
+
+    const auto& variable = m_Metadata->Variables[findResult->second];
+
+    MaterialParameterHandle handle;
+    handle.Offset = variable.Offset;
+    handle.Size = variable.Size;
+    handle.Layout = m_Metadata;
+    return handle;
+}
+
+void Material::WriteVariable(const MaterialParameterHandle& handle, const size_t size, const void* data, const bool array)
+{
+    if (!handle.IsValid())
+    {
+        return;
+    }
+
+    // A valid handle implies a constant buffer, so this one has been resolved for another material's layout.
+    if (m_ConstantBuffer == nullptr)
     {
-        throw std::exception("Constant buffer size mismatch.");
+        throw std::exception("The parameter handle was resolved for a different material layout.");
     }
 
-    memcpy(m_ConstantBuffer.get(), data, size);
+    m_ConstantBuffer->Write(handle, size, data, array);
 }
 
 void Material::SetVariable(const std::string& name, size_t size, const void* data, bool array, bool throwOnNotFound)
@@ -92,39 +145,32 @@ void Material::SetVariable(const std::string& name, size_t size, const void* dat
         return;
     }
 
-    for (const auto& variable : m_Metadata->Variables)
+    const auto handle = FindParameter(name);
+    if (!handle.IsValid())
     {
-        if (variable.Name != name) continue;
-
-        if (array)
-        {
-            if (size > variable.Size)
-            {
-                throw std::exception("The value is too big for the destination array variable.");
-            }
-        }
-        else
+        if (throwOnNotFound)
         {
-            if (size != variable.Size)
-            {
-                throw std::exception("Variable size mismatch.");
-            }
+            throw std::exception("Variable not found.");
         }
 
-        memcpy(m_ConstantBuffer.get() + variable.Offset, data, size);
         return;
     }
 
-    if (throwOnNotFound)
-    {
-        throw std::exception("Variable not found.");
-    }
+    WriteVariable(handle, size, data, array);
 }
 
 void Material::SetShaderResourceView(const std::string& name, const ShaderResourceView& shaderResourceView)
 {
-    m_ShaderResourceViews.insert_or_assign(name, shaderResourceView);
-    SetVariable<uint32_t>("has_" + name, 1u, false);
+    const auto id = m_Shader->FindShaderResourceView(name);
+    if (id == Shader::INVALID_SHADER_RESOURCE_VIEW_ID)
+    {
+        throw std::exception("Shader variable not found.");
+    }
+
+    m_ShaderResourceViews[id] = shaderResourceView;
+
+    const auto hasShaderResourceViewHandle = FindParameter(HashUtils::Fnv1a(name, HAS_SHADER_RESOURCE_VIEW_PREFIX_HASH));
+    SetVariable<uint32_t>(hasShaderResourceViewHandle, 1u);
 }
 
 void Material::Bind(CommandList& commandList)
@@ -154,6 +200,24 @@ void Material::EndBatch(CommandList& commandList)
     m_Shader->Unbind(commandList);
 }
 
+void Material::RequestTextureScreenSize(const float screenSizeInPixels) const
+{
+    if (!TextureStreamer::IsCreated())
+    {
+        return;
+    }
+
+    auto& textureStreamer = TextureStreamer::Get();
+
+    for (const auto& shaderResourceView : m_ShaderResourceViews)
+    {
+        if (shaderResourceView.has_value() && shaderResourceView->m_Resource != nullptr)
+        {
+            textureStreamer.RequestScreenSize(*shaderResourceView->m_Resource, screenSizeInPixels);
+        }
+    }
+}
+
 std::shared_ptr<Material> Material::Create(const std::shared_ptr<Shader>& shader)
 {
     return std::make_shared<Material>(shader);
@@ -171,16 +235,25 @@ void Material::UploadConstantBuffer(CommandList& commandList)
         return;
     }
 
-    m_Shader->SetMaterialConstantBuffer(commandList, m_ConstantBufferSize, m_ConstantBuffer.get());
+    const uint64_t uploadBufferGeneration = commandList.GetUploadBufferGeneration();
+    if (m_ConstantBuffer->NeedsUpload(uploadBufferGeneration))
+    {
+        const auto allocation = commandList.AllocateInUploadBuffer(m_ConstantBuffer->GetSize(), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+        memcpy(allocation.Cpu, m_ConstantBuffer->GetData(), m_ConstantBuffer->GetSize());
+        m_ConstantBuffer->OnUploaded(uploadBufferGeneration, allocation.Gpu);
+    }
+
+    m_Shader->SetMaterialConstantBuffer(commandList, m_ConstantBuffer->GetUploadedAddress());
 }
 
 void Material::UploadShaderResourceViews(CommandList& commandList)
 {
-    for (const auto& srvName : m_ShaderResourceViews)
+    for (Shader::ShaderResourceViewId id = 0; id < m_ShaderResourceViews.size(); ++id)
     {
-        const auto& name = srvName.first;
-        const auto& shaderResourceView = srvName.second;
-
-        m_Shader->SetShaderResourceView(commandList, name, shaderResourceView);
+        const auto& shaderResourceView = m_ShaderResourceViews[id];
+        if (shaderResourceView.has_value())
+        {
+            m_Shader->SetShaderResourceView(commandList, id, *shaderResourceView);
+        }
     }
 }
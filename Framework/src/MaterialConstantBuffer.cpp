@@ -0,0 +1,87 @@
+#include "MaterialConstantBuffer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+MaterialConstantBuffer::MaterialConstantBuffer(const size_t size, const void* layout)
+    : m_Data(new uint8_t[size])
+    , m_Size(size)
+    , m_Layout(layout)
+{
+    memset(m_Data.get(), 0, m_Size);
+}
+
+MaterialConstantBuffer::MaterialConstantBuffer(const MaterialConstantBuffer& other)
+    : m_Data(new uint8_t[other.m_Size])
+    , m_Size(other.m_Size)
+    , m_Layout(other.m_Layout)
+{
+    // The copy has not been uploaded yet.
+    memcpy(m_Data.get(), other.m_Data.get(), m_Size);
+}
+
+void MaterialConstantBuffer::Write(const MaterialParameterHandle& handle, const size_t size, const void* data, const bool array)
+{
+    if (!handle.IsValid())
+    {
+        return;
+    }
+
+    if (handle.Layout != m_Layout)
+    {
+        throw std::invalid_argument("The parameter handle was resolved for a different material layout.");
+    }
+
+    if (array)
+    {
+        if (size > handle.Size)
+        {
+            throw std::invalid_argument("The value is too big for the destination array variable.");
+        }
+    }
+    else
+    {
+        if (size != handle.Size)
+        {
+            throw std::invalid_argument("Variable size mismatch.");
+        }
+    }
+
+    auto* destination = m_Data.get() + handle.Offset;
+    if (memcmp(destination, data, size) == 0)
+    {
+        return;
+    }
+
+    memcpy(destination, data, size);
+    m_IsDirty = true;
+}
+
+void MaterialConstantBuffer::WriteAll(const size_t size, const void* data)
+{
+    if (size != m_Size)
+    {
+        throw std::invalid_argument("Constant buffer size mismatch.");
+    }
+
+    if (memcmp(m_Data.get(), data, size) == 0)
+    {
+        return;
+    }
+
+    memcpy(m_Data.get(), data, size);
+    m_IsDirty = true;
+}
+
+bool MaterialConstantBuffer::NeedsUpload(const uint64_t uploadBufferGeneration) const
+{
+    // Allocations from the previous generations have been released together with the upload buffer pages.
+    return m_IsDirty || m_UploadBufferGeneration != uploadBufferGeneration;
+}
+
+void MaterialConstantBuffer::OnUploaded(const uint64_t uploadBufferGeneration, const uint64_t uploadedAddress)
+{
+    m_UploadedAddress = uploadedAddress;
+    m_UploadBufferGeneration = uploadBufferGeneration;
+    m_IsDirty = false;
+}
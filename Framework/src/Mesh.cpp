@@ -1,8 +1,10 @@
 ﻿#include <DX12Library/DX12LibPCH.h>
 #include <Framework/Mesh.h>
 #include <Framework/Bone.h>
+#include <Framework/LodSelector.h>
 
 #include <DX12Library/Application.h>
+#include <DX12Library/Helpers.h>
 
 #include <DirectXMesh.h>
 
@@ -57,6 +59,29 @@ namespace
         }
     }
 
+    void CopyVertices(CommandList& commandList, VertexBuffer& vertexBuffer, const VertexCollectionType& vertices)
+    {
+        constexpr auto& layout = VertexAttributes::LAYOUT;
+
+        std::vector<uint8_t> encodedVertices(vertices.size() * layout.GetStride());
+        layout.Encode(vertices.data(), vertices.size(), encodedVertices.data());
+        commandList.CopyVertexBuffer(vertexBuffer, vertices.size(), layout.GetStride(), encodedVertices.data());
+    }
+
+    void CopyIndices(CommandList& commandList, IndexBuffer& indexBuffer, const IndexCollectionType& indices, const size_t numVertices)
+    {
+        if (numVertices <= Mesh::MAX_VERTICES_FOR_16_BIT_INDICES)
+        {
+            std::vector<uint16_t> narrowIndices(indices.size());
+            std::transform(indices.begin(), indices.end(), narrowIndices.begin(), [](const uint32_t index) { return static_cast<uint16_t>(index); });
+            commandList.CopyIndexBuffer(indexBuffer, narrowIndices);
+        }
+        else
+        {
+            commandList.CopyIndexBuffer(indexBuffer, indices);
+        }
+    }
+
     // Helper for flipping winding of geometric primitives for LH vs. RH coords
     void ReverseWinding(IndexCollectionType& indices, VertexCollectionType& vertices)
     {
@@ -73,29 +98,6 @@ namespace
     }
 }
 
-const D3D12_INPUT_ELEMENT_DESC VertexAttributes::INPUT_ELEMENTS[] = {
-    {
-        "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_BUFFER_SLOT_INDEX, D3D12_APPEND_ALIGNED_ELEMENT,
-        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-    },
-    {
-        "NORMAL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_BUFFER_SLOT_INDEX, D3D12_APPEND_ALIGNED_ELEMENT,
-        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-    },
-    {
-        "TEXCOORD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_BUFFER_SLOT_INDEX, D3D12_APPEND_ALIGNED_ELEMENT,
-        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-    },
-    {
-        "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_BUFFER_SLOT_INDEX, D3D12_APPEND_ALIGNED_ELEMENT,
-        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-    },
-    {
-        "BINORMAL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, VERTEX_BUFFER_SLOT_INDEX, D3D12_APPEND_ALIGNED_ELEMENT,
-        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-    },
-};
-
 void SkinningVertexAttributes::NormalizeWeights()
 {
     float totalWeight = 0.0f;
@@ -124,7 +126,7 @@ const D3D12_INPUT_ELEMENT_DESC SkinningVertexAttributes::INPUT_ELEMENTS[] = {
     },
 };
 
-Mesh::Mesh() : m_IndexCount(0)
+Mesh::Mesh() : m_Lods(1, Lod{ 0, 0, 0.0f })
 {}
 
 void Mesh::SetSkinningVertexAttributes(CommandList& commandList, const SkinningVertexCollectionType& vertexAttributes)
@@ -166,11 +168,6 @@ MeshPrototype::MeshPrototype(VertexCollectionType&& vertices, IndexCollectionTyp
         throw std::exception("Empty index buffer.");
     }
 
-    if (m_Vertices.size() >= USHRT_MAX)
-    {
-        throw std::exception("Too many vertices for 16-bit index buffer");
-    }
-
     if (!rhCoords)
     {
         ReverseWinding(m_Indices, m_Vertices);
@@ -198,10 +195,26 @@ void MeshPrototype::AddVertexAttributes(const MeshPrototype& otherPrototype)
     AddToVector(m_SkinningVertexAttributes, otherPrototype.m_SkinningVertexAttributes);
 }
 
-void Mesh::Draw(CommandList& commandList, const uint32_t instanceCount) const
+MeshOptimization::Result MeshPrototype::Optimize(const MeshOptimization::Settings& settings)
+{
+    const float* positions = m_Vertices.empty() ? nullptr : &m_Vertices[0].Position.x;
+    MeshOptimization::Result result = MeshOptimization::Optimize(m_Indices,
+        positions, m_Vertices.size(), sizeof(VertexAttributes), VertexAttributes::LAYOUT.GetStride(), settings
+    );
+
+    MeshOptimization::RemapVertices(m_Vertices, result);
+    MeshOptimization::RemapVertices(m_SkinningVertexAttributes, result);
+    m_Lods = result.Lods;
+
+    return result;
+}
+
+void Mesh::Draw(CommandList& commandList, const uint32_t instanceCount, const uint32_t lodIndex) const
 {
     Bind(commandList);
-    commandList.DrawIndexed(m_IndexCount, instanceCount);
+
+    const Lod& lod = GetLod(std::min(lodIndex, GetLodCount() - 1));
+    commandList.DrawIndexed(lod.IndexCount, instanceCount, lod.StartIndex);
 }
 
 void Mesh::Bind(CommandList& commandList) const
@@ -217,7 +230,22 @@ void Mesh::Bind(CommandList& commandList) const
 
 UINT Mesh::GetIndexCount() const
 {
-    return m_IndexCount;
+    return m_Lods[0].IndexCount;
+}
+
+uint32_t Mesh::GetLodCount() const
+{
+    return static_cast<uint32_t>(m_Lods.size());
+}
+
+const Mesh::Lod& Mesh::GetLod(const uint32_t lodIndex) const
+{
+    return m_Lods[lodIndex];
+}
+
+uint32_t Mesh::SelectLod(const float screenSize, const float maxScreenError) const
+{
+    return LodSelector::SelectLod(m_Lods.data(), GetLodCount(), screenSize, maxScreenError);
 }
 
 std::shared_ptr<Mesh> Mesh::CreateSphere(CommandList& commandList, float diameter, size_t tessellation, bool rhcoords)
@@ -272,13 +300,13 @@ std::shared_ptr<Mesh> Mesh::CreateSphere(CommandList& commandList, float diamete
             size_t nextI = i + 1;
             size_t nextJ = (j + 1) % stride;
 
-            indices.push_back(static_cast<uint16_t>(i * stride + j));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + j));
-            indices.push_back(static_cast<uint16_t>(i * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(i * stride + j));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + j));
+            indices.push_back(static_cast<uint32_t>(i * stride + nextJ));
 
-            indices.push_back(static_cast<uint16_t>(i * stride + nextJ));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + j));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(i * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + j));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + nextJ));
         }
     }
 
@@ -326,13 +354,13 @@ std::shared_ptr<Mesh> Mesh::CreateCube(CommandList& commandList, float size, boo
 
         // Six indices (two triangles) per face.
         size_t vbase = vertices.size();
-        indices.push_back(static_cast<uint16_t>(vbase + 0));
-        indices.push_back(static_cast<uint16_t>(vbase + 1));
-        indices.push_back(static_cast<uint16_t>(vbase + 2));
+        indices.push_back(static_cast<uint32_t>(vbase + 0));
+        indices.push_back(static_cast<uint32_t>(vbase + 1));
+        indices.push_back(static_cast<uint32_t>(vbase + 2));
 
-        indices.push_back(static_cast<uint16_t>(vbase + 0));
-        indices.push_back(static_cast<uint16_t>(vbase + 2));
-        indices.push_back(static_cast<uint16_t>(vbase + 3));
+        indices.push_back(static_cast<uint32_t>(vbase + 0));
+        indices.push_back(static_cast<uint32_t>(vbase + 2));
+        indices.push_back(static_cast<uint32_t>(vbase + 3));
 
         // Four vertices per face.
         vertices.push_back(VertexAttributes((normal - side1 - side2) * size, normal, textureCoordinates[0]));
@@ -383,9 +411,9 @@ static void CreateCylinderCap(VertexCollectionType& vertices, IndexCollectionTyp
         }
 
         size_t vbase = vertices.size();
-        indices.push_back(static_cast<uint16_t>(vbase));
-        indices.push_back(static_cast<uint16_t>(vbase + i1));
-        indices.push_back(static_cast<uint16_t>(vbase + i2));
+        indices.push_back(static_cast<uint32_t>(vbase));
+        indices.push_back(static_cast<uint32_t>(vbase + i1));
+        indices.push_back(static_cast<uint32_t>(vbase + i2));
     }
 
     // Which end of the cylinder is this?
@@ -448,9 +476,9 @@ std::shared_ptr<Mesh> Mesh::CreateCone(CommandList& commandList, float diameter,
         vertices.push_back(VertexAttributes(topOffset, normal, g_XMZero));
         vertices.push_back(VertexAttributes(pt, normal, textureCoordinate + g_XMIdentityR1));
 
-        indices.push_back(static_cast<uint16_t>(i * 2));
-        indices.push_back(static_cast<uint16_t>((i * 2 + 3) % (stride * 2)));
-        indices.push_back(static_cast<uint16_t>((i * 2 + 1) % (stride * 2)));
+        indices.push_back(static_cast<uint32_t>(i * 2));
+        indices.push_back(static_cast<uint32_t>((i * 2 + 3) % (stride * 2)));
+        indices.push_back(static_cast<uint32_t>((i * 2 + 1) % (stride * 2)));
     }
 
     // Create flat triangle fan caps to seal the bottom.
@@ -505,13 +533,13 @@ std::shared_ptr<Mesh> Mesh::CreateTorus(CommandList& commandList, float diameter
             size_t nextI = (i + 1) % stride;
             size_t nextJ = (j + 1) % stride;
 
-            indices.push_back(static_cast<uint16_t>(i * stride + j));
-            indices.push_back(static_cast<uint16_t>(i * stride + nextJ));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + j));
+            indices.push_back(static_cast<uint32_t>(i * stride + j));
+            indices.push_back(static_cast<uint32_t>(i * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + j));
 
-            indices.push_back(static_cast<uint16_t>(i * stride + nextJ));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + nextJ));
-            indices.push_back(static_cast<uint16_t>(nextI * stride + j));
+            indices.push_back(static_cast<uint32_t>(i * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + nextJ));
+            indices.push_back(static_cast<uint32_t>(nextI * stride + j));
         }
     }
 
@@ -623,27 +651,87 @@ std::shared_ptr<Mesh> Mesh::CreateMesh(CommandList& commandList, const MeshProto
     return mesh;
 }
 
+std::shared_ptr<Mesh> Mesh::CreateMesh(CommandList& commandList, const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh)
+{
+    auto mesh = std::make_shared<Mesh>();
+    mesh->Initialize(commandList, cookedModel, cookedMesh);
+    return mesh;
+}
+
+Armature Mesh::CreateArmature(const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh)
+{
+    Armature armature;
+    if (cookedMesh.NumBones == 0)
+    {
+        return armature;
+    }
+
+    std::vector<Bone> bones(cookedMesh.NumBones);
+    for (uint32_t boneIndex = 0; boneIndex < cookedMesh.NumBones; ++boneIndex)
+    {
+        const auto& cookedBone = cookedMesh.Bones[boneIndex];
+        auto& bone = bones[boneIndex];
+
+        bone.Name = cookedModel.GetBoneName(cookedBone);
+        bone.Offset = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(cookedBone.Offset));
+        bone.LocalTransform = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(cookedBone.LocalTransform));
+        bone.GlobalTransform = XMMatrixIdentity();
+        bone.IsDirty = true;
+    }
+
+    // The cooker sorts the bones so that parents come before their children.
+    std::vector<uint32_t> parentIndices(cookedMesh.NumBones, Armature::NO_PARENT);
+    for (uint32_t boneIndex = 0; boneIndex < cookedMesh.NumBones; ++boneIndex)
+    {
+        const auto& cookedBone = cookedMesh.Bones[boneIndex];
+        const uint32_t* children = cookedModel.GetBoneChildren(cookedBone);
+
+        for (uint32_t childIndex = 0; childIndex < cookedBone.NumChildren; ++childIndex)
+        {
+            parentIndices[children[childIndex]] = boneIndex;
+        }
+    }
+
+    armature.SetBones(bones, parentIndices);
+    return armature;
+}
+
 void Mesh::Initialize(CommandList& commandList, VertexCollectionType& vertices, IndexCollectionType& indices,
     bool rhCoords)
 {
-    if (vertices.size() >= USHRT_MAX)
-        throw std::exception("Too many vertices for 16-bit index buffer");
-
     if (!rhCoords)
         ReverseWinding(indices, vertices);
 
     CalculateAabb(vertices);
-    commandList.CopyVertexBuffer(m_VertexBuffer, vertices);
-    commandList.CopyIndexBuffer(m_IndexBuffer, indices);
+    CopyVertices(commandList, m_VertexBuffer, vertices);
+    CopyIndices(commandList, m_IndexBuffer, indices, vertices.size());
 
-    m_IndexCount = static_cast<UINT>(indices.size());
+    m_Lods = { { 0, static_cast<UINT>(indices.size()), 0.0f } };
 }
 
 void Mesh::Initialize(CommandList& commandList, const MeshPrototype& prototype)
 {
     CalculateAabb(prototype.m_Vertices);
-    commandList.CopyVertexBuffer(m_VertexBuffer, prototype.m_Vertices);
-    commandList.CopyIndexBuffer(m_IndexBuffer, prototype.m_Indices);
+    CopyVertices(commandList, m_VertexBuffer, prototype.m_Vertices);
+
+    m_Lods = { { 0, static_cast<UINT>(prototype.m_Indices.size()), 0.0f } };
+
+    if (prototype.m_Lods.empty())
+    {
+        CopyIndices(commandList, m_IndexBuffer, prototype.m_Indices, prototype.m_Vertices.size());
+    }
+    else
+    {
+        // One index buffer for all the LODs.
+        IndexCollectionType indices = prototype.m_Indices;
+        for (const auto& lod : prototype.m_Lods)
+        {
+            m_Lods.push_back({ static_cast<UINT>(indices.size()), static_cast<UINT>(lod.Indices.size()), lod.Error });
+            indices.insert(indices.end(), lod.Indices.begin(), lod.Indices.end());
+        }
+
+        CopyIndices(commandList, m_IndexBuffer, indices, prototype.m_Vertices.size());
+    }
 
     m_Armature = prototype.m_Armature;
 
@@ -651,8 +739,33 @@ void Mesh::Initialize(CommandList& commandList, const MeshPrototype& prototype)
     {
         SetSkinningVertexAttributes(commandList, prototype.m_SkinningVertexAttributes);
     }
+}
+
+void Mesh::Initialize(CommandList& commandList, const CookedModelView& cookedModel, const CookedModelView::MeshView& cookedMesh)
+{
+    // Same w components as CalculateAabb produces.
+    m_Aabb.Min = XMVectorSet(cookedMesh.AabbMin[0], cookedMesh.AabbMin[1], cookedMesh.AabbMin[2], 0.0f);
+    m_Aabb.Max = XMVectorSet(cookedMesh.AabbMax[0], cookedMesh.AabbMax[1], cookedMesh.AabbMax[2], 1.0f);
+
+    Assert(cookedModel.GetVertexLayout() == VertexAttributes::LAYOUT, "The cooked model has to be in the vertex buffer layout.");
+
+    const DXGI_FORMAT indexFormat = cookedMesh.IndexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    commandList.CopyVertexBuffer(m_VertexBuffer, cookedMesh.NumVertices, cookedMesh.VertexStride, cookedMesh.Vertices);
+    commandList.CopyIndexBuffer(m_IndexBuffer, cookedMesh.NumIndices, indexFormat, cookedMesh.Indices);
+
+    m_Armature = CreateArmature(cookedModel, cookedMesh);
 
-    m_IndexCount = static_cast<UINT>(prototype.m_Indices.size());
+    if (cookedMesh.NumSkinningVertices > 0)
+    {
+        commandList.CopyVertexBuffer(m_SkinningVertexBuffer, cookedMesh.NumSkinningVertices, sizeof(SkinningVertexAttributes), cookedMesh.SkinningVertices);
+    }
+
+    m_Lods.resize(cookedMesh.NumLods);
+    for (uint32_t lodIndex = 0; lodIndex < cookedMesh.NumLods; ++lodIndex)
+    {
+        const auto& cookedLod = cookedMesh.Lods[lodIndex];
+        m_Lods[lodIndex] = { cookedLod.IndexOffset, cookedLod.NumIndices, cookedLod.Error };
+    }
 }
 
 void Mesh::CalculateAabb(const VertexCollectionType& vertices)
@@ -0,0 +1,165 @@
+#include "MeshOptimization.h"
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    void Validate(const std::vector<uint32_t>& indices, const size_t numVertices)
+    {
+        if (indices.size() % 3 != 0)
+        {
+            throw std::runtime_error("The index count is not a multiple of 3.");
+        }
+
+        if (std::any_of(indices.begin(), indices.end(), [numVertices](const uint32_t index) { return index >= numVertices; }))
+        {
+            throw std::runtime_error("Index out of range.");
+        }
+    }
+
+    void GenerateLods(const std::vector<uint32_t>& indices,
+        const float* positions, const size_t numVertices, const size_t positionStride,
+        const MeshOptimization::Settings& settings, std::vector<MeshOptimization::Lod>& lods)
+    {
+        size_t previousIndexCount = indices.size();
+
+        for (uint32_t lodIndex = 0; lodIndex < settings.MaxLods; ++lodIndex)
+        {
+            const size_t targetIndexCount = static_cast<size_t>(static_cast<float>(previousIndexCount) * settings.LodReduction) / 3 * 3;
+            if (targetIndexCount < 3)
+            {
+                break;
+            }
+
+            MeshOptimization::Lod lod;
+            lod.Indices.resize(indices.size());
+
+            // Always simplified from the full mesh, so that the error of each LOD is measured against the original.
+            const size_t indexCount = meshopt_simplify(lod.Indices.data(), indices.data(), indices.size(),
+                positions, numVertices, positionStride,
+                targetIndexCount, settings.LodTargetError, 0, &lod.Error
+            );
+
+            // The error limit has been reached: further LODs would not be any smaller.
+            if (indexCount == 0 || static_cast<float>(indexCount) > static_cast<float>(previousIndexCount) * settings.LodMinReduction)
+            {
+                break;
+            }
+
+            lod.Indices.resize(indexCount);
+
+            if (settings.OptimizeVertexCache)
+            {
+                meshopt_optimizeVertexCache(lod.Indices.data(), lod.Indices.data(), lod.Indices.size(), numVertices);
+            }
+
+            previousIndexCount = indexCount;
+            lods.push_back(std::move(lod));
+        }
+    }
+
+    void RemapIndices(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap)
+    {
+        meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+    }
+
+    // Packed float3 positions in the new vertex order.
+    std::vector<float> RemapPositions(const float* positions, const size_t numVertices, const size_t positionStride, const MeshOptimization::Result& result)
+    {
+        std::vector<float> remappedPositions(result.NumVertices * 3);
+
+        for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+        {
+            const uint32_t newIndex = result.VertexRemap[vertexIndex];
+            if (newIndex != MeshOptimization::UNUSED_VERTEX)
+            {
+                const auto* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertexIndex * positionStride);
+                std::copy_n(position, 3, remappedPositions.data() + newIndex * 3);
+            }
+        }
+
+        return remappedPositions;
+    }
+}
+
+MeshOptimization::Statistics MeshOptimization::Analyze(const uint32_t* indices, const size_t numIndices,
+    const float* positions, const size_t numVertices, const size_t positionStride, const size_t vertexSize)
+{
+    Statistics statistics;
+
+    if (numIndices == 0 || numVertices == 0)
+    {
+        return statistics;
+    }
+
+    const meshopt_VertexCacheStatistics vertexCache = meshopt_analyzeVertexCache(indices, numIndices, numVertices, REFERENCE_VERTEX_CACHE_SIZE, 0, 0);
+    const meshopt_OverdrawStatistics overdraw = meshopt_analyzeOverdraw(indices, numIndices, positions, numVertices, positionStride);
+    const meshopt_VertexFetchStatistics vertexFetch = meshopt_analyzeVertexFetch(indices, numIndices, numVertices, vertexSize);
+
+    statistics.Acmr = vertexCache.acmr;
+    statistics.Atvr = vertexCache.atvr;
+    statistics.Overdraw = overdraw.overdraw;
+    statistics.Overfetch = vertexFetch.overfetch;
+    return statistics;
+}
+
+MeshOptimization::Result MeshOptimization::Optimize(std::vector<uint32_t>& indices,
+    const float* positions, const size_t numVertices, const size_t positionStride, const size_t vertexSize,
+    const Settings& settings)
+{
+    Validate(indices, numVertices);
+
+    Result result;
+    result.NumVertices = numVertices;
+    result.Before = Analyze(indices.data(), indices.size(), positions, numVertices, positionStride, vertexSize);
+
+    if (indices.empty())
+    {
+        result.After = result.Before;
+        return result;
+    }
+
+    if (settings.OptimizeVertexCache)
+    {
+        meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), numVertices);
+    }
+
+    // Reorders clusters of the vertex cache optimized triangles, so it has to come after it.
+    if (settings.OptimizeOverdraw)
+    {
+        meshopt_optimizeOverdraw(indices.data(), indices.data(), indices.size(),
+            positions, numVertices, positionStride, settings.OverdrawThreshold
+        );
+    }
+
+    GenerateLods(indices, positions, numVertices, positionStride, settings, result.Lods);
+
+    if (!settings.OptimizeVertexFetch)
+    {
+        result.After = Analyze(indices.data(), indices.size(), positions, numVertices, positionStride, vertexSize);
+        return result;
+    }
+
+    // The LODs share the vertex buffer: the full mesh goes first so that the order of its vertices has the priority.
+    std::vector<uint32_t> allIndices = indices;
+    for (const Lod& lod : result.Lods)
+    {
+        allIndices.insert(allIndices.end(), lod.Indices.begin(), lod.Indices.end());
+    }
+
+    result.VertexRemap.resize(numVertices);
+    result.NumVertices = meshopt_optimizeVertexFetchRemap(result.VertexRemap.data(), allIndices.data(), allIndices.size(), numVertices);
+
+    RemapIndices(indices, result.VertexRemap);
+    for (Lod& lod : result.Lods)
+    {
+        RemapIndices(lod.Indices, result.VertexRemap);
+    }
+
+    const std::vector<float> remappedPositions = RemapPositions(positions, numVertices, positionStride, result);
+    result.After = Analyze(indices.data(), indices.size(), remappedPositions.data(), result.NumVertices, sizeof(float) * 3, vertexSize);
+    return result;
+}
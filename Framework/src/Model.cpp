@@ -27,4 +27,12 @@ void Model::Draw(CommandList& commandList) const
 	{
 		mesh->Draw(commandList);
 	}
+}
+
+void Model::Draw(CommandList& commandList, const std::vector<uint32_t>& meshLods) const
+{
+	for (size_t meshIndex = 0; meshIndex < m_Meshes.size(); ++meshIndex)
+	{
+		m_Meshes[meshIndex]->Draw(commandList, 1, meshLods[meshIndex]);
+	}
 }
\ No newline at end of file
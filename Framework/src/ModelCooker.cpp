@@ -0,0 +1,490 @@
+#include "ModelCooker.h"
+
+#include <DX12Library/ThreadPool.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    constexpr auto AI_FLAGS = aiProcess_ConvertToLeftHanded |
+        aiProcess_CalcTangentSpace |
+        aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_SortByPType |
+        aiProcess_GenSmoothNormals |
+        aiProcess_PopulateArmatureData |
+        aiProcess_LimitBoneWeights;
+
+    void SetPosition(float (&destination)[4], const aiVector3D& vector)
+    {
+        destination[0] = vector.x;
+        destination[1] = vector.y;
+        destination[2] = vector.z;
+        destination[3] = 1.0f;
+    }
+
+    void SetVector(float (&destination)[4], const aiVector3D& vector)
+    {
+        destination[0] = vector.x;
+        destination[1] = vector.y;
+        destination[2] = vector.z;
+        destination[3] = 0.0f;
+    }
+
+    void SetMatrix(float (&destination)[16], const aiMatrix4x4& matrix)
+    {
+        // transpose to convert to the left-handed orientation
+        const float values[16] = {
+            matrix.a1, matrix.b1, matrix.c1, matrix.d1,
+            matrix.a2, matrix.b2, matrix.c2, matrix.d2,
+            matrix.a3, matrix.b3, matrix.c3, matrix.d3,
+            matrix.a4, matrix.b4, matrix.c4, matrix.d4,
+        };
+        memcpy(destination, values, sizeof(values));
+    }
+
+    void NormalizeWeights(CookedModelFile::SkinningVertex& vertex)
+    {
+        float totalWeight = 0.0f;
+
+        for (const float weight : vertex.Weights)
+        {
+            totalWeight += weight;
+        }
+
+        if (totalWeight == 0.0f) return;
+
+        for (float& weight : vertex.Weights)
+        {
+            weight /= totalWeight;
+        }
+    }
+
+    void CalculateAabb(CookedModelFile::Mesh& mesh)
+    {
+        // Matches Mesh::CalculateAabb, which starts from an empty box at the origin.
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            mesh.AabbMin[i] = 0.0f;
+            mesh.AabbMax[i] = 0.0f;
+        }
+
+        for (const auto& vertex : mesh.Vertices)
+        {
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                mesh.AabbMin[i] = std::min(mesh.AabbMin[i], vertex.Position[i]);
+                mesh.AabbMax[i] = std::max(mesh.AabbMax[i], vertex.Position[i]);
+            }
+        }
+    }
+
+    /**
+     * Reorder the bones depth-first from the roots, so that parents come before their children (and every subtree is a contiguous range).
+     * The global transforms are then updated in a single pass (see Armature).
+     */
+    void SortBones(CookedModelFile::Mesh& mesh)
+    {
+        constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+        const auto numBones = static_cast<uint32_t>(mesh.Bones.size());
+        if (numBones == 0)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> parentIndices(numBones, NO_INDEX);
+        for (uint32_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            for (const uint32_t childIndex : mesh.Bones[boneIndex].Children)
+            {
+                parentIndices[childIndex] = boneIndex;
+            }
+        }
+
+        // sortedIndices[new index] = old index
+        std::vector<uint32_t> sortedIndices;
+        sortedIndices.reserve(numBones);
+        std::vector<uint32_t> stack;
+        std::vector<bool> isVisited(numBones, false);
+
+        for (uint32_t rootIndex = 0; rootIndex < numBones; ++rootIndex)
+        {
+            if (parentIndices[rootIndex] != NO_INDEX)
+            {
+                continue;
+            }
+
+            stack.push_back(rootIndex);
+            while (!stack.empty())
+            {
+                const uint32_t boneIndex = stack.back();
+                stack.pop_back();
+
+                if (isVisited[boneIndex])
+                {
+                    throw std::runtime_error("The bone hierarchy is not a tree.");
+                }
+
+                isVisited[boneIndex] = true;
+                sortedIndices.push_back(boneIndex);
+
+                const auto& children = mesh.Bones[boneIndex].Children;
+                stack.insert(stack.end(), children.rbegin(), children.rend());
+            }
+        }
+
+        if (sortedIndices.size() != numBones)
+        {
+            throw std::runtime_error("The bone hierarchy is not a tree.");
+        }
+
+        std::vector<uint32_t> newIndices(numBones);
+        for (uint32_t newIndex = 0; newIndex < numBones; ++newIndex)
+        {
+            newIndices[sortedIndices[newIndex]] = newIndex;
+        }
+
+        std::vector<CookedModelFile::Bone> sortedBones(numBones);
+        for (uint32_t newIndex = 0; newIndex < numBones; ++newIndex)
+        {
+            sortedBones[newIndex] = std::move(mesh.Bones[sortedIndices[newIndex]]);
+            for (auto& childIndex : sortedBones[newIndex].Children)
+            {
+                childIndex = newIndices[childIndex];
+            }
+        }
+        mesh.Bones = std::move(sortedBones);
+
+        for (auto& vertex : mesh.SkinningVertices)
+        {
+            for (auto& boneId : vertex.BoneIds)
+            {
+                boneId = newIndices[boneId];
+            }
+        }
+    }
+
+    void ImportBones(const aiMesh& mesh, CookedModelFile::Mesh& outputMesh)
+    {
+        outputMesh.Bones.resize(mesh.mNumBones);
+        outputMesh.SkinningVertices.resize(mesh.mNumVertices);
+
+        std::unordered_map<std::string, uint32_t> boneIndicesByNames;
+
+        for (unsigned int boneIndex = 0; boneIndex < mesh.mNumBones; ++boneIndex)
+        {
+            const auto meshBone = mesh.mBones[boneIndex];
+
+            auto& bone = outputMesh.Bones[boneIndex];
+            bone.Name = meshBone->mName.C_Str();
+            SetMatrix(bone.Offset, meshBone->mOffsetMatrix);
+            boneIndicesByNames.emplace(bone.Name, boneIndex);
+
+            for (unsigned int weightIndex = 0; weightIndex < meshBone->mNumWeights; ++weightIndex)
+            {
+                const auto& weight = meshBone->mWeights[weightIndex];
+                auto& vertex = outputMesh.SkinningVertices[weight.mVertexId];
+
+                // try put the weight into any of the available slots of the vertex
+                for (uint32_t slot = 0; slot < CookedModelFile::BONES_PER_VERTEX; slot++)
+                {
+                    // search for the first 0 weight and fill it
+                    if (vertex.Weights[slot] == 0.0f)
+                    {
+                        vertex.BoneIds[slot] = boneIndex;
+                        vertex.Weights[slot] = weight.mWeight;
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (auto& vertex : outputMesh.SkinningVertices)
+        {
+            NormalizeWeights(vertex);
+        }
+
+        for (unsigned int boneIndex = 0; boneIndex < mesh.mNumBones; ++boneIndex)
+        {
+            const auto meshBoneNode = mesh.mBones[boneIndex]->mNode;
+            auto& bone = outputMesh.Bones[boneIndex];
+            SetMatrix(bone.LocalTransform, meshBoneNode->mTransformation);
+
+            for (unsigned int childIndex = 0; childIndex < meshBoneNode->mNumChildren; ++childIndex)
+            {
+                const auto findResult = boneIndicesByNames.find(meshBoneNode->mChildren[childIndex]->mName.C_Str());
+                if (findResult != boneIndicesByNames.end())
+                {
+                    bone.Children.push_back(findResult->second);
+                }
+            }
+        }
+
+        SortBones(outputMesh);
+    }
+
+    void ValidateMesh(const aiMesh& mesh)
+    {
+        if (mesh.mNumVertices == 0)
+        {
+            throw std::runtime_error("Empty vertex buffer.");
+        }
+
+        if (mesh.mNumFaces == 0)
+        {
+            throw std::runtime_error("Empty index buffer.");
+        }
+    }
+
+    void ImportMesh(const aiMesh& mesh, const float normalSign, CookedModelFile::Mesh& outputMesh)
+    {
+        // Value-initialized: missing attributes stay zero.
+        outputMesh.Vertices.resize(mesh.mNumVertices);
+
+        for (unsigned int vertexIndex = 0; vertexIndex < mesh.mNumVertices; ++vertexIndex)
+        {
+            auto& vertex = outputMesh.Vertices[vertexIndex];
+
+            if (mesh.HasPositions())
+            {
+                SetPosition(vertex.Position, mesh.mVertices[vertexIndex]);
+            }
+
+            if (mesh.HasNormals())
+            {
+                SetVector(vertex.Normal, mesh.mNormals[vertexIndex] * normalSign);
+            }
+
+            constexpr unsigned int uvIndex = 0;
+            if (mesh.HasTextureCoords(uvIndex))
+            {
+                SetVector(vertex.Uv, mesh.mTextureCoords[uvIndex][vertexIndex]);
+            }
+
+            if (mesh.HasTangentsAndBitangents())
+            {
+                SetVector(vertex.Tangent, mesh.mTangents[vertexIndex]);
+                SetVector(vertex.Bitangent, mesh.mBitangents[vertexIndex]);
+            }
+        }
+
+        constexpr unsigned int indicesInTriangle = 3;
+        outputMesh.Indices.reserve(mesh.mNumFaces * indicesInTriangle);
+
+        for (unsigned int faceIndex = 0; faceIndex < mesh.mNumFaces; ++faceIndex)
+        {
+            const auto& face = mesh.mFaces[faceIndex];
+            assert(face.mNumIndices == indicesInTriangle);
+
+            outputMesh.Indices.push_back(static_cast<CookedModelFile::Index>(face.mIndices[0]));
+            outputMesh.Indices.push_back(static_cast<CookedModelFile::Index>(face.mIndices[1]));
+            outputMesh.Indices.push_back(static_cast<CookedModelFile::Index>(face.mIndices[2]));
+        }
+
+        if (mesh.HasBones())
+        {
+            ImportBones(mesh, outputMesh);
+        }
+
+        CalculateAabb(outputMesh);
+    }
+
+    void ImportKeys(const unsigned int numKeys, const aiVectorKey* keys, std::vector<CookedAnimationFile::Vector3Key>& result)
+    {
+        result.resize(numKeys);
+
+        for (unsigned int keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+        {
+            const auto& value = keys[keyIndex].mValue;
+            result[keyIndex] = { static_cast<float>(keys[keyIndex].mTime), { value.x, value.y, value.z } };
+        }
+    }
+
+    void ImportKeys(const unsigned int numKeys, const aiQuatKey* keys, std::vector<CookedAnimationFile::QuaternionKey>& result)
+    {
+        result.resize(numKeys);
+
+        for (unsigned int keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+        {
+            const auto& value = keys[keyIndex].mValue;
+            result[keyIndex] = { static_cast<float>(keys[keyIndex].mTime), { value.x, value.y, value.z, value.w } };
+        }
+    }
+}
+
+CookedModelFile ModelCooker::Import(const std::string& path, const bool flipNormals, ThreadPool* threadPool)
+{
+    Assimp::Importer importer;
+
+    const aiScene* scene = importer.ReadFile(path.c_str(), AI_FLAGS);
+
+    if (scene == nullptr)
+    {
+        throw std::runtime_error(importer.GetErrorString());
+    }
+
+    // Validated up front so that the same mesh is reported regardless of the order the meshes are converted in.
+    for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
+    {
+        ValidateMesh(*scene->mMeshes[meshIndex]);
+    }
+
+    CookedModelFile result;
+    result.m_Flags = flipNormals ? CookedModelFile::FLAG_FLIP_NORMALS : 0;
+    result.m_Meshes.resize(scene->mNumMeshes);
+
+    const float normalSign = flipNormals ? -1.0f : 1.0f;
+
+    // Each mesh is written into its own preallocated slot, so the output order matches the scene.
+    const auto importMesh = [scene, normalSign, &result](const size_t meshIndex)
+    {
+        ImportMesh(*scene->mMeshes[meshIndex], normalSign, result.m_Meshes[meshIndex]);
+    };
+
+    if (threadPool != nullptr && scene->mNumMeshes > 1)
+    {
+        threadPool->ParallelFor(scene->mNumMeshes, importMesh);
+    }
+    else
+    {
+        for (size_t meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
+        {
+            importMesh(meshIndex);
+        }
+    }
+
+    return result;
+}
+
+CookedAnimationFile ModelCooker::ImportAnimations(const std::string& path)
+{
+    Assimp::Importer importer;
+
+    // Only the handedness affects the keys: the mesh post-processing steps would be wasted.
+    const aiScene* scene = importer.ReadFile(path.c_str(), aiProcess_ConvertToLeftHanded);
+
+    if (scene == nullptr)
+    {
+        throw std::runtime_error(importer.GetErrorString());
+    }
+
+    CookedAnimationFile result;
+    result.m_Clips.resize(scene->mNumAnimations);
+
+    std::unordered_map<std::string, uint32_t> nodeIndicesByNames;
+
+    for (unsigned int animationIndex = 0; animationIndex < scene->mNumAnimations; ++animationIndex)
+    {
+        const auto& animation = *scene->mAnimations[animationIndex];
+        auto& clip = result.m_Clips[animationIndex];
+
+        clip.Name = animation.mName.C_Str();
+        clip.Duration = static_cast<float>(animation.mDuration);
+        clip.TicksPerSecond = static_cast<float>(animation.mTicksPerSecond);
+        clip.Channels.resize(animation.mNumChannels);
+
+        for (unsigned int channelIndex = 0; channelIndex < animation.mNumChannels; ++channelIndex)
+        {
+            const auto& channel = *animation.mChannels[channelIndex];
+            auto& outputChannel = clip.Channels[channelIndex];
+
+            const auto [it, inserted] = nodeIndicesByNames.try_emplace(channel.mNodeName.C_Str(), static_cast<uint32_t>(result.m_NodeNames.size()));
+            if (inserted)
+            {
+                result.m_NodeNames.push_back(it->first);
+            }
+
+            outputChannel.NodeIndex = it->second;
+            ImportKeys(channel.mNumPositionKeys, channel.mPositionKeys, outputChannel.PositionKeys);
+            ImportKeys(channel.mNumRotationKeys, channel.mRotationKeys, outputChannel.RotationKeys);
+            ImportKeys(channel.mNumScalingKeys, channel.mScalingKeys, outputChannel.ScalingKeys);
+        }
+    }
+
+    return result;
+}
+
+std::vector<MeshOptimization::Result> ModelCooker::Optimize(CookedModelFile& model, const MeshOptimization::Settings& settings, ThreadPool* threadPool)
+{
+    const uint32_t vertexSize = model.m_VertexLayout.GetStride();
+    std::vector<MeshOptimization::Result> results(model.m_Meshes.size());
+
+    const auto optimizeMesh = [&model, &settings, vertexSize, &results](const size_t meshIndex)
+    {
+        auto& mesh = model.m_Meshes[meshIndex];
+        const float* positions = mesh.Vertices.empty() ? nullptr : mesh.Vertices[0].Position;
+
+        auto& result = results[meshIndex];
+        result = MeshOptimization::Optimize(mesh.Indices, positions, mesh.Vertices.size(), sizeof(CookedModelFile::Vertex), vertexSize, settings);
+
+        MeshOptimization::RemapVertices(mesh.Vertices, result);
+        MeshOptimization::RemapVertices(mesh.SkinningVertices, result);
+        mesh.Lods = result.Lods;
+    };
+
+    if (threadPool != nullptr && model.m_Meshes.size() > 1)
+    {
+        threadPool->ParallelFor(model.m_Meshes.size(), optimizeMesh);
+    }
+    else
+    {
+        for (size_t meshIndex = 0; meshIndex < model.m_Meshes.size(); ++meshIndex)
+        {
+            optimizeMesh(meshIndex);
+        }
+    }
+
+    model.m_Flags |= CookedModelFile::FLAG_OPTIMIZED;
+    return results;
+}
+
+MeshOptimization::Settings ModelCooker::GetDefaultOptimizationSettings()
+{
+    MeshOptimization::Settings settings;
+    settings.MaxLods = DEFAULT_LOD_COUNT;
+    // LODs are picked by their projected error, so the coarse ones may deviate more than the default.
+    settings.LodTargetError = 5e-2f;
+    return settings;
+}
+
+std::filesystem::path ModelCooker::GetCookedPath(const std::filesystem::path& sourcePath)
+{
+    auto path = sourcePath;
+    path += ".cooked";
+    return path;
+}
+
+std::filesystem::path ModelCooker::GetCookedAnimationsPath(const std::filesystem::path& sourcePath)
+{
+    auto path = sourcePath;
+    path += ".animations";
+    return path;
+}
+
+bool ModelCooker::IsUpToDate(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath)
+{
+    std::error_code errorCode;
+
+    const auto cookedTime = std::filesystem::last_write_time(cookedPath, errorCode);
+    if (errorCode)
+    {
+        return false;
+    }
+
+    const auto sourceTime = std::filesystem::last_write_time(sourcePath, errorCode);
+    if (errorCode)
+    {
+        return true;
+    }
+
+    return cookedTime >= sourceTime;
+}
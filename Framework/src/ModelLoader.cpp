@@ -4,227 +4,124 @@
 #include <Framework/ModelLoader.h>
 #include <Framework/Mesh.h>
 #include <DX12Library/Helpers.h>
+#include <DX12Library/TextureStreamer.h>
+#include <DX12Library/ThreadPool.h>
 
 #include <Framework/Model.h>
 #include <Framework/Bone.h>
 #include <Framework/Animation.h>
-
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>           // Output data structure
-#include <assimp/postprocess.h>     // Post processing flags
+#include <Framework/AnimationLibrary.h>
+#include <Framework/CookedAnimationFile.h>
+#include <Framework/CookedModelFile.h>
+#include <Framework/ModelCooker.h>
 
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <type_traits>
 
 using namespace DirectX;
 namespace fs = std::filesystem;
 
 namespace
 {
-    XMFLOAT3 ToXMFloat3(aiVector3D vector)
-    {
-        return { vector.x, vector.y, vector.z };
-    }
-
-    XMFLOAT4 ToXMFloat4Position(aiVector3D vector)
-    {
-        return { vector.x, vector.y, vector.z, 1.0f };
-    }
-
-    XMFLOAT4 ToXMFloat4Vector(aiVector3D vector)
-    {
-        return { vector.x, vector.y, vector.z, 0.0f };
-    }
-
-    XMFLOAT2 ToXMFloat2(aiVector3D vector)
-    {
-        return { vector.x, vector.y };
-    }
-
-    XMMATRIX ToXMATRIX(aiMatrix4x4 matrix)
-    {
-        // transpose to convert to the left-handed orientation
-        return XMMATRIX(
-            matrix.a1, matrix.b1, matrix.c1, matrix.d1,
-            matrix.a2, matrix.b2, matrix.c2, matrix.d2,
-            matrix.a3, matrix.b3, matrix.c3, matrix.d3,
-            matrix.a4, matrix.b4, matrix.c4, matrix.d4
-        );
-    }
+    // The cooked streams are uploaded (or decoded) as is, so their layouts have to match the runtime ones.
+    static_assert(sizeof(CookedModelFile::Vertex) == VertexLayout::SOURCE_STRIDE);
+    static_assert(sizeof(SkinningVertexAttributes) == sizeof(CookedModelFile::SkinningVertex));
+    static_assert(SkinningVertexAttributes::BONES_PER_VERTEX == CookedModelFile::BONES_PER_VERTEX);
+    static_assert(std::is_same_v<IndexCollectionType::value_type, CookedModelFile::Index>);
 
-    XMVECTOR ToXMVECTOR(aiVector3D vector)
+    ThreadPool& GetImportThreadPool()
     {
-        return XMVectorSet(vector.x, vector.y, vector.z, 0.0);
+        // Created on first use, shared by all the loaders.
+        static ThreadPool threadPool;
+        return threadPool;
     }
 
-    XMVECTOR ToXMVECTOR(aiQuaternion quaternion)
+    /**
+     * @param requiredVertexLayout If not set, a cooked model of any layout is accepted, and a model imported in place keeps full precision.
+     */
+    void LoadCookedModel(const std::string& path, const bool flipNormals, const std::optional<VertexLayout>& requiredVertexLayout, CookedModelView& cookedModel)
     {
-        return XMVectorSet(quaternion.x, quaternion.y, quaternion.z, quaternion.w);
-    }
+        const auto cookedPath = ModelCooker::GetCookedPath(path);
+        const uint32_t expectedFlags = flipNormals ? CookedModelFile::FLAG_FLIP_NORMALS : 0;
+
+        // Models cooked without optimization are still valid.
+        if (ModelCooker::IsUpToDate(path, cookedPath) &&
+            cookedModel.Open(cookedPath) &&
+            (cookedModel.GetFlags() & CookedModelFile::FLAG_FLIP_NORMALS) == expectedFlags &&
+            (!requiredVertexLayout.has_value() || cookedModel.GetVertexLayout() == *requiredVertexLayout))
+        {
+            return;
+        }
 
-    constexpr auto AI_FLAGS = aiProcess_ConvertToLeftHanded;
+        // Not cooked (or stale): import and optimize in place, as the cooker does. The result goes through the same representation as a cooked file.
+        CookedModelFile model;
+        try
+        {
+            model = ModelCooker::Import(path, flipNormals, &GetImportThreadPool());
+            model.m_VertexLayout = requiredVertexLayout.value_or(VertexLayout::Full());
+            ModelCooker::Optimize(model, ModelCooker::GetDefaultOptimizationSettings(), &GetImportThreadPool());
+        }
+        catch (const std::runtime_error& exception)
+        {
+            throw std::exception(exception.what());
+        }
 
-    template <typename TKey>
-    void BuildKeyFrames(unsigned int numKeys, const TKey* keys, std::vector<Animation::KeyFrame>& result)
-    {
-        for (unsigned int keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+        if (!cookedModel.Load(model.Serialize()))
         {
-            Animation::KeyFrame keyFrame;
-            auto key = keys[keyIndex];
-            keyFrame.Value = ToXMVECTOR(key.mValue);
-            keyFrame.NormalizedTime = static_cast<float>(key.mTime);
-            result.push_back(keyFrame);
+            throw std::exception("Failed to load the imported model.");
         }
     }
 }
 
 std::vector<MeshPrototype> ModelLoader::LoadAsMeshPrototypes(const std::string& path, const bool flipNormals) const
 {
-    Assimp::Importer importer;
-
-    constexpr auto flags = AI_FLAGS |
-    aiProcess_CalcTangentSpace |
-    aiProcess_Triangulate |
-    aiProcess_JoinIdenticalVertices |
-    aiProcess_SortByPType |
-    aiProcess_GenSmoothNormals |
-    aiProcess_PopulateArmatureData |
-    aiProcess_LimitBoneWeights;
-
-    const aiScene* scene = importer.ReadFile(path.c_str(), flags);
-
-    if (scene == nullptr)
-    {
-        const std::string errorString = importer.GetErrorString();
-        throw std::exception(errorString.c_str());
-    }
+    CookedModelView cookedModel;
+    LoadCookedModel(path, flipNormals, std::nullopt, cookedModel);
 
     std::vector<MeshPrototype> outputMeshes;
+    outputMeshes.reserve(cookedModel.GetMeshCount());
 
-    for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
+    for (uint32_t meshIndex = 0; meshIndex < cookedModel.GetMeshCount(); ++meshIndex)
     {
-        const auto mesh = scene->mMeshes[meshIndex];
+        const auto mesh = cookedModel.GetMesh(meshIndex);
 
-        VertexCollectionType outputVertices;
-        outputVertices.reserve(mesh->mNumVertices);
+        VertexCollectionType outputVertices(mesh.NumVertices);
+        cookedModel.GetVertexLayout().Decode(mesh.Vertices, mesh.NumVertices, outputVertices.data());
 
-        for (unsigned int vertexIndex = 0; vertexIndex < mesh->mNumVertices; ++vertexIndex)
+        // The indices of all the LODs, split below.
+        IndexCollectionType outputIndices(mesh.NumIndices);
+        if (mesh.IndexStride == sizeof(uint16_t))
         {
-            VertexAttributes vertexAttributes;
-
-            if (mesh->HasPositions())
-            {
-                vertexAttributes.Position = ToXMFloat4Position(mesh->mVertices[vertexIndex]);
-            }
-
-            if (mesh->HasNormals())
-            {
-                vertexAttributes.Normal = ToXMFloat4Vector(mesh->mNormals[vertexIndex] * (flipNormals ? -1.0f : 1.0f));
-            }
-
-            constexpr unsigned int uvIndex = 0;
-            if (mesh->HasTextureCoords(uvIndex))
-            {
-                vertexAttributes.Uv = ToXMFloat4Vector(mesh->mTextureCoords[uvIndex][vertexIndex]);
-            }
-
-            if (mesh->HasTangentsAndBitangents())
-            {
-                vertexAttributes.Tangent = ToXMFloat4Vector(mesh->mTangents[vertexIndex]);
-                vertexAttributes.Bitangent = ToXMFloat4Vector(mesh->mBitangents[vertexIndex]);
-            }
-
-            outputVertices.push_back(vertexAttributes);
+            const auto* indices = static_cast<const uint16_t*>(mesh.Indices);
+            std::copy(indices, indices + mesh.NumIndices, outputIndices.begin());
+        }
+        else
+        {
+            memcpy(outputIndices.data(), mesh.Indices, mesh.NumIndices * sizeof(uint32_t));
         }
 
-        IndexCollectionType outputIndices;
-        constexpr unsigned int indicesInTriangle = 3;
-        outputVertices.reserve(mesh->mNumFaces * indicesInTriangle);
-
-        for (unsigned int faceIndex = 0; faceIndex < mesh->mNumFaces; ++faceIndex)
+        const auto getLodIndices = [&outputIndices](const CookedModelFile::LodRecord& lod)
         {
-            const auto face = mesh->mFaces[faceIndex];
-            assert(face.mNumIndices == indicesInTriangle);
+            const auto first = outputIndices.begin() + lod.IndexOffset;
+            return IndexCollectionType(first, first + lod.NumIndices);
+        };
 
-            outputIndices.push_back(face.mIndices[0]);
-            outputIndices.push_back(face.mIndices[1]);
-            outputIndices.push_back(face.mIndices[2]);
-        }
+        MeshPrototype& meshPrototype = outputMeshes.emplace_back(std::move(outputVertices), getLodIndices(mesh.Lods[0]), true, false);
 
-        MeshPrototype& meshPrototype = outputMeshes.emplace_back(std::move(outputVertices), std::move(outputIndices), true, false);
+        for (uint32_t lodIndex = 1; lodIndex < mesh.NumLods; ++lodIndex)
+        {
+            meshPrototype.m_Lods.push_back({ getLodIndices(mesh.Lods[lodIndex]), mesh.Lods[lodIndex].Error });
+        }
 
-        if (mesh->HasBones())
+        if (mesh.NumSkinningVertices > 0)
         {
-            std::vector<Bone> bones;
-            bones.reserve(mesh->mNumBones);
-
-            SkinningVertexCollectionType outputSkinningVertices;
-            outputSkinningVertices.resize(mesh->mNumVertices);
-
-            for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
-            {
-                auto meshBone = mesh->mBones[boneIndex];
-
-                Bone bone;
-                bone.Offset = ToXMATRIX(meshBone->mOffsetMatrix);
-                bone.Name = meshBone->mName.C_Str();
-                bone.IsDirty = true;
-
-                bones.push_back(bone);
-
-                for (unsigned int weightIndex = 0; weightIndex < meshBone->mNumWeights; ++weightIndex)
-                {
-                    auto& weight = meshBone->mWeights[weightIndex];
-                    auto& vertexAttributes = outputSkinningVertices[weight.mVertexId];
-
-                    // try put the weight into any of the available slots of the vertex
-                    for (uint32_t vertexAttributeId = 0; vertexAttributeId < SkinningVertexAttributes::BONES_PER_VERTEX; vertexAttributeId++)
-                    {
-                        // search for the first 0 weight and fill it
-                        if (vertexAttributes.Weights[vertexAttributeId] == 0.0)
-                        {
-                            vertexAttributes.BoneIds[vertexAttributeId] = boneIndex;
-                            vertexAttributes.Weights[vertexAttributeId] = weight.mWeight;
-                            break;
-                        }
-                    }
-                }
-            }
-
-            for (auto& vertexAttributes : outputSkinningVertices)
-            {
-                vertexAttributes.NormalizeWeights();
-            }
-
-            Armature& armature = meshPrototype.m_Armature;
-            armature.SetBones(bones);
-
-            for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
-            {
-                std::vector<size_t> childrenIndices;
-
-                const auto meshBoneNode = mesh->mBones[boneIndex]->mNode;
-                auto& bone = armature.GetBone(boneIndex);
-                bone.LocalTransform = ToXMATRIX(meshBoneNode->mTransformation);
-
-                for (unsigned int childIndex = 0; childIndex < meshBoneNode->mNumChildren; ++childIndex)
-                {
-                    const auto child = meshBoneNode->mChildren[childIndex];
-                    auto childName = std::string(child->mName.C_Str());
-                    if (!armature.HasBone(childName))
-                    {
-                        continue;
-                    }
-
-                    size_t armatureBoneIndex = armature.GetBoneIndex(childName);
-                    childrenIndices.push_back(armatureBoneIndex);
-                }
-
-                armature.SetBoneChildren(boneIndex, childrenIndices);
-            }
-
-            meshPrototype.m_SkinningVertexAttributes = std::move(outputSkinningVertices);
+            meshPrototype.m_SkinningVertexAttributes.resize(mesh.NumSkinningVertices);
+            memcpy(meshPrototype.m_SkinningVertexAttributes.data(), mesh.SkinningVertices, mesh.NumSkinningVertices * sizeof(SkinningVertexAttributes));
         }
+
+        meshPrototype.m_Armature = Mesh::CreateArmature(cookedModel, mesh);
     }
 
     return outputMeshes;
@@ -232,8 +129,18 @@ std::vector<MeshPrototype> ModelLoader::LoadAsMeshPrototypes(const std::string&
 
 std::shared_ptr<Model> ModelLoader::Load(CommandList& commandList, const std::string& path, bool flipNormals) const
 {
-    const auto meshPrototypes = LoadAsMeshPrototypes(path, flipNormals);
-    return Load(commandList, meshPrototypes);
+    CookedModelView cookedModel;
+    LoadCookedModel(path, flipNormals, VertexAttributes::LAYOUT, cookedModel);
+
+    std::vector<std::shared_ptr<Mesh>> outputMeshes;
+    outputMeshes.reserve(cookedModel.GetMeshCount());
+
+    for (uint32_t meshIndex = 0; meshIndex < cookedModel.GetMeshCount(); ++meshIndex)
+    {
+        outputMeshes.push_back(Mesh::CreateMesh(commandList, cookedModel, cookedModel.GetMesh(meshIndex)));
+    }
+
+    return std::make_shared<Model>(outputMeshes);
 }
 
 std::shared_ptr<Model> ModelLoader::Load(CommandList& commandList, const std::vector<MeshPrototype>& meshPrototypes) const
@@ -259,56 +166,35 @@ std::shared_ptr<Model> ModelLoader::LoadExisting(std::shared_ptr<Mesh> mesh) con
 
 std::shared_ptr<Animation> ModelLoader::LoadAnimation(const std::string& path, const std::string& animationName) const
 {
-    Assimp::Importer importer;
-
-    auto flags = AI_FLAGS;
-
-    const aiScene* scene = importer.ReadFile(path.c_str(), flags);
-
-    if (scene == nullptr)
+    CookedAnimationFile file;
+    try
     {
-        std::string errorString = importer.GetErrorString();
-        throw std::exception(errorString.c_str());
+        file = AnimationLibrary::LoadCookedAnimations(path);
     }
-
-    if (!scene->HasAnimations())
+    catch (const std::runtime_error& exception)
     {
-        throw std::exception("Specified file does not contain animations");
+        throw std::exception(exception.what());
     }
 
-    for (unsigned int i = 0; i < scene->mNumAnimations; ++i)
+    for (size_t clipIndex = 0; clipIndex < file.m_Clips.size(); ++clipIndex)
     {
-        auto animation = scene->mAnimations[i];
-        if (strcmp(animation->mName.C_Str(), animationName.c_str()) != 0) continue;
-
-        auto duration = static_cast<float>(animation->mDuration);
-        auto ticksPerSecond = static_cast<float>(animation->mTicksPerSecond);
-
-        std::vector<Animation::Channel> resultingChannels;
-
-        for (unsigned int channelIndex = 0; channelIndex < animation->mNumChannels; ++channelIndex)
+        if (file.m_Clips[clipIndex].Name == animationName)
         {
-            auto channel = animation->mChannels[channelIndex];
-
-            Animation::Channel resultingChannel;
-            resultingChannel.NodeName = channel->mNodeName.C_Str();
-
-            BuildKeyFrames(channel->mNumPositionKeys, channel->mPositionKeys, resultingChannel.PositionKeyFrames);
-            BuildKeyFrames(channel->mNumRotationKeys, channel->mRotationKeys, resultingChannel.RotationKeyFrames);
-            BuildKeyFrames(channel->mNumScalingKeys, channel->mScalingKeys, resultingChannel.ScalingKeyFrames);
-
-            resultingChannels.push_back(resultingChannel);
+            return AnimationLibrary::CreateAnimation(file, clipIndex);
         }
-
-        auto resultingAnimation = std::make_shared<Animation>(duration, ticksPerSecond, resultingChannels);
-        return resultingAnimation;
     }
 
     throw std::exception("The requested animation was not found.");
 }
 
-std::shared_ptr<Texture> ModelLoader::LoadTexture(CommandList& commandList, const std::wstring& path, TextureUsageType usage /*= TextureUsageType::Albedo*/) const
+std::shared_ptr<Texture> ModelLoader::LoadTexture(CommandList& commandList, const std::wstring& path, TextureUsageType usage /*= TextureUsageType::Albedo*/,
+    const bool streamMips /*= false*/) const
 {
+    if (TextureStreamer::IsCreated())
+    {
+        return TextureStreamer::Get().LoadTexture(path, usage, streamMips);
+    }
+
     auto texture = std::make_shared<Texture>();
     commandList.LoadTextureFromFile(*texture, path, usage);
     return texture;
@@ -2,13 +2,110 @@
 #include <DX12Library/Helpers.h>
 #include <Framework/Mesh.h>
 
+#include "PipelineStateCache.h"
+#include "PipelineStateKey.h"
+
 static constexpr UINT MAX_RENDER_TARGETS = _countof(D3D12_RT_FORMAT_ARRAY::RTFormats);
 
+namespace
+{
+    PipelineStateKey::ShaderBytecode ToKeyBytecode(const Microsoft::WRL::ComPtr<ID3DBlob>& shader)
+    {
+        return { shader->GetBufferPointer(), shader->GetBufferSize() };
+    }
+
+    PipelineStateKey::Blend ToKeyBlend(const D3D12_BLEND_DESC& blendDesc)
+    {
+        PipelineStateKey::Blend blend;
+        blend.AlphaToCoverageEnable = blendDesc.AlphaToCoverageEnable;
+        blend.IndependentBlendEnable = blendDesc.IndependentBlendEnable;
+
+        for (UINT i = 0; i < MAX_RENDER_TARGETS; ++i)
+        {
+            const auto& renderTargetDesc = blendDesc.RenderTarget[i];
+            auto& renderTarget = blend.RenderTargets[i];
+            renderTarget.BlendEnable = renderTargetDesc.BlendEnable;
+            renderTarget.LogicOpEnable = renderTargetDesc.LogicOpEnable;
+            renderTarget.SrcBlend = renderTargetDesc.SrcBlend;
+            renderTarget.DestBlend = renderTargetDesc.DestBlend;
+            renderTarget.BlendOp = renderTargetDesc.BlendOp;
+            renderTarget.SrcBlendAlpha = renderTargetDesc.SrcBlendAlpha;
+            renderTarget.DestBlendAlpha = renderTargetDesc.DestBlendAlpha;
+            renderTarget.BlendOpAlpha = renderTargetDesc.BlendOpAlpha;
+            renderTarget.LogicOp = renderTargetDesc.LogicOp;
+            renderTarget.RenderTargetWriteMask = renderTargetDesc.RenderTargetWriteMask;
+        }
+
+        return blend;
+    }
+
+    PipelineStateKey::DepthStencilOp ToKeyDepthStencilOp(const D3D12_DEPTH_STENCILOP_DESC& opDesc)
+    {
+        PipelineStateKey::DepthStencilOp op;
+        op.StencilFailOp = opDesc.StencilFailOp;
+        op.StencilDepthFailOp = opDesc.StencilDepthFailOp;
+        op.StencilPassOp = opDesc.StencilPassOp;
+        op.StencilFunc = opDesc.StencilFunc;
+        return op;
+    }
+
+    PipelineStateKey::DepthStencil ToKeyDepthStencil(const D3D12_DEPTH_STENCIL_DESC& depthStencilDesc)
+    {
+        PipelineStateKey::DepthStencil depthStencil;
+        depthStencil.DepthEnable = depthStencilDesc.DepthEnable;
+        depthStencil.DepthWriteMask = depthStencilDesc.DepthWriteMask;
+        depthStencil.DepthFunc = depthStencilDesc.DepthFunc;
+        depthStencil.StencilEnable = depthStencilDesc.StencilEnable;
+        depthStencil.StencilReadMask = depthStencilDesc.StencilReadMask;
+        depthStencil.StencilWriteMask = depthStencilDesc.StencilWriteMask;
+        depthStencil.FrontFace = ToKeyDepthStencilOp(depthStencilDesc.FrontFace);
+        depthStencil.BackFace = ToKeyDepthStencilOp(depthStencilDesc.BackFace);
+        return depthStencil;
+    }
+
+    PipelineStateKey::Rasterizer ToKeyRasterizer(const D3D12_RASTERIZER_DESC& rasterizerDesc)
+    {
+        PipelineStateKey::Rasterizer rasterizer;
+        rasterizer.FillMode = rasterizerDesc.FillMode;
+        rasterizer.CullMode = rasterizerDesc.CullMode;
+        rasterizer.FrontCounterClockwise = rasterizerDesc.FrontCounterClockwise;
+        rasterizer.DepthBias = rasterizerDesc.DepthBias;
+        rasterizer.DepthBiasClamp = rasterizerDesc.DepthBiasClamp;
+        rasterizer.SlopeScaledDepthBias = rasterizerDesc.SlopeScaledDepthBias;
+        rasterizer.DepthClipEnable = rasterizerDesc.DepthClipEnable;
+        rasterizer.MultisampleEnable = rasterizerDesc.MultisampleEnable;
+        rasterizer.AntialiasedLineEnable = rasterizerDesc.AntialiasedLineEnable;
+        rasterizer.ForcedSampleCount = rasterizerDesc.ForcedSampleCount;
+        rasterizer.ConservativeRaster = rasterizerDesc.ConservativeRaster;
+        return rasterizer;
+    }
+
+    std::vector<PipelineStateKey::InputElement> ToKeyInputLayout(const std::vector<D3D12_INPUT_ELEMENT_DESC>& inputLayout)
+    {
+        std::vector<PipelineStateKey::InputElement> elements(inputLayout.size());
+
+        for (size_t i = 0; i < inputLayout.size(); ++i)
+        {
+            const auto& elementDesc = inputLayout[i];
+            auto& element = elements[i];
+            element.SemanticName = elementDesc.SemanticName;
+            element.SemanticIndex = elementDesc.SemanticIndex;
+            element.Format = elementDesc.Format;
+            element.InputSlot = elementDesc.InputSlot;
+            element.AlignedByteOffset = elementDesc.AlignedByteOffset;
+            element.InputSlotClass = elementDesc.InputSlotClass;
+            element.InstanceDataStepRate = elementDesc.InstanceDataStepRate;
+        }
+
+        return elements;
+    }
+}
+
 PipelineStateBuilder::PipelineStateBuilder(const std::shared_ptr<RootSignature> rootSignature)
     : m_RootSignature(rootSignature)
     , m_InputLayout(VertexAttributes::INPUT_ELEMENT_COUNT)
 {
-    memcpy(m_InputLayout.data(), VertexAttributes::INPUT_ELEMENTS, sizeof(VertexAttributes::INPUT_ELEMENTS));
+    std::copy_n(VertexAttributes::INPUT_ELEMENTS.begin(), VertexAttributes::INPUT_ELEMENT_COUNT, m_InputLayout.begin());
 }
 
 Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateBuilder::Build(Microsoft::WRL::ComPtr<ID3D12Device2> device) const
@@ -58,11 +155,52 @@ Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateBuilder::Build(Microsof
         sizeof(PipelineStateStream), &pipelineStateStream
     };
 
+    if (PipelineStateCache::IsCreated())
+    {
+        return PipelineStateCache::Get().LoadOrCreate(device, ComputeKey(), pipelineStateStreamDesc);
+    }
+
     Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
     ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pipelineState)));
     return pipelineState;
 }
 
+PipelineStateKey PipelineStateBuilder::CreateKey() const
+{
+    Assert(m_VertexShader != nullptr, "Vertex Shader cannot be null.");
+    Assert(m_PixelShader != nullptr, "Pixel Shader cannot be null.");
+
+    PipelineStateKey key;
+    key.RootSignatureHash = m_RootSignature->GetHash();
+    key.VertexShader = ToKeyBytecode(m_VertexShader);
+    key.PixelShader = ToKeyBytecode(m_PixelShader);
+    key.InputLayout = ToKeyInputLayout(m_InputLayout);
+    key.BlendState = ToKeyBlend(m_BlendDesc);
+    key.DepthStencilState = ToKeyDepthStencil(m_DepthStencilDesc);
+    key.RasterizerState = ToKeyRasterizer(m_RasterizerDesc);
+
+    auto& renderTargetState = key.RenderTargetState;
+    renderTargetState.NumRenderTargets = static_cast<uint32_t>(m_RenderTargetFormats.size());
+    for (size_t i = 0; i < m_RenderTargetFormats.size(); ++i)
+    {
+        renderTargetState.RenderTargetFormats[i] = static_cast<uint32_t>(m_RenderTargetFormats[i]);
+    }
+    renderTargetState.DepthStencilFormat = static_cast<uint32_t>(m_DepthStencilFormat);
+    renderTargetState.SampleCount = m_SampleDesc.Count;
+    renderTargetState.SampleQuality = m_SampleDesc.Quality;
+    return key;
+}
+
+uint64_t PipelineStateBuilder::ComputeStateHash() const
+{
+    return CreateKey().ComputeStateHash();
+}
+
+uint64_t PipelineStateBuilder::ComputeKey() const
+{
+    return CreateKey().ComputeKey();
+}
+
 PipelineStateBuilder& PipelineStateBuilder::WithRenderTargetFormats(const std::vector<DXGI_FORMAT>& renderTargetFormats, DXGI_FORMAT depthStencilFormat)
 {
     Assert(renderTargetFormats.size() < MAX_RENDER_TARGETS, "Too many render target formats.");
@@ -0,0 +1,214 @@
+#include "PipelineStateCache.h"
+
+#include <DX12Library/Application.h>
+#include <DX12Library/HashUtils.h>
+#include <DX12Library/Helpers.h>
+
+#include <algorithm>
+
+namespace
+{
+    PipelineStateCache* g_PipelineStateCache = nullptr;
+}
+
+void PipelineStateCache::Create(const std::filesystem::path& path)
+{
+    Assert(g_PipelineStateCache == nullptr, "Pipeline state cache is already created.");
+    g_PipelineStateCache = new PipelineStateCache(path);
+}
+
+void PipelineStateCache::Destroy()
+{
+    delete g_PipelineStateCache;
+    g_PipelineStateCache = nullptr;
+}
+
+bool PipelineStateCache::IsCreated()
+{
+    return g_PipelineStateCache != nullptr;
+}
+
+PipelineStateCache& PipelineStateCache::Get()
+{
+    Assert(g_PipelineStateCache != nullptr, "Pipeline state cache is not created.");
+    return *g_PipelineStateCache;
+}
+
+PipelineStateCache::PipelineStateCache(const std::filesystem::path& path)
+    : m_Path(path)
+{
+    if (!m_File.Read(m_Path))
+    {
+        // Missing, corrupted, or written by an older version.
+        m_File = {};
+    }
+
+    CreatePipelineLibrary();
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    try
+    {
+        Save();
+    }
+    catch (const std::exception&)
+    {
+        // Failing to write the cache only costs a slower startup next time.
+    }
+}
+
+void PipelineStateCache::CreatePipelineLibrary()
+{
+    Microsoft::WRL::ComPtr<ID3D12Device1> device1;
+    if (FAILED(Application::Get().GetDevice().As(&device1)))
+    {
+        return;
+    }
+
+    const auto& blob = m_File.m_PipelineLibraryBlob;
+    HRESULT result = device1->CreatePipelineLibrary(blob.data(), blob.size(), IID_PPV_ARGS(&m_PipelineLibrary));
+
+    // The blob is rejected if the driver or the adapter has changed: start with an empty library.
+    if (FAILED(result) && !blob.empty())
+    {
+        m_File.m_PipelineLibraryBlob.clear();
+        m_IsDirty = true;
+        result = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_PipelineLibrary));
+    }
+
+    if (FAILED(result))
+    {
+        // Pipeline libraries are not supported (e.g., under graphics tools): pipelines are simply not cached.
+        m_PipelineLibrary = nullptr;
+    }
+}
+
+void PipelineStateCache::Save()
+{
+    std::lock_guard lock(m_Mutex);
+
+    if (!m_IsDirty)
+    {
+        return;
+    }
+
+    PipelineStateCacheFile file;
+    file.m_KnownRenderTargetStates = m_File.m_KnownRenderTargetStates;
+
+    if (m_PipelineLibrary != nullptr)
+    {
+        file.m_PipelineLibraryBlob.resize(m_PipelineLibrary->GetSerializedSize());
+        ThrowIfFailed(m_PipelineLibrary->Serialize(file.m_PipelineLibraryBlob.data(), file.m_PipelineLibraryBlob.size()));
+    }
+
+    file.Write(m_Path);
+    m_IsDirty = false;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineStateCache::LoadOrCreate(
+    const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+    const uint64_t key,
+    const D3D12_PIPELINE_STATE_STREAM_DESC& pipelineStateStreamDesc
+)
+{
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+    if (m_PipelineLibrary == nullptr)
+    {
+        ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pipelineState)));
+        return pipelineState;
+    }
+
+    const auto name = HashUtils::ToWString(key);
+
+    {
+        std::lock_guard lock(m_Mutex);
+
+        // Fails with E_INVALIDARG if the pipeline is not in the library (or the description does not match).
+        if (SUCCEEDED(m_PipelineLibrary->LoadPipeline(name.c_str(), &pipelineStateStreamDesc, IID_PPV_ARGS(&pipelineState))))
+        {
+            return pipelineState;
+        }
+    }
+
+    // Compile outside of the lock so that other threads can load their pipelines in the meantime.
+    ThrowIfFailed(device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&pipelineState)));
+
+    {
+        std::lock_guard lock(m_Mutex);
+
+        // Fails if another thread has already stored the same pipeline.
+        if (SUCCEEDED(m_PipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get())))
+        {
+            m_IsDirty = true;
+        }
+    }
+
+    return pipelineState;
+}
+
+void PipelineStateCache::RegisterRenderTargetState(const uint64_t stateHash, const RenderTargetState& renderTargetState)
+{
+    const auto record = ToRecord(renderTargetState);
+
+    std::lock_guard lock(m_Mutex);
+
+    auto& records = m_File.m_KnownRenderTargetStates[stateHash];
+    if (std::find(records.begin(), records.end(), record) == records.end())
+    {
+        records.push_back(record);
+        m_IsDirty = true;
+    }
+}
+
+std::vector<RenderTargetState> PipelineStateCache::GetKnownRenderTargetStates(const uint64_t stateHash) const
+{
+    std::vector<RenderTargetState> result;
+
+    std::lock_guard lock(m_Mutex);
+
+    const auto findResult = m_File.m_KnownRenderTargetStates.find(stateHash);
+    if (findResult != m_File.m_KnownRenderTargetStates.end())
+    {
+        result.reserve(findResult->second.size());
+        for (const auto& record : findResult->second)
+        {
+            result.push_back(FromRecord(record));
+        }
+    }
+
+    return result;
+}
+
+PipelineStateCacheFile::RenderTargetStateRecord PipelineStateCache::ToRecord(const RenderTargetState& renderTargetState)
+{
+    static_assert(PipelineStateCacheFile::MAX_RENDER_TARGETS == RenderTargetFormats::MAX_RENDER_TARGETS);
+
+    const auto& formats = renderTargetState.GetFormats();
+
+    PipelineStateCacheFile::RenderTargetStateRecord record;
+    record.NumRenderTargets = formats.GetCount();
+    for (UINT i = 0; i < RenderTargetFormats::MAX_RENDER_TARGETS; ++i)
+    {
+        record.RenderTargetFormats[i] = static_cast<uint32_t>(formats.GetFormats()[i]);
+    }
+    record.DepthStencilFormat = static_cast<uint32_t>(formats.GetDepthStencilFormat());
+    record.SampleCount = renderTargetState.GetSampleDesc().Count;
+    record.SampleQuality = renderTargetState.GetSampleDesc().Quality;
+    return record;
+}
+
+RenderTargetState PipelineStateCache::FromRecord(const PipelineStateCacheFile::RenderTargetStateRecord& record)
+{
+    RenderTargetFormats::FormatsArray formats;
+    for (UINT i = 0; i < RenderTargetFormats::MAX_RENDER_TARGETS; ++i)
+    {
+        formats[i] = static_cast<DXGI_FORMAT>(record.RenderTargetFormats[i]);
+    }
+
+    const DXGI_SAMPLE_DESC sampleDesc = { record.SampleCount, record.SampleQuality };
+    return RenderTargetState(
+        RenderTargetFormats(formats, record.NumRenderTargets, static_cast<DXGI_FORMAT>(record.DepthStencilFormat)),
+        sampleDesc
+    );
+}
@@ -0,0 +1,164 @@
+#include "PipelineStateCacheFile.h"
+#include "ByteStream.h"
+
+#include <DX12Library/HashUtils.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t PayloadSize;
+        uint64_t PayloadHash;
+    };
+}
+
+uint64_t PipelineStateCacheFile::RenderTargetStateRecord::ComputeHash() const
+{
+    HashUtils::Hasher hasher;
+    hasher.Add(NumRenderTargets);
+    hasher.Add(RenderTargetFormats);
+    hasher.Add(DepthStencilFormat);
+    hasher.Add(SampleCount);
+    hasher.Add(SampleQuality);
+    return hasher.GetValue();
+}
+
+bool PipelineStateCacheFile::RenderTargetStateRecord::operator==(const RenderTargetStateRecord& other) const
+{
+    return NumRenderTargets == other.NumRenderTargets &&
+        memcmp(RenderTargetFormats, other.RenderTargetFormats, sizeof(RenderTargetFormats)) == 0 &&
+        DepthStencilFormat == other.DepthStencilFormat &&
+        SampleCount == other.SampleCount &&
+        SampleQuality == other.SampleQuality;
+}
+
+uint64_t PipelineStateCacheFile::ComputePipelineKey(const uint64_t stateHash, const RenderTargetStateRecord& renderTargetState)
+{
+    return HashUtils::Combine(stateHash, renderTargetState.ComputeHash());
+}
+
+std::vector<uint8_t> PipelineStateCacheFile::Serialize() const
+{
+    std::vector<uint8_t> payload;
+    ByteWriter payloadWriter(payload);
+
+    payloadWriter.Write(static_cast<uint64_t>(m_KnownRenderTargetStates.size()));
+    for (const auto& [stateHash, renderTargetStates] : m_KnownRenderTargetStates)
+    {
+        payloadWriter.Write(stateHash);
+        payloadWriter.Write(static_cast<uint64_t>(renderTargetStates.size()));
+        payloadWriter.WriteBytes(renderTargetStates.data(), renderTargetStates.size() * sizeof(RenderTargetStateRecord));
+    }
+
+    payloadWriter.Write(static_cast<uint64_t>(m_PipelineLibraryBlob.size()));
+    payloadWriter.WriteBytes(m_PipelineLibraryBlob.data(), m_PipelineLibraryBlob.size());
+
+    Header header{};
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.PayloadSize = payload.size();
+    header.PayloadHash = HashUtils::Fnv1a(payload.data(), payload.size());
+
+    std::vector<uint8_t> result;
+    result.reserve(sizeof(Header) + payload.size());
+
+    ByteWriter writer(result);
+    writer.Write(header);
+    writer.WriteBytes(payload.data(), payload.size());
+    return result;
+}
+
+bool PipelineStateCacheFile::Deserialize(const uint8_t* data, const size_t size)
+{
+    m_KnownRenderTargetStates.clear();
+    m_PipelineLibraryBlob.clear();
+
+    ByteReader reader(data, size);
+
+    Header header{};
+    if (!reader.Read(header) ||
+        header.Magic != MAGIC ||
+        header.Version != VERSION ||
+        header.PayloadSize != reader.GetRemainingSize() ||
+        header.PayloadHash != HashUtils::Fnv1a(data + sizeof(Header), reader.GetRemainingSize()))
+    {
+        return false;
+    }
+
+    uint64_t numStateHashes;
+    if (!reader.Read(numStateHashes))
+    {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < numStateHashes; ++i)
+    {
+        uint64_t stateHash, numRenderTargetStates;
+        if (!reader.Read(stateHash) || !reader.Read(numRenderTargetStates) ||
+            numRenderTargetStates > reader.GetRemainingSize() / sizeof(RenderTargetStateRecord))
+        {
+            m_KnownRenderTargetStates.clear();
+            return false;
+        }
+
+        auto& renderTargetStates = m_KnownRenderTargetStates[stateHash];
+        renderTargetStates.resize(numRenderTargetStates);
+        reader.ReadBytes(renderTargetStates.data(), renderTargetStates.size() * sizeof(RenderTargetStateRecord));
+    }
+
+    uint64_t libraryBlobSize;
+    if (!reader.Read(libraryBlobSize) || libraryBlobSize != reader.GetRemainingSize())
+    {
+        m_KnownRenderTargetStates.clear();
+        return false;
+    }
+
+    m_PipelineLibraryBlob.resize(libraryBlobSize);
+    reader.ReadBytes(m_PipelineLibraryBlob.data(), m_PipelineLibraryBlob.size());
+    return true;
+}
+
+bool PipelineStateCacheFile::Read(const std::filesystem::path& path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return false;
+    }
+
+    const auto size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(size);
+    if (!stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size)))
+    {
+        return false;
+    }
+
+    return Deserialize(bytes.data(), bytes.size());
+}
+
+void PipelineStateCacheFile::Write(const std::filesystem::path& path) const
+{
+    const auto bytes = Serialize();
+
+    // Write to a temporary file first so that a crash does not leave a truncated cache behind.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            throw std::runtime_error("Failed to write the pipeline state cache.");
+        }
+    }
+
+    std::filesystem::rename(tempPath, path);
+}
@@ -0,0 +1,74 @@
+#include "PipelineStateCompiler.h"
+
+#include <DX12Library/HashUtils.h>
+#include <DX12Library/Helpers.h>
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace
+{
+    PipelineStateCompiler* g_PipelineStateCompiler = nullptr;
+}
+
+void PipelineStateCompiler::Create(const uint32_t numThreads)
+{
+    Assert(g_PipelineStateCompiler == nullptr, "Pipeline state compiler is already created.");
+    g_PipelineStateCompiler = new PipelineStateCompiler(numThreads);
+}
+
+void PipelineStateCompiler::Destroy()
+{
+    delete g_PipelineStateCompiler;
+    g_PipelineStateCompiler = nullptr;
+}
+
+bool PipelineStateCompiler::IsCreated()
+{
+    return g_PipelineStateCompiler != nullptr;
+}
+
+PipelineStateCompiler& PipelineStateCompiler::Get()
+{
+    Assert(g_PipelineStateCompiler != nullptr, "Pipeline state compiler is not created.");
+    return *g_PipelineStateCompiler;
+}
+
+PipelineStateCompiler::PipelineStateCompiler(const uint32_t numThreads)
+    : m_Queue(numThreads)
+{}
+
+std::shared_ptr<PipelineStateCompiler::Job> PipelineStateCompiler::Compile(const uint64_t key, BuildFunction buildFunction)
+{
+    return m_Queue.Schedule(key, [key, buildFunction = std::move(buildFunction)]()
+        {
+            try
+            {
+                return buildFunction();
+            }
+            catch (const std::exception& exception)
+            {
+                // The successful compilations are only reported through TryPopCompletionReport.
+                char buffer[128];
+                sprintf_s(buffer, "Pipeline state %ls failed to compile: ", HashUtils::ToWString(key).c_str());
+                OutputDebugStringA((buffer + std::string(exception.what()) + "\n").c_str());
+                throw;
+            }
+        });
+}
+
+bool PipelineStateCompiler::TryPopCompletionReport(CompletionReport& report)
+{
+    return m_Queue.TryPopCompletionReport(report);
+}
+
+size_t PipelineStateCompiler::GetNumPendingJobs() const
+{
+    return m_Queue.GetNumPendingJobs();
+}
+
+void PipelineStateCompiler::Wait()
+{
+    m_Queue.Wait();
+}
@@ -0,0 +1,110 @@
+#include "PipelineStateKey.h"
+
+#include <DX12Library/HashUtils.h>
+
+namespace
+{
+    void HashBlend(HashUtils::Hasher& hasher, const PipelineStateKey::Blend& blend)
+    {
+        hasher.Add(blend.AlphaToCoverageEnable);
+        hasher.Add(blend.IndependentBlendEnable);
+
+        for (const auto& renderTarget : blend.RenderTargets)
+        {
+            hasher.Add(renderTarget.BlendEnable);
+            hasher.Add(renderTarget.LogicOpEnable);
+            hasher.Add(renderTarget.SrcBlend);
+            hasher.Add(renderTarget.DestBlend);
+            hasher.Add(renderTarget.BlendOp);
+            hasher.Add(renderTarget.SrcBlendAlpha);
+            hasher.Add(renderTarget.DestBlendAlpha);
+            hasher.Add(renderTarget.BlendOpAlpha);
+            hasher.Add(renderTarget.LogicOp);
+            hasher.Add(renderTarget.RenderTargetWriteMask);
+        }
+    }
+
+    void HashDepthStencilOp(HashUtils::Hasher& hasher, const PipelineStateKey::DepthStencilOp& op)
+    {
+        hasher.Add(op.StencilFailOp);
+        hasher.Add(op.StencilDepthFailOp);
+        hasher.Add(op.StencilPassOp);
+        hasher.Add(op.StencilFunc);
+    }
+
+    void HashDepthStencil(HashUtils::Hasher& hasher, const PipelineStateKey::DepthStencil& depthStencil)
+    {
+        hasher.Add(depthStencil.DepthEnable);
+        hasher.Add(depthStencil.DepthWriteMask);
+        hasher.Add(depthStencil.DepthFunc);
+        hasher.Add(depthStencil.StencilEnable);
+        hasher.Add(depthStencil.StencilReadMask);
+        hasher.Add(depthStencil.StencilWriteMask);
+        HashDepthStencilOp(hasher, depthStencil.FrontFace);
+        HashDepthStencilOp(hasher, depthStencil.BackFace);
+    }
+
+    void HashRasterizer(HashUtils::Hasher& hasher, const PipelineStateKey::Rasterizer& rasterizer)
+    {
+        hasher.Add(rasterizer.FillMode);
+        hasher.Add(rasterizer.CullMode);
+        hasher.Add(rasterizer.FrontCounterClockwise);
+        hasher.Add(rasterizer.DepthBias);
+        hasher.Add(rasterizer.DepthBiasClamp);
+        hasher.Add(rasterizer.SlopeScaledDepthBias);
+        hasher.Add(rasterizer.DepthClipEnable);
+        hasher.Add(rasterizer.MultisampleEnable);
+        hasher.Add(rasterizer.AntialiasedLineEnable);
+        hasher.Add(rasterizer.ForcedSampleCount);
+        hasher.Add(rasterizer.ConservativeRaster);
+    }
+
+    void HashInputLayout(HashUtils::Hasher& hasher, const std::vector<PipelineStateKey::InputElement>& inputLayout)
+    {
+        hasher.Add(inputLayout.size());
+
+        for (const auto& element : inputLayout)
+        {
+            hasher.AddString(element.SemanticName);
+            hasher.Add(element.SemanticIndex);
+            hasher.Add(element.Format);
+            hasher.Add(element.InputSlot);
+            hasher.Add(element.AlignedByteOffset);
+            hasher.Add(element.InputSlotClass);
+            hasher.Add(element.InstanceDataStepRate);
+        }
+    }
+
+    // The size comes first, so that bytes moved from one shader to the next change the hash.
+    void HashShader(HashUtils::Hasher& hasher, const PipelineStateKey::ShaderBytecode& shader)
+    {
+        hasher.Add(shader.Size);
+        hasher.AddBytes(shader.Data, shader.Size);
+    }
+}
+
+uint64_t PipelineStateKey::ComputeStateHash() const
+{
+    HashUtils::Hasher hasher;
+    hasher.Add(RootSignatureHash);
+    HashShader(hasher, VertexShader);
+    HashShader(hasher, PixelShader);
+    HashInputLayout(hasher, InputLayout);
+    HashBlend(hasher, BlendState);
+    HashDepthStencil(hasher, DepthStencilState);
+    HashRasterizer(hasher, RasterizerState);
+    return hasher.GetValue();
+}
+
+uint64_t PipelineStateKey::ComputeKey() const
+{
+    return PipelineStateCacheFile::ComputePipelineKey(ComputeStateHash(), RenderTargetState);
+}
+
+uint64_t PipelineStateKey::ComputeComputePipelineKey(const uint64_t rootSignatureHash, const ShaderBytecode& computeShader)
+{
+    HashUtils::Hasher hasher;
+    hasher.Add(rootSignatureHash);
+    HashShader(hasher, computeShader);
+    return hasher.GetValue();
+}
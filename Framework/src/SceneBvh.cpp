@@ -0,0 +1,403 @@
+#include <Framework/SceneBvh.h>
+
+#include <algorithm>
+#include <array>
+
+using namespace DirectX;
+
+namespace
+{
+    // The tree is rebuilt when the refits have made the sum of the nodes' surface areas this much larger than after the last build.
+    constexpr float REBUILD_SURFACE_AREA_RATIO = 1.5f;
+
+    // Every level splits the objects in four halves of halves, so even 2^32 objects are less than 17 levels deep,
+    // and a level adds at most BRANCHING_FACTOR - 1 entries to the stack.
+    constexpr uint32_t MAX_STACK_SIZE = 64;
+
+    struct PlaneVectors
+    {
+        XMVECTOR NormalX;
+        XMVECTOR NormalY;
+        XMVECTOR NormalZ;
+        XMVECTOR Distance;
+        bool IsPositiveX;
+        bool IsPositiveY;
+        bool IsPositiveZ;
+    };
+
+    float GetAxis(const XMFLOAT3& vector, const uint32_t axis)
+    {
+        return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+    }
+}
+
+bool SceneBvh::Bounds::operator==(const Bounds& other) const
+{
+    return Min.x == other.Min.x && Min.y == other.Min.y && Min.z == other.Min.z &&
+        Max.x == other.Max.x && Max.y == other.Max.y && Max.z == other.Max.z;
+}
+
+void SceneBvh::Bounds::Encapsulate(const Bounds& other)
+{
+    Min = { std::min(Min.x, other.Min.x), std::min(Min.y, other.Min.y), std::min(Min.z, other.Min.z) };
+    Max = { std::max(Max.x, other.Max.x), std::max(Max.y, other.Max.y), std::max(Max.z, other.Max.z) };
+}
+
+float SceneBvh::Bounds::GetSurfaceArea() const
+{
+    const float x = Max.x - Min.x;
+    const float y = Max.y - Min.y;
+    const float z = Max.z - Min.z;
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+SceneBvh::Bounds SceneBvh::ToBounds(const Aabb& aabb)
+{
+    Bounds bounds{};
+    XMStoreFloat3(&bounds.Min, aabb.Min);
+    XMStoreFloat3(&bounds.Max, aabb.Max);
+    return bounds;
+}
+
+SceneBvh::Bounds SceneBvh::GetChildBounds(const Node& node, const uint32_t lane)
+{
+    const float* minX = &node.MinX.x;
+    const float* minY = &node.MinY.x;
+    const float* minZ = &node.MinZ.x;
+    const float* maxX = &node.MaxX.x;
+    const float* maxY = &node.MaxY.x;
+    const float* maxZ = &node.MaxZ.x;
+    return { { minX[lane], minY[lane], minZ[lane] }, { maxX[lane], maxY[lane], maxZ[lane] } };
+}
+
+void SceneBvh::SetChildBounds(Node& node, const uint32_t lane, const Bounds& bounds)
+{
+    (&node.MinX.x)[lane] = bounds.Min.x;
+    (&node.MinY.x)[lane] = bounds.Min.y;
+    (&node.MinZ.x)[lane] = bounds.Min.z;
+    (&node.MaxX.x)[lane] = bounds.Max.x;
+    (&node.MaxY.x)[lane] = bounds.Max.y;
+    (&node.MaxZ.x)[lane] = bounds.Max.z;
+}
+
+SceneBvh::Bounds SceneBvh::ComputeNodeBounds(const Node& node)
+{
+    Bounds bounds = GetChildBounds(node, 0);
+    for (uint32_t lane = 1; lane < node.ChildrenCount; ++lane)
+    {
+        bounds.Encapsulate(GetChildBounds(node, lane));
+    }
+
+    return bounds;
+}
+
+void SceneBvh::Update(const std::vector<Aabb>& objectBounds)
+{
+    if (!m_IsValid || objectBounds.size() != m_ObjectBounds.size())
+    {
+        m_ObjectBounds.resize(objectBounds.size());
+        for (size_t i = 0; i < objectBounds.size(); ++i)
+        {
+            m_ObjectBounds[i] = ToBounds(objectBounds[i]);
+        }
+
+        Build();
+        return;
+    }
+
+    bool hasMoved = false;
+    for (size_t i = 0; i < objectBounds.size(); ++i)
+    {
+        const Bounds bounds = ToBounds(objectBounds[i]);
+        if (bounds == m_ObjectBounds[i])
+        {
+            continue;
+        }
+
+        m_ObjectBounds[i] = bounds;
+
+        const uint32_t objectLane = m_ObjectLanes[i];
+        const uint32_t nodeIndex = objectLane / BRANCHING_FACTOR;
+        SetChildBounds(m_Nodes[nodeIndex], objectLane % BRANCHING_FACTOR, bounds);
+        m_IsNodeDirty[nodeIndex] = true;
+        hasMoved = true;
+    }
+
+    if (!hasMoved)
+    {
+        return;
+    }
+
+    Refit();
+
+    if (m_SurfaceArea > m_BuiltSurfaceArea * REBUILD_SURFACE_AREA_RATIO)
+    {
+        Build();
+    }
+}
+
+void SceneBvh::Invalidate()
+{
+    m_IsValid = false;
+}
+
+void SceneBvh::Build()
+{
+    const auto numObjects = static_cast<uint32_t>(m_ObjectBounds.size());
+
+    m_Nodes.clear();
+    m_ObjectLanes.assign(numObjects, INVALID_INDEX);
+    m_BuildObjects.resize(numObjects);
+    m_BuildCenters.resize(numObjects);
+    m_SurfaceArea = 0.0f;
+
+    for (uint32_t i = 0; i < numObjects; ++i)
+    {
+        const auto& bounds = m_ObjectBounds[i];
+        m_BuildObjects[i] = i;
+        m_BuildCenters[i] = { (bounds.Min.x + bounds.Max.x) * 0.5f, (bounds.Min.y + bounds.Max.y) * 0.5f, (bounds.Min.z + bounds.Max.z) * 0.5f };
+    }
+
+    if (numObjects > 0)
+    {
+        BuildNode(0, numObjects, INVALID_INDEX);
+        m_RootBounds = ComputeNodeBounds(m_Nodes[0]);
+        m_SurfaceArea += m_RootBounds.GetSurfaceArea();
+    }
+
+    m_IsNodeDirty.assign(m_Nodes.size(), false);
+    m_BuiltSurfaceArea = m_SurfaceArea;
+    m_IsValid = true;
+
+    ++m_Stats.NumRebuilds;
+    m_Stats.NumObjects = numObjects;
+    m_Stats.NumNodes = static_cast<uint32_t>(m_Nodes.size());
+}
+
+uint32_t SceneBvh::BuildNode(const uint32_t begin, const uint32_t end, const uint32_t parentLane)
+{
+    // The parents are allocated before their children, so a refit can go through the nodes backwards.
+    const auto nodeIndex = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.push_back(Node{});
+    m_Nodes[nodeIndex].ParentLane = parentLane;
+
+    // Partitions [first, last) at split, along the longest axis of the centers.
+    const auto splitAt = [this](const uint32_t first, const uint32_t split, const uint32_t last)
+    {
+        XMFLOAT3 min = m_BuildCenters[m_BuildObjects[first]];
+        XMFLOAT3 max = min;
+        for (uint32_t i = first + 1; i < last; ++i)
+        {
+            const auto& center = m_BuildCenters[m_BuildObjects[i]];
+            min = { std::min(min.x, center.x), std::min(min.y, center.y), std::min(min.z, center.z) };
+            max = { std::max(max.x, center.x), std::max(max.y, center.y), std::max(max.z, center.z) };
+        }
+
+        const float extentX = max.x - min.x;
+        const float extentY = max.y - min.y;
+        const float extentZ = max.z - min.z;
+        const uint32_t axis = extentX >= extentY && extentX >= extentZ ? 0 : extentY >= extentZ ? 1 : 2;
+
+        std::nth_element(m_BuildObjects.begin() + first, m_BuildObjects.begin() + split, m_BuildObjects.begin() + last,
+            [this, axis](const uint32_t object1, const uint32_t object2)
+            {
+                return GetAxis(m_BuildCenters[object1], axis) < GetAxis(m_BuildCenters[object2], axis);
+            });
+    };
+
+    std::array<uint32_t, BRANCHING_FACTOR + 1> groupBounds{};
+    uint32_t groupsCount;
+
+    if (end - begin <= BRANCHING_FACTOR)
+    {
+        groupsCount = end - begin;
+        for (uint32_t i = 0; i <= groupsCount; ++i)
+        {
+            groupBounds[i] = begin + i;
+        }
+    }
+    else
+    {
+        // A binary split of each half of a binary split: at least two objects per half, so at least one per group.
+        const uint32_t middle = begin + (end - begin) / 2;
+        splitAt(begin, middle, end);
+        const uint32_t firstQuarter = begin + (middle - begin) / 2;
+        splitAt(begin, firstQuarter, middle);
+        const uint32_t lastQuarter = middle + (end - middle) / 2;
+        splitAt(middle, lastQuarter, end);
+
+        groupsCount = BRANCHING_FACTOR;
+        groupBounds = { begin, firstQuarter, middle, lastQuarter, end };
+    }
+
+    for (uint32_t lane = 0; lane < groupsCount; ++lane)
+    {
+        const uint32_t groupBegin = groupBounds[lane];
+        const uint32_t groupEnd = groupBounds[lane + 1];
+
+        uint32_t child;
+        Bounds childBounds;
+
+        if (groupEnd - groupBegin == 1)
+        {
+            const uint32_t objectIndex = m_BuildObjects[groupBegin];
+            child = objectIndex | OBJECT_BIT;
+            childBounds = m_ObjectBounds[objectIndex];
+            m_ObjectLanes[objectIndex] = nodeIndex * BRANCHING_FACTOR + lane;
+        }
+        else
+        {
+            // Invalidates the references to m_Nodes.
+            child = BuildNode(groupBegin, groupEnd, nodeIndex * BRANCHING_FACTOR + lane);
+            childBounds = ComputeNodeBounds(m_Nodes[child]);
+            m_SurfaceArea += childBounds.GetSurfaceArea();
+        }
+
+        auto& node = m_Nodes[nodeIndex];
+        node.Children[lane] = child;
+        SetChildBounds(node, lane, childBounds);
+    }
+
+    m_Nodes[nodeIndex].ChildrenCount = groupsCount;
+    return nodeIndex;
+}
+
+void SceneBvh::Refit()
+{
+    for (auto nodeIndex = static_cast<uint32_t>(m_Nodes.size()); nodeIndex-- > 0;)
+    {
+        if (!m_IsNodeDirty[nodeIndex])
+        {
+            continue;
+        }
+
+        m_IsNodeDirty[nodeIndex] = false;
+        ++m_Stats.NumRefittedNodes;
+
+        const auto& node = m_Nodes[nodeIndex];
+        const Bounds bounds = ComputeNodeBounds(node);
+
+        if (node.ParentLane == INVALID_INDEX)
+        {
+            m_SurfaceArea += bounds.GetSurfaceArea() - m_RootBounds.GetSurfaceArea();
+            m_RootBounds = bounds;
+            continue;
+        }
+
+        const uint32_t parentIndex = node.ParentLane / BRANCHING_FACTOR;
+        const uint32_t lane = node.ParentLane % BRANCHING_FACTOR;
+        const Bounds previousBounds = GetChildBounds(m_Nodes[parentIndex], lane);
+
+        // The objects have moved inside the node.
+        if (bounds == previousBounds)
+        {
+            continue;
+        }
+
+        m_SurfaceArea += bounds.GetSurfaceArea() - previousBounds.GetSurfaceArea();
+        SetChildBounds(m_Nodes[parentIndex], lane, bounds);
+        m_IsNodeDirty[parentIndex] = true;
+    }
+
+    ++m_Stats.NumRefits;
+}
+
+void SceneBvh::Query(const Frustum& frustum, std::vector<uint32_t>& visibleObjects) const
+{
+    if (m_Nodes.empty())
+    {
+        return;
+    }
+
+    PlaneVectors planes[ShadowCasterCulling::FRUSTUM_PLANES_COUNT];
+    for (uint32_t i = 0; i < ShadowCasterCulling::FRUSTUM_PLANES_COUNT; ++i)
+    {
+        const auto& plane = frustum.Planes[i];
+        planes[i] = {
+            XMVectorReplicate(plane.x), XMVectorReplicate(plane.y), XMVectorReplicate(plane.z), XMVectorReplicate(plane.w),
+            plane.x >= 0.0f, plane.y >= 0.0f, plane.z >= 0.0f,
+        };
+    }
+
+    std::array<uint32_t, MAX_STACK_SIZE> stack;
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const auto& node = m_Nodes[stack[--stackSize]];
+
+        const XMVECTOR minX = XMLoadFloat4A(&node.MinX);
+        const XMVECTOR minY = XMLoadFloat4A(&node.MinY);
+        const XMVECTOR minZ = XMLoadFloat4A(&node.MinZ);
+        const XMVECTOR maxX = XMLoadFloat4A(&node.MaxX);
+        const XMVECTOR maxY = XMLoadFloat4A(&node.MaxY);
+        const XMVECTOR maxZ = XMLoadFloat4A(&node.MaxZ);
+
+        XMVECTOR isOutside = XMVectorFalseInt();
+        XMVECTOR isInside = XMVectorTrueInt();
+
+        for (const auto& plane : planes)
+        {
+            // A box is outside if its corner furthest along the normal is behind the plane, and inside if its nearest corner is in front of it.
+            const XMVECTOR farX = plane.IsPositiveX ? maxX : minX;
+            const XMVECTOR farY = plane.IsPositiveY ? maxY : minY;
+            const XMVECTOR farZ = plane.IsPositiveZ ? maxZ : minZ;
+            const XMVECTOR nearX = plane.IsPositiveX ? minX : maxX;
+            const XMVECTOR nearY = plane.IsPositiveY ? minY : maxY;
+            const XMVECTOR nearZ = plane.IsPositiveZ ? minZ : maxZ;
+
+            const XMVECTOR farDistance = XMVectorMultiplyAdd(farZ, plane.NormalZ,
+                XMVectorMultiplyAdd(farY, plane.NormalY, XMVectorMultiply(farX, plane.NormalX)));
+            const XMVECTOR nearDistance = XMVectorMultiplyAdd(nearZ, plane.NormalZ,
+                XMVectorMultiplyAdd(nearY, plane.NormalY, XMVectorMultiply(nearX, plane.NormalX)));
+
+            isOutside = XMVectorOrInt(isOutside, XMVectorLess(farDistance, plane.Distance));
+            isInside = XMVectorAndInt(isInside, XMVectorGreaterOrEqual(nearDistance, plane.Distance));
+        }
+
+        uint32_t outsideLanes[BRANCHING_FACTOR];
+        uint32_t insideLanes[BRANCHING_FACTOR];
+        XMStoreInt4(outsideLanes, isOutside);
+        XMStoreInt4(insideLanes, isInside);
+
+        for (uint32_t lane = 0; lane < node.ChildrenCount; ++lane)
+        {
+            if (outsideLanes[lane] != 0)
+            {
+                continue;
+            }
+
+            const uint32_t child = node.Children[lane];
+            if ((child & OBJECT_BIT) != 0)
+            {
+                visibleObjects.push_back(child & ~OBJECT_BIT);
+            }
+            else if (insideLanes[lane] != 0)
+            {
+                AppendSubtree(child, visibleObjects);
+            }
+            else
+            {
+                stack[stackSize++] = child;
+            }
+        }
+    }
+}
+
+void SceneBvh::AppendSubtree(const uint32_t nodeIndex, std::vector<uint32_t>& visibleObjects) const
+{
+    const auto& node = m_Nodes[nodeIndex];
+    for (uint32_t lane = 0; lane < node.ChildrenCount; ++lane)
+    {
+        const uint32_t child = node.Children[lane];
+        if ((child & OBJECT_BIT) != 0)
+        {
+            visibleObjects.push_back(child & ~OBJECT_BIT);
+        }
+        else
+        {
+            AppendSubtree(child, visibleObjects);
+        }
+    }
+}
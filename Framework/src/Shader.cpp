@@ -2,24 +2,89 @@
 #include <DX12Library/ShaderUtils.h>
 #include <DX12Library/Application.h>
 
+#include "PipelineStateCache.h"
+#include "PipelineStateCompiler.h"
+
 Shader::Shader(const std::shared_ptr<CommonRootSignature>& rootSignature, const ShaderBlob& vertexShader, const ShaderBlob& pixelShader, const std::function<void(PipelineStateBuilder&)> buildPipelineState)
     : m_RootSignature(rootSignature)
     , m_PipelineStateBuilder(rootSignature)
 {
     m_PipelineStateBuilder.WithShaders(vertexShader.GetBlob(), pixelShader.GetBlob());
     buildPipelineState(m_PipelineStateBuilder);
+    m_PipelineStateHash = m_PipelineStateBuilder.ComputeStateHash();
+
+    m_VertexShaderMetadata = ShaderReflectionCache::Get(vertexShader);
+    m_PixelShaderMetadata = ShaderReflectionCache::Get(pixelShader);
+    BuildShaderResourceViewBindings();
+
+    StartPrewarm();
+}
+
+void Shader::StartPrewarm()
+{
+    if (!PipelineStateCache::IsCreated() || !PipelineStateCompiler::IsCreated())
+    {
+        return;
+    }
 
-    CollectShaderMetadata(vertexShader.GetBlob(), &m_VertexShaderMetadata);
-    CollectShaderMetadata(pixelShader.GetBlob(), &m_PixelShaderMetadata);
+    for (const auto& renderTargetState : PipelineStateCache::Get().GetKnownRenderTargetStates(m_PipelineStateHash))
+    {
+        ScheduleCompilation(renderTargetState);
+    }
 }
 
-void Shader::Bind(CommandList& commandList)
+void Shader::ConfigureForRenderTargetState(PipelineStateBuilder& builder, const RenderTargetState& renderTargetState)
+{
+    const auto& formats = renderTargetState.GetFormats();
+    std::vector<DXGI_FORMAT> renderTargetFormats(formats.GetFormats(), formats.GetFormats() + formats.GetCount());
+    builder.WithRenderTargetFormats(renderTargetFormats, formats.GetDepthStencilFormat());
+    builder.WithSampleDesc(renderTargetState.GetSampleDesc());
+}
+
+void Shader::ScheduleCompilation(const RenderTargetState& renderTargetState)
+{
+    if (m_PendingPipelineStateObjects.find(renderTargetState) != m_PendingPipelineStateObjects.end())
+    {
+        return;
+    }
+
+    // The builder is copied, because the original one is modified on the render thread.
+    PipelineStateBuilder builder = m_PipelineStateBuilder;
+    ConfigureForRenderTargetState(builder, renderTargetState);
+
+    const uint64_t key = builder.ComputeKey();
+    auto job = PipelineStateCompiler::Get().Compile(key, [builder = std::move(builder)]()
+        {
+            return builder.Build(Application::Get().GetDevice());
+        });
+    m_PendingPipelineStateObjects.emplace(renderTargetState, std::move(job));
+}
+
+bool Shader::Bind(CommandList& commandList)
 {
     const auto device = Application::Get().GetDevice();
     const auto& renderTargetState = commandList.GetLastRenderTargetState();
-    const auto pipelineState = GetPipelineState(device, renderTargetState);
+    const auto pipelineState = TryGetPipelineState(device, renderTargetState);
+
+    if (pipelineState != nullptr)
+    {
+        commandList.SetPipelineState(pipelineState);
+        return true;
+    }
+
+    if (m_FallbackShader != nullptr)
+    {
+        return m_FallbackShader->Bind(commandList);
+    }
+
+    commandList.SkipDrawsUntilNextPipelineState();
+    return false;
+}
 
-    commandList.SetPipelineState(pipelineState);
+void Shader::SetFallback(const std::shared_ptr<Shader>& fallbackShader)
+{
+    Assert(fallbackShader.get() != this, "A shader cannot be its own fallback.");
+    m_FallbackShader = fallbackShader;
 }
 
 void Shader::Unbind(CommandList& commandList)
@@ -32,99 +97,129 @@ void Shader::SetMaterialConstantBuffer(CommandList& commandList, size_t size, co
     m_RootSignature->SetMaterialConstantBuffer(commandList, size, data);
 }
 
-void Shader::SetShaderResourceView(CommandList& commandList, const std::string& variableName, const ShaderResourceView& shaderResourceView)
+void Shader::SetMaterialConstantBuffer(CommandList& commandList, const D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
 {
-    const auto vsFindResult = m_VertexShaderMetadata.m_ShaderResourceViewsNameCache.find(variableName);
-    const auto vsFound = vsFindResult != m_VertexShaderMetadata.m_ShaderResourceViewsNameCache.end();
-    if (vsFound)
+    m_RootSignature->SetMaterialConstantBuffer(commandList, bufferLocation);
+}
+
+Shader::ShaderResourceViewId Shader::FindShaderResourceView(const std::string& variableName) const
+{
+    const auto findResult = m_ShaderResourceViewIds.find(variableName);
+    if (findResult == m_ShaderResourceViewIds.end())
     {
-        auto index = vsFindResult->second;
-        const auto& srvMetadata = m_VertexShaderMetadata.m_ShaderResourceViews[index];
-        switch (srvMetadata.Space)
-        {
-        case CommonRootSignature::MATERIAL_REGISTER_SPACE:
-            m_RootSignature->SetMaterialShaderResourceView(commandList, srvMetadata.RegisterIndex, shaderResourceView);
-            break;
-        case CommonRootSignature::PIPELINE_REGISTER_SPACE:
-            m_RootSignature->SetPipelineShaderResourceView(commandList, srvMetadata.RegisterIndex, shaderResourceView);
-            break;
-        default:
-            throw std::exception("Invalid space index for an SRV.");
-        }
+        return INVALID_SHADER_RESOURCE_VIEW_ID;
     }
 
-    const auto psFindResult = m_PixelShaderMetadata.m_ShaderResourceViewsNameCache.find(variableName);
-    const auto psFound = psFindResult != m_PixelShaderMetadata.m_ShaderResourceViewsNameCache.end();
-    if (psFound)
+    return findResult->second;
+}
+
+void Shader::SetShaderResourceView(CommandList& commandList, const ShaderResourceViewId id, const ShaderResourceView& shaderResourceView)
+{
+    Assert(id < m_ShaderResourceViewBindings.size(), "Invalid shader resource view ID.");
+
+    const auto& binding = m_ShaderResourceViewBindings[id];
+    for (uint32_t i = 0; i < binding.NumRegisters; ++i)
     {
-        auto index = psFindResult->second;
-        const auto& srvMetadata = m_PixelShaderMetadata.m_ShaderResourceViews[index];
-        switch (srvMetadata.Space)
+        const auto& shaderRegister = binding.Registers[i];
+        switch (shaderRegister.Space)
         {
         case CommonRootSignature::MATERIAL_REGISTER_SPACE:
-            m_RootSignature->SetMaterialShaderResourceView(commandList, srvMetadata.RegisterIndex, shaderResourceView);
+            m_RootSignature->SetMaterialShaderResourceView(commandList, shaderRegister.Index, shaderResourceView);
             break;
         case CommonRootSignature::PIPELINE_REGISTER_SPACE:
-            m_RootSignature->SetPipelineShaderResourceView(commandList, srvMetadata.RegisterIndex, shaderResourceView);
+            m_RootSignature->SetPipelineShaderResourceView(commandList, shaderRegister.Index, shaderResourceView);
             break;
         default:
             throw std::exception("Invalid space index for an SRV.");
         }
     }
+}
 
-    if (!vsFound && !psFound)
+void Shader::SetShaderResourceView(CommandList& commandList, const std::string& variableName, const ShaderResourceView& shaderResourceView)
+{
+    const auto id = FindShaderResourceView(variableName);
+    if (id == INVALID_SHADER_RESOURCE_VIEW_ID)
     {
         throw std::exception("Shader variable not found.");
     }
+
+    SetShaderResourceView(commandList, id, shaderResourceView);
 }
 
-Microsoft::WRL::ComPtr<ID3D12PipelineState> Shader::GetPipelineState(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const RenderTargetState& renderTargetState)
+Microsoft::WRL::ComPtr<ID3D12PipelineState> Shader::TryGetPipelineState(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const RenderTargetState& renderTargetState)
 {
-    auto findResult = m_PipelineStateObjects.find(renderTargetState);
-    if (findResult == m_PipelineStateObjects.end())
+    const auto findResult = m_PipelineStateObjects.find(renderTargetState);
+    if (findResult != m_PipelineStateObjects.end())
     {
-        const auto& formats = renderTargetState.GetFormats();
-        std::vector<DXGI_FORMAT> renderTargetFormats(formats.GetCount());
-        memcpy(renderTargetFormats.data(), formats.GetFormats(), sizeof(DXGI_FORMAT) * renderTargetFormats.size());
-        m_PipelineStateBuilder.WithRenderTargetFormats(renderTargetFormats, formats.GetDepthStencilFormat());
+        return findResult->second;
+    }
 
-        m_PipelineStateBuilder.WithSampleDesc(renderTargetState.GetSampleDesc());
+    if (PipelineStateCache::IsCreated())
+    {
+        PipelineStateCache::Get().RegisterRenderTargetState(m_PipelineStateHash, renderTargetState);
+    }
 
+    if (!PipelineStateCompiler::IsCreated())
+    {
+        ConfigureForRenderTargetState(m_PipelineStateBuilder, renderTargetState);
         const auto pipelineStateObject = m_PipelineStateBuilder.Build(device);
-
         m_PipelineStateObjects.insert(std::make_pair(renderTargetState, pipelineStateObject));
-
         return pipelineStateObject;
     }
-    else
+
+    const auto pendingFindResult = m_PendingPipelineStateObjects.find(renderTargetState);
+    if (pendingFindResult == m_PendingPipelineStateObjects.end())
     {
-        return findResult->second;
+        ScheduleCompilation(renderTargetState);
+        return nullptr;
     }
-}
 
-void Shader::CollectShaderMetadata(const Microsoft::WRL::ComPtr<ID3DBlob>& shader, ShaderMetadata* outMetadata)
-{
-    const auto reflection = ShaderUtils::Reflect(shader);
-
-    // constant buffers
+    const auto& job = pendingFindResult->second;
+    switch (job->GetStatus())
     {
-        outMetadata->m_ConstantBuffers = std::move(ShaderUtils::GetConstantBuffers(reflection));
-
-        for (size_t i = 0; i < outMetadata->m_ConstantBuffers.size(); ++i)
-        {
-            const auto& cbufferMetadata = outMetadata->m_ConstantBuffers[i];
-            outMetadata->m_ConstantBuffersNameCache.emplace(cbufferMetadata.Name, i);
-        }
+    case PipelineStateCompiler::JobStatus::Pending:
+        return nullptr;
+    case PipelineStateCompiler::JobStatus::Completed:
+    {
+        const auto pipelineStateObject = job->GetResult();
+        m_PipelineStateObjects.insert(std::make_pair(renderTargetState, pipelineStateObject));
+        m_PendingPipelineStateObjects.erase(pendingFindResult);
+        return pipelineStateObject;
     }
+    case PipelineStateCompiler::JobStatus::Failed:
+    default:
+        throw std::exception(job->GetErrorMessage().c_str());
+    }
+}
 
-    // shader resource views
+void Shader::BuildShaderResourceViewBindings()
+{
+    const auto addRegisters = [this](const ShaderMetadata& metadata)
     {
-        outMetadata->m_ShaderResourceViews = std::move(ShaderUtils::GetShaderResourceViews(reflection));
-
-        for (size_t i = 0; i < outMetadata->m_ShaderResourceViews.size(); ++i)
+        for (const auto& srvMetadata : metadata.m_ShaderResourceViews)
         {
-            const auto& srvMetadata = outMetadata->m_ShaderResourceViews[i];
-            outMetadata->m_ShaderResourceViewsNameCache.emplace(srvMetadata.Name, i);
+            const auto [it, inserted] = m_ShaderResourceViewIds.try_emplace(srvMetadata.Name, static_cast<ShaderResourceViewId>(m_ShaderResourceViewBindings.size()));
+            if (inserted)
+            {
+                m_ShaderResourceViewBindings.push_back({});
+            }
+
+            auto& binding = m_ShaderResourceViewBindings[it->second];
+            const ShaderResourceViewBinding::Register shaderRegister = { srvMetadata.Space, srvMetadata.RegisterIndex };
+
+            bool isDuplicate = false;
+            for (uint32_t i = 0; i < binding.NumRegisters; ++i)
+            {
+                isDuplicate |= binding.Registers[i].Space == shaderRegister.Space && binding.Registers[i].Index == shaderRegister.Index;
+            }
+
+            if (!isDuplicate)
+            {
+                binding.Registers[binding.NumRegisters++] = shaderRegister;
+            }
         }
-    }
+    };
+
+    addRegisters(*m_VertexShaderMetadata);
+    addRegisters(*m_PixelShaderMetadata);
 }
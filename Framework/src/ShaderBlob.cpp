@@ -12,6 +12,7 @@ ShaderBlob::ShaderBlob(const void* bytecode, size_t length)
 
 ShaderBlob::ShaderBlob(const std::wstring& fileName)
 	: m_Blob(ShaderUtils::LoadShaderFromFile(fileName))
+	, m_FileName(fileName)
 {
 
 }
@@ -20,3 +21,8 @@ const Microsoft::WRL::ComPtr<ID3DBlob>& ShaderBlob::GetBlob() const
 {
 	return m_Blob;
 }
+
+const std::wstring& ShaderBlob::GetFileName() const
+{
+	return m_FileName;
+}
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "ShaderReflectionCache.h"
+#include "ByteStream.h"
+
+#include <DX12Library/HashUtils.h>
+
+#include <fstream>
+
+namespace
+{
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t BytecodeHash;
+        uint64_t PayloadSize;
+        uint64_t PayloadHash;
+    };
+}
+
+std::mutex ShaderReflectionCache::s_Mutex;
+std::unordered_map<uint64_t, std::shared_ptr<const ShaderReflection>> ShaderReflectionCache::s_Reflections;
+
+void ShaderReflection::BuildNameCaches()
+{
+    m_ConstantBuffersNameCache.clear();
+    m_ConstantBufferVariablesNameHashCache.clear();
+    m_ConstantBufferVariablesNameHashCache.resize(m_ConstantBuffers.size());
+
+    for (size_t i = 0; i < m_ConstantBuffers.size(); ++i)
+    {
+        const auto& constantBuffer = m_ConstantBuffers[i];
+        m_ConstantBuffersNameCache.emplace(constantBuffer.Name, i);
+
+        auto& variablesNameHashCache = m_ConstantBufferVariablesNameHashCache[i];
+        for (size_t variableIndex = 0; variableIndex < constantBuffer.Variables.size(); ++variableIndex)
+        {
+            const auto [it, inserted] = variablesNameHashCache.emplace(HashUtils::Fnv1a(constantBuffer.Variables[variableIndex].Name), variableIndex);
+            if (!inserted)
+            {
+                throw std::exception("Constant buffer variable name hash collision.");
+            }
+        }
+    }
+
+    m_ShaderResourceViewsNameCache.clear();
+    for (size_t i = 0; i < m_ShaderResourceViews.size(); ++i)
+    {
+        m_ShaderResourceViewsNameCache.emplace(m_ShaderResourceViews[i].Name, i);
+    }
+}
+
+std::vector<uint8_t> ShaderReflection::Serialize(const uint64_t bytecodeHash) const
+{
+    std::vector<uint8_t> payload;
+    ByteWriter payloadWriter(payload);
+
+    payloadWriter.Write(static_cast<uint32_t>(m_ConstantBuffers.size()));
+    for (const auto& constantBuffer : m_ConstantBuffers)
+    {
+        payloadWriter.WriteString(constantBuffer.Name);
+        payloadWriter.Write(constantBuffer.RegisterIndex);
+        payloadWriter.Write(constantBuffer.Space);
+        payloadWriter.Write(constantBuffer.Size);
+
+        payloadWriter.Write(static_cast<uint32_t>(constantBuffer.Variables.size()));
+        for (const auto& variable : constantBuffer.Variables)
+        {
+            payloadWriter.WriteString(variable.Name);
+            payloadWriter.Write(variable.Size);
+            payloadWriter.Write(variable.Offset);
+
+            const uint8_t hasDefaultValue = variable.DefaultValue != nullptr ? 1 : 0;
+            payloadWriter.Write(hasDefaultValue);
+            if (hasDefaultValue)
+            {
+                payloadWriter.WriteBytes(variable.DefaultValue.get(), variable.Size);
+            }
+        }
+    }
+
+    payloadWriter.Write(static_cast<uint32_t>(m_ShaderResourceViews.size()));
+    for (const auto& shaderResourceView : m_ShaderResourceViews)
+    {
+        payloadWriter.WriteString(shaderResourceView.Name);
+        payloadWriter.Write(shaderResourceView.RegisterIndex);
+        payloadWriter.Write(shaderResourceView.Space);
+    }
+
+    Header header{};
+    header.Magic = MAGIC;
+    header.Version = VERSION;
+    header.BytecodeHash = bytecodeHash;
+    header.PayloadSize = payload.size();
+    header.PayloadHash = HashUtils::Fnv1a(payload.data(), payload.size());
+
+    std::vector<uint8_t> result;
+    result.reserve(sizeof(Header) + payload.size());
+
+    ByteWriter writer(result);
+    writer.Write(header);
+    writer.WriteBytes(payload.data(), payload.size());
+    return result;
+}
+
+bool ShaderReflection::Deserialize(const uint8_t* data, const size_t size, const uint64_t bytecodeHash)
+{
+    *this = {};
+
+    ByteReader reader(data, size);
+
+    Header header{};
+    if (!reader.Read(header) ||
+        header.Magic != MAGIC ||
+        header.Version != VERSION ||
+        header.BytecodeHash != bytecodeHash ||
+        header.PayloadSize != reader.GetRemainingSize() ||
+        header.PayloadHash != HashUtils::Fnv1a(data + sizeof(Header), reader.GetRemainingSize()))
+    {
+        return false;
+    }
+
+    const auto readConstantBuffers = [this, &reader]()
+    {
+        uint32_t numConstantBuffers;
+        if (!reader.Read(numConstantBuffers))
+        {
+            return false;
+        }
+
+        m_ConstantBuffers.resize(numConstantBuffers);
+        for (auto& constantBuffer : m_ConstantBuffers)
+        {
+            uint32_t numVariables;
+            if (!reader.ReadString(constantBuffer.Name) ||
+                !reader.Read(constantBuffer.RegisterIndex) ||
+                !reader.Read(constantBuffer.Space) ||
+                !reader.Read(constantBuffer.Size) ||
+                !reader.Read(numVariables))
+            {
+                return false;
+            }
+
+            constantBuffer.Variables.resize(numVariables);
+            for (auto& variable : constantBuffer.Variables)
+            {
+                uint8_t hasDefaultValue;
+                if (!reader.ReadString(variable.Name) ||
+                    !reader.Read(variable.Size) ||
+                    !reader.Read(variable.Offset) ||
+                    !reader.Read(hasDefaultValue))
+                {
+                    return false;
+                }
+
+                if (hasDefaultValue)
+                {
+                    if (variable.Size > reader.GetRemainingSize())
+                    {
+                        return false;
+                    }
+
+                    variable.DefaultValue = std::shared_ptr<uint8_t[]>(new uint8_t[variable.Size]);
+                    reader.ReadBytes(variable.DefaultValue.get(), variable.Size);
+                }
+            }
+        }
+
+        return true;
+    };
+
+    const auto readShaderResourceViews = [this, &reader]()
+    {
+        uint32_t numShaderResourceViews;
+        if (!reader.Read(numShaderResourceViews))
+        {
+            return false;
+        }
+
+        m_ShaderResourceViews.resize(numShaderResourceViews);
+        for (auto& shaderResourceView : m_ShaderResourceViews)
+        {
+            if (!reader.ReadString(shaderResourceView.Name) ||
+                !reader.Read(shaderResourceView.RegisterIndex) ||
+                !reader.Read(shaderResourceView.Space))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    if (!readConstantBuffers() || !readShaderResourceViews() || reader.GetRemainingSize() != 0)
+    {
+        *this = {};
+        return false;
+    }
+
+    BuildNameCaches();
+    return true;
+}
+
+std::shared_ptr<const ShaderReflection> ShaderReflectionCache::Get(const ShaderBlob& shaderBlob)
+{
+    const auto& blob = shaderBlob.GetBlob();
+    const uint64_t bytecodeHash = ComputeBytecodeHash(blob);
+
+    {
+        std::lock_guard lock(s_Mutex);
+
+        const auto findResult = s_Reflections.find(bytecodeHash);
+        if (findResult != s_Reflections.end())
+        {
+            return findResult->second;
+        }
+    }
+
+    std::shared_ptr<ShaderReflection> reflection;
+
+    const auto& fileName = shaderBlob.GetFileName();
+    if (!fileName.empty())
+    {
+        const auto path = GetReflectionFilePath(fileName);
+        reflection = TryReadReflectionFile(path, bytecodeHash);
+
+        if (reflection == nullptr)
+        {
+            reflection = Reflect(blob);
+            TryWriteReflectionFile(path, *reflection, bytecodeHash);
+        }
+    }
+    else
+    {
+        // Embedded bytecode is reflected once per run: there is no file to put the reflection next to.
+        reflection = Reflect(blob);
+    }
+
+    std::lock_guard lock(s_Mutex);
+
+    // Another thread might have reflected the same bytecode in the meantime: keep the first one.
+    const auto [it, inserted] = s_Reflections.emplace(bytecodeHash, std::move(reflection));
+    return it->second;
+}
+
+uint64_t ShaderReflectionCache::ComputeBytecodeHash(const Microsoft::WRL::ComPtr<ID3DBlob>& shaderBlob)
+{
+    return HashUtils::Fnv1a(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
+}
+
+std::filesystem::path ShaderReflectionCache::GetReflectionFilePath(const std::wstring& shaderFileName)
+{
+    std::filesystem::path path = ShaderUtils::GetShaderFilePath(shaderFileName);
+    path.replace_extension(L".reflection");
+    return path;
+}
+
+std::shared_ptr<ShaderReflection> ShaderReflectionCache::Reflect(const Microsoft::WRL::ComPtr<ID3DBlob>& shaderBlob)
+{
+    const auto reflection = ShaderUtils::Reflect(shaderBlob);
+
+    auto result = std::make_shared<ShaderReflection>();
+    result->m_ConstantBuffers = ShaderUtils::GetConstantBuffers(reflection);
+    result->m_ShaderResourceViews = ShaderUtils::GetShaderResourceViews(reflection);
+    result->BuildNameCaches();
+    return result;
+}
+
+std::shared_ptr<ShaderReflection> ShaderReflectionCache::TryReadReflectionFile(const std::filesystem::path& path, const uint64_t bytecodeHash)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return nullptr;
+    }
+
+    const auto size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(size);
+    if (!stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size)))
+    {
+        return nullptr;
+    }
+
+    auto reflection = std::make_shared<ShaderReflection>();
+    if (!reflection->Deserialize(bytes.data(), bytes.size(), bytecodeHash))
+    {
+        // Stale (the shader has been recompiled) or corrupted: reflected and overwritten by the caller.
+        return nullptr;
+    }
+
+    return reflection;
+}
+
+void ShaderReflectionCache::TryWriteReflectionFile(const std::filesystem::path& path, const ShaderReflection& reflection, const uint64_t bytecodeHash)
+{
+    const auto bytes = reflection.Serialize(bytecodeHash);
+
+    // Failing to write the file (e.g., a read-only install) only costs reflecting the shader again next time.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            return;
+        }
+    }
+
+    std::error_code errorCode;
+    std::filesystem::rename(tempPath, path, errorCode);
+}
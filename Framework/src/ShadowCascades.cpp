@@ -0,0 +1,164 @@
+#include <Framework/ShadowCascades.h>
+#include <Framework/BoundingSphere.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t FRUSTUM_CORNERS_COUNT = 4;
+
+    // A cascade is never thinner than this, even if the scene is empty.
+    constexpr float MIN_DEPTH_RANGE = 1e-3f;
+}
+
+ShadowCascades::SplitDistances ShadowCascades::ComputeSplitDistances(const float nearPlane, const float farPlane, const uint32_t cascadesCount, const float logarithmicSplitWeight)
+{
+    if (cascadesCount == 0 || cascadesCount > MAX_CASCADES_COUNT)
+    {
+        throw std::invalid_argument("The cascades count is out of range.");
+    }
+
+    if (nearPlane <= 0.0f || farPlane <= nearPlane)
+    {
+        throw std::invalid_argument("The near plane must be positive and nearer than the far plane.");
+    }
+
+    const float weight = std::clamp(logarithmicSplitWeight, 0.0f, 1.0f);
+
+    SplitDistances splitDistances{};
+    splitDistances[0] = nearPlane;
+
+    for (uint32_t i = 1; i < cascadesCount; ++i)
+    {
+        const float fraction = static_cast<float>(i) / static_cast<float>(cascadesCount);
+        const float uniformDistance = nearPlane + (farPlane - nearPlane) * fraction;
+        const float logarithmicDistance = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        splitDistances[i] = uniformDistance + (logarithmicDistance - uniformDistance) * weight;
+    }
+
+    splitDistances[cascadesCount] = farPlane;
+    return splitDistances;
+}
+
+ShadowCascades::Cascade ShadowCascades::ComputeCascade(const XMMATRIX& cameraView, const XMMATRIX& cameraProjection,
+    const float nearDistance, const float farDistance,
+    const FXMVECTOR lightDirectionWs, const BoundingSphere& sceneBounds, const uint32_t resolution)
+{
+    if (resolution <= 2)
+    {
+        throw std::invalid_argument("The shadow map resolution is too small.");
+    }
+
+    float nearPlane, farPlane;
+    GetPerspectiveClipPlanes(cameraProjection, &nearPlane, &farPlane);
+
+    // The slice is found in view space, where it does not depend on the camera's position and rotation,
+    // so neither does its bounding sphere's radius.
+    const XMMATRIX inverseProjection = XMMatrixInverse(nullptr, cameraProjection);
+    const XMVECTOR cornersNdc[FRUSTUM_CORNERS_COUNT] =
+    {
+        XMVectorSet(-1.0f, -1.0f, 0.0f, 1.0f),
+        XMVectorSet(1.0f, -1.0f, 0.0f, 1.0f),
+        XMVectorSet(-1.0f, 1.0f, 0.0f, 1.0f),
+        XMVectorSet(1.0f, 1.0f, 0.0f, 1.0f),
+    };
+
+    const float nearFraction = (nearDistance - nearPlane) / (farPlane - nearPlane);
+    const float farFraction = (farDistance - nearPlane) / (farPlane - nearPlane);
+
+    XMVECTOR sliceCornersVs[FRUSTUM_CORNERS_COUNT * 2];
+    XMVECTOR sliceCenterVs = XMVectorZero();
+
+    for (uint32_t i = 0; i < FRUSTUM_CORNERS_COUNT; ++i)
+    {
+        // The edges of the frustum are rays from the eye, so the view depth changes linearly along them.
+        const XMVECTOR nearCorner = XMVector3TransformCoord(cornersNdc[i], inverseProjection);
+        const XMVECTOR farCorner = XMVector3TransformCoord(XMVectorSetZ(cornersNdc[i], 1.0f), inverseProjection);
+        sliceCornersVs[i] = XMVectorLerp(nearCorner, farCorner, nearFraction);
+        sliceCornersVs[i + FRUSTUM_CORNERS_COUNT] = XMVectorLerp(nearCorner, farCorner, farFraction);
+
+        sliceCenterVs = XMVectorAdd(sliceCenterVs, XMVectorAdd(sliceCornersVs[i], sliceCornersVs[i + FRUSTUM_CORNERS_COUNT]));
+    }
+
+    sliceCenterVs = XMVectorScale(sliceCenterVs, 1.0f / static_cast<float>(FRUSTUM_CORNERS_COUNT * 2));
+
+    float sliceRadius = 0.0f;
+    for (const XMVECTOR corner : sliceCornersVs)
+    {
+        sliceRadius = std::max(sliceRadius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corner, sliceCenterVs))));
+    }
+
+    // A border of a texel on each side: the snapped projection still covers the whole sphere.
+    const float texelSize = 2.0f * sliceRadius / static_cast<float>(resolution - 2);
+    const float halfSize = 0.5f * texelSize * static_cast<float>(resolution);
+
+    // The light's view is placed at the origin, so that the texel grid is fixed in the world and only depends on the light's direction.
+    const XMVECTOR lightDirection = XMVector3Normalize(lightDirectionWs);
+    const XMVECTOR up = std::abs(XMVectorGetY(lightDirection)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    const XMMATRIX lightView = XMMatrixLookToLH(XMVectorZero(), XMVectorNegate(lightDirection), up);
+
+    const XMMATRIX inverseCameraView = XMMatrixInverse(nullptr, cameraView);
+    const XMVECTOR sliceCenterWs = XMVector3TransformCoord(sliceCenterVs, inverseCameraView);
+    XMFLOAT3 sliceCenterLs{};
+    XMStoreFloat3(&sliceCenterLs, XMVector3TransformCoord(sliceCenterWs, lightView));
+
+    // Moving by whole texels makes every world position fall on the same spot of a texel.
+    const float snappedCenterX = std::floor(sliceCenterLs.x / texelSize + 0.5f) * texelSize;
+    const float snappedCenterY = std::floor(sliceCenterLs.y / texelSize + 0.5f) * texelSize;
+
+    XMFLOAT3 sceneCenterLs{};
+    XMStoreFloat3(&sceneCenterLs, XMVector3TransformCoord(sceneBounds.GetCenter(), lightView));
+    const float sceneRadius = std::max(sceneBounds.GetRadius(), MIN_DEPTH_RANGE);
+
+    Cascade cascade{};
+    cascade.View = lightView;
+    cascade.Projection = XMMatrixOrthographicOffCenterLH(snappedCenterX - halfSize, snappedCenterX + halfSize,
+        snappedCenterY - halfSize, snappedCenterY + halfSize,
+        sceneCenterLs.z - sceneRadius, sceneCenterLs.z + sceneRadius);
+    cascade.ViewProjection = cascade.View * cascade.Projection;
+    cascade.NearDistance = nearDistance;
+    cascade.FarDistance = farDistance;
+    cascade.TexelSize = texelSize;
+    return cascade;
+}
+
+void ShadowCascades::GetPerspectiveClipPlanes(const XMMATRIX& projection, float* nearPlane, float* farPlane)
+{
+    // z' = z * f / (f - n) - n * f / (f - n)
+    const float scale = XMVectorGetZ(projection.r[2]);
+    const float offset = XMVectorGetZ(projection.r[3]);
+    *nearPlane = -offset / scale;
+    *farPlane = offset / (1.0f - scale);
+}
+
+void ShadowCascades::Update(const Settings& settings, const XMMATRIX& cameraView, const XMMATRIX& cameraProjection,
+    const FXMVECTOR lightDirectionWs, const BoundingSphere& sceneBounds)
+{
+    float nearPlane, farPlane;
+    GetPerspectiveClipPlanes(cameraProjection, &nearPlane, &farPlane);
+
+    const float maxDistance = std::min(std::max(settings.MaxDistance, nearPlane * 2.0f), farPlane);
+    const auto splitDistances = ComputeSplitDistances(nearPlane, maxDistance, settings.CascadesCount, settings.LogarithmicSplitWeight);
+
+    for (uint32_t i = 0; i < settings.CascadesCount; ++i)
+    {
+        m_Cascades[i] = ComputeCascade(cameraView, cameraProjection, splitDistances[i], splitDistances[i + 1],
+            lightDirectionWs, sceneBounds, settings.Resolution);
+    }
+
+    m_CascadesCount = settings.CascadesCount;
+}
+
+const ShadowCascades::Cascade& ShadowCascades::GetCascade(const uint32_t index) const
+{
+    if (index >= m_CascadesCount)
+    {
+        throw std::out_of_range("The cascade index is out of range.");
+    }
+
+    return m_Cascades[index];
+}
@@ -0,0 +1,171 @@
+#include <Framework/ShadowCasterCulling.h>
+#include <Framework/BoundingSphere.h>
+
+#include <cstring>
+#include <utility>
+
+using namespace DirectX;
+
+ShadowCasterCulling::Frustum ShadowCasterCulling::Frustum::FromViewProjection(const XMMATRIX& viewProjection)
+{
+    const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+    const XMVECTOR planeVectors[FRUSTUM_PLANES_COUNT] =
+    {
+        columns.r[2], // near: z >= 0
+        XMVectorSubtract(columns.r[3], columns.r[2]), // far: z <= w
+        XMVectorAdd(columns.r[3], columns.r[0]), // left: x >= -w
+        XMVectorSubtract(columns.r[3], columns.r[0]), // right: x <= w
+        XMVectorSubtract(columns.r[3], columns.r[1]), // top: y <= w
+        XMVectorAdd(columns.r[3], columns.r[1]), // bottom: y >= -w
+    };
+
+    Frustum frustum{};
+    for (uint32_t i = 0; i < FRUSTUM_PLANES_COUNT; ++i)
+    {
+        // dot(normal, position) + w >= 0, while the tests expect dot(normal, position) >= w.
+        XMStoreFloat4(&frustum.Planes[i], XMPlaneNormalize(planeVectors[i]));
+        frustum.Planes[i].w = -frustum.Planes[i].w;
+    }
+
+    return frustum;
+}
+
+bool ShadowCasterCulling::Intersects(const Frustum& frustum, const Aabb& aabb)
+{
+    return Intersects(frustum, ToBounds(aabb));
+}
+
+bool ShadowCasterCulling::Intersects(const BoundingSphere& sphere, const Aabb& aabb)
+{
+    return Intersects(sphere.GetCenter(), sphere.GetRadius(), ToBounds(aabb));
+}
+
+bool ShadowCasterCulling::CasterState::operator==(const CasterState& other) const
+{
+    return Model == other.Model && std::memcmp(&WorldMatrix, &other.WorldMatrix, sizeof(XMFLOAT4X4)) == 0;
+}
+
+ShadowCasterCulling::Bounds ShadowCasterCulling::ToBounds(const Aabb& aabb)
+{
+    Bounds bounds{};
+    XMStoreFloat3(&bounds.Min, aabb.Min);
+    XMStoreFloat3(&bounds.Max, aabb.Max);
+    return bounds;
+}
+
+bool ShadowCasterCulling::Intersects(const Frustum& frustum, const Bounds& bounds)
+{
+    // Outside if the corner furthest along the normal is behind a plane.
+    for (const auto& plane : frustum.Planes)
+    {
+        const float x = plane.x >= 0.0f ? bounds.Max.x : bounds.Min.x;
+        const float y = plane.y >= 0.0f ? bounds.Max.y : bounds.Min.y;
+        const float z = plane.z >= 0.0f ? bounds.Max.z : bounds.Min.z;
+
+        if (plane.x * x + plane.y * y + plane.z * z < plane.w)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ShadowCasterCulling::Intersects(const FXMVECTOR sphereCenter, const float sphereRadius, const Bounds& bounds)
+{
+    const XMVECTOR min = XMLoadFloat3(&bounds.Min);
+    const XMVECTOR max = XMLoadFloat3(&bounds.Max);
+    const XMVECTOR closestPoint = XMVectorClamp(sphereCenter, min, max);
+    const XMVECTOR offset = XMVectorSubtract(sphereCenter, closestPoint);
+    return XMVectorGetX(XMVector3Dot(offset, offset)) <= sphereRadius * sphereRadius;
+}
+
+void ShadowCasterCulling::BeginFrame(const std::vector<Caster>& casters)
+{
+    std::swap(m_CasterStates, m_PreviousCasterStates);
+
+    m_CasterBounds.resize(casters.size());
+    m_CasterStates.resize(casters.size());
+    for (size_t i = 0; i < casters.size(); ++i)
+    {
+        m_CasterBounds[i] = ToBounds(casters[i].Bounds);
+        XMStoreFloat4x4(&m_CasterStates[i].WorldMatrix, casters[i].WorldMatrix);
+        m_CasterStates[i].Model = casters[i].Model;
+    }
+
+    // The indices may now refer to other casters.
+    if (m_CasterStates.size() != m_PreviousCasterStates.size())
+    {
+        Invalidate();
+    }
+
+    m_HasCasterChanged.assign(m_CasterStates.size(), false);
+    for (size_t i = 0; i < m_CasterStates.size() && i < m_PreviousCasterStates.size(); ++i)
+    {
+        m_HasCasterChanged[i] = !(m_CasterStates[i] == m_PreviousCasterStates[i]);
+    }
+
+    m_Stats = {};
+}
+
+bool ShadowCasterCulling::CullView(const uint32_t viewIndex, const XMMATRIX& viewProjection, const BoundingSphere* range)
+{
+    if (viewIndex >= m_Views.size())
+    {
+        m_Views.resize(viewIndex + 1);
+    }
+
+    auto& view = m_Views[viewIndex];
+
+    XMFLOAT4X4 viewProjectionValues;
+    XMStoreFloat4x4(&viewProjectionValues, viewProjection);
+    bool isDirty = !view.IsValid || std::memcmp(&view.ViewProjection, &viewProjectionValues, sizeof(XMFLOAT4X4)) != 0;
+
+    const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+    const XMVECTOR rangeCenter = range != nullptr ? range->GetCenter() : XMVectorZero();
+    const float rangeRadius = range != nullptr ? range->GetRadius() : 0.0f;
+
+    m_ScratchCasters.clear();
+    for (uint32_t casterIndex = 0; casterIndex < m_CasterBounds.size(); ++casterIndex)
+    {
+        const auto& bounds = m_CasterBounds[casterIndex];
+
+        if (range != nullptr && !Intersects(rangeCenter, rangeRadius, bounds))
+        {
+            continue;
+        }
+
+        if (!Intersects(frustum, bounds))
+        {
+            continue;
+        }
+
+        m_ScratchCasters.push_back(casterIndex);
+        isDirty = isDirty || m_HasCasterChanged[casterIndex];
+    }
+
+    // A caster has entered or left the view. The ones that have left are not in the new list, so they are caught here.
+    isDirty = isDirty || m_ScratchCasters != view.Casters;
+
+    std::swap(view.Casters, m_ScratchCasters);
+    view.ViewProjection = viewProjectionValues;
+    view.IsValid = true;
+
+    ++m_Stats.NumViews;
+    if (isDirty)
+    {
+        ++m_Stats.NumRedrawnViews;
+        m_Stats.NumDraws += static_cast<uint32_t>(view.Casters.size());
+        m_Stats.NumCulledDraws += static_cast<uint32_t>(m_CasterBounds.size() - view.Casters.size());
+    }
+
+    return isDirty;
+}
+
+void ShadowCasterCulling::Invalidate()
+{
+    for (auto& view : m_Views)
+    {
+        view.IsValid = false;
+    }
+}
@@ -0,0 +1,348 @@
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Round to nearest even, as the GPU conversion does.
+    uint16_t FloatToHalf(const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        const uint32_t sign = (bits >> 16) & 0x8000u;
+        const uint32_t exponent = (bits >> 23) & 0xFFu;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        // Infinity or NaN
+        if (exponent == 0xFFu)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u));
+        }
+
+        const int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+
+        // Overflow
+        if (halfExponent >= 0x1F)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00u);
+        }
+
+        // Subnormal or zero
+        if (halfExponent <= 0)
+        {
+            if (halfExponent < -10)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+
+            mantissa |= 0x800000u;
+            const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+            uint32_t halfMantissa = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u) != 0))
+            {
+                ++halfMantissa;
+            }
+
+            return static_cast<uint16_t>(sign | halfMantissa);
+        }
+
+        uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+        const uint32_t remainder = mantissa & 0x1FFFu;
+
+        // A carry into the exponent is the correct result (up to infinity).
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+        {
+            ++half;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    float HalfToFloat(const uint16_t half)
+    {
+        const uint32_t sign = (half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+
+        uint32_t bits;
+        if (exponent == 0x1Fu)
+        {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        }
+        else if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // normalize the subnormal
+                exponent = 127 - 15 + 1;
+                while ((mantissa & 0x400u) == 0)
+                {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+            }
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    template <typename T>
+    T FloatToSnorm(const float value)
+    {
+        constexpr float scale = static_cast<float>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::lround(std::clamp(value, -1.0f, 1.0f) * scale));
+    }
+
+    template <typename T>
+    float SnormToFloat(const T value)
+    {
+        // Both the minimum and the next value map to -1.
+        constexpr float scale = static_cast<float>(std::numeric_limits<T>::max());
+        return std::max(static_cast<float>(value) / scale, -1.0f);
+    }
+
+    template <typename T>
+    void Store(uint8_t* destination, const T* values, const uint32_t count)
+    {
+        memcpy(destination, values, count * sizeof(T));
+    }
+
+    template <typename T>
+    void Load(const uint8_t* source, T* values, const uint32_t count)
+    {
+        memcpy(values, source, count * sizeof(T));
+    }
+
+    // +1 or -1: whether the bitangent is cross(normal, tangent) or its opposite.
+    float ComputeHandedness(const float* normal, const float* tangent, const float* bitangent)
+    {
+        const float cross[3] = {
+            normal[1] * tangent[2] - normal[2] * tangent[1],
+            normal[2] * tangent[0] - normal[0] * tangent[2],
+            normal[0] * tangent[1] - normal[1] * tangent[0],
+        };
+        return cross[0] * bitangent[0] + cross[1] * bitangent[1] + cross[2] * bitangent[2] < 0.0f ? -1.0f : 1.0f;
+    }
+
+    void RebuildBitangent(const float* normal, const float* tangent, float* bitangent)
+    {
+        bitangent[0] = (normal[1] * tangent[2] - normal[2] * tangent[1]) * tangent[3];
+        bitangent[1] = (normal[2] * tangent[0] - normal[0] * tangent[2]) * tangent[3];
+        bitangent[2] = (normal[0] * tangent[1] - normal[1] * tangent[0]) * tangent[3];
+        bitangent[3] = 0.0f;
+    }
+
+    void EncodeAttribute(const VertexAttributeFormat format, const float* source, uint8_t* destination)
+    {
+        switch (format)
+        {
+        case VertexAttributeFormat::Float32x4:
+        case VertexAttributeFormat::Float32x3:
+        case VertexAttributeFormat::Float32x2:
+            Store(destination, source, VertexLayout::GetComponentCount(format));
+            break;
+        case VertexAttributeFormat::Float16x4:
+        case VertexAttributeFormat::Float16x2:
+        {
+            uint16_t values[4];
+            const uint32_t componentCount = VertexLayout::GetComponentCount(format);
+            for (uint32_t i = 0; i < componentCount; ++i)
+            {
+                values[i] = FloatToHalf(source[i]);
+            }
+            Store(destination, values, componentCount);
+            break;
+        }
+        case VertexAttributeFormat::Snorm16x4:
+        {
+            int16_t values[4];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                values[i] = FloatToSnorm<int16_t>(source[i]);
+            }
+            Store(destination, values, 4);
+            break;
+        }
+        case VertexAttributeFormat::Snorm8x4:
+        {
+            int8_t values[4];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                values[i] = FloatToSnorm<int8_t>(source[i]);
+            }
+            Store(destination, values, 4);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void DecodeAttribute(const VertexAttributeFormat format, const uint8_t* source, float* destination)
+    {
+        switch (format)
+        {
+        case VertexAttributeFormat::Float32x4:
+        case VertexAttributeFormat::Float32x3:
+        case VertexAttributeFormat::Float32x2:
+            Load(source, destination, VertexLayout::GetComponentCount(format));
+            break;
+        case VertexAttributeFormat::Float16x4:
+        case VertexAttributeFormat::Float16x2:
+        {
+            uint16_t values[4];
+            const uint32_t componentCount = VertexLayout::GetComponentCount(format);
+            Load(source, values, componentCount);
+            for (uint32_t i = 0; i < componentCount; ++i)
+            {
+                destination[i] = HalfToFloat(values[i]);
+            }
+            break;
+        }
+        case VertexAttributeFormat::Snorm16x4:
+        {
+            int16_t values[4];
+            Load(source, values, 4);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                destination[i] = SnormToFloat(values[i]);
+            }
+            break;
+        }
+        case VertexAttributeFormat::Snorm8x4:
+        {
+            int8_t values[4];
+            Load(source, values, 4);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                destination[i] = SnormToFloat(values[i]);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool VertexLayout::Unpack(const uint32_t packed, VertexLayout& layout)
+{
+    if ((packed >> (ATTRIBUTE_COUNT * 4)) != 0)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < ATTRIBUTE_COUNT; ++i)
+    {
+        const uint32_t format = (packed >> (i * 4)) & 0xFu;
+        if (format >= static_cast<uint32_t>(VertexAttributeFormat::Count) ||
+            (format == static_cast<uint32_t>(VertexAttributeFormat::None) && i != Bitangent))
+        {
+            return false;
+        }
+
+        layout.Formats[i] = static_cast<VertexAttributeFormat>(format);
+    }
+
+    return true;
+}
+
+void VertexLayout::Encode(const void* source, const size_t numVertices, void* destination) const
+{
+    const auto* sourceVertex = static_cast<const float*>(source);
+    auto* destinationVertex = static_cast<uint8_t*>(destination);
+    const uint32_t stride = GetStride();
+
+    if (*this == Full())
+    {
+        memcpy(destination, source, numVertices * SOURCE_STRIDE);
+
+        for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+        {
+            const float* normal = sourceVertex + Normal * SOURCE_COMPONENT_COUNT;
+            const float* tangent = sourceVertex + Tangent * SOURCE_COMPONENT_COUNT;
+            const float* bitangent = sourceVertex + Bitangent * SOURCE_COMPONENT_COUNT;
+            const float handedness = ComputeHandedness(normal, tangent, bitangent);
+            memcpy(destinationVertex + GetOffset(Tangent) + 3 * sizeof(float), &handedness, sizeof(handedness));
+
+            sourceVertex += ATTRIBUTE_COUNT * SOURCE_COMPONENT_COUNT;
+            destinationVertex += stride;
+        }
+
+        return;
+    }
+
+    for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    {
+        const float* normal = sourceVertex + Normal * SOURCE_COMPONENT_COUNT;
+        const float* bitangent = sourceVertex + Bitangent * SOURCE_COMPONENT_COUNT;
+        const float* sourceTangent = sourceVertex + Tangent * SOURCE_COMPONENT_COUNT;
+        const float tangent[4] = { sourceTangent[0], sourceTangent[1], sourceTangent[2], ComputeHandedness(normal, sourceTangent, bitangent) };
+
+        uint32_t offset = 0;
+        for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; ++attribute)
+        {
+            const float* values = attribute == Tangent ? tangent : sourceVertex + attribute * SOURCE_COMPONENT_COUNT;
+            EncodeAttribute(Formats[attribute], values, destinationVertex + offset);
+            offset += GetSize(Formats[attribute]);
+        }
+
+        sourceVertex += ATTRIBUTE_COUNT * SOURCE_COMPONENT_COUNT;
+        destinationVertex += stride;
+    }
+}
+
+void VertexLayout::Decode(const void* source, const size_t numVertices, void* destination) const
+{
+    if (*this == Full())
+    {
+        memcpy(destination, source, numVertices * SOURCE_STRIDE);
+        return;
+    }
+
+    const auto* sourceVertex = static_cast<const uint8_t*>(source);
+    auto* destinationVertex = static_cast<float*>(destination);
+    const uint32_t stride = GetStride();
+
+    for (size_t vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    {
+        uint32_t offset = 0;
+        for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; ++attribute)
+        {
+            float* values = destinationVertex + attribute * SOURCE_COMPONENT_COUNT;
+            values[0] = values[1] = values[2] = 0.0f;
+            values[3] = attribute == Position ? 1.0f : 0.0f;
+
+            DecodeAttribute(Formats[attribute], sourceVertex + offset, values);
+            offset += GetSize(Formats[attribute]);
+        }
+
+        if (Formats[Bitangent] == VertexAttributeFormat::None)
+        {
+            RebuildBitangent(destinationVertex + Normal * SOURCE_COMPONENT_COUNT, destinationVertex + Tangent * SOURCE_COMPONENT_COUNT,
+                destinationVertex + Bitangent * SOURCE_COMPONENT_COUNT);
+        }
+
+        sourceVertex += stride;
+        destinationVertex += ATTRIBUTE_COUNT * SOURCE_COMPONENT_COUNT;
+    }
+}
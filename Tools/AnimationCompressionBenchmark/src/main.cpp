@@ -0,0 +1,331 @@
+#include <Animation.h>
+#include <Armature.h>
+#include <CompressedAnimation.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Skeletons.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumInstances = 100;
+        uint32_t NumFrames = 600;
+        float FrameRate = 60.0f;
+        // Mixamo clips have a key per frame at 30 FPS.
+        float KeysPerSecond = 30.0f;
+        float DurationInSeconds = 4.0f;
+        CompressedAnimation::Settings Compression;
+        uint32_t Seed = 0;
+    };
+
+    struct Skeleton
+    {
+        Armature Bones;
+        std::vector<Animation::Channel> Channels;
+    };
+
+    // A smooth curve with a bit of noise, as motion capture has.
+    class Curve
+    {
+    public:
+        Curve(std::mt19937& random, const float amplitude, const float noise)
+        {
+            std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+            for (auto& wave : m_Waves)
+            {
+                wave = { amplitude * distribution(random), 0.5f + 2.0f * distribution(random), 6.28f * distribution(random) };
+            }
+
+            m_Noise = noise;
+        }
+
+        float Evaluate(const float time, std::mt19937& random) const
+        {
+            std::uniform_real_distribution<float> noiseDistribution(-m_Noise, m_Noise);
+            float value = noiseDistribution(random);
+            for (const auto& wave : m_Waves)
+            {
+                value += wave.Amplitude * std::sin(wave.Frequency * time + wave.Phase);
+            }
+            return value;
+        }
+
+    private:
+        struct Wave
+        {
+            float Amplitude;
+            float Frequency;
+            float Phase;
+        };
+
+        Wave m_Waves[2];
+        float m_Noise;
+    };
+
+    /**
+     * A chain of bones with a key per frame on every track, as exported clips have:
+     * the root moves, the other bones only rotate, some of them barely, and the scaling is constant.
+     */
+    Skeleton CreateSkeleton(const uint32_t numBones, const Settings& settings, std::mt19937& random)
+    {
+        const std::vector<Bone> bones = ToolsCommon::CreateBones(numBones);
+
+        Skeleton skeleton;
+        skeleton.Bones.SetBones(bones, ToolsCommon::CreateChainParentIndices(numBones));
+
+        const uint32_t numKeys = std::max(static_cast<uint32_t>(settings.DurationInSeconds * settings.KeysPerSecond), 2u);
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+        for (uint32_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            const bool isRoot = boneIndex == 0;
+            const float rotationAmplitude = distribution(random) < 0.25f ? 0.02f : 0.6f;
+            const Curve pitch(random, rotationAmplitude, 0.0005f);
+            const Curve yaw(random, rotationAmplitude, 0.0005f);
+            const Curve roll(random, rotationAmplitude, 0.0005f);
+            const Curve x(random, isRoot ? 50.0f : 0.0f, 0.0f);
+            const Curve z(random, isRoot ? 50.0f : 0.0f, 0.0f);
+            const float offset = isRoot ? 100.0f : 10.0f;
+
+            Animation::Channel channel;
+            channel.NodeName = bones[boneIndex].Name;
+
+            for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+            {
+                const float time = static_cast<float>(keyIndex);
+                const float seconds = time / settings.KeysPerSecond;
+
+                channel.PositionKeyFrames.push_back({ XMVectorSet(x.Evaluate(seconds, random), offset, z.Evaluate(seconds, random), 0.0f), time });
+                channel.RotationKeyFrames.push_back({ XMQuaternionRotationRollPitchYaw(pitch.Evaluate(seconds, random), yaw.Evaluate(seconds, random), roll.Evaluate(seconds, random)), time });
+                channel.ScalingKeyFrames.push_back({ XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), time });
+            }
+
+            skeleton.Channels.push_back(std::move(channel));
+        }
+
+        return skeleton;
+    }
+
+    // Keeps the samples from being optimized away.
+    float Checksum(const Animation::Pose& transforms)
+    {
+        float checksum = 0.0f;
+        for (const auto& transform : transforms)
+        {
+            checksum += XMVectorGetX(transform.Position) + XMVectorGetW(transform.Rotation);
+        }
+        return checksum;
+    }
+
+    struct Errors
+    {
+        float Position = 0.0f;
+        float Rotation = 0.0f;
+        float Scaling = 0.0f;
+    };
+
+    void AccumulateErrors(const Animation::Pose& transforms, const Animation::Pose& referenceTransforms, Errors& errors)
+    {
+        for (size_t i = 0; i < transforms.size(); ++i)
+        {
+            const auto& transform = transforms[i];
+            const auto& reference = referenceTransforms[i];
+
+            // The angle between the rotations, from the chord between the quaternions (acos of the dot product is too imprecise near 1).
+            const XMVECTOR q1 = XMQuaternionNormalize(transform.Rotation);
+            const XMVECTOR q2 = XMQuaternionNormalize(reference.Rotation);
+            const float chord = std::min(XMVectorGetX(XMVector4Length(XMVectorSubtract(q1, q2))), XMVectorGetX(XMVector4Length(XMVectorAdd(q1, q2))));
+
+            errors.Position = std::max(errors.Position, XMVectorGetX(XMVector3Length(XMVectorSubtract(transform.Position, reference.Position))));
+            errors.Rotation = std::max(errors.Rotation, 4.0f * std::asin(std::min(chord * 0.5f, 1.0f)));
+            errors.Scaling = std::max(errors.Scaling, XMVectorGetX(XMVector3Length(XMVectorSubtract(transform.Scaling, reference.Scaling))));
+        }
+    }
+
+    // Returns false if the error exceeds the bound.
+    bool RunBenchmark(const uint32_t numBones, const Settings& settings)
+    {
+        std::mt19937 random(settings.Seed);
+        const Skeleton skeleton = CreateSkeleton(numBones, settings, random);
+
+        const float ticksPerSecond = settings.KeysPerSecond;
+        const float duration = static_cast<float>(skeleton.Channels[0].PositionKeyFrames.size() - 1);
+        const Animation animation(duration, ticksPerSecond, skeleton.Channels);
+
+        CompressedAnimation compressedAnimation(0.0f, ticksPerSecond, {});
+        const double compressionTime = ToolsCommon::MeasureTime([&]()
+            {
+                compressedAnimation = CompressedAnimation(duration, ticksPerSecond, skeleton.Channels, settings.Compression);
+            });
+
+        const Animation::Binding binding = animation.Bind(skeleton.Bones);
+        const Animation::Binding compressedBinding = compressedAnimation.Bind(skeleton.Bones);
+        Animation::Pose transforms;
+        Animation::Pose referenceTransforms;
+
+        // The reconstruction error, at every frame and between them, forward and after seeks.
+        Errors errors;
+        {
+            Animation::Cursor cursor = animation.CreateCursor();
+            Animation::Cursor compressedCursor = compressedAnimation.CreateCursor();
+            std::uniform_real_distribution<double> timeDistribution(0.0, animation.GetDurationInSeconds());
+
+            const auto check = [&](const double time)
+            {
+                animation.Sample(binding, time, cursor, referenceTransforms);
+                compressedAnimation.Sample(compressedBinding, time, compressedCursor, transforms);
+                AccumulateErrors(transforms, referenceTransforms, errors);
+            };
+
+            const double timeStep = 1.0 / (4.0 * settings.KeysPerSecond);
+            for (double time = 0.0; time <= animation.GetDurationInSeconds(); time += timeStep)
+            {
+                check(time);
+            }
+
+            for (uint32_t i = 0; i < 1000; ++i)
+            {
+                check(timeDistribution(random));
+            }
+        }
+
+        // Every instance plays the clip from a different point.
+        std::uniform_real_distribution<double> phaseDistribution(0.0, settings.DurationInSeconds);
+        std::vector<double> phases(settings.NumInstances);
+        for (auto& phase : phases)
+        {
+            phase = phaseDistribution(random);
+        }
+
+        std::vector<Animation::Cursor> cursors(settings.NumInstances, animation.CreateCursor());
+        std::vector<Animation::Cursor> compressedCursors(settings.NumInstances, compressedAnimation.CreateCursor());
+
+        float checksum = 0.0f;
+        const auto forEachSample = [&](auto&& sample)
+        {
+            for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+            {
+                const double time = frame / static_cast<double>(settings.FrameRate);
+                for (uint32_t instance = 0; instance < settings.NumInstances; ++instance)
+                {
+                    sample(instance, time + phases[instance]);
+                }
+            }
+        };
+
+        const double uncompressedTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](const uint32_t instance, const double time)
+                    {
+                        animation.Sample(binding, time, cursors[instance], transforms);
+                        checksum += Checksum(transforms);
+                    });
+            });
+
+        const double compressedTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](const uint32_t instance, const double time)
+                    {
+                        compressedAnimation.Sample(compressedBinding, time, compressedCursors[instance], transforms);
+                        checksum += Checksum(transforms);
+                    });
+            });
+
+        const double numSamples = static_cast<double>(settings.NumFrames) * settings.NumInstances;
+        const auto perSample = [numSamples](const double time)
+        {
+            return time * 1000.0 / numSamples;
+        };
+
+        std::cout << "Bones: " << numBones
+            << ", memory: " << animation.GetMemorySize() / 1024.0 << " KiB (" << animation.GetKeyCount() << " keys)"
+            << " -> " << compressedAnimation.GetMemorySize() / 1024.0 << " KiB (" << compressedAnimation.GetKeyCount() << " keys)"
+            << " x" << static_cast<double>(animation.GetMemorySize()) / compressedAnimation.GetMemorySize()
+            << ", compression " << compressionTime << " ms" << std::endl;
+        std::cout << "    per sample: uncompressed " << perSample(uncompressedTime) << " us"
+            << ", compressed " << perSample(compressedTime) << " us (x" << uncompressedTime / compressedTime << ")"
+            << " [checksum " << checksum << "]" << std::endl;
+        std::cout << "    max error: position " << errors.Position << ", rotation " << errors.Rotation << " rad, scaling " << errors.Scaling << std::endl;
+
+        /**
+         * The tolerances are guaranteed at the keys and halfway between them (or the quantization step of the track if it is larger).
+         * Elsewhere, nlerp between the kept keys and slerp between the source keys can differ slightly more.
+         * The root moves over about 200 units: 16-bit quantization of that range is within the default position tolerance.
+         */
+        constexpr float ERROR_BOUND_FACTOR = 2.0f;
+        const auto& compression = settings.Compression;
+        const bool withinBounds =
+            errors.Position <= compression.PositionTolerance * ERROR_BOUND_FACTOR &&
+            errors.Rotation <= compression.RotationTolerance * ERROR_BOUND_FACTOR &&
+            errors.Scaling <= compression.ScalingTolerance * ERROR_BOUND_FACTOR;
+
+        if (!withinBounds)
+        {
+            std::cerr << "The reconstruction error exceeds " << ERROR_BOUND_FACTOR << "x the tolerance." << std::endl;
+        }
+
+        return withinBounds;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> boneCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: AnimationCompressionBenchmark [--bones <count>...] [--instances <count>] [--frames <count>] [--keys-per-second <count>] [--position-tolerance <units>] [--rotation-tolerance <radians>] [--seed <value>]");
+    commandLine.AddOption("--bones", boneCounts, 1u);
+    commandLine.AddOption("--instances", settings.NumInstances, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--keys-per-second", settings.KeysPerSecond, 1.0f);
+    commandLine.AddOption("--position-tolerance", settings.Compression.PositionTolerance);
+    commandLine.AddOption("--rotation-tolerance", settings.Compression.RotationTolerance);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (boneCounts.empty())
+    {
+        boneCounts = { 16, 32, 65, 128, 256 };
+    }
+
+    try
+    {
+        std::cout << "Instances: " << settings.NumInstances << ", frames: " << settings.NumFrames << ", keys per second: " << settings.KeysPerSecond
+            << ", tolerances: position " << settings.Compression.PositionTolerance << ", rotation " << settings.Compression.RotationTolerance << " rad" << std::endl;
+
+        bool withinBounds = true;
+        for (const uint32_t numBones : boneCounts)
+        {
+            withinBounds &= RunBenchmark(numBones, settings);
+        }
+
+        if (!withinBounds)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include <CookedAnimationFile.h>
+#include <ModelCooker.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+
+    struct Settings
+    {
+        uint32_t MaxClips = 64;
+        // A Mixamo skeleton has about 65 bones.
+        uint32_t NumBones = 65;
+        uint32_t NumKeys = 60;
+        uint32_t NumIterations = 3;
+    };
+
+    std::string EncodeBase64(const std::vector<uint8_t>& bytes)
+    {
+        constexpr char DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string result;
+        result.reserve((bytes.size() + 2) / 3 * 4);
+
+        for (size_t i = 0; i < bytes.size(); i += 3)
+        {
+            const size_t remaining = std::min<size_t>(bytes.size() - i, 3);
+
+            uint32_t value = static_cast<uint32_t>(bytes[i]) << 16;
+            if (remaining > 1)
+            {
+                value |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+            }
+            if (remaining > 2)
+            {
+                value |= bytes[i + 2];
+            }
+
+            result += DIGITS[(value >> 18) & 0x3F];
+            result += DIGITS[(value >> 12) & 0x3F];
+            result += remaining > 1 ? DIGITS[(value >> 6) & 0x3F] : '=';
+            result += remaining > 2 ? DIGITS[value & 0x3F] : '=';
+        }
+
+        return result;
+    }
+
+    void AppendFloats(std::vector<uint8_t>& bytes, std::initializer_list<float> values)
+    {
+        for (const float value : values)
+        {
+            const auto* valueBytes = reinterpret_cast<const uint8_t*>(&value);
+            bytes.insert(bytes.end(), valueBytes, valueBytes + sizeof(float));
+        }
+    }
+
+    std::string GetClipName(const uint32_t clipIndex)
+    {
+        return "Clip" + std::to_string(clipIndex);
+    }
+
+    /**
+     * A glTF file with a chain of bones, animated by every clip (translation and rotation of every bone, with distinct values per clip).
+     * The buffer is embedded as a data URI, so the file is self-contained.
+     */
+    void WriteSyntheticModel(const std::filesystem::path& path, const uint32_t numClips, const Settings& settings)
+    {
+        const uint32_t numKeys = std::max(settings.NumKeys, 2u);
+        const float duration = static_cast<float>(numKeys - 1) / 30.0f;
+
+        std::vector<uint8_t> buffer;
+        for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+        {
+            AppendFloats(buffer, { static_cast<float>(keyIndex) / 30.0f });
+        }
+
+        std::ostringstream accessors;
+        std::ostringstream animations;
+
+        accessors << R"({"bufferView":0,"componentType":5126,"count":)" << numKeys << R"(,"type":"SCALAR","min":[0],"max":[)" << duration << "]}";
+        uint32_t numAccessors = 1;
+
+        for (uint32_t clipIndex = 0; clipIndex < numClips; ++clipIndex)
+        {
+            std::ostringstream samplers;
+            std::ostringstream channels;
+
+            for (uint32_t boneIndex = 0; boneIndex < settings.NumBones; ++boneIndex)
+            {
+                const float phase = static_cast<float>(clipIndex * settings.NumBones + boneIndex);
+
+                const size_t translationsOffset = buffer.size();
+                for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+                {
+                    const float angle = 2.0f * PI * static_cast<float>(keyIndex) / static_cast<float>(numKeys - 1) + phase;
+                    AppendFloats(buffer, { std::sin(angle) * 0.1f, 1.0f, std::cos(angle) * 0.1f });
+                }
+
+                const size_t rotationsOffset = buffer.size();
+                for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+                {
+                    const float halfAngle = 0.5f * std::sin(2.0f * PI * static_cast<float>(keyIndex) / static_cast<float>(numKeys - 1) + phase);
+                    AppendFloats(buffer, { std::sin(halfAngle), 0.0f, 0.0f, std::cos(halfAngle) });
+                }
+
+                accessors << R"(,{"bufferView":0,"byteOffset":)" << translationsOffset << R"(,"componentType":5126,"count":)" << numKeys << R"(,"type":"VEC3"})";
+                accessors << R"(,{"bufferView":0,"byteOffset":)" << rotationsOffset << R"(,"componentType":5126,"count":)" << numKeys << R"(,"type":"VEC4"})";
+
+                const uint32_t samplerIndex = boneIndex * 2;
+                samplers << (boneIndex > 0 ? "," : "")
+                    << R"({"input":0,"output":)" << numAccessors << R"(,"interpolation":"LINEAR"},)"
+                    << R"({"input":0,"output":)" << numAccessors + 1 << R"(,"interpolation":"LINEAR"})";
+                channels << (boneIndex > 0 ? "," : "")
+                    << R"({"sampler":)" << samplerIndex << R"(,"target":{"node":)" << boneIndex << R"(,"path":"translation"}},)"
+                    << R"({"sampler":)" << samplerIndex + 1 << R"(,"target":{"node":)" << boneIndex << R"(,"path":"rotation"}})";
+
+                numAccessors += 2;
+            }
+
+            animations << (clipIndex > 0 ? "," : "")
+                << R"({"name":")" << GetClipName(clipIndex) << R"(","samplers":[)" << samplers.str() << R"(],"channels":[)" << channels.str() << "]}";
+        }
+
+        std::ostringstream nodes;
+        for (uint32_t boneIndex = 0; boneIndex < settings.NumBones; ++boneIndex)
+        {
+            nodes << (boneIndex > 0 ? "," : "") << R"({"name":"Bone)" << boneIndex << '"';
+            if (boneIndex + 1 < settings.NumBones)
+            {
+                nodes << R"(,"children":[)" << boneIndex + 1 << "]";
+            }
+            nodes << "}";
+        }
+
+        std::ofstream stream(path, std::ios::trunc);
+        stream << R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],)"
+            << R"("nodes":[)" << nodes.str() << "],"
+            << R"("buffers":[{"byteLength":)" << buffer.size() << R"(,"uri":"data:application/octet-stream;base64,)" << EncodeBase64(buffer) << R"("}],)"
+            << R"("bufferViews":[{"buffer":0,"byteLength":)" << buffer.size() << "}],"
+            << R"("accessors":[)" << accessors.str() << "],"
+            << R"("animations":[)" << animations.str() << "]}";
+
+        if (!stream)
+        {
+            throw std::runtime_error("Failed to write " + path.string());
+        }
+    }
+
+    // What loading a clip used to cost: the whole file is parsed again for every clip.
+    size_t ImportClip(const std::string& path, const std::string& clipName)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path.c_str(), aiProcess_ConvertToLeftHanded);
+
+        if (scene == nullptr)
+        {
+            throw std::runtime_error(importer.GetErrorString());
+        }
+
+        for (unsigned int animationIndex = 0; animationIndex < scene->mNumAnimations; ++animationIndex)
+        {
+            const auto& animation = *scene->mAnimations[animationIndex];
+            if (clipName != animation.mName.C_Str())
+            {
+                continue;
+            }
+
+            size_t numKeys = 0;
+            for (unsigned int channelIndex = 0; channelIndex < animation.mNumChannels; ++channelIndex)
+            {
+                const auto& channel = *animation.mChannels[channelIndex];
+                numKeys += channel.mNumPositionKeys + channel.mNumRotationKeys + channel.mNumScalingKeys;
+            }
+
+            return numKeys;
+        }
+
+        throw std::runtime_error("The clip " + clipName + " was not found.");
+    }
+
+    template <typename TFunction>
+    double MeasureBestTime(const uint32_t numIterations, TFunction&& function)
+    {
+        double bestTime = std::numeric_limits<double>::max();
+
+        for (uint32_t iteration = 0; iteration < std::max(numIterations, 1u); ++iteration)
+        {
+            bestTime = std::min(bestTime, ToolsCommon::MeasureTime(function));
+        }
+
+        return bestTime;
+    }
+
+    /**
+     * Reports, for all the clips of the file: a parse per clip (the previous loader), a single pass (ModelCooker::ImportAnimations),
+     * and reading the cooked clips.
+     */
+    void RunBenchmark(const std::filesystem::path& path, const Settings& settings)
+    {
+        const auto sourcePath = path.string();
+        const auto cookedPath = std::filesystem::temp_directory_path() / (path.filename().string() + ".animations");
+
+        CookedAnimationFile file;
+        const double singlePassTime = MeasureBestTime(settings.NumIterations, [&]()
+            {
+                file = ModelCooker::ImportAnimations(sourcePath);
+            });
+
+        size_t numKeys = 0;
+        const double perClipTime = MeasureBestTime(settings.NumIterations, [&]()
+            {
+                numKeys = 0;
+                for (const auto& clip : file.m_Clips)
+                {
+                    numKeys += ImportClip(sourcePath, clip.Name);
+                }
+            });
+
+        file.Write(cookedPath);
+
+        CookedAnimationFile cookedFile;
+        const double cookedTime = MeasureBestTime(settings.NumIterations, [&]()
+            {
+                if (!cookedFile.Read(cookedPath))
+                {
+                    throw std::runtime_error("Failed to read the cooked clips.");
+                }
+            });
+
+        if (cookedFile.m_Clips.size() != file.m_Clips.size())
+        {
+            throw std::runtime_error("The cooked clips do not match the imported ones.");
+        }
+
+        std::cout << path.filename().string() << ": clips " << file.m_Clips.size() << ", keys " << numKeys
+            << ", source " << std::filesystem::file_size(path) / 1024 << " KiB, cooked " << std::filesystem::file_size(cookedPath) / 1024 << " KiB"
+            << ", per clip " << perClipTime << " ms, single pass " << singlePassTime << " ms (x" << perClipTime / std::max(singlePassTime, 1e-6) << ")"
+            << ", cooked " << cookedTime << " ms (x" << perClipTime / std::max(cookedTime, 1e-6) << ")" << std::endl;
+
+        std::filesystem::remove(cookedPath);
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<std::filesystem::path> paths;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: AnimationImportBenchmark [<model>...] [--max-clips <count>] [--bones <count>] [--keys <count>] [--iterations <count>]\n"
+        "       Without models, synthetic glTF files with 1, 2, 4, ... clips are generated.");
+    commandLine.AddOption("--max-clips", settings.MaxClips, 1u);
+    commandLine.AddOption("--bones", settings.NumBones, 1u);
+    commandLine.AddOption("--keys", settings.NumKeys);
+    commandLine.AddOption("--iterations", settings.NumIterations);
+    commandLine.AddPositional(paths);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        if (!paths.empty())
+        {
+            for (const auto& path : paths)
+            {
+                RunBenchmark(path, settings);
+            }
+
+            return 0;
+        }
+
+        std::cout << "Bones: " << settings.NumBones << ", keys per channel: " << std::max(settings.NumKeys, 2u) << std::endl;
+
+        for (uint32_t numClips = 1; ; numClips = std::min(numClips * 2, settings.MaxClips))
+        {
+            const auto path = std::filesystem::temp_directory_path() / ("AnimationImportBenchmark_" + std::to_string(numClips) + ".gltf");
+            WriteSyntheticModel(path, numClips, settings);
+            RunBenchmark(path, settings);
+            std::filesystem::remove(path);
+
+            if (numClips == settings.MaxClips)
+            {
+                break;
+            }
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
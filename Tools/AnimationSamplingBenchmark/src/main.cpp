@@ -0,0 +1,386 @@
+#include <Animation.h>
+#include <AnimationBlendTree.h>
+#include <Armature.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/CountingAllocator.h>
+#include <ToolsCommon/Skeletons.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumInstances = 100;
+        uint32_t NumFrames = 600;
+        float FrameRate = 60.0f;
+        // Mixamo clips have a key per frame at 30 FPS.
+        float KeysPerSecond = 30.0f;
+        float DurationInSeconds = 4.0f;
+        uint32_t Seed = 0;
+    };
+
+    struct Skeleton
+    {
+        Armature Bones;
+        std::vector<Animation::Channel> Channels;
+    };
+
+    // A chain of bones, with a channel per bone and a few channels for nodes that are not bones (as exported clips have).
+    Skeleton CreateSkeleton(const uint32_t numBones, const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+        const std::vector<Bone> bones = ToolsCommon::CreateBones(numBones);
+
+        Skeleton skeleton;
+        skeleton.Bones.SetBones(bones, ToolsCommon::CreateChainParentIndices(numBones));
+
+        const uint32_t numKeys = std::max(static_cast<uint32_t>(settings.DurationInSeconds * settings.KeysPerSecond), 2u);
+        const uint32_t numChannels = numBones + numBones / 16;
+
+        for (uint32_t channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+        {
+            Animation::Channel channel;
+            channel.NodeName = "mixamorig:" + std::string(channelIndex < numBones ? "Bone" : "Node") + std::to_string(channelIndex);
+
+            for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+            {
+                const float time = static_cast<float>(keyIndex);
+                channel.PositionKeyFrames.push_back({ XMVectorSet(distribution(random), distribution(random), distribution(random), 0.0f), time });
+                channel.RotationKeyFrames.push_back({ XMQuaternionNormalize(XMVectorSet(distribution(random), distribution(random), distribution(random), 1.0f)), time });
+            }
+
+            // Scaling is usually constant.
+            channel.ScalingKeyFrames.push_back({ XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), 0.0f });
+            skeleton.Channels.push_back(std::move(channel));
+        }
+
+        return skeleton;
+    }
+
+    /**
+     * What the sampling used to cost: the keys are found with a linear scan, the bones are looked up by name,
+     * and the animated bones are tracked in a set.
+     */
+    class LegacySampler
+    {
+    public:
+        LegacySampler(const float ticksPerSecond, const float duration, const std::vector<Animation::Channel>& channels)
+            : m_TicksPerSecond(ticksPerSecond)
+            , m_Duration(duration)
+            , m_Channels(channels)
+        {}
+
+        std::vector<Animation::BoneTransform> Sample(const Armature& armature, const double time) const
+        {
+            const auto normalizedTime = static_cast<float>(std::fmod(time * m_TicksPerSecond, m_Duration));
+
+            std::vector<Animation::BoneTransform> transforms(armature.GetBones().size());
+            std::set<size_t> affectedBones;
+
+            for (const auto& channel : m_Channels)
+            {
+                if (!armature.HasBone(channel.NodeName))
+                {
+                    continue;
+                }
+
+                const size_t boneIndex = armature.GetBoneIndex(channel.NodeName);
+                affectedBones.insert(boneIndex);
+
+                transforms[boneIndex] = {
+                    Interpolate(channel.PositionKeyFrames, normalizedTime, false),
+                    Interpolate(channel.RotationKeyFrames, normalizedTime, true),
+                    Interpolate(channel.ScalingKeyFrames, normalizedTime, false),
+                };
+            }
+
+            for (size_t boneIndex = 0; boneIndex < transforms.size(); ++boneIndex)
+            {
+                if (!affectedBones.contains(boneIndex))
+                {
+                    transforms[boneIndex] = { XMVectorZero(), XMQuaternionIdentity(), XMVectorSet(1, 1, 1, 0) };
+                }
+            }
+
+            return transforms;
+        }
+
+    private:
+        static XMVECTOR Interpolate(const std::vector<Animation::KeyFrame>& keyFrames, const float time, const bool isRotation)
+        {
+            if (keyFrames.size() == 1)
+            {
+                return keyFrames[0].Value;
+            }
+
+            for (size_t i = 0; i < keyFrames.size() - 1; ++i)
+            {
+                if (time < keyFrames[i + 1].NormalizedTime)
+                {
+                    const float t = (time - keyFrames[i].NormalizedTime) / (keyFrames[i + 1].NormalizedTime - keyFrames[i].NormalizedTime);
+                    return isRotation ? XMQuaternionSlerp(keyFrames[i].Value, keyFrames[i + 1].Value, t) : XMVectorLerp(keyFrames[i].Value, keyFrames[i + 1].Value, t);
+                }
+            }
+
+            return keyFrames.back().Value;
+        }
+
+        float m_TicksPerSecond;
+        float m_Duration;
+        std::vector<Animation::Channel> m_Channels;
+    };
+
+    // How the poses used to be blended: every operation returns a new pose and the mask is a set.
+    std::vector<Animation::BoneTransform> LegacyBlend(const std::vector<Animation::BoneTransform>& transforms1, const std::vector<Animation::BoneTransform>& transforms2, const float weight)
+    {
+        std::vector<Animation::BoneTransform> result(transforms1.size());
+        for (size_t i = 0; i < transforms1.size(); ++i)
+        {
+            result[i] = {
+                XMVectorLerp(transforms1[i].Position, transforms2[i].Position, weight),
+                XMQuaternionSlerp(transforms1[i].Rotation, transforms2[i].Rotation, weight),
+                XMVectorLerp(transforms1[i].Scaling, transforms2[i].Scaling, weight),
+            };
+        }
+        return result;
+    }
+
+    std::vector<Animation::BoneTransform> LegacyApplyMask(const std::vector<Animation::BoneTransform>& transforms1, const std::vector<Animation::BoneTransform>& transforms2, const std::set<size_t>& mask)
+    {
+        std::vector<Animation::BoneTransform> result(transforms1.size());
+        for (size_t i = 0; i < transforms1.size(); ++i)
+        {
+            result[i] = mask.contains(i) ? transforms1[i] : transforms2[i];
+        }
+        return result;
+    }
+
+    // Spends some time on exact values of 0 and 1, as the demo does.
+    float GetBlendWeight(const double time)
+    {
+        return std::clamp(static_cast<float>(std::sin(time * 2.0)) * 0.75f + 0.5f, 0.0f, 1.0f);
+    }
+
+    // Keeps the samples from being optimized away.
+    float Checksum(const std::vector<Animation::BoneTransform>& transforms)
+    {
+        float checksum = 0.0f;
+        for (const auto& transform : transforms)
+        {
+            checksum += XMVectorGetX(transform.Position) + XMVectorGetW(transform.Rotation);
+        }
+        return checksum;
+    }
+
+    // Returns the number of allocations in the steady state of the allocation-free paths.
+    uint64_t RunBenchmark(const uint32_t numBones, const Settings& settings)
+    {
+        std::mt19937 random(settings.Seed);
+        const Skeleton skeleton = CreateSkeleton(numBones, settings, random);
+
+        const float ticksPerSecond = settings.KeysPerSecond;
+        const float duration = static_cast<float>(skeleton.Channels[0].PositionKeyFrames.size() - 1);
+        const Animation animation(duration, ticksPerSecond, skeleton.Channels);
+        const LegacySampler legacySampler(ticksPerSecond, duration, skeleton.Channels);
+
+        // Every instance plays the clip from a different point.
+        std::uniform_real_distribution<double> phaseDistribution(0.0, settings.DurationInSeconds);
+        std::vector<double> phases(settings.NumInstances);
+        for (auto& phase : phases)
+        {
+            phase = phaseDistribution(random);
+        }
+
+        const Animation::Binding binding = animation.Bind(skeleton.Bones);
+        std::vector<Animation::Cursor> cursors(settings.NumInstances, animation.CreateCursor());
+        std::vector<Animation::BoneTransform> transforms;
+
+        float checksum = 0.0f;
+        const auto forEachSample = [&](auto&& sample)
+        {
+            for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+            {
+                const double time = frame / static_cast<double>(settings.FrameRate);
+                for (uint32_t instance = 0; instance < settings.NumInstances; ++instance)
+                {
+                    sample(instance, time + phases[instance]);
+                }
+            }
+        };
+
+        const double legacyTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](uint32_t, const double time)
+                    {
+                        checksum += Checksum(legacySampler.Sample(skeleton.Bones, time));
+                    });
+            });
+
+        const double searchTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](uint32_t, const double time)
+                    {
+                        animation.Sample(binding, time, transforms);
+                        checksum += Checksum(transforms);
+                    });
+            });
+
+        const double cursorTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](const uint32_t instance, const double time)
+                    {
+                        animation.Sample(binding, time, cursors[instance], transforms);
+                        checksum += Checksum(transforms);
+                    });
+            });
+
+        const double numSamples = static_cast<double>(settings.NumFrames) * settings.NumInstances;
+        const auto perSample = [numSamples](const double time)
+        {
+            return time * 1000.0 / numSamples;
+        };
+
+        std::cout << "Bones: " << numBones << ", channels " << skeleton.Channels.size()
+            << ", per sample: legacy " << perSample(legacyTime) << " us"
+            << ", binary search " << perSample(searchTime) << " us (x" << legacyTime / searchTime << ")"
+            << ", cursor " << perSample(cursorTime) << " us (x" << legacyTime / cursorTime << ")"
+            << " [checksum " << checksum << "]" << std::endl;
+
+        // The demo's tree: a run/idle blend with the upper half of the chain overridden by a third clip.
+        const auto runAnimation = std::make_shared<const Animation>(duration, ticksPerSecond, skeleton.Channels);
+        const auto idleAnimation = std::make_shared<const Animation>(duration, ticksPerSecond, CreateSkeleton(numBones, settings, random).Channels);
+        const auto topAnimation = std::make_shared<const Animation>(duration, ticksPerSecond, CreateSkeleton(numBones, settings, random).Channels);
+        const BoneMask topMask = Animation::BuildMask(skeleton.Bones, skeleton.Bones.GetBone(numBones / 2).Name);
+
+        std::set<size_t> legacyTopMask;
+        for (size_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            if (topMask.Contains(boneIndex))
+            {
+                legacyTopMask.insert(boneIndex);
+            }
+        }
+
+        const auto playbackBinding = runAnimation->Bind(skeleton.Bones);
+        std::vector<Animation::Cursor> runCursors(settings.NumInstances, runAnimation->CreateCursor());
+        std::vector<Animation::Cursor> idleCursors(settings.NumInstances, idleAnimation->CreateCursor());
+        std::vector<Animation::Cursor> topCursors(settings.NumInstances, topAnimation->CreateCursor());
+        std::vector<Animation::BoneTransform> runTransforms, idleTransforms, topTransforms;
+
+        std::vector<AnimationBlendTree> blendTrees;
+        blendTrees.reserve(settings.NumInstances);
+        AnimationBlendTree::NodeId locomotionNode = 0;
+        for (uint32_t instance = 0; instance < settings.NumInstances; ++instance)
+        {
+            auto& blendTree = blendTrees.emplace_back(skeleton.Bones);
+            const auto run = blendTree.AddClip(runAnimation);
+            const auto idle = blendTree.AddClip(idleAnimation);
+            locomotionNode = blendTree.AddBlend({ run, idle }, { 1.0f, 0.0f });
+            const auto top = blendTree.AddClip(topAnimation);
+            blendTree.AddMask(top, locomotionNode, topMask);
+        }
+
+        const double legacyBlendTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample([&](const uint32_t instance, const double time)
+                    {
+                        runAnimation->Sample(playbackBinding, time, runCursors[instance], runTransforms);
+                        idleAnimation->Sample(playbackBinding, time, idleCursors[instance], idleTransforms);
+                        topAnimation->Sample(playbackBinding, time, topCursors[instance], topTransforms);
+
+                        auto blended = LegacyBlend(runTransforms, idleTransforms, GetBlendWeight(time));
+                        blended = LegacyApplyMask(topTransforms, blended, legacyTopMask);
+                        checksum += Checksum(blended);
+                    });
+            });
+
+        Animation::Pose pose;
+        const auto evaluateBlendTree = [&](const uint32_t instance, const double time)
+        {
+            const float weight = GetBlendWeight(time);
+            blendTrees[instance].SetWeight(locomotionNode, 0, 1.0f - weight);
+            blendTrees[instance].SetWeight(locomotionNode, 1, weight);
+            blendTrees[instance].Evaluate(time, pose);
+            checksum += Checksum(pose);
+        };
+
+        // Warm up, so that the output has the capacity.
+        evaluateBlendTree(0, 0.0);
+
+        const uint64_t numAllocationsBefore = ToolsCommon::g_NumAllocations;
+        const double blendTreeTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachSample(evaluateBlendTree);
+            });
+        const uint64_t numAllocations = ToolsCommon::g_NumAllocations - numAllocationsBefore;
+
+        std::cout << "    blend: legacy " << perSample(legacyBlendTime) << " us"
+            << ", blend tree " << perSample(blendTreeTime) << " us (x" << legacyBlendTime / blendTreeTime << ")"
+            << ", allocations in steady state " << numAllocations
+            << " [checksum " << checksum << "]" << std::endl;
+
+        return numAllocations;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> boneCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: AnimationSamplingBenchmark [--bones <count>...] [--instances <count>] [--frames <count>] [--keys-per-second <count>] [--seed <value>]");
+    commandLine.AddOption("--bones", boneCounts, 1u);
+    commandLine.AddOption("--instances", settings.NumInstances, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--keys-per-second", settings.KeysPerSecond, 1.0f);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (boneCounts.empty())
+    {
+        boneCounts = { 16, 32, 65, 128, 256 };
+    }
+
+    try
+    {
+        std::cout << "Instances: " << settings.NumInstances << ", frames: " << settings.NumFrames << ", keys per second: " << settings.KeysPerSecond << std::endl;
+
+        uint64_t numAllocations = 0;
+        for (const uint32_t numBones : boneCounts)
+        {
+            numAllocations += RunBenchmark(numBones, settings);
+        }
+
+        if (numAllocations != 0)
+        {
+            std::cerr << "The blend tree has allocated " << numAllocations << " times in the steady state." << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
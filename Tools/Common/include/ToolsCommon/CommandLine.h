@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ToolsCommon
+{
+    namespace Detail
+    {
+        // The type of a value and how it is stored: assigned, or appended to a std::vector.
+        template <typename T>
+        struct OptionValue
+        {
+            using Type = T;
+
+            static void Set(T& value, Type element)
+            {
+                value = std::move(element);
+            }
+        };
+
+        template <typename T>
+        struct OptionValue<std::vector<T>>
+        {
+            using Type = T;
+
+            static void Set(std::vector<T>& values, Type element)
+            {
+                values.push_back(std::move(element));
+            }
+        };
+    }
+
+    /**
+     * The arguments of a tool: "--name <value>" options, "--name" flags, and positional arguments (the ones not starting with "--").
+     * The options write to the variables they are added with, which must outlive the parsing.
+     */
+    class CommandLine
+    {
+    public:
+        // Returns false if the value is invalid.
+        using Handler = std::function<bool(std::string_view)>;
+
+        // Printed as is on an invalid command line (e.g., "Usage: Tool [--frames <count>]").
+        explicit CommandLine(std::string usage)
+            : m_Usage(std::move(usage))
+        {
+        }
+
+        CommandLine& AddFlag(const std::string_view name, bool& value, const bool valueIfPresent = true)
+        {
+            m_Options.push_back({ std::string(name), false, [&value, valueIfPresent](std::string_view)
+            {
+                value = valueIfPresent;
+                return true;
+            } });
+            return *this;
+        }
+
+        // A number, clamped to [min, max]. For a std::vector, every occurrence of the option appends a value.
+        template <typename T>
+            requires std::is_arithmetic_v<typename Detail::OptionValue<T>::Type>
+        CommandLine& AddOption(const std::string_view name, T& value,
+                               const std::type_identity_t<typename Detail::OptionValue<T>::Type> min = std::numeric_limits<typename Detail::OptionValue<T>::Type>::lowest(),
+                               const std::type_identity_t<typename Detail::OptionValue<T>::Type> max = std::numeric_limits<typename Detail::OptionValue<T>::Type>::max())
+        {
+            return AddOption(name, [&value, min, max](const std::string_view text)
+            {
+                typename Detail::OptionValue<T>::Type number;
+                const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+                if (error != std::errc() || end != text.data() + text.size())
+                {
+                    return false;
+                }
+
+                Detail::OptionValue<T>::Set(value, std::clamp(number, min, max));
+                return true;
+            });
+        }
+
+        // A string or a path.
+        template <typename T>
+            requires (!std::is_arithmetic_v<typename Detail::OptionValue<T>::Type> && std::constructible_from<typename Detail::OptionValue<T>::Type, std::string_view>)
+        CommandLine& AddOption(const std::string_view name, T& value)
+        {
+            return AddOption(name, [&value](const std::string_view text)
+            {
+                Detail::OptionValue<T>::Set(value, typename Detail::OptionValue<T>::Type(text));
+                return true;
+            });
+        }
+
+        CommandLine& AddOption(const std::string_view name, Handler handler)
+        {
+            m_Options.push_back({ std::string(name), true, std::move(handler) });
+            return *this;
+        }
+
+        template <typename T>
+        CommandLine& AddPositional(std::vector<T>& values)
+        {
+            return AddPositional([&values](const std::string_view text)
+            {
+                values.emplace_back(text);
+                return true;
+            });
+        }
+
+        CommandLine& AddPositional(Handler handler)
+        {
+            m_PositionalHandler = std::move(handler);
+            return *this;
+        }
+
+        // Prints the usage and returns false if an argument is unknown or its value is missing or invalid.
+        bool Parse(const int argc, const char* const* argv) const
+        {
+            for (int i = 1; i < argc; ++i)
+            {
+                const std::string_view argument = argv[i];
+
+                if (!argument.starts_with("--"))
+                {
+                    if (!m_PositionalHandler || !m_PositionalHandler(argument))
+                    {
+                        return Fail("Unexpected argument: " + std::string(argument));
+                    }
+                    continue;
+                }
+
+                const auto option = std::find_if(m_Options.begin(), m_Options.end(), [argument](const Option& option)
+                {
+                    return option.Name == argument;
+                });
+                if (option == m_Options.end())
+                {
+                    return Fail("Unknown option: " + std::string(argument));
+                }
+
+                if (!option->HasValue)
+                {
+                    option->Handle({});
+                    continue;
+                }
+
+                if (i + 1 >= argc)
+                {
+                    return Fail("Missing value for " + option->Name);
+                }
+
+                const std::string_view value = argv[++i];
+                if (!option->Handle(value))
+                {
+                    return Fail("Invalid value for " + option->Name + ": " + std::string(value));
+                }
+            }
+
+            return true;
+        }
+
+        void PrintUsage() const
+        {
+            std::cerr << m_Usage << std::endl;
+        }
+
+    private:
+        struct Option
+        {
+            std::string Name;
+            bool HasValue;
+            Handler Handle;
+        };
+
+        bool Fail(const std::string& message) const
+        {
+            std::cerr << message << std::endl;
+            PrintUsage();
+            return false;
+        }
+
+        std::string m_Usage;
+        std::vector<Option> m_Options;
+        Handler m_PositionalHandler;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Replaces the global operator new and delete to count the allocations, to check that a steady state does not allocate.
+ * Defines the replacement functions, so it must be included by a single translation unit of a tool.
+ */
+namespace ToolsCommon
+{
+    inline std::atomic<uint64_t> g_NumAllocations = 0;
+
+    inline void* Allocate(const std::size_t size)
+    {
+        ++g_NumAllocations;
+        if (void* memory = std::malloc(size != 0 ? size : 1))
+        {
+            return memory;
+        }
+        throw std::bad_alloc();
+    }
+
+    inline void* AllocateAligned(const std::size_t size, const std::align_val_t alignment)
+    {
+        ++g_NumAllocations;
+        const auto alignmentInBytes = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+        void* memory = _aligned_malloc(size != 0 ? size : 1, alignmentInBytes);
+#else
+        void* memory = std::aligned_alloc(alignmentInBytes, (std::max<std::size_t>(size, 1) + alignmentInBytes - 1) / alignmentInBytes * alignmentInBytes);
+#endif
+        if (memory != nullptr)
+        {
+            return memory;
+        }
+        throw std::bad_alloc();
+    }
+
+    inline void FreeAligned(void* memory)
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+void* operator new(const std::size_t size) { return ToolsCommon::Allocate(size); }
+void* operator new[](const std::size_t size) { return ToolsCommon::Allocate(size); }
+void* operator new(const std::size_t size, const std::align_val_t alignment) { return ToolsCommon::AllocateAligned(size, alignment); }
+void* operator new[](const std::size_t size, const std::align_val_t alignment) { return ToolsCommon::AllocateAligned(size, alignment); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { ToolsCommon::FreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { ToolsCommon::FreeAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { ToolsCommon::FreeAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { ToolsCommon::FreeAligned(memory); }
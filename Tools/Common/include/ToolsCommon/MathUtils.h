@@ -0,0 +1,17 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstring>
+
+namespace ToolsCommon
+{
+    // Bitwise, for results that must not change at all (e.g., a cached matrix against a recomputed one).
+    inline bool AreEqual(const DirectX::XMMATRIX& matrix1, const DirectX::XMMATRIX& matrix2)
+    {
+        DirectX::XMFLOAT4X4 values1, values2;
+        DirectX::XMStoreFloat4x4(&values1, matrix1);
+        DirectX::XMStoreFloat4x4(&values2, matrix2);
+        return std::memcmp(&values1, &values2, sizeof(DirectX::XMFLOAT4X4)) == 0;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Armature.h>
+#include <Bone.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ToolsCommon
+{
+    // Bones named as in Mixamo models ("mixamorig:Bone<index>"), with identity transforms.
+    inline std::vector<Bone> CreateBones(const uint32_t numBones)
+    {
+        std::vector<Bone> bones(numBones);
+        for (uint32_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            bones[boneIndex].Name = "mixamorig:Bone" + std::to_string(boneIndex);
+            bones[boneIndex].Offset = DirectX::XMMatrixIdentity();
+            bones[boneIndex].LocalTransform = DirectX::XMMatrixIdentity();
+            bones[boneIndex].GlobalTransform = DirectX::XMMatrixIdentity();
+            bones[boneIndex].IsDirty = true;
+        }
+        return bones;
+    }
+
+    // The parent of every bone is the bone before it.
+    inline std::vector<uint32_t> CreateChainParentIndices(const uint32_t numBones)
+    {
+        std::vector<uint32_t> parentIndices(numBones);
+        for (uint32_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+        {
+            parentIndices[boneIndex] = boneIndex > 0 ? boneIndex - 1 : Armature::NO_PARENT;
+        }
+        return parentIndices;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+namespace ToolsCommon
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    inline double GetElapsedMs(const Clock::time_point startTime)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    }
+
+    // The wall time of a call, in milliseconds.
+    template <typename TFunction>
+    double MeasureTime(TFunction&& function)
+    {
+        const auto startTime = Clock::now();
+        std::forward<TFunction>(function)();
+        return GetElapsedMs(startTime);
+    }
+}
@@ -0,0 +1,698 @@
+#include "ModelCooker.h"
+
+#include <ToolsCommon/CommandLine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        std::vector<std::filesystem::path> ModelPaths;
+        bool FlipNormals = false;
+        // Random bytes changed in a valid file, once each: the view must either reject it or stay in its bounds.
+        uint32_t NumRandomCorruptions = 500;
+        uint32_t Seed = 0;
+    };
+
+    // A static model and a skinned one.
+    const char* const DEFAULT_MODEL_PATHS[] = {
+        "Assets/Models/teapot/teapot.obj",
+        "Assets/Models/archer/archer.fbx",
+    };
+
+    const std::pair<const char*, VertexLayout> VERTEX_LAYOUTS[] = {
+        { "full", VertexLayout::Full() },
+        { "compact", VertexLayout::Compact() },
+    };
+
+    using File = CookedModelFile;
+
+    // A grid of the given size, optionally skinned to a chain of bones with a branch, and with a LOD per halving.
+    File::Mesh CreateSyntheticMesh(const uint32_t numVerticesPerSide, const bool isSkinned, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+        File::Mesh mesh{};
+        mesh.Vertices.resize(static_cast<size_t>(numVerticesPerSide) * numVerticesPerSide);
+        for (uint32_t y = 0; y < numVerticesPerSide; ++y)
+        {
+            for (uint32_t x = 0; x < numVerticesPerSide; ++x)
+            {
+                auto& vertex = mesh.Vertices[y * numVerticesPerSide + x];
+                vertex = { { static_cast<float>(x), unitDistribution(random), static_cast<float>(y), 1.0f },
+                    { 0.0f, 1.0f, 0.0f, 0.0f },
+                    { static_cast<float>(x) / static_cast<float>(numVerticesPerSide), static_cast<float>(y) / static_cast<float>(numVerticesPerSide), 0.0f, 0.0f },
+                    { 1.0f, 0.0f, 0.0f, 0.0f },
+                    { 0.0f, 0.0f, 1.0f, 0.0f } };
+            }
+        }
+
+        for (uint32_t y = 0; y + 1 < numVerticesPerSide; ++y)
+        {
+            for (uint32_t x = 0; x + 1 < numVerticesPerSide; ++x)
+            {
+                const uint32_t v00 = y * numVerticesPerSide + x;
+                const uint32_t v10 = v00 + numVerticesPerSide;
+                mesh.Indices.insert(mesh.Indices.end(), { v00, v10, v10 + 1, v00, v10 + 1, v00 + 1 });
+            }
+        }
+
+        for (size_t numIndices = mesh.Indices.size() / 6 * 3; numIndices >= 3; numIndices = numIndices / 6 * 3)
+        {
+            MeshOptimization::Lod lod;
+            lod.Indices.assign(mesh.Indices.begin(), mesh.Indices.begin() + static_cast<ptrdiff_t>(numIndices));
+            lod.Error = 1.0f / static_cast<float>(numIndices);
+            mesh.Lods.push_back(std::move(lod));
+        }
+
+        mesh.AabbMin[0] = 0.0f;
+        mesh.AabbMin[1] = -1.0f;
+        mesh.AabbMin[2] = 0.0f;
+        mesh.AabbMax[0] = static_cast<float>(numVerticesPerSide - 1);
+        mesh.AabbMax[1] = 1.0f;
+        mesh.AabbMax[2] = static_cast<float>(numVerticesPerSide - 1);
+
+        if (isSkinned)
+        {
+            constexpr uint32_t numBones = 5;
+            for (uint32_t boneIndex = 0; boneIndex < numBones; ++boneIndex)
+            {
+                File::Bone bone{};
+                bone.Name = "Bone" + std::to_string(boneIndex);
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    bone.Offset[i] = unitDistribution(random);
+                    bone.LocalTransform[i] = unitDistribution(random);
+                }
+
+                mesh.Bones.push_back(std::move(bone));
+            }
+
+            // The parents come before their children.
+            mesh.Bones[0].Children = { 1, 3 };
+            mesh.Bones[1].Children = { 2 };
+            mesh.Bones[3].Children = { 4 };
+
+            std::uniform_int_distribution<uint32_t> boneDistribution(0, numBones - 1);
+            mesh.SkinningVertices.resize(mesh.Vertices.size());
+            for (auto& skinningVertex : mesh.SkinningVertices)
+            {
+                for (uint32_t i = 0; i < File::BONES_PER_VERTEX; ++i)
+                {
+                    skinningVertex.BoneIds[i] = boneDistribution(random);
+                    skinningVertex.Weights[i] = 1.0f / static_cast<float>(File::BONES_PER_VERTEX);
+                }
+            }
+        }
+
+        return mesh;
+    }
+
+    uint32_t GetIndex(const CookedModelView::MeshView& mesh, const uint32_t i)
+    {
+        return mesh.IndexStride == sizeof(uint16_t) ?
+            static_cast<const uint16_t*>(mesh.Indices)[i] :
+            static_cast<const uint32_t*>(mesh.Indices)[i];
+    }
+
+    // Returns an empty string if the view holds the model, or the first difference.
+    std::string Compare(const File& model, const CookedModelView& view)
+    {
+        if (view.GetFlags() != model.m_Flags)
+        {
+            return "flags";
+        }
+
+        if (view.GetVertexLayout().Pack() != model.m_VertexLayout.Pack())
+        {
+            return "vertex layout";
+        }
+
+        if (view.GetMeshCount() != model.m_Meshes.size())
+        {
+            return "mesh count";
+        }
+
+        for (uint32_t meshIndex = 0; meshIndex < view.GetMeshCount(); ++meshIndex)
+        {
+            const auto& mesh = model.m_Meshes[meshIndex];
+            const auto meshView = view.GetMesh(meshIndex);
+            const std::string prefix = "mesh " + std::to_string(meshIndex) + ": ";
+
+            std::vector<uint8_t> encodedVertices(mesh.Vertices.size() * model.m_VertexLayout.GetStride());
+            model.m_VertexLayout.Encode(mesh.Vertices.data(), mesh.Vertices.size(), encodedVertices.data());
+            if (meshView.NumVertices != mesh.Vertices.size() || meshView.VertexStride != model.m_VertexLayout.GetStride() ||
+                memcmp(meshView.Vertices, encodedVertices.data(), encodedVertices.size()) != 0)
+            {
+                return prefix + "vertices";
+            }
+
+            // The 16-bit indices are only used when they can address all the vertices.
+            const uint32_t expectedIndexStride = mesh.Vertices.size() <= File::MAX_VERTICES_FOR_16_BIT_INDICES ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (meshView.IndexStride != expectedIndexStride || meshView.NumLods != mesh.Lods.size() + 1)
+            {
+                return prefix + "index stride or LOD count";
+            }
+
+            for (uint32_t lodIndex = 0; lodIndex < meshView.NumLods; ++lodIndex)
+            {
+                const auto& lodRecord = meshView.Lods[lodIndex];
+                const auto& indices = lodIndex == 0 ? mesh.Indices : mesh.Lods[lodIndex - 1].Indices;
+                const float error = lodIndex == 0 ? 0.0f : mesh.Lods[lodIndex - 1].Error;
+
+                if (lodRecord.NumIndices != indices.size() || lodRecord.Error != error)
+                {
+                    return prefix + "LOD " + std::to_string(lodIndex);
+                }
+
+                for (uint32_t i = 0; i < lodRecord.NumIndices; ++i)
+                {
+                    if (GetIndex(meshView, lodRecord.IndexOffset + i) != indices[i])
+                    {
+                        return prefix + "indices of the LOD " + std::to_string(lodIndex);
+                    }
+                }
+            }
+
+            if (meshView.NumSkinningVertices != mesh.SkinningVertices.size() ||
+                (!mesh.SkinningVertices.empty() && memcmp(meshView.SkinningVertices, mesh.SkinningVertices.data(), mesh.SkinningVertices.size() * sizeof(File::SkinningVertex)) != 0))
+            {
+                return prefix + "skinning vertices";
+            }
+
+            if (meshView.NumBones != mesh.Bones.size())
+            {
+                return prefix + "bone count";
+            }
+
+            for (uint32_t boneIndex = 0; boneIndex < meshView.NumBones; ++boneIndex)
+            {
+                const auto& bone = mesh.Bones[boneIndex];
+                const auto& boneRecord = meshView.Bones[boneIndex];
+                const uint32_t* children = view.GetBoneChildren(boneRecord);
+
+                if (view.GetBoneName(boneRecord) != bone.Name ||
+                    memcmp(boneRecord.Offset, bone.Offset, sizeof(bone.Offset)) != 0 ||
+                    memcmp(boneRecord.LocalTransform, bone.LocalTransform, sizeof(bone.LocalTransform)) != 0 ||
+                    !std::equal(children, children + boneRecord.NumChildren, bone.Children.begin(), bone.Children.end()))
+                {
+                    return prefix + "bone " + std::to_string(boneIndex);
+                }
+            }
+
+            if (!std::equal(mesh.AabbMin, mesh.AabbMin + 3, meshView.AabbMin) || !std::equal(mesh.AabbMax, mesh.AabbMax + 3, meshView.AabbMax))
+            {
+                return prefix + "bounds";
+            }
+        }
+
+        return {};
+    }
+
+    // Reads every byte that the view exposes, so that AddressSanitizer catches a range that Parse has let through.
+    uint64_t ReadAll(const CookedModelView& view)
+    {
+        uint64_t sum = 0;
+        const auto add = [&sum](const void* data, const size_t size)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                sum += bytes[i];
+            }
+        };
+
+        for (uint32_t meshIndex = 0; meshIndex < view.GetMeshCount(); ++meshIndex)
+        {
+            const auto mesh = view.GetMesh(meshIndex);
+            add(mesh.Vertices, static_cast<size_t>(mesh.NumVertices) * mesh.VertexStride);
+            add(mesh.Indices, static_cast<size_t>(mesh.NumIndices) * mesh.IndexStride);
+            add(mesh.SkinningVertices, mesh.NumSkinningVertices * sizeof(File::SkinningVertex));
+            add(mesh.Lods, mesh.NumLods * sizeof(File::LodRecord));
+
+            for (uint32_t lodIndex = 0; lodIndex < mesh.NumLods; ++lodIndex)
+            {
+                for (uint32_t i = 0; i < mesh.Lods[lodIndex].NumIndices; ++i)
+                {
+                    sum += GetIndex(mesh, mesh.Lods[lodIndex].IndexOffset + i);
+                }
+            }
+
+            for (uint32_t boneIndex = 0; boneIndex < mesh.NumBones; ++boneIndex)
+            {
+                const auto& bone = mesh.Bones[boneIndex];
+                add(&bone, sizeof(bone));
+                add(view.GetBoneName(bone).data(), bone.NameLength);
+                add(view.GetBoneChildren(bone), bone.NumChildren * sizeof(uint32_t));
+            }
+        }
+
+        return sum;
+    }
+
+    File::Header& GetHeader(std::vector<uint8_t>& bytes)
+    {
+        return *reinterpret_cast<File::Header*>(bytes.data());
+    }
+
+    const File::Header& GetHeader(const std::vector<uint8_t>& bytes)
+    {
+        return *reinterpret_cast<const File::Header*>(bytes.data());
+    }
+
+    File::MeshRecord& GetMeshRecord(std::vector<uint8_t>& bytes, const uint32_t meshIndex)
+    {
+        return reinterpret_cast<File::MeshRecord*>(bytes.data() + GetHeader(bytes).MeshesOffset)[meshIndex];
+    }
+
+    template <typename T>
+    T* GetStream(std::vector<uint8_t>& bytes, const uint64_t offset)
+    {
+        return reinterpret_cast<T*>(bytes.data() + offset);
+    }
+
+    // Changes a field of a valid file. Returns false if the file has nothing to corrupt (e.g., no bones).
+    using Corruption = std::function<bool(std::vector<uint8_t>& bytes)>;
+
+    // A corruption of every mesh record field that Parse validates, applied to the first mesh that has the field.
+    std::vector<std::pair<const char*, Corruption>> GetCorruptions()
+    {
+        const auto forMesh = [](const std::function<bool(std::vector<uint8_t>&, File::MeshRecord&)>& corruptMesh)
+        {
+            return [corruptMesh](std::vector<uint8_t>& bytes)
+            {
+                for (uint32_t meshIndex = 0; meshIndex < GetHeader(bytes).NumMeshes; ++meshIndex)
+                {
+                    if (corruptMesh(bytes, GetMeshRecord(bytes, meshIndex)))
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            };
+        };
+
+        return {
+            { "magic", [](auto& bytes) { GetHeader(bytes).Magic ^= 1; return true; } },
+            { "older version", [](auto& bytes) { GetHeader(bytes).Version = File::VERSION - 1; return true; } },
+            { "newer version", [](auto& bytes) { GetHeader(bytes).Version = File::VERSION + 1; return true; } },
+            { "file size", [](auto& bytes) { GetHeader(bytes).FileSize += File::STREAM_ALIGNMENT; return true; } },
+            { "vertex layout", [](auto& bytes) { GetHeader(bytes).VertexLayout = ~0u; return true; } },
+            { "mesh count", [](auto& bytes) { GetHeader(bytes).NumMeshes = ~0u; return true; } },
+            { "misaligned meshes", [](auto& bytes) { GetHeader(bytes).MeshesOffset += 4; return true; } },
+            { "meshes out of the file", [](auto& bytes) { GetHeader(bytes).MeshesOffset = bytes.size(); return GetHeader(bytes).NumMeshes > 0; } },
+            { "vertex stride", forMesh([](auto&, auto& mesh) { mesh.VertexStride += 4; return true; }) },
+            { "vertices out of the file", forMesh([](auto& bytes, auto& mesh) { mesh.VerticesOffset = bytes.size(); return mesh.NumVertices > 0; }) },
+            { "vertex count", forMesh([](auto& bytes, auto& mesh) { mesh.NumVertices = static_cast<uint32_t>(bytes.size()); return true; }) },
+            { "index stride", forMesh([](auto&, auto& mesh) { mesh.IndexStride = 3; return true; }) },
+            { "misaligned indices", forMesh([](auto&, auto& mesh) { mesh.IndicesOffset += 2; return mesh.NumIndices > 0; }) },
+            { "index out of range", forMesh([](auto& bytes, auto& mesh)
+                {
+                    if (mesh.NumIndices == 0)
+                    {
+                        return false;
+                    }
+
+                    if (mesh.IndexStride == sizeof(uint16_t))
+                    {
+                        *GetStream<uint16_t>(bytes, mesh.IndicesOffset) = static_cast<uint16_t>(std::min<uint32_t>(mesh.NumVertices, UINT16_MAX));
+                        return mesh.NumVertices <= UINT16_MAX;
+                    }
+
+                    *GetStream<uint32_t>(bytes, mesh.IndicesOffset) = mesh.NumVertices;
+                    return true;
+                }) },
+            { "no LOD", forMesh([](auto&, auto& mesh) { mesh.NumLods = 0; return true; }) },
+            { "LOD out of the index stream", forMesh([](auto& bytes, auto& mesh)
+                {
+                    auto& lod = GetStream<File::LodRecord>(bytes, mesh.LodsOffset)[mesh.NumLods - 1];
+                    lod.IndexOffset = mesh.NumIndices - lod.NumIndices + 3;
+                    return true;
+                }) },
+            { "LOD not made of triangles", forMesh([](auto& bytes, auto& mesh)
+                {
+                    auto& lod = GetStream<File::LodRecord>(bytes, mesh.LodsOffset)[0];
+                    if (lod.NumIndices == 0)
+                    {
+                        return false;
+                    }
+
+                    lod.NumIndices -= 1;
+                    return true;
+                }) },
+            { "LODs out of the file", forMesh([](auto& bytes, auto& mesh) { mesh.LodsOffset = bytes.size(); return true; }) },
+            { "skinning vertex stride", forMesh([](auto&, auto& mesh) { mesh.SkinningVertexStride += 4; return true; }) },
+            { "skinning vertex count", forMesh([](auto&, auto& mesh)
+                {
+                    if (mesh.NumSkinningVertices < 2)
+                    {
+                        return false;
+                    }
+
+                    mesh.NumSkinningVertices -= 1;
+                    return true;
+                }) },
+            { "bone id out of range", forMesh([](auto& bytes, auto& mesh)
+                {
+                    if (mesh.NumSkinningVertices == 0)
+                    {
+                        return false;
+                    }
+
+                    GetStream<File::SkinningVertex>(bytes, mesh.SkinningVerticesOffset)[mesh.NumSkinningVertices - 1].BoneIds[File::BONES_PER_VERTEX - 1] = mesh.NumBones;
+                    return true;
+                }) },
+            { "bones out of the file", forMesh([](auto& bytes, auto& mesh) { mesh.BonesOffset = bytes.size(); return mesh.NumBones > 0; }) },
+            { "bone name out of the file", forMesh([](auto& bytes, auto& mesh)
+                {
+                    if (mesh.NumBones == 0)
+                    {
+                        return false;
+                    }
+
+                    GetStream<File::BoneRecord>(bytes, mesh.BonesOffset)[0].NameLength = static_cast<uint32_t>(bytes.size());
+                    return true;
+                }) },
+            { "bone child out of range", forMesh([](auto& bytes, auto& mesh)
+                {
+                    for (uint32_t boneIndex = 0; boneIndex < mesh.NumBones; ++boneIndex)
+                    {
+                        auto& bone = GetStream<File::BoneRecord>(bytes, mesh.BonesOffset)[boneIndex];
+                        if (bone.NumChildren > 0)
+                        {
+                            GetStream<uint32_t>(bytes, bone.ChildrenOffset)[0] = mesh.NumBones;
+                            return true;
+                        }
+                    }
+
+                    return false;
+                }) },
+            { "bone child before its parent", forMesh([](auto& bytes, auto& mesh)
+                {
+                    for (uint32_t boneIndex = 0; boneIndex < mesh.NumBones; ++boneIndex)
+                    {
+                        auto& bone = GetStream<File::BoneRecord>(bytes, mesh.BonesOffset)[boneIndex];
+                        if (bone.NumChildren > 0)
+                        {
+                            GetStream<uint32_t>(bytes, bone.ChildrenOffset)[0] = boneIndex;
+                            return true;
+                        }
+                    }
+
+                    return false;
+                }) },
+        };
+    }
+
+    bool IsRejected(std::vector<uint8_t> bytes)
+    {
+        CookedModelView view;
+        if (!view.Load(std::move(bytes)))
+        {
+            return true;
+        }
+
+        ReadAll(view);
+        return false;
+    }
+
+    // Returns false if a check fails.
+    bool CheckRejections(const std::string& name, const std::vector<uint8_t>& bytes, const Settings& settings, std::mt19937& random)
+    {
+        uint32_t numCorruptions = 0;
+        for (const auto& [corruptionName, corrupt] : GetCorruptions())
+        {
+            auto corruptedBytes = bytes;
+            if (!corrupt(corruptedBytes))
+            {
+                continue;
+            }
+
+            ++numCorruptions;
+            if (!IsRejected(std::move(corruptedBytes)))
+            {
+                std::cerr << name << ": a file with a corrupted " << corruptionName << " has been accepted." << std::endl;
+                return false;
+            }
+        }
+
+        // Truncated as is, and with a header that agrees with the truncated size, so that the ranges of the streams are what rejects it.
+        const size_t truncationStep = std::max<size_t>(bytes.size() / 128, 1);
+        uint32_t numTruncations = 0;
+        for (size_t size = 0; size < bytes.size(); size += size < sizeof(File::Header) * 2 ? 1 : truncationStep)
+        {
+            std::vector<uint8_t> truncatedBytes(bytes.begin(), bytes.begin() + static_cast<ptrdiff_t>(size));
+            if (!IsRejected(truncatedBytes))
+            {
+                std::cerr << name << ": a file truncated to " << size << " bytes has been accepted." << std::endl;
+                return false;
+            }
+
+            if (size >= sizeof(File::Header))
+            {
+                GetHeader(truncatedBytes).FileSize = size;
+                if (!IsRejected(std::move(truncatedBytes)))
+                {
+                    std::cerr << name << ": a file truncated to " << size << " bytes (with a matching header) has been accepted." << std::endl;
+                    return false;
+                }
+            }
+
+            ++numTruncations;
+        }
+
+        // The header and the records are what matter: random changes to them must not make the view read out of the file.
+        const auto& header = GetHeader(bytes);
+        const size_t corruptedRange = std::min<size_t>(bytes.size(), header.MeshesOffset + header.NumMeshes * sizeof(File::MeshRecord));
+        std::uniform_int_distribution<size_t> offsetDistribution(0, corruptedRange - 1);
+        std::uniform_int_distribution<uint32_t> byteDistribution(0, UINT8_MAX);
+        uint32_t numAccepted = 0;
+        for (uint32_t i = 0; i < settings.NumRandomCorruptions; ++i)
+        {
+            auto corruptedBytes = bytes;
+            corruptedBytes[offsetDistribution(random)] ^= static_cast<uint8_t>(byteDistribution(random) | 1);
+            numAccepted += IsRejected(std::move(corruptedBytes)) ? 0 : 1;
+        }
+
+        std::cout << "    Rejected " << numCorruptions << " corrupted fields and " << numTruncations << " truncations"
+            << "; " << numAccepted << " of " << settings.NumRandomCorruptions << " random header changes accepted (in bounds)" << std::endl;
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool CheckModel(const std::string& name, const File& model, const Settings& settings, std::mt19937& random)
+    {
+        std::cout << name << ": " << model.m_Meshes.size() << " meshes" << std::endl;
+
+        std::vector<uint8_t> bytes = model.Serialize();
+
+        CookedModelView view;
+        if (!view.Load(std::vector<uint8_t>(bytes)))
+        {
+            std::cerr << name << ": the serialized model has been rejected." << std::endl;
+            return false;
+        }
+
+        const std::string difference = Compare(model, view);
+        if (!difference.empty())
+        {
+            std::cerr << name << ": the parsed model differs (" << difference << ")." << std::endl;
+            return false;
+        }
+
+        // Through the file and the memory mapping, as the demos load it.
+        const auto path = std::filesystem::temp_directory_path() / "CookedModelCheck.cooked";
+        model.Write(path);
+
+        std::string fileDifference;
+        {
+            CookedModelView fileView;
+            fileDifference = fileView.Open(path) ? Compare(model, fileView) : "not opened";
+        }
+        std::filesystem::remove(path);
+
+        if (!fileDifference.empty())
+        {
+            std::cerr << name << ": the model read from the file differs (" << fileDifference << ")." << std::endl;
+            return false;
+        }
+
+        return CheckRejections(name, bytes, settings, random);
+    }
+
+    // Random orthonormal tangent frames of both handednesses must survive Encode and Decode, with the bitangent rebuilt when it is not stored.
+    bool CheckVertexLayouts(std::mt19937& random)
+    {
+        if (VertexLayout::Compact().GetStride() > 32)
+        {
+            std::cerr << "The compact vertex layout takes " << VertexLayout::Compact().GetStride() << " bytes." << std::endl;
+            return false;
+        }
+
+        constexpr size_t numVertices = 1000;
+        std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+        const auto normalize = [](float* v)
+        {
+            const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        };
+
+        std::vector<File::Vertex> vertices(numVertices);
+        for (size_t i = 0; i < numVertices; ++i)
+        {
+            auto& vertex = vertices[i];
+            float normal[3] = { unitDistribution(random), unitDistribution(random), 1.5f };
+            float tangent[3] = { 1.5f, unitDistribution(random), unitDistribution(random) };
+            normalize(normal);
+
+            // Make the tangent orthogonal to the normal.
+            const float d = normal[0] * tangent[0] + normal[1] * tangent[1] + normal[2] * tangent[2];
+            for (int c = 0; c < 3; ++c)
+            {
+                tangent[c] -= d * normal[c];
+            }
+            normalize(tangent);
+
+            const float handedness = i % 2 == 0 ? 1.0f : -1.0f;
+            vertex = { { unitDistribution(random) * 1000.0f, unitDistribution(random) * 1000.0f, unitDistribution(random) * 1000.0f, 1.0f },
+                { normal[0], normal[1], normal[2], 0.0f },
+                { unitDistribution(random), unitDistribution(random), 0.0f, 0.0f },
+                { tangent[0], tangent[1], tangent[2], 0.0f },
+                { (normal[1] * tangent[2] - normal[2] * tangent[1]) * handedness,
+                    (normal[2] * tangent[0] - normal[0] * tangent[2]) * handedness,
+                    (normal[0] * tangent[1] - normal[1] * tangent[0]) * handedness, 0.0f } };
+        }
+
+        bool success = true;
+
+        for (const auto& [layoutName, vertexLayout] : VERTEX_LAYOUTS)
+        {
+            std::vector<uint8_t> encodedVertices(numVertices * vertexLayout.GetStride());
+            vertexLayout.Encode(vertices.data(), numVertices, encodedVertices.data());
+            std::vector<File::Vertex> decodedVertices(numVertices);
+            vertexLayout.Decode(encodedVertices.data(), numVertices, decodedVertices.data());
+
+            for (size_t i = 0; i < numVertices; ++i)
+            {
+                const auto& vertex = vertices[i];
+                const auto& decodedVertex = decodedVertices[i];
+                const float handedness = i % 2 == 0 ? 1.0f : -1.0f;
+
+                // Snorm16 directions and float32 positions.
+                constexpr float tolerance = 1e-3f;
+                bool isClose = decodedVertex.Tangent[3] == handedness;
+                for (int c = 0; c < 3; ++c)
+                {
+                    isClose &= std::abs(decodedVertex.Position[c] - vertex.Position[c]) <= tolerance;
+                    isClose &= std::abs(decodedVertex.Normal[c] - vertex.Normal[c]) <= tolerance;
+                    isClose &= std::abs(decodedVertex.Tangent[c] - vertex.Tangent[c]) <= tolerance;
+                    isClose &= std::abs(decodedVertex.Bitangent[c] - vertex.Bitangent[c]) <= tolerance;
+                }
+
+                if (!isClose)
+                {
+                    std::cerr << "Vertex " << i << " does not survive the " << layoutName << " vertex layout." << std::endl;
+                    success = false;
+                    break;
+                }
+            }
+        }
+
+        return success;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: CookedModelCheck [<model>...] [--flip-normals] [--corruptions <count>] [--seed <value>]");
+    commandLine.AddFlag("--flip-normals", settings.FlipNormals);
+    commandLine.AddOption("--corruptions", settings.NumRandomCorruptions);
+    commandLine.AddOption("--seed", settings.Seed);
+    commandLine.AddPositional(settings.ModelPaths);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    const bool useDefaultModels = settings.ModelPaths.empty();
+    if (useDefaultModels)
+    {
+        settings.ModelPaths.assign(std::begin(DEFAULT_MODEL_PATHS), std::end(DEFAULT_MODEL_PATHS));
+    }
+
+    try
+    {
+        std::mt19937 random(settings.Seed);
+        bool success = CheckVertexLayouts(random);
+
+        // A static and a skinned mesh with 16-bit indices.
+        for (const auto& [layoutName, vertexLayout] : VERTEX_LAYOUTS)
+        {
+            File model;
+            model.m_Flags = File::FLAG_OPTIMIZED;
+            model.m_VertexLayout = vertexLayout;
+            model.m_Meshes.push_back(CreateSyntheticMesh(16, false, random));
+            model.m_Meshes.push_back(CreateSyntheticMesh(24, true, random));
+
+            success &= CheckModel(std::string("Synthetic (") + layoutName + ")", model, settings, random);
+        }
+
+        // Too many vertices for 16-bit indices. In the smallest layout only, as it is checked byte by byte.
+        {
+            File model;
+            model.m_VertexLayout = VertexLayout::Compact();
+            model.m_Meshes.push_back(CreateSyntheticMesh(257, true, random));
+
+            success &= CheckModel("Synthetic with 32-bit indices (compact)", model, settings, random);
+        }
+
+        for (const auto& path : settings.ModelPaths)
+        {
+            if (useDefaultModels && !std::filesystem::exists(path))
+            {
+                std::cout << path.string() << ": not found, skipped (run from the repository root)" << std::endl;
+                continue;
+            }
+
+            for (const auto& [layoutName, vertexLayout] : VERTEX_LAYOUTS)
+            {
+                File model = ModelCooker::Import(path.string(), settings.FlipNormals);
+                model.m_VertexLayout = vertexLayout;
+                ModelCooker::Optimize(model);
+
+                success &= CheckModel(path.string() + " (" + layoutName + ")", model, settings, random);
+            }
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
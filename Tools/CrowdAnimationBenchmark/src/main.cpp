@@ -0,0 +1,376 @@
+#include <Animation.h>
+#include <AnimationBlendTree.h>
+#include <Armature.h>
+#include <CrowdAnimator.h>
+#include <ThreadPool.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Skeletons.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumBones = 65;
+        uint32_t NumFrames = 120;
+        float FrameRate = 60.0f;
+        // 0 means one per hardware thread.
+        uint32_t NumThreads = 0;
+        uint32_t CharactersPerJob = 8;
+        float KeysPerSecond = 30.0f;
+        float DurationInSeconds = 4.0f;
+        uint32_t Seed = 0;
+    };
+
+    struct Skeleton
+    {
+        std::vector<Bone> Bones;
+        std::vector<uint32_t> ParentIndices;
+    };
+
+    // A humanoid-like tree: every bone hangs off one of the few bones before it, so there are chains and branches.
+    Skeleton CreateSkeleton(const Settings& settings, std::mt19937& random)
+    {
+        Skeleton skeleton;
+        skeleton.Bones = ToolsCommon::CreateBones(settings.NumBones);
+        skeleton.ParentIndices.resize(settings.NumBones);
+
+        for (uint32_t boneIndex = 0; boneIndex < settings.NumBones; ++boneIndex)
+        {
+            if (boneIndex == 0)
+            {
+                skeleton.ParentIndices[boneIndex] = Armature::NO_PARENT;
+            }
+            else
+            {
+                std::uniform_int_distribution<uint32_t> parentDistribution(boneIndex > 4 ? boneIndex - 4 : 0, boneIndex - 1);
+                skeleton.ParentIndices[boneIndex] = parentDistribution(random);
+            }
+        }
+
+        return skeleton;
+    }
+
+    std::shared_ptr<const Animation> CreateAnimation(const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        const uint32_t numKeys = std::max(static_cast<uint32_t>(settings.DurationInSeconds * settings.KeysPerSecond), 2u);
+
+        std::vector<Animation::Channel> channels;
+        for (uint32_t boneIndex = 0; boneIndex < settings.NumBones; ++boneIndex)
+        {
+            Animation::Channel channel;
+            channel.NodeName = "mixamorig:Bone" + std::to_string(boneIndex);
+
+            for (uint32_t keyIndex = 0; keyIndex < numKeys; ++keyIndex)
+            {
+                const float time = static_cast<float>(keyIndex);
+                channel.PositionKeyFrames.push_back({ XMVectorSet(distribution(random), distribution(random), distribution(random), 0.0f), time });
+                channel.RotationKeyFrames.push_back({ XMQuaternionNormalize(XMVectorSet(distribution(random), distribution(random), distribution(random), 1.0f)), time });
+            }
+
+            channel.ScalingKeyFrames.push_back({ XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), 0.0f });
+            channels.push_back(std::move(channel));
+        }
+
+        return std::make_shared<const Animation>(static_cast<float>(numKeys - 1), settings.KeysPerSecond, channels);
+    }
+
+    /**
+     * How the global transforms used to be updated: recursively from every bone, following per-bone lists of children.
+     */
+    class LegacyHierarchy
+    {
+    public:
+        explicit LegacyHierarchy(const std::vector<uint32_t>& parentIndices)
+            : m_BoneChildrenByIndex(parentIndices.size())
+        {
+            for (size_t boneIndex = 0; boneIndex < parentIndices.size(); ++boneIndex)
+            {
+                if (parentIndices[boneIndex] != Armature::NO_PARENT)
+                {
+                    m_BoneChildrenByIndex[parentIndices[boneIndex]].push_back(boneIndex);
+                }
+            }
+        }
+
+        void UpdateBoneGlobalTransforms(Armature& armature) const
+        {
+            for (size_t boneIndex = 0; boneIndex < m_BoneChildrenByIndex.size(); ++boneIndex)
+            {
+                UpdateBoneGlobalTransforms(armature, boneIndex, XMMatrixIdentity());
+            }
+        }
+
+    private:
+        void UpdateBoneGlobalTransforms(Armature& armature, const size_t rootIndex, const XMMATRIX& parentTransform) const
+        {
+            auto& bone = armature.GetBone(rootIndex);
+            if (!bone.IsDirty)
+            {
+                return;
+            }
+
+            bone.GlobalTransform = bone.LocalTransform * parentTransform;
+            bone.IsDirty = false;
+
+            for (const size_t childIndex : m_BoneChildrenByIndex[rootIndex])
+            {
+                UpdateBoneGlobalTransforms(armature, childIndex, bone.GlobalTransform);
+            }
+        }
+
+        std::vector<std::vector<size_t>> m_BoneChildrenByIndex;
+    };
+
+    // Spends some time on exact values of 0 and 1, as the demo does.
+    float GetBlendWeight(const double time)
+    {
+        return std::clamp(static_cast<float>(std::sin(time * 2.0)) * 0.75f + 0.5f, 0.0f, 1.0f);
+    }
+
+    // Keeps the updates from being optimized away.
+    float Checksum(const std::vector<Armature>& armatures)
+    {
+        float checksum = 0.0f;
+        for (const auto& armature : armatures)
+        {
+            for (const auto& bone : armature.GetBones())
+            {
+                checksum += XMVectorGetX(bone.GlobalTransform.r[3]);
+            }
+        }
+        return checksum;
+    }
+
+    float GetMaxDifference(const std::vector<Armature>& armatures1, const std::vector<Armature>& armatures2)
+    {
+        float maxDifference = 0.0f;
+        for (size_t characterIndex = 0; characterIndex < armatures1.size(); ++characterIndex)
+        {
+            const auto& bones1 = armatures1[characterIndex].GetBones();
+            const auto& bones2 = armatures2[characterIndex].GetBones();
+
+            for (size_t boneIndex = 0; boneIndex < bones1.size(); ++boneIndex)
+            {
+                for (size_t row = 0; row < 4; ++row)
+                {
+                    const XMVECTOR difference = XMVectorAbs(XMVectorSubtract(bones1[boneIndex].GlobalTransform.r[row], bones2[boneIndex].GlobalTransform.r[row]));
+                    maxDifference = std::max({ maxDifference, XMVectorGetX(difference), XMVectorGetY(difference), XMVectorGetZ(difference), XMVectorGetW(difference) });
+                }
+            }
+        }
+        return maxDifference;
+    }
+
+    // A crowd of characters with the demo's blend tree: a run/idle blend with the upper body overridden by a third clip.
+    struct Crowd
+    {
+        std::vector<Armature> Armatures;
+        CrowdAnimator Animator;
+        AnimationBlendTree::NodeId LocomotionNode = 0;
+
+        Crowd(ThreadPool* threadPool, const Settings& settings)
+            : Animator(threadPool, settings.CharactersPerJob)
+        {}
+
+        void SetWeights(const double time)
+        {
+            const float weight = GetBlendWeight(time);
+            for (CrowdAnimator::CharacterId characterId = 0; characterId < Animator.GetCharacterCount(); ++characterId)
+            {
+                Animator.GetBlendTree(characterId).SetWeight(LocomotionNode, 0, 1.0f - weight);
+                Animator.GetBlendTree(characterId).SetWeight(LocomotionNode, 1, weight);
+            }
+        }
+    };
+
+    void CreateCrowd(Crowd& crowd, const uint32_t numCharacters, const Skeleton& skeleton, const std::shared_ptr<const Animation>* animations, const std::vector<double>& timeOffsets)
+    {
+        // The animator keeps pointers to the armatures.
+        crowd.Armatures.resize(numCharacters);
+
+        for (uint32_t characterIndex = 0; characterIndex < numCharacters; ++characterIndex)
+        {
+            auto& armature = crowd.Armatures[characterIndex];
+            armature.SetBones(skeleton.Bones, skeleton.ParentIndices);
+
+            const auto characterId = crowd.Animator.AddCharacter(armature, timeOffsets[characterIndex]);
+            auto& blendTree = crowd.Animator.GetBlendTree(characterId);
+
+            const auto run = blendTree.AddClip(animations[0]);
+            const auto idle = blendTree.AddClip(animations[1]);
+            crowd.LocomotionNode = blendTree.AddBlend({ run, idle }, { 1.0f, 0.0f });
+            const auto top = blendTree.AddClip(animations[2]);
+            blendTree.AddMask(top, crowd.LocomotionNode, Animation::BuildMask(armature, armature.GetBone(skeleton.Bones.size() / 4).Name));
+        }
+    }
+
+    // Returns false if the multi-threaded update does not match the serial one.
+    bool RunBenchmark(const uint32_t numCharacters, const Skeleton& skeleton, const std::shared_ptr<const Animation>* animations, ThreadPool& threadPool, const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<double> timeOffsetDistribution(0.0, settings.DurationInSeconds);
+        std::vector<double> timeOffsets(numCharacters);
+        for (auto& timeOffset : timeOffsets)
+        {
+            timeOffset = timeOffsetDistribution(random);
+        }
+
+        Crowd serialCrowd(nullptr, settings);
+        Crowd parallelCrowd(&threadPool, settings);
+        CreateCrowd(serialCrowd, numCharacters, skeleton, animations, timeOffsets);
+        CreateCrowd(parallelCrowd, numCharacters, skeleton, animations, timeOffsets);
+
+        // The legacy path runs the same blend trees and only replaces the global transform update.
+        Crowd legacyCrowd(nullptr, settings);
+        CreateCrowd(legacyCrowd, numCharacters, skeleton, animations, timeOffsets);
+        const LegacyHierarchy legacyHierarchy(skeleton.ParentIndices);
+        Animation::Pose legacyPose(skeleton.Bones.size());
+
+        float checksum = 0.0f;
+        const auto forEachFrame = [&](auto&& update)
+        {
+            for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+            {
+                update(frame / static_cast<double>(settings.FrameRate));
+            }
+        };
+
+        const double legacyTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachFrame([&](const double time)
+                    {
+                        legacyCrowd.SetWeights(time);
+                        for (CrowdAnimator::CharacterId characterId = 0; characterId < numCharacters; ++characterId)
+                        {
+                            auto& armature = legacyCrowd.Armatures[characterId];
+                            legacyCrowd.Animator.GetBlendTree(characterId).Evaluate(time + timeOffsets[characterId], legacyPose);
+                            Animation::Apply(armature, legacyPose);
+                            legacyHierarchy.UpdateBoneGlobalTransforms(armature);
+                        }
+                    });
+            });
+        checksum += Checksum(legacyCrowd.Armatures);
+
+        const double serialTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachFrame([&](const double time)
+                    {
+                        serialCrowd.SetWeights(time);
+                        serialCrowd.Animator.Update(time);
+                    });
+            });
+        checksum += Checksum(serialCrowd.Armatures);
+
+        const double parallelTime = ToolsCommon::MeasureTime([&]()
+            {
+                forEachFrame([&](const double time)
+                    {
+                        parallelCrowd.SetWeights(time);
+                        parallelCrowd.Animator.Update(time);
+                    });
+            });
+        checksum += Checksum(parallelCrowd.Armatures);
+
+        const float legacyDifference = GetMaxDifference(legacyCrowd.Armatures, serialCrowd.Armatures);
+        const float parallelDifference = GetMaxDifference(parallelCrowd.Armatures, serialCrowd.Armatures);
+
+        const auto perFrame = [&settings](const double time)
+        {
+            return time / settings.NumFrames;
+        };
+
+        std::cout << "Characters: " << numCharacters
+            << ", per frame: legacy " << perFrame(legacyTime) << " ms"
+            << ", linear " << perFrame(serialTime) << " ms (x" << legacyTime / serialTime << ")"
+            << ", jobs " << perFrame(parallelTime) << " ms (x" << serialTime / parallelTime << " over linear)"
+            << ", per character " << perFrame(parallelTime) * 1000.0 / numCharacters << " us"
+            << " [checksum " << checksum << "]" << std::endl;
+
+        // Same operations in the same order per character: the results must be identical.
+        if (parallelDifference != 0.0f)
+        {
+            std::cerr << "The multi-threaded update differs from the serial one by " << parallelDifference << "." << std::endl;
+            return false;
+        }
+
+        if (legacyDifference > 1e-4f)
+        {
+            std::cerr << "The linear update differs from the recursive one by " << legacyDifference << "." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> characterCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: CrowdAnimationBenchmark [--characters <count>...] [--bones <count>] [--frames <count>] [--threads <count>] [--characters-per-job <count>] [--seed <value>]");
+    commandLine.AddOption("--characters", characterCounts, 1u);
+    commandLine.AddOption("--bones", settings.NumBones, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--threads", settings.NumThreads);
+    commandLine.AddOption("--characters-per-job", settings.CharactersPerJob, 1u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (characterCounts.empty())
+    {
+        characterCounts = { 1, 10, 100, 1000 };
+    }
+
+    try
+    {
+        std::mt19937 random(settings.Seed);
+        const Skeleton skeleton = CreateSkeleton(settings, random);
+        const std::shared_ptr<const Animation> animations[] = {
+            CreateAnimation(settings, random),
+            CreateAnimation(settings, random),
+            CreateAnimation(settings, random),
+        };
+
+        ThreadPool threadPool(settings.NumThreads);
+
+        std::cout << "Bones: " << settings.NumBones << ", frames: " << settings.NumFrames
+            << ", threads: " << threadPool.GetThreadCount() << ", characters per job: " << settings.CharactersPerJob << std::endl;
+
+        bool success = true;
+        for (const uint32_t numCharacters : characterCounts)
+        {
+            success &= RunBenchmark(numCharacters, skeleton, animations, threadPool, settings, random);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
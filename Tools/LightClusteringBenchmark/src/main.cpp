@@ -0,0 +1,339 @@
+#include <LightClustering.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        LightClustering::Settings Clustering;
+        // The share of the lights that are spot lights.
+        float SpotPercent = 50.0f;
+        uint32_t NumFrames = 10;
+        // The positions per frame where the lights found in the cluster are checked.
+        uint32_t NumSamples = 1000;
+        uint32_t Seed = 0;
+        // The lights are scattered over a square with this many lights per square unit.
+        float Density = 0.1f;
+    };
+
+    // The DeferredLightingDemo's camera.
+    constexpr float CAMERA_FOV = 45.0f;
+    constexpr float CAMERA_ASPECT_RATIO = 16.0f / 9.0f;
+    constexpr float CAMERA_NEAR_PLANE = 0.1f;
+    constexpr float CAMERA_FAR_PLANE = 1000.0f;
+
+    // A light must be in the cluster of a position it lights by more than this share of its radius and angle,
+    // which leaves room for the float error of the transforms and of the slice formula.
+    constexpr float COVERAGE_TOLERANCE = 1e-3f;
+
+    struct Lights
+    {
+        std::vector<LightClustering::PointLightBounds> PointLights;
+        std::vector<LightClustering::SpotLightBounds> SpotLights;
+    };
+
+    float GetSceneSize(const uint32_t numLights, const Settings& settings)
+    {
+        return std::sqrt(static_cast<float>(numLights) / settings.Density);
+    }
+
+    Lights CreateLights(const uint32_t numLights, const Settings& settings, std::mt19937& random)
+    {
+        const float sceneSize = GetSceneSize(numLights, settings);
+        std::uniform_real_distribution<float> positionDistribution(-sceneSize * 0.5f, sceneSize * 0.5f);
+        std::uniform_real_distribution<float> heightDistribution(0.0f, 10.0f);
+        std::uniform_real_distribution<float> radiusDistribution(1.0f, 8.0f);
+        std::uniform_real_distribution<float> directionDistribution(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> angleDistribution(XMConvertToRadians(5.0f), XMConvertToRadians(100.0f));
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+        Lights lights;
+        for (uint32_t i = 0; i < numLights; ++i)
+        {
+            const XMFLOAT3 position = { positionDistribution(random), heightDistribution(random), positionDistribution(random) };
+            const float radius = radiusDistribution(random);
+
+            if (unitDistribution(random) * 100.0f < settings.SpotPercent)
+            {
+                // Mostly pointing down, as the demo's spot light.
+                XMFLOAT3 direction;
+                XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSet(directionDistribution(random), -1.0f, directionDistribution(random), 0.0f)));
+                lights.SpotLights.push_back({ position, radius, direction, angleDistribution(random) });
+            }
+            else
+            {
+                lights.PointLights.push_back({ position, radius });
+            }
+        }
+
+        return lights;
+    }
+
+    // A camera walking around the scene, looking slightly down.
+    XMMATRIX CreateCameraView(const uint32_t numLights, const uint32_t frame, const Settings& settings)
+    {
+        const float orbitRadius = GetSceneSize(numLights, settings) * 0.25f;
+        const float angle = static_cast<float>(frame) * 0.1f;
+        const XMVECTOR eyePosition = XMVectorSet(std::cos(angle) * orbitRadius, 5.0f, std::sin(angle) * orbitRadius, 1.0f);
+        const XMVECTOR eyeDirection = XMVector3Normalize(XMVectorSet(-std::sin(angle), -0.2f, std::cos(angle), 0.0f));
+        return XMMatrixLookToLH(eyePosition, eyeDirection, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    XMMATRIX CreateCameraProjection()
+    {
+        return XMMatrixPerspectiveFovLH(XMConvertToRadians(CAMERA_FOV), CAMERA_ASPECT_RATIO, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+    }
+
+    // As the clustered light pass finds the cluster of a pixel.
+    uint32_t GetSlice(const float viewDepth, const LightClustering::ShaderParameters& parameters)
+    {
+        const float slice = std::floor(std::log2(viewDepth) * parameters.SliceScale + parameters.SliceBias);
+        return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(parameters.SlicesCount - 1)));
+    }
+
+    uint32_t GetClusterIndex(const XMFLOAT2& uv, const float viewDepth, const LightClustering::ShaderParameters& parameters)
+    {
+        const uint32_t tileX = std::min(static_cast<uint32_t>(uv.x * static_cast<float>(parameters.TilesX)), parameters.TilesX - 1);
+        const uint32_t tileY = std::min(static_cast<uint32_t>(uv.y * static_cast<float>(parameters.TilesY)), parameters.TilesY - 1);
+        return (GetSlice(viewDepth, parameters) * parameters.TilesY + tileY) * parameters.TilesX + tileX;
+    }
+
+    bool IsLit(const LightClustering::PointLightBounds& light, const XMVECTOR positionWs)
+    {
+        const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(positionWs, XMLoadFloat3(&light.PositionWs))));
+        return distance < light.Radius * (1.0f - COVERAGE_TOLERANCE);
+    }
+
+    bool IsLit(const LightClustering::SpotLightBounds& light, const XMVECTOR positionWs)
+    {
+        const XMVECTOR offset = XMVectorSubtract(positionWs, XMLoadFloat3(&light.PositionWs));
+        const float distance = XMVectorGetX(XMVector3Length(offset));
+        if (!(distance < light.Radius * (1.0f - COVERAGE_TOLERANCE)) || distance == 0.0f)
+        {
+            return false;
+        }
+
+        const float cosAngle = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&light.DirectionWs))) / distance;
+        return cosAngle > std::cos(light.HalfAngle * (1.0f - COVERAGE_TOLERANCE));
+    }
+
+    // Build must find exactly the lights that BuildReference finds, in the same order.
+    bool ValidateReference(const LightClustering& clustering, const LightClustering& reference, const uint32_t frame)
+    {
+        const auto& clusters = clustering.GetClusters();
+        const auto& referenceClusters = reference.GetClusters();
+        const bool areClustersEqual = clusters.size() == referenceClusters.size() &&
+            std::equal(clusters.begin(), clusters.end(), referenceClusters.begin(), [](const auto& cluster1, const auto& cluster2)
+                {
+                    return cluster1.Offset == cluster2.Offset && cluster1.Count == cluster2.Count;
+                });
+
+        if (areClustersEqual && clustering.GetLightIndices() == reference.GetLightIndices())
+        {
+            return true;
+        }
+
+        std::cerr << "Frame " << frame << ": the clusters have " << clustering.GetLightIndices().size() << " lights, the reference ones "
+            << reference.GetLightIndices().size() << "." << std::endl;
+        return false;
+    }
+
+    // The slice formula of the shader must agree with the distances of the slices.
+    bool ValidateSlices(const LightClustering& clustering)
+    {
+        const auto parameters = clustering.GetShaderParameters();
+        for (uint32_t slice = 0; slice < parameters.SlicesCount; ++slice)
+        {
+            const float nearDistance = clustering.GetSliceDistance(slice);
+            const float farDistance = clustering.GetSliceDistance(slice + 1);
+            const float distances[] = { nearDistance * (1.0f + COVERAGE_TOLERANCE), std::sqrt(nearDistance * farDistance), farDistance * (1.0f - COVERAGE_TOLERANCE) };
+            for (const float distance : distances)
+            {
+                if (GetSlice(distance, parameters) != slice)
+                {
+                    std::cerr << "The view depth " << distance << " is in the slice " << GetSlice(distance, parameters) << " instead of " << slice << "." << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Every light that lights a position must be in the cluster of the position.
+    bool ValidateCoverage(const LightClustering& clustering, const Lights& lights, const XMMATRIX& view, const XMMATRIX& projection,
+        const uint32_t numSamples, const uint32_t frame, std::mt19937& random)
+    {
+        const auto parameters = clustering.GetShaderParameters();
+        const auto& clusters = clustering.GetClusters();
+        const auto& lightIndices = clustering.GetLightIndices();
+
+        XMFLOAT4X4 projectionValues;
+        XMStoreFloat4x4(&projectionValues, projection);
+        const XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        const float logNearPlane = std::log2(CAMERA_NEAR_PLANE);
+        const float logFarPlane = std::log2(CAMERA_FAR_PLANE);
+
+        for (uint32_t sample = 0; sample < numSamples; ++sample)
+        {
+            // Close to the lights: within their height, near the camera, where the clusters are small.
+            const XMFLOAT2 uv = { unitDistribution(random), unitDistribution(random) };
+            const float viewDepth = std::exp2(logNearPlane + (logFarPlane - logNearPlane) * unitDistribution(random) * 0.75f);
+            const float ndcX = uv.x * 2.0f - 1.0f;
+            const float ndcY = 1.0f - uv.y * 2.0f;
+            const XMVECTOR positionVs = XMVectorSet(
+                (ndcX - projectionValues.m[2][0]) / projectionValues.m[0][0] * viewDepth,
+                (ndcY - projectionValues.m[2][1]) / projectionValues.m[1][1] * viewDepth,
+                viewDepth, 1.0f);
+            const XMVECTOR positionWs = XMVector3TransformCoord(positionVs, inverseView);
+
+            const auto& cluster = clusters[GetClusterIndex(uv, viewDepth, parameters)];
+            const auto clusterBegin = lightIndices.begin() + cluster.Offset;
+            const auto clusterEnd = clusterBegin + cluster.Count;
+            const uint32_t numPointLights = static_cast<uint32_t>(lights.PointLights.size());
+
+            const auto validate = [&](const uint32_t lightIndex)
+            {
+                if (std::binary_search(clusterBegin, clusterEnd, lightIndex))
+                {
+                    return true;
+                }
+
+                std::cerr << "Frame " << frame << ": the light " << lightIndex << " lights a position at the depth " << viewDepth
+                    << " but is not in its cluster." << std::endl;
+                return false;
+            };
+
+            for (uint32_t i = 0; i < numPointLights; ++i)
+            {
+                if (IsLit(lights.PointLights[i], positionWs) && !validate(i))
+                {
+                    return false;
+                }
+            }
+
+            for (uint32_t i = 0; i < lights.SpotLights.size(); ++i)
+            {
+                if (IsLit(lights.SpotLights[i], positionWs) && !validate(numPointLights + i))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const uint32_t numLights, const Settings& settings, std::mt19937& random)
+    {
+        const Lights lights = CreateLights(numLights, settings, random);
+        const XMMATRIX projection = CreateCameraProjection();
+
+        LightClustering clustering;
+        LightClustering reference;
+        double buildTime = 0.0;
+        double referenceTime = 0.0;
+        uint64_t numLightIndices = 0;
+        uint64_t numLitClusters = 0;
+        uint32_t maxClusterLights = 0;
+
+        for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+        {
+            const XMMATRIX view = CreateCameraView(numLights, frame, settings);
+
+            buildTime += ToolsCommon::MeasureTime([&]() { clustering.Build(settings.Clustering, view, projection, lights.PointLights, lights.SpotLights); });
+            referenceTime += ToolsCommon::MeasureTime([&]() { reference.BuildReference(settings.Clustering, view, projection, lights.PointLights, lights.SpotLights); });
+
+            if (!ValidateReference(clustering, reference, frame) ||
+                (frame == 0 && !ValidateSlices(clustering)) ||
+                !ValidateCoverage(clustering, lights, view, projection, settings.NumSamples, frame, random))
+            {
+                return false;
+            }
+
+            numLightIndices += clustering.GetLightIndices().size();
+            for (const auto& cluster : clustering.GetClusters())
+            {
+                numLitClusters += cluster.Count > 0 ? 1 : 0;
+                maxClusterLights = std::max(maxClusterLights, cluster.Count);
+            }
+        }
+
+        const double numFrames = static_cast<double>(settings.NumFrames);
+        const double numClusters = static_cast<double>(clustering.GetClusters().size());
+
+        std::cout << "Lights: " << numLights << " (" << lights.SpotLights.size() << " spot)"
+            << "; per frame: build " << buildTime * 1000.0 / numFrames << " us"
+            << ", reference " << referenceTime * 1000.0 / numFrames << " us (" << referenceTime / std::max(buildTime, 1e-9) << "x)"
+            << "; " << static_cast<uint64_t>(numLightIndices / numFrames) << " light indices"
+            << ", " << 100.0 * static_cast<double>(numLitClusters) / numFrames / numClusters << "% clusters lit"
+            << ", " << static_cast<double>(numLightIndices) / std::max(static_cast<double>(numLitClusters), 1.0) << " lights per lit cluster (max " << maxClusterLights << ")" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> lightCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: LightClusteringBenchmark [--lights <count>...] [--spot <percent>] [--frames <count>] [--samples <count>] [--seed <value>]");
+    commandLine.AddOption("--lights", lightCounts);
+    commandLine.AddOption("--spot", settings.SpotPercent, 0.0f, 100.0f);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--samples", settings.NumSamples);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (lightCounts.empty())
+    {
+        lightCounts = { 100, 1000, 10000 };
+    }
+
+    try
+    {
+        std::cout << "Clusters: " << settings.Clustering.TilesX << "x" << settings.Clustering.TilesY << "x" << settings.Clustering.SlicesCount
+            << ", spot lights: " << settings.SpotPercent << "%, frames: " << settings.NumFrames << ", samples per frame: " << settings.NumSamples
+            << ", lights per square unit: " << settings.Density << std::endl;
+
+        std::mt19937 random(settings.Seed);
+        bool success = true;
+        for (const uint32_t numLights : lightCounts)
+        {
+            success &= RunBenchmark(numLights, settings, random);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include <Aabb.h>
+#include <LodSelector.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumObjects = 100000;
+        // The objects share this many LOD chains, as instances of the same models do.
+        uint32_t NumMeshes = 32;
+        uint32_t MaxLods = 5;
+        uint32_t NumFrames = 100;
+        uint32_t Seed = 0;
+        float SceneSize = 2000.0f;
+    };
+
+    // The DeferredLightingDemo's camera.
+    constexpr float CAMERA_FOV = 45.0f;
+    constexpr float CAMERA_ASPECT_RATIO = 16.0f / 9.0f;
+    constexpr float CAMERA_NEAR_PLANE = 0.1f;
+    constexpr float CAMERA_FAR_PLANE = 1000.0f;
+
+    // A selection may differ from the reference only when the projected error is this close to the limit (relative),
+    // where the float error of the single-precision path decides.
+    constexpr double BOUNDARY_TOLERANCE = 1e-4;
+
+    // Stands in for Mesh::Lod.
+    struct Lod
+    {
+        float Error;
+    };
+
+    struct Object
+    {
+        Aabb Bounds;
+        uint32_t MeshIndex;
+    };
+
+    // Each LOD about doubles the error of the previous one, as MeshOptimization's simplification does when it halves the triangles.
+    std::vector<std::vector<Lod>> CreateLodChains(const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> errorDistribution(0.5e-3f, 4e-3f);
+        std::uniform_real_distribution<float> growthDistribution(1.5f, 3.0f);
+        std::uniform_int_distribution<uint32_t> lodCountDistribution(1, std::max(settings.MaxLods, 1u));
+
+        std::vector<std::vector<Lod>> lodChains(settings.NumMeshes);
+        for (auto& lods : lodChains)
+        {
+            lods.resize(lodCountDistribution(random));
+            lods[0].Error = 0.0f;
+
+            float error = errorDistribution(random);
+            for (size_t lodIndex = 1; lodIndex < lods.size(); ++lodIndex)
+            {
+                lods[lodIndex].Error = error;
+                error *= growthDistribution(random);
+            }
+        }
+
+        return lodChains;
+    }
+
+    std::vector<Object> CreateObjects(const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> positionDistribution(-settings.SceneSize * 0.5f, settings.SceneSize * 0.5f);
+        std::uniform_real_distribution<float> heightDistribution(0.0f, 20.0f);
+        // Mostly small props, some buildings.
+        std::lognormal_distribution<float> sizeDistribution(0.5f, 1.0f);
+        std::uniform_int_distribution<uint32_t> meshDistribution(0, settings.NumMeshes - 1);
+
+        std::vector<Object> objects(settings.NumObjects);
+        for (auto& object : objects)
+        {
+            const XMVECTOR center = XMVectorSet(positionDistribution(random), heightDistribution(random), positionDistribution(random), 0.0f);
+            const XMVECTOR extents = XMVectorSet(sizeDistribution(random), sizeDistribution(random), sizeDistribution(random), 0.0f);
+            object.Bounds = { center - extents, center + extents };
+            object.MeshIndex = meshDistribution(random);
+        }
+
+        return objects;
+    }
+
+    // The camera circles the scene at walking height, looking around.
+    XMMATRIX CreateCameraView(const uint32_t frame, const Settings& settings)
+    {
+        const float angle = static_cast<float>(frame) * 0.05f;
+        const float radius = settings.SceneSize * 0.25f;
+        const XMVECTOR eye = XMVectorSet(std::cos(angle) * radius, 2.0f, std::sin(angle) * radius, 1.0f);
+        const XMVECTOR target = eye + XMVectorSet(std::cos(angle * 3.0f), -0.1f, std::sin(angle * 3.0f), 0.0f);
+        return XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    XMMATRIX CreateCameraProjection()
+    {
+        return XMMatrixPerspectiveFovLH(XMConvertToRadians(CAMERA_FOV), CAMERA_ASPECT_RATIO, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+    }
+
+    /**
+     * The same selection in double precision and without the LodSelector's shortcuts:
+     * the center is transformed by the full view matrix, and the projection scale is computed from the field of view.
+     * Returns the LOD, and how close the deciding projected error is to the limit (relative).
+     */
+    uint32_t SelectLodReference(const Object& object, const std::vector<Lod>& lods, const XMFLOAT4X4& view, const double maxScreenError, double& outBoundaryDistance)
+    {
+        XMFLOAT3 min, max;
+        XMStoreFloat3(&min, object.Bounds.Min);
+        XMStoreFloat3(&max, object.Bounds.Max);
+
+        const double center[3] = { (min.x + static_cast<double>(max.x)) * 0.5, (min.y + static_cast<double>(max.y)) * 0.5, (min.z + static_cast<double>(max.z)) * 0.5 };
+        const double size[3] = { static_cast<double>(max.x) - min.x, static_cast<double>(max.y) - min.y, static_cast<double>(max.z) - min.z };
+        const double radius = std::sqrt(size[0] * size[0] + size[1] * size[1] + size[2] * size[2]) * 0.5;
+
+        // Row vectors: the view depth is the dot product with the third column.
+        const double depth = center[0] * view.m[0][2] + center[1] * view.m[1][2] + center[2] * view.m[2][2] + view.m[3][2];
+        const double projectionScale = 1.0 / std::tan(CAMERA_FOV * 3.14159265358979323846 / 360.0);
+        const double screenSize = radius * projectionScale / std::max({ depth, radius, 1e-6 });
+
+        outBoundaryDistance = std::numeric_limits<double>::infinity();
+
+        uint32_t selectedLod = 0;
+        for (uint32_t lodIndex = 0; lodIndex < lods.size(); ++lodIndex)
+        {
+            const double projectedError = lods[lodIndex].Error * screenSize;
+            if (lodIndex > 0)
+            {
+                outBoundaryDistance = std::min(outBoundaryDistance, std::abs(projectedError - maxScreenError) / maxScreenError);
+            }
+
+            if (projectedError <= maxScreenError)
+            {
+                selectedLod = lodIndex;
+            }
+        }
+
+        return selectedLod;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const Settings& settings, std::mt19937& random)
+    {
+        const std::vector<std::vector<Lod>> lodChains = CreateLodChains(settings, random);
+        const std::vector<Object> objects = CreateObjects(settings, random);
+        const XMMATRIX projection = CreateCameraProjection();
+
+        std::vector<uint32_t> selectedLods(objects.size());
+        std::vector<uint32_t> referenceLods(objects.size());
+        std::vector<double> boundaryDistances(objects.size());
+        std::vector<size_t> lodHistogram(settings.MaxLods, 0);
+
+        double selectionTime = 0.0;
+        double referenceTime = 0.0;
+        size_t numBoundaryMismatches = 0;
+
+        for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+        {
+            const XMMATRIX view = CreateCameraView(frame, settings);
+
+            // As DeferredLightingDemo and GameObject::SelectLods do.
+            selectionTime += ToolsCommon::MeasureTime([&]()
+                {
+                    const LodSelector lodSelector(view, projection);
+                    for (size_t i = 0; i < objects.size(); ++i)
+                    {
+                        const auto& lods = lodChains[objects[i].MeshIndex];
+                        const float screenSize = lodSelector.ComputeScreenSize(objects[i].Bounds);
+                        selectedLods[i] = lodSelector.SelectLod(lods.data(), static_cast<uint32_t>(lods.size()), screenSize);
+                    }
+                });
+
+            referenceTime += ToolsCommon::MeasureTime([&]()
+                {
+                    XMFLOAT4X4 viewMatrix;
+                    XMStoreFloat4x4(&viewMatrix, view);
+                    for (size_t i = 0; i < objects.size(); ++i)
+                    {
+                        referenceLods[i] = SelectLodReference(objects[i], lodChains[objects[i].MeshIndex], viewMatrix, LodSelector::DEFAULT_MAX_SCREEN_ERROR, boundaryDistances[i]);
+                    }
+                });
+
+            for (size_t i = 0; i < objects.size(); ++i)
+            {
+                if (selectedLods[i] != referenceLods[i])
+                {
+                    if (boundaryDistances[i] > BOUNDARY_TOLERANCE)
+                    {
+                        std::cerr << "Frame " << frame << ": the object " << i << " has selected the LOD " << selectedLods[i]
+                            << " instead of " << referenceLods[i] << "." << std::endl;
+                        return false;
+                    }
+
+                    ++numBoundaryMismatches;
+                }
+
+                ++lodHistogram[selectedLods[i]];
+            }
+        }
+
+        // The selection must not degenerate to a single LOD (e.g., because of a wrong projection scale).
+        const size_t numSelectedLodIndices = std::count_if(lodHistogram.begin(), lodHistogram.end(), [](const size_t count) { return count > 0; });
+        if (settings.MaxLods > 1 && numSelectedLodIndices < 2)
+        {
+            std::cerr << "Only " << numSelectedLodIndices << " LOD index has ever been selected." << std::endl;
+            return false;
+        }
+
+        const double numSelections = static_cast<double>(objects.size()) * settings.NumFrames;
+        std::cout << "Objects: " << settings.NumObjects << ", meshes: " << settings.NumMeshes << ", frames: " << settings.NumFrames
+            << "; LodSelector: " << selectionTime / settings.NumFrames << " ms/frame (" << selectionTime * 1e6 / numSelections << " ns/object)"
+            << ", reference: " << referenceTime / settings.NumFrames << " ms/frame (" << referenceTime * 1e6 / numSelections << " ns/object)" << std::endl;
+
+        std::cout << "LODs:";
+        for (size_t lodIndex = 0; lodIndex < lodHistogram.size(); ++lodIndex)
+        {
+            std::cout << " " << lodIndex << ": " << 100.0 * static_cast<double>(lodHistogram[lodIndex]) / numSelections << "%";
+        }
+        std::cout << "; mismatches at the boundary: " << numBoundaryMismatches << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: LodSelectionBenchmark [--objects <count>] [--meshes <count>] [--lods <count>] [--frames <count>] [--seed <value>]");
+    commandLine.AddOption("--objects", settings.NumObjects, 1u);
+    commandLine.AddOption("--meshes", settings.NumMeshes, 1u);
+    commandLine.AddOption("--lods", settings.MaxLods, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        std::mt19937 random(settings.Seed);
+        if (!RunBenchmark(settings, random))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
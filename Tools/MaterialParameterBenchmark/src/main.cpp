@@ -0,0 +1,409 @@
+#include <MaterialConstantBuffer.h>
+#include <DX12Library/HashUtils.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumLights = 10000;
+        uint32_t NumFrames = 100;
+        // The share of the lights whose color changes between the two passes of a frame.
+        float AnimatedPercent = 10.0f;
+        uint32_t Seed = 0;
+    };
+
+    // The constant buffer alignment of D3D12.
+    constexpr size_t UPLOAD_ALIGNMENT = 256;
+
+    struct Float4
+    {
+        float X, Y, Z, W;
+    };
+
+    /**
+     * The material constant buffer of a light volume pass:
+     *     float4 PositionWS; float4 Color; float Attenuation[3]; float Intensity;
+     * The 4 parameter sets written per light and per frame.
+     */
+    struct LightMaterialData
+    {
+        Float4 PositionWs;
+        Float4 Color;
+        float Attenuation[3];
+        float Intensity;
+    };
+
+    // Stands in for the reflection of a shader: the variables, and their indices by HashUtils::Fnv1a of their names.
+    struct Layout
+    {
+        struct Variable
+        {
+            std::string Name;
+            uint32_t Offset;
+            uint32_t Size;
+        };
+
+        size_t Size = 0;
+        std::vector<Variable> Variables;
+        std::unordered_map<uint64_t, size_t> VariablesNameHashCache;
+
+        // The lookup of Material::FindParameter.
+        MaterialParameterHandle FindParameter(const std::string_view name) const
+        {
+            const auto findResult = VariablesNameHashCache.find(HashUtils::Fnv1a(name));
+            if (findResult == VariablesNameHashCache.end())
+            {
+                return {};
+            }
+
+            const auto& variable = Variables[findResult->second];
+
+            MaterialParameterHandle handle;
+            handle.Offset = variable.Offset;
+            handle.Size = variable.Size;
+            handle.Layout = this;
+            return handle;
+        }
+    };
+
+    Layout CreateLightMaterialLayout()
+    {
+        Layout layout;
+        layout.Size = sizeof(LightMaterialData);
+        layout.Variables = {
+            { "PositionWS", offsetof(LightMaterialData, PositionWs), sizeof(Float4) },
+            { "Color", offsetof(LightMaterialData, Color), sizeof(Float4) },
+            { "Attenuation", offsetof(LightMaterialData, Attenuation), sizeof(float) * 3 },
+            { "Intensity", offsetof(LightMaterialData, Intensity), sizeof(float) },
+        };
+
+        for (size_t i = 0; i < layout.Variables.size(); ++i)
+        {
+            layout.VariablesNameHashCache.emplace(HashUtils::Fnv1a(layout.Variables[i].Name), i);
+        }
+
+        return layout;
+    }
+
+    struct Light
+    {
+        Float4 PositionWs;
+        Float4 Color;
+        std::vector<float> Attenuation;
+        float Intensity;
+    };
+
+    // The upload buffer of a command list: reset (with a new generation) every frame.
+    class UploadBuffer
+    {
+    public:
+        explicit UploadBuffer(const size_t capacity)
+            : m_Data(capacity)
+        {}
+
+        void Reset()
+        {
+            m_Offset = 0;
+            ++m_Generation;
+        }
+
+        uint64_t GetGeneration() const { return m_Generation; }
+        size_t GetNumAllocations() const { return m_NumAllocations; }
+
+        // Returns the offset of the copy, standing in for its GPU address.
+        uint64_t Upload(const MaterialConstantBuffer& constantBuffer)
+        {
+            const size_t size = (constantBuffer.GetSize() + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+            if (m_Offset + size > m_Data.size())
+            {
+                throw std::runtime_error("The upload buffer is full.");
+            }
+
+            memcpy(m_Data.data() + m_Offset, constantBuffer.GetData(), constantBuffer.GetSize());
+            const uint64_t address = m_Offset;
+            m_Offset += size;
+            ++m_NumAllocations;
+            return address;
+        }
+
+        const uint8_t* GetData(const uint64_t address) const { return m_Data.data() + address; }
+
+    private:
+        std::vector<uint8_t> m_Data;
+        size_t m_Offset = 0;
+        uint64_t m_Generation = 1;
+        size_t m_NumAllocations = 0;
+    };
+
+    // Binds the material as Material::UploadConstantBuffer does. Returns the address the draw reads from.
+    uint64_t Bind(MaterialConstantBuffer& constantBuffer, UploadBuffer& uploadBuffer)
+    {
+        if (constantBuffer.NeedsUpload(uploadBuffer.GetGeneration()))
+        {
+            constantBuffer.OnUploaded(uploadBuffer.GetGeneration(), uploadBuffer.Upload(constantBuffer));
+        }
+
+        return constantBuffer.GetUploadedAddress();
+    }
+
+    template <typename TFunction>
+    bool Throws(TFunction&& function)
+    {
+        try
+        {
+            function();
+        }
+        catch (const std::invalid_argument&)
+        {
+            return true;
+        }
+
+        return false;
+    }
+
+    // The handle-based setters must reject the same values as the string ones.
+    bool CheckSizes(const Layout& layout)
+    {
+        MaterialConstantBuffer constantBuffer(layout.Size, &layout);
+        const auto color = layout.FindParameter("Color");
+        const auto attenuation = layout.FindParameter("Attenuation");
+
+        const float scalar = 1.0f;
+        const float values[4] = {};
+        const bool isCorrect =
+            Throws([&]() { constantBuffer.Write(color, sizeof(scalar), &scalar, false); }) &&
+            Throws([&]() { constantBuffer.Write(attenuation, sizeof(values), values, true); }) &&
+            !Throws([&]() { constantBuffer.Write(attenuation, sizeof(float) * 2, values, true); }) &&
+            !Throws([&]() { constantBuffer.Write(color, sizeof(Float4), values, false); }) &&
+            !Throws([&]() { constantBuffer.Write(layout.FindParameter("Missing"), sizeof(scalar), &scalar, false); });
+
+        const Layout otherLayout = CreateLightMaterialLayout();
+        const bool isOtherLayoutRejected = Throws([&]() { constantBuffer.Write(otherLayout.FindParameter("Color"), sizeof(Float4), values, false); });
+
+        if (!isCorrect || !isOtherLayoutRejected)
+        {
+            std::cerr << "The size or the layout of a handle-based write has not been checked." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const Settings& settings, std::mt19937& random)
+    {
+        const Layout layout = CreateLightMaterialLayout();
+        if (!CheckSizes(layout))
+        {
+            return false;
+        }
+
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+        std::vector<Light> lights(settings.NumLights);
+        for (auto& light : lights)
+        {
+            light.PositionWs = { unitDistribution(random) * 100.0f, unitDistribution(random) * 10.0f, unitDistribution(random) * 100.0f, 1.0f };
+            light.Color = { unitDistribution(random), unitDistribution(random), unitDistribution(random), 1.0f };
+            light.Attenuation = { 1.0f, 0.1f, unitDistribution(random) };
+            light.Intensity = 1.0f + unitDistribution(random);
+        }
+
+        // The same materials, written by name and by handle.
+        std::vector<MaterialConstantBuffer> stringMaterials(settings.NumLights, MaterialConstantBuffer(layout.Size, &layout));
+        std::vector<MaterialConstantBuffer> handleMaterials(settings.NumLights, MaterialConstantBuffer(layout.Size, &layout));
+
+        const auto positionParameter = layout.FindParameter("PositionWS");
+        const auto colorParameter = layout.FindParameter("Color");
+        const auto attenuationParameter = layout.FindParameter("Attenuation");
+        const auto intensityParameter = layout.FindParameter("Intensity");
+
+        // As Material::SetVariable(name, ...).
+        const auto writeByName = [&layout](MaterialConstantBuffer& material, const std::string_view name, const size_t size, const void* data, const bool array)
+        {
+            material.Write(layout.FindParameter(name), size, data, array);
+        };
+
+        // Lights drawn in both passes of the frame (e.g., stencil and shading), with the color of some changing in between.
+        UploadBuffer uploadBuffer(settings.NumLights * 2 * UPLOAD_ALIGNMENT);
+
+        double stringTime = 0.0;
+        double handleTime = 0.0;
+        double bindTime = 0.0;
+        size_t numDirtyAfterWrites = 0;
+        size_t numBinds = 0;
+
+        for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+        {
+            uploadBuffer.Reset();
+            const size_t numAllocationsBefore = uploadBuffer.GetNumAllocations();
+
+            stringTime += ToolsCommon::MeasureTime([&]()
+                {
+                    for (size_t i = 0; i < lights.size(); ++i)
+                    {
+                        const auto& light = lights[i];
+                        auto& material = stringMaterials[i];
+                        writeByName(material, "PositionWS", sizeof(light.PositionWs), &light.PositionWs, false);
+                        writeByName(material, "Color", sizeof(light.Color), &light.Color, false);
+                        writeByName(material, "Attenuation", sizeof(float) * light.Attenuation.size(), light.Attenuation.data(), true);
+                        writeByName(material, "Intensity", sizeof(light.Intensity), &light.Intensity, false);
+                    }
+                });
+
+            handleTime += ToolsCommon::MeasureTime([&]()
+                {
+                    for (size_t i = 0; i < lights.size(); ++i)
+                    {
+                        const auto& light = lights[i];
+                        auto& material = handleMaterials[i];
+                        material.Write(positionParameter, sizeof(light.PositionWs), &light.PositionWs, false);
+                        material.Write(colorParameter, sizeof(light.Color), &light.Color, false);
+                        material.Write(attenuationParameter, sizeof(float) * light.Attenuation.size(), light.Attenuation.data(), true);
+                        material.Write(intensityParameter, sizeof(light.Intensity), &light.Intensity, false);
+                    }
+                });
+
+            // Only the first frame changes the data: the following ones write the same values.
+            size_t numDirty = 0;
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                if (memcmp(stringMaterials[i].GetData(), handleMaterials[i].GetData(), layout.Size) != 0)
+                {
+                    std::cerr << "The light " << i << " has different data when written by name and by handle." << std::endl;
+                    return false;
+                }
+
+                numDirty += handleMaterials[i].IsDirty() ? 1 : 0;
+            }
+
+            const size_t numExpectedDirty = frame == 0 ? lights.size() : 0;
+            if (numDirty != numExpectedDirty)
+            {
+                std::cerr << "Frame " << frame << ": " << numDirty << " materials are dirty after the writes instead of " << numExpectedDirty << "." << std::endl;
+                return false;
+            }
+
+            numDirtyAfterWrites += numDirty;
+
+            std::vector<uint64_t> firstPassAddresses(lights.size());
+            bindTime += ToolsCommon::MeasureTime([&]()
+                {
+                    for (size_t i = 0; i < lights.size(); ++i)
+                    {
+                        firstPassAddresses[i] = Bind(handleMaterials[i], uploadBuffer);
+                    }
+                });
+
+            // The previous frame's uploads have been released: every material is uploaded again, once.
+            if (uploadBuffer.GetNumAllocations() - numAllocationsBefore != lights.size())
+            {
+                std::cerr << "Frame " << frame << ": " << uploadBuffer.GetNumAllocations() - numAllocationsBefore << " uploads in the first pass instead of " << lights.size() << "." << std::endl;
+                return false;
+            }
+
+            std::vector<bool> isAnimated(lights.size());
+            size_t numAnimated = 0;
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                isAnimated[i] = unitDistribution(random) * 100.0f < settings.AnimatedPercent;
+                if (isAnimated[i])
+                {
+                    auto& color = lights[i].Color;
+                    color.X = 1.0f - color.X;
+                    handleMaterials[i].Write(colorParameter, sizeof(color), &color, false);
+                    writeByName(stringMaterials[i], "Color", sizeof(color), &color, false);
+                    ++numAnimated;
+                }
+            }
+
+            // The first pass's draws still read the previous uploads, so a changed material is uploaded again as a whole.
+            const size_t numAllocationsAfterFirstPass = uploadBuffer.GetNumAllocations();
+            std::vector<uint64_t> secondPassAddresses(lights.size());
+            bindTime += ToolsCommon::MeasureTime([&]()
+                {
+                    for (size_t i = 0; i < lights.size(); ++i)
+                    {
+                        secondPassAddresses[i] = Bind(handleMaterials[i], uploadBuffer);
+                    }
+                });
+
+            numBinds += lights.size() * 2;
+
+            if (uploadBuffer.GetNumAllocations() - numAllocationsAfterFirstPass != numAnimated)
+            {
+                std::cerr << "Frame " << frame << ": " << uploadBuffer.GetNumAllocations() - numAllocationsAfterFirstPass << " uploads in the second pass instead of " << numAnimated << "." << std::endl;
+                return false;
+            }
+
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                // The unchanged lights have reused their upload, and every upload holds the current data.
+                const bool isReused = secondPassAddresses[i] == firstPassAddresses[i];
+                if (isReused == isAnimated[i] || memcmp(uploadBuffer.GetData(secondPassAddresses[i]), handleMaterials[i].GetData(), layout.Size) != 0)
+                {
+                    std::cerr << "Frame " << frame << ": the light " << i << " has bound a wrong upload." << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        const double numWrites = static_cast<double>(settings.NumLights) * 4.0 * settings.NumFrames;
+        std::cout << "Lights: " << settings.NumLights << " x 4 parameters, frames: " << settings.NumFrames
+            << "; by name: " << stringTime / settings.NumFrames << " ms/frame (" << stringTime * 1e6 / numWrites << " ns/write)"
+            << ", by handle: " << handleTime / settings.NumFrames << " ms/frame (" << handleTime * 1e6 / numWrites << " ns/write)"
+            << ", speedup: " << stringTime / std::max(handleTime, 1e-6) << "x" << std::endl;
+        std::cout << "Binds: " << numBinds << ", uploads: " << uploadBuffer.GetNumAllocations()
+            << " (" << 100.0 * uploadBuffer.GetNumAllocations() / std::max<size_t>(numBinds, 1) << "%), dirty after the writes: " << numDirtyAfterWrites
+            << ", bind time: " << bindTime / settings.NumFrames << " ms/frame" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: MaterialParameterBenchmark [--lights <count>] [--frames <count>] [--animated <percent>] [--seed <value>]");
+    commandLine.AddOption("--lights", settings.NumLights, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--animated", settings.AnimatedPercent);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        std::mt19937 random(settings.Seed);
+        if (!RunBenchmark(settings, random))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include <MeshOptimization.h>
+
+#include <meshoptimizer.h>
+
+#include <ToolsCommon/CommandLine.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// The results are only meaningful with the real library (MeshOptimization uses the options of meshopt_simplify, added in 0.19).
+static_assert(MESHOPTIMIZER_VERSION >= 190, "MeshOptimizationCheck needs meshoptimizer 0.19 or later.");
+
+namespace
+{
+    struct Settings
+    {
+        // The sphere has segments x segments / 2 quads, the grid segments x segments.
+        uint32_t NumSegments = 64;
+        uint32_t MaxLods = 3;
+        uint32_t Seed = 0;
+    };
+
+    constexpr float PI = 3.14159265358979f;
+
+    struct Vertex
+    {
+        float Position[3];
+        // The index of the vertex when the mesh was built, which identifies it after the remap.
+        uint32_t Id;
+    };
+
+    struct SampleMesh
+    {
+        std::string Name;
+        std::vector<Vertex> Vertices;
+        std::vector<uint32_t> Indices;
+    };
+
+    // A triangle identified by the ids of its vertices, rotated so that the smallest one comes first (which keeps the winding).
+    using Triangle = std::array<uint32_t, 3>;
+
+    Triangle MakeTriangle(const uint32_t id0, const uint32_t id1, const uint32_t id2)
+    {
+        if (id1 < id0 && id1 < id2)
+        {
+            return { id1, id2, id0 };
+        }
+
+        if (id2 < id0 && id2 < id1)
+        {
+            return { id2, id0, id1 };
+        }
+
+        return { id0, id1, id2 };
+    }
+
+    std::vector<Triangle> GetSortedTriangles(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+    {
+        std::vector<Triangle> triangles;
+        triangles.reserve(indices.size() / 3);
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            triangles.push_back(MakeTriangle(vertices[indices[i]].Id, vertices[indices[i + 1]].Id, vertices[indices[i + 2]].Id));
+        }
+
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    /**
+     * The triangles and the vertices are shuffled, as an exporter that does not care about the vertex cache would leave them,
+     * and a few vertices are not referenced, so that the vertex fetch optimization also has to drop some.
+     */
+    void Shuffle(SampleMesh& mesh, std::mt19937& random)
+    {
+        const size_t numTriangles = mesh.Indices.size() / 3;
+        std::vector<uint32_t> triangleOrder(numTriangles);
+        std::iota(triangleOrder.begin(), triangleOrder.end(), 0);
+        std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+
+        std::vector<uint32_t> vertexOrder(mesh.Vertices.size());
+        std::iota(vertexOrder.begin(), vertexOrder.end(), 0);
+        std::shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+
+        // Old vertex index -> new vertex index.
+        std::vector<uint32_t> vertexRemap(mesh.Vertices.size());
+        std::vector<Vertex> shuffledVertices(mesh.Vertices.size());
+        for (size_t newIndex = 0; newIndex < vertexOrder.size(); ++newIndex)
+        {
+            vertexRemap[vertexOrder[newIndex]] = static_cast<uint32_t>(newIndex);
+            shuffledVertices[newIndex] = mesh.Vertices[vertexOrder[newIndex]];
+        }
+
+        std::vector<uint32_t> shuffledIndices;
+        shuffledIndices.reserve(mesh.Indices.size());
+        for (const uint32_t triangle : triangleOrder)
+        {
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                shuffledIndices.push_back(vertexRemap[mesh.Indices[triangle * 3 + corner]]);
+            }
+        }
+
+        mesh.Vertices = std::move(shuffledVertices);
+        mesh.Indices = std::move(shuffledIndices);
+    }
+
+    void AddVertex(SampleMesh& mesh, const float x, const float y, const float z)
+    {
+        mesh.Vertices.push_back({ { x, y, z }, static_cast<uint32_t>(mesh.Vertices.size()) });
+    }
+
+    void AddQuad(SampleMesh& mesh, const uint32_t v00, const uint32_t v01, const uint32_t v10, const uint32_t v11)
+    {
+        mesh.Indices.insert(mesh.Indices.end(), { v00, v10, v11, v00, v11, v01 });
+    }
+
+    // Seams and poles included: their vertices are duplicated, as with texture coordinates.
+    SampleMesh CreateSphere(const uint32_t numSegments)
+    {
+        SampleMesh mesh;
+        mesh.Name = "Sphere";
+
+        const uint32_t numRings = std::max(numSegments / 2, 2u);
+        for (uint32_t ring = 0; ring <= numRings; ++ring)
+        {
+            const float theta = PI * static_cast<float>(ring) / static_cast<float>(numRings);
+            for (uint32_t segment = 0; segment <= numSegments; ++segment)
+            {
+                const float phi = 2.0f * PI * static_cast<float>(segment) / static_cast<float>(numSegments);
+                AddVertex(mesh, std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            }
+        }
+
+        for (uint32_t ring = 0; ring < numRings; ++ring)
+        {
+            for (uint32_t segment = 0; segment < numSegments; ++segment)
+            {
+                const uint32_t v00 = ring * (numSegments + 1) + segment;
+                const uint32_t v10 = v00 + numSegments + 1;
+                AddQuad(mesh, v00, v00 + 1, v10, v10 + 1);
+            }
+        }
+
+        return mesh;
+    }
+
+    // A wavy terrain, with an unreferenced vertex every 7.
+    SampleMesh CreateGrid(const uint32_t numSegments)
+    {
+        SampleMesh mesh;
+        mesh.Name = "Grid";
+
+        const uint32_t rowSize = numSegments + 1;
+        for (uint32_t z = 0; z <= numSegments; ++z)
+        {
+            for (uint32_t x = 0; x <= numSegments; ++x)
+            {
+                AddVertex(mesh, static_cast<float>(x), std::sin(static_cast<float>(x) * 0.3f) * std::cos(static_cast<float>(z) * 0.2f), static_cast<float>(z));
+            }
+        }
+
+        const size_t numUsedVertices = mesh.Vertices.size();
+        for (size_t i = 0; i < numUsedVertices; i += 7)
+        {
+            AddVertex(mesh, 0.0f, -100.0f, 0.0f);
+        }
+
+        for (uint32_t z = 0; z < numSegments; ++z)
+        {
+            for (uint32_t x = 0; x < numSegments; ++x)
+            {
+                const uint32_t v00 = z * rowSize + x;
+                AddQuad(mesh, v00, v00 + 1, v00 + rowSize, v00 + rowSize + 1);
+            }
+        }
+
+        return mesh;
+    }
+
+    void PrintStatistics(const MeshOptimization::Statistics& statistics)
+    {
+        std::cout << "ACMR " << statistics.Acmr << ", ATVR " << statistics.Atvr
+            << ", overdraw " << statistics.Overdraw << ", overfetch " << statistics.Overfetch;
+    }
+
+    // Returns false if a check fails.
+    bool CheckMesh(SampleMesh mesh, const Settings& settings)
+    {
+        const std::vector<Triangle> originalTriangles = GetSortedTriangles(mesh.Indices, mesh.Vertices);
+
+        MeshOptimization::Settings optimizationSettings;
+        optimizationSettings.MaxLods = settings.MaxLods;
+
+        const size_t numVerticesBefore = mesh.Vertices.size();
+        const MeshOptimization::Result result = MeshOptimization::Optimize(mesh.Indices,
+            mesh.Vertices[0].Position, mesh.Vertices.size(), sizeof(Vertex), sizeof(Vertex), optimizationSettings);
+        MeshOptimization::RemapVertices(mesh.Vertices, result);
+
+        std::cout << mesh.Name << ": " << originalTriangles.size() << " triangles, " << numVerticesBefore << " -> " << mesh.Vertices.size() << " vertices" << std::endl;
+        std::cout << "    Before: ";
+        PrintStatistics(result.Before);
+        std::cout << std::endl << "    After:  ";
+        PrintStatistics(result.After);
+        std::cout << std::endl;
+
+        if (mesh.Vertices.size() != result.NumVertices)
+        {
+            std::cerr << mesh.Name << ": " << mesh.Vertices.size() << " vertices after the remap instead of " << result.NumVertices << "." << std::endl;
+            return false;
+        }
+
+        const auto isOutOfRange = [&mesh](const uint32_t index) { return index >= mesh.Vertices.size(); };
+        if (std::any_of(mesh.Indices.begin(), mesh.Indices.end(), isOutOfRange))
+        {
+            std::cerr << mesh.Name << ": an index is out of range after the remap." << std::endl;
+            return false;
+        }
+
+        // Only the order of the triangles and of the vertices may change.
+        if (GetSortedTriangles(mesh.Indices, mesh.Vertices) != originalTriangles)
+        {
+            std::cerr << mesh.Name << ": the optimized triangles are not the original ones." << std::endl;
+            return false;
+        }
+
+        // The remapped vertices only change places: each one keeps its position.
+        std::vector<bool> isIdUsed(numVerticesBefore, false);
+        for (const Vertex& vertex : mesh.Vertices)
+        {
+            if (vertex.Id >= numVerticesBefore || isIdUsed[vertex.Id])
+            {
+                std::cerr << mesh.Name << ": the vertex " << vertex.Id << " is missing or duplicated after the remap." << std::endl;
+                return false;
+            }
+
+            isIdUsed[vertex.Id] = true;
+        }
+
+        // ATVR is not compared: the unreferenced vertices count before the remap, but not after.
+        // The triangles have been shuffled, so any vertex cache optimization does better.
+        if (result.After.Acmr >= result.Before.Acmr)
+        {
+            std::cerr << mesh.Name << ": the vertex cache efficiency has not improved." << std::endl;
+            return false;
+        }
+
+        size_t previousIndexCount = mesh.Indices.size();
+        for (size_t lodIndex = 0; lodIndex < result.Lods.size(); ++lodIndex)
+        {
+            const auto& lod = result.Lods[lodIndex];
+            std::cout << "    LOD " << lodIndex + 1 << ": " << lod.Indices.size() / 3 << " triangles, error " << lod.Error << std::endl;
+
+            if (lod.Indices.size() % 3 != 0 || lod.Indices.size() >= previousIndexCount || std::any_of(lod.Indices.begin(), lod.Indices.end(), isOutOfRange))
+            {
+                std::cerr << mesh.Name << ": the LOD " << lodIndex + 1 << " is invalid." << std::endl;
+                return false;
+            }
+
+            previousIndexCount = lod.Indices.size();
+        }
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: MeshOptimizationCheck [--segments <count>] [--lods <count>] [--seed <value>]");
+    commandLine.AddOption("--segments", settings.NumSegments, 4u);
+    commandLine.AddOption("--lods", settings.MaxLods);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        std::cout << "meshoptimizer " << MESHOPTIMIZER_VERSION / 1000 << "." << MESHOPTIMIZER_VERSION % 1000 / 10 << std::endl;
+
+        std::mt19937 random(settings.Seed);
+
+        std::vector<SampleMesh> meshes;
+        meshes.push_back(CreateSphere(settings.NumSegments));
+        meshes.push_back(CreateGrid(settings.NumSegments));
+
+        bool success = true;
+        for (SampleMesh& mesh : meshes)
+        {
+            Shuffle(mesh, random);
+            success &= CheckMesh(mesh, settings);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
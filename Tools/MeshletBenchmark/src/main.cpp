@@ -0,0 +1,379 @@
+#include "MeshletBuilder.h"
+#include "MeshletCulling.h"
+#include "MeshletStore.h"
+
+#include <ModelCooker.h>
+
+#include <DX12Library/ThreadPool.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The models of MeshletsDemo.
+    const char* const DEFAULT_MODEL_PATHS[] = {
+        "Assets/Models/teapot/teapot.obj",
+        "Assets/Models/tv/TV.fbx",
+    };
+
+    // The calling thread participates in ThreadPool::ParallelFor, so N threads need N - 1 workers.
+    std::unique_ptr<ThreadPool> CreateThreadPool(const uint32_t numThreads)
+    {
+        if (numThreads <= 1)
+        {
+            return nullptr;
+        }
+
+        return std::make_unique<ThreadPool>(numThreads - 1);
+    }
+
+    struct Totals
+    {
+        size_t NumTriangles = 0;
+        size_t NumMeshlets = 0;
+        size_t NumMeshletVertices = 0;
+        uint32_t NumLodLevels = 0;
+    };
+
+    // Builds the meshlets of all the meshes of the model, like MeshletsDemo::LoadContent.
+    Totals BuildMeshlets(const CookedModelFile& model, const MeshletBuilder::Settings& settings, ThreadPool* threadPool)
+    {
+        std::vector<MeshletBuilder::Output> outputs(model.m_Meshes.size());
+
+        const auto buildMesh = [&](const size_t meshIndex)
+        {
+            const CookedModelFile::Mesh& mesh = model.m_Meshes[meshIndex];
+            const MeshletBuilder::MeshView meshView = {
+                mesh.Vertices.empty() ? nullptr : mesh.Vertices[0].Position, sizeof(CookedModelFile::Vertex), mesh.Vertices.size(),
+                mesh.Indices.data(), mesh.Indices.size(),
+            };
+            outputs[meshIndex] = MeshletBuilder::BuildMeshlets(meshView, settings, threadPool);
+        };
+
+        if (threadPool != nullptr)
+        {
+            threadPool->ParallelFor(outputs.size(), buildMesh);
+        }
+        else
+        {
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                buildMesh(i);
+            }
+        }
+
+        Totals totals;
+        for (size_t meshIndex = 0; meshIndex < outputs.size(); ++meshIndex)
+        {
+            const MeshletBuilder::Output& output = outputs[meshIndex];
+            totals.NumTriangles += model.m_Meshes[meshIndex].Indices.size() / 3;
+            totals.NumMeshlets += output.Meshlets.size();
+            totals.NumMeshletVertices += output.VertexIndices.size();
+
+            for (const MeshletLod& lod : output.Lods)
+            {
+                totals.NumLodLevels = std::max(totals.NumLodLevels, lod.m_Level + 1);
+            }
+        }
+
+        return totals;
+    }
+
+    // Reports the build time of all the meshes of the model for 1, 2, 4, ... threads.
+    void RunBenchmark(const std::filesystem::path& path, const bool flipNormals, const MeshletBuilder::Settings& settings,
+        const uint32_t maxThreads, const uint32_t numIterations)
+    {
+        // The same input as at runtime: imported and optimized (see ModelLoader).
+        CookedModelFile model = ModelCooker::Import(path.string(), flipNormals);
+        ModelCooker::Optimize(model);
+
+        std::cout << path.string() << std::endl;
+
+        for (uint32_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+        {
+            const auto threadPool = CreateThreadPool(numThreads);
+
+            double bestTime = std::numeric_limits<double>::max();
+            Totals totals;
+
+            for (uint32_t iteration = 0; iteration < numIterations; ++iteration)
+            {
+                bestTime = std::min(bestTime, ToolsCommon::MeasureTime([&]() { totals = BuildMeshlets(model, settings, threadPool.get()); }));
+            }
+
+            std::cout << "Threads: " << numThreads
+                << ", meshes: " << model.m_Meshes.size()
+                << ", triangles: " << totals.NumTriangles
+                << ", meshlets: " << totals.NumMeshlets
+                << ", meshlet vertices: " << totals.NumMeshletVertices;
+            if (settings.BuildClusterLod)
+            {
+                std::cout << ", LOD levels: " << totals.NumLodLevels;
+            }
+            std::cout << ", build: " << bestTime << " ms" << std::endl;
+
+            if (numThreads == maxThreads)
+            {
+                break;
+            }
+        }
+    }
+
+    // The planes of a (row-vector) view-projection matrix, pointing inwards, in the order and layout of Camera::Frustum.
+    void ExtractFrustumPlanes(const DirectX::XMMATRIX& viewProjection, DirectX::XMFLOAT4 planes[MeshletCulling::FRUSTUM_PLANES_COUNT])
+    {
+        using namespace DirectX;
+
+        const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+        const XMVECTOR planeVectors[MeshletCulling::FRUSTUM_PLANES_COUNT] =
+        {
+            columns.r[2], // near: z >= 0
+            XMVectorSubtract(columns.r[3], columns.r[2]), // far: z <= w
+            XMVectorAdd(columns.r[3], columns.r[0]), // left: x >= -w
+            XMVectorSubtract(columns.r[3], columns.r[0]), // right: x <= w
+            XMVectorSubtract(columns.r[3], columns.r[1]), // top: y <= w
+            XMVectorAdd(columns.r[3], columns.r[1]), // bottom: y >= -w
+        };
+
+        for (uint32_t i = 0; i < MeshletCulling::FRUSTUM_PLANES_COUNT; ++i)
+        {
+            // dot(normal, position) + w >= 0, while the culling expects dot(normal, position) >= distance.
+            XMStoreFloat4(&planes[i], XMPlaneNormalize(planeVectors[i]));
+            planes[i].w = -planes[i].w;
+        }
+    }
+
+    // Random depths in the first mip, each next one stores the maximums of the previous one (like HDB_Downsample_PS).
+    MeshletCulling::HierarchicalDepthBuffer CreateHierarchicalDepthBuffer(const uint32_t resolution, std::mt19937& random)
+    {
+        MeshletCulling::HierarchicalDepthBuffer hdb;
+        hdb.m_Width = resolution;
+        hdb.m_Height = resolution;
+
+        std::uniform_real_distribution<float> depthDistribution(0.9f, 1.0f);
+        auto& firstMip = hdb.m_Mips.emplace_back(resolution * resolution);
+        for (float& depth : firstMip)
+        {
+            depth = depthDistribution(random);
+        }
+
+        for (uint32_t size = resolution / 2; size >= 1; size /= 2)
+        {
+            const std::vector<float>& source = hdb.m_Mips.back();
+            std::vector<float> mip(size * size);
+
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    const uint32_t sourceSize = size * 2;
+                    const float* row0 = &source[(y * 2) * sourceSize + x * 2];
+                    const float* row1 = row0 + sourceSize;
+                    mip[y * size + x] = std::max(std::max(row0[0], row0[1]), std::max(row1[0], row1[1]));
+                }
+            }
+
+            hdb.m_Mips.push_back(std::move(mip));
+        }
+
+        return hdb;
+    }
+
+    struct CullingTime
+    {
+        double Best = std::numeric_limits<double>::max();
+        double Average = 0.0;
+    };
+
+    template <typename CullFunction>
+    CullingTime MeasureCulling(const CullFunction& cull, std::vector<uint32_t>& visibleMeshletIndices, const uint32_t numFrames)
+    {
+        CullingTime result;
+
+        for (uint32_t frame = 0; frame < numFrames; ++frame)
+        {
+            visibleMeshletIndices.clear();
+
+            const double time = ToolsCommon::MeasureTime(cull);
+            result.Best = std::min(result.Best, time);
+            result.Average += time / numFrames;
+        }
+
+        return result;
+    }
+
+    /*
+     * Culls a synthetic scene of meshlets scattered around a grid of transforms, every frame, for 1, 2, 4, ... threads.
+     * The same meshlets are culled as an array of structures (Meshlet) and as a structure of arrays (MeshletStore).
+     */
+    void RunCullingBenchmark(const size_t numMeshlets, const uint32_t maxThreads, const uint32_t numFrames)
+    {
+        using namespace DirectX;
+
+        constexpr uint32_t gridSize = 32;
+        constexpr float gridSpacing = 10.0f;
+        constexpr float meshletRadius = 0.25f;
+
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+
+        std::vector<Transform> transforms(gridSize * gridSize);
+        for (uint32_t i = 0; i < transforms.size(); ++i)
+        {
+            const float x = (static_cast<float>(i % gridSize) - gridSize * 0.5f) * gridSpacing;
+            const float z = (static_cast<float>(i / gridSize) - gridSize * 0.5f) * gridSpacing;
+            transforms[i].Compute(XMMatrixTranslation(x, 0.0f, z));
+        }
+
+        std::vector<Meshlet> meshlets(numMeshlets);
+        for (size_t i = 0; i < meshlets.size(); ++i)
+        {
+            Meshlet& meshlet = meshlets[i];
+            MeshletBounds& bounds = meshlet.m_Bounds;
+
+            bounds.m_Center = XMFLOAT3(unitDistribution(random) * 5.0f, unitDistribution(random) * 5.0f, unitDistribution(random) * 5.0f);
+            bounds.m_Radius = meshletRadius;
+            bounds.m_ConeApex = bounds.m_Center;
+            XMStoreFloat3(&bounds.m_ConeAxis, XMVector3Normalize(XMVectorSet(unitDistribution(random), unitDistribution(random), unitDistribution(random), 0.0f)));
+            bounds.m_ConeCutoff = 0.5f;
+            bounds.m_AabbCenter = bounds.m_Center;
+            bounds.m_AabbHalfSize = XMFLOAT3(meshletRadius * 0.5f, meshletRadius * 0.5f, meshletRadius * 0.5f);
+
+            meshlet.m_TransformIndex = static_cast<uint32_t>(i % transforms.size());
+            meshlet.m_VertexOffset = 0;
+            meshlet.m_IndexOffset = 0;
+            meshlet.m_VertexCount = 64;
+            meshlet.m_IndexCount = 124 * 3;
+        }
+
+        MeshletStore meshletStore;
+        meshletStore.Resize(meshlets.size());
+        for (size_t i = 0; i < meshlets.size(); ++i)
+        {
+            meshletStore.Set(i, meshlets[i]);
+        }
+
+        const XMVECTOR eye = XMVectorSet(0.0f, 20.0f, -50.0f, 1.0f);
+        const XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const XMMATRIX projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        const MeshletCulling::HierarchicalDepthBuffer hdb = CreateHierarchicalDepthBuffer(256, random);
+
+        MeshletCulling::Parameters parameters;
+        XMStoreFloat3(&parameters.m_CameraPosition, eye);
+        parameters.m_ViewProjection = XMMatrixMultiply(view, projection);
+        ExtractFrustumPlanes(parameters.m_ViewProjection, parameters.m_FrustumPlanes);
+        parameters.m_Hdb = &hdb;
+        const MeshletCulling culling(parameters);
+
+        std::vector<uint32_t> visibleMeshletIndices;
+        visibleMeshletIndices.reserve(meshlets.size());
+
+        for (uint32_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+        {
+            const auto threadPool = CreateThreadPool(numThreads);
+
+            const CullingTime aosTime = MeasureCulling([&]
+            {
+                culling.Cull(meshlets.data(), meshlets.size(), transforms.data(), visibleMeshletIndices, threadPool.get());
+            }, visibleMeshletIndices, numFrames);
+            const std::vector<uint32_t> aosVisibleMeshletIndices = visibleMeshletIndices;
+
+            const CullingTime soaTime = MeasureCulling([&]
+            {
+                culling.Cull(meshletStore, transforms.data(), visibleMeshletIndices, threadPool.get());
+            }, visibleMeshletIndices, numFrames);
+
+            if (visibleMeshletIndices != aosVisibleMeshletIndices)
+            {
+                throw std::runtime_error("The AoS and SoA culling results differ.");
+            }
+
+            std::cout << "Threads: " << numThreads
+                << ", meshlets: " << meshlets.size()
+                << ", visible: " << visibleMeshletIndices.size()
+                << ", AoS cull: " << aosTime.Best << " ms (best), " << aosTime.Average << " ms (average)"
+                << ", SoA cull: " << soaTime.Best << " ms (best), " << soaTime.Average << " ms (average)" << std::endl;
+
+            if (numThreads == maxThreads)
+            {
+                break;
+            }
+        }
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<std::filesystem::path> paths;
+    // MeshletsDemo loads its models with flipped normals.
+    bool flipNormals = true;
+    MeshletBuilder::Settings settings;
+    uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t numIterations = 3;
+    bool culling = false;
+    size_t numMeshlets = 1'000'000;
+
+    ToolsCommon::CommandLine commandLine("Usage: MeshletBenchmark [<model>...] [--no-flip-normals] [--cluster-lod] [--partition-size <triangles>] [--threads <count>] [--iterations <count>]\n"
+        "       MeshletBenchmark --culling [--meshlets <count>] [--threads <count>] [--iterations <frames>]");
+    commandLine.AddFlag("--no-flip-normals", flipNormals, false);
+    commandLine.AddFlag("--cluster-lod", settings.BuildClusterLod);
+    commandLine.AddOption("--partition-size", settings.PartitionSize, 1u);
+    commandLine.AddOption("--threads", numThreads, 1u);
+    commandLine.AddOption("--iterations", numIterations, 1u);
+    commandLine.AddFlag("--culling", culling);
+    commandLine.AddOption("--meshlets", numMeshlets);
+    commandLine.AddPositional(paths);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (culling)
+    {
+        try
+        {
+            RunCullingBenchmark(numMeshlets, numThreads, std::max(numIterations, 10u));
+        }
+        catch (const std::exception& exception)
+        {
+            std::cerr << exception.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (paths.empty())
+    {
+        paths.assign(std::begin(DEFAULT_MODEL_PATHS), std::end(DEFAULT_MODEL_PATHS));
+    }
+
+    for (const auto& path : paths)
+    {
+        try
+        {
+            RunBenchmark(path, flipNormals, settings, numThreads, numIterations);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cerr << path.string() << ": " << exception.what() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "ModelCooker.h"
+
+#include <DX12Library/ThreadPool.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    bool ParseVertexLayout(const std::string_view name, VertexLayout& vertexLayout)
+    {
+        if (name == "full")
+        {
+            vertexLayout = VertexLayout::Full();
+        }
+        else if (name == "compact")
+        {
+            vertexLayout = VertexLayout::Compact();
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    void PrintStatistics(const MeshOptimization::Statistics& statistics)
+    {
+        std::cout << "ACMR " << statistics.Acmr << ", ATVR " << statistics.Atvr
+            << ", overdraw " << statistics.Overdraw << ", overfetch " << statistics.Overfetch;
+    }
+
+    void PrintOptimizationResults(const std::vector<MeshOptimization::Result>& results)
+    {
+        for (size_t meshIndex = 0; meshIndex < results.size(); ++meshIndex)
+        {
+            const auto& result = results[meshIndex];
+
+            std::cout << "Mesh " << meshIndex << ": ";
+            PrintStatistics(result.Before);
+            std::cout << " -> ";
+            PrintStatistics(result.After);
+            std::cout << ", LODs " << result.Lods.size() << std::endl;
+        }
+    }
+
+    // The calling thread participates in ThreadPool::ParallelFor, so N threads need N - 1 workers.
+    std::unique_ptr<ThreadPool> CreateThreadPool(const uint32_t numThreads)
+    {
+        if (numThreads <= 1)
+        {
+            return nullptr;
+        }
+
+        return std::make_unique<ThreadPool>(numThreads - 1);
+    }
+
+    // Reports the import time (Assimp post-processing included) for 1, 2, 4, ... threads.
+    void RunBenchmark(const std::filesystem::path& inputPath, const bool flipNormals, const uint32_t maxThreads)
+    {
+        constexpr uint32_t numIterations = 3;
+
+        for (uint32_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+        {
+            const auto threadPool = CreateThreadPool(numThreads);
+
+            double bestTime = std::numeric_limits<double>::max();
+            size_t numMeshes = 0;
+
+            for (uint32_t iteration = 0; iteration < numIterations; ++iteration)
+            {
+                const auto startTime = ToolsCommon::Clock::now();
+                const auto model = ModelCooker::Import(inputPath.string(), flipNormals, threadPool.get());
+                bestTime = std::min(bestTime, ToolsCommon::GetElapsedMs(startTime));
+                numMeshes = model.m_Meshes.size();
+            }
+
+            std::cout << "Threads: " << numThreads << ", meshes: " << numMeshes << ", import: " << bestTime << " ms" << std::endl;
+
+            if (numThreads == maxThreads)
+            {
+                break;
+            }
+        }
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::filesystem::path inputPath;
+    std::filesystem::path outputPath;
+    bool flipNormals = false;
+    bool benchmark = false;
+    bool optimize = true;
+    MeshOptimization::Settings optimizationSettings = ModelCooker::GetDefaultOptimizationSettings();
+    // The default matches VertexAttributes::LAYOUT. Models cooked with a different layout are imported again at runtime.
+    VertexLayout vertexLayout = VertexLayout::Compact();
+    uint32_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    ToolsCommon::CommandLine commandLine("Usage: ModelCooker <input> [<output>] [--flip-normals] [--vertex-layout full|compact] [--no-optimize] [--lods <count>] [--threads <count>] [--benchmark]");
+    commandLine.AddFlag("--flip-normals", flipNormals);
+    commandLine.AddFlag("--no-optimize", optimize, false);
+    commandLine.AddOption("--lods", optimizationSettings.MaxLods);
+    commandLine.AddFlag("--benchmark", benchmark);
+    commandLine.AddOption("--vertex-layout", [&vertexLayout](const std::string_view name) { return ParseVertexLayout(name, vertexLayout); });
+    commandLine.AddOption("--threads", numThreads, 1u);
+    commandLine.AddPositional([&inputPath, &outputPath](const std::string_view argument)
+    {
+        std::filesystem::path& path = inputPath.empty() ? inputPath : outputPath;
+        if (!path.empty())
+        {
+            return false;
+        }
+
+        path = argument;
+        return true;
+    });
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (inputPath.empty())
+    {
+        commandLine.PrintUsage();
+        return 1;
+    }
+
+    if (outputPath.empty())
+    {
+        outputPath = ModelCooker::GetCookedPath(inputPath);
+    }
+
+    try
+    {
+        if (benchmark)
+        {
+            RunBenchmark(inputPath, flipNormals, numThreads);
+        }
+        else
+        {
+            const auto threadPool = CreateThreadPool(numThreads);
+
+            auto model = ModelCooker::Import(inputPath.string(), flipNormals, threadPool.get());
+            model.m_VertexLayout = vertexLayout;
+
+            if (optimize)
+            {
+                std::cout << inputPath.string() << std::endl;
+                PrintOptimizationResults(ModelCooker::Optimize(model, optimizationSettings, threadPool.get()));
+            }
+
+            model.Write(outputPath);
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << inputPath.string() << ": " << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
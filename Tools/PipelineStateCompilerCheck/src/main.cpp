@@ -0,0 +1,238 @@
+#include <AsyncBuildQueue.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumShaders = 64;
+        // How long the mock driver takes to compile a pipeline state.
+        uint32_t BuildLatencyMs = 50;
+        uint32_t NumThreads = 4;
+        // The frame pacing: the time the simulated frame waits for the GPU after recording its draws.
+        uint32_t FramePeriodMs = 2;
+        // Every this many shaders, the compilation fails.
+        uint32_t FailurePeriod = 16;
+    };
+
+    // Stands in for ID3D12PipelineState.
+    struct MockPipelineState
+    {
+        uint64_t Key;
+    };
+
+    using Queue = AsyncBuildQueue<std::shared_ptr<MockPipelineState>>;
+
+    using ToolsCommon::Clock;
+    using ToolsCommon::GetElapsedMs;
+
+    // The mock driver: sleeps as long as a real compilation takes, then creates the pipeline state or throws.
+    Queue::BuildFunction CreateBuildFunction(const uint64_t key, const Settings& settings)
+    {
+        return [key, latencyMs = settings.BuildLatencyMs, isFailing = key % settings.FailurePeriod == settings.FailurePeriod - 1]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs));
+            if (isFailing)
+            {
+                throw std::runtime_error("Mock compilation error " + std::to_string(key) + ".");
+            }
+
+            return std::make_shared<MockPipelineState>(MockPipelineState{ key });
+        };
+    }
+
+    // A job scheduled again while it is in flight is not compiled twice.
+    bool CheckDeduplication(const Settings& settings)
+    {
+        Queue queue(settings.NumThreads);
+
+        const auto job = queue.Schedule(0, CreateBuildFunction(0, settings));
+        const auto sameJob = queue.Schedule(0, CreateBuildFunction(0, settings));
+        queue.Wait();
+
+        Queue::CompletionReport report;
+        uint32_t numReports = 0;
+        while (queue.TryPopCompletionReport(report))
+        {
+            ++numReports;
+        }
+
+        if (job != sameJob || numReports != 1 || job->GetStatus() != Queue::JobStatus::Completed || job->GetResult()->Key != 0)
+        {
+            std::cerr << "The same key in flight has been compiled " << numReports << " times." << std::endl;
+            return false;
+        }
+
+        // Once finished, the key can be compiled again (e.g., after a failure).
+        const auto newJob = queue.Schedule(0, CreateBuildFunction(0, settings));
+        queue.Wait();
+        if (newJob == job || newJob->GetStatus() != Queue::JobStatus::Completed)
+        {
+            std::cerr << "A finished key has not been compiled again." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Simulates frames drawing with every shader, as Shader::Bind does: a missing pipeline state is scheduled,
+     * a pending one is skipped (the draw uses the fallback), and a completed one is bound.
+     * No frame may take as long as a single compilation.
+     */
+    bool CheckFrames(const Settings& settings)
+    {
+        Queue queue(settings.NumThreads);
+
+        std::vector<std::shared_ptr<Queue::Job>> jobs(settings.NumShaders);
+        std::vector<std::shared_ptr<MockPipelineState>> pipelineStates(settings.NumShaders);
+        std::vector<bool> isFailed(settings.NumShaders, false);
+
+        uint32_t numFrames = 0;
+        uint32_t numFallbackDraws = 0;
+        uint32_t numFinishedShaders = 0;
+        double maxFrameTimeMs = 0.0;
+        const auto startTime = Clock::now();
+
+        // Every compilation would take NumShaders / NumThreads * latency if the frames waited for none of them.
+        const double timeoutMs = 10.0 * settings.BuildLatencyMs * (settings.NumShaders / std::max(settings.NumThreads, 1u) + 1);
+
+        while (numFinishedShaders < settings.NumShaders)
+        {
+            if (GetElapsedMs(startTime) > timeoutMs)
+            {
+                std::cerr << "Only " << numFinishedShaders << " of " << settings.NumShaders << " pipeline states have been compiled in " << timeoutMs << " ms." << std::endl;
+                return false;
+            }
+
+            const auto frameStartTime = Clock::now();
+
+            for (uint64_t shader = 0; shader < settings.NumShaders; ++shader)
+            {
+                if (pipelineStates[shader] != nullptr || isFailed[shader])
+                {
+                    continue;
+                }
+
+                auto& job = jobs[shader];
+                if (job == nullptr)
+                {
+                    job = queue.Schedule(shader, CreateBuildFunction(shader, settings));
+                }
+
+                switch (job->GetStatus())
+                {
+                case Queue::JobStatus::Pending:
+                    ++numFallbackDraws;
+                    break;
+                case Queue::JobStatus::Completed:
+                    pipelineStates[shader] = job->GetResult();
+                    ++numFinishedShaders;
+                    break;
+                case Queue::JobStatus::Failed:
+                    isFailed[shader] = true;
+                    ++numFinishedShaders;
+                    break;
+                }
+            }
+
+            const double frameTimeMs = GetElapsedMs(frameStartTime);
+            maxFrameTimeMs = std::max(maxFrameTimeMs, frameTimeMs);
+            ++numFrames;
+
+            // A frame that had waited for a compilation would have taken at least the compilation's latency.
+            if (frameTimeMs >= settings.BuildLatencyMs)
+            {
+                std::cerr << "Frame " << numFrames << " has taken " << frameTimeMs << " ms: it has waited for a compilation." << std::endl;
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(settings.FramePeriodMs));
+        }
+
+        // Every job has reported once, with the right result.
+        uint32_t numReports = 0;
+        uint32_t numFailedReports = 0;
+        Queue::CompletionReport report;
+        while (queue.TryPopCompletionReport(report))
+        {
+            ++numReports;
+            numFailedReports += report.Succeeded ? 0 : 1;
+        }
+
+        uint32_t numExpectedFailures = 0;
+        for (uint64_t shader = 0; shader < settings.NumShaders; ++shader)
+        {
+            const bool isExpectedToFail = shader % settings.FailurePeriod == settings.FailurePeriod - 1;
+            numExpectedFailures += isExpectedToFail ? 1 : 0;
+
+            const bool isCorrect = isExpectedToFail ?
+                isFailed[shader] && jobs[shader]->GetErrorMessage() == "Mock compilation error " + std::to_string(shader) + "." :
+                pipelineStates[shader] != nullptr && pipelineStates[shader]->Key == shader;
+            if (!isCorrect)
+            {
+                std::cerr << "The pipeline state of the shader " << shader << " is wrong." << std::endl;
+                return false;
+            }
+        }
+
+        if (numReports != settings.NumShaders || numFailedReports != numExpectedFailures)
+        {
+            std::cerr << numReports << " completion reports (" << numFailedReports << " failed) instead of "
+                << settings.NumShaders << " (" << numExpectedFailures << " failed)." << std::endl;
+            return false;
+        }
+
+        std::cout << "Shaders: " << settings.NumShaders << " (" << numExpectedFailures << " failing), compilation latency: " << settings.BuildLatencyMs << " ms"
+            << ", threads: " << settings.NumThreads
+            << "; all compiled in " << GetElapsedMs(startTime) << " ms over " << numFrames << " frames"
+            << ", " << numFallbackDraws << " fallback draws, longest frame " << maxFrameTimeMs << " ms" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: PipelineStateCompilerCheck [--shaders <count>] [--latency <ms>] [--threads <count>] [--frame <ms>]");
+    commandLine.AddOption("--shaders", settings.NumShaders, 1u);
+    commandLine.AddOption("--latency", settings.BuildLatencyMs, 1u);
+    commandLine.AddOption("--threads", settings.NumThreads);
+    commandLine.AddOption("--frame", settings.FramePeriodMs);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        if (!CheckDeduplication(settings) || !CheckFrames(settings))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,454 @@
+#include <PipelineStateCacheFile.h>
+#include <PipelineStateKey.h>
+
+#include <ToolsCommon/CommandLine.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        // Pipeline states with random fixed-function states, checked for key collisions and saved to the cache file.
+        uint32_t NumPipelines = 1000;
+        uint32_t Seed = 0;
+    };
+
+    // The DXGI and D3D12 values used below, so that the check does not need the headers.
+    constexpr uint32_t DXGI_FORMAT_R32G32B32A32_FLOAT = 2;
+    constexpr uint32_t DXGI_FORMAT_R16G16B16A16_FLOAT = 10;
+    constexpr uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t DXGI_FORMAT_D32_FLOAT = 40;
+    constexpr uint32_t D3D12_FILL_MODE_SOLID = 3;
+    constexpr uint32_t D3D12_CULL_MODE_BACK = 3;
+    constexpr uint32_t D3D12_COMPARISON_FUNC_LESS = 2;
+    constexpr uint32_t D3D12_BLEND_ONE = 2;
+    constexpr uint32_t D3D12_BLEND_OP_ADD = 1;
+
+    // Mock shader bytecode.
+    std::vector<uint8_t> CreateBytecode(const size_t size, const uint8_t seed)
+    {
+        std::vector<uint8_t> bytecode(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            bytecode[i] = static_cast<uint8_t>(seed + i * 31);
+        }
+
+        return bytecode;
+    }
+
+    struct Shaders
+    {
+        std::vector<uint8_t> VertexShader = CreateBytecode(256, 1);
+        std::vector<uint8_t> PixelShader = CreateBytecode(512, 2);
+    };
+
+    // As PipelineStateBuilder configures it by default: the mesh vertex layout, opaque, depth tested, back faces culled.
+    PipelineStateKey CreateDefaultKey(const Shaders& shaders)
+    {
+        PipelineStateKey key;
+        key.RootSignatureHash = 0x0123456789abcdefull;
+        key.VertexShader = { shaders.VertexShader.data(), shaders.VertexShader.size() };
+        key.PixelShader = { shaders.PixelShader.data(), shaders.PixelShader.size() };
+
+        const char* const semanticNames[] = { "POSITION", "NORMAL", "TEXCOORD", "TANGENT", "BINORMAL" };
+        for (uint32_t i = 0; i < std::size(semanticNames); ++i)
+        {
+            PipelineStateKey::InputElement element;
+            element.SemanticName = semanticNames[i];
+            element.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+            element.AlignedByteOffset = i * 16;
+            key.InputLayout.push_back(element);
+        }
+
+        for (auto& renderTarget : key.BlendState.RenderTargets)
+        {
+            renderTarget.SrcBlend = D3D12_BLEND_ONE;
+            renderTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+            renderTarget.BlendOp = D3D12_BLEND_OP_ADD;
+            renderTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+            renderTarget.RenderTargetWriteMask = 0xF;
+        }
+
+        key.DepthStencilState.DepthEnable = 1;
+        key.DepthStencilState.DepthWriteMask = 1;
+        key.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+        key.DepthStencilState.StencilReadMask = 0xFF;
+        key.DepthStencilState.StencilWriteMask = 0xFF;
+
+        key.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+        key.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+        key.RasterizerState.DepthClipEnable = 1;
+
+        key.RenderTargetState.NumRenderTargets = 1;
+        key.RenderTargetState.RenderTargetFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        key.RenderTargetState.DepthStencilFormat = DXGI_FORMAT_D32_FLOAT;
+        return key;
+    }
+
+    // A change of a single part of the pipeline state.
+    struct Change
+    {
+        const char* Name;
+        std::function<void(PipelineStateKey& key, Shaders& shaders)> Apply;
+        // Whether the render target state is the only thing that changes.
+        bool IsRenderTargetState = false;
+    };
+
+    std::vector<Change> GetChanges()
+    {
+        return {
+            { "root signature", [](auto& key, auto&) { key.RootSignatureHash ^= 1; } },
+            { "vertex shader byte", [](auto&, auto& shaders) { shaders.VertexShader[100] ^= 1; } },
+            { "pixel shader byte", [](auto&, auto& shaders) { shaders.PixelShader.back() ^= 0x80; } },
+            { "vertex shader size", [](auto&, auto& shaders) { shaders.VertexShader.push_back(0); } },
+            // The same bytes in total, split differently between the shaders.
+            { "shader boundary", [](auto&, auto& shaders)
+                {
+                    shaders.PixelShader.insert(shaders.PixelShader.begin(), shaders.VertexShader.back());
+                    shaders.VertexShader.pop_back();
+                } },
+            { "swapped shaders", [](auto&, auto& shaders) { std::swap(shaders.VertexShader, shaders.PixelShader); } },
+            { "input element count", [](auto& key, auto&) { key.InputLayout.pop_back(); } },
+            { "semantic name", [](auto& key, auto&) { key.InputLayout[2].SemanticName = "TEXCOORE"; } },
+            { "semantic index", [](auto& key, auto&) { key.InputLayout[2].SemanticIndex = 1; } },
+            { "input format", [](auto& key, auto&) { key.InputLayout[1].Format = DXGI_FORMAT_R16G16B16A16_FLOAT; } },
+            { "input slot", [](auto& key, auto&) { key.InputLayout[4].InputSlot = 1; } },
+            { "input offset", [](auto& key, auto&) { key.InputLayout[3].AlignedByteOffset += 4; } },
+            { "input slot class", [](auto& key, auto&) { key.InputLayout[0].InputSlotClass = 1; } },
+            { "instance step rate", [](auto& key, auto&) { key.InputLayout[0].InstanceDataStepRate = 1; } },
+            { "alpha to coverage", [](auto& key, auto&) { key.BlendState.AlphaToCoverageEnable = 1; } },
+            { "independent blend", [](auto& key, auto&) { key.BlendState.IndependentBlendEnable = 1; } },
+            { "blend enable", [](auto& key, auto&) { key.BlendState.RenderTargets[0].BlendEnable = 1; } },
+            { "logic op enable", [](auto& key, auto&) { key.BlendState.RenderTargets[0].LogicOpEnable = 1; } },
+            { "source blend", [](auto& key, auto&) { key.BlendState.RenderTargets[0].SrcBlend += 1; } },
+            { "destination blend", [](auto& key, auto&) { key.BlendState.RenderTargets[0].DestBlend += 1; } },
+            { "blend op", [](auto& key, auto&) { key.BlendState.RenderTargets[0].BlendOp += 1; } },
+            { "source alpha blend", [](auto& key, auto&) { key.BlendState.RenderTargets[0].SrcBlendAlpha += 1; } },
+            { "destination alpha blend", [](auto& key, auto&) { key.BlendState.RenderTargets[0].DestBlendAlpha += 1; } },
+            { "alpha blend op", [](auto& key, auto&) { key.BlendState.RenderTargets[0].BlendOpAlpha += 1; } },
+            { "logic op", [](auto& key, auto&) { key.BlendState.RenderTargets[0].LogicOp += 1; } },
+            { "write mask", [](auto& key, auto&) { key.BlendState.RenderTargets[0].RenderTargetWriteMask = 0x7; } },
+            { "last render target blend", [](auto& key, auto&) { key.BlendState.RenderTargets[PipelineStateKey::MAX_RENDER_TARGETS - 1].BlendEnable = 1; } },
+            { "depth enable", [](auto& key, auto&) { key.DepthStencilState.DepthEnable = 0; } },
+            { "depth write", [](auto& key, auto&) { key.DepthStencilState.DepthWriteMask = 0; } },
+            { "depth func", [](auto& key, auto&) { key.DepthStencilState.DepthFunc += 1; } },
+            { "stencil enable", [](auto& key, auto&) { key.DepthStencilState.StencilEnable = 1; } },
+            { "stencil read mask", [](auto& key, auto&) { key.DepthStencilState.StencilReadMask = 0x0F; } },
+            { "stencil write mask", [](auto& key, auto&) { key.DepthStencilState.StencilWriteMask = 0x0F; } },
+            { "front stencil fail op", [](auto& key, auto&) { key.DepthStencilState.FrontFace.StencilFailOp += 1; } },
+            { "front stencil depth fail op", [](auto& key, auto&) { key.DepthStencilState.FrontFace.StencilDepthFailOp += 1; } },
+            { "front stencil pass op", [](auto& key, auto&) { key.DepthStencilState.FrontFace.StencilPassOp += 1; } },
+            { "front stencil func", [](auto& key, auto&) { key.DepthStencilState.FrontFace.StencilFunc += 1; } },
+            { "back stencil func", [](auto& key, auto&) { key.DepthStencilState.BackFace.StencilFunc += 1; } },
+            { "fill mode", [](auto& key, auto&) { key.RasterizerState.FillMode -= 1; } },
+            { "cull mode", [](auto& key, auto&) { key.RasterizerState.CullMode -= 1; } },
+            { "winding", [](auto& key, auto&) { key.RasterizerState.FrontCounterClockwise = 1; } },
+            { "depth bias", [](auto& key, auto&) { key.RasterizerState.DepthBias = 100; } },
+            { "depth bias clamp", [](auto& key, auto&) { key.RasterizerState.DepthBiasClamp = 0.5f; } },
+            { "slope scaled depth bias", [](auto& key, auto&) { key.RasterizerState.SlopeScaledDepthBias = 1.5f; } },
+            { "depth clip", [](auto& key, auto&) { key.RasterizerState.DepthClipEnable = 0; } },
+            { "multisample", [](auto& key, auto&) { key.RasterizerState.MultisampleEnable = 1; } },
+            { "antialiased lines", [](auto& key, auto&) { key.RasterizerState.AntialiasedLineEnable = 1; } },
+            { "forced sample count", [](auto& key, auto&) { key.RasterizerState.ForcedSampleCount = 4; } },
+            { "conservative raster", [](auto& key, auto&) { key.RasterizerState.ConservativeRaster = 1; } },
+            { "render target count", [](auto& key, auto&) { key.RenderTargetState.NumRenderTargets = 2; key.RenderTargetState.RenderTargetFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM; }, true },
+            { "render target format", [](auto& key, auto&) { key.RenderTargetState.RenderTargetFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; }, true },
+            { "depth stencil format", [](auto& key, auto&) { key.RenderTargetState.DepthStencilFormat = 0; }, true },
+            { "sample count", [](auto& key, auto&) { key.RenderTargetState.SampleCount = 4; }, true },
+            { "sample quality", [](auto& key, auto&) { key.RenderTargetState.SampleQuality = 1; }, true },
+        };
+    }
+
+    // Returns false if a check fails.
+    bool CheckKeyStability()
+    {
+        Shaders shaders;
+        const PipelineStateKey key = CreateDefaultKey(shaders);
+
+        // Equal state in other buffers: only the contents count, not where they are.
+        Shaders otherShaders;
+        const PipelineStateKey otherKey = CreateDefaultKey(otherShaders);
+
+        if (key.ComputeKey() != otherKey.ComputeKey() || key.ComputeStateHash() != otherKey.ComputeStateHash())
+        {
+            std::cerr << "The key of the same pipeline state depends on the location of its data." << std::endl;
+            return false;
+        }
+
+        // The keys are persisted in the cache file, so they must not change between runs, builds and platforms.
+        // Update these if the hashed state changes on purpose: the pipelines cached with the previous keys will be recompiled once.
+        constexpr uint64_t EXPECTED_STATE_HASH = 0x4d0120f2837e6296ull;
+        constexpr uint64_t EXPECTED_KEY = 0x855179e6485edaceull;
+
+        if (key.ComputeStateHash() != EXPECTED_STATE_HASH || key.ComputeKey() != EXPECTED_KEY)
+        {
+            std::cerr << std::hex << "The key of the reference pipeline state has changed: state hash 0x" << key.ComputeStateHash()
+                << ", key 0x" << key.ComputeKey() << std::dec << "." << std::endl;
+            return false;
+        }
+
+        std::cout << "Reference pipeline state: stable key" << std::endl;
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool CheckKeySensitivity()
+    {
+        Shaders referenceShaders;
+        const PipelineStateKey referenceKey = CreateDefaultKey(referenceShaders);
+        const uint64_t referenceStateHash = referenceKey.ComputeStateHash();
+        const uint64_t referenceFullKey = referenceKey.ComputeKey();
+
+        const auto changes = GetChanges();
+        for (const auto& change : changes)
+        {
+            Shaders shaders;
+            PipelineStateKey key = CreateDefaultKey(shaders);
+            change.Apply(key, shaders);
+            key.VertexShader = { shaders.VertexShader.data(), shaders.VertexShader.size() };
+            key.PixelShader = { shaders.PixelShader.data(), shaders.PixelShader.size() };
+
+            if (key.ComputeKey() == referenceFullKey)
+            {
+                std::cerr << "A change of the " << change.Name << " does not change the key." << std::endl;
+                return false;
+            }
+
+            // The state hash groups the render target states a pipeline has been used with (see PipelineStateCacheFile).
+            const bool hasStateHashChanged = key.ComputeStateHash() != referenceStateHash;
+            if (hasStateHashChanged == change.IsRenderTargetState)
+            {
+                std::cerr << "A change of the " << change.Name << (change.IsRenderTargetState ? " changes" : " does not change") << " the state hash." << std::endl;
+                return false;
+            }
+        }
+
+        // Compute pipelines: the same root signature and bytecode hashing.
+        const std::vector<uint8_t> computeShader = CreateBytecode(300, 3);
+        std::vector<uint8_t> changedComputeShader = computeShader;
+        changedComputeShader[0] ^= 1;
+
+        const uint64_t computeKey = PipelineStateKey::ComputeComputePipelineKey(1, { computeShader.data(), computeShader.size() });
+        if (computeKey != PipelineStateKey::ComputeComputePipelineKey(1, { computeShader.data(), computeShader.size() }) ||
+            computeKey == PipelineStateKey::ComputeComputePipelineKey(2, { computeShader.data(), computeShader.size() }) ||
+            computeKey == PipelineStateKey::ComputeComputePipelineKey(1, { changedComputeShader.data(), changedComputeShader.size() }) ||
+            computeKey == PipelineStateKey::ComputeComputePipelineKey(1, { computeShader.data(), computeShader.size() - 1 }))
+        {
+            std::cerr << "The key of a compute pipeline is not stable or does not change with its state." << std::endl;
+            return false;
+        }
+
+        std::cout << "Changes: " << changes.size() << " parts of the pipeline state, all change the key" << std::endl;
+        return true;
+    }
+
+    // Random fixed-function and render target states: the keys of distinct states must not collide.
+    std::vector<PipelineStateKey> CreateRandomKeys(const Shaders& shaders, const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_int_distribution<uint32_t> valueDistribution(0, 7);
+
+        std::vector<PipelineStateKey> keys;
+        keys.reserve(settings.NumPipelines);
+        for (uint32_t i = 0; i < settings.NumPipelines; ++i)
+        {
+            PipelineStateKey key = CreateDefaultKey(shaders);
+            key.RootSignatureHash = i;
+            key.BlendState.RenderTargets[0].SrcBlend = valueDistribution(random);
+            key.DepthStencilState.DepthFunc = valueDistribution(random);
+            key.RasterizerState.CullMode = valueDistribution(random);
+            key.RasterizerState.DepthBias = static_cast<int32_t>(valueDistribution(random));
+            key.RenderTargetState.SampleCount = 1u << (valueDistribution(random) % 4);
+            keys.push_back(std::move(key));
+        }
+
+        return keys;
+    }
+
+    PipelineStateCacheFile CreateCacheFile(const std::vector<PipelineStateKey>& keys)
+    {
+        PipelineStateCacheFile file;
+        for (const auto& key : keys)
+        {
+            auto& renderTargetStates = file.m_KnownRenderTargetStates[key.ComputeStateHash()];
+            if (std::find(renderTargetStates.begin(), renderTargetStates.end(), key.RenderTargetState) == renderTargetStates.end())
+            {
+                renderTargetStates.push_back(key.RenderTargetState);
+            }
+        }
+
+        // Stands in for the serialized ID3D12PipelineLibrary.
+        file.m_PipelineLibraryBlob = CreateBytecode(4096, 4);
+        return file;
+    }
+
+    bool AreEqual(const PipelineStateCacheFile& a, const PipelineStateCacheFile& b)
+    {
+        return a.m_KnownRenderTargetStates == b.m_KnownRenderTargetStates && a.m_PipelineLibraryBlob == b.m_PipelineLibraryBlob;
+    }
+
+    // Returns false if a check fails.
+    bool CheckCacheFile(const Settings& settings, std::mt19937& random)
+    {
+        Shaders shaders;
+        const std::vector<PipelineStateKey> keys = CreateRandomKeys(shaders, settings, random);
+
+        std::vector<uint64_t> sortedKeys;
+        for (const auto& key : keys)
+        {
+            sortedKeys.push_back(key.ComputeKey());
+        }
+        std::sort(sortedKeys.begin(), sortedKeys.end());
+        if (std::adjacent_find(sortedKeys.begin(), sortedKeys.end()) != sortedKeys.end())
+        {
+            std::cerr << "Two distinct pipeline states have the same key." << std::endl;
+            return false;
+        }
+
+        const PipelineStateCacheFile file = CreateCacheFile(keys);
+
+        // Through the file, as the demos do on startup and exit.
+        const auto path = std::filesystem::temp_directory_path() / "PipelineStateKeyCheck.bin";
+        file.Write(path);
+
+        PipelineStateCacheFile readFile;
+        const bool isRead = readFile.Read(path);
+        std::filesystem::remove(path);
+
+        if (!isRead || !AreEqual(file, readFile))
+        {
+            std::cerr << "The pipeline state cache read from the file differs from the written one." << std::endl;
+            return false;
+        }
+
+        // The keys derived from the stored render target states find the same pipelines.
+        for (const auto& key : keys)
+        {
+            const auto& renderTargetStates = readFile.m_KnownRenderTargetStates[key.ComputeStateHash()];
+            const auto isSameKey = [&key](const PipelineStateCacheFile::RenderTargetStateRecord& renderTargetState)
+            {
+                return PipelineStateCacheFile::ComputePipelineKey(key.ComputeStateHash(), renderTargetState) == key.ComputeKey();
+            };
+
+            if (std::none_of(renderTargetStates.begin(), renderTargetStates.end(), isSameKey))
+            {
+                std::cerr << "The key of a cached pipeline cannot be derived from the file." << std::endl;
+                return false;
+            }
+        }
+
+        PipelineStateCacheFile missingFile;
+        if (missingFile.Read(path))
+        {
+            std::cerr << "A missing pipeline state cache has been read." << std::endl;
+            return false;
+        }
+
+        // Every single corrupted byte and every truncation is rejected, and leaves the file empty.
+        // Checked exhaustively on a smaller file.
+        const std::vector<uint8_t> bytes = CreateCacheFile({ keys.begin(), keys.begin() + std::min<size_t>(keys.size(), 16) }).Serialize();
+        const auto isRejected = [](const std::vector<uint8_t>& corruptedBytes)
+        {
+            PipelineStateCacheFile corruptedFile;
+            const bool isAccepted = corruptedFile.Deserialize(corruptedBytes.data(), corruptedBytes.size());
+            return !isAccepted && corruptedFile.m_KnownRenderTargetStates.empty() && corruptedFile.m_PipelineLibraryBlob.empty();
+        };
+
+        for (size_t i = 0; i < bytes.size(); ++i)
+        {
+            std::vector<uint8_t> corruptedBytes = bytes;
+            corruptedBytes[i] ^= static_cast<uint8_t>(1u << (i % 8));
+            if (!isRejected(corruptedBytes))
+            {
+                std::cerr << "A pipeline state cache with the byte " << i << " corrupted has been accepted." << std::endl;
+                return false;
+            }
+        }
+
+        for (size_t size = 0; size < bytes.size(); ++size)
+        {
+            if (!isRejected(std::vector<uint8_t>(bytes.begin(), bytes.begin() + static_cast<ptrdiff_t>(size))))
+            {
+                std::cerr << "A pipeline state cache truncated to " << size << " bytes has been accepted." << std::endl;
+                return false;
+            }
+        }
+
+        std::vector<uint8_t> extendedBytes = bytes;
+        extendedBytes.push_back(0);
+        if (!isRejected(extendedBytes))
+        {
+            std::cerr << "A pipeline state cache with trailing bytes has been accepted." << std::endl;
+            return false;
+        }
+
+        std::cout << "Cache file: " << file.m_KnownRenderTargetStates.size() << " pipeline states round trip"
+            << "; all " << bytes.size() << " corrupted bytes and truncations of a " << bytes.size() << "-byte file rejected" << std::endl;
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool CheckVersionMismatch()
+    {
+        PipelineStateCacheFile file;
+        file.m_PipelineLibraryBlob = CreateBytecode(64, 5);
+        const std::vector<uint8_t> bytes = file.Serialize();
+
+        for (const uint32_t version : { PipelineStateCacheFile::VERSION - 1, PipelineStateCacheFile::VERSION + 1 })
+        {
+            // The version follows the magic.
+            std::vector<uint8_t> otherVersionBytes = bytes;
+            memcpy(otherVersionBytes.data() + sizeof(uint32_t), &version, sizeof(version));
+
+            PipelineStateCacheFile otherVersionFile;
+            if (otherVersionFile.Deserialize(otherVersionBytes.data(), otherVersionBytes.size()))
+            {
+                std::cerr << "A pipeline state cache of the version " << version << " has been accepted." << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: PipelineStateKeyCheck [--pipelines <count>] [--seed <value>]");
+    commandLine.AddOption("--pipelines", settings.NumPipelines, 1u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        std::mt19937 random(settings.Seed);
+
+        if (!CheckKeyStability() || !CheckKeySensitivity() || !CheckCacheFile(settings, random) || !CheckVersionMismatch())
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <Aabb.h>
+#include <SceneBvh.h>
+#include <ShadowCasterCulling.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        // The share of the objects that move every frame.
+        float MovingPercent = 5.0f;
+        uint32_t NumFrames = 100;
+        uint32_t Seed = 0;
+        // The objects are scattered over a square with this many objects per square unit.
+        float Density = 0.25f;
+        float FarPlane = 300.0f;
+    };
+
+    struct Object
+    {
+        XMFLOAT3 Position;
+        XMFLOAT3 HalfExtents;
+        // Zero for the static objects. The moving ones drift away, so the refitted nodes grow until the tree is rebuilt.
+        XMFLOAT3 Velocity;
+    };
+
+    float GetSceneSize(const uint32_t numObjects, const Settings& settings)
+    {
+        return std::sqrt(static_cast<float>(numObjects) / settings.Density);
+    }
+
+    std::vector<Object> CreateObjects(const uint32_t numObjects, const Settings& settings, std::mt19937& random)
+    {
+        const float sceneSize = GetSceneSize(numObjects, settings);
+        std::uniform_real_distribution<float> positionDistribution(-sceneSize * 0.5f, sceneSize * 0.5f);
+        std::uniform_real_distribution<float> heightDistribution(0.0f, 20.0f);
+        std::uniform_real_distribution<float> sizeDistribution(0.25f, 2.0f);
+        std::uniform_real_distribution<float> velocityDistribution(-0.5f, 0.5f);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+        std::vector<Object> objects(numObjects);
+        for (auto& object : objects)
+        {
+            object.HalfExtents = { sizeDistribution(random), sizeDistribution(random), sizeDistribution(random) };
+            object.Position = { positionDistribution(random), heightDistribution(random), positionDistribution(random) };
+
+            const bool isMoving = unitDistribution(random) * 100.0f < settings.MovingPercent;
+            object.Velocity = isMoving ? XMFLOAT3(velocityDistribution(random), 0.0f, velocityDistribution(random)) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+
+        return objects;
+    }
+
+    void ComputeBounds(const std::vector<Object>& objects, const uint32_t frame, std::vector<Aabb>& bounds)
+    {
+        bounds.resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            const auto& object = objects[i];
+            const XMVECTOR position = XMVectorMultiplyAdd(XMLoadFloat3(&object.Velocity), XMVectorReplicate(static_cast<float>(frame)), XMLoadFloat3(&object.Position));
+            const XMVECTOR halfExtents = XMLoadFloat3(&object.HalfExtents);
+            bounds[i].Min = XMVectorSetW(XMVectorSubtract(position, halfExtents), 1.0f);
+            bounds[i].Max = XMVectorSetW(XMVectorAdd(position, halfExtents), 1.0f);
+        }
+    }
+
+    // A camera walking around the scene, as SceneRenderer's main view.
+    ShadowCasterCulling::Frustum ComputeFrustum(const uint32_t numObjects, const uint32_t frame, const Settings& settings)
+    {
+        const float orbitRadius = GetSceneSize(numObjects, settings) * 0.25f;
+        const float angle = static_cast<float>(frame) * 0.02f;
+        const XMVECTOR eyePosition = XMVectorSet(std::cos(angle) * orbitRadius, 10.0f, std::sin(angle) * orbitRadius, 1.0f);
+        const XMVECTOR eyeDirection = XMVector3Normalize(XMVectorSet(-std::sin(angle), -0.2f, std::cos(angle), 0.0f));
+
+        const auto viewMatrix = XMMatrixLookToLH(eyePosition, eyeDirection, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const auto projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, settings.FarPlane);
+        return ShadowCasterCulling::Frustum::FromViewProjection(viewMatrix * projectionMatrix);
+    }
+
+    // The reference: every object is tested on its own.
+    void QueryBruteForce(const ShadowCasterCulling::Frustum& frustum, const std::vector<Aabb>& bounds, std::vector<uint32_t>& visibleObjects)
+    {
+        for (uint32_t i = 0; i < bounds.size(); ++i)
+        {
+            if (ShadowCasterCulling::Intersects(frustum, bounds[i]))
+            {
+                visibleObjects.push_back(i);
+            }
+        }
+    }
+
+    // The BVH must find exactly the objects that the reference finds, once each.
+    bool Validate(std::vector<uint32_t> visibleObjects, const std::vector<uint32_t>& referenceVisibleObjects, const uint32_t frame)
+    {
+        std::sort(visibleObjects.begin(), visibleObjects.end());
+        if (visibleObjects == referenceVisibleObjects)
+        {
+            return true;
+        }
+
+        std::cerr << "Frame " << frame << ": the BVH has found " << visibleObjects.size() << " visible objects, the brute force "
+            << referenceVisibleObjects.size() << "." << std::endl;
+        return false;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const uint32_t numObjects, const Settings& settings, std::mt19937& random)
+    {
+        const std::vector<Object> objects = CreateObjects(numObjects, settings, random);
+        std::vector<Aabb> bounds;
+        std::vector<uint32_t> visibleObjects;
+        std::vector<uint32_t> referenceVisibleObjects;
+        visibleObjects.reserve(numObjects);
+        referenceVisibleObjects.reserve(numObjects);
+
+        SceneBvh bvh;
+        double updateTime = 0.0;
+        double bruteForceTime = 0.0;
+        double queryTime = 0.0;
+        uint64_t numVisibleObjects = 0;
+
+        // The first frame builds the tree, the others refit it.
+        for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+        {
+            ComputeBounds(objects, frame, bounds);
+            const auto frustum = ComputeFrustum(numObjects, frame, settings);
+
+            const double frameUpdateTime = ToolsCommon::MeasureTime([&]() { bvh.Update(bounds); });
+
+            referenceVisibleObjects.clear();
+            const double frameBruteForceTime = ToolsCommon::MeasureTime([&]() { QueryBruteForce(frustum, bounds, referenceVisibleObjects); });
+
+            visibleObjects.clear();
+            const double frameQueryTime = ToolsCommon::MeasureTime([&]() { bvh.Query(frustum, visibleObjects); });
+
+            if (!Validate(visibleObjects, referenceVisibleObjects, frame))
+            {
+                return false;
+            }
+
+            if (frame > 0)
+            {
+                updateTime += frameUpdateTime;
+                bruteForceTime += frameBruteForceTime;
+                queryTime += frameQueryTime;
+                numVisibleObjects += visibleObjects.size();
+            }
+        }
+
+        // Removing objects rebuilds the tree.
+        {
+            bounds.resize(numObjects / 2);
+            bvh.Update(bounds);
+
+            const auto frustum = ComputeFrustum(numObjects, settings.NumFrames, settings);
+            referenceVisibleObjects.clear();
+            QueryBruteForce(frustum, bounds, referenceVisibleObjects);
+            visibleObjects.clear();
+            bvh.Query(frustum, visibleObjects);
+
+            if (!Validate(visibleObjects, referenceVisibleObjects, settings.NumFrames))
+            {
+                return false;
+            }
+        }
+
+        const double numTimedFrames = static_cast<double>(std::max(settings.NumFrames - 1, 1u));
+        const double averageVisibleObjects = static_cast<double>(numVisibleObjects) / numTimedFrames;
+        const auto& stats = bvh.GetStats();
+        const uint64_t numMovingObjects = std::count_if(objects.begin(), objects.end(), [](const Object& object) { return object.Velocity.x != 0.0f || object.Velocity.z != 0.0f; });
+
+        std::cout << "Objects: " << numObjects << " (" << numMovingObjects << " moving)"
+            << ", visible " << static_cast<uint64_t>(averageVisibleObjects) << " (cull ratio " << 100.0 * (1.0 - averageVisibleObjects / numObjects) << "%)"
+            << "; per frame: brute force " << bruteForceTime * 1000.0 / numTimedFrames << " us"
+            << ", BVH query " << queryTime * 1000.0 / numTimedFrames << " us (" << bruteForceTime / std::max(queryTime, 1e-9) << "x)"
+            << ", BVH update " << updateTime * 1000.0 / numTimedFrames << " us"
+            << "; " << stats.NumNodes << " nodes, " << stats.NumRebuilds << " builds, " << stats.NumRefits << " refits" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> objectCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: SceneCullingBenchmark [--objects <count>...] [--moving <percent>] [--frames <count>] [--seed <value>]");
+    commandLine.AddOption("--objects", objectCounts, 1u);
+    commandLine.AddOption("--moving", settings.MovingPercent, 0.0f, 100.0f);
+    commandLine.AddOption("--frames", settings.NumFrames, 2u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (objectCounts.empty())
+    {
+        objectCounts = { 1000, 10000, 100000 };
+    }
+
+    try
+    {
+        std::cout << "Moving: " << settings.MovingPercent << "%, frames: " << settings.NumFrames
+            << ", far plane: " << settings.FarPlane << ", objects per square unit: " << settings.Density << std::endl;
+
+        std::mt19937 random(settings.Seed);
+        bool success = true;
+        for (const uint32_t numObjects : objectCounts)
+        {
+            success &= RunBenchmark(numObjects, settings, random);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,364 @@
+#include <BoundingSphere.h>
+#include <ShadowCascades.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/MathUtils.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        ShadowCascades::Settings Cascades;
+        uint32_t NumFrames = 1000;
+        uint32_t Seed = 0;
+    };
+
+    // The LightingDemo's camera.
+    constexpr float CAMERA_FOV = 45.0f;
+    constexpr float CAMERA_ASPECT_RATIO = 16.0f / 9.0f;
+    constexpr float CAMERA_NEAR_PLANE = 0.1f;
+    constexpr float CAMERA_FAR_PLANE = 1000.0f;
+
+    // Texel positions are compared with this tolerance, for the float error of the transforms.
+    constexpr float TEXEL_TOLERANCE = 0.01f;
+
+    bool AreNear(const float value1, const float value2, const float tolerance)
+    {
+        return std::abs(value1 - value2) <= tolerance * std::max({ 1.0f, std::abs(value1), std::abs(value2) });
+    }
+
+    XMMATRIX CreateCameraView(const XMVECTOR position, const float pitch, const float yaw)
+    {
+        const XMMATRIX rotation = XMMatrixRotationRollPitchYaw(pitch, yaw, 0.0f);
+        return XMMatrixInverse(nullptr, rotation * XMMatrixTranslationFromVector(position));
+    }
+
+    XMMATRIX CreateCameraProjection()
+    {
+        return XMMatrixPerspectiveFovLH(XMConvertToRadians(CAMERA_FOV), CAMERA_ASPECT_RATIO, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+    }
+
+    // Where a world position falls on the shadow map, in texels.
+    XMFLOAT2 ComputeTexelPosition(const XMVECTOR positionWs, const ShadowCascades::Cascade& cascade, const uint32_t resolution)
+    {
+        const XMVECTOR positionCs = XMVector3TransformCoord(positionWs, cascade.ViewProjection);
+        return {
+            (XMVectorGetX(positionCs) * 0.5f + 0.5f) * static_cast<float>(resolution),
+            (XMVectorGetY(positionCs) * 0.5f + 0.5f) * static_cast<float>(resolution),
+        };
+    }
+
+    float Fraction(const float value)
+    {
+        return value - std::floor(value);
+    }
+
+    // The difference of two fractions, wrapped to [-0.5, 0.5).
+    float FractionDistance(const float fraction1, const float fraction2)
+    {
+        const float distance = fraction1 - fraction2;
+        return std::abs(distance - std::floor(distance + 0.5f));
+    }
+
+    bool CheckSplitDistances()
+    {
+        constexpr float nearPlane = 0.1f;
+        constexpr float farPlane = 200.0f;
+
+        for (uint32_t cascadesCount = 1; cascadesCount <= ShadowCascades::MAX_CASCADES_COUNT; ++cascadesCount)
+        {
+            for (const float weight : { 0.0f, 0.5f, 0.75f, 1.0f })
+            {
+                const auto splitDistances = ShadowCascades::ComputeSplitDistances(nearPlane, farPlane, cascadesCount, weight);
+
+                if (splitDistances[0] != nearPlane || splitDistances[cascadesCount] != farPlane)
+                {
+                    std::cerr << "The splits of " << cascadesCount << " cascades (weight " << weight << ") do not start at the near plane and end at the far plane." << std::endl;
+                    return false;
+                }
+
+                for (uint32_t i = 0; i < cascadesCount; ++i)
+                {
+                    if (!(splitDistances[i] < splitDistances[i + 1]))
+                    {
+                        std::cerr << "The splits of " << cascadesCount << " cascades (weight " << weight << ") are not increasing." << std::endl;
+                        return false;
+                    }
+
+                    // Uniform: the same depth, logarithmic: the same ratio.
+                    const bool isExpected = weight == 0.0f ? AreNear(splitDistances[i + 1] - splitDistances[i], (farPlane - nearPlane) / cascadesCount, 1e-4f) :
+                        weight == 1.0f ? AreNear(splitDistances[i + 1] / splitDistances[i], std::pow(farPlane / nearPlane, 1.0f / cascadesCount), 1e-4f) :
+                        true;
+                    if (!isExpected)
+                    {
+                        std::cerr << "Split " << i << " of " << cascadesCount << " cascades (weight " << weight << ") is wrong: " << splitDistances[i + 1] << "." << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+
+        const auto expectThrow = [](const uint32_t cascadesCount, const float nearPlane, const float farPlane)
+        {
+            try
+            {
+                ShadowCascades::ComputeSplitDistances(nearPlane, farPlane, cascadesCount, 0.5f);
+            }
+            catch (const std::invalid_argument&)
+            {
+                return true;
+            }
+
+            std::cerr << "Expected the splits of " << cascadesCount << " cascades in [" << nearPlane << ", " << farPlane << "] to be rejected." << std::endl;
+            return false;
+        };
+
+        return expectThrow(0, nearPlane, farPlane) && expectThrow(ShadowCascades::MAX_CASCADES_COUNT + 1, nearPlane, farPlane) &&
+            expectThrow(1, 0.0f, farPlane) && expectThrow(1, farPlane, nearPlane);
+    }
+
+    bool CheckClipPlanes()
+    {
+        float nearPlane, farPlane;
+        ShadowCascades::GetPerspectiveClipPlanes(CreateCameraProjection(), &nearPlane, &farPlane);
+
+        if (!AreNear(nearPlane, CAMERA_NEAR_PLANE, 1e-4f) || !AreNear(farPlane, CAMERA_FAR_PLANE, 1e-3f))
+        {
+            std::cerr << "Wrong clip planes of the projection: " << nearPlane << ", " << farPlane << "." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Every corner of a cascade's slice of the camera frustum must be inside its shadow map, texel border included.
+    bool CheckCoverage(const ShadowCascades& cascades, const XMMATRIX& cameraView, const XMMATRIX& cameraProjection, const uint32_t resolution)
+    {
+        const XMMATRIX inverseViewProjection = XMMatrixInverse(nullptr, cameraView * cameraProjection);
+
+        for (uint32_t cascadeIndex = 0; cascadeIndex < cascades.GetCascadesCount(); ++cascadeIndex)
+        {
+            const auto& cascade = cascades.GetCascade(cascadeIndex);
+
+            for (const float distance : { cascade.NearDistance, cascade.FarDistance })
+            {
+                // The NDC depth of the view depth.
+                const float depthNdc = XMVectorGetZ(XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, distance, 1.0f), cameraProjection));
+
+                for (const float x : { -1.0f, 1.0f })
+                {
+                    for (const float y : { -1.0f, 1.0f })
+                    {
+                        const XMVECTOR cornerWs = XMVector3TransformCoord(XMVectorSet(x, y, depthNdc, 1.0f), inverseViewProjection);
+                        const XMFLOAT2 texelPosition = ComputeTexelPosition(cornerWs, cascade, resolution);
+                        const float max = static_cast<float>(resolution) - 1.0f + TEXEL_TOLERANCE;
+
+                        if (texelPosition.x < 1.0f - TEXEL_TOLERANCE || texelPosition.y < 1.0f - TEXEL_TOLERANCE || texelPosition.x > max || texelPosition.y > max)
+                        {
+                            std::cerr << "A corner of the slice of cascade " << cascadeIndex << " is outside of its shadow map: "
+                                << texelPosition.x << ", " << texelPosition.y << "." << std::endl;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    struct StabilityStats
+    {
+        // How many times a cascade's matrix has changed between two frames.
+        uint32_t NumMatrixChanges = 0;
+        // The largest drift of a world position within a texel, should be 0.
+        float MaxTexelDrift = 0.0f;
+    };
+
+    /**
+     * Moves and rotates the camera smoothly: a cascade's texel size must not change, its texel grid must stay fixed in the world,
+     * and the slices must stay covered.
+     */
+    bool CheckStability(const Settings& settings, const XMVECTOR lightDirection, const BoundingSphere& sceneBounds, std::mt19937& random, StabilityStats& stats)
+    {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        const XMMATRIX cameraProjection = CreateCameraProjection();
+        const uint32_t resolution = settings.Cascades.Resolution;
+
+        // Probes fixed in the world, their positions within a texel must not change.
+        std::vector<XMVECTOR> probes(8);
+        for (auto& probe : probes)
+        {
+            probe = XMVectorSet(distribution(random) * 20.0f, distribution(random) * 2.0f, distribution(random) * 20.0f, 1.0f);
+        }
+
+        ShadowCascades cascades;
+        ShadowCascades previousCascades;
+        std::vector<XMFLOAT2> initialFractions(ShadowCascades::MAX_CASCADES_COUNT * probes.size());
+
+        XMVECTOR position = XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f);
+        const XMVECTOR velocity = XMVectorScale(XMVector3Normalize(XMVectorSet(distribution(random), distribution(random) * 0.1f, distribution(random), 0.0f)), 0.01f);
+        float pitch = 0.1f;
+        float yaw = 0.0f;
+
+        for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+        {
+            position = XMVectorAdd(position, velocity);
+            pitch = 0.1f + 0.2f * std::sin(static_cast<float>(frame) * 0.01f);
+            yaw += 0.002f;
+
+            const XMMATRIX cameraView = CreateCameraView(position, pitch, yaw);
+            cascades.Update(settings.Cascades, cameraView, cameraProjection, lightDirection, sceneBounds);
+
+            if (!CheckCoverage(cascades, cameraView, cameraProjection, resolution))
+            {
+                return false;
+            }
+
+            for (uint32_t cascadeIndex = 0; cascadeIndex < cascades.GetCascadesCount(); ++cascadeIndex)
+            {
+                const auto& cascade = cascades.GetCascade(cascadeIndex);
+
+                for (size_t probeIndex = 0; probeIndex < probes.size(); ++probeIndex)
+                {
+                    const XMFLOAT2 texelPosition = ComputeTexelPosition(probes[probeIndex], cascade, resolution);
+                    const XMFLOAT2 fraction = { Fraction(texelPosition.x), Fraction(texelPosition.y) };
+                    auto& initialFraction = initialFractions[cascadeIndex * probes.size() + probeIndex];
+
+                    if (frame == 0)
+                    {
+                        initialFraction = fraction;
+                        continue;
+                    }
+
+                    stats.MaxTexelDrift = std::max({ stats.MaxTexelDrift, FractionDistance(fraction.x, initialFraction.x), FractionDistance(fraction.y, initialFraction.y) });
+                }
+
+                if (frame == 0)
+                {
+                    continue;
+                }
+
+                const auto& previousCascade = previousCascades.GetCascade(cascadeIndex);
+                if (cascade.TexelSize != previousCascade.TexelSize)
+                {
+                    std::cerr << "The texel size of cascade " << cascadeIndex << " has changed in frame " << frame << ": "
+                        << previousCascade.TexelSize << " -> " << cascade.TexelSize << "." << std::endl;
+                    return false;
+                }
+
+                if (!ToolsCommon::AreEqual(cascade.ViewProjection, previousCascade.ViewProjection))
+                {
+                    ++stats.NumMatrixChanges;
+                }
+            }
+
+            previousCascades = cascades;
+        }
+
+        if (stats.MaxTexelDrift > TEXEL_TOLERANCE)
+        {
+            std::cerr << "The texel grid has drifted by " << stats.MaxTexelDrift << " texels." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const Settings& settings, std::mt19937& random)
+    {
+        if (!CheckSplitDistances() || !CheckClipPlanes())
+        {
+            return false;
+        }
+
+        const XMVECTOR lightDirection = XMVector3Normalize(XMVectorSet(0.4f, 1.0f, 0.3f, 0.0f));
+        const BoundingSphere sceneBounds(60.0f, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+
+        StabilityStats stats;
+        if (!CheckStability(settings, lightDirection, sceneBounds, random, stats))
+        {
+            return false;
+        }
+
+        const XMMATRIX cameraView = CreateCameraView(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f), 0.1f, 0.0f);
+        const XMMATRIX cameraProjection = CreateCameraProjection();
+        ShadowCascades cascades;
+        float checksum = 0.0f;
+
+        const double time = ToolsCommon::MeasureTime([&]()
+            {
+                for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+                {
+                    cascades.Update(settings.Cascades, cameraView, cameraProjection, lightDirection, sceneBounds);
+                    checksum += XMVectorGetX(cascades.GetCascade(0).ViewProjection.r[3]);
+                }
+            });
+
+        std::cout << "Splits:";
+        for (uint32_t i = 0; i < cascades.GetCascadesCount(); ++i)
+        {
+            const auto& cascade = cascades.GetCascade(i);
+            std::cout << " [" << cascade.NearDistance << ", " << cascade.FarDistance << "] " << cascade.TexelSize * 100.0f << " cm/texel;";
+        }
+
+        std::cout << std::endl << "Update " << time * 1000.0 / settings.NumFrames << " us"
+            << ", moving camera: " << stats.NumMatrixChanges << " matrix changes in " << (settings.NumFrames - 1) * cascades.GetCascadesCount() << " cascade frames"
+            << ", max texel drift " << stats.MaxTexelDrift
+            << " [checksum " << checksum << "]" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: ShadowCascadesBenchmark [--cascades <count>] [--weight <value>] [--resolution <size>] [--distance <value>] [--frames <count>] [--seed <value>]");
+    commandLine.AddOption("--cascades", settings.Cascades.CascadesCount, 1u, ShadowCascades::MAX_CASCADES_COUNT);
+    commandLine.AddOption("--weight", settings.Cascades.LogarithmicSplitWeight, 0.0f, 1.0f);
+    commandLine.AddOption("--resolution", settings.Cascades.Resolution, 16u);
+    commandLine.AddOption("--distance", settings.Cascades.MaxDistance);
+    commandLine.AddOption("--frames", settings.NumFrames, 2u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    try
+    {
+        std::cout << "Cascades: " << settings.Cascades.CascadesCount << ", weight: " << settings.Cascades.LogarithmicSplitWeight
+            << ", resolution: " << settings.Cascades.Resolution << ", distance: " << settings.Cascades.MaxDistance
+            << ", frames: " << settings.NumFrames << std::endl;
+
+        std::mt19937 random(settings.Seed);
+        if (!RunBenchmark(settings, random))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
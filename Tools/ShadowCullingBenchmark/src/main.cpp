@@ -0,0 +1,436 @@
+#include <Aabb.h>
+#include <BoundingSphere.h>
+#include <ShadowCasterCulling.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        // The share of the objects that change every frame.
+        float MovingPercent = 5.0f;
+        uint32_t NumPointLights = 16;
+        uint32_t NumSpotLights = 8;
+        uint32_t NumFrames = 100;
+        uint32_t Seed = 0;
+        // The objects are scattered over a square of this size.
+        float SceneSize = 200.0f;
+    };
+
+    constexpr uint32_t CUBE_SIDES_COUNT = 6;
+
+    // Matches Cubemap::SIDE_ORIENTATIONS.
+    const XMVECTOR CUBE_SIDE_FORWARDS[CUBE_SIDES_COUNT] =
+    {
+        XMVectorSet(1, 0, 0, 0), XMVectorSet(-1, 0, 0, 0),
+        XMVectorSet(0, 1, 0, 0), XMVectorSet(0, -1, 0, 0),
+        XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 0, -1, 0),
+    };
+
+    const XMVECTOR CUBE_SIDE_UPS[CUBE_SIDES_COUNT] =
+    {
+        XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 1, 0, 0),
+        XMVectorSet(0, 0, -1, 0), XMVectorSet(0, 0, 1, 0),
+        XMVectorSet(0, 1, 0, 0), XMVectorSet(0, 1, 0, 0),
+    };
+
+    enum class MotionType
+    {
+        Static,
+        // Around a circle: the bounds change.
+        Moving,
+        // Half a revolution every frame: the bounds stay the same, but the world matrix changes.
+        Turning,
+        // Another model of the same size every frame: only the model changes.
+        Swapping,
+        Count,
+    };
+
+    // Stand in for the models of the objects.
+    const char MODELS[2] = {};
+
+    struct Object
+    {
+        XMFLOAT3 Position;
+        XMFLOAT3 HalfExtents;
+        MotionType Motion;
+        float Phase;
+    };
+
+    struct ShadowView
+    {
+        XMMATRIX ViewProjection;
+        // Only for the point lights.
+        bool HasRange;
+        XMFLOAT3 RangeCenter;
+        float RangeRadius;
+    };
+
+    // The views of one kind of light, culled with their own ShadowCasterCulling like in the LightingDemo's SceneRenderer.
+    struct LightViews
+    {
+        std::vector<ShadowView> Views;
+        ShadowCasterCulling Culling;
+        // What every view has last drawn, to check that a view which is not redrawn would have looked the same.
+        std::vector<std::vector<uint32_t>> DrawnCasters;
+        std::vector<std::vector<ShadowCasterCulling::Caster>> DrawnCasterStates;
+    };
+
+    std::vector<Object> CreateObjects(const uint32_t numObjects, const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> positionDistribution(-settings.SceneSize * 0.5f, settings.SceneSize * 0.5f);
+        std::uniform_real_distribution<float> sizeDistribution(0.25f, 2.0f);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        std::uniform_int_distribution<int> motionDistribution(static_cast<int>(MotionType::Moving), static_cast<int>(MotionType::Count) - 1);
+
+        std::vector<Object> objects(numObjects);
+        for (auto& object : objects)
+        {
+            object.HalfExtents = { sizeDistribution(random), sizeDistribution(random), sizeDistribution(random) };
+            object.Position = { positionDistribution(random), object.HalfExtents.y, positionDistribution(random) };
+            object.Motion = unitDistribution(random) * 100.0f < settings.MovingPercent ? static_cast<MotionType>(motionDistribution(random)) : MotionType::Static;
+            object.Phase = unitDistribution(random) * 6.28f;
+        }
+
+        return objects;
+    }
+
+    void ComputeCasters(const std::vector<Object>& objects, const uint32_t frame, std::vector<ShadowCasterCulling::Caster>& casters)
+    {
+        casters.resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            const auto& object = objects[i];
+            auto& caster = casters[i];
+
+            XMVECTOR position = XMLoadFloat3(&object.Position);
+            if (object.Motion == MotionType::Moving)
+            {
+                const float time = static_cast<float>(frame) * 0.1f + object.Phase;
+                position = XMVectorAdd(position, XMVectorSet(std::sin(time) * 2.0f, 0.0f, std::cos(time) * 2.0f, 0.0f));
+            }
+
+            const float angle = object.Motion == MotionType::Turning ? XM_PI * static_cast<float>(frame % 2) : 0.0f;
+            caster.WorldMatrix = XMMatrixRotationY(angle) * XMMatrixTranslationFromVector(position);
+            caster.Model = &MODELS[object.Motion == MotionType::Swapping ? frame % 2 : 0];
+
+            const XMVECTOR halfExtents = XMLoadFloat3(&object.HalfExtents);
+            caster.Bounds.Min = XMVectorSetW(XMVectorSubtract(position, halfExtents), 1.0f);
+            caster.Bounds.Max = XMVectorSetW(XMVectorAdd(position, halfExtents), 1.0f);
+        }
+    }
+
+    // The same matrices as the shadow pass PSOs compute.
+    std::vector<LightViews> CreateLightViews(const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> positionDistribution(-settings.SceneSize * 0.5f, settings.SceneSize * 0.5f);
+        std::vector<LightViews> lightViews(3);
+
+        {
+            // Directional: an orthographic projection around the scene's bounding sphere.
+            const XMVECTOR lightDirection = XMVector3Normalize(XMVectorSet(0.3f, 1.0f, 0.2f, 0.0f));
+            const float radius = settings.SceneSize * 0.75f;
+            const XMVECTOR sceneCenter = XMVectorZero();
+            const auto viewMatrix = XMMatrixLookToLH(XMVectorScale(lightDirection, 2.0f * radius), XMVectorNegate(lightDirection), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+            XMFLOAT3 sceneCenterVs{};
+            XMStoreFloat3(&sceneCenterVs, XMVector3TransformCoord(sceneCenter, viewMatrix));
+            const auto projectionMatrix = XMMatrixOrthographicOffCenterLH(sceneCenterVs.x - radius, sceneCenterVs.x + radius,
+                sceneCenterVs.y - radius, sceneCenterVs.y + radius,
+                sceneCenterVs.z - radius, sceneCenterVs.z + radius);
+            lightViews[0].Views.push_back({ viewMatrix * projectionMatrix, false, {}, 0.0f });
+        }
+
+        for (uint32_t lightIndex = 0; lightIndex < settings.NumPointLights; ++lightIndex)
+        {
+            // PointLightShadowPassPso::ComputeShadowRange of a light with the default range and a white color.
+            const float range = 20.0f * 2.0f;
+            const XMFLOAT3 position = { positionDistribution(random), 4.0f, positionDistribution(random) };
+            const XMVECTOR eyePosition = XMLoadFloat3(&position);
+
+            for (uint32_t sideIndex = 0; sideIndex < CUBE_SIDES_COUNT; ++sideIndex)
+            {
+                const auto viewMatrix = XMMatrixLookToLH(eyePosition, CUBE_SIDE_FORWARDS[sideIndex], CUBE_SIDE_UPS[sideIndex]);
+                const auto projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(90.0f), 1, 0.1f, range);
+                lightViews[1].Views.push_back({ viewMatrix * projectionMatrix, true, position, range });
+            }
+        }
+
+        for (uint32_t lightIndex = 0; lightIndex < settings.NumSpotLights; ++lightIndex)
+        {
+            const XMVECTOR eyePosition = XMVectorSet(positionDistribution(random), 10.0f, positionDistribution(random), 1.0f);
+            const XMVECTOR eyeDirection = XMVector3Normalize(XMVectorSet(positionDistribution(random) * 0.01f, -1.0f, positionDistribution(random) * 0.01f, 0.0f));
+            const auto viewMatrix = XMMatrixLookToLH(eyePosition, eyeDirection, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+            const auto projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(30.0f) * 2, 1, 0.1f, 100.0f);
+            lightViews[2].Views.push_back({ viewMatrix * projectionMatrix, false, {}, 0.0f });
+        }
+
+        for (auto& views : lightViews)
+        {
+            views.DrawnCasters.resize(views.Views.size());
+            views.DrawnCasterStates.resize(views.Views.size());
+        }
+
+        return lightViews;
+    }
+
+    bool IsInsideClipSpace(const XMVECTOR position, const XMMATRIX& viewProjection)
+    {
+        XMFLOAT4 clipPosition;
+        XMStoreFloat4(&clipPosition, XMVector4Transform(XMVectorSetW(position, 1.0f), viewProjection));
+        return clipPosition.w > 0.0f &&
+            std::abs(clipPosition.x) <= clipPosition.w && std::abs(clipPosition.y) <= clipPosition.w &&
+            clipPosition.z >= 0.0f && clipPosition.z <= clipPosition.w;
+    }
+
+    // A brute-force reference: a point sampled inside the box is seen by the view (and in its range), so the caster must not be culled.
+    bool IsSurelyVisible(const Aabb& bounds, const ShadowView& view)
+    {
+        constexpr uint32_t SAMPLES_PER_AXIS = 4;
+
+        for (uint32_t x = 0; x < SAMPLES_PER_AXIS; ++x)
+        {
+            for (uint32_t y = 0; y < SAMPLES_PER_AXIS; ++y)
+            {
+                for (uint32_t z = 0; z < SAMPLES_PER_AXIS; ++z)
+                {
+                    const XMVECTOR t = XMVectorScale(XMVectorSet(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z), 0.0f), 1.0f / (SAMPLES_PER_AXIS - 1));
+                    const XMVECTOR position = XMVectorAdd(bounds.Min, XMVectorMultiply(XMVectorSubtract(bounds.Max, bounds.Min), t));
+
+                    if (view.HasRange)
+                    {
+                        const XMVECTOR offset = XMVectorSubtract(position, XMLoadFloat3(&view.RangeCenter));
+                        if (XMVectorGetX(XMVector3Dot(offset, offset)) > view.RangeRadius * view.RangeRadius)
+                        {
+                            continue;
+                        }
+                    }
+
+                    if (IsInsideClipSpace(position, view.ViewProjection))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // The caster would cast the same shadow.
+    bool AreEqual(const ShadowCasterCulling::Caster& caster1, const ShadowCasterCulling::Caster& caster2)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            if (!XMVector4Equal(caster1.WorldMatrix.r[row], caster2.WorldMatrix.r[row]))
+            {
+                return false;
+            }
+        }
+
+        return caster1.Model == caster2.Model;
+    }
+
+    struct FrameStats
+    {
+        uint64_t NumViews = 0;
+        uint64_t NumRedrawnViews = 0;
+        // Every view draws every object.
+        uint64_t NumNaiveDraws = 0;
+        // Every view draws its visible casters.
+        uint64_t NumCulledDraws = 0;
+        // Only the changed views draw their visible casters.
+        uint64_t NumCachedDraws = 0;
+    };
+
+    // Returns false if a check fails.
+    bool CullFrame(std::vector<LightViews>& lightViews, const std::vector<ShadowCasterCulling::Caster>& casters, FrameStats& stats, const bool validate)
+    {
+        for (auto& views : lightViews)
+        {
+            views.Culling.BeginFrame(casters);
+
+            for (uint32_t viewIndex = 0; viewIndex < views.Views.size(); ++viewIndex)
+            {
+                const auto& view = views.Views[viewIndex];
+                const BoundingSphere range(view.RangeRadius, XMLoadFloat3(&view.RangeCenter));
+                const bool isDirty = views.Culling.CullView(viewIndex, view.ViewProjection, view.HasRange ? &range : nullptr);
+                const auto& visibleCasters = views.Culling.GetVisibleCasters(viewIndex);
+
+                stats.NumCulledDraws += visibleCasters.size();
+
+                if (!validate)
+                {
+                    continue;
+                }
+
+                for (uint32_t casterIndex = 0, visibleIndex = 0; casterIndex < casters.size(); ++casterIndex)
+                {
+                    const bool isCulled = visibleIndex >= visibleCasters.size() || visibleCasters[visibleIndex] != casterIndex;
+                    if (!isCulled)
+                    {
+                        ++visibleIndex;
+                    }
+                    else if (IsSurelyVisible(casters[casterIndex].Bounds, view))
+                    {
+                        std::cerr << "Object " << casterIndex << " is visible in view " << viewIndex << " but has been culled." << std::endl;
+                        return false;
+                    }
+                }
+
+                auto& drawnCasters = views.DrawnCasters[viewIndex];
+                auto& drawnCasterStates = views.DrawnCasterStates[viewIndex];
+                if (isDirty)
+                {
+                    drawnCasters = visibleCasters;
+                    drawnCasterStates.clear();
+                    for (const uint32_t casterIndex : visibleCasters)
+                    {
+                        drawnCasterStates.push_back(casters[casterIndex]);
+                    }
+                    continue;
+                }
+
+                // Not redrawn: the shadow map must still show exactly these casters, where and as they are.
+                bool isStale = drawnCasters != visibleCasters;
+                for (size_t i = 0; !isStale && i < visibleCasters.size(); ++i)
+                {
+                    isStale = !AreEqual(drawnCasterStates[i], casters[visibleCasters[i]]);
+                }
+
+                if (isStale)
+                {
+                    std::cerr << "View " << viewIndex << " has changed but is not redrawn." << std::endl;
+                    return false;
+                }
+            }
+
+            const auto& cullingStats = views.Culling.GetStats();
+            stats.NumViews += cullingStats.NumViews;
+            stats.NumRedrawnViews += cullingStats.NumRedrawnViews;
+            stats.NumNaiveDraws += static_cast<uint64_t>(views.Views.size()) * casters.size();
+            stats.NumCachedDraws += cullingStats.NumDraws;
+        }
+
+        return true;
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const uint32_t numObjects, const Settings& settings, std::mt19937& random)
+    {
+        const std::vector<Object> objects = CreateObjects(numObjects, settings, random);
+        std::vector<ShadowCasterCulling::Caster> casters;
+
+        // The first frames check the culling against the reference, and then the rest are timed.
+        {
+            std::vector<LightViews> lightViews = CreateLightViews(settings, random);
+            for (uint32_t frame = 0; frame < std::min(settings.NumFrames, 3u); ++frame)
+            {
+                ComputeCasters(objects, frame, casters);
+
+                FrameStats stats;
+                if (!CullFrame(lightViews, casters, stats, true))
+                {
+                    return false;
+                }
+            }
+        }
+
+        std::vector<LightViews> lightViews = CreateLightViews(settings, random);
+        FrameStats firstFrameStats;
+        FrameStats stats;
+
+        const double time = ToolsCommon::MeasureTime([&]()
+            {
+                for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+                {
+                    ComputeCasters(objects, frame, casters);
+                    CullFrame(lightViews, casters, frame == 0 ? firstFrameStats : stats, false);
+                }
+            });
+
+        const auto perFrame = [&settings](const uint64_t count)
+        {
+            return count / std::max(settings.NumFrames - 1, 1u);
+        };
+
+        const auto countObjects = [&objects](const MotionType motion)
+        {
+            return std::count_if(objects.begin(), objects.end(), [motion](const Object& object) { return object.Motion == motion; });
+        };
+
+        std::cout << "Objects: " << numObjects << " (" << countObjects(MotionType::Moving) << " moving, " << countObjects(MotionType::Turning) << " turning, "
+            << countObjects(MotionType::Swapping) << " swapping)"
+            << ", culling " << time * 1000.0 / settings.NumFrames << " us per frame"
+            << ", first frame: " << firstFrameStats.NumNaiveDraws << " naive draws, " << firstFrameStats.NumCachedDraws << " culled draws"
+            << "; per frame: " << perFrame(stats.NumNaiveDraws) << " naive draws, " << perFrame(stats.NumCulledDraws) << " culled draws, "
+            << perFrame(stats.NumCachedDraws) << " culled and cached draws"
+            << ", redrawn views " << perFrame(stats.NumRedrawnViews) << "/" << perFrame(stats.NumViews) << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> objectCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: ShadowCullingBenchmark [--objects <count>...] [--moving <percent>] [--point-lights <count>] [--spot-lights <count>] [--frames <count>] [--seed <value>]\n"
+        "       The changing objects are evenly split between moving, turning in place, and swapping their models.");
+    commandLine.AddOption("--objects", objectCounts, 1u);
+    commandLine.AddOption("--moving", settings.MovingPercent, 0.0f, 100.0f);
+    commandLine.AddOption("--point-lights", settings.NumPointLights);
+    commandLine.AddOption("--spot-lights", settings.NumSpotLights);
+    commandLine.AddOption("--frames", settings.NumFrames, 2u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (objectCounts.empty())
+    {
+        objectCounts = { 100, 1000, 10000 };
+    }
+
+    try
+    {
+        std::cout << "Point lights: " << settings.NumPointLights << " (" << settings.NumPointLights * CUBE_SIDES_COUNT << " views)"
+            << ", spot lights: " << settings.NumSpotLights << ", directional lights: 1"
+            << ", moving: " << settings.MovingPercent << "%, frames: " << settings.NumFrames << std::endl;
+
+        std::mt19937 random(settings.Seed);
+        bool success = true;
+        for (const uint32_t numObjects : objectCounts)
+        {
+            success &= RunBenchmark(numObjects, settings, random);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,408 @@
+#include <Armature.h>
+#include <BonePalette.h>
+#include <InstanceBatcher.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/CountingAllocator.h>
+#include <ToolsCommon/MathUtils.h>
+#include <ToolsCommon/Skeletons.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumBones = 65;
+        // The distinct meshes and materials the characters are drawn with.
+        uint32_t NumMeshes = 3;
+        uint32_t NumMaterials = 2;
+        uint32_t NumFrames = 200;
+        uint32_t Seed = 0;
+    };
+
+    // Stands for the mesh and the material of a draw.
+    struct DrawKey
+    {
+        uint32_t MeshIndex;
+        uint32_t MaterialIndex;
+
+        bool operator<(const DrawKey& other) const
+        {
+            return MeshIndex != other.MeshIndex ? MeshIndex < other.MeshIndex : MaterialIndex < other.MaterialIndex;
+        }
+    };
+
+    // The same layout as the demo's.
+    struct SkinnedInstance
+    {
+        XMMATRIX Model;
+        XMMATRIX InverseTransposeModel;
+        uint32_t PaletteOffset;
+        // Not uploaded by the demo, used to check the order of the instances.
+        uint32_t CharacterIndex;
+        uint32_t Padding[2];
+    };
+
+    struct Character
+    {
+        Armature Bones;
+        DrawKey Key;
+        XMMATRIX World;
+    };
+
+    std::vector<Character> CreateCharacters(const uint32_t numCharacters, const Settings& settings, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+        std::uniform_int_distribution<uint32_t> meshDistribution(0, settings.NumMeshes - 1);
+        std::uniform_int_distribution<uint32_t> materialDistribution(0, settings.NumMaterials - 1);
+
+        std::vector<Character> characters(numCharacters);
+        for (auto& character : characters)
+        {
+            std::vector<Bone> bones = ToolsCommon::CreateBones(settings.NumBones);
+            for (auto& bone : bones)
+            {
+                bone.Offset = XMMatrixTranslation(distribution(random), distribution(random), distribution(random));
+                bone.LocalTransform = XMMatrixRotationRollPitchYaw(distribution(random), distribution(random), distribution(random)) *
+                    XMMatrixTranslation(distribution(random), distribution(random), distribution(random));
+            }
+
+            character.Bones.SetBones(bones, ToolsCommon::CreateChainParentIndices(settings.NumBones));
+            character.Bones.UpdateBoneGlobalTransforms();
+            character.Key = { meshDistribution(random), materialDistribution(random) };
+            character.World = XMMatrixScaling(0.05f, 0.05f, 0.05f) * XMMatrixTranslation(distribution(random) * 50.0f, 0.0f, distribution(random) * 50.0f);
+        }
+
+        return characters;
+    }
+
+    struct FrameStats
+    {
+        uint32_t NumDraws = 0;
+        uint32_t NumUploads = 0;
+        size_t NumUploadedBytes = 0;
+    };
+
+    /**
+     * What the demo used to do: a new vector of skinning matrices and an upload per character,
+     * then a constant buffer and a draw per bone.
+     */
+    FrameStats LegacyFrame(const std::vector<Character>& characters, const XMMATRIX& viewProjection, std::vector<uint8_t>& uploadBuffer)
+    {
+        FrameStats stats;
+
+        const auto upload = [&](const void* data, const size_t size)
+        {
+            uploadBuffer.resize(size);
+            std::memcpy(uploadBuffer.data(), data, size);
+            ++stats.NumUploads;
+            stats.NumUploadedBytes += size;
+        };
+
+        for (const auto& character : characters)
+        {
+            const auto& bones = character.Bones.GetBones();
+            std::vector<XMMATRIX> bonesSb;
+            bonesSb.reserve(bones.size());
+
+            for (const auto& bone : bones)
+            {
+                bonesSb.push_back(bone.Offset * bone.GlobalTransform);
+            }
+
+            upload(bonesSb.data(), bonesSb.size() * sizeof(XMMATRIX));
+            ++stats.NumDraws;
+        }
+
+        for (const auto& character : characters)
+        {
+            for (const auto& bone : character.Bones.GetBones())
+            {
+                const XMMATRIX modelViewProjection[] = {
+                    bone.GlobalTransform * character.World * viewProjection,
+                    XMMatrixTranspose(XMMatrixInverse(nullptr, bone.GlobalTransform * character.World)),
+                };
+                upload(modelViewProjection, sizeof(modelViewProjection));
+                ++stats.NumDraws;
+            }
+        }
+
+        return stats;
+    }
+
+    using Batcher = InstanceBatcher<DrawKey, SkinnedInstance>;
+
+    // Returns the index of the first bone world matrix in the palette.
+    uint32_t PackFrame(const std::vector<Character>& characters, BonePalette& bonePalette, Batcher& batcher)
+    {
+        bonePalette.Clear();
+        batcher.Clear();
+
+        for (uint32_t characterIndex = 0; characterIndex < characters.size(); ++characterIndex)
+        {
+            const auto& character = characters[characterIndex];
+
+            SkinnedInstance instance{};
+            instance.Model = character.World;
+            instance.InverseTransposeModel = XMMatrixTranspose(XMMatrixInverse(nullptr, character.World));
+            instance.PaletteOffset = bonePalette.AddSkinningMatrices(character.Bones);
+            instance.CharacterIndex = characterIndex;
+            batcher.Add(character.Key, instance);
+        }
+
+        batcher.Build();
+
+        const uint32_t firstBoneInstance = bonePalette.GetSize();
+        for (const auto& character : characters)
+        {
+            bonePalette.AddBoneWorldMatrices(character.Bones, character.World);
+        }
+
+        return firstBoneInstance;
+    }
+
+    // The instanced path: the palette and the instances are uploaded once, then a draw per batch and one for all the bones.
+    FrameStats PaletteFrame(const std::vector<Character>& characters, BonePalette& bonePalette, Batcher& batcher, std::vector<uint8_t>& uploadBuffer)
+    {
+        PackFrame(characters, bonePalette, batcher);
+
+        FrameStats stats;
+        const auto upload = [&](const void* data, const size_t size)
+        {
+            uploadBuffer.resize(size);
+            std::memcpy(uploadBuffer.data(), data, size);
+            ++stats.NumUploads;
+            stats.NumUploadedBytes += size;
+        };
+
+        upload(bonePalette.GetMatrices().data(), bonePalette.GetMatrices().size() * sizeof(XMMATRIX));
+        upload(batcher.GetInstances().data(), batcher.GetInstances().size() * sizeof(SkinnedInstance));
+        stats.NumDraws = static_cast<uint32_t>(batcher.GetBatches().size()) + 1;
+        return stats;
+    }
+
+    // Every instance must find its own matrices, and every batch must be a contiguous range of instances with the same key in the order they were added.
+    bool Validate(const std::vector<Character>& characters, const BonePalette& bonePalette, const Batcher& batcher, const uint32_t firstBoneInstance)
+    {
+        const auto& matrices = bonePalette.GetMatrices();
+        const auto& instances = batcher.GetInstances();
+
+        if (instances.size() != characters.size())
+        {
+            std::cerr << "Expected " << characters.size() << " instances, got " << instances.size() << "." << std::endl;
+            return false;
+        }
+
+        std::vector<bool> isDrawn(characters.size(), false);
+        uint32_t expectedFirstInstance = 0;
+
+        for (size_t batchIndex = 0; batchIndex < batcher.GetBatches().size(); ++batchIndex)
+        {
+            const auto& batch = batcher.GetBatches()[batchIndex];
+            if (batch.FirstInstance != expectedFirstInstance || batch.NumInstances == 0)
+            {
+                std::cerr << "Batch " << batchIndex << " is not contiguous with the previous one." << std::endl;
+                return false;
+            }
+
+            if (batchIndex > 0 && !(batcher.GetBatches()[batchIndex - 1].Key < batch.Key))
+            {
+                std::cerr << "Batch " << batchIndex << " has the same key as another one." << std::endl;
+                return false;
+            }
+
+            for (uint32_t instanceIndex = batch.FirstInstance; instanceIndex < batch.FirstInstance + batch.NumInstances; ++instanceIndex)
+            {
+                const auto& instance = instances[instanceIndex];
+                const auto& character = characters[instance.CharacterIndex];
+
+                if (character.Key < batch.Key || batch.Key < character.Key || isDrawn[instance.CharacterIndex])
+                {
+                    std::cerr << "Character " << instance.CharacterIndex << " is in a wrong batch or drawn twice." << std::endl;
+                    return false;
+                }
+
+                if (instanceIndex > batch.FirstInstance && instances[instanceIndex - 1].CharacterIndex > instance.CharacterIndex)
+                {
+                    std::cerr << "The instances of batch " << batchIndex << " are not in the order they were added in." << std::endl;
+                    return false;
+                }
+
+                isDrawn[instance.CharacterIndex] = true;
+
+                const auto& bones = character.Bones.GetBones();
+                if (instance.PaletteOffset + bones.size() > firstBoneInstance)
+                {
+                    std::cerr << "The skinning matrices of character " << instance.CharacterIndex << " are out of range." << std::endl;
+                    return false;
+                }
+
+                for (size_t boneIndex = 0; boneIndex < bones.size(); ++boneIndex)
+                {
+                    if (!ToolsCommon::AreEqual(matrices[instance.PaletteOffset + boneIndex], bones[boneIndex].Offset * bones[boneIndex].GlobalTransform))
+                    {
+                        std::cerr << "Bone " << boneIndex << " of character " << instance.CharacterIndex << " has a wrong skinning matrix." << std::endl;
+                        return false;
+                    }
+                }
+            }
+
+            expectedFirstInstance += batch.NumInstances;
+        }
+
+        if (expectedFirstInstance != instances.size())
+        {
+            std::cerr << "The batches do not cover all the instances." << std::endl;
+            return false;
+        }
+
+        // The bone world matrices follow the skinning matrices, in the order of the characters.
+        size_t matrixIndex = firstBoneInstance;
+        for (const auto& character : characters)
+        {
+            for (const auto& bone : character.Bones.GetBones())
+            {
+                if (matrixIndex >= matrices.size() || !ToolsCommon::AreEqual(matrices[matrixIndex], bone.GlobalTransform * character.World))
+                {
+                    std::cerr << "Wrong bone world matrix at " << matrixIndex << "." << std::endl;
+                    return false;
+                }
+                ++matrixIndex;
+            }
+        }
+
+        if (matrixIndex != matrices.size())
+        {
+            std::cerr << "The palette has " << matrices.size() - matrixIndex << " extra matrices." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Keeps the work from being optimized away.
+    float Checksum(const std::vector<uint8_t>& uploadBuffer)
+    {
+        return uploadBuffer.empty() ? 0.0f : static_cast<float>(uploadBuffer[uploadBuffer.size() / 2]);
+    }
+
+    // Returns false if a check fails.
+    bool RunBenchmark(const uint32_t numCharacters, const Settings& settings, std::mt19937& random)
+    {
+        const std::vector<Character> characters = CreateCharacters(numCharacters, settings, random);
+        const XMMATRIX viewProjection = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+        BonePalette bonePalette;
+        Batcher batcher;
+        std::vector<uint8_t> uploadBuffer;
+
+        if (!Validate(characters, bonePalette, batcher, PackFrame(characters, bonePalette, batcher)))
+        {
+            return false;
+        }
+
+        float checksum = 0.0f;
+        FrameStats legacyStats;
+        const double legacyTime = ToolsCommon::MeasureTime([&]()
+            {
+                for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+                {
+                    legacyStats = LegacyFrame(characters, viewProjection, uploadBuffer);
+                    checksum += Checksum(uploadBuffer);
+                }
+            });
+
+        // Warm up, so that the buffers have the capacity.
+        PaletteFrame(characters, bonePalette, batcher, uploadBuffer);
+
+        FrameStats paletteStats;
+        const uint64_t numAllocationsBefore = ToolsCommon::g_NumAllocations;
+        const double paletteTime = ToolsCommon::MeasureTime([&]()
+            {
+                for (uint32_t frame = 0; frame < settings.NumFrames; ++frame)
+                {
+                    paletteStats = PaletteFrame(characters, bonePalette, batcher, uploadBuffer);
+                    checksum += Checksum(uploadBuffer);
+                }
+            });
+        const uint64_t numAllocations = ToolsCommon::g_NumAllocations - numAllocationsBefore;
+
+        const auto perFrame = [&settings](const double time)
+        {
+            return time * 1000.0 / settings.NumFrames;
+        };
+
+        std::cout << "Characters: " << numCharacters
+            << ", per frame: legacy " << perFrame(legacyTime) << " us, " << legacyStats.NumDraws << " draws, " << legacyStats.NumUploads << " uploads"
+            << "; palette " << perFrame(paletteTime) << " us (x" << legacyTime / paletteTime << "), " << paletteStats.NumDraws << " draws, " << paletteStats.NumUploads << " uploads"
+            << " (" << paletteStats.NumUploadedBytes / 1024 << " KiB)"
+            << ", allocations in steady state " << numAllocations
+            << " [checksum " << checksum << "]" << std::endl;
+
+        if (numAllocations != 0)
+        {
+            std::cerr << "The palette path has allocated " << numAllocations << " times in the steady state." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::vector<uint32_t> characterCounts;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: SkinnedInstancingBenchmark [--characters <count>...] [--bones <count>] [--meshes <count>] [--materials <count>] [--frames <count>] [--seed <value>]");
+    commandLine.AddOption("--characters", characterCounts, 1u);
+    commandLine.AddOption("--bones", settings.NumBones, 1u);
+    commandLine.AddOption("--meshes", settings.NumMeshes, 1u);
+    commandLine.AddOption("--materials", settings.NumMaterials, 1u);
+    commandLine.AddOption("--frames", settings.NumFrames, 1u);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (characterCounts.empty())
+    {
+        characterCounts = { 1, 10, 100, 1000 };
+    }
+
+    try
+    {
+        std::cout << "Bones: " << settings.NumBones << ", meshes: " << settings.NumMeshes << ", materials: " << settings.NumMaterials
+            << ", frames: " << settings.NumFrames << std::endl;
+
+        std::mt19937 random(settings.Seed);
+        bool success = true;
+        for (const uint32_t numCharacters : characterCounts)
+        {
+            success &= RunBenchmark(numCharacters, settings, random);
+        }
+
+        if (!success)
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
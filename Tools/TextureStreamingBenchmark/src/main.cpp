@@ -0,0 +1,381 @@
+#include <DX12Library/TextureResidencyManager.h>
+
+#include <ToolsCommon/CommandLine.h>
+#include <ToolsCommon/Timing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+    constexpr size_t MEBIBYTE = 1024 * 1024;
+
+    struct Vector3
+    {
+        float x, y, z;
+
+        Vector3 operator+(const Vector3& other) const { return { x + other.x, y + other.y, z + other.z }; }
+        Vector3 operator-(const Vector3& other) const { return { x - other.x, y - other.y, z - other.z }; }
+        Vector3 operator*(const float scale) const { return { x * scale, y * scale, z * scale }; }
+
+        float Dot(const Vector3& other) const { return x * other.x + y * other.y + z * other.z; }
+        float Length() const { return std::sqrt(Dot(*this)); }
+        Vector3 Normalize() const { return *this * (1.0f / std::max(Length(), 1e-6f)); }
+    };
+
+    struct CameraFrame
+    {
+        Vector3 Position;
+        Vector3 Forward;
+    };
+
+    struct Object
+    {
+        Vector3 Center;
+        float Radius;
+        // Objects share textures, like materials in a scene.
+        uint32_t TextureIndex;
+    };
+
+    struct Scene
+    {
+        // The objects are scattered over [-extent, extent] on the XZ plane.
+        float Extent;
+        std::vector<Object> Objects;
+        std::vector<TextureResidencyManager::TextureDesc> Textures;
+    };
+
+    // BC7 for most textures (16 bytes per 4x4 block), RGBA8 for some.
+    TextureResidencyManager::TextureDesc CreateTextureDesc(const uint32_t size, const bool isCompressed)
+    {
+        TextureResidencyManager::TextureDesc desc;
+        desc.m_Width = size;
+        desc.m_Height = size;
+
+        for (uint32_t mipSize = size; ; mipSize /= 2)
+        {
+            const size_t numBlocks = (mipSize + 3) / 4;
+            desc.m_MipSizesInBytes.push_back(isCompressed ? numBlocks * numBlocks * 16 : static_cast<size_t>(mipSize) * mipSize * 4);
+
+            if (mipSize == 1)
+            {
+                break;
+            }
+        }
+
+        return desc;
+    }
+
+    Scene CreateScene(const uint32_t numObjects, const uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<uint32_t> sizeExponentDistribution(9, 12);
+        std::uniform_real_distribution<float> compressedDistribution(0.0f, 1.0f);
+        std::uniform_real_distribution<float> radiusDistribution(0.5f, 4.0f);
+
+        Scene scene;
+        scene.Extent = std::sqrt(static_cast<float>(numObjects)) * 5.0f;
+        std::uniform_real_distribution<float> positionDistribution(-scene.Extent, scene.Extent);
+
+        const uint32_t numTextures = std::max(numObjects / 4, 1u);
+        for (uint32_t i = 0; i < numTextures; ++i)
+        {
+            scene.Textures.push_back(CreateTextureDesc(1u << sizeExponentDistribution(random), compressedDistribution(random) < 0.8f));
+        }
+
+        std::uniform_int_distribution<uint32_t> textureDistribution(0, numTextures - 1);
+        for (uint32_t i = 0; i < numObjects; ++i)
+        {
+            const float radius = radiusDistribution(random);
+            scene.Objects.push_back({ { positionDistribution(random), radius, positionDistribution(random) }, radius, textureDistribution(random) });
+        }
+
+        return scene;
+    }
+
+    // Looks along the path, so only positions are needed.
+    std::vector<CameraFrame> CreateCameraFrames(const std::vector<Vector3>& positions)
+    {
+        if (positions.size() < 2)
+        {
+            throw std::runtime_error("A camera path needs at least two positions.");
+        }
+
+        std::vector<CameraFrame> frames;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            const size_t next = std::min(i + 1, positions.size() - 1);
+            const size_t previous = next == i ? i - 1 : i;
+            frames.push_back({ positions[i], (positions[next] - positions[previous]).Normalize() });
+        }
+
+        return frames;
+    }
+
+    std::vector<CameraFrame> CreateOrbitPath(const Scene& scene, const uint32_t numFrames)
+    {
+        std::vector<CameraFrame> frames;
+        for (uint32_t i = 0; i < numFrames; ++i)
+        {
+            const float angle = 2.0f * PI * static_cast<float>(i) / static_cast<float>(numFrames);
+            const Vector3 position = { std::cos(angle) * scene.Extent * 1.2f, scene.Extent * 0.3f, std::sin(angle) * scene.Extent * 1.2f };
+            frames.push_back({ position, (Vector3{ 0, 0, 0 } - position).Normalize() });
+        }
+
+        return frames;
+    }
+
+    // A figure eight close to the ground, passing through the scene.
+    std::vector<CameraFrame> CreateFlythroughPath(const Scene& scene, const uint32_t numFrames)
+    {
+        std::vector<Vector3> positions;
+        for (uint32_t i = 0; i < numFrames; ++i)
+        {
+            const float t = 2.0f * PI * static_cast<float>(i) / static_cast<float>(numFrames);
+            positions.push_back({ std::sin(t) * scene.Extent * 0.9f, 2.0f, std::sin(t) * std::cos(t) * scene.Extent * 0.9f });
+        }
+
+        return CreateCameraFrames(positions);
+    }
+
+    std::vector<CameraFrame> LoadPath(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open " + path + ".");
+        }
+
+        std::vector<Vector3> positions;
+        Vector3 position{};
+        while (file >> position.x >> position.y >> position.z)
+        {
+            positions.push_back(position);
+        }
+
+        return CreateCameraFrames(positions);
+    }
+
+    struct Settings
+    {
+        float ViewportHeight = 1080.0f;
+        float AspectRatio = 16.0f / 9.0f;
+        float VerticalFov = PI / 3.0f;
+    };
+
+    struct Statistics
+    {
+        double AverageUpdateTime = 0.0;
+        double MaxUpdateTime = 0.0;
+        size_t LoadedSizeInBytes = 0;
+        size_t EvictedSizeInBytes = 0;
+        size_t PeakResidentSizeInBytes = 0;
+        size_t NumRequests = 0;
+        size_t NumSatisfiedRequests = 0;
+        size_t NumMissingMips = 0;
+    };
+
+    size_t GetSizeFromMip(const TextureResidencyManager::TextureDesc& desc, const uint16_t mip)
+    {
+        size_t size = 0;
+        for (size_t i = mip; i < desc.m_MipSizesInBytes.size(); ++i)
+        {
+            size += desc.m_MipSizesInBytes[i];
+        }
+        return size;
+    }
+
+    // Replays the camera path: every frame, the visible objects request the mips of their textures from their screen size (like GameObject::RequestTextureMips).
+    Statistics Simulate(const Scene& scene, const std::vector<CameraFrame>& cameraFrames, const size_t budgetInBytes, const Settings& settings)
+    {
+        TextureResidencyManager residencyManager(budgetInBytes);
+
+        std::vector<TextureResidencyManager::TextureId> textureIds;
+        for (const auto& desc : scene.Textures)
+        {
+            textureIds.push_back(residencyManager.Register(desc));
+        }
+
+        // cot(vFov / 2), as in LodSelector.
+        const float projectionScale = 1.0f / std::tan(settings.VerticalFov * 0.5f);
+        // A cone around the frustum.
+        const float tanHalfDiagonalFov = std::tan(settings.VerticalFov * 0.5f) * std::sqrt(1.0f + settings.AspectRatio * settings.AspectRatio);
+        const float cosHalfDiagonalFov = 1.0f / std::sqrt(1.0f + tanHalfDiagonalFov * tanHalfDiagonalFov);
+        const float sinHalfDiagonalFov = tanHalfDiagonalFov * cosHalfDiagonalFov;
+
+        Statistics statistics;
+        // The finest mip requested in the frame, per texture.
+        std::vector<uint16_t> requestedMips(scene.Textures.size());
+
+        for (const CameraFrame& cameraFrame : cameraFrames)
+        {
+            std::fill(requestedMips.begin(), requestedMips.end(), UINT16_MAX);
+
+            for (const Object& object : scene.Objects)
+            {
+                const Vector3 offset = object.Center - cameraFrame.Position;
+                const float depth = offset.Dot(cameraFrame.Forward);
+                const float distance = offset.Length();
+
+                // Outside of the cone: the angle to the axis minus the angular radius is larger than the half angle.
+                const float lateralDistance = std::sqrt(std::max(distance * distance - depth * depth, 0.0f));
+                if (depth * sinHalfDiagonalFov - lateralDistance * cosHalfDiagonalFov < -object.Radius)
+                {
+                    continue;
+                }
+
+                const float screenSize = object.Radius * projectionScale / std::max(depth, object.Radius);
+                const float screenSizeInPixels = screenSize * settings.ViewportHeight;
+
+                const TextureResidencyManager::TextureId id = textureIds[object.TextureIndex];
+                residencyManager.RequestScreenSize(id, screenSizeInPixels);
+
+                const auto& desc = scene.Textures[object.TextureIndex];
+                const uint16_t mip = TextureResidencyManager::ComputeMip(desc.m_Width, desc.m_Height,
+                    static_cast<uint16_t>(desc.m_MipSizesInBytes.size()), screenSizeInPixels);
+                requestedMips[object.TextureIndex] = std::min(requestedMips[object.TextureIndex], mip);
+            }
+
+            const auto startTime = ToolsCommon::Clock::now();
+            const auto& changes = residencyManager.Update();
+            const double updateTime = ToolsCommon::GetElapsedMs(startTime) * 1000.0;
+            statistics.AverageUpdateTime += updateTime;
+            statistics.MaxUpdateTime = std::max(statistics.MaxUpdateTime, updateTime);
+
+            for (const auto& change : changes)
+            {
+                const auto& desc = scene.Textures[change.m_Id];
+                const size_t previousSize = GetSizeFromMip(desc, change.m_PreviousMip);
+                const size_t size = GetSizeFromMip(desc, change.m_Mip);
+                if (size > previousSize)
+                {
+                    statistics.LoadedSizeInBytes += size - previousSize;
+                }
+                else
+                {
+                    statistics.EvictedSizeInBytes += previousSize - size;
+                }
+            }
+
+            statistics.PeakResidentSizeInBytes = std::max(statistics.PeakResidentSizeInBytes, residencyManager.GetResidentSizeInBytes());
+
+            for (size_t i = 0; i < requestedMips.size(); ++i)
+            {
+                if (requestedMips[i] == UINT16_MAX)
+                {
+                    continue;
+                }
+
+                const uint16_t mip = residencyManager.GetMip(textureIds[i]);
+
+                ++statistics.NumRequests;
+                if (mip <= requestedMips[i])
+                {
+                    ++statistics.NumSatisfiedRequests;
+                }
+                else
+                {
+                    statistics.NumMissingMips += mip - requestedMips[i];
+                }
+            }
+        }
+
+        statistics.AverageUpdateTime /= static_cast<double>(cameraFrames.size());
+        return statistics;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    std::string pathName = "flythrough";
+    uint32_t numFrames = 2000;
+    uint32_t numObjects = 4000;
+    uint32_t seed = 0;
+    std::vector<size_t> budgetsInMebibytes;
+    Settings settings;
+
+    ToolsCommon::CommandLine commandLine("Usage: TextureStreamingBenchmark [--path orbit|flythrough|<file>] [--frames <count>] [--objects <count>] [--budget <MiB>...] [--height <pixels>] [--seed <value>]\n"
+        "       A path file has a camera position per line: x y z");
+    commandLine.AddOption("--path", pathName);
+    commandLine.AddOption("--frames", numFrames, 2u);
+    commandLine.AddOption("--objects", numObjects, 1u);
+    commandLine.AddOption("--budget", budgetsInMebibytes);
+    commandLine.AddOption("--height", settings.ViewportHeight);
+    commandLine.AddOption("--seed", seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    if (budgetsInMebibytes.empty())
+    {
+        budgetsInMebibytes = { 64, 128, 256, 512, 1024 };
+    }
+
+    try
+    {
+        const Scene scene = CreateScene(numObjects, seed);
+
+        std::vector<CameraFrame> cameraFrames;
+        if (pathName == "orbit")
+        {
+            cameraFrames = CreateOrbitPath(scene, numFrames);
+        }
+        else if (pathName == "flythrough")
+        {
+            cameraFrames = CreateFlythroughPath(scene, numFrames);
+        }
+        else
+        {
+            cameraFrames = LoadPath(pathName);
+        }
+
+        size_t fullSizeInBytes = 0;
+        for (const auto& desc : scene.Textures)
+        {
+            fullSizeInBytes += GetSizeFromMip(desc, 0);
+        }
+
+        std::cout << "Path: " << pathName
+            << ", frames: " << cameraFrames.size()
+            << ", objects: " << scene.Objects.size()
+            << ", textures: " << scene.Textures.size()
+            << ", fully resident: " << fullSizeInBytes / MEBIBYTE << " MiB" << std::endl;
+
+        for (const size_t budgetInMebibytes : budgetsInMebibytes)
+        {
+            const Statistics statistics = Simulate(scene, cameraFrames, budgetInMebibytes * MEBIBYTE, settings);
+            const double satisfiedRatio = statistics.NumRequests > 0
+                ? static_cast<double>(statistics.NumSatisfiedRequests) / static_cast<double>(statistics.NumRequests)
+                : 1.0;
+            const double missingMipsPerRequest = statistics.NumRequests > 0
+                ? static_cast<double>(statistics.NumMissingMips) / static_cast<double>(statistics.NumRequests)
+                : 0.0;
+
+            std::cout << "Budget: " << budgetInMebibytes << " MiB"
+                << ", peak resident: " << statistics.PeakResidentSizeInBytes / MEBIBYTE << " MiB"
+                << ", loaded: " << statistics.LoadedSizeInBytes / MEBIBYTE << " MiB"
+                << ", evicted: " << statistics.EvictedSizeInBytes / MEBIBYTE << " MiB"
+                << ", satisfied: " << satisfiedRatio * 100.0 << "%"
+                << ", missing mips per request: " << missingMipsPerRequest
+                << ", update: " << statistics.AverageUpdateTime << " us (average), " << statistics.MaxUpdateTime << " us (max)" << std::endl;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
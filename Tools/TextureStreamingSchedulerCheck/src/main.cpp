@@ -0,0 +1,359 @@
+#include <DX12Library/TextureStreamingScheduler.h>
+#include <DX12Library/ThreadPool.h>
+
+#include <ToolsCommon/CommandLine.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct Settings
+    {
+        uint32_t NumTextures = 256;
+        size_t StagingBudgetInBytes = 1024 * 1024;
+        uint32_t NumThreads = 4;
+        // The number of frames the mock GPU takes to reach the fence value of a frame's uploads.
+        uint32_t FenceLatency = 2;
+        // Every this many textures, the decode fails.
+        uint32_t FailurePeriod = 8;
+        uint32_t Seed = 0;
+    };
+
+    using Scheduler = TextureStreamingScheduler;
+    using RequestStatus = Scheduler::RequestStatus;
+
+    constexpr size_t KIBIBYTE = 1024;
+
+    // The mock decoder: counts its calls per key, waits for an optional gate, then allocates the pixels or throws.
+    class MockDecoder
+    {
+    public:
+        Scheduler::DecodeFunction Create(const std::wstring& key, const size_t sizeInBytes, const bool isFailing,
+            std::shared_future<void> gate = {})
+        {
+            return [this, key, sizeInBytes, isFailing, gate]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    ++m_NumDecodes[key];
+                }
+
+                if (gate.valid())
+                {
+                    gate.wait();
+                }
+
+                if (isFailing)
+                {
+                    throw std::runtime_error("Mock decode error.");
+                }
+
+                auto storage = std::make_shared<std::vector<uint8_t>>(sizeInBytes);
+
+                TextureData data;
+                data.m_Format = 28; // DXGI_FORMAT_R8G8B8A8_UNORM
+                data.m_Width = sizeInBytes / 4;
+                data.m_Subresources.push_back({ storage->data(), sizeInBytes, sizeInBytes });
+                data.m_SizeInBytes = sizeInBytes;
+                data.m_Storage = storage;
+                return data;
+            };
+        }
+
+        uint32_t GetNumDecodes(const std::wstring& key) const
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            const auto findResult = m_NumDecodes.find(key);
+            return findResult != m_NumDecodes.end() ? findResult->second : 0;
+        }
+
+    private:
+        mutable std::mutex m_Mutex;
+        std::unordered_map<std::wstring, uint32_t> m_NumDecodes;
+    };
+
+    std::wstring GetKey(const uint32_t index)
+    {
+        return L"Textures/texture" + std::to_wstring(index) + L".dds";
+    }
+
+    // Requests for a key in flight, from several threads and at every stage, share one decode until the request is retired.
+    bool CheckDeduplication(const Settings& settings)
+    {
+        // Outlives the decodes in flight, which the scheduler waits for.
+        MockDecoder decoder;
+        ThreadPool threadPool(settings.NumThreads);
+        Scheduler scheduler(threadPool, settings.StagingBudgetInBytes);
+
+        const std::wstring key = GetKey(0);
+        std::promise<void> gate;
+        const auto request = scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false, gate.get_future().share()));
+
+        // While decoding, from other threads too.
+        std::vector<std::future<std::shared_ptr<Scheduler::Request>>> duplicates;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            duplicates.push_back(std::async(std::launch::async, [&]() { return scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false)); }));
+        }
+
+        bool isShared = true;
+        for (auto& duplicate : duplicates)
+        {
+            isShared &= duplicate.get() == request;
+        }
+
+        gate.set_value();
+        scheduler.WaitForDecodes();
+
+        // Decoded, then uploading.
+        isShared &= scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false)) == request;
+        const auto uploads = scheduler.AcquireUploads();
+        isShared &= scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false)) == request;
+        scheduler.SubmitUploads(uploads, 1);
+        isShared &= scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false)) == request;
+        scheduler.WaitForDecodes();
+
+        if (!isShared || decoder.GetNumDecodes(key) != 1 || uploads.size() != 1)
+        {
+            std::cerr << "A texture requested while in flight has been decoded " << decoder.GetNumDecodes(key) << " times." << std::endl;
+            return false;
+        }
+
+        // Once retired, the key is decoded again (e.g., after the texture has been evicted).
+        const auto finishedRequests = scheduler.Retire(1);
+        const auto newRequest = scheduler.Schedule(key, decoder.Create(key, KIBIBYTE, false));
+        scheduler.WaitForDecodes();
+        if (finishedRequests.size() != 1 || newRequest == request || decoder.GetNumDecodes(key) != 2)
+        {
+            std::cerr << "A retired texture has not been decoded again." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    struct Upload
+    {
+        std::shared_ptr<Scheduler::Request> Request;
+        size_t SizeInBytes;
+        uint64_t FenceValue;
+        std::weak_ptr<const void> Storage;
+    };
+
+    /**
+     * Simulates frames streaming textures of random sizes (some larger than the whole budget) with some failing decodes:
+     * the uploads in flight never exceed the staging budget, their memory is only returned once the mock fence has been reached,
+     * and every request is reported exactly once, the failing ones with their error, without holding up the others.
+     */
+    bool CheckFrames(const Settings& settings)
+    {
+        // Outlives the decodes in flight, which the scheduler waits for.
+        MockDecoder decoder;
+        ThreadPool threadPool(settings.NumThreads);
+        Scheduler scheduler(threadPool, settings.StagingBudgetInBytes);
+        std::mt19937 random(settings.Seed);
+
+        const size_t maxSizeInBytes = settings.StagingBudgetInBytes * 3 / 2;
+        std::uniform_int_distribution<size_t> sizeDistribution(KIBIBYTE, maxSizeInBytes);
+
+        std::vector<size_t> sizesInBytes(settings.NumTextures);
+        std::vector<std::shared_ptr<Scheduler::Request>> requests(settings.NumTextures);
+        std::unordered_map<const Scheduler::Request*, uint32_t> requestIndices;
+        uint32_t numExpectedFailures = 0;
+
+        for (uint32_t i = 0; i < settings.NumTextures; ++i)
+        {
+            // The first decode fails, so that a failure is at the front of the queue.
+            const bool isFailing = i % settings.FailurePeriod == 0;
+            numExpectedFailures += isFailing ? 1 : 0;
+
+            sizesInBytes[i] = sizeDistribution(random);
+            requests[i] = scheduler.Schedule(GetKey(i), decoder.Create(GetKey(i), sizesInBytes[i], isFailing));
+            requestIndices[requests[i].get()] = i;
+        }
+
+        std::deque<Upload> uploadsInFlight;
+        uint64_t fenceValue = 0;
+        uint32_t numCompleted = 0;
+        uint32_t numFailed = 0;
+        uint32_t numFrames = 0;
+        size_t maxStagingSizeInFlight = 0;
+
+        // With one upload per frame, every texture would be done after NumTextures + FenceLatency frames, so the queue must not stall for longer.
+        const uint32_t maxFrames = 100 * (settings.NumTextures + settings.FenceLatency + 1);
+
+        while (numCompleted + numFailed < settings.NumTextures)
+        {
+            if (++numFrames > maxFrames)
+            {
+                std::cerr << "Only " << numCompleted + numFailed << " of " << settings.NumTextures << " textures have finished after " << maxFrames << " frames." << std::endl;
+                return false;
+            }
+
+            // Let the decodes progress between the frames without waiting for them.
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+            ++fenceValue;
+
+            for (const auto& request : scheduler.AcquireUploads())
+            {
+                const uint32_t index = requestIndices.at(request.get());
+                const auto& data = request->GetData();
+                if (request->GetStatus() != RequestStatus::Uploading || data.m_SizeInBytes != sizesInBytes[index] || data.m_Storage == nullptr)
+                {
+                    std::cerr << "The upload of the texture " << index << " has wrong data." << std::endl;
+                    return false;
+                }
+
+                uploadsInFlight.push_back({ request, data.m_SizeInBytes, fenceValue, data.m_Storage });
+            }
+
+            std::vector<std::shared_ptr<Scheduler::Request>> submittedRequests;
+            size_t stagingSizeInFlight = 0;
+            for (const auto& upload : uploadsInFlight)
+            {
+                if (upload.FenceValue == fenceValue)
+                {
+                    submittedRequests.push_back(upload.Request);
+                }
+                stagingSizeInFlight += upload.SizeInBytes;
+            }
+
+            // A texture larger than the budget may only be in flight on its own.
+            if ((stagingSizeInFlight > settings.StagingBudgetInBytes && uploadsInFlight.size() > 1) ||
+                scheduler.GetStagingSizeInFlight() != stagingSizeInFlight)
+            {
+                std::cerr << "Frame " << numFrames << ": " << stagingSizeInFlight << " bytes of staging memory in " << uploadsInFlight.size()
+                    << " uploads (" << scheduler.GetStagingSizeInFlight() << " according to the scheduler), over the budget of " << settings.StagingBudgetInBytes << "." << std::endl;
+                return false;
+            }
+            maxStagingSizeInFlight = std::max(maxStagingSizeInFlight, stagingSizeInFlight);
+
+            scheduler.SubmitUploads(submittedRequests, fenceValue);
+
+            // The mock GPU lags behind the CPU.
+            const uint64_t completedFenceValue = fenceValue > settings.FenceLatency ? fenceValue - settings.FenceLatency : 0;
+
+            for (const auto& request : scheduler.Retire(completedFenceValue))
+            {
+                const uint32_t index = requestIndices.at(request.get());
+
+                if (request->GetStatus() == RequestStatus::Failed)
+                {
+                    if (index % settings.FailurePeriod != 0 || request->GetErrorMessage() != "Mock decode error.")
+                    {
+                        std::cerr << "The texture " << index << " has failed: " << request->GetErrorMessage() << std::endl;
+                        return false;
+                    }
+
+                    ++numFailed;
+                    continue;
+                }
+
+                const auto upload = std::find_if(uploadsInFlight.begin(), uploadsInFlight.end(), [&](const Upload& u) { return u.Request == request; });
+                if (request->GetStatus() != RequestStatus::Completed || upload == uploadsInFlight.end() || upload->FenceValue > completedFenceValue)
+                {
+                    std::cerr << "The texture " << index << " has been retired before the fence of its upload has been reached." << std::endl;
+                    return false;
+                }
+
+                if (!upload->Storage.expired())
+                {
+                    std::cerr << "The staging memory of the texture " << index << " has not been returned after its upload." << std::endl;
+                    return false;
+                }
+
+                uploadsInFlight.erase(upload);
+                ++numCompleted;
+            }
+
+            // The staging memory of the uploads in flight is still alive, the rest has been returned.
+            for (const auto& upload : uploadsInFlight)
+            {
+                if (upload.Request->GetStatus() != RequestStatus::Uploading || upload.Storage.expired())
+                {
+                    std::cerr << "The staging memory of an upload has been returned before the fence " << upload.FenceValue
+                        << " has been reached (completed: " << completedFenceValue << ")." << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < settings.NumTextures; ++i)
+        {
+            const auto& request = requests[i];
+            const bool isExpectedToFail = i % settings.FailurePeriod == 0;
+            const bool isCorrect = isExpectedToFail ?
+                request->GetStatus() == RequestStatus::Failed :
+                request->GetStatus() == RequestStatus::Completed && request->GetData().m_Storage == nullptr;
+
+            if (!isCorrect || decoder.GetNumDecodes(GetKey(i)) != 1)
+            {
+                std::cerr << "The texture " << i << " has ended wrong." << std::endl;
+                return false;
+            }
+        }
+
+        if (numFailed != numExpectedFailures || scheduler.GetNumPendingRequests() != 0 || scheduler.GetStagingSizeInFlight() != 0)
+        {
+            std::cerr << numFailed << " failures reported instead of " << numExpectedFailures << ", " << scheduler.GetNumPendingRequests() << " requests still pending." << std::endl;
+            return false;
+        }
+
+        std::cout << "Textures: " << settings.NumTextures << " (" << numExpectedFailures << " failing), staging budget: " << settings.StagingBudgetInBytes / KIBIBYTE << " KiB"
+            << ", threads: " << settings.NumThreads << ", fence latency: " << settings.FenceLatency << " frames"
+            << "; all streamed in " << numFrames << " frames, at most " << maxStagingSizeInFlight / KIBIBYTE << " KiB in flight" << std::endl;
+
+        return true;
+    }
+}
+
+int main(const int argc, char** argv)
+{
+    Settings settings;
+
+    size_t stagingBudgetInKibibytes = settings.StagingBudgetInBytes / KIBIBYTE;
+
+    ToolsCommon::CommandLine commandLine("Usage: TextureStreamingSchedulerCheck [--textures <count>] [--budget <KiB>] [--threads <count>] [--fence-latency <frames>] [--seed <value>]");
+    commandLine.AddOption("--textures", settings.NumTextures, 1u);
+    commandLine.AddOption("--budget", stagingBudgetInKibibytes, 2u);
+    commandLine.AddOption("--threads", settings.NumThreads);
+    commandLine.AddOption("--fence-latency", settings.FenceLatency);
+    commandLine.AddOption("--seed", settings.Seed);
+
+    if (!commandLine.Parse(argc, argv))
+    {
+        return 1;
+    }
+
+    settings.StagingBudgetInBytes = stagingBudgetInKibibytes * KIBIBYTE;
+
+    try
+    {
+        if (!CheckDeduplication(settings) || !CheckFrames(settings))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "OK" << std::endl;
+    return 0;
+}